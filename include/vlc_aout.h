@@ -55,6 +55,17 @@
 /* Max acceptable resampling (in %) */
 #define AOUT_MAX_RESAMPLING             10
 
+/* Low latency mode ("audio-low-latency") */
+/** Period of the audio output device */
+#define AOUT_LOW_LATENCY_PERIOD         (CLOCK_FREQ / 200)
+
+/** Target buffering of the audio output device */
+#define AOUT_LOW_LATENCY_BUFFER         (4 * AOUT_LOW_LATENCY_PERIOD)
+
+/** Maximum advance or delay of actual audio playback time to coded PTS,
+ * replacing AOUT_MAX_PTS_ADVANCE and AOUT_MAX_PTS_DELAY */
+#define AOUT_LOW_LATENCY_PTS_DRIFT      (CLOCK_FREQ / 100)
+
 #include "vlc_es.h"
 
 #define AOUT_FMTS_IDENTICAL( p_first, p_second ) (                          \
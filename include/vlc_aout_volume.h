@@ -48,6 +48,9 @@ struct audio_volume
 
     vlc_fourcc_t format; /**< Audio samples format */
     void (*amplify)(audio_volume_t *, block_t *, float); /**< Amplifier */
+    /** Amplifier with a linear gain ramp over the block, from the first
+     * to the second factor (optional) */
+    void (*amplify_ramp)(audio_volume_t *, block_t *, float, float);
 };
 
 /** @} */
@@ -159,6 +159,10 @@ struct decoder_t
     decoder_owner_sys_t *p_owner;
 
     bool                b_error;
+
+    /* Audio output buffers
+     * XXX use decoder_NewAudioBuffer (optional, block_Alloc() if NULL) */
+    block_t        *(*pf_aout_buffer_new)( decoder_t *, size_t );
 };
 
 /**
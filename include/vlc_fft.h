@@ -0,0 +1,90 @@
+/*****************************************************************************
+ * vlc_fft.h: real-input fast Fourier transform
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_FFT_H
+# define VLC_FFT_H 1
+
+/**
+ * \defgroup fft Fast Fourier transform
+ * \ingroup audio_output
+ * Spectrum analysis and synthesis of real signals, e.g. audio samples.
+ *
+ * The trigonometric tables are shared by all the transforms of a given size.
+ * A transform object is not reentrant: each thread needs its own.
+ * @{
+ * \file
+ * Fast Fourier transform API
+ */
+
+typedef struct vlc_fft vlc_fft_t;
+
+/**
+ * Creates a transform of real signals.
+ *
+ * \param size number of input samples: an even number with no prime factor
+ *             other than 2, 3 and 5 (e.g. 512, 480 or 1920)
+ * \return a transform object, or NULL if the size is not supported or on
+ * memory error
+ */
+VLC_API vlc_fft_t *vlc_fft_New(unsigned size) VLC_USED;
+
+/**
+ * Destroys a transform.
+ */
+VLC_API void vlc_fft_Delete(vlc_fft_t *);
+
+/**
+ * Computes the discrete Fourier transform of size real samples.
+ *
+ * Only the size / 2 + 1 first bins are returned, the other ones being their
+ * complex conjugates. The transform is not normalized.
+ *
+ * \param in size input samples
+ * \param re size / 2 + 1 real parts of the bins [OUT]
+ * \param im size / 2 + 1 imaginary parts of the bins [OUT]
+ */
+VLC_API void vlc_fft_Forward(vlc_fft_t *, const float *in,
+                             float *re, float *im);
+
+/**
+ * Computes the real signal of size samples from its spectrum.
+ *
+ * This is the inverse of vlc_fft_Forward(), and is not normalized either:
+ * transforming a signal back and forth scales it by size. The imaginary
+ * parts of the first and last bins are ignored.
+ *
+ * \param re size / 2 + 1 real parts of the bins
+ * \param im size / 2 + 1 imaginary parts of the bins
+ * \param out size output samples [OUT]
+ */
+VLC_API void vlc_fft_Inverse(vlc_fft_t *, const float *re, const float *im,
+                             float *out);
+
+/**
+ * Computes the power spectrum of size real samples.
+ *
+ * \param in size input samples
+ * \param power size / 2 + 1 squared magnitudes of the bins [OUT]
+ */
+VLC_API void vlc_fft_Power(vlc_fft_t *, const float *in, float *power);
+
+/** @} */
+
+#endif
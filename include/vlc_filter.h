@@ -141,6 +141,15 @@ struct filter_t
 
     /* Private structure for the owner of the decoder */
     filter_owner_t      owner;
+
+    /** Filter audio frames in place (audio filter, optional)
+     *
+     * Filters processing interleaved float32 frames in place, with the same
+     * format in and out, can set this in addition to pf_audio_filter. The
+     * audio output then runs consecutive such filters on cache-sized chunks
+     * of each block, one chunk after the other.
+     */
+    void (*pf_audio_inplace)( filter_t *, float *, unsigned i_frames );
 };
 
 /**
@@ -410,6 +410,14 @@ VLC_API void libvlc_MetadataCancel( libvlc_int_t *, void * );
 /******************
  * Input stats
  ******************/
+/** Counters of one stream output processing stage */
+typedef struct
+{
+    int64_t i_pictures; /**< Pictures out of the stage */
+    int64_t i_busy;     /**< Time spent processing (us) */
+    int64_t i_stalled;  /**< Time spent waiting on the next stage (us) */
+} input_stage_stats_t;
+
 struct input_stats_t
 {
     vlc_mutex_t         lock;
@@ -444,6 +452,14 @@ struct input_stats_t
     /* Aout */
     int64_t i_played_abuffers;
     int64_t i_lost_abuffers;
+    int64_t i_audio_latency; /**< Last measured playback latency (us) */
+    int64_t i_allocated_abuffers; /**< Decoder buffers allocated */
+    int64_t i_recycled_abuffers; /**< Decoder buffers reused */
+
+    /* Transcode, time summed over the threads */
+    input_stage_stats_t transcode_decode;
+    input_stage_stats_t transcode_filter;
+    input_stage_stats_t transcode_encode; /**< Renditions included */
 };
 
 #endif
@@ -189,6 +189,28 @@ VLC_USED;
  */
 VLC_API unsigned picture_pool_GetSize(const picture_pool_t *);
 
+/**
+ * Statistics of the picture buffers recycler
+ *
+ * The pixel buffers of the pictures allocated from the heap, including those
+ * of picture_pool_NewFromFormat(), are taken from and returned to a process
+ * wide recycler.
+ */
+typedef struct {
+    uint64_t allocated; /**< buffers allocated from the heap */
+    uint64_t reused; /**< buffers taken from the recycler */
+    uint64_t recycled; /**< buffers returned to the recycler */
+    uint64_t evicted; /**< buffers freed from the recycler */
+    size_t   cached_bytes; /**< bytes currently held by the recycler */
+    unsigned cached_count; /**< buffers currently held by the recycler */
+} picture_buffer_stats_t;
+
+/**
+ * Retrieves a snapshot of the picture buffers recycler statistics.
+ * @note This function is thread-safe.
+ */
+VLC_API void picture_buffer_GetStats(picture_buffer_stats_t *);
+
 
 #endif /* VLC_PICTURE_POOL_H */
 
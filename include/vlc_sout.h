@@ -192,6 +192,10 @@ static inline int sout_MuxControl( sout_mux_t *p_mux, int i_query, ... )
 
 enum sout_stream_query_e {
     SOUT_STREAM_EMPTY,    /* arg1=bool *,       res=can fail (assume true) */
+    SOUT_STREAM_GET_STATS,/* arg1=input_stage_stats_t * (decode),
+                             arg2=input_stage_stats_t * (filter),
+                             arg3=input_stage_stats_t * (encode),
+                             counters are added, res=can fail */
 };
 
 struct sout_stream_t
@@ -30,6 +30,8 @@
 #include <vlc_aout.h>
 #include <vlc_aout_volume.h>
 
+#include "../audio_mixer/ramp.h"
+
 static int Probe(vlc_object_t *);
 
 vlc_module_begin()
@@ -41,6 +43,7 @@ vlc_module_begin()
 vlc_module_end()
 
 static void AmplifyFloat(audio_volume_t *, block_t *, float);
+static void AmplifyFloatRamp(audio_volume_t *, block_t *, float, float);
 
 static int Probe(vlc_object_t *obj)
 {
@@ -49,7 +52,10 @@ static int Probe(vlc_object_t *obj)
     if (!vlc_CPU_ARM_NEON())
         return VLC_EGENERIC;
     if (volume->format == VLC_CODEC_FL32)
+    {
         volume->amplify = AmplifyFloat;
+        volume->amplify_ramp = AmplifyFloatRamp;
+    }
     else
         return VLC_EGENERIC;
     return VLC_SUCCESS;
@@ -83,3 +89,14 @@ static void AmplifyFloat(audio_volume_t *volume, block_t *block, float amp)
     amplify_float_arm_neon(buf, buf, length, amp);
     (void) volume;
 }
+
+static void AmplifyFloatRamp(audio_volume_t *volume, block_t *block,
+                             float from, float to)
+{
+    volume_ramp_t ramp;
+
+    if (!volume_RampInit(&ramp, block, sizeof (float), from, to))
+        AmplifyFloat(volume, block, to);
+    else
+        volume_RampFL32(&ramp, (float *)block->p_buffer, 0);
+}
@@ -30,6 +30,7 @@
 # include "config.h"
 #endif
 
+#include <errno.h>
 #include <math.h>                                        /* sqrt */
 
 #define VLC_MODULE_LICENSE VLC_LICENSE_GPL_2_PLUS
@@ -38,6 +39,8 @@
 #include <vlc_aout.h>
 #include <vlc_filter.h>
 #include <vlc_block.h>
+#include <vlc_fft.h>
+#include <vlc_fs.h>
 
 /*****************************************************************************
  * Local prototypes
@@ -45,6 +48,7 @@
 static int  OpenFilter ( vlc_object_t * );
 static void CloseFilter( vlc_object_t * );
 static block_t *Convert( filter_t *, block_t * );
+static void Flush( filter_t * );
 
 /*****************************************************************************
  * Module descriptor
@@ -72,6 +76,20 @@ static block_t *Convert( filter_t *, block_t * );
      "Dolby Surround encoded streams won't be decoded before being " \
      "processed by this filter. Enabling this setting is not recommended.")
 
+#define HEADPHONE_CONVOLUTION_TEXT N_("Convolution")
+#define HEADPHONE_CONVOLUTION_LONGTEXT N_( \
+     "Render the virtual speakers by convolution with their impulse " \
+     "responses, at the cost of a few milliseconds of delay. This is " \
+     "always the case when impulse responses are loaded from a file.")
+
+#define HEADPHONE_HRIR_TEXT N_("Impulse responses file")
+#define HEADPHONE_HRIR_LONGTEXT N_( \
+     "WAV file with the head-related impulse responses of the virtual " \
+     "speakers, as pairs of left and right ear channels, in this order: " \
+     "left, right, middle left, middle right, rear left, rear right, " \
+     "rear center, center and low-frequency. The speakers missing from " \
+     "the file use the physical model.")
+
 vlc_module_begin ()
     set_description( N_("Headphone virtual spatialization effect") )
     set_shortname( N_("Headphone effect") )
@@ -85,6 +103,10 @@ vlc_module_begin ()
               HEADPHONE_COMPENSATE_LONGTEXT, true )
     add_bool( "headphone-dolby", false, HEADPHONE_DOLBY_TEXT,
               HEADPHONE_DOLBY_LONGTEXT, true )
+    add_bool( "headphone-convolution", false, HEADPHONE_CONVOLUTION_TEXT,
+              HEADPHONE_CONVOLUTION_LONGTEXT, true )
+    add_loadfile( "headphone-hrir", NULL, HEADPHONE_HRIR_TEXT,
+                  HEADPHONE_HRIR_LONGTEXT, true )
 
     set_capability( "audio filter", 0 )
     set_callbacks( OpenFilter, CloseFilter )
@@ -109,6 +131,7 @@ struct filter_sys_t
     float * p_overflow_buffer;
     unsigned int i_nb_atomic_operations;
     struct atomic_operation_t * p_atomic_operations;
+    struct convolver_t * p_conv;/* NULL with the delay lines */
 };
 
 /*****************************************************************************
@@ -327,6 +350,440 @@ static int Init( vlc_object_t *p_this, struct filter_sys_t * p_data
     return 0;
 }
 
+/*****************************************************************************
+ * Convolution: uniformly partitioned overlap-save convolution
+ *****************************************************************************
+ * Each impulse response is cut into partitions of CONV_BLOCK frames. Every
+ * CONV_BLOCK input frames, the spectra of the last input blocks are
+ * multiplied by those of the partitions and summed, so the cost per frame
+ * only grows with the number of partitions, by one complex multiplication
+ * per frequency bin, and the output is delayed by one block.
+ *****************************************************************************/
+#define CONV_BLOCK    256
+#define CONV_FFT_SIZE (2 * CONV_BLOCK)
+#define CONV_BINS     (CONV_BLOCK + 1)
+#define CONV_MAX_SECONDS 10 /* longest impulse response */
+
+typedef struct
+{
+    float re[CONV_BINS];
+    float im[CONV_BINS];
+} conv_spectrum_t;
+
+struct convolver_t
+{
+    unsigned int i_channels;        /* source channels */
+    unsigned int i_parts;           /* partitions per impulse response */
+    unsigned int i_slot;            /* newest spectrum of the delay line */
+    unsigned int i_fill;            /* frames in the current block */
+
+    conv_spectrum_t * p_responses;  /* [channel][part][ear] */
+    bool * pb_silent;               /* [channel][part] */
+    conv_spectrum_t * p_history;    /* [channel][part], input spectra */
+    float * p_input;                /* [channel][CONV_FFT_SIZE] */
+    float output[2][CONV_BLOCK];
+
+    vlc_fft_t * p_fft;
+    float time[CONV_FFT_SIZE];      /* inverse transform output */
+    conv_spectrum_t sum[2];
+};
+
+/* Speaker positions, in the order of the input channels and of the
+ * impulse responses file */
+static const uint32_t pi_conv_positions[] =
+{
+    AOUT_CHAN_LEFT, AOUT_CHAN_RIGHT, AOUT_CHAN_MIDDLELEFT,
+    AOUT_CHAN_MIDDLERIGHT, AOUT_CHAN_REARLEFT, AOUT_CHAN_REARRIGHT,
+    AOUT_CHAN_REARCENTER, AOUT_CHAN_CENTER, AOUT_CHAN_LFE,
+};
+/* Same weights as the physical model, times the number of channels */
+static const float pf_conv_weights[] =
+    { 2.0, 2.0, 1.5, 1.5, 1.5, 1.5, 1.5, 1.5, 5.0 };
+
+/* Transforms back both ears; overlap-save: only the second half of each
+ * block is free of circular aliasing */
+static void ConvInverse( struct convolver_t * p_conv )
+{
+    for( unsigned int i_ear = 0; i_ear < 2; i_ear++ )
+    {
+        vlc_fft_Inverse( p_conv->p_fft, p_conv->sum[i_ear].re,
+                         p_conv->sum[i_ear].im, p_conv->time );
+        memcpy( p_conv->output[i_ear], p_conv->time + CONV_BLOCK,
+                sizeof(p_conv->output[i_ear]) );
+    }
+}
+
+static void ConvMultiplyAdd( conv_spectrum_t *restrict p_sum,
+                             const conv_spectrum_t *restrict p_x,
+                             const conv_spectrum_t *restrict p_h )
+{
+    for( unsigned int k = 0; k < CONV_BINS; k++ )
+    {
+        p_sum->re[k] += p_x->re[k] * p_h->re[k] - p_x->im[k] * p_h->im[k];
+        p_sum->im[k] += p_x->re[k] * p_h->im[k] + p_x->im[k] * p_h->re[k];
+    }
+}
+
+/* Filters the complete input block */
+static void ConvProcess( struct convolver_t * p_conv )
+{
+    const unsigned int i_channels = p_conv->i_channels;
+    const unsigned int i_parts = p_conv->i_parts;
+    const unsigned int i_slot = p_conv->i_slot;
+
+    for( unsigned int c = 0; c < i_channels; c++ )
+    {
+        conv_spectrum_t * p_x = &p_conv->p_history[c * i_parts + i_slot];
+
+        vlc_fft_Forward( p_conv->p_fft, &p_conv->p_input[c * CONV_FFT_SIZE],
+                         p_x->re, p_x->im );
+    }
+
+    memset( p_conv->sum, 0, sizeof(p_conv->sum) );
+    for( unsigned int c = 0; c < i_channels; c++ )
+        for( unsigned int p = 0; p < i_parts; p++ )
+        {
+            if( p_conv->pb_silent[c * i_parts + p] )
+                continue;
+
+            /* The p-th partition applies to the input from p blocks ago */
+            const conv_spectrum_t * p_x =
+                &p_conv->p_history[c * i_parts + (i_slot + i_parts - p) % i_parts];
+            const conv_spectrum_t * p_h =
+                &p_conv->p_responses[(c * i_parts + p) * 2];
+
+            ConvMultiplyAdd( &p_conv->sum[0], p_x, &p_h[0] );
+            ConvMultiplyAdd( &p_conv->sum[1], p_x, &p_h[1] );
+        }
+    ConvInverse( p_conv );
+
+    for( unsigned int c = 0; c < i_channels; c++ )
+        memcpy( &p_conv->p_input[c * CONV_FFT_SIZE],
+                &p_conv->p_input[c * CONV_FFT_SIZE + CONV_BLOCK],
+                CONV_BLOCK * sizeof(float) );
+    p_conv->i_slot = ( i_slot + 1 ) % i_parts;
+}
+
+static void ConvReset( struct convolver_t * p_conv )
+{
+    memset( p_conv->p_input, 0,
+            p_conv->i_channels * CONV_FFT_SIZE * sizeof(float) );
+    memset( p_conv->p_history, 0, p_conv->i_channels * p_conv->i_parts
+                                  * sizeof(conv_spectrum_t) );
+    memset( p_conv->output, 0, sizeof(p_conv->output) );
+    p_conv->i_slot = 0;
+    p_conv->i_fill = 0;
+}
+
+static void ConvDelete( struct convolver_t * p_conv )
+{
+    if( p_conv->p_fft != NULL )
+        vlc_fft_Delete( p_conv->p_fft );
+    free( p_conv->p_input );
+    free( p_conv->p_history );
+    free( p_conv->pb_silent );
+    free( p_conv->p_responses );
+    free( p_conv );
+}
+
+/* Reads a WAV file as planar float samples at the given rate */
+static float * LoadResponses( vlc_object_t *p_this, const char *psz_path,
+                              unsigned int i_rate, unsigned int *pi_channels,
+                              size_t *pi_length )
+{
+    FILE * p_file = vlc_fopen( psz_path, "rb" );
+    uint8_t * p_data = NULL;
+    float * p_raw = NULL;
+    unsigned int i_channels = 0, i_bits = 0, i_file_rate = 0, i_tag = 0;
+    uint8_t header[40];
+    uint32_t i_size;
+
+    if( p_file == NULL )
+    {
+        msg_Err( p_this, "cannot open %s: %s", psz_path,
+                 vlc_strerror_c( errno ) );
+        return NULL;
+    }
+
+    if( fread( header, 1, 12, p_file ) != 12
+     || memcmp( header, "RIFF", 4 ) || memcmp( header + 8, "WAVE", 4 ) )
+        goto error;
+
+    for( ;; )
+    {
+        if( fread( header, 1, 8, p_file ) != 8 )
+            goto error;
+        i_size = GetDWLE( header + 4 );
+        if( !memcmp( header, "data", 4 ) )
+            break;
+
+        uint32_t i_skip = i_size + ( i_size & 1 );
+        if( !memcmp( header, "fmt ", 4 ) )
+        {
+            uint32_t i_read = __MIN( i_size, sizeof(header) );
+            if( i_size < 16 || fread( header, 1, i_read, p_file ) != i_read )
+                goto error;
+            i_tag = GetWLE( header );
+            i_channels = GetWLE( header + 2 );
+            i_file_rate = GetDWLE( header + 4 );
+            i_bits = GetWLE( header + 14 );
+            if( i_tag == 0xFFFE /* WAVE_FORMAT_EXTENSIBLE */ && i_size >= 26 )
+                i_tag = GetWLE( header + 24 );
+            i_skip -= i_read;
+        }
+        if( fseek( p_file, i_skip, SEEK_CUR ) )
+            goto error;
+    }
+
+    if( i_channels == 0 || i_file_rate == 0
+     || !( ( i_tag == 1 && ( i_bits == 16 || i_bits == 24 || i_bits == 32 ) )
+        || ( i_tag == 3 && i_bits == 32 ) ) )
+    {
+        msg_Err( p_this, "unsupported impulse responses format" );
+        goto error;
+    }
+
+    const size_t i_frame = i_channels * i_bits / 8;
+    const size_t i_length = i_size / i_frame;
+    if( i_length == 0 || i_length > CONV_MAX_SECONDS * i_file_rate )
+        goto error;
+
+    p_data = malloc( i_length * i_frame );
+    p_raw = malloc( i_length * i_channels * sizeof(float) );
+    if( p_data == NULL || p_raw == NULL
+     || fread( p_data, i_frame, i_length, p_file ) != i_length )
+        goto error;
+
+    for( size_t i = 0; i < i_length; i++ )
+        for( unsigned int c = 0; c < i_channels; c++ )
+        {
+            const uint8_t * p = &p_data[i * i_frame + c * i_bits / 8];
+            float f_sample;
+
+            if( i_tag == 3 )
+            {
+                uint32_t i_bits32 = GetDWLE( p );
+                memcpy( &f_sample, &i_bits32, sizeof(f_sample) );
+            }
+            else if( i_bits == 16 )
+                f_sample = (int16_t)GetWLE( p ) / 32768.f;
+            else if( i_bits == 24 )
+                f_sample = (int32_t)( ( p[0] << 8 ) | ( p[1] << 16 )
+                                    | ( (uint32_t)p[2] << 24 ) ) / 2147483648.f;
+            else
+                f_sample = (int32_t)GetDWLE( p ) / 2147483648.f;
+            p_raw[c * i_length + i] = f_sample;
+        }
+    free( p_data );
+    fclose( p_file );
+
+    *pi_channels = i_channels;
+    if( i_file_rate == i_rate )
+    {
+        *pi_length = i_length;
+        return p_raw;
+    }
+
+    /* Linear interpolation is enough for the short responses, the gain
+     * is preserved by scaling with the rates ratio */
+    msg_Dbg( p_this, "resampling impulse responses from %u to %u Hz",
+             i_file_rate, i_rate );
+    const size_t i_out_length = __MAX( (uint64_t)i_length * i_rate
+                                       / i_file_rate, 1 );
+    const float f_gain = (float)i_file_rate / i_rate;
+    float * p_out = malloc( i_out_length * i_channels * sizeof(float) );
+    if( p_out != NULL )
+        for( unsigned int c = 0; c < i_channels; c++ )
+            for( size_t i = 0; i < i_out_length; i++ )
+            {
+                const float * p_in = &p_raw[c * i_length];
+                double d_pos = (double)i * i_file_rate / i_rate;
+                size_t j = d_pos;
+                float f_frac = d_pos - j;
+                float f_next = j + 1 < i_length ? p_in[j + 1] : 0.f;
+
+                p_out[c * i_out_length + i] =
+                    ( p_in[j] + ( f_next - p_in[j] ) * f_frac ) * f_gain;
+            }
+    free( p_raw );
+    *pi_length = i_out_length;
+    return p_out;
+
+error:
+    msg_Err( p_this, "invalid impulse responses file %s", psz_path );
+    free( p_data );
+    free( p_raw );
+    fclose( p_file );
+    return NULL;
+}
+
+/* Builds the impulse responses from the atomic operations of the physical
+ * model, and replaces those found in the file if any */
+static struct convolver_t * ConvNew( vlc_object_t *p_this,
+                                     struct filter_sys_t * p_data,
+                                     unsigned int i_nb_channels,
+                                     uint32_t i_physical_channels,
+                                     unsigned int i_rate,
+                                     const char *psz_path )
+{
+    unsigned int i_file_channels = 0;
+    size_t i_file_length = 0;
+    float * p_file = NULL;
+
+    if( psz_path != NULL )
+    {
+        p_file = LoadResponses( p_this, psz_path, i_rate, &i_file_channels,
+                                &i_file_length );
+        if( p_file == NULL )
+            return NULL;
+    }
+
+    unsigned int i_channels = 0;
+    for( unsigned int i = 0; i < ARRAY_SIZE(pi_conv_positions); i++ )
+        if( i_physical_channels & pi_conv_positions[i] )
+            i_channels++;
+
+    size_t i_length = i_file_length;
+    for( unsigned int i = 0; i < p_data->i_nb_atomic_operations; i++ )
+        i_length = __MAX( i_length,
+                          p_data->p_atomic_operations[i].i_delay + 1 );
+
+    struct convolver_t * p_conv = calloc( 1, sizeof(*p_conv) );
+    if( p_conv == NULL )
+    {
+        free( p_file );
+        return NULL;
+    }
+    const unsigned int i_parts = ( i_length + CONV_BLOCK - 1 ) / CONV_BLOCK;
+    const size_t i_padded = (size_t)i_parts * CONV_BLOCK;
+
+    p_conv->i_channels = i_channels;
+    p_conv->i_parts = i_parts;
+    p_conv->p_responses = malloc( i_channels * i_parts * 2
+                                  * sizeof(conv_spectrum_t) );
+    p_conv->pb_silent = malloc( i_channels * i_parts * sizeof(bool) );
+    p_conv->p_history = malloc( i_channels * i_parts
+                                * sizeof(conv_spectrum_t) );
+    p_conv->p_input = malloc( i_channels * CONV_FFT_SIZE * sizeof(float) );
+    p_conv->p_fft = vlc_fft_New( CONV_FFT_SIZE );
+    float * p_ir = calloc( i_channels * 2 * i_padded, sizeof(float) );
+    if( p_conv->p_responses == NULL || p_conv->pb_silent == NULL
+     || p_conv->p_history == NULL || p_conv->p_input == NULL
+     || p_conv->p_fft == NULL || p_ir == NULL )
+    {
+        free( p_ir );
+        free( p_file );
+        ConvDelete( p_conv );
+        return NULL;
+    }
+
+    /* A delayed impulse per atomic operation */
+    for( unsigned int i = 0; i < p_data->i_nb_atomic_operations; i++ )
+    {
+        const struct atomic_operation_t * p_op =
+            &p_data->p_atomic_operations[i];
+
+        p_ir[( p_op->i_source_channel_offset * 2 + p_op->i_dest_channel_offset )
+             * i_padded + p_op->i_delay] += p_op->d_amplitude_factor;
+    }
+
+    /* Measured responses, with the weights of the physical model */
+    for( unsigned int i = 0, c = 0; i < ARRAY_SIZE(pi_conv_positions); i++ )
+    {
+        if( !( i_physical_channels & pi_conv_positions[i] ) )
+            continue;
+        if( 2 * i + 1 < i_file_channels )
+            for( unsigned int i_ear = 0; i_ear < 2; i_ear++ )
+            {
+                float * p_dst = &p_ir[( c * 2 + i_ear ) * i_padded];
+                const float * p_src = &p_file[( 2 * i + i_ear ) * i_file_length];
+
+                memset( p_dst, 0, i_padded * sizeof(float) );
+                for( size_t j = 0; j < i_file_length; j++ )
+                    p_dst[j] = p_src[j] * pf_conv_weights[i] / 2
+                             / i_nb_channels;
+            }
+        c++;
+    }
+    free( p_file );
+
+    /* Spectra of the partitions, zero-padded, with the inverse transform
+     * scaling */
+    for( unsigned int c = 0; c < i_channels; c++ )
+        for( unsigned int p = 0; p < i_parts; p++ )
+        {
+            bool b_silent = true;
+
+            for( unsigned int i_ear = 0; i_ear < 2; i_ear++ )
+            {
+                const float * p_src = &p_ir[( c * 2 + i_ear ) * i_padded
+                                            + p * CONV_BLOCK];
+                conv_spectrum_t * p_h =
+                    &p_conv->p_responses[(c * i_parts + p) * 2 + i_ear];
+
+                memset( p_conv->time + CONV_BLOCK, 0,
+                        CONV_BLOCK * sizeof(float) );
+                for( unsigned int j = 0; j < CONV_BLOCK; j++ )
+                {
+                    p_conv->time[j] = p_src[j] / CONV_FFT_SIZE;
+                    b_silent = b_silent && p_src[j] == 0.f;
+                }
+                vlc_fft_Forward( p_conv->p_fft, p_conv->time,
+                                 p_h->re, p_h->im );
+            }
+            p_conv->pb_silent[c * i_parts + p] = b_silent;
+        }
+    free( p_ir );
+
+    ConvReset( p_conv );
+    msg_Dbg( p_this, "convolution with %u partitions of %u frames, "
+             "%u ms latency", i_parts, CONV_BLOCK, CONV_BLOCK * 1000 / i_rate );
+    return p_conv;
+}
+
+/*****************************************************************************
+ * ConvWork: convert a buffer by convolution
+ *****************************************************************************/
+static void ConvWork( filter_t * p_filter,
+                      block_t * p_in_buf, block_t * p_out_buf )
+{
+    struct convolver_t * p_conv = p_filter->p_sys->p_conv;
+    const unsigned int i_input_nb =
+        aout_FormatNbChannels( &p_filter->fmt_in.audio );
+    const float * p_in = (const float *)p_in_buf->p_buffer;
+    float * p_out = (float *)p_out_buf->p_buffer;
+    size_t i_frames = p_in_buf->i_nb_samples;
+
+    while( i_frames > 0 )
+    {
+        const unsigned int i_fill = p_conv->i_fill;
+        const size_t i_count = __MIN( i_frames, CONV_BLOCK - i_fill );
+
+        for( unsigned int c = 0; c < p_conv->i_channels; c++ )
+        {
+            float * p_dst = &p_conv->p_input[c * CONV_FFT_SIZE
+                                             + CONV_BLOCK + i_fill];
+            for( size_t i = 0; i < i_count; i++ )
+                p_dst[i] = p_in[i * i_input_nb + c];
+        }
+        for( size_t i = 0; i < i_count; i++ )
+        {
+            p_out[2 * i]     = p_conv->output[0][i_fill + i];
+            p_out[2 * i + 1] = p_conv->output[1][i_fill + i];
+        }
+
+        p_in += i_count * i_input_nb;
+        p_out += 2 * i_count;
+        i_frames -= i_count;
+        p_conv->i_fill += i_count;
+        if( p_conv->i_fill == CONV_BLOCK )
+        {
+            ConvProcess( p_conv );
+            p_conv->i_fill = 0;
+        }
+    }
+}
+
 /*****************************************************************************
  * DoWork: convert a buffer
  *****************************************************************************/
@@ -458,6 +915,7 @@ static int OpenFilter( vlc_object_t *p_this )
     p_sys->p_overflow_buffer = NULL;
     p_sys->i_nb_atomic_operations = 0;
     p_sys->p_atomic_operations = NULL;
+    p_sys->p_conv = NULL;
 
     if( Init( VLC_OBJECT(p_filter), p_sys
                 , aout_FormatNbChannels ( &(p_filter->fmt_in.audio) )
@@ -468,6 +926,24 @@ static int OpenFilter( vlc_object_t *p_this )
         return VLC_EGENERIC;
     }
 
+    char *psz_hrir = var_InheritString( p_filter, "headphone-hrir" );
+    if( psz_hrir != NULL || var_InheritBool( p_filter, "headphone-convolution" ) )
+    {
+        p_sys->p_conv = ConvNew( VLC_OBJECT(p_filter), p_sys
+                , aout_FormatNbChannels ( &(p_filter->fmt_in.audio) )
+                , p_filter->fmt_in.audio.i_physical_channels
+                , p_filter->fmt_in.audio.i_rate, psz_hrir );
+        free( psz_hrir );
+        if( p_sys->p_conv == NULL )
+        {
+            free( p_sys->p_overflow_buffer );
+            free( p_sys->p_atomic_operations );
+            free( p_sys );
+            return VLC_EGENERIC;
+        }
+        p_filter->pf_flush = Flush;
+    }
+
     /* Request a specific format if not already compatible */
     p_filter->fmt_in.audio.i_format = VLC_CODEC_FL32;
     p_filter->fmt_out.audio.i_format = VLC_CODEC_FL32;
@@ -492,11 +968,18 @@ static void CloseFilter( vlc_object_t *p_this )
 {
     filter_t *p_filter = (filter_t *)p_this;
 
+    if( p_filter->p_sys->p_conv != NULL )
+        ConvDelete( p_filter->p_sys->p_conv );
     free( p_filter->p_sys->p_overflow_buffer );
     free( p_filter->p_sys->p_atomic_operations );
     free( p_filter->p_sys );
 }
 
+static void Flush( filter_t *p_filter )
+{
+    ConvReset( p_filter->p_sys->p_conv );
+}
+
 static block_t *Convert( filter_t *p_filter, block_t *p_block )
 {
     if( !p_block || !p_block->i_nb_samples )
@@ -523,7 +1006,10 @@ static block_t *Convert( filter_t *p_filter, block_t *p_block )
     p_out->i_pts = p_block->i_pts;
     p_out->i_length = p_block->i_length;
 
-    DoWork( p_filter, p_block, p_out );
+    if( p_filter->p_sys->p_conv != NULL )
+        ConvWork( p_filter, p_block, p_out );
+    else
+        DoWork( p_filter, p_block, p_out );
 
     block_Release( p_block );
     return p_out;
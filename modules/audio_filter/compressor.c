@@ -118,6 +118,7 @@ typedef union
 static int      Open            ( vlc_object_t * );
 static void     Close           ( vlc_object_t * );
 static block_t *DoWork          ( filter_t *, block_t * );
+static void     DoWorkInplace   ( filter_t *, float *, unsigned );
 
 static void     DbInit          ( filter_sys_t * );
 static float    Db2Lin          ( float, filter_sys_t * );
@@ -257,6 +258,7 @@ static int Open( vlc_object_t *p_this )
     p_filter->fmt_in.audio.i_format = VLC_CODEC_FL32;
     p_filter->fmt_out.audio = p_filter->fmt_in.audio;
     p_filter->pf_audio_filter = DoWork;
+    p_filter->pf_audio_inplace = DoWorkInplace;
 
     /* At this stage, we are ready! */
     msg_Dbg( p_filter, "compressor successfully initialized" );
@@ -295,9 +297,16 @@ static void Close( vlc_object_t *p_this )
 
 static block_t * DoWork( filter_t * p_filter, block_t * p_in_buf )
 {
-    int i_samples = p_in_buf->i_nb_samples;
+    DoWorkInplace( p_filter, (float*)p_in_buf->p_buffer,
+                   p_in_buf->i_nb_samples );
+    return p_in_buf;
+}
+
+static void DoWorkInplace( filter_t * p_filter, float * pf_buf,
+                           unsigned i_frames )
+{
+    int i_samples = i_frames;
     int i_channels = aout_FormatNbChannels( &p_filter->fmt_in.audio );
-    float *pf_buf = (float*)p_in_buf->p_buffer;
 
     /* Current parameters */
     filter_sys_t *p_sys = p_filter->p_sys;
@@ -437,8 +446,6 @@ static block_t * DoWork( filter_t * p_filter, block_t * p_in_buf )
     p_sys->f_env      = f_env;
     p_sys->f_env_rms  = f_env_rms;
     p_sys->f_env_peak = f_env_peak;
-
-    return p_in_buf;
 }
 
 /*****************************************************************************
@@ -38,10 +38,9 @@
 #include <vlc_aout.h>
 #include <vlc_filter.h>
 
-#include "equalizer_presets.h"
+#include "equalizer_bank.h"
 
 /* TODO:
- *  - optimize a bit (you can hardly do slower ;)
  *  - add tables for more bands (15 and 32 would be cool), maybe with auto coeffs
  *    computation (not too hard once the Q is found).
  *  - support for external preset
@@ -103,31 +102,26 @@ vlc_module_end ()
  *****************************************************************************/
 struct filter_sys_t
 {
-    /* Filter static config */
-    int i_band;
-    float *f_alpha;
-    float *f_beta;
-    float *f_gamma;
+    /* Filter config (f_amp is dynamic) */
+    eqz_bank_t bank;
+    eqz_filter_t pf_filter;
 
     /* Filter dyn config */
-    float *f_amp;   /* Per band amp */
     float f_gamp;   /* Global preamp */
     bool b_2eqz;
 
     /* Filter state */
-    float x[32][2];
-    float y[32][128][2];
+    eqz_state_t state[32];
 
     /* Second filter state */
-    float x2[32][2];
-    float y2[32][128][2];
+    eqz_state_t state2[32];
 
     vlc_mutex_t lock;
 };
 
 static block_t *DoWork( filter_t *, block_t * );
+static void DoWorkInplace( filter_t *, float *, unsigned );
 
-#define EQZ_IN_FACTOR (0.25f)
 static int  EqzInit( filter_t *, int );
 static void EqzFilter( filter_t *, float *, float *, int, int );
 static void EqzClean( filter_t * );
@@ -166,6 +160,7 @@ static int Open( vlc_object_t *p_this )
     p_filter->fmt_in.audio.i_format = VLC_CODEC_FL32;
     p_filter->fmt_out.audio = p_filter->fmt_in.audio;
     p_filter->pf_audio_filter = DoWork;
+    p_filter->pf_audio_inplace = DoWorkInplace;
 
     return VLC_SUCCESS;
 }
@@ -190,75 +185,21 @@ static void Close( vlc_object_t *p_this )
  *****************************************************************************/
 static block_t * DoWork( filter_t * p_filter, block_t * p_in_buf )
 {
-    EqzFilter( p_filter, (float*)p_in_buf->p_buffer,
-               (float*)p_in_buf->p_buffer, p_in_buf->i_nb_samples,
-               aout_FormatNbChannels( &p_filter->fmt_in.audio ) );
+    DoWorkInplace( p_filter, (float*)p_in_buf->p_buffer,
+                   p_in_buf->i_nb_samples );
     return p_in_buf;
 }
 
-/*****************************************************************************
- * Equalizer stuff
- *****************************************************************************/
-typedef struct
-{
-    int   i_band;
-
-    struct
-    {
-        float f_frequency;
-        float f_alpha;
-        float f_beta;
-        float f_gamma;
-    } band[EQZ_BANDS_MAX];
-
-} eqz_config_t;
-
-/* Equalizer coefficient calculation function based on equ-xmms */
-static void EqzCoeffs( int i_rate, float f_octave_percent,
-                       bool b_use_vlc_freqs,
-                       eqz_config_t *p_eqz_config )
+static void DoWorkInplace( filter_t * p_filter, float * p_buf,
+                           unsigned i_frames )
 {
-    const float *f_freq_table_10b = b_use_vlc_freqs
-                                  ? f_vlc_frequency_table_10b
-                                  : f_iso_frequency_table_10b;
-    float f_rate = (float) i_rate;
-    float f_nyquist_freq = 0.5f * f_rate;
-    float f_octave_factor = powf( 2.0f, 0.5f * f_octave_percent );
-    float f_octave_factor_1 = 0.5f * ( f_octave_factor + 1.0f );
-    float f_octave_factor_2 = 0.5f * ( f_octave_factor - 1.0f );
-
-    p_eqz_config->i_band = EQZ_BANDS_MAX;
-
-    for( int i = 0; i < EQZ_BANDS_MAX; i++ )
-    {
-        float f_freq = f_freq_table_10b[i];
-
-        p_eqz_config->band[i].f_frequency = f_freq;
-
-        if( f_freq <= f_nyquist_freq )
-        {
-            float f_theta_1 = ( 2.0f * (float) M_PI * f_freq ) / f_rate;
-            float f_theta_2 = f_theta_1 / f_octave_factor;
-            float f_sin     = sinf( f_theta_2 );
-            float f_sin_prd = sinf( f_theta_2 * f_octave_factor_1 )
-                            * sinf( f_theta_2 * f_octave_factor_2 );
-            float f_sin_hlf = f_sin * 0.5f;
-            float f_den     = f_sin_hlf + f_sin_prd;
-
-            p_eqz_config->band[i].f_alpha = f_sin_prd / f_den;
-            p_eqz_config->band[i].f_beta  = ( f_sin_hlf - f_sin_prd ) / f_den;
-            p_eqz_config->band[i].f_gamma = f_sin * cosf( f_theta_1 ) / f_den;
-        }
-        else
-        {
-            /* Any frequency beyond the Nyquist frequency is no good... */
-            p_eqz_config->band[i].f_alpha =
-            p_eqz_config->band[i].f_beta  =
-            p_eqz_config->band[i].f_gamma = 0.0f;
-        }
-    }
+    EqzFilter( p_filter, p_buf, p_buf, i_frames,
+               aout_FormatNbChannels( &p_filter->fmt_in.audio ) );
 }
 
+/*****************************************************************************
+ * Equalizer stuff
+ *****************************************************************************/
 static inline float EqzConvertdB( float db )
 {
     /* Map it to gain,
@@ -280,57 +221,31 @@ static int EqzInit( filter_t *p_filter, int i_rate )
 {
     filter_sys_t *p_sys = p_filter->p_sys;
     eqz_config_t cfg;
-    int i, ch;
+    int i;
     vlc_value_t val1, val2, val3;
     vlc_object_t *p_aout = p_filter->obj.parent;
-    int i_ret = VLC_ENOMEM;
 
     bool b_vlcFreqs = var_InheritBool( p_aout, "equalizer-vlcfreqs" );
     EqzCoeffs( i_rate, 1.0f, b_vlcFreqs, &cfg );
 
-    /* Create the static filter config */
-    p_sys->i_band = cfg.i_band;
-    p_sys->f_alpha = malloc( p_sys->i_band * sizeof(float) );
-    p_sys->f_beta  = malloc( p_sys->i_band * sizeof(float) );
-    p_sys->f_gamma = malloc( p_sys->i_band * sizeof(float) );
-    if( !p_sys->f_alpha || !p_sys->f_beta || !p_sys->f_gamma )
-        goto error;
-
-    for( i = 0; i < p_sys->i_band; i++ )
+    /* Create the static filter config (padding bands included) */
+    memset( &p_sys->bank, 0, sizeof(p_sys->bank) );
+    p_sys->bank.i_band = cfg.i_band;
+    for( i = 0; i < cfg.i_band; i++ )
     {
-        p_sys->f_alpha[i] = cfg.band[i].f_alpha;
-        p_sys->f_beta[i]  = cfg.band[i].f_beta;
-        p_sys->f_gamma[i] = cfg.band[i].f_gamma;
+        p_sys->bank.f_alpha[i] = cfg.band[i].f_alpha;
+        p_sys->bank.f_beta[i]  = cfg.band[i].f_beta;
+        p_sys->bank.f_gamma[i] = cfg.band[i].f_gamma;
     }
+    p_sys->pf_filter = EqzFilterSelect();
 
     /* Filter dyn config */
     p_sys->b_2eqz = false;
     p_sys->f_gamp = 1.0f;
-    p_sys->f_amp  = malloc( p_sys->i_band * sizeof(float) );
-    if( !p_sys->f_amp )
-        goto error;
-
-    for( i = 0; i < p_sys->i_band; i++ )
-    {
-        p_sys->f_amp[i] = 0.0f;
-    }
 
     /* Filter state */
-    for( ch = 0; ch < 32; ch++ )
-    {
-        p_sys->x[ch][0]  =
-        p_sys->x[ch][1]  =
-        p_sys->x2[ch][0] =
-        p_sys->x2[ch][1] = 0.0f;
-
-        for( i = 0; i < p_sys->i_band; i++ )
-        {
-            p_sys->y[ch][i][0]  =
-            p_sys->y[ch][i][1]  =
-            p_sys->y2[ch][i][0] =
-            p_sys->y2[ch][i][1] = 0.0f;
-        }
-    }
+    memset( p_sys->state, 0, sizeof(p_sys->state) );
+    memset( p_sys->state2, 0, sizeof(p_sys->state2) );
 
     var_Create( p_aout, "equalizer-bands", VLC_VAR_STRING | VLC_VAR_DOINHERIT );
     var_Create( p_aout, "equalizer-preset", VLC_VAR_STRING | VLC_VAR_DOINHERIT );
@@ -356,9 +271,7 @@ static int EqzInit( filter_t *p_filter, int i_rate )
     {
         msg_Err(p_filter, "No preset selected");
         free( val2.psz_string );
-        free( p_sys->f_amp );
-        i_ret = VLC_EGENERIC;
-        goto error;
+        return VLC_EGENERIC;
     }
     free( val2.psz_string );
 
@@ -369,82 +282,25 @@ static int EqzInit( filter_t *p_filter, int i_rate )
     var_AddCallback( p_aout, "equalizer-2pass", TwoPassCallback, p_sys );
 
     msg_Dbg( p_filter, "equalizer loaded for %d Hz with %d bands %d pass",
-                        i_rate, p_sys->i_band, p_sys->b_2eqz ? 2 : 1 );
-    for( i = 0; i < p_sys->i_band; i++ )
+                        i_rate, p_sys->bank.i_band, p_sys->b_2eqz ? 2 : 1 );
+    for( i = 0; i < p_sys->bank.i_band; i++ )
     {
         msg_Dbg( p_filter, "   %.2f Hz -> factor:%f alpha:%f beta:%f gamma:%f",
-                 cfg.band[i].f_frequency, p_sys->f_amp[i],
-                 p_sys->f_alpha[i], p_sys->f_beta[i], p_sys->f_gamma[i]);
+                 cfg.band[i].f_frequency, p_sys->bank.f_amp[i],
+                 p_sys->bank.f_alpha[i], p_sys->bank.f_beta[i],
+                 p_sys->bank.f_gamma[i]);
     }
     return VLC_SUCCESS;
-
-error:
-    free( p_sys->f_alpha );
-    free( p_sys->f_beta );
-    free( p_sys->f_gamma );
-    return i_ret;
 }
 
 static void EqzFilter( filter_t *p_filter, float *out, float *in,
                        int i_samples, int i_channels )
 {
     filter_sys_t *p_sys = p_filter->p_sys;
-    int i, ch, j;
 
     vlc_mutex_lock( &p_sys->lock );
-    for( i = 0; i < i_samples; i++ )
-    {
-        for( ch = 0; ch < i_channels; ch++ )
-        {
-            const float x = in[ch];
-            float o = 0.0f;
-
-            for( j = 0; j < p_sys->i_band; j++ )
-            {
-                float y = p_sys->f_alpha[j] * ( x - p_sys->x[ch][1] ) +
-                          p_sys->f_gamma[j] * p_sys->y[ch][j][0] -
-                          p_sys->f_beta[j]  * p_sys->y[ch][j][1];
-
-                p_sys->y[ch][j][1] = p_sys->y[ch][j][0];
-                p_sys->y[ch][j][0] = y;
-
-                o += y * p_sys->f_amp[j];
-            }
-            p_sys->x[ch][1] = p_sys->x[ch][0];
-            p_sys->x[ch][0] = x;
-
-            /* Second filter */
-            if( p_sys->b_2eqz )
-            {
-                const float x2 = EQZ_IN_FACTOR * x + o;
-                o = 0.0f;
-                for( j = 0; j < p_sys->i_band; j++ )
-                {
-                    float y = p_sys->f_alpha[j] * ( x2 - p_sys->x2[ch][1] ) +
-                              p_sys->f_gamma[j] * p_sys->y2[ch][j][0] -
-                              p_sys->f_beta[j]  * p_sys->y2[ch][j][1];
-
-                    p_sys->y2[ch][j][1] = p_sys->y2[ch][j][0];
-                    p_sys->y2[ch][j][0] = y;
-
-                    o += y * p_sys->f_amp[j];
-                }
-                p_sys->x2[ch][1] = p_sys->x2[ch][0];
-                p_sys->x2[ch][0] = x2;
-
-                /* We add source PCM + filtered PCM */
-                out[ch] = p_sys->f_gamp * p_sys->f_gamp *( EQZ_IN_FACTOR * x2 + o );
-            }
-            else
-            {
-                /* We add source PCM + filtered PCM */
-                out[ch] = p_sys->f_gamp *( EQZ_IN_FACTOR * x + o );
-            }
-        }
-
-        in  += i_channels;
-        out += i_channels;
-    }
+    p_sys->pf_filter( &p_sys->bank, p_sys->state, p_sys->state2, out, in,
+                      i_samples, i_channels, p_sys->f_gamp, p_sys->b_2eqz );
     vlc_mutex_unlock( &p_sys->lock );
 }
 
@@ -457,12 +313,6 @@ static void EqzClean( filter_t *p_filter )
     var_DelCallback( p_aout, "equalizer-preset", PresetCallback, p_sys );
     var_DelCallback( p_aout, "equalizer-preamp", PreampCallback, p_sys );
     var_DelCallback( p_aout, "equalizer-2pass", TwoPassCallback, p_sys );
-
-    free( p_sys->f_alpha );
-    free( p_sys->f_beta );
-    free( p_sys->f_gamma );
-
-    free( p_sys->f_amp );
 }
 
 
@@ -543,7 +393,7 @@ static int BandsCallback( vlc_object_t *p_this, char const *psz_cmd,
 
     /* Same thing for bands */
     vlc_mutex_lock( &p_sys->lock );
-    while( i < p_sys->i_band )
+    while( i < p_sys->bank.i_band )
     {
         char *next;
         /* Read dB -20/20 */
@@ -551,14 +401,14 @@ static int BandsCallback( vlc_object_t *p_this, char const *psz_cmd,
         if( next == p || isnan( f ) )
             break; /* no conversion */
 
-        p_sys->f_amp[i++] = EqzConvertdB( f );
+        p_sys->bank.f_amp[i++] = EqzConvertdB( f );
 
         if( *next == '\0' )
             break; /* end of line */
         p = &next[1];
     }
-    while( i < p_sys->i_band )
-        p_sys->f_amp[i++] = EqzConvertdB( 0.f );
+    while( i < p_sys->bank.i_band )
+        p_sys->bank.f_amp[i++] = EqzConvertdB( 0.f );
     vlc_mutex_unlock( &p_sys->lock );
     return VLC_SUCCESS;
 }
@@ -0,0 +1,388 @@
+/*****************************************************************************
+ * equalizer_bank.h: band-pass filter bank of the equalizer
+ *****************************************************************************
+ * Copyright (C) 2004-2026 VLC authors and VideoLAN
+ * $Id$
+ *
+ * Authors: Laurent Aimar <fenrir@via.ecp.fr>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_EQUALIZER_BANK_H_
+#define VLC_EQUALIZER_BANK_H_
+
+#include <math.h>
+#include <vlc_cpu.h>
+
+#include "equalizer_presets.h"
+
+#if defined(HAVE_SSE_INTRINSICS) && (defined(__i386__) || defined(__x86_64__))
+# include <xmmintrin.h>
+# define EQZ_SSE 1
+#endif
+#if defined(__ARM_NEON__) || defined(__aarch64__)
+# include <arm_neon.h>
+# define EQZ_NEON 1
+#endif
+
+/* Every band filters the same input independently of the others, so the
+ * SIMD versions process 4 bands at once. The coefficients of the padding
+ * bands are all zero, so that their output is always zero. */
+#define EQZ_BANK_SIZE ((EQZ_BANDS_MAX + 3) & ~3)
+
+#define EQZ_IN_FACTOR (0.25f)
+
+typedef struct
+{
+    int   i_band;
+
+    struct
+    {
+        float f_frequency;
+        float f_alpha;
+        float f_beta;
+        float f_gamma;
+    } band[EQZ_BANDS_MAX];
+
+} eqz_config_t;
+
+/* Equalizer coefficient calculation function based on equ-xmms */
+static void EqzCoeffs( int i_rate, float f_octave_percent,
+                       bool b_use_vlc_freqs,
+                       eqz_config_t *p_eqz_config )
+{
+    const float *f_freq_table_10b = b_use_vlc_freqs
+                                  ? f_vlc_frequency_table_10b
+                                  : f_iso_frequency_table_10b;
+    float f_rate = (float) i_rate;
+    float f_nyquist_freq = 0.5f * f_rate;
+    float f_octave_factor = powf( 2.0f, 0.5f * f_octave_percent );
+    float f_octave_factor_1 = 0.5f * ( f_octave_factor + 1.0f );
+    float f_octave_factor_2 = 0.5f * ( f_octave_factor - 1.0f );
+
+    p_eqz_config->i_band = EQZ_BANDS_MAX;
+
+    for( int i = 0; i < EQZ_BANDS_MAX; i++ )
+    {
+        float f_freq = f_freq_table_10b[i];
+
+        p_eqz_config->band[i].f_frequency = f_freq;
+
+        if( f_freq <= f_nyquist_freq )
+        {
+            float f_theta_1 = ( 2.0f * (float) M_PI * f_freq ) / f_rate;
+            float f_theta_2 = f_theta_1 / f_octave_factor;
+            float f_sin     = sinf( f_theta_2 );
+            float f_sin_prd = sinf( f_theta_2 * f_octave_factor_1 )
+                            * sinf( f_theta_2 * f_octave_factor_2 );
+            float f_sin_hlf = f_sin * 0.5f;
+            float f_den     = f_sin_hlf + f_sin_prd;
+
+            p_eqz_config->band[i].f_alpha = f_sin_prd / f_den;
+            p_eqz_config->band[i].f_beta  = ( f_sin_hlf - f_sin_prd ) / f_den;
+            p_eqz_config->band[i].f_gamma = f_sin * cosf( f_theta_1 ) / f_den;
+        }
+        else
+        {
+            /* Any frequency beyond the Nyquist frequency is no good... */
+            p_eqz_config->band[i].f_alpha =
+            p_eqz_config->band[i].f_beta  =
+            p_eqz_config->band[i].f_gamma = 0.0f;
+        }
+    }
+}
+
+/* Coefficients of the filter bank */
+typedef struct
+{
+    int   i_band;
+    float f_alpha[EQZ_BANK_SIZE];
+    float f_beta[EQZ_BANK_SIZE];
+    float f_gamma[EQZ_BANK_SIZE];
+    float f_amp[EQZ_BANK_SIZE];   /* Per band amp */
+} eqz_bank_t;
+
+/* Per channel state of the filter bank */
+typedef struct
+{
+    float x[2];
+    float y[2][EQZ_BANK_SIZE];
+} eqz_state_t;
+
+static inline float EqzBank( const eqz_bank_t *p_bank, eqz_state_t *s,
+                             float x )
+{
+    float o = 0.0f;
+
+    for( int j = 0; j < p_bank->i_band; j++ )
+    {
+        float y = p_bank->f_alpha[j] * ( x - s->x[1] ) +
+                  p_bank->f_gamma[j] * s->y[0][j] -
+                  p_bank->f_beta[j]  * s->y[1][j];
+
+        s->y[1][j] = s->y[0][j];
+        s->y[0][j] = y;
+
+        o += y * p_bank->f_amp[j];
+    }
+    s->x[1] = s->x[0];
+    s->x[0] = x;
+    return o;
+}
+
+#define EQZ_VECTORS (EQZ_BANK_SIZE / 4)
+
+#ifdef EQZ_SSE
+typedef struct
+{
+    __m128 alpha[EQZ_VECTORS], beta[EQZ_VECTORS], gamma[EQZ_VECTORS];
+    __m128 amp[EQZ_VECTORS];
+} eqz_bank_sse_t;
+
+typedef struct
+{
+    float x[2];
+    __m128 y0[EQZ_VECTORS], y1[EQZ_VECTORS];
+} eqz_state_sse_t;
+
+VLC_SSE
+static inline float EqzBankSse( const eqz_bank_sse_t *p_bank,
+                                eqz_state_sse_t *s, float x )
+{
+    const __m128 dx = _mm_set1_ps( x - s->x[1] );
+    __m128 o = _mm_setzero_ps();
+
+    for( int j = 0; j < EQZ_VECTORS; j++ )
+    {
+        __m128 y = _mm_sub_ps(
+            _mm_add_ps( _mm_mul_ps( p_bank->alpha[j], dx ),
+                        _mm_mul_ps( p_bank->gamma[j], s->y0[j] ) ),
+            _mm_mul_ps( p_bank->beta[j], s->y1[j] ) );
+
+        s->y1[j] = s->y0[j];
+        s->y0[j] = y;
+
+        o = _mm_add_ps( o, _mm_mul_ps( y, p_bank->amp[j] ) );
+    }
+    s->x[1] = s->x[0];
+    s->x[0] = x;
+
+    o = _mm_add_ps( o, _mm_movehl_ps( o, o ) );
+    o = _mm_add_ss( o, _mm_shuffle_ps( o, o, 1 ) );
+    return _mm_cvtss_f32( o );
+}
+
+VLC_SSE
+static void EqzSetupSse( eqz_bank_sse_t *p_dst, const eqz_bank_t *p_src )
+{
+    for( int j = 0; j < EQZ_VECTORS; j++ )
+    {
+        p_dst->alpha[j] = _mm_loadu_ps( &p_src->f_alpha[4 * j] );
+        p_dst->beta[j]  = _mm_loadu_ps( &p_src->f_beta[4 * j] );
+        p_dst->gamma[j] = _mm_loadu_ps( &p_src->f_gamma[4 * j] );
+        p_dst->amp[j]   = _mm_loadu_ps( &p_src->f_amp[4 * j] );
+    }
+}
+
+VLC_SSE
+static void EqzLoadSse( eqz_state_sse_t *p_dst, const eqz_state_t *p_src )
+{
+    p_dst->x[0] = p_src->x[0];
+    p_dst->x[1] = p_src->x[1];
+    for( int j = 0; j < EQZ_VECTORS; j++ )
+    {
+        p_dst->y0[j] = _mm_loadu_ps( &p_src->y[0][4 * j] );
+        p_dst->y1[j] = _mm_loadu_ps( &p_src->y[1][4 * j] );
+    }
+}
+
+VLC_SSE
+static void EqzStoreSse( eqz_state_t *p_dst, const eqz_state_sse_t *p_src )
+{
+    p_dst->x[0] = p_src->x[0];
+    p_dst->x[1] = p_src->x[1];
+    for( int j = 0; j < EQZ_VECTORS; j++ )
+    {
+        _mm_storeu_ps( &p_dst->y[0][4 * j], p_src->y0[j] );
+        _mm_storeu_ps( &p_dst->y[1][4 * j], p_src->y1[j] );
+    }
+}
+#endif
+
+#ifdef EQZ_NEON
+typedef struct
+{
+    float32x4_t alpha[EQZ_VECTORS], beta[EQZ_VECTORS], gamma[EQZ_VECTORS];
+    float32x4_t amp[EQZ_VECTORS];
+} eqz_bank_neon_t;
+
+typedef struct
+{
+    float x[2];
+    float32x4_t y0[EQZ_VECTORS], y1[EQZ_VECTORS];
+} eqz_state_neon_t;
+
+static inline float EqzBankNeon( const eqz_bank_neon_t *p_bank,
+                                 eqz_state_neon_t *s, float x )
+{
+    const float32x4_t dx = vdupq_n_f32( x - s->x[1] );
+    float32x4_t o = vdupq_n_f32( 0.0f );
+
+    for( int j = 0; j < EQZ_VECTORS; j++ )
+    {
+        float32x4_t y = vmulq_f32( p_bank->alpha[j], dx );
+
+        y = vmlaq_f32( y, p_bank->gamma[j], s->y0[j] );
+        y = vmlsq_f32( y, p_bank->beta[j], s->y1[j] );
+
+        s->y1[j] = s->y0[j];
+        s->y0[j] = y;
+
+        o = vmlaq_f32( o, y, p_bank->amp[j] );
+    }
+    s->x[1] = s->x[0];
+    s->x[0] = x;
+
+    float32x2_t h = vadd_f32( vget_low_f32( o ), vget_high_f32( o ) );
+    return vget_lane_f32( vpadd_f32( h, h ), 0 );
+}
+
+static void EqzSetupNeon( eqz_bank_neon_t *p_dst, const eqz_bank_t *p_src )
+{
+    for( int j = 0; j < EQZ_VECTORS; j++ )
+    {
+        p_dst->alpha[j] = vld1q_f32( &p_src->f_alpha[4 * j] );
+        p_dst->beta[j]  = vld1q_f32( &p_src->f_beta[4 * j] );
+        p_dst->gamma[j] = vld1q_f32( &p_src->f_gamma[4 * j] );
+        p_dst->amp[j]   = vld1q_f32( &p_src->f_amp[4 * j] );
+    }
+}
+
+static void EqzLoadNeon( eqz_state_neon_t *p_dst, const eqz_state_t *p_src )
+{
+    p_dst->x[0] = p_src->x[0];
+    p_dst->x[1] = p_src->x[1];
+    for( int j = 0; j < EQZ_VECTORS; j++ )
+    {
+        p_dst->y0[j] = vld1q_f32( &p_src->y[0][4 * j] );
+        p_dst->y1[j] = vld1q_f32( &p_src->y[1][4 * j] );
+    }
+}
+
+static void EqzStoreNeon( eqz_state_t *p_dst, const eqz_state_neon_t *p_src )
+{
+    p_dst->x[0] = p_src->x[0];
+    p_dst->x[1] = p_src->x[1];
+    for( int j = 0; j < EQZ_VECTORS; j++ )
+    {
+        vst1q_f32( &p_dst->y[0][4 * j], p_src->y0[j] );
+        vst1q_f32( &p_dst->y[1][4 * j], p_src->y1[j] );
+    }
+}
+#endif
+
+static inline void EqzSetup( eqz_bank_t *p_dst, const eqz_bank_t *p_src )
+{
+    *p_dst = *p_src;
+}
+
+static inline void EqzCopy( eqz_state_t *p_dst, const eqz_state_t *p_src )
+{
+    *p_dst = *p_src;
+}
+
+typedef void (*eqz_filter_t)( const eqz_bank_t *, eqz_state_t *, eqz_state_t *,
+                              float *, const float *, int, int, float, bool );
+
+/* Filters interleaved samples, with a second pass through the bank
+ * (and second states) if b_2eqz is set. The channels are independent, so
+ * they are processed one after the other, with their states kept local for
+ * the compiler to hold them in registers. */
+#define EQZ_FILTER( name, attr, bank_t, state_t, setup, load, store, bank ) \
+attr \
+static void name( const eqz_bank_t *p_bank, \
+                  eqz_state_t *p_state, eqz_state_t *p_state2, \
+                  float *out, const float *in, \
+                  int i_samples, int i_channels, float f_gamp, bool b_2eqz ) \
+{ \
+    const float f_gamp2 = f_gamp * f_gamp; \
+    bank_t b; \
+ \
+    setup( &b, p_bank ); \
+    for( int ch = 0; ch < i_channels; ch++ ) \
+    { \
+        state_t s; \
+ \
+        load( &s, &p_state[ch] ); \
+        if( b_2eqz ) \
+        { \
+            state_t s2; \
+ \
+            load( &s2, &p_state2[ch] ); \
+            for( int i = 0; i < i_samples; i++ ) \
+            { \
+                const float x = in[i * i_channels + ch]; \
+                const float x2 = EQZ_IN_FACTOR * x + bank( &b, &s, x ); \
+                const float o = bank( &b, &s2, x2 ); \
+                /* We add source PCM + filtered PCM */ \
+                out[i * i_channels + ch] = f_gamp2 *( EQZ_IN_FACTOR * x2 + o ); \
+            } \
+            store( &p_state2[ch], &s2 ); \
+        } \
+        else \
+        { \
+            for( int i = 0; i < i_samples; i++ ) \
+            { \
+                const float x = in[i * i_channels + ch]; \
+                const float o = bank( &b, &s, x ); \
+                /* We add source PCM + filtered PCM */ \
+                out[i * i_channels + ch] = f_gamp *( EQZ_IN_FACTOR * x + o ); \
+            } \
+        } \
+        store( &p_state[ch], &s ); \
+    } \
+}
+
+EQZ_FILTER( EqzFilterC, , eqz_bank_t, eqz_state_t,
+            EqzSetup, EqzCopy, EqzCopy, EqzBank )
+#ifdef EQZ_SSE
+EQZ_FILTER( EqzFilterSse, VLC_SSE, eqz_bank_sse_t, eqz_state_sse_t,
+            EqzSetupSse, EqzLoadSse, EqzStoreSse, EqzBankSse )
+#endif
+#ifdef EQZ_NEON
+EQZ_FILTER( EqzFilterNeon, , eqz_bank_neon_t, eqz_state_neon_t,
+            EqzSetupNeon, EqzLoadNeon, EqzStoreNeon, EqzBankNeon )
+#endif
+
+/* Picks the fastest implementation for the CPU */
+static inline eqz_filter_t EqzFilterSelect( void )
+{
+#ifdef EQZ_SSE
+    if( vlc_CPU_SSE() )
+        return EqzFilterSse;
+#endif
+#ifdef EQZ_NEON
+# ifdef __aarch64__
+    if( vlc_CPU_ARM64_NEON() )
+# else
+    if( vlc_CPU_ARM_NEON() )
+# endif
+        return EqzFilterNeon;
+#endif
+    return EqzFilterC;
+}
+
+#endif
@@ -43,6 +43,7 @@
 static int      Open        ( vlc_object_t * );
 static void     Close       ( vlc_object_t * );
 static block_t  *Process    ( filter_t *, block_t * );
+static void      ProcessInplace( filter_t *, float *, unsigned );
 
 struct filter_sys_t
 {
@@ -98,6 +99,8 @@ static int Open( vlc_object_t *p_this )
 
     p_filter->fmt_out.audio = p_filter->fmt_in.audio;
     p_filter->pf_audio_filter = Process;
+    if( p_filter->fmt_in.audio.i_format == VLC_CODEC_FL32 )
+        p_filter->pf_audio_inplace = ProcessInplace;
     return VLC_SUCCESS;
 }
 
@@ -114,6 +117,20 @@ static block_t *Process( filter_t *p_filter, block_t *p_block )
     return p_block;
 }
 
+static void ProcessInplace( filter_t *p_filter, float *p_buf,
+                            unsigned i_frames )
+{
+    const float f_gain = p_filter->p_sys->f_gain;
+    const size_t i_samples = i_frames
+                           * aout_FormatNbChannels( &p_filter->fmt_in.audio );
+
+    if( f_gain == 1.f )
+        return; /* nothing to do */
+
+    for( size_t i = 0; i < i_samples; i++ )
+        p_buf[i] *= f_gain;
+}
+
 
 /*****************************************************************************
  * Close: close filter
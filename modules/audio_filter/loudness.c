@@ -0,0 +1,794 @@
+/*****************************************************************************
+ * loudness.c: EBU R128 loudness normalization with a true peak limiter
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*
+ * The loudness is measured as specified by ITU-R BS.1770 (K-weighting,
+ * 400 ms gating blocks with absolute and relative gates), which EBU R128 and
+ * ATSC A/85 both refer to. The gain brings the integrated loudness to the
+ * target, and a lookahead limiter keeps the true peak of the output below
+ * the ceiling, the true peak being estimated by 4x oversampling.
+ */
+
+/*****************************************************************************
+ * Preamble
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <math.h>
+
+#include <vlc_common.h>
+#include <vlc_plugin.h>
+#include <vlc_aout.h>
+#include <vlc_filter.h>
+#include <vlc_cpu.h>
+
+#if defined(HAVE_SSE2_INTRINSICS) && (defined(__i386__) || defined(__x86_64__))
+# include <emmintrin.h>
+# define LOUDNESS_SSE2 1
+# ifdef __SSE2__
+#  define VLC_SSE2
+# else
+#  define VLC_SSE2 __attribute__ ((__target__ ("sse2")))
+# endif
+#endif
+
+/*****************************************************************************
+ * Local prototypes
+ *****************************************************************************/
+static int  Open ( vlc_object_t * );
+static void Close( vlc_object_t * );
+
+#define TARGET_TEXT N_("Target loudness")
+#define TARGET_LONGTEXT N_( \
+    "Integrated loudness to normalize the audio to, in LUFS: -23 for " \
+    "EBU R128, -24 for ATSC A/85.")
+#define TRUE_PEAK_TEXT N_("Maximum true peak")
+#define TRUE_PEAK_LONGTEXT N_( \
+    "True peak level below which the limiter keeps the output, in dBTP.")
+#define LOOKAHEAD_TEXT N_("Limiter lookahead")
+#define LOOKAHEAD_LONGTEXT N_( \
+    "How far ahead the limiter looks to reduce the gain smoothly before " \
+    "peaks, in milliseconds. The audio is delayed as much.")
+#define MAX_GAIN_TEXT N_("Maximum gain")
+#define MAX_GAIN_LONGTEXT N_( \
+    "Largest amplification of quiet programs, in dB.")
+#define REPLAY_GAIN_TEXT N_("Start from the replay gain")
+#define REPLAY_GAIN_LONGTEXT N_( \
+    "Use the replay gain information of the stream, if any, until enough " \
+    "audio has been measured. Replay gain should then be disabled in the " \
+    "audio settings, not to be applied twice.")
+
+vlc_module_begin ()
+    set_shortname( N_("Loudness") )
+    set_description( N_("EBU R128 loudness normalization") )
+    set_category( CAT_AUDIO )
+    set_subcategory( SUBCAT_AUDIO_AFILTER )
+    add_float_with_range( "loudness-target", -23., -70., -5.,
+                          TARGET_TEXT, TARGET_LONGTEXT, false )
+    add_float_with_range( "loudness-true-peak", -1., -9., 0.,
+                          TRUE_PEAK_TEXT, TRUE_PEAK_LONGTEXT, false )
+    add_float_with_range( "loudness-lookahead", 5., 1., 50.,
+                          LOOKAHEAD_TEXT, LOOKAHEAD_LONGTEXT, true )
+    add_float_with_range( "loudness-max-gain", 12., 0., 40.,
+                          MAX_GAIN_TEXT, MAX_GAIN_LONGTEXT, false )
+    add_bool( "loudness-replay-gain", true,
+              REPLAY_GAIN_TEXT, REPLAY_GAIN_LONGTEXT, false )
+    set_capability( "audio filter", 0 )
+    set_callbacks( Open, Close )
+    add_shortcut( "loudness" )
+vlc_module_end ()
+
+/*****************************************************************************
+ * Local structures
+ *****************************************************************************/
+/* The channels are measured in vectors of 4 lanes */
+#define LANES        4
+#define GROUPS       ((AOUT_CHAN_MAX + LANES - 1) / LANES)
+
+/* True peak estimation: 3 interpolated phases of 12 taps each */
+#define TP_TAPS      12
+#define TP_PHASES    3
+#define TP_DELAY     (TP_TAPS / 2) /* frames from a sample to its peak */
+
+#define SUBBLOCKS_PER_SECOND 10    /* 100 ms steps of the gating blocks */
+#define MOMENTARY_SUBBLOCKS  4     /* 400 ms gating blocks */
+#define SHORTTERM_SUBBLOCKS  30    /* 3 s */
+
+/* Histogram of the gating blocks loudness, by 0.1 LU from -70 LUFS */
+#define ABSOLUTE_GATE  (-70.)
+#define RELATIVE_GATE  (-10.)
+#define HIST_BINS      800
+
+/* Gating blocks measured before the replay gain is dropped */
+#define SEED_BLOCKS    30
+/* ReplayGain 2.0 reference loudness */
+#define REPLAY_GAIN_REFERENCE (-18.f)
+
+#define GAIN_TIME      1.f  /* normalization gain time constant (s) */
+#define RELEASE_TIME   .1f  /* limiter release time constant (s) */
+#define CHUNK_FRAMES   512
+
+typedef struct
+{
+    float z[4][LANES];                /* K-weighting filters states */
+    float hist[2 * TP_TAPS][LANES];   /* last samples, twice in a row */
+    float weight[LANES];
+} loudness_group_t;
+
+typedef float (*loudness_measure_t)( filter_sys_t *, const float *, unsigned,
+                                     float * );
+
+struct filter_sys_t
+{
+    unsigned i_channels;
+    unsigned i_groups;
+
+    /* Measurement */
+    loudness_measure_t pf_measure;
+    loudness_group_t group[GROUPS];
+    unsigned i_hist_pos;
+    float shelf[5];                   /* b0, b1, b2, a1, a2 */
+    float highpass[5];
+    float tp_coef[TP_PHASES][TP_TAPS];
+
+    /* Gating */
+    unsigned i_sub_length;
+    unsigned i_sub_frames;
+    double f_sub_energy;
+    double pf_sub_power[SHORTTERM_SUBBLOCKS];
+    unsigned i_sub_pos;
+    unsigned i_sub_count;
+    uint32_t pi_hist[HIST_BINS];
+    double pf_bin_power[HIST_BINS];
+    uint64_t i_blocks;
+    float f_integrated;
+    float f_seed;
+    bool b_seed;
+
+    /* Normalization gain */
+    float f_target;
+    float f_max_gain;
+    float f_gain;
+    float f_gain_target;
+    float f_gain_coef;
+
+    /* Lookahead limiter */
+    float f_ceiling;
+    unsigned i_lookahead;
+    unsigned i_ring;                  /* delayed frames + 1 */
+    unsigned i_write;
+    float *p_ring;
+    float *p_ring_gain;
+    float f_prev_peak;
+    uint64_t i_frame;
+    float *p_min_val;                 /* sliding minimum, as a deque */
+    uint64_t *p_min_idx;
+    unsigned i_min_head;
+    unsigned i_min_count;
+    float f_env;
+    float f_release;
+    float *p_avg;                     /* moving average of the envelope */
+    unsigned i_avg_pos;
+    double f_avg_sum;
+
+    /* Statistics */
+    float f_max_peak;
+    float f_min_gain;
+};
+
+/*****************************************************************************
+ * Measurement
+ *****************************************************************************/
+/* Each kernel K-weights the frames and estimates their true peaks, lane by
+ * lane. It returns the weighted energy of the frames, and stores the peak
+ * of each frame, TP_DELAY frames late, in peaks. */
+
+static float MeasureC( filter_sys_t *p_sys, const float *p_in,
+                       unsigned i_frames, float *p_peaks )
+{
+    const unsigned i_channels = p_sys->i_channels;
+    const float *s = p_sys->shelf, *h = p_sys->highpass;
+    float f_energy = 0.f;
+
+    for( unsigned g = 0; g < p_sys->i_groups; g++ )
+    {
+        loudness_group_t *p_group = &p_sys->group[g];
+        const unsigned i_lanes = __MIN( i_channels - g * LANES, LANES );
+        unsigned i_pos = p_sys->i_hist_pos;
+
+        for( unsigned f = 0; f < i_frames; f++ )
+        {
+            const float *x = p_in + f * i_channels + g * LANES;
+            float f_peak = 0.f;
+
+            i_pos = ( i_pos + 1 ) % TP_TAPS;
+            for( unsigned l = 0; l < i_lanes; l++ )
+            {
+                float (*z)[LANES] = p_group->z;
+                float y = s[0] * x[l] + z[0][l];
+                z[0][l] = s[1] * x[l] - s[3] * y + z[1][l];
+                z[1][l] = s[2] * x[l] - s[4] * y;
+                float k = h[0] * y + z[2][l];
+                z[2][l] = h[1] * y - h[3] * k + z[3][l];
+                z[3][l] = h[2] * y - h[4] * k;
+                f_energy += p_group->weight[l] * k * k;
+
+                p_group->hist[i_pos][l] = x[l];
+                p_group->hist[i_pos + TP_TAPS][l] = x[l];
+
+                /* Oldest sample first */
+                const float (*w)[LANES] = &p_group->hist[i_pos + 1];
+                f_peak = fmaxf( f_peak, fabsf( w[TP_DELAY - 1][l] ) );
+                for( unsigned p = 0; p < TP_PHASES; p++ )
+                {
+                    float acc = 0.f;
+                    for( unsigned t = 0; t < TP_TAPS; t++ )
+                        acc += p_sys->tp_coef[p][t] * w[t][l];
+                    f_peak = fmaxf( f_peak, fabsf( acc ) );
+                }
+            }
+            p_peaks[f] = g ? fmaxf( p_peaks[f], f_peak ) : f_peak;
+        }
+    }
+    p_sys->i_hist_pos = ( p_sys->i_hist_pos + i_frames ) % TP_TAPS;
+    return f_energy;
+}
+
+#ifdef LOUDNESS_SSE2
+/* All the lanes of a group are filtered at once */
+VLC_SSE2
+static float MeasureSSE2( filter_sys_t *p_sys, const float *p_in,
+                         unsigned i_frames, float *p_peaks )
+{
+    const unsigned i_channels = p_sys->i_channels;
+    const __m128 sb0 = _mm_set1_ps( p_sys->shelf[0] );
+    const __m128 sb1 = _mm_set1_ps( p_sys->shelf[1] );
+    const __m128 sb2 = _mm_set1_ps( p_sys->shelf[2] );
+    const __m128 sa1 = _mm_set1_ps( p_sys->shelf[3] );
+    const __m128 sa2 = _mm_set1_ps( p_sys->shelf[4] );
+    const __m128 hb0 = _mm_set1_ps( p_sys->highpass[0] );
+    const __m128 hb1 = _mm_set1_ps( p_sys->highpass[1] );
+    const __m128 hb2 = _mm_set1_ps( p_sys->highpass[2] );
+    const __m128 ha1 = _mm_set1_ps( p_sys->highpass[3] );
+    const __m128 ha2 = _mm_set1_ps( p_sys->highpass[4] );
+    const __m128 abs_mask = _mm_castsi128_ps( _mm_set1_epi32( 0x7fffffff ) );
+    __m128 energy = _mm_setzero_ps();
+
+    for( unsigned g = 0; g < p_sys->i_groups; g++ )
+    {
+        loudness_group_t *p_group = &p_sys->group[g];
+        const unsigned i_lanes = __MIN( i_channels - g * LANES, LANES );
+        const __m128 weight = _mm_loadu_ps( p_group->weight );
+        __m128 z0 = _mm_loadu_ps( p_group->z[0] );
+        __m128 z1 = _mm_loadu_ps( p_group->z[1] );
+        __m128 z2 = _mm_loadu_ps( p_group->z[2] );
+        __m128 z3 = _mm_loadu_ps( p_group->z[3] );
+        unsigned i_pos = p_sys->i_hist_pos;
+
+        for( unsigned f = 0; f < i_frames; f++ )
+        {
+            const float *p_frame = p_in + f * i_channels + g * LANES;
+            __m128 x;
+
+            if( i_lanes == LANES )
+                x = _mm_loadu_ps( p_frame );
+            else
+            {
+                float lanes[LANES] = { 0.f, 0.f, 0.f, 0.f };
+                memcpy( lanes, p_frame, i_lanes * sizeof(float) );
+                x = _mm_loadu_ps( lanes );
+            }
+
+            __m128 y = _mm_add_ps( _mm_mul_ps( sb0, x ), z0 );
+            z0 = _mm_add_ps( _mm_sub_ps( _mm_mul_ps( sb1, x ),
+                                         _mm_mul_ps( sa1, y ) ), z1 );
+            z1 = _mm_sub_ps( _mm_mul_ps( sb2, x ), _mm_mul_ps( sa2, y ) );
+            __m128 k = _mm_add_ps( _mm_mul_ps( hb0, y ), z2 );
+            z2 = _mm_add_ps( _mm_sub_ps( _mm_mul_ps( hb1, y ),
+                                         _mm_mul_ps( ha1, k ) ), z3 );
+            z3 = _mm_sub_ps( _mm_mul_ps( hb2, y ), _mm_mul_ps( ha2, k ) );
+            energy = _mm_add_ps( energy,
+                                 _mm_mul_ps( weight, _mm_mul_ps( k, k ) ) );
+
+            i_pos = ( i_pos + 1 ) % TP_TAPS;
+            _mm_storeu_ps( p_group->hist[i_pos], x );
+            _mm_storeu_ps( p_group->hist[i_pos + TP_TAPS], x );
+
+            const float (*w)[LANES] = &p_group->hist[i_pos + 1];
+            __m128 acc0 = _mm_setzero_ps();
+            __m128 acc1 = _mm_setzero_ps();
+            __m128 acc2 = _mm_setzero_ps();
+            for( unsigned t = 0; t < TP_TAPS; t++ )
+            {
+                __m128 v = _mm_loadu_ps( w[t] );
+                acc0 = _mm_add_ps( acc0,
+                           _mm_mul_ps( _mm_set1_ps( p_sys->tp_coef[0][t] ), v ) );
+                acc1 = _mm_add_ps( acc1,
+                           _mm_mul_ps( _mm_set1_ps( p_sys->tp_coef[1][t] ), v ) );
+                acc2 = _mm_add_ps( acc2,
+                           _mm_mul_ps( _mm_set1_ps( p_sys->tp_coef[2][t] ), v ) );
+            }
+            __m128 peak = _mm_and_ps( _mm_loadu_ps( w[TP_DELAY - 1] ),
+                                      abs_mask );
+            peak = _mm_max_ps( peak, _mm_and_ps( acc0, abs_mask ) );
+            peak = _mm_max_ps( peak, _mm_and_ps( acc1, abs_mask ) );
+            peak = _mm_max_ps( peak, _mm_and_ps( acc2, abs_mask ) );
+            peak = _mm_max_ps( peak, _mm_movehl_ps( peak, peak ) );
+            peak = _mm_max_ss( peak, _mm_shuffle_ps( peak, peak, 1 ) );
+
+            float f_peak = _mm_cvtss_f32( peak );
+            p_peaks[f] = g ? fmaxf( p_peaks[f], f_peak ) : f_peak;
+        }
+
+        _mm_storeu_ps( p_group->z[0], z0 );
+        _mm_storeu_ps( p_group->z[1], z1 );
+        _mm_storeu_ps( p_group->z[2], z2 );
+        _mm_storeu_ps( p_group->z[3], z3 );
+    }
+    p_sys->i_hist_pos = ( p_sys->i_hist_pos + i_frames ) % TP_TAPS;
+
+    energy = _mm_add_ps( energy, _mm_movehl_ps( energy, energy ) );
+    energy = _mm_add_ss( energy, _mm_shuffle_ps( energy, energy, 1 ) );
+    return _mm_cvtss_f32( energy );
+}
+#endif
+
+/*****************************************************************************
+ * Gating and normalization gain
+ *****************************************************************************/
+static float Integrate( const filter_sys_t *p_sys )
+{
+    double f_sum = 0.;
+    uint64_t i_count = 0;
+
+    for( unsigned b = 0; b < HIST_BINS; b++ )
+    {
+        f_sum += p_sys->pi_hist[b] * p_sys->pf_bin_power[b];
+        i_count += p_sys->pi_hist[b];
+    }
+
+    /* Relative gate */
+    double f_gate = -0.691 + 10. * log10( f_sum / i_count ) + RELATIVE_GATE;
+    double f_first = ceil( ( f_gate - ABSOLUTE_GATE ) * 10. - .5 );
+    f_sum = 0.;
+    i_count = 0;
+    for( unsigned b = f_first > 0. ? f_first : 0; b < HIST_BINS; b++ )
+    {
+        f_sum += p_sys->pi_hist[b] * p_sys->pf_bin_power[b];
+        i_count += p_sys->pi_hist[b];
+    }
+    return i_count ? -0.691 + 10. * log10( f_sum / i_count ) : -INFINITY;
+}
+
+static float ShortTerm( const filter_sys_t *p_sys )
+{
+    double f_power = 0.;
+
+    if( p_sys->i_sub_count == 0 )
+        return -INFINITY;
+    for( unsigned i = 0; i < p_sys->i_sub_count; i++ )
+        f_power += p_sys->pf_sub_power[i];
+    return -0.691 + 10. * log10( f_power / p_sys->i_sub_count );
+}
+
+static void UpdateGain( filter_sys_t *p_sys )
+{
+    float f_loudness;
+
+    if( p_sys->b_seed && p_sys->i_blocks < SEED_BLOCKS )
+        f_loudness = p_sys->f_seed;
+    else if( p_sys->i_blocks > 0 && isfinite( p_sys->f_integrated ) )
+        f_loudness = p_sys->f_integrated;
+    else
+        return;
+
+    float f_gain = fminf( p_sys->f_target - f_loudness, p_sys->f_max_gain );
+    p_sys->f_gain_target = powf( 10.f, f_gain / 20.f );
+}
+
+static void SubBlockDone( filter_sys_t *p_sys )
+{
+    p_sys->pf_sub_power[p_sys->i_sub_pos] =
+        p_sys->f_sub_energy / p_sys->i_sub_length;
+    p_sys->i_sub_pos = ( p_sys->i_sub_pos + 1 ) % SHORTTERM_SUBBLOCKS;
+    if( p_sys->i_sub_count < SHORTTERM_SUBBLOCKS )
+        p_sys->i_sub_count++;
+    p_sys->f_sub_energy = 0.;
+    p_sys->i_sub_frames = 0;
+
+    if( p_sys->i_sub_count < MOMENTARY_SUBBLOCKS )
+        return;
+
+    /* Gating block of the last 400 ms */
+    double f_power = 0.;
+    for( unsigned i = 1; i <= MOMENTARY_SUBBLOCKS; i++ )
+        f_power += p_sys->pf_sub_power[( p_sys->i_sub_pos
+                                         + SHORTTERM_SUBBLOCKS - i )
+                                       % SHORTTERM_SUBBLOCKS];
+    f_power /= MOMENTARY_SUBBLOCKS;
+
+    double f_loudness = -0.691 + 10. * log10( f_power );
+    if( f_loudness > ABSOLUTE_GATE )
+    {
+        unsigned b = ( f_loudness - ABSOLUTE_GATE ) * 10.;
+        p_sys->pi_hist[__MIN( b, HIST_BINS - 1 )]++;
+        p_sys->i_blocks++;
+        p_sys->f_integrated = Integrate( p_sys );
+    }
+    UpdateGain( p_sys );
+}
+
+/*****************************************************************************
+ * Lookahead limiter
+ *****************************************************************************/
+/* Index in a ring buffer, from an index below twice its size */
+static inline unsigned Wrap( unsigned i, unsigned i_size )
+{
+    return i >= i_size ? i - i_size : i;
+}
+
+/* The gain of each frame is the moving average, over the lookahead, of an
+ * envelope that never exceeds the smallest gain required over the
+ * lookahead. Hence the gain is below the required one for the frame the
+ * windows overlap on, which is the one output. */
+static void Limit( filter_sys_t *p_sys, float *p_buf, unsigned i_frames,
+                   const float *p_peaks )
+{
+    const unsigned i_channels = p_sys->i_channels;
+    const unsigned i_ring = p_sys->i_ring;
+    const unsigned i_lookahead = p_sys->i_lookahead;
+
+    for( unsigned i = 0; i < i_frames; i++ )
+    {
+        float *p_frame = p_buf + i * i_channels;
+        const uint64_t t = p_sys->i_frame++;
+        const unsigned w = p_sys->i_write;
+        const unsigned o = w + 1 < i_ring ? w + 1 : 0;
+        const unsigned s = w >= TP_DELAY ? w - TP_DELAY : w + i_ring - TP_DELAY;
+
+        p_sys->f_gain += ( p_sys->f_gain_target - p_sys->f_gain )
+                       * p_sys->f_gain_coef;
+
+        /* Gain required by the frame TP_DELAY frames ago, including the
+         * peaks between it and its neighbours */
+        float f_peak = fmaxf( p_peaks[i], p_sys->f_prev_peak );
+        p_sys->f_prev_peak = p_peaks[i];
+        p_sys->f_max_peak = fmaxf( p_sys->f_max_peak, p_peaks[i] );
+
+        float f_level = f_peak * p_sys->p_ring_gain[s];
+        float f_req = f_level > p_sys->f_ceiling
+                    ? p_sys->f_ceiling / f_level : 1.f;
+
+        /* Sliding minimum over the lookahead */
+        while( p_sys->i_min_count > 0 )
+        {
+            unsigned back = Wrap( p_sys->i_min_head + p_sys->i_min_count - 1,
+                                  i_lookahead );
+            if( p_sys->p_min_val[back] < f_req )
+                break;
+            p_sys->i_min_count--;
+        }
+        if( p_sys->i_min_count > 0
+         && p_sys->p_min_idx[p_sys->i_min_head] + i_lookahead <= t )
+        {
+            p_sys->i_min_head = Wrap( p_sys->i_min_head + 1, i_lookahead );
+            p_sys->i_min_count--;
+        }
+        unsigned back = Wrap( p_sys->i_min_head + p_sys->i_min_count,
+                              i_lookahead );
+        p_sys->p_min_val[back] = f_req;
+        p_sys->p_min_idx[back] = t;
+        p_sys->i_min_count++;
+
+        float f_min = p_sys->p_min_val[p_sys->i_min_head];
+        p_sys->f_env = fminf( f_min, p_sys->f_env
+                              + ( 1.f - p_sys->f_env ) * p_sys->f_release );
+
+        p_sys->f_avg_sum += p_sys->f_env - p_sys->p_avg[p_sys->i_avg_pos];
+        p_sys->p_avg[p_sys->i_avg_pos] = p_sys->f_env;
+        p_sys->i_avg_pos = Wrap( p_sys->i_avg_pos + 1, i_lookahead );
+        float f_limit = p_sys->f_avg_sum / i_lookahead;
+        p_sys->f_min_gain = fminf( p_sys->f_min_gain, f_limit );
+
+        /* Output the oldest frame, and queue the new one */
+        const float f_out_gain = p_sys->p_ring_gain[o] * f_limit;
+        float *p_in = p_sys->p_ring + w * i_channels;
+        float *p_out = p_sys->p_ring + o * i_channels;
+
+        for( unsigned c = 0; c < i_channels; c++ )
+        {
+            p_in[c] = p_frame[c];
+            p_frame[c] = p_out[c] * f_out_gain;
+        }
+        p_sys->p_ring_gain[w] = p_sys->f_gain;
+        p_sys->i_write = o;
+    }
+}
+
+static void Reset( filter_sys_t *p_sys )
+{
+    for( unsigned g = 0; g < p_sys->i_groups; g++ )
+    {
+        memset( p_sys->group[g].z, 0, sizeof(p_sys->group[g].z) );
+        memset( p_sys->group[g].hist, 0, sizeof(p_sys->group[g].hist) );
+    }
+    p_sys->i_hist_pos = 0;
+
+    memset( p_sys->p_ring, 0,
+            p_sys->i_ring * p_sys->i_channels * sizeof(float) );
+    for( unsigned i = 0; i < p_sys->i_ring; i++ )
+        p_sys->p_ring_gain[i] = p_sys->f_gain;
+    p_sys->i_write = 0;
+    p_sys->f_prev_peak = 0.f;
+    p_sys->i_frame = 0;
+    p_sys->i_min_head = 0;
+    p_sys->i_min_count = 0;
+    p_sys->f_env = 1.f;
+    for( unsigned i = 0; i < p_sys->i_lookahead; i++ )
+        p_sys->p_avg[i] = 1.f;
+    p_sys->i_avg_pos = 0;
+    p_sys->f_avg_sum = p_sys->i_lookahead;
+}
+
+/*****************************************************************************
+ * Filter callbacks
+ *****************************************************************************/
+static void DoWorkInplace( filter_t *p_filter, float *p_buf,
+                           unsigned i_frames )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    float p_peaks[CHUNK_FRAMES];
+
+    while( i_frames > 0 )
+    {
+        unsigned i_run = __MIN( i_frames, CHUNK_FRAMES );
+        i_run = __MIN( i_run, p_sys->i_sub_length - p_sys->i_sub_frames );
+
+        p_sys->f_sub_energy += p_sys->pf_measure( p_sys, p_buf, i_run,
+                                                  p_peaks );
+        p_sys->i_sub_frames += i_run;
+        Limit( p_sys, p_buf, i_run, p_peaks );
+        if( p_sys->i_sub_frames == p_sys->i_sub_length )
+            SubBlockDone( p_sys );
+
+        p_buf += i_run * p_sys->i_channels;
+        i_frames -= i_run;
+    }
+}
+
+static block_t *DoWork( filter_t *p_filter, block_t *p_block )
+{
+    DoWorkInplace( p_filter, (float *)p_block->p_buffer,
+                   p_block->i_nb_samples );
+    return p_block;
+}
+
+static void Flush( filter_t *p_filter )
+{
+    /* The loudness measured so far still holds for the program */
+    Reset( p_filter->p_sys );
+}
+
+/*****************************************************************************
+ * Open: initialize the filter
+ *****************************************************************************/
+static void KWeightingInit( filter_sys_t *p_sys, double f_rate )
+{
+    /* High shelf, modelling the head */
+    double f0 = 1681.974450955533;
+    double G = 3.999843853973347;
+    double Q = 0.7071752369554196;
+    double K = tan( M_PI * f0 / f_rate );
+    double Vh = pow( 10., G / 20. );
+    double Vb = pow( Vh, 0.4996667741545416 );
+    double a0 = 1. + K / Q + K * K;
+
+    p_sys->shelf[0] = ( Vh + Vb * K / Q + K * K ) / a0;
+    p_sys->shelf[1] = 2. * ( K * K - Vh ) / a0;
+    p_sys->shelf[2] = ( Vh - Vb * K / Q + K * K ) / a0;
+    p_sys->shelf[3] = 2. * ( K * K - 1. ) / a0;
+    p_sys->shelf[4] = ( 1. - K / Q + K * K ) / a0;
+
+    /* Revised low-frequency B-curve high pass */
+    f0 = 38.13547087602444;
+    Q = 0.5003270373238773;
+    K = tan( M_PI * f0 / f_rate );
+    a0 = 1. + K / Q + K * K;
+
+    p_sys->highpass[0] = 1.;
+    p_sys->highpass[1] = -2.;
+    p_sys->highpass[2] = 1.;
+    p_sys->highpass[3] = 2. * ( K * K - 1. ) / a0;
+    p_sys->highpass[4] = ( 1. - K / Q + K * K ) / a0;
+}
+
+static void TruePeakInit( filter_sys_t *p_sys )
+{
+    /* Hann windowed sinc, interpolating a quarter, half and three quarters
+     * of the way between the two middle samples */
+    for( unsigned p = 0; p < TP_PHASES; p++ )
+        for( unsigned t = 0; t < TP_TAPS; t++ )
+        {
+            double d = (double)t - ( TP_DELAY - 1 ) - ( p + 1 ) / 4.;
+            double sinc = d != 0. ? sin( M_PI * d ) / ( M_PI * d ) : 1.;
+            double win = .5 * ( 1. + cos( M_PI * d / TP_DELAY ) );
+
+            p_sys->tp_coef[p][t] = sinc * win;
+        }
+}
+
+static void WeightsInit( filter_sys_t *p_sys, uint32_t i_physical )
+{
+    unsigned c = 0;
+
+    /* Surround channels weigh +1.5 dB, the LFE is left out */
+    for( unsigned i = 0; pi_vlc_chan_order_wg4[i]; i++ )
+    {
+        const uint32_t chan = pi_vlc_chan_order_wg4[i];
+        float f_weight = 1.f;
+
+        if( !( i_physical & chan ) )
+            continue;
+        if( chan == AOUT_CHAN_LFE )
+            f_weight = 0.f;
+        else if( chan & ( AOUT_CHAN_MIDDLELEFT | AOUT_CHAN_MIDDLERIGHT
+                        | AOUT_CHAN_REARLEFT | AOUT_CHAN_REARRIGHT
+                        | AOUT_CHAN_REARCENTER ) )
+            f_weight = 1.41f;
+        p_sys->group[c / LANES].weight[c % LANES] = f_weight;
+        c++;
+    }
+}
+
+static float SeedInit( filter_t *p_filter, bool *pb_seed )
+{
+    /* Set by the decoder audio output, if any, not by the configuration */
+    const audio_replay_gain_t *p_rg =
+        var_InheritAddress( p_filter, "audio-replay-gain" );
+
+    *pb_seed = false;
+    if( p_rg == NULL )
+        return 0.f;
+
+    for( unsigned i = 0; i < AUDIO_REPLAY_GAIN_MAX; i++ )
+        if( p_rg->pb_gain[i] )
+        {
+            *pb_seed = true;
+            return REPLAY_GAIN_REFERENCE - p_rg->pf_gain[i];
+        }
+    return 0.f;
+}
+
+static int Open( vlc_object_t *p_this )
+{
+    filter_t *p_filter = (filter_t *)p_this;
+    const unsigned i_channels =
+        aout_FormatNbChannels( &p_filter->fmt_in.audio );
+    const unsigned i_rate = p_filter->fmt_in.audio.i_rate;
+
+    if( i_channels == 0 || i_channels > AOUT_CHAN_MAX || i_rate == 0 )
+        return VLC_EGENERIC;
+
+    filter_sys_t *p_sys = calloc( 1, sizeof(*p_sys) );
+    if( unlikely(p_sys == NULL) )
+        return VLC_ENOMEM;
+
+    p_sys->i_channels = i_channels;
+    p_sys->i_groups = ( i_channels + LANES - 1 ) / LANES;
+    p_sys->pf_measure = MeasureC;
+#ifdef LOUDNESS_SSE2
+    if( vlc_CPU_SSE2() )
+        p_sys->pf_measure = MeasureSSE2;
+#endif
+    KWeightingInit( p_sys, i_rate );
+    TruePeakInit( p_sys );
+
+    p_sys->i_sub_length = ( i_rate + SUBBLOCKS_PER_SECOND / 2 )
+                        / SUBBLOCKS_PER_SECOND;
+    for( unsigned b = 0; b < HIST_BINS; b++ )
+        p_sys->pf_bin_power[b] =
+            pow( 10., ( ABSOLUTE_GATE + ( b + .5 ) / 10. + 0.691 ) / 10. );
+    p_sys->f_integrated = -INFINITY;
+
+    p_sys->f_target = var_InheritFloat( p_filter, "loudness-target" );
+    p_sys->f_max_gain = var_InheritFloat( p_filter, "loudness-max-gain" );
+    p_sys->f_ceiling = powf( 10.f, var_InheritFloat( p_filter,
+                                        "loudness-true-peak" ) / 20.f );
+    p_sys->f_gain_coef = 1.f - expf( -1.f / ( GAIN_TIME * i_rate ) );
+    p_sys->f_release = 1.f - expf( -1.f / ( RELEASE_TIME * i_rate ) );
+
+    p_sys->f_gain = p_sys->f_gain_target = 1.f;
+    if( var_InheritBool( p_filter, "loudness-replay-gain" ) )
+    {
+        p_sys->f_seed = SeedInit( p_filter, &p_sys->b_seed );
+        if( p_sys->b_seed )
+        {
+            msg_Dbg( p_filter, "starting from replay gain: %.1f LUFS",
+                     p_sys->f_seed );
+            UpdateGain( p_sys );
+            p_sys->f_gain = p_sys->f_gain_target;
+        }
+    }
+
+    float f_lookahead = var_InheritFloat( p_filter, "loudness-lookahead" );
+    p_sys->i_lookahead = __MAX( lroundf( f_lookahead * i_rate / 1000.f ), 1 );
+    p_sys->i_ring = p_sys->i_lookahead + TP_DELAY;
+    p_sys->p_ring = malloc( p_sys->i_ring * i_channels
+                            * sizeof(*p_sys->p_ring) );
+    p_sys->p_ring_gain = malloc( p_sys->i_ring * sizeof(*p_sys->p_ring_gain) );
+    p_sys->p_min_val = malloc( p_sys->i_lookahead
+                               * sizeof(*p_sys->p_min_val) );
+    p_sys->p_min_idx = malloc( p_sys->i_lookahead
+                               * sizeof(*p_sys->p_min_idx) );
+    p_sys->p_avg = malloc( p_sys->i_lookahead * sizeof(*p_sys->p_avg) );
+    if( unlikely(p_sys->p_ring == NULL || p_sys->p_ring_gain == NULL
+              || p_sys->p_min_val == NULL || p_sys->p_min_idx == NULL
+              || p_sys->p_avg == NULL) )
+    {
+        free( p_sys->p_avg );
+        free( p_sys->p_min_idx );
+        free( p_sys->p_min_val );
+        free( p_sys->p_ring_gain );
+        free( p_sys->p_ring );
+        free( p_sys );
+        return VLC_ENOMEM;
+    }
+    Reset( p_sys );
+    WeightsInit( p_sys, p_filter->fmt_in.audio.i_physical_channels );
+    p_sys->f_min_gain = 1.f;
+
+    p_filter->p_sys = p_sys;
+    p_filter->fmt_in.audio.i_format = VLC_CODEC_FL32;
+    aout_FormatPrepare( &p_filter->fmt_in.audio );
+    p_filter->fmt_out.audio = p_filter->fmt_in.audio;
+    p_filter->pf_audio_filter = DoWork;
+    p_filter->pf_audio_inplace = DoWorkInplace;
+    p_filter->pf_flush = Flush;
+
+    msg_Dbg( p_filter, "target %.1f LUFS, ceiling %.1f dBTP, "
+             "lookahead %u frames", p_sys->f_target,
+             20.f * log10f( p_sys->f_ceiling ), p_sys->i_lookahead );
+    return VLC_SUCCESS;
+}
+
+/*****************************************************************************
+ * Close: destroy the filter
+ *****************************************************************************/
+static void Close( vlc_object_t *p_this )
+{
+    filter_t *p_filter = (filter_t *)p_this;
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    msg_Dbg( p_filter, "integrated loudness %.1f LUFS, short-term %.1f LUFS, "
+             "true peak %.1f dBTP, limiter down to %.1f dB",
+             p_sys->f_integrated, ShortTerm( p_sys ),
+             20.f * log10f( p_sys->f_max_peak ),
+             20.f * log10f( p_sys->f_min_gain ) );
+
+    free( p_sys->p_avg );
+    free( p_sys->p_min_idx );
+    free( p_sys->p_min_val );
+    free( p_sys->p_ring_gain );
+    free( p_sys->p_ring );
+    free( p_sys );
+}
@@ -57,6 +57,9 @@ struct filter_sys_t
     int i_nb;
     float *p_last;
     float f_max;
+    /* Per-buffer scratch, allocated once: i_channels sums then gains */
+    float *pf_sum;
+    float *pf_gain;
 };
 
 /*****************************************************************************
@@ -117,6 +120,15 @@ static int Open( vlc_object_t *p_this )
         return VLC_ENOMEM;
     }
 
+    p_sys->pf_sum = calloc( 2 * i_channels, sizeof(float) );
+    if( !p_sys->pf_sum )
+    {
+        free( p_sys->p_last );
+        free( p_sys );
+        return VLC_ENOMEM;
+    }
+    p_sys->pf_gain = p_sys->pf_sum + i_channels;
+
     p_filter->fmt_in.audio.i_format = VLC_CODEC_FL32;
     p_filter->fmt_out.audio = p_filter->fmt_in.audio;
     p_filter->pf_audio_filter = DoWork;
@@ -129,8 +141,6 @@ static int Open( vlc_object_t *p_this )
  *****************************************************************************/
 static block_t *DoWork( filter_t *p_filter, block_t *p_in_buf )
 {
-    float *pf_sum;
-    float *pf_gain;
     float f_average = 0;
     int i, i_chan;
 
@@ -140,17 +150,8 @@ static block_t *DoWork( filter_t *p_filter, block_t *p_in_buf )
     float *p_in =  (float*)p_in_buf->p_buffer;
 
     struct filter_sys_t *p_sys = p_filter->p_sys;
-
-    pf_sum = calloc( i_channels, sizeof(float) );
-    if( !pf_sum )
-        goto out;
-
-    pf_gain = malloc( sizeof(float) * i_channels );
-    if( !pf_gain )
-    {
-        free( pf_sum );
-        goto out;
-    }
+    float *pf_sum = p_sys->pf_sum;
+    float *pf_gain = p_sys->pf_gain;
 
     /* Calculate the average power level on this buffer */
     for( i = 0 ; i < i_samples; i++ )
@@ -210,13 +211,7 @@ static block_t *DoWork( filter_t *p_filter, block_t *p_in_buf )
         p_out += i_channels;
     }
 
-    free( pf_sum );
-    free( pf_gain );
-
     return p_in_buf;
-out:
-    block_Release( p_in_buf );
-    return NULL;
 }
 
 /**********************************************************************
@@ -227,6 +222,7 @@ static void Close( vlc_object_t *p_this )
     filter_t *p_filter = (filter_t*)p_this;
     filter_sys_t *p_sys = p_filter->p_sys;
 
+    free( p_sys->pf_sum );
     free( p_sys->p_last );
     free( p_sys );
 }
@@ -0,0 +1,524 @@
+/*****************************************************************************
+ * polyphase.c : polyphase windowed-sinc resampler
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*****************************************************************************
+ * This resampler computes every output frame as the inner product of the
+ * input around it with a Kaiser-windowed sinc low-pass filter. The filter is
+ * precomputed for POLYPHASE_PHASES sub-sample offsets (the phases), and the
+ * coefficients for the actual offset are linearly interpolated between the
+ * two nearest phases. The resampling ratio is thus only a step in a fixed
+ * point position, and can change with every block at no cost (as needed by
+ * the audio output to compensate for clock drift). The table is only
+ * recomputed if the cut-off frequency must change, i.e. when downsampling.
+ *
+ * The input is kept deinterleaved so that the inner products run on
+ * contiguous memory, with SSE or NEON if available.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+#include <math.h>
+
+#include <vlc_common.h>
+#include <vlc_plugin.h>
+#include <vlc_aout.h>
+#include <vlc_filter.h>
+#include <vlc_block.h>
+#include <vlc_cpu.h>
+
+#if defined(HAVE_SSE_INTRINSICS) && (defined(__i386__) || defined(__x86_64__))
+# include <xmmintrin.h>
+# define POLYPHASE_SSE 1
+#endif
+#if defined(__ARM_NEON__) || defined(__aarch64__)
+# include <arm_neon.h>
+# define POLYPHASE_NEON 1
+#endif
+
+#define POLYPHASE_PHASES 256
+#define POLYPHASE_TAPS_MAX 64
+
+#define QUALITY_TEXT N_("Resampling quality")
+#define QUALITY_LONGTEXT N_( \
+    "Resampling quality (0 = worst and fastest, 2 = best and slowest).")
+
+static int  Open( vlc_object_t * );
+static int  OpenResampler( vlc_object_t * );
+static void Close( vlc_object_t * );
+
+vlc_module_begin ()
+    set_shortname( N_("Polyphase resampler") )
+    set_description( N_("Polyphase windowed-sinc audio resampler") )
+    set_category( CAT_AUDIO )
+    set_subcategory( SUBCAT_AUDIO_RESAMPLER )
+    add_integer( "polyphase-resampler-quality", 1,
+                 QUALITY_TEXT, QUALITY_LONGTEXT, true )
+        change_integer_range( 0, 2 )
+    set_capability( "audio converter", 30 )
+    set_callbacks( Open, Close )
+
+    add_submodule()
+    set_capability( "audio resampler", 30 )
+    set_callbacks( OpenResampler, Close )
+    add_shortcut( "polyphase" )
+vlc_module_end ()
+
+/* Number of taps (a multiple of 8, up to POLYPHASE_TAPS_MAX), Kaiser window
+ * beta and cut-off frequency (relative to the Nyquist frequency of the lowest
+ * rate) per quality */
+static const struct
+{
+    unsigned i_taps;
+    float    f_beta;
+    float    f_rolloff;
+} qualities[] = {
+    { 16, 6.f, 0.80f },
+    { 32, 8.f, 0.91f },
+    { 64, 9.f, 0.95f },
+};
+
+typedef float (*dot_t)( const float *, const float *, unsigned );
+typedef void (*interpolate_t)( float *, const float *, const float *,
+                               float, unsigned );
+
+struct filter_sys_t
+{
+    /* Filter table, (POLYPHASE_PHASES + 1) rows of i_taps coefficients */
+    float   *p_table;
+    unsigned i_taps;
+    float    f_beta;
+    float    f_rolloff;
+    float    f_cutoff;      /* cut-off of the current table */
+
+    dot_t         pf_dot;
+    interpolate_t pf_interpolate;
+
+    /* Deinterleaved input, i_hist_size frames per channel */
+    float   *p_hist;
+    size_t   i_hist_size;
+    size_t   i_hist;        /* buffered frames */
+    uint64_t i_pos;         /* next output position, 32.32 fixed point */
+
+    unsigned i_channels;
+    bool     b_first;
+    date_t   end_date;
+};
+
+/*****************************************************************************
+ * Inner products
+ *****************************************************************************/
+static float DotC( const float *a, const float *b, unsigned n )
+{
+    float s0 = 0.f, s1 = 0.f, s2 = 0.f, s3 = 0.f;
+
+    for( unsigned i = 0; i < n; i += 4 )
+    {
+        s0 += a[i] * b[i];
+        s1 += a[i + 1] * b[i + 1];
+        s2 += a[i + 2] * b[i + 2];
+        s3 += a[i + 3] * b[i + 3];
+    }
+    return ( s0 + s1 ) + ( s2 + s3 );
+}
+
+static void InterpolateC( float *c, const float *a, const float *b,
+                          float mu, unsigned n )
+{
+    for( unsigned i = 0; i < n; i++ )
+        c[i] = a[i] + mu * ( b[i] - a[i] );
+}
+
+#ifdef POLYPHASE_SSE
+VLC_SSE
+static float DotSse( const float *a, const float *b, unsigned n )
+{
+    __m128 s0 = _mm_setzero_ps(), s1 = _mm_setzero_ps();
+
+    for( unsigned i = 0; i < n; i += 8 )
+    {
+        s0 = _mm_add_ps( s0, _mm_mul_ps( _mm_loadu_ps( a + i ),
+                                         _mm_loadu_ps( b + i ) ) );
+        s1 = _mm_add_ps( s1, _mm_mul_ps( _mm_loadu_ps( a + i + 4 ),
+                                         _mm_loadu_ps( b + i + 4 ) ) );
+    }
+    s0 = _mm_add_ps( s0, s1 );
+    s0 = _mm_add_ps( s0, _mm_movehl_ps( s0, s0 ) );
+    s0 = _mm_add_ss( s0, _mm_shuffle_ps( s0, s0, 1 ) );
+    return _mm_cvtss_f32( s0 );
+}
+
+VLC_SSE
+static void InterpolateSse( float *c, const float *a, const float *b,
+                            float mu, unsigned n )
+{
+    const __m128 m = _mm_set1_ps( mu );
+
+    for( unsigned i = 0; i < n; i += 4 )
+    {
+        __m128 va = _mm_loadu_ps( a + i );
+        __m128 vb = _mm_loadu_ps( b + i );
+        _mm_storeu_ps( c + i, _mm_add_ps( va,
+                                  _mm_mul_ps( m, _mm_sub_ps( vb, va ) ) ) );
+    }
+}
+#endif
+
+#ifdef POLYPHASE_NEON
+static float DotNeon( const float *a, const float *b, unsigned n )
+{
+    float32x4_t s0 = vdupq_n_f32( 0.f ), s1 = vdupq_n_f32( 0.f );
+
+    for( unsigned i = 0; i < n; i += 8 )
+    {
+        s0 = vmlaq_f32( s0, vld1q_f32( a + i ), vld1q_f32( b + i ) );
+        s1 = vmlaq_f32( s1, vld1q_f32( a + i + 4 ), vld1q_f32( b + i + 4 ) );
+    }
+    s0 = vaddq_f32( s0, s1 );
+
+    float32x2_t h = vadd_f32( vget_low_f32( s0 ), vget_high_f32( s0 ) );
+    return vget_lane_f32( vpadd_f32( h, h ), 0 );
+}
+
+static void InterpolateNeon( float *c, const float *a, const float *b,
+                             float mu, unsigned n )
+{
+    for( unsigned i = 0; i < n; i += 4 )
+    {
+        float32x4_t va = vld1q_f32( a + i );
+        float32x4_t vb = vld1q_f32( b + i );
+        vst1q_f32( c + i, vmlaq_n_f32( va, vsubq_f32( vb, va ), mu ) );
+    }
+}
+#endif
+
+/*****************************************************************************
+ * Filter table
+ *****************************************************************************/
+/* Zeroth order modified Bessel function of the first kind */
+static double BesselI0( double x )
+{
+    double sum = 1., term = 1.;
+
+    for( unsigned k = 1; k < 50 && term > sum * 1e-12; k++ )
+    {
+        term *= ( x / ( 2. * k ) ) * ( x / ( 2. * k ) );
+        sum += term;
+    }
+    return sum;
+}
+
+/* Fills the table for a cut-off frequency relative to the input Nyquist
+ * frequency. Row p holds the filter for an output frame p/POLYPHASE_PHASES
+ * input frames after tap i_taps/2 - 1. */
+static void ComputeTable( filter_sys_t *p_sys, float f_cutoff )
+{
+    const unsigned n = p_sys->i_taps;
+    const double i0_beta = BesselI0( p_sys->f_beta );
+    const double half = n / 2.;
+
+    for( unsigned p = 0; p <= POLYPHASE_PHASES; p++ )
+    {
+        float *row = &p_sys->p_table[p * n];
+        double sum = 0.;
+
+        for( unsigned k = 0; k < n; k++ )
+        {
+            double t = (double)k - ( half - 1. ) - (double)p / POLYPHASE_PHASES;
+            double x = M_PI * f_cutoff * t;
+            double sinc = fabs( x ) < 1e-9 ? 1. : sin( x ) / x;
+            double r = t / half;
+            double w = r * r < 1. ?
+                BesselI0( p_sys->f_beta * sqrt( 1. - r * r ) ) / i0_beta : 0.;
+
+            row[k] = sinc * w;
+            sum += row[k];
+        }
+        /* Unity gain at DC for every phase */
+        for( unsigned k = 0; k < n; k++ )
+            row[k] /= sum;
+    }
+    p_sys->f_cutoff = f_cutoff;
+}
+
+/*****************************************************************************
+ * Resampling
+ *****************************************************************************/
+static void Reset( filter_sys_t *p_sys )
+{
+    /* Prime the history so that the first output frame is centered on the
+     * first input frame */
+    p_sys->i_hist = p_sys->i_taps / 2 - 1;
+    for( unsigned ch = 0; ch < p_sys->i_channels; ch++ )
+        memset( &p_sys->p_hist[ch * p_sys->i_hist_size], 0,
+                p_sys->i_hist * sizeof(float) );
+    p_sys->i_pos = 0;
+}
+
+static int GrowHistory( filter_sys_t *p_sys, size_t i_size )
+{
+    if( i_size <= p_sys->i_hist_size )
+        return VLC_SUCCESS;
+
+    i_size = __MAX( i_size, 2 * p_sys->i_hist_size );
+    float *p_hist = malloc( i_size * p_sys->i_channels * sizeof(float) );
+    if( unlikely(p_hist == NULL) )
+        return VLC_ENOMEM;
+
+    for( unsigned ch = 0; ch < p_sys->i_channels; ch++ )
+        memcpy( &p_hist[ch * i_size], &p_sys->p_hist[ch * p_sys->i_hist_size],
+                p_sys->i_hist * sizeof(float) );
+    free( p_sys->p_hist );
+    p_sys->p_hist = p_hist;
+    p_sys->i_hist_size = i_size;
+    return VLC_SUCCESS;
+}
+
+static block_t *Resample( filter_t *p_filter, block_t *p_in )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    const unsigned i_channels = p_sys->i_channels;
+    const unsigned i_taps = p_sys->i_taps;
+    const unsigned i_in_rate = p_filter->fmt_in.audio.i_rate;
+    const unsigned i_out_rate = p_filter->fmt_out.audio.i_rate;
+    block_t *p_out = NULL;
+
+    if( p_in->i_nb_samples == 0 )
+        goto out;
+
+    if( (p_in->i_flags & BLOCK_FLAG_DISCONTINUITY) || p_sys->b_first )
+    {
+        Reset( p_sys );
+        date_Init( &p_sys->end_date, i_out_rate, 1 );
+        date_Set( &p_sys->end_date, p_in->i_pts );
+        p_sys->b_first = false;
+    }
+
+    /* The rates may change between blocks (clock drift compensation) */
+    const uint64_t i_step = ( (uint64_t)i_in_rate << 32 ) / i_out_rate;
+    float f_cutoff = p_sys->f_rolloff;
+    if( i_out_rate < i_in_rate )
+        f_cutoff = f_cutoff * i_out_rate / i_in_rate;
+    if( fabsf( f_cutoff - p_sys->f_cutoff ) > 0.002f * p_sys->f_cutoff )
+        ComputeTable( p_sys, f_cutoff );
+
+    /* Append the input to the history */
+    if( GrowHistory( p_sys, p_sys->i_hist + p_in->i_nb_samples ) )
+        goto out;
+
+    const float *p_src = (const float *)p_in->p_buffer;
+    for( unsigned ch = 0; ch < i_channels; ch++ )
+    {
+        float *p_dst = &p_sys->p_hist[ch * p_sys->i_hist_size + p_sys->i_hist];
+        for( unsigned i = 0; i < p_in->i_nb_samples; i++ )
+            p_dst[i] = p_src[i * i_channels + ch];
+    }
+    p_sys->i_hist += p_in->i_nb_samples;
+
+    /* Count the output frames for which the whole filter is available */
+    size_t i_out_nb = 0;
+    if( p_sys->i_hist >= i_taps )
+    {
+        uint64_t i_limit = (uint64_t)( p_sys->i_hist - i_taps + 1 ) << 32;
+        if( p_sys->i_pos < i_limit )
+            i_out_nb = ( i_limit - p_sys->i_pos - 1 ) / i_step + 1;
+    }
+
+    if( i_out_nb > 0 )
+    {
+        p_out = block_Alloc( i_out_nb * i_channels * sizeof(float) );
+        if( unlikely(p_out == NULL) )
+            goto out;
+
+        float *p_dst = (float *)p_out->p_buffer;
+        uint64_t i_pos = p_sys->i_pos;
+
+        /* Filter even when the rates happen to be equal, so that the
+         * response and the delay do not change with drift compensation */
+        float coeffs[POLYPHASE_TAPS_MAX];
+
+        for( size_t i = 0; i < i_out_nb; i++ )
+        {
+            const size_t i_index = i_pos >> 32;
+            const uint64_t i_phase = (uint64_t)(uint32_t)i_pos
+                                   * POLYPHASE_PHASES;
+            const float *p_row =
+                &p_sys->p_table[(i_phase >> 32) * i_taps];
+            const float f_mu =
+                (uint32_t)i_phase * (1.f / 4294967296.f);
+
+            p_sys->pf_interpolate( coeffs, p_row, p_row + i_taps,
+                                   f_mu, i_taps );
+            for( unsigned ch = 0; ch < i_channels; ch++ )
+                *(p_dst++) = p_sys->pf_dot( coeffs,
+                    &p_sys->p_hist[ch * p_sys->i_hist_size + i_index],
+                    i_taps );
+            i_pos += i_step;
+        }
+
+        /* Drop the input frames which are not needed anymore */
+        const size_t i_drop = __MIN( i_pos >> 32, p_sys->i_hist );
+        p_sys->i_hist -= i_drop;
+        for( unsigned ch = 0; ch < i_channels; ch++ )
+        {
+            float *p_hist = &p_sys->p_hist[ch * p_sys->i_hist_size];
+            memmove( p_hist, p_hist + i_drop, p_sys->i_hist * sizeof(float) );
+        }
+        p_sys->i_pos = i_pos - ( (uint64_t)i_drop << 32 );
+
+        p_out->i_nb_samples = i_out_nb;
+        p_out->i_dts =
+        p_out->i_pts = date_Get( &p_sys->end_date );
+        p_out->i_length = date_Increment( &p_sys->end_date,
+                                          i_out_nb ) - p_out->i_pts;
+        p_out->i_flags = p_in->i_flags & BLOCK_FLAG_DISCONTINUITY;
+    }
+out:
+    block_Release( p_in );
+    return p_out;
+}
+
+static block_t *Drain( filter_t *p_filter )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    if( p_sys->b_first )
+        return NULL;
+
+    /* Push silence through the second half of the filter */
+    const unsigned i_frames = p_sys->i_taps / 2 + 1;
+    block_t *p_block = block_Alloc( i_frames * p_sys->i_channels
+                                             * sizeof(float) );
+    if( unlikely(p_block == NULL) )
+        return NULL;
+
+    memset( p_block->p_buffer, 0, p_block->i_buffer );
+    p_block->i_nb_samples = i_frames;
+    p_block->i_pts = p_block->i_dts = VLC_TS_INVALID;
+
+    p_block = Resample( p_filter, p_block );
+    p_sys->b_first = true;
+    return p_block;
+}
+
+static void Flush( filter_t *p_filter )
+{
+    p_filter->p_sys->b_first = true;
+}
+
+/*****************************************************************************
+ * Open/Close
+ *****************************************************************************/
+static int OpenResampler( vlc_object_t *p_this )
+{
+    filter_t *p_filter = (filter_t *)p_this;
+
+    if( p_filter->fmt_in.audio.i_format != VLC_CODEC_FL32
+     || p_filter->fmt_out.audio.i_format != VLC_CODEC_FL32
+     || p_filter->fmt_in.audio.i_physical_channels
+              != p_filter->fmt_out.audio.i_physical_channels
+     || p_filter->fmt_in.audio.i_original_channels
+              != p_filter->fmt_out.audio.i_original_channels )
+        return VLC_EGENERIC;
+
+    filter_sys_t *p_sys = calloc( 1, sizeof(*p_sys) );
+    if( unlikely(p_sys == NULL) )
+        return VLC_ENOMEM;
+
+    unsigned i_quality = var_InheritInteger( p_this,
+                                             "polyphase-resampler-quality" );
+    if( i_quality >= ARRAY_SIZE(qualities) )
+        i_quality = 1;
+
+    p_sys->i_taps = qualities[i_quality].i_taps;
+    p_sys->f_beta = qualities[i_quality].f_beta;
+    p_sys->f_rolloff = qualities[i_quality].f_rolloff;
+    p_sys->i_channels = aout_FormatNbChannels( &p_filter->fmt_in.audio );
+    p_sys->b_first = true;
+
+    p_sys->p_table = malloc( ( POLYPHASE_PHASES + 1 ) * p_sys->i_taps
+                             * sizeof(float) );
+    if( unlikely(p_sys->p_table == NULL)
+     || GrowHistory( p_sys, 4096 ) )
+    {
+        free( p_sys->p_table );
+        free( p_sys );
+        return VLC_ENOMEM;
+    }
+
+    float f_cutoff = p_sys->f_rolloff;
+    if( p_filter->fmt_out.audio.i_rate < p_filter->fmt_in.audio.i_rate )
+        f_cutoff = f_cutoff * p_filter->fmt_out.audio.i_rate
+                            / p_filter->fmt_in.audio.i_rate;
+    ComputeTable( p_sys, f_cutoff );
+
+    p_sys->pf_dot = DotC;
+    p_sys->pf_interpolate = InterpolateC;
+#ifdef POLYPHASE_SSE
+    if( vlc_CPU_SSE() )
+    {
+        p_sys->pf_dot = DotSse;
+        p_sys->pf_interpolate = InterpolateSse;
+    }
+#endif
+#ifdef POLYPHASE_NEON
+# ifdef __aarch64__
+    if( vlc_CPU_ARM64_NEON() )
+# else
+    if( vlc_CPU_ARM_NEON() )
+# endif
+    {
+        p_sys->pf_dot = DotNeon;
+        p_sys->pf_interpolate = InterpolateNeon;
+    }
+#endif
+
+    p_filter->p_sys = p_sys;
+    p_filter->pf_audio_filter = Resample;
+    p_filter->pf_audio_drain = Drain;
+    p_filter->pf_flush = Flush;
+
+    msg_Dbg( p_filter, "%u Hz -> %u Hz, %u channels, %u taps",
+             p_filter->fmt_in.audio.i_rate, p_filter->fmt_out.audio.i_rate,
+             p_sys->i_channels, p_sys->i_taps );
+    return VLC_SUCCESS;
+}
+
+static int Open( vlc_object_t *p_this )
+{
+    filter_t *p_filter = (filter_t *)p_this;
+
+    /* Will change rate */
+    if( p_filter->fmt_in.audio.i_rate == p_filter->fmt_out.audio.i_rate )
+        return VLC_EGENERIC;
+    return OpenResampler( p_this );
+}
+
+static void Close( vlc_object_t *p_this )
+{
+    filter_t *p_filter = (filter_t *)p_this;
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    free( p_sys->p_hist );
+    free( p_sys->p_table );
+    free( p_sys );
+}
@@ -36,6 +36,8 @@
 #include <string.h> /* for memset */
 #include <limits.h> /* form INT_MIN */
 
+#include "scaletempo_search.h"
+
 /*****************************************************************************
  * Module descriptor
  *****************************************************************************/
@@ -56,6 +58,8 @@ vlc_module_begin ()
         N_("Overlap Length"), N_("Percentage of stride to overlap"), true )
     add_integer_with_range( "scaletempo-search", 14, 0, 200,
         N_("Search Length"), N_("Length in milliseconds to search for best overlap position"), true )
+    add_bool( "scaletempo-coarse-search", true,
+        N_("Coarse search"), N_("Search for the best overlap position at a lower resolution first, then only refine around the best candidates"), true )
 
     set_callbacks( Open, Close )
 vlc_module_end ()
@@ -110,6 +114,9 @@ struct filter_sys_t
     unsigned  frames_search;
     void     *buf_pre_corr;
     void     *table_window;
+    float    *buf_coarse;
+    bool      b_coarse_search;
+    scaletempo_corr4_t corr4;
     unsigned(*best_overlap_offset)( filter_t *p_filter );
 };
 
@@ -120,9 +127,8 @@ static unsigned best_overlap_offset_float( filter_t *p_filter )
 {
     filter_sys_t *p = p_filter->p_sys;
     float *pw, *po, *ppc, *search_start;
-    float best_corr = INT_MIN;
-    unsigned best_off = 0;
-    unsigned i, off;
+    unsigned best_off;
+    unsigned i;
 
     pw  = p->table_window;
     po  = p->buf_overlap;
@@ -133,19 +139,16 @@ static unsigned best_overlap_offset_float( filter_t *p_filter )
     }
 
     search_start = (float *)p->buf_queue + p->samples_per_frame;
-    for( off = 0; off < p->frames_search; off++ ) {
-      float corr = 0;
-      float *ps = search_start;
-      ppc = p->buf_pre_corr;
-      for( i = p->samples_per_frame; i < p->samples_overlap; i++ ) {
-        corr += *ppc++ * *ps++;
-      }
-      if( corr > best_corr ) {
-        best_corr = corr;
-        best_off  = off;
-      }
-      search_start += p->samples_per_frame;
-    }
+    if( p->buf_coarse )
+        best_off = ScaletempoSearchCoarse( p->corr4, p->buf_pre_corr,
+                                           search_start,
+                                           p->samples_overlap - p->samples_per_frame,
+                                           p->samples_per_frame,
+                                           p->frames_search, p->buf_coarse );
+    else
+        best_off = ScaletempoSearch( p->corr4, p->buf_pre_corr, search_start,
+                                     p->samples_overlap - p->samples_per_frame,
+                                     p->samples_per_frame, p->frames_search );
 
     return best_off * p->bytes_per_frame;
 }
@@ -337,6 +340,15 @@ static int reinit_buffers( filter_t *p_filter )
             for( j = 0; j < p->samples_per_frame; j++ )
                 *pw++ = v;
         }
+        if( p->b_coarse_search )
+        {
+            p->buf_coarse = malloc( ScaletempoCoarseSize( frames_overlap,
+                                        p->frames_search, p->samples_per_frame )
+                                    * sizeof(float) );
+            if( ! p->buf_coarse )
+                return VLC_ENOMEM;
+        }
+        p->corr4 = ScaletempoCorr4Select();
         p->best_overlap_offset = best_overlap_offset_float;
     }
 
@@ -407,15 +419,18 @@ static int Open( vlc_object_t *p_this )
     p_sys->ms_stride       = var_InheritInteger( p_this, "scaletempo-stride" );
     p_sys->percent_overlap = var_InheritFloat( p_this, "scaletempo-overlap" );
     p_sys->ms_search       = var_InheritInteger( p_this, "scaletempo-search" );
+    p_sys->b_coarse_search = var_InheritBool( p_this, "scaletempo-coarse-search" );
 
-    msg_Dbg( p_this, "params: %i stride, %.3f overlap, %i search",
-             p_sys->ms_stride, p_sys->percent_overlap, p_sys->ms_search );
+    msg_Dbg( p_this, "params: %i stride, %.3f overlap, %i search%s",
+             p_sys->ms_stride, p_sys->percent_overlap, p_sys->ms_search,
+             p_sys->b_coarse_search ? " (coarse)" : "" );
 
     p_sys->buf_queue      = NULL;
     p_sys->buf_overlap    = NULL;
     p_sys->table_blend    = NULL;
     p_sys->buf_pre_corr   = NULL;
     p_sys->table_window   = NULL;
+    p_sys->buf_coarse     = NULL;
     p_sys->bytes_overlap  = 0;
     p_sys->bytes_queued   = 0;
     p_sys->bytes_to_slide = 0;
@@ -442,6 +457,7 @@ static void Close( vlc_object_t *p_this )
     free( p_sys->table_blend );
     free( p_sys->buf_pre_corr );
     free( p_sys->table_window );
+    free( p_sys->buf_coarse );
     free( p_sys );
 }
 
@@ -0,0 +1,343 @@
+/*****************************************************************************
+ * scaletempo_search.h: best overlap search of the tempo scaler
+ *****************************************************************************
+ * Copyright © 2008-2026 VLC authors and VideoLAN
+ * $Id$
+ *
+ * Authors: Rov Juvano <rovjuvano@users.sourceforge.net>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_SCALETEMPO_SEARCH_H_
+#define VLC_SCALETEMPO_SEARCH_H_
+
+#include <limits.h>
+#include <vlc_cpu.h>
+
+#if defined(HAVE_SSE_INTRINSICS) && (defined(__i386__) || defined(__x86_64__))
+# include <xmmintrin.h>
+# define SCALETEMPO_SSE 1
+#endif
+#if defined(__ARM_NEON__) || defined(__aarch64__)
+# include <arm_neon.h>
+# define SCALETEMPO_NEON 1
+#endif
+
+/*
+ * The correlation of the windowed overlap (pre_corr) with the input queue is
+ * computed at every frame offset of the search window. The exhaustive search
+ * computes it 4 offsets at a time, so that each pre_corr sample is loaded
+ * once for 4 multiplications.
+ *
+ * The coarse search first correlates decimated copies of both signals, where
+ * each channel is summed over SCALETEMPO_DECIMATION frames separately, then
+ * only refines the best few coarse offsets at full resolution.
+ */
+#define SCALETEMPO_DECIMATION 4
+#define SCALETEMPO_CANDIDATES 3
+
+/* Computes the correlations at 4 consecutive frame offsets */
+typedef void (*scaletempo_corr4_t)( const float *pre_corr, const float *search,
+                                    unsigned samples, unsigned stride,
+                                    float corr[4] );
+
+static void ScaletempoCorr4C( const float *pre_corr, const float *search,
+                              unsigned samples, unsigned stride,
+                              float corr[4] )
+{
+    for( unsigned k = 0; k < 4; k++ )
+    {
+        const float *ps = search + k * stride;
+        float sum = 0;
+
+        for( unsigned i = 0; i < samples; i++ )
+            sum += pre_corr[i] * ps[i];
+        corr[k] = sum;
+    }
+}
+
+#ifdef SCALETEMPO_SSE
+VLC_SSE
+static inline float ScaletempoSumSse( __m128 v )
+{
+    float f[4];
+
+    _mm_storeu_ps( f, v );
+    return ( f[0] + f[1] ) + ( f[2] + f[3] );
+}
+
+VLC_SSE
+static void ScaletempoCorr4Sse( const float *pre_corr, const float *search,
+                                unsigned samples, unsigned stride,
+                                float corr[4] )
+{
+    const float *ps0 = search, *ps1 = ps0 + stride;
+    const float *ps2 = ps1 + stride, *ps3 = ps2 + stride;
+    __m128 s0 = _mm_setzero_ps(), s1 = _mm_setzero_ps();
+    __m128 s2 = _mm_setzero_ps(), s3 = _mm_setzero_ps();
+    unsigned i = 0;
+
+    for( ; i + 4 <= samples; i += 4 )
+    {
+        const __m128 pc = _mm_loadu_ps( pre_corr + i );
+
+        s0 = _mm_add_ps( s0, _mm_mul_ps( pc, _mm_loadu_ps( ps0 + i ) ) );
+        s1 = _mm_add_ps( s1, _mm_mul_ps( pc, _mm_loadu_ps( ps1 + i ) ) );
+        s2 = _mm_add_ps( s2, _mm_mul_ps( pc, _mm_loadu_ps( ps2 + i ) ) );
+        s3 = _mm_add_ps( s3, _mm_mul_ps( pc, _mm_loadu_ps( ps3 + i ) ) );
+    }
+
+    corr[0] = ScaletempoSumSse( s0 );
+    corr[1] = ScaletempoSumSse( s1 );
+    corr[2] = ScaletempoSumSse( s2 );
+    corr[3] = ScaletempoSumSse( s3 );
+    for( ; i < samples; i++ )
+    {
+        corr[0] += pre_corr[i] * ps0[i];
+        corr[1] += pre_corr[i] * ps1[i];
+        corr[2] += pre_corr[i] * ps2[i];
+        corr[3] += pre_corr[i] * ps3[i];
+    }
+}
+#endif
+
+#ifdef SCALETEMPO_NEON
+static inline float ScaletempoSumNeon( float32x4_t v )
+{
+    float32x2_t h = vadd_f32( vget_low_f32( v ), vget_high_f32( v ) );
+    return vget_lane_f32( vpadd_f32( h, h ), 0 );
+}
+
+static void ScaletempoCorr4Neon( const float *pre_corr, const float *search,
+                                 unsigned samples, unsigned stride,
+                                 float corr[4] )
+{
+    const float *ps0 = search, *ps1 = ps0 + stride;
+    const float *ps2 = ps1 + stride, *ps3 = ps2 + stride;
+    float32x4_t s0 = vdupq_n_f32( 0.f ), s1 = vdupq_n_f32( 0.f );
+    float32x4_t s2 = vdupq_n_f32( 0.f ), s3 = vdupq_n_f32( 0.f );
+    unsigned i = 0;
+
+    for( ; i + 4 <= samples; i += 4 )
+    {
+        const float32x4_t pc = vld1q_f32( pre_corr + i );
+
+        s0 = vmlaq_f32( s0, pc, vld1q_f32( ps0 + i ) );
+        s1 = vmlaq_f32( s1, pc, vld1q_f32( ps1 + i ) );
+        s2 = vmlaq_f32( s2, pc, vld1q_f32( ps2 + i ) );
+        s3 = vmlaq_f32( s3, pc, vld1q_f32( ps3 + i ) );
+    }
+
+    corr[0] = ScaletempoSumNeon( s0 );
+    corr[1] = ScaletempoSumNeon( s1 );
+    corr[2] = ScaletempoSumNeon( s2 );
+    corr[3] = ScaletempoSumNeon( s3 );
+    for( ; i < samples; i++ )
+    {
+        corr[0] += pre_corr[i] * ps0[i];
+        corr[1] += pre_corr[i] * ps1[i];
+        corr[2] += pre_corr[i] * ps2[i];
+        corr[3] += pre_corr[i] * ps3[i];
+    }
+}
+#endif
+
+static inline scaletempo_corr4_t ScaletempoCorr4Select( void )
+{
+#ifdef SCALETEMPO_SSE
+    if( vlc_CPU_SSE() )
+        return ScaletempoCorr4Sse;
+#endif
+#ifdef SCALETEMPO_NEON
+# ifdef __aarch64__
+    if( vlc_CPU_ARM64_NEON() )
+# else
+    if( vlc_CPU_ARM_NEON() )
+# endif
+        return ScaletempoCorr4Neon;
+#endif
+    return ScaletempoCorr4C;
+}
+
+/* Exhaustive search of the offsets first to last (excluded), in frames */
+static unsigned ScaletempoSearchRange( scaletempo_corr4_t pf_corr4,
+                                       const float *pre_corr,
+                                       const float *search,
+                                       unsigned samples, unsigned channels,
+                                       unsigned first, unsigned last,
+                                       float *p_best_corr )
+{
+    float best_corr = *p_best_corr;
+    unsigned best_off = first;
+
+    for( unsigned off = first; off < last; off += 4 )
+    {
+        float corr[4];
+        unsigned count = __MIN( 4, last - off );
+
+        if( count == 4 )
+            pf_corr4( pre_corr, search + off * channels, samples, channels,
+                      corr );
+        else
+            for( unsigned k = 0; k < count; k++ )
+            {
+                const float *ps = search + ( off + k ) * channels;
+                corr[k] = 0;
+                for( unsigned i = 0; i < samples; i++ )
+                    corr[k] += pre_corr[i] * ps[i];
+            }
+
+        for( unsigned k = 0; k < count; k++ )
+            if( corr[k] > best_corr )
+            {
+                best_corr = corr[k];
+                best_off = off + k;
+            }
+    }
+    *p_best_corr = best_corr;
+    return best_off;
+}
+
+static unsigned ScaletempoSearch( scaletempo_corr4_t pf_corr4,
+                                  const float *pre_corr, const float *search,
+                                  unsigned samples, unsigned channels,
+                                  unsigned frames_search )
+{
+    float best_corr = INT_MIN;
+
+    return ScaletempoSearchRange( pf_corr4, pre_corr, search, samples,
+                                  channels, 0, frames_search, &best_corr );
+}
+
+/* Sums groups of SCALETEMPO_DECIMATION frames, channel by channel */
+static void ScaletempoDecimate( float *p_dst, const float *p_src,
+                                unsigned frames, unsigned channels )
+{
+    for( unsigned j = 0; j < frames / SCALETEMPO_DECIMATION; j++ )
+    {
+        for( unsigned c = 0; c < channels; c++ )
+            p_dst[c] = p_src[c];
+        p_src += channels;
+        for( unsigned d = 1; d < SCALETEMPO_DECIMATION; d++ )
+        {
+            for( unsigned c = 0; c < channels; c++ )
+                p_dst[c] += p_src[c];
+            p_src += channels;
+        }
+        p_dst += channels;
+    }
+}
+
+/* Size of the coarse buffer, in floats */
+static inline size_t ScaletempoCoarseSize( unsigned frames_overlap,
+                                           unsigned frames_search,
+                                           unsigned channels )
+{
+    return ( ( 2 * frames_overlap + frames_search ) / SCALETEMPO_DECIMATION
+             + 1 ) * channels;
+}
+
+static void ScaletempoCandidate( float cand_corr[], unsigned cand_off[],
+                                 float corr, unsigned off )
+{
+    unsigned c = SCALETEMPO_CANDIDATES;
+
+    /* Best coarse offsets, in decreasing order */
+    while( c > 0 && corr > cand_corr[c - 1] )
+    {
+        if( c < SCALETEMPO_CANDIDATES )
+        {
+            cand_corr[c] = cand_corr[c - 1];
+            cand_off[c] = cand_off[c - 1];
+        }
+        c--;
+    }
+    if( c < SCALETEMPO_CANDIDATES )
+    {
+        cand_corr[c] = corr;
+        cand_off[c] = off;
+    }
+}
+
+static unsigned ScaletempoSearchCoarse( scaletempo_corr4_t pf_corr4,
+                                        const float *pre_corr,
+                                        const float *search,
+                                        unsigned samples, unsigned channels,
+                                        unsigned frames_search,
+                                        float *p_coarse )
+{
+    const unsigned D = SCALETEMPO_DECIMATION;
+    const unsigned frames_corr = samples / channels;
+    const unsigned coarse_corr = frames_corr / D;
+    const unsigned coarse_search = frames_search / D;
+
+    if( coarse_corr == 0 || coarse_search < SCALETEMPO_CANDIDATES )
+        return ScaletempoSearch( pf_corr4, pre_corr, search, samples,
+                                 channels, frames_search );
+
+    float *p_pc = p_coarse;
+    float *p_s = p_coarse + coarse_corr * channels;
+    ScaletempoDecimate( p_pc, pre_corr, frames_corr, channels );
+    ScaletempoDecimate( p_s, search, ( coarse_search + coarse_corr ) * D,
+                        channels );
+
+    float cand_corr[SCALETEMPO_CANDIDATES];
+    unsigned cand_off[SCALETEMPO_CANDIDATES];
+    for( unsigned c = 0; c < SCALETEMPO_CANDIDATES; c++ )
+    {
+        cand_corr[c] = INT_MIN;
+        cand_off[c] = 0;
+    }
+
+    unsigned k = 0;
+    for( ; k + 4 <= coarse_search; k += 4 )
+    {
+        float corr[4];
+
+        pf_corr4( p_pc, p_s + k * channels, coarse_corr * channels,
+                  channels, corr );
+        for( unsigned i = 0; i < 4; i++ )
+            ScaletempoCandidate( cand_corr, cand_off, corr[i], k + i );
+    }
+    for( ; k < coarse_search; k++ )
+    {
+        float corr = 0;
+        for( unsigned i = 0; i < coarse_corr * channels; i++ )
+            corr += p_pc[i] * p_s[k * channels + i];
+        ScaletempoCandidate( cand_corr, cand_off, corr, k );
+    }
+
+    /* Full resolution around the candidates */
+    float best_corr = INT_MIN;
+    unsigned best_off = 0;
+    for( unsigned c = 0; c < SCALETEMPO_CANDIDATES; c++ )
+    {
+        unsigned first = cand_off[c] * D + 1 > D ? cand_off[c] * D + 1 - D : 0;
+        unsigned last = __MIN( cand_off[c] * D + D + 1, frames_search );
+        float corr = best_corr;
+        unsigned off = ScaletempoSearchRange( pf_corr4, pre_corr, search,
+                                              samples, channels, first, last,
+                                              &corr );
+        if( corr > best_corr )
+        {
+            best_corr = corr;
+            best_off = off;
+        }
+    }
+    return best_off;
+}
+
+#endif
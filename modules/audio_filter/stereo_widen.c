@@ -36,6 +36,7 @@ static int  Open ( vlc_object_t * );
 static void Close( vlc_object_t * );
 
 static block_t *Filter ( filter_t *, block_t * );
+static void FilterInplace ( filter_t *, float *, unsigned );
 static int paramCallback( vlc_object_t *, char const *, vlc_value_t ,
                             vlc_value_t , void * );
 
@@ -133,6 +134,7 @@ static int Open( vlc_object_t *obj )
     p_sys->b_free_buf = true;
     p_sys->pf_write = p_sys->pf_begin;
     p_filter->pf_audio_filter = Filter;
+    p_filter->pf_audio_inplace = FilterInplace;
     return VLC_SUCCESS;
 }
 
@@ -141,12 +143,19 @@ static int Open( vlc_object_t *obj )
  * Filter: process each sample
  *****************************************************************************/
 static block_t *Filter( filter_t *p_filter, block_t *p_block )
+{
+    FilterInplace( p_filter, (float *)p_block->p_buffer,
+                   p_block->i_nb_samples );
+    return p_block;
+}
+
+static void FilterInplace( filter_t *p_filter, float *p_out,
+                           unsigned i_frames )
 {
     filter_sys_t *p_sys = p_filter->p_sys;
-    float *p_out = (float *)p_block->p_buffer;
     float *pf_read;
 
-    for (unsigned i = p_block->i_nb_samples; i > 0; i--)
+    for (unsigned i = i_frames; i > 0; i--)
     {
         pf_read = p_sys->pf_write + 2;
         /* if at end of buffer put read ptr at begin */
@@ -169,8 +178,6 @@ static block_t *Filter( filter_t *p_filter, block_t *p_block )
         else
             p_sys->pf_write += 2;
     }
-
-    return p_block;
 }
 
 /*****************************************************************************
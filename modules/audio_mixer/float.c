@@ -34,6 +34,23 @@
 #include <vlc_plugin.h>
 #include <vlc_aout.h>
 #include <vlc_aout_volume.h>
+#include <vlc_cpu.h>
+
+#include "ramp.h"
+
+#if defined(HAVE_SSE_INTRINSICS) && (defined(__i386__) || defined(__x86_64__))
+# include <xmmintrin.h>
+# define MIXER_SSE 1
+# if defined(__AVX__) || VLC_GCC_VERSION(4, 9) || defined(__clang__)
+#  include <immintrin.h>
+#  define MIXER_AVX 1
+#  ifdef __AVX__
+#   define VLC_AVX
+#  else
+#   define VLC_AVX __attribute__ ((__target__ ("avx")))
+#  endif
+# endif
+#endif
 
 /*****************************************************************************
  * Local prototypes
@@ -67,6 +84,149 @@ static void FilterFL32( audio_volume_t *p_volume, block_t *p_buffer,
     (void) p_volume;
 }
 
+static void FilterFL32Ramp( audio_volume_t *p_volume, block_t *p_buffer,
+                            float f_from, float f_to )
+{
+    volume_ramp_t ramp;
+
+    if( !volume_RampInit( &ramp, p_buffer, sizeof(float), f_from, f_to ) )
+    {
+        FilterFL32( p_volume, p_buffer, f_to );
+        return;
+    }
+    volume_RampFL32( &ramp, (float *)p_buffer->p_buffer, 0 );
+}
+
+#ifdef MIXER_SSE
+VLC_SSE
+static void FilterFL32SSE( audio_volume_t *p_volume, block_t *p_buffer,
+                           float f_multiplier )
+{
+    if( f_multiplier == 1.f )
+        return; /* nothing to do */
+
+    float *p = (float *)p_buffer->p_buffer;
+    const size_t i_samples = p_buffer->i_buffer / sizeof(*p);
+    const __m128 mult = _mm_set1_ps( f_multiplier );
+    size_t i = 0;
+
+    for( ; i + 8 <= i_samples; i += 8 )
+    {
+        _mm_storeu_ps( p + i, _mm_mul_ps( _mm_loadu_ps( p + i ), mult ) );
+        _mm_storeu_ps( p + i + 4,
+                       _mm_mul_ps( _mm_loadu_ps( p + i + 4 ), mult ) );
+    }
+    for( ; i < i_samples; i++ )
+        p[i] *= f_multiplier;
+
+    (void) p_volume;
+}
+
+VLC_SSE
+static void FilterFL32RampSSE( audio_volume_t *p_volume, block_t *p_buffer,
+                               float f_from, float f_to )
+{
+    volume_ramp_t ramp;
+
+    if( !volume_RampInit( &ramp, p_buffer, sizeof(float), f_from, f_to ) )
+    {
+        FilterFL32SSE( p_volume, p_buffer, f_to );
+        return;
+    }
+
+    float frames[RAMP_PERIOD_MAX];
+    const unsigned i_period = volume_RampPeriod( &ramp, 4, frames );
+    const size_t i_samples = (size_t)ramp.frames * ramp.channels;
+    const __m128 from = _mm_set1_ps( ramp.from );
+    const __m128 step = _mm_set1_ps( ramp.step );
+    float *p = (float *)p_buffer->p_buffer;
+    float f_base = 0.f;
+    size_t i = 0;
+
+    for( ; i + i_period <= i_samples; i += i_period )
+    {
+        const __m128 base = _mm_set1_ps( f_base );
+
+        for( unsigned j = 0; j < i_period; j += 4 )
+        {
+            __m128 frame = _mm_add_ps( base, _mm_loadu_ps( frames + j ) );
+            __m128 gain = _mm_add_ps( from, _mm_mul_ps( step, frame ) );
+
+            _mm_storeu_ps( p + i + j,
+                           _mm_mul_ps( _mm_loadu_ps( p + i + j ), gain ) );
+        }
+        f_base += i_period / ramp.channels;
+    }
+    volume_RampFL32( &ramp, p + i, i / ramp.channels );
+}
+#endif
+
+#ifdef MIXER_AVX
+VLC_AVX
+static void FilterFL32AVX( audio_volume_t *p_volume, block_t *p_buffer,
+                           float f_multiplier )
+{
+    if( f_multiplier == 1.f )
+        return; /* nothing to do */
+
+    float *p = (float *)p_buffer->p_buffer;
+    const size_t i_samples = p_buffer->i_buffer / sizeof(*p);
+    const __m256 mult = _mm256_set1_ps( f_multiplier );
+    size_t i = 0;
+
+    for( ; i + 16 <= i_samples; i += 16 )
+    {
+        _mm256_storeu_ps( p + i,
+                          _mm256_mul_ps( _mm256_loadu_ps( p + i ), mult ) );
+        _mm256_storeu_ps( p + i + 8,
+                          _mm256_mul_ps( _mm256_loadu_ps( p + i + 8 ), mult ) );
+    }
+    for( ; i < i_samples; i++ )
+        p[i] *= f_multiplier;
+
+    (void) p_volume;
+}
+
+VLC_AVX
+static void FilterFL32RampAVX( audio_volume_t *p_volume, block_t *p_buffer,
+                               float f_from, float f_to )
+{
+    volume_ramp_t ramp;
+
+    if( !volume_RampInit( &ramp, p_buffer, sizeof(float), f_from, f_to ) )
+    {
+        FilterFL32AVX( p_volume, p_buffer, f_to );
+        return;
+    }
+
+    float frames[RAMP_PERIOD_MAX];
+    const unsigned i_period = volume_RampPeriod( &ramp, 8, frames );
+    const size_t i_samples = (size_t)ramp.frames * ramp.channels;
+    const __m256 from = _mm256_set1_ps( ramp.from );
+    const __m256 step = _mm256_set1_ps( ramp.step );
+    float *p = (float *)p_buffer->p_buffer;
+    float f_base = 0.f;
+    size_t i = 0;
+
+    for( ; i + i_period <= i_samples; i += i_period )
+    {
+        const __m256 base = _mm256_set1_ps( f_base );
+
+        for( unsigned j = 0; j < i_period; j += 8 )
+        {
+            __m256 frame = _mm256_add_ps( base, _mm256_loadu_ps( frames + j ) );
+            __m256 gain = _mm256_add_ps( from, _mm256_mul_ps( step, frame ) );
+
+            _mm256_storeu_ps( p + i + j,
+                              _mm256_mul_ps( _mm256_loadu_ps( p + i + j ),
+                                             gain ) );
+        }
+        f_base += i_period / ramp.channels;
+    }
+    volume_RampFL32( &ramp, p + i, i / ramp.channels );
+}
+#endif
+
 static void FilterFL64( audio_volume_t *p_volume, block_t *p_buffer,
                         float f_multiplier )
 {
@@ -81,6 +241,27 @@ static void FilterFL64( audio_volume_t *p_volume, block_t *p_buffer,
     (void) p_volume;
 }
 
+static void FilterFL64Ramp( audio_volume_t *p_volume, block_t *p_buffer,
+                            float f_from, float f_to )
+{
+    volume_ramp_t ramp;
+
+    if( !volume_RampInit( &ramp, p_buffer, sizeof(double), f_from, f_to ) )
+    {
+        FilterFL64( p_volume, p_buffer, f_to );
+        return;
+    }
+
+    double *p = (double *)p_buffer->p_buffer;
+    for( unsigned n = 0; n < ramp.frames; n++ )
+    {
+        const double gain = volume_RampGain( &ramp, n );
+
+        for( unsigned c = 0; c < ramp.channels; c++ )
+            *(p++) *= gain;
+    }
+}
+
 /**
  * Initializes the mixer
  */
@@ -92,9 +273,26 @@ static int Create( vlc_object_t *p_this )
     {
         case VLC_CODEC_FL32:
             p_volume->amplify = FilterFL32;
+            p_volume->amplify_ramp = FilterFL32Ramp;
+#ifdef MIXER_AVX
+            if( vlc_CPU_AVX() )
+            {
+                p_volume->amplify = FilterFL32AVX;
+                p_volume->amplify_ramp = FilterFL32RampAVX;
+                break;
+            }
+#endif
+#ifdef MIXER_SSE
+            if( vlc_CPU_SSE() )
+            {
+                p_volume->amplify = FilterFL32SSE;
+                p_volume->amplify_ramp = FilterFL32RampSSE;
+            }
+#endif
             break;
         case VLC_CODEC_FL64:
             p_volume->amplify = FilterFL64;
+            p_volume->amplify_ramp = FilterFL64Ramp;
             break;
         default:
             return -1;
@@ -29,6 +29,23 @@
 #include <vlc_plugin.h>
 #include <vlc_aout.h>
 #include <vlc_aout_volume.h>
+#include <vlc_cpu.h>
+
+#include "ramp.h"
+
+#if defined(HAVE_SSE2_INTRINSICS) && (defined(__i386__) || defined(__x86_64__))
+# include <emmintrin.h>
+# define MIXER_SSE2 1
+# ifdef __SSE2__
+#  define VLC_SSE2
+# else
+#  define VLC_SSE2 __attribute__ ((__target__ ("sse2")))
+# endif
+# if defined(__AVX2__) || VLC_GCC_VERSION(4, 9) || defined(__clang__)
+#  include <immintrin.h>
+#  define MIXER_AVX2 1
+# endif
+#endif
 
 static int Activate (vlc_object_t *);
 
@@ -82,6 +99,426 @@ static void FilterS16N (audio_volume_t *vol, block_t *block, float volume)
     (void) vol;
 }
 
+/* Gain ramps are computed in floating point, rounded to nearest */
+static void RampS32N (const volume_ramp_t *ramp, int32_t *p, unsigned frame)
+{
+    for (unsigned n = frame; n < ramp->frames; n++)
+    {
+        const double gain = volume_RampGain (ramp, n);
+
+        for (unsigned c = 0; c < ramp->channels; c++)
+        {
+            double s = *p * gain;
+            if (s > INT32_MAX)
+                s = INT32_MAX;
+            else
+            if (s < INT32_MIN)
+                s = INT32_MIN;
+            *(p++) = lrint (s);
+        }
+    }
+}
+
+static void FilterS32NRamp (audio_volume_t *vol, block_t *block,
+                            float from, float to)
+{
+    volume_ramp_t ramp;
+
+    if (!volume_RampInit (&ramp, block, sizeof (int32_t), from, to))
+        FilterS32N (vol, block, to);
+    else
+        RampS32N (&ramp, (int32_t *)block->p_buffer, 0);
+}
+
+static void RampS16N (const volume_ramp_t *ramp, int16_t *p, unsigned frame)
+{
+    for (unsigned n = frame; n < ramp->frames; n++)
+    {
+        const float gain = volume_RampGain (ramp, n);
+
+        for (unsigned c = 0; c < ramp->channels; c++)
+        {
+            float s = *p * gain;
+            if (s > INT16_MAX)
+                s = INT16_MAX;
+            else
+            if (s < INT16_MIN)
+                s = INT16_MIN;
+            *(p++) = lrintf (s);
+        }
+    }
+}
+
+static void FilterS16NRamp (audio_volume_t *vol, block_t *block,
+                            float from, float to)
+{
+    volume_ramp_t ramp;
+
+    if (!volume_RampInit (&ramp, block, sizeof (int16_t), from, to))
+        FilterS16N (vol, block, to);
+    else
+        RampS16N (&ramp, (int16_t *)block->p_buffer, 0);
+}
+
+#ifdef MIXER_SSE2
+/* Same fixed point multiplier as the C version, so the same output */
+VLC_SSE2
+static void FilterS16NSSE2 (audio_volume_t *vol, block_t *block, float volume)
+{
+    int16_t *p = (int16_t *)block->p_buffer;
+    const size_t n = block->i_buffer / sizeof (*p);
+
+    int_fast32_t mult = lroundf (volume * 0x1.p8f);
+    if (mult == (1 << 8))
+        return;
+    if (mult > INT16_MAX)
+    {
+        FilterS16N (vol, block, volume);
+        return;
+    }
+
+    const __m128i m = _mm_set1_epi16 (mult);
+    size_t i = 0;
+
+    for (; i + 8 <= n; i += 8)
+    {
+        __m128i x = _mm_loadu_si128 ((const __m128i *)(p + i));
+        __m128i lo = _mm_mullo_epi16 (x, m);
+        __m128i hi = _mm_mulhi_epi16 (x, m);
+        __m128i a = _mm_srai_epi32 (_mm_unpacklo_epi16 (lo, hi), 8);
+        __m128i b = _mm_srai_epi32 (_mm_unpackhi_epi16 (lo, hi), 8);
+
+        _mm_storeu_si128 ((__m128i *)(p + i), _mm_packs_epi32 (a, b));
+    }
+
+    for (; i < n; i++)
+    {
+        int_fast32_t s = (p[i] * mult) >> 8;
+        if (s > INT16_MAX)
+            s = INT16_MAX;
+        else
+        if (s < INT16_MIN)
+            s = INT16_MIN;
+        p[i] = s;
+    }
+}
+
+VLC_SSE2
+static void FilterS16NRampSSE2 (audio_volume_t *vol, block_t *block,
+                                float from, float to)
+{
+    volume_ramp_t ramp;
+
+    if (!volume_RampInit (&ramp, block, sizeof (int16_t), from, to))
+    {
+        FilterS16NSSE2 (vol, block, to);
+        return;
+    }
+
+    float frames[RAMP_PERIOD_MAX];
+    const unsigned period = volume_RampPeriod (&ramp, 4, frames);
+    const size_t n = (size_t)ramp.frames * ramp.channels;
+    const __m128 start = _mm_set1_ps (ramp.from);
+    const __m128 step = _mm_set1_ps (ramp.step);
+    int16_t *p = (int16_t *)block->p_buffer;
+    float base = 0.f;
+    size_t i = 0;
+
+    for (; i + period <= n; i += period)
+    {
+        const __m128 b = _mm_set1_ps (base);
+
+        for (unsigned j = 0; j < period; j += 4)
+        {
+            __m128 frame = _mm_add_ps (b, _mm_loadu_ps (frames + j));
+            __m128 gain = _mm_add_ps (start, _mm_mul_ps (step, frame));
+            __m128i x = _mm_loadl_epi64 ((const __m128i *)(p + i + j));
+            __m128 f = _mm_cvtepi32_ps (_mm_srai_epi32 (
+                                            _mm_unpacklo_epi16 (x, x), 16));
+            __m128i y = _mm_cvtps_epi32 (_mm_mul_ps (f, gain));
+
+            _mm_storel_epi64 ((__m128i *)(p + i + j), _mm_packs_epi32 (y, y));
+        }
+        base += period / ramp.channels;
+    }
+    RampS16N (&ramp, p + i, i / ramp.channels);
+}
+
+/* Computed in double precision: rounded to nearest instead of down */
+VLC_SSE2
+static void FilterS32NSSE2 (audio_volume_t *vol, block_t *block, float volume)
+{
+    int32_t *p = (int32_t *)block->p_buffer;
+    const size_t n = block->i_buffer / sizeof (*p);
+
+    int_fast32_t mult = lroundf (volume * 0x1.p24f);
+    if (mult == (1 << 24))
+        return;
+
+    const __m128d g = _mm_set1_pd (mult * 0x1.p-24);
+    const __m128d max = _mm_set1_pd (INT32_MAX);
+    const __m128d min = _mm_set1_pd (INT32_MIN);
+    size_t i = 0;
+
+    for (; i + 4 <= n; i += 4)
+    {
+        __m128i x = _mm_loadu_si128 ((const __m128i *)(p + i));
+        __m128d lo = _mm_mul_pd (_mm_cvtepi32_pd (x), g);
+        __m128d hi = _mm_mul_pd (_mm_cvtepi32_pd (_mm_unpackhi_epi64 (x, x)),
+                                 g);
+
+        lo = _mm_min_pd (_mm_max_pd (lo, min), max);
+        hi = _mm_min_pd (_mm_max_pd (hi, min), max);
+        _mm_storeu_si128 ((__m128i *)(p + i),
+                          _mm_unpacklo_epi64 (_mm_cvtpd_epi32 (lo),
+                                              _mm_cvtpd_epi32 (hi)));
+    }
+
+    for (; i < n; i++)
+    {
+        int_fast64_t s = (p[i] * (int_fast64_t)mult) >> INT64_C(24);
+        if (s > INT32_MAX)
+            s = INT32_MAX;
+        else
+        if (s < INT32_MIN)
+            s = INT32_MIN;
+        p[i] = s;
+    }
+    (void) vol;
+}
+
+VLC_SSE2
+static void FilterS32NRampSSE2 (audio_volume_t *vol, block_t *block,
+                                float from, float to)
+{
+    volume_ramp_t ramp;
+
+    if (!volume_RampInit (&ramp, block, sizeof (int32_t), from, to))
+    {
+        FilterS32NSSE2 (vol, block, to);
+        return;
+    }
+
+    float frames[RAMP_PERIOD_MAX];
+    const unsigned period = volume_RampPeriod (&ramp, 4, frames);
+    const size_t n = (size_t)ramp.frames * ramp.channels;
+    const __m128 start = _mm_set1_ps (ramp.from);
+    const __m128 step = _mm_set1_ps (ramp.step);
+    const __m128d max = _mm_set1_pd (INT32_MAX);
+    const __m128d min = _mm_set1_pd (INT32_MIN);
+    int32_t *p = (int32_t *)block->p_buffer;
+    float base = 0.f;
+    size_t i = 0;
+
+    for (; i + period <= n; i += period)
+    {
+        const __m128 b = _mm_set1_ps (base);
+
+        for (unsigned j = 0; j < period; j += 4)
+        {
+            __m128 frame = _mm_add_ps (b, _mm_loadu_ps (frames + j));
+            __m128 gain = _mm_add_ps (start, _mm_mul_ps (step, frame));
+            __m128i x = _mm_loadu_si128 ((const __m128i *)(p + i + j));
+            __m128d lo = _mm_mul_pd (_mm_cvtepi32_pd (x),
+                                     _mm_cvtps_pd (gain));
+            __m128d hi = _mm_mul_pd (_mm_cvtepi32_pd (
+                                         _mm_unpackhi_epi64 (x, x)),
+                                     _mm_cvtps_pd (_mm_movehl_ps (gain, gain)));
+
+            lo = _mm_min_pd (_mm_max_pd (lo, min), max);
+            hi = _mm_min_pd (_mm_max_pd (hi, min), max);
+            _mm_storeu_si128 ((__m128i *)(p + i + j),
+                              _mm_unpacklo_epi64 (_mm_cvtpd_epi32 (lo),
+                                                  _mm_cvtpd_epi32 (hi)));
+        }
+        base += period / ramp.channels;
+    }
+    RampS32N (&ramp, p + i, i / ramp.channels);
+}
+#endif
+
+#ifdef MIXER_AVX2
+VLC_AVX2
+static void FilterS16NAVX2 (audio_volume_t *vol, block_t *block, float volume)
+{
+    int16_t *p = (int16_t *)block->p_buffer;
+    const size_t n = block->i_buffer / sizeof (*p);
+
+    int_fast32_t mult = lroundf (volume * 0x1.p8f);
+    if (mult == (1 << 8))
+        return;
+    if (mult > INT16_MAX)
+    {
+        FilterS16N (vol, block, volume);
+        return;
+    }
+
+    const __m256i m = _mm256_set1_epi16 (mult);
+    size_t i = 0;
+
+    /* Unpacking and packing both work within 128-bits lanes */
+    for (; i + 16 <= n; i += 16)
+    {
+        __m256i x = _mm256_loadu_si256 ((const __m256i *)(p + i));
+        __m256i lo = _mm256_mullo_epi16 (x, m);
+        __m256i hi = _mm256_mulhi_epi16 (x, m);
+        __m256i a = _mm256_srai_epi32 (_mm256_unpacklo_epi16 (lo, hi), 8);
+        __m256i b = _mm256_srai_epi32 (_mm256_unpackhi_epi16 (lo, hi), 8);
+
+        _mm256_storeu_si256 ((__m256i *)(p + i), _mm256_packs_epi32 (a, b));
+    }
+
+    for (; i < n; i++)
+    {
+        int_fast32_t s = (p[i] * mult) >> 8;
+        if (s > INT16_MAX)
+            s = INT16_MAX;
+        else
+        if (s < INT16_MIN)
+            s = INT16_MIN;
+        p[i] = s;
+    }
+}
+
+VLC_AVX2
+static void FilterS16NRampAVX2 (audio_volume_t *vol, block_t *block,
+                                float from, float to)
+{
+    volume_ramp_t ramp;
+
+    if (!volume_RampInit (&ramp, block, sizeof (int16_t), from, to))
+    {
+        FilterS16NAVX2 (vol, block, to);
+        return;
+    }
+
+    float frames[RAMP_PERIOD_MAX];
+    const unsigned period = volume_RampPeriod (&ramp, 8, frames);
+    const size_t n = (size_t)ramp.frames * ramp.channels;
+    const __m256 start = _mm256_set1_ps (ramp.from);
+    const __m256 step = _mm256_set1_ps (ramp.step);
+    int16_t *p = (int16_t *)block->p_buffer;
+    float base = 0.f;
+    size_t i = 0;
+
+    for (; i + period <= n; i += period)
+    {
+        const __m256 b = _mm256_set1_ps (base);
+
+        for (unsigned j = 0; j < period; j += 8)
+        {
+            __m256 frame = _mm256_add_ps (b, _mm256_loadu_ps (frames + j));
+            __m256 gain = _mm256_add_ps (start, _mm256_mul_ps (step, frame));
+            __m128i x = _mm_loadu_si128 ((const __m128i *)(p + i + j));
+            __m256 f = _mm256_cvtepi32_ps (_mm256_cvtepi16_epi32 (x));
+            __m256i y = _mm256_cvtps_epi32 (_mm256_mul_ps (f, gain));
+
+            _mm_storeu_si128 ((__m128i *)(p + i + j),
+                              _mm_packs_epi32 (_mm256_castsi256_si128 (y),
+                                               _mm256_extracti128_si256 (y, 1)));
+        }
+        base += period / ramp.channels;
+    }
+    RampS16N (&ramp, p + i, i / ramp.channels);
+}
+
+/* Same computations as the SSE2 version */
+VLC_AVX2
+static void FilterS32NAVX2 (audio_volume_t *vol, block_t *block, float volume)
+{
+    int32_t *p = (int32_t *)block->p_buffer;
+    const size_t n = block->i_buffer / sizeof (*p);
+
+    int_fast32_t mult = lroundf (volume * 0x1.p24f);
+    if (mult == (1 << 24))
+        return;
+
+    const __m256d g = _mm256_set1_pd (mult * 0x1.p-24);
+    const __m256d max = _mm256_set1_pd (INT32_MAX);
+    const __m256d min = _mm256_set1_pd (INT32_MIN);
+    size_t i = 0;
+
+    for (; i + 8 <= n; i += 8)
+    {
+        __m256i x = _mm256_loadu_si256 ((const __m256i *)(p + i));
+        __m256d lo = _mm256_mul_pd (
+            _mm256_cvtepi32_pd (_mm256_castsi256_si128 (x)), g);
+        __m256d hi = _mm256_mul_pd (
+            _mm256_cvtepi32_pd (_mm256_extracti128_si256 (x, 1)), g);
+
+        lo = _mm256_min_pd (_mm256_max_pd (lo, min), max);
+        hi = _mm256_min_pd (_mm256_max_pd (hi, min), max);
+        _mm256_storeu_si256 ((__m256i *)(p + i),
+            _mm256_inserti128_si256 (
+                _mm256_castsi128_si256 (_mm256_cvtpd_epi32 (lo)),
+                _mm256_cvtpd_epi32 (hi), 1));
+    }
+
+    for (; i < n; i++)
+    {
+        int_fast64_t s = (p[i] * (int_fast64_t)mult) >> INT64_C(24);
+        if (s > INT32_MAX)
+            s = INT32_MAX;
+        else
+        if (s < INT32_MIN)
+            s = INT32_MIN;
+        p[i] = s;
+    }
+    (void) vol;
+}
+
+VLC_AVX2
+static void FilterS32NRampAVX2 (audio_volume_t *vol, block_t *block,
+                                float from, float to)
+{
+    volume_ramp_t ramp;
+
+    if (!volume_RampInit (&ramp, block, sizeof (int32_t), from, to))
+    {
+        FilterS32NAVX2 (vol, block, to);
+        return;
+    }
+
+    float frames[RAMP_PERIOD_MAX];
+    const unsigned period = volume_RampPeriod (&ramp, 8, frames);
+    const size_t n = (size_t)ramp.frames * ramp.channels;
+    const __m256 start = _mm256_set1_ps (ramp.from);
+    const __m256 step = _mm256_set1_ps (ramp.step);
+    const __m256d max = _mm256_set1_pd (INT32_MAX);
+    const __m256d min = _mm256_set1_pd (INT32_MIN);
+    int32_t *p = (int32_t *)block->p_buffer;
+    float base = 0.f;
+    size_t i = 0;
+
+    for (; i + period <= n; i += period)
+    {
+        const __m256 b = _mm256_set1_ps (base);
+
+        for (unsigned j = 0; j < period; j += 8)
+        {
+            __m256 frame = _mm256_add_ps (b, _mm256_loadu_ps (frames + j));
+            __m256 gain = _mm256_add_ps (start, _mm256_mul_ps (step, frame));
+            __m256i x = _mm256_loadu_si256 ((const __m256i *)(p + i + j));
+            __m256d lo = _mm256_mul_pd (
+                _mm256_cvtepi32_pd (_mm256_castsi256_si128 (x)),
+                _mm256_cvtps_pd (_mm256_castps256_ps128 (gain)));
+            __m256d hi = _mm256_mul_pd (
+                _mm256_cvtepi32_pd (_mm256_extracti128_si256 (x, 1)),
+                _mm256_cvtps_pd (_mm256_extractf128_ps (gain, 1)));
+
+            lo = _mm256_min_pd (_mm256_max_pd (lo, min), max);
+            hi = _mm256_min_pd (_mm256_max_pd (hi, min), max);
+            _mm256_storeu_si256 ((__m256i *)(p + i + j),
+                _mm256_inserti128_si256 (
+                    _mm256_castsi128_si256 (_mm256_cvtpd_epi32 (lo)),
+                    _mm256_cvtpd_epi32 (hi), 1));
+        }
+        base += period / ramp.channels;
+    }
+    RampS32N (&ramp, p + i, i / ramp.channels);
+}
+#endif
+
 static void FilterU8 (audio_volume_t *vol, block_t *block, float volume)
 {
     uint8_t *p = (uint8_t *)block->p_buffer;
@@ -103,6 +540,35 @@ static void FilterU8 (audio_volume_t *vol, block_t *block, float volume)
     (void) vol;
 }
 
+static void FilterU8Ramp (audio_volume_t *vol, block_t *block,
+                          float from, float to)
+{
+    volume_ramp_t ramp;
+
+    if (!volume_RampInit (&ramp, block, sizeof (uint8_t), from, to))
+    {
+        FilterU8 (vol, block, to);
+        return;
+    }
+
+    uint8_t *p = (uint8_t *)block->p_buffer;
+    for (unsigned n = 0; n < ramp.frames; n++)
+    {
+        const float gain = volume_RampGain (&ramp, n);
+
+        for (unsigned c = 0; c < ramp.channels; c++)
+        {
+            float s = ((int_fast8_t)(*p - 128)) * gain;
+            if (s > INT8_MAX)
+                s = INT8_MAX;
+            else
+            if (s < INT8_MIN)
+                s = INT8_MIN;
+            *(p++) = lrintf (s) + 128;
+        }
+    }
+}
+
 static int Activate (vlc_object_t *obj)
 {
     audio_volume_t *vol = (audio_volume_t *)obj;
@@ -111,12 +577,43 @@ static int Activate (vlc_object_t *obj)
     {
         case VLC_CODEC_S32N:
             vol->amplify = FilterS32N;
+            vol->amplify_ramp = FilterS32NRamp;
+#ifdef MIXER_SSE2
+            if (vlc_CPU_SSE2 ())
+            {
+                vol->amplify = FilterS32NSSE2;
+                vol->amplify_ramp = FilterS32NRampSSE2;
+            }
+#endif
+#ifdef MIXER_AVX2
+            if (vlc_CPU_AVX2 ())
+            {
+                vol->amplify = FilterS32NAVX2;
+                vol->amplify_ramp = FilterS32NRampAVX2;
+            }
+#endif
             break;
         case VLC_CODEC_S16N:
             vol->amplify = FilterS16N;
+            vol->amplify_ramp = FilterS16NRamp;
+#ifdef MIXER_SSE2
+            if (vlc_CPU_SSE2 ())
+            {
+                vol->amplify = FilterS16NSSE2;
+                vol->amplify_ramp = FilterS16NRampSSE2;
+            }
+#endif
+#ifdef MIXER_AVX2
+            if (vlc_CPU_AVX2 ())
+            {
+                vol->amplify = FilterS16NAVX2;
+                vol->amplify_ramp = FilterS16NRampAVX2;
+            }
+#endif
             break;
         case VLC_CODEC_U8:
             vol->amplify = FilterU8;
+            vol->amplify_ramp = FilterU8Ramp;
             break;
         default:
             return -1;
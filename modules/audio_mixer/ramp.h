@@ -0,0 +1,98 @@
+/*****************************************************************************
+ * ramp.h: software volume gain ramps
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_AUDIO_MIXER_RAMP_H_
+#define VLC_AUDIO_MIXER_RAMP_H_
+
+/*
+ * A volume change is spread linearly over one block: the n-th frame of a
+ * block of N frames (counted from 1) is amplified by
+ *      from + (to - from) * n / N
+ * so that the last frame reaches the new volume.
+ *
+ * Vectorized kernels process runs of samples spanning a whole number of both
+ * frames and vectors, within which the frame number of each lane is fixed.
+ */
+
+/** Largest run of samples, for 8 lanes vectors */
+#define RAMP_PERIOD_MAX (8 * AOUT_CHAN_MAX)
+
+typedef struct
+{
+    unsigned channels;
+    unsigned frames;
+    float from;
+    float step; /**< Gain increment per frame */
+} volume_ramp_t;
+
+static inline bool volume_RampInit(volume_ramp_t *ramp, const block_t *block,
+                                   size_t sample_size, float from, float to)
+{
+    size_t samples = block->i_buffer / sample_size;
+
+    if (block->i_nb_samples == 0 || (samples % block->i_nb_samples) != 0
+     || samples / block->i_nb_samples > AOUT_CHAN_MAX)
+        return false;
+
+    ramp->channels = samples / block->i_nb_samples;
+    ramp->frames = block->i_nb_samples;
+    ramp->from = from;
+    ramp->step = (to - from) / block->i_nb_samples;
+    return true;
+}
+
+/**
+ * Computes the frame number of each sample of a run.
+ * \param width number of lanes of the vectors
+ * \return the number of samples in the run
+ */
+static inline unsigned volume_RampPeriod(const volume_ramp_t *ramp,
+                                         unsigned width,
+                                         float frames[RAMP_PERIOD_MAX])
+{
+    unsigned period = ramp->channels;
+
+    while (period % width)
+        period += ramp->channels;
+    for (unsigned i = 0; i < period; i++)
+        frames[i] = i / ramp->channels + 1;
+    return period;
+}
+
+/** Gain of the n-th frame (counted from 0) */
+static inline float volume_RampGain(const volume_ramp_t *ramp, unsigned n)
+{
+    return ramp->from + ramp->step * (float)(n + 1);
+}
+
+/** Ramps single precision samples, from the given frame onward */
+static inline void volume_RampFL32(const volume_ramp_t *ramp, float *p,
+                                   unsigned frame)
+{
+    for (unsigned n = frame; n < ramp->frames; n++)
+    {
+        const float gain = volume_RampGain(ramp, n);
+
+        for (unsigned c = 0; c < ramp->channels; c++)
+            *(p++) *= gain;
+    }
+}
+
+#endif
@@ -772,14 +772,23 @@ static int Start(audio_output_t *aout, audio_sample_format_t *restrict fmt)
                             | PA_STREAM_AUTO_TIMING_UPDATE
                             | PA_STREAM_FIX_RATE;
 
+    /* In low latency mode, the target length is the end-to-end latency,
+     * including the server and device buffers. */
+    const bool low_latency = var_InheritBool(aout, "audio-low-latency");
+    const mtime_t period = low_latency ? AOUT_LOW_LATENCY_PERIOD
+                                       : AOUT_MIN_PREPARE_TIME;
+    if (low_latency)
+        flags |= PA_STREAM_ADJUST_LATENCY;
+
     struct pa_buffer_attr attr;
     attr.maxlength = -1;
     /* PulseAudio goes berserk if the target length (tlength) is not
      * significantly longer than 2 periods (minreq), or when the period length
      * is unspecified and the target length is short. */
-    attr.tlength = pa_usec_to_bytes(3 * AOUT_MIN_PREPARE_TIME, &ss);
+    attr.tlength = pa_usec_to_bytes(low_latency ? AOUT_LOW_LATENCY_BUFFER
+                                                : 3 * period, &ss);
     attr.prebuf = 0; /* trigger manually */
-    attr.minreq = pa_usec_to_bytes(AOUT_MIN_PREPARE_TIME, &ss);
+    attr.minreq = pa_usec_to_bytes(period, &ss);
     attr.fragsize = 0; /* not used for output */
 
     pa_cvolume *cvolume = NULL, cvolumebuf;
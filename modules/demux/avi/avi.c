@@ -37,6 +37,9 @@
 #include <vlc_input.h>
 
 #include <vlc_dialog.h>
+#include <vlc_fs.h>
+#include <vlc_interrupt.h>
+#include <vlc_md5.h>
 
 #include <vlc_meta.h>
 #include <vlc_codecs.h>
@@ -57,6 +60,16 @@
     "Recreate a index for the AVI file. Use this if your AVI file is damaged "\
     "or incomplete (not seekable)." )
 
+#define BACKGROUND_INDEX_TEXT N_("Build the index in the background")
+#define BACKGROUND_INDEX_LONGTEXT N_( \
+    "Start playing files with a broken or missing index right away, and " \
+    "make seeking more accurate while the index is being built." )
+
+#define INDEX_CACHE_TEXT N_("Keep the rebuilt indexes")
+#define INDEX_CACHE_LONGTEXT N_( \
+    "Save the indexes rebuilt for broken or incomplete files, and reuse " \
+    "them when opening the same files again." )
+
 #define BI_RAWRGB 0x00
 #define BI_RGBBITFIELDS 0x03
 
@@ -82,6 +95,10 @@ vlc_module_begin ()
     add_integer( "avi-index", 0,
               INDEX_TEXT, INDEX_LONGTEXT, false )
         change_integer_list( pi_index, ppsz_indexes )
+    add_bool( "avi-background-index", false,
+              BACKGROUND_INDEX_TEXT, BACKGROUND_INDEX_LONGTEXT, true )
+    add_bool( "avi-index-cache", false,
+              INDEX_CACHE_TEXT, INDEX_CACHE_LONGTEXT, true )
 
     set_callbacks( Open, Close )
 vlc_module_end ()
@@ -136,6 +153,8 @@ typedef struct
     avi_entry_t     *p_entry;
 
 } avi_index_t;
+typedef struct avi_indexer_t avi_indexer_t;
+
 static void avi_index_Init( avi_index_t * );
 static void avi_index_Clean( avi_index_t * );
 static void avi_index_Append( avi_index_t *, off_t *, avi_entry_t * );
@@ -190,6 +209,9 @@ struct demux_sys_t
     off_t   i_movi_begin;
     off_t   i_movi_lastchunk_pos;   /* XXX position of last valid chunk */
 
+    /* index being rebuilt in the background, or NULL */
+    avi_indexer_t *p_indexer;
+
     /* number of streams and information */
     unsigned int i_track;
     avi_track_t  **track;
@@ -221,12 +243,16 @@ static int AVI_StreamBytesSet ( demux_t *,
 vlc_fourcc_t AVI_FourccGetCodec( unsigned int i_cat, vlc_fourcc_t );
 static int   AVI_GetKeyFlag    ( vlc_fourcc_t , uint8_t * );
 
-static int AVI_PacketGetHeader( demux_t *, avi_packet_t *p_pk );
-static int AVI_PacketNext     ( demux_t * );
-static int AVI_PacketSearch   ( demux_t * );
+static int AVI_PacketGetHeader( stream_t *, avi_packet_t *p_pk );
+static int AVI_PacketNext     ( stream_t * );
+static int AVI_PacketSearch   ( demux_t *, stream_t * );
 
 static void AVI_IndexLoad    ( demux_t * );
 static void AVI_IndexCreate  ( demux_t * );
+static int  AVI_IndexCacheLoad( demux_t * );
+static int  AVI_IndexStart   ( demux_t * );
+static void AVI_IndexStop    ( demux_t * );
+static void AVI_IndexMerge   ( demux_t * );
 
 static void AVI_ExtractSubtitle( demux_t *, unsigned int i_stream, avi_chunk_list_t *, avi_chunk_STRING_t * );
 
@@ -235,6 +261,8 @@ static void AVI_DvHandleAudio( demux_t *, avi_track_t *, block_t * );
 static mtime_t  AVI_MovieGetLength( demux_t * );
 
 static void AVI_MetaLoad( demux_t *, avi_chunk_list_t *p_riff, avi_chunk_avih_t *p_avih );
+static void AVI_MediaKitFix( demux_t *, avi_chunk_list_t *p_hdrl, avi_chunk_avih_t *p_avih );
+static bool AVI_IndexInBackground( demux_t *, avi_chunk_list_t *p_hdrl );
 
 block_t * ReadFrame( demux_t *p_demux, const avi_track_t *tk,
                      const int i_header, const int i_size );
@@ -712,7 +740,11 @@ static int Open( vlc_object_t * p_this )
 aviindex:
         if( p_sys->b_fastseekable )
         {
-            AVI_IndexCreate( p_demux );
+            /* Reuse the index rebuilt last time, else rebuild it */
+            if( AVI_IndexCacheLoad( p_demux ) &&
+                ( !AVI_IndexInBackground( p_demux, p_hdrl ) ||
+                  AVI_IndexStart( p_demux ) ) )
+                AVI_IndexCreate( p_demux );
         }
         else if( p_sys->b_seekable )
         {
@@ -752,7 +784,9 @@ aviindex:
                 b_index = true;
                 goto aviindex;
             }
-            if( i_do_index == 0 )
+            /* Nothing to wait for with the index built in the background */
+            if( i_do_index == 0 &&
+                !AVI_IndexInBackground( p_demux, p_hdrl ) )
             {
                 const char *psz_msg = _(
                     "Because this AVI file index is broken or missing, "
@@ -787,45 +821,16 @@ aviindex:
         }
     }
 
-    /* fix some BeOS MediaKit generated file */
-    for( i = 0 ; i < p_sys->i_track; i++ )
-    {
-        avi_track_t         *tk = p_sys->track[i];
-        avi_chunk_list_t    *p_strl;
-        avi_chunk_strf_auds_t    *p_auds;
+    /* Until the index is complete, trust the header for the length */
+    if( p_sys->p_indexer != NULL )
+        p_sys->i_length = __MAX( p_sys->i_length,
+                                 (mtime_t)p_avih->i_totalframes *
+                                 (mtime_t)p_avih->i_microsecperframe /
+                                 CLOCK_FREQ );
 
-        if( tk->i_cat != AUDIO_ES )
-        {
-            continue;
-        }
-        if( tk->idx.i_size < 1 ||
-            tk->i_scale != 1 ||
-            tk->i_samplesize != 0 )
-        {
-            continue;
-        }
-        p_strl = AVI_ChunkFind( p_hdrl, AVIFOURCC_strl, i );
-        p_auds = AVI_ChunkFind( p_strl, AVIFOURCC_strf, 0 );
-
-        if( p_auds->p_wf->wFormatTag != WAVE_FORMAT_PCM &&
-            tk->i_rate == p_auds->p_wf->nSamplesPerSec )
-        {
-            int64_t i_track_length =
-                tk->idx.p_entry[tk->idx.i_size-1].i_length +
-                tk->idx.p_entry[tk->idx.i_size-1].i_lengthtotal;
-            mtime_t i_length = (mtime_t)p_avih->i_totalframes *
-                               (mtime_t)p_avih->i_microsecperframe;
-
-            if( i_length == 0 )
-            {
-                msg_Warn( p_demux, "track[%d] cannot be fixed (BeOS MediaKit generated)", i );
-                continue;
-            }
-            tk->i_samplesize = 1;
-            tk->i_rate       = i_track_length  * CLOCK_FREQ / i_length;
-            msg_Warn( p_demux, "track[%d] fixed with rate=%d scale=%d (BeOS MediaKit generated)", i, tk->i_rate, tk->i_scale );
-        }
-    }
+    /* fix some BeOS MediaKit generated file, such files are never indexed
+     * in the background */
+    AVI_MediaKitFix( p_demux, p_hdrl, p_avih );
 
     if( p_sys->b_seekable )
     {
@@ -839,6 +844,8 @@ aviindex:
     return VLC_SUCCESS;
 
 error:
+    AVI_IndexStop( p_demux );
+
     for( unsigned i = 0; i < p_sys->i_attachment; i++)
         vlc_input_attachment_Delete(p_sys->attachment[i]);
     free(p_sys->attachment);
@@ -859,6 +866,8 @@ static void Close ( vlc_object_t * p_this )
     demux_t *    p_demux = (demux_t *)p_this;
     demux_sys_t *p_sys = p_demux->p_sys  ;
 
+    AVI_IndexStop( p_demux );
+
     for( unsigned int i = 0; i < p_sys->i_track; i++ )
     {
         if( p_sys->track[i] )
@@ -982,6 +991,7 @@ static int Demux_Seekable( demux_t *p_demux )
     /* cannot be more than 100 stream (dcXX or wbXX) */
     avi_track_toread_t toread[100];
 
+    AVI_IndexMerge( p_demux );
 
     /* detect new selected/unselected streams */
     for( i_track = 0; i_track < p_sys->i_track; i_track++ )
@@ -1119,7 +1129,7 @@ static int Demux_Seekable( demux_t *p_demux )
             if( p_sys->b_seekable && p_sys->i_movi_lastchunk_pos >= p_sys->i_movi_begin + 12 )
             {
                 vlc_stream_Seek( p_demux->s, p_sys->i_movi_lastchunk_pos );
-                if( AVI_PacketNext( p_demux ) )
+                if( AVI_PacketNext( p_demux->s ) )
                 {
                     return( AVI_TrackStopFinishedStreams( p_demux ) ? 0 : 1 );
                 }
@@ -1133,7 +1143,7 @@ static int Demux_Seekable( demux_t *p_demux )
             {
                 avi_packet_t avi_pk;
 
-                if( AVI_PacketGetHeader( p_demux, &avi_pk ) )
+                if( AVI_PacketGetHeader( p_demux->s, &avi_pk ) )
                 {
                     msg_Warn( p_demux,
                              "cannot get packet header, track disabled" );
@@ -1142,7 +1152,7 @@ static int Demux_Seekable( demux_t *p_demux )
                 if( avi_pk.i_stream >= p_sys->i_track ||
                     ( avi_pk.i_cat != AUDIO_ES && avi_pk.i_cat != VIDEO_ES ) )
                 {
-                    if( AVI_PacketNext( p_demux ) )
+                    if( AVI_PacketNext( p_demux->s ) )
                     {
                         msg_Warn( p_demux,
                                   "cannot skip packet, track disabled" );
@@ -1183,7 +1193,7 @@ static int Demux_Seekable( demux_t *p_demux )
                     }
                     else
                     {
-                        if( AVI_PacketNext( p_demux ) )
+                        if( AVI_PacketNext( p_demux->s ) )
                         {
                             msg_Warn( p_demux,
                                       "cannot skip packet, track disabled" );
@@ -1383,7 +1393,7 @@ static int Demux_UnSeekable( demux_t *p_demux )
 
         avi_packet_t    avi_pk;
 
-        if( AVI_PacketGetHeader( p_demux, &avi_pk ) )
+        if( AVI_PacketGetHeader( p_demux->s, &avi_pk ) )
         {
             return VLC_DEMUXER_EOF;
         }
@@ -1400,18 +1410,18 @@ static int Demux_UnSeekable( demux_t *p_demux )
                 case AVIFOURCC_JUNK:
                 case AVIFOURCC_LIST:
                 case AVIFOURCC_RIFF:
-                    return( !AVI_PacketNext( p_demux ) ? 1 : 0 );
+                    return( !AVI_PacketNext( p_demux->s ) ? 1 : 0 );
                 case AVIFOURCC_idx1:
                     if( p_sys->b_odml )
                     {
-                        return( !AVI_PacketNext( p_demux ) ? 1 : 0 );
+                        return( !AVI_PacketNext( p_demux->s ) ? 1 : 0 );
                     }
                     return VLC_DEMUXER_EOF;
                 default:
                     msg_Warn( p_demux,
                               "seems to have lost position @%"PRIu64", resync",
                               vlc_stream_Tell(p_demux->s) );
-                    if( AVI_PacketSearch( p_demux ) )
+                    if( AVI_PacketSearch( p_demux, p_demux->s ) )
                     {
                         msg_Err( p_demux, "resync failed" );
                         return VLC_DEMUXER_EGENERIC;
@@ -1447,7 +1457,7 @@ static int Demux_UnSeekable( demux_t *p_demux )
             }
             else
             {
-                if( AVI_PacketNext( p_demux ) )
+                if( AVI_PacketNext( p_demux->s ) )
                 {
                     return VLC_DEMUXER_EOF;
                 }
@@ -1487,6 +1497,8 @@ static int Seek( demux_t *p_demux, mtime_t i_date, int i_percent )
     {
         int64_t i_pos_backup = vlc_stream_Tell( p_demux->s );
 
+        AVI_IndexMerge( p_demux );
+
         /* Check and lazy load indexes if it was not done (not fastseekable) */
         if ( !p_sys->b_indexloaded && ( p_sys->i_avih_flags & AVIF_HASINDEX ) )
         {
@@ -1814,7 +1826,7 @@ static int AVI_StreamChunkFind( demux_t *p_demux, unsigned int i_stream )
     if( p_sys->i_movi_lastchunk_pos >= p_sys->i_movi_begin + 12 )
     {
         vlc_stream_Seek( p_demux->s, p_sys->i_movi_lastchunk_pos );
-        if( AVI_PacketNext( p_demux ) )
+        if( AVI_PacketNext( p_demux->s ) )
         {
             return VLC_EGENERIC;
         }
@@ -1826,7 +1838,7 @@ static int AVI_StreamChunkFind( demux_t *p_demux, unsigned int i_stream )
 
     for( ;; )
     {
-        if( AVI_PacketGetHeader( p_demux, &avi_pk ) )
+        if( AVI_PacketGetHeader( p_demux->s, &avi_pk ) )
         {
             msg_Warn( p_demux, "cannot get packet header" );
             return VLC_EGENERIC;
@@ -1834,7 +1846,7 @@ static int AVI_StreamChunkFind( demux_t *p_demux, unsigned int i_stream )
         if( avi_pk.i_stream >= p_sys->i_track ||
             ( avi_pk.i_cat != AUDIO_ES && avi_pk.i_cat != VIDEO_ES ) )
         {
-            if( AVI_PacketNext( p_demux ) )
+            if( AVI_PacketNext( p_demux->s ) )
             {
                 return VLC_EGENERIC;
             }
@@ -1868,7 +1880,7 @@ static int AVI_StreamChunkFind( demux_t *p_demux, unsigned int i_stream )
                 return VLC_SUCCESS;
             }
 
-            if( AVI_PacketNext( p_demux ) )
+            if( AVI_PacketNext( p_demux->s ) )
             {
                 return VLC_EGENERIC;
             }
@@ -2166,17 +2178,17 @@ static void AVI_ParseStreamHeader( vlc_fourcc_t i_id,
 /****************************************************************************
  *
  ****************************************************************************/
-static int AVI_PacketGetHeader( demux_t *p_demux, avi_packet_t *p_pk )
+static int AVI_PacketGetHeader( stream_t *s, avi_packet_t *p_pk )
 {
     const uint8_t *p_peek;
 
-    if( vlc_stream_Peek( p_demux->s, &p_peek, 16 ) < 16 )
+    if( vlc_stream_Peek( s, &p_peek, 16 ) < 16 )
     {
         return VLC_EGENERIC;
     }
     p_pk->i_fourcc  = VLC_FOURCC( p_peek[0], p_peek[1], p_peek[2], p_peek[3] );
     p_pk->i_size    = GetDWLE( p_peek + 4 );
-    p_pk->i_pos     = vlc_stream_Tell( p_demux->s );
+    p_pk->i_pos     = vlc_stream_Tell( s );
     if( p_pk->i_fourcc == AVIFOURCC_LIST || p_pk->i_fourcc == AVIFOURCC_RIFF )
     {
         p_pk->i_type = VLC_FOURCC( p_peek[8],  p_peek[9],
@@ -2193,12 +2205,12 @@ static int AVI_PacketGetHeader( demux_t *p_demux, avi_packet_t *p_pk )
     return VLC_SUCCESS;
 }
 
-static int AVI_PacketNext( demux_t *p_demux )
+static int AVI_PacketNext( stream_t *s )
 {
     avi_packet_t    avi_ck;
     int             i_skip = 0;
 
-    if( AVI_PacketGetHeader( p_demux, &avi_ck ) )
+    if( AVI_PacketGetHeader( s, &avi_ck ) )
     {
         return VLC_EGENERIC;
     }
@@ -2218,14 +2230,14 @@ static int AVI_PacketNext( demux_t *p_demux )
         i_skip = __EVEN( avi_ck.i_size ) + 8;
     }
 
-    if( vlc_stream_Read( p_demux->s, NULL, i_skip ) != i_skip )
+    if( vlc_stream_Read( s, NULL, i_skip ) != i_skip )
     {
         return VLC_EGENERIC;
     }
     return VLC_SUCCESS;
 }
 
-static int AVI_PacketSearch( demux_t *p_demux )
+static int AVI_PacketSearch( demux_t *p_demux, stream_t *s )
 {
     demux_sys_t     *p_sys = p_demux->p_sys;
     avi_packet_t    avi_pk;
@@ -2233,11 +2245,11 @@ static int AVI_PacketSearch( demux_t *p_demux )
 
     for( ;; )
     {
-        if( vlc_stream_Read( p_demux->s, NULL, 1 ) != 1 )
+        if( vlc_killed() || vlc_stream_Read( s, NULL, 1 ) != 1 )
         {
             return VLC_EGENERIC;
         }
-        AVI_PacketGetHeader( p_demux, &avi_pk );
+        AVI_PacketGetHeader( s, &avi_pk );
         if( avi_pk.i_stream < p_sys->i_track &&
             ( avi_pk.i_cat == AUDIO_ES || avi_pk.i_cat == VIDEO_ES ) )
         {
@@ -2586,41 +2598,135 @@ static void AVI_IndexLoad( demux_t *p_demux )
     }
 }
 
-static void AVI_IndexCreate( demux_t *p_demux )
+/* The index is rebuilt by scanning the movi list, either when opening, or
+ * in the background through another stream while playing */
+struct avi_indexer_t
 {
-    demux_sys_t *p_sys = p_demux->p_sys;
-
-    avi_chunk_list_t *p_riff;
-    avi_chunk_list_t *p_movi;
+    demux_t         *p_demux;
+    stream_t        *s;
+    vlc_thread_t    thread;
+    vlc_interrupt_t *p_interrupt;   /* NULL when scanning synchronously */
+    bool            b_merged;       /* demux thread only */
+
+    off_t           i_movi_begin;
+    off_t           i_movi_end;
+    off_t           i_riffx_pos;    /* where to go on at idx1, or -1 */
+    char            *psz_cache;     /* where to save the index, or NULL */
+
+    vlc_mutex_t     lock;
+    bool            b_done;
+    off_t           i_last_pos;
+    avi_index_t     idx[];          /* one per track */
+};
 
-    unsigned int i_stream;
-    off_t i_movi_end;
+static char *AVI_IndexCachePath( demux_t *p_demux )
+{
+    const char *psz_url = p_demux->s->psz_url;
+    if( psz_url == NULL || !var_InheritBool( p_demux, "avi-index-cache" ) )
+        return NULL;
+
+    char *psz_dir = config_GetUserDir( VLC_CACHE_DIR );
+    if( psz_dir == NULL )
+        return NULL;
+
+    struct md5_s md5;
+    InitMD5( &md5 );
+    AddMD5( &md5, psz_url, strlen( psz_url ) );
+    EndMD5( &md5 );
+
+    char *psz_hash = psz_md5_hash( &md5 );
+    char *psz_path;
+    if( psz_hash == NULL ||
+        asprintf( &psz_path, "%s"DIR_SEP"avi"DIR_SEP"%s-%"PRIx64".idx",
+                  psz_dir, psz_hash,
+                  (uint64_t)stream_Size( p_demux->s ) ) == -1 )
+        psz_path = NULL;
+
+    free( psz_hash );
+    free( psz_dir );
+    return psz_path;
+}
 
-    mtime_t i_dialog_update;
-    vlc_dialog_id *p_dialog_id = NULL;
+static avi_indexer_t *AVI_IndexerNew( demux_t *p_demux, stream_t *s )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
 
-    p_riff = AVI_ChunkFind( &p_sys->ck_root, AVIFOURCC_RIFF, 0);
-    p_movi = AVI_ChunkFind( p_riff, AVIFOURCC_movi, 0);
+    avi_chunk_list_t *p_riff = AVI_ChunkFind( &p_sys->ck_root, AVIFOURCC_RIFF, 0);
+    avi_chunk_list_t *p_movi = AVI_ChunkFind( p_riff, AVIFOURCC_movi, 0);
 
     if( !p_movi )
     {
         msg_Err( p_demux, "cannot find p_movi" );
-        return;
+        return NULL;
     }
 
-    for( i_stream = 0; i_stream < p_sys->i_track; i_stream++ )
-        avi_index_Init( &p_sys->track[i_stream]->idx );
+    avi_indexer_t *p_ix = malloc( sizeof( *p_ix ) +
+                                  p_sys->i_track * sizeof( *p_ix->idx ) );
+    if( unlikely( p_ix == NULL ) )
+        return NULL;
+
+    p_ix->p_demux = p_demux;
+    p_ix->s = s;
+    p_ix->p_interrupt = NULL;
+    p_ix->b_merged = false;
+
+    /* The chunks tree is not to be read while indexing in the background */
+    p_ix->i_movi_begin = p_movi->i_chunk_pos + 12;
+    p_ix->i_movi_end = __MIN( (off_t)(p_movi->i_chunk_pos + p_movi->i_chunk_size),
+                              stream_Size( s ) );
+    p_ix->i_riffx_pos = -1;
+    if( p_sys->b_odml )
+    {
+        avi_chunk_list_t *p_sysx = AVI_ChunkFind( &p_sys->ck_root,
+                                                  AVIFOURCC_RIFF, 1 );
+        if( p_sysx )
+            p_ix->i_riffx_pos = p_sysx->i_chunk_pos + 24;
+    }
+    p_ix->psz_cache = AVI_IndexCachePath( p_demux );
+
+    vlc_mutex_init( &p_ix->lock );
+    p_ix->b_done = false;
+    p_ix->i_last_pos = 0;
+    for( unsigned i = 0; i < p_sys->i_track; i++ )
+        avi_index_Init( &p_ix->idx[i] );
+
+    return p_ix;
+}
+
+static void AVI_IndexerDelete( avi_indexer_t *p_ix )
+{
+    demux_sys_t *p_sys = p_ix->p_demux->p_sys;
+
+    for( unsigned i = 0; i < p_sys->i_track; i++ )
+        avi_index_Clean( &p_ix->idx[i] );
+    vlc_mutex_destroy( &p_ix->lock );
+    free( p_ix->psz_cache );
+    if( p_ix->p_interrupt )
+        vlc_interrupt_destroy( p_ix->p_interrupt );
+    if( p_ix->s != p_ix->p_demux->s )
+        vlc_stream_Delete( p_ix->s );
+    free( p_ix );
+}
+
+/* Returns VLC_SUCCESS if the whole movi list was scanned */
+static int AVI_IndexScan( avi_indexer_t *p_ix )
+{
+    demux_t     *p_demux = p_ix->p_demux;
+    demux_sys_t *p_sys = p_demux->p_sys;
+    stream_t    *s = p_ix->s;
+    int         i_ret = VLC_SUCCESS;
 
-    i_movi_end = __MIN( (off_t)(p_movi->i_chunk_pos + p_movi->i_chunk_size),
-                        stream_Size( p_demux->s ) );
+    mtime_t i_dialog_update;
+    vlc_dialog_id *p_dialog_id = NULL;
 
-    vlc_stream_Seek( p_demux->s, p_movi->i_chunk_pos + 12 );
+    vlc_stream_Seek( s, p_ix->i_movi_begin );
     msg_Warn( p_demux, "creating index from LIST-movi, will take time !" );
 
 
-    /* Only show dialog if AVI is > 10MB */
+    /* Only show dialog if AVI is > 10MB, and not when indexing in the
+     * background */
     i_dialog_update = mdate();
-    if( stream_Size( p_demux->s ) > 10000000 )
+    if( p_ix->p_interrupt == NULL && stream_Size( s ) > 10000000 )
     {
         p_dialog_id =
             vlc_dialog_display_progress( p_demux, false, 0.0, _("Cancel"),
@@ -2632,21 +2738,30 @@ static void AVI_IndexCreate( demux_t *p_demux )
     {
         avi_packet_t pk;
 
+        if( vlc_killed() )
+        {
+            i_ret = VLC_EGENERIC;
+            break;
+        }
+
         /* Don't update/check dialog too often */
         if( p_dialog_id != NULL && mdate() - i_dialog_update > 100000 )
         {
             if( vlc_dialog_is_cancelled( p_demux, p_dialog_id ) )
+            {
+                i_ret = VLC_EGENERIC;
                 break;
+            }
 
-            double f_current = vlc_stream_Tell( p_demux->s );
-            double f_size    = stream_Size( p_demux->s );
+            double f_current = vlc_stream_Tell( s );
+            double f_size    = stream_Size( s );
             double f_pos     = f_current / f_size;
             vlc_dialog_update_progress( p_demux, p_dialog_id, f_pos );
 
             i_dialog_update = mdate();
         }
 
-        if( AVI_PacketGetHeader( p_demux, &pk ) )
+        if( AVI_PacketGetHeader( s, &pk ) )
             break;
 
         if( pk.i_stream < p_sys->i_track &&
@@ -2660,7 +2775,10 @@ static void AVI_IndexCreate( demux_t *p_demux )
             index.i_pos     = pk.i_pos;
             index.i_length  = pk.i_size;
             index.i_lengthtotal = pk.i_size;
-            avi_index_Append( &tk->idx, &p_sys->i_movi_lastchunk_pos, &index );
+
+            vlc_mutex_lock( &p_ix->lock );
+            avi_index_Append( &p_ix->idx[pk.i_stream], &p_ix->i_last_pos, &index );
+            vlc_mutex_unlock( &p_ix->lock );
         }
         else
         {
@@ -2669,13 +2787,9 @@ static void AVI_IndexCreate( demux_t *p_demux )
             case AVIFOURCC_idx1:
                 if( p_sys->b_odml )
                 {
-                    avi_chunk_list_t *p_sysx;
-                    p_sysx = AVI_ChunkFind( &p_sys->ck_root,
-                                            AVIFOURCC_RIFF, 1 );
-
                     msg_Dbg( p_demux, "looking for new RIFF chunk" );
-                    if( vlc_stream_Seek( p_demux->s,
-                                         p_sysx->i_chunk_pos + 24 ) )
+                    if( p_ix->i_riffx_pos < 0 ||
+                        vlc_stream_Seek( s, p_ix->i_riffx_pos ) )
                         goto print_stat;
                     break;
                 }
@@ -2691,7 +2805,7 @@ static void AVI_IndexCreate( demux_t *p_demux )
 
             default:
                 msg_Warn( p_demux, "need resync, probably broken avi" );
-                if( AVI_PacketSearch( p_demux ) )
+                if( AVI_PacketSearch( p_demux, s ) )
                 {
                     msg_Warn( p_demux, "lost sync, abord index creation" );
                     goto print_stat;
@@ -2699,8 +2813,8 @@ static void AVI_IndexCreate( demux_t *p_demux )
             }
         }
 
-        if( ( !p_sys->b_odml && pk.i_pos + pk.i_size >= i_movi_end ) ||
-            AVI_PacketNext( p_demux ) )
+        if( ( !p_sys->b_odml && pk.i_pos + pk.i_size >= p_ix->i_movi_end ) ||
+            AVI_PacketNext( s ) )
         {
             break;
         }
@@ -2710,10 +2824,388 @@ print_stat:
     if( p_dialog_id != NULL )
         vlc_dialog_release( p_demux, p_dialog_id );
 
-    for( i_stream = 0; i_stream < p_sys->i_track; i_stream++ )
+    for( unsigned i = 0; i < p_sys->i_track; i++ )
+    {
+        msg_Dbg( p_demux, "stream[%u] creating %u index entries",
+                 i, p_ix->idx[i].i_size );
+    }
+    return i_ret;
+}
+
+/* Creates the missing parent directories of the cache file */
+static void AVI_IndexCacheCreateDir( const char *psz_path )
+{
+    char psz_dir[strlen( psz_path ) + 1];
+    strcpy( psz_dir, psz_path );
+
+    for( char *psz = strchr( psz_dir + 1, DIR_SEP_CHAR ); psz != NULL;
+         psz = strchr( psz + 1, DIR_SEP_CHAR ) )
+    {
+        *psz = '\0';
+        vlc_mkdir( psz_dir, 0700 );
+        *psz = DIR_SEP_CHAR;
+    }
+}
+
+static void AVI_IndexCacheSave( avi_indexer_t *p_ix )
+{
+    demux_t     *p_demux = p_ix->p_demux;
+    demux_sys_t *p_sys = p_demux->p_sys;
+    char *psz_tmp;
+
+    AVI_IndexCacheCreateDir( p_ix->psz_cache );
+
+    if( asprintf( &psz_tmp, "%s.tmp", p_ix->psz_cache ) == -1 )
+        return;
+
+    FILE *f = vlc_fopen( psz_tmp, "wt" );
+    bool b_ok = false;
+    if( f != NULL )
+    {
+        fprintf( f, "vlc-avi-index %d %"PRIu64" %"PRIu64"\n", 1,
+                 (uint64_t)p_ix->i_movi_begin, (uint64_t)stream_Size( p_ix->s ) );
+        for( unsigned i = 0; i < p_sys->i_track; i++ )
+        {
+            const avi_index_t *p_index = &p_ix->idx[i];
+
+            fprintf( f, "t %u %u\n", i, p_index->i_size );
+            for( unsigned j = 0; j < p_index->i_size; j++ )
+                fprintf( f, "%"PRIu32" %"PRIu32" %"PRIu64" %"PRIu32"\n",
+                         p_index->p_entry[j].i_id, p_index->p_entry[j].i_flags,
+                         (uint64_t)p_index->p_entry[j].i_pos,
+                         p_index->p_entry[j].i_length );
+        }
+        b_ok = !ferror( f );
+        b_ok = fclose( f ) == 0 && b_ok;
+    }
+
+    if( !b_ok || vlc_rename( psz_tmp, p_ix->psz_cache ) )
     {
-        msg_Dbg( p_demux, "stream[%d] creating %d index entries",
-                i_stream, p_sys->track[i_stream]->idx.i_size );
+        msg_Warn( p_demux, "cannot write the index %s", p_ix->psz_cache );
+        vlc_unlink( psz_tmp );
+    }
+    else
+        msg_Dbg( p_demux, "saved the index %s", p_ix->psz_cache );
+    free( psz_tmp );
+}
+
+/* Loads the index rebuilt when the file was last opened */
+static int AVI_IndexCacheLoad( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    char *psz_path = AVI_IndexCachePath( p_demux );
+    if( psz_path == NULL )
+        return VLC_EGENERIC;
+
+    FILE *f = vlc_fopen( psz_path, "rt" );
+    if( f == NULL )
+    {
+        free( psz_path );
+        return VLC_EGENERIC;
+    }
+
+    avi_chunk_list_t *p_riff = AVI_ChunkFind( &p_sys->ck_root, AVIFOURCC_RIFF, 0);
+    avi_chunk_list_t *p_movi = AVI_ChunkFind( p_riff, AVIFOURCC_movi, 0);
+
+    int i_version;
+    uint64_t i_movi_begin, i_size;
+    bool b_ok = p_movi != NULL &&
+        fscanf( f, "vlc-avi-index %d %"SCNu64" %"SCNu64,
+                &i_version, &i_movi_begin, &i_size ) == 3 &&
+        i_version == 1 && i_movi_begin == p_movi->i_chunk_pos + 12 &&
+        i_size == (uint64_t)stream_Size( p_demux->s );
+
+    avi_index_t *idx = calloc( p_sys->i_track, sizeof(*idx) );
+    off_t i_last_pos = 0;
+    if( unlikely( idx == NULL ) )
+    {
+        fclose( f );
+        free( psz_path );
+        return VLC_EGENERIC;
+    }
+    for( unsigned i = 0; i < p_sys->i_track; i++ )
+        avi_index_Init( &idx[i] );
+
+    for( unsigned i = 0; b_ok && i < p_sys->i_track; i++ )
+    {
+        unsigned i_track, i_count;
+
+        b_ok = fscanf( f, " t %u %u", &i_track, &i_count ) == 2 &&
+               i_track == i;
+        for( unsigned j = 0; b_ok && j < i_count; j++ )
+        {
+            avi_entry_t index;
+            uint64_t i_pos;
+
+            b_ok = fscanf( f, "%"SCNu32" %"SCNu32" %"SCNu64" %"SCNu32,
+                           &index.i_id, &index.i_flags, &i_pos,
+                           &index.i_length ) == 4 && i_pos < i_size;
+            if( b_ok )
+            {
+                index.i_pos = i_pos;
+                avi_index_Append( &idx[i], &i_last_pos, &index );
+                b_ok = idx[i].p_entry != NULL;
+            }
+        }
+    }
+    fclose( f );
+
+    /* The file may have been rewritten in place, check the last chunks */
+    for( unsigned i = 0; b_ok && i < p_sys->i_track; i++ )
+    {
+        avi_packet_t pk;
+
+        if( idx[i].i_size == 0 )
+            continue;
+
+        const avi_entry_t *p_last = &idx[i].p_entry[idx[i].i_size - 1];
+        b_ok = !vlc_stream_Seek( p_demux->s, p_last->i_pos ) &&
+               !AVI_PacketGetHeader( p_demux->s, &pk ) &&
+               pk.i_fourcc == p_last->i_id && pk.i_size == p_last->i_length;
+    }
+
+    if( !b_ok )
+    {
+        msg_Warn( p_demux, "invalid index %s", psz_path );
+        for( unsigned i = 0; i < p_sys->i_track; i++ )
+            avi_index_Clean( &idx[i] );
+        free( idx );
+        free( psz_path );
+        return VLC_EGENERIC;
+    }
+
+    for( unsigned i = 0; i < p_sys->i_track; i++ )
+    {
+        avi_index_Clean( &p_sys->track[i]->idx );
+        p_sys->track[i]->idx = idx[i];
+    }
+    free( idx );
+    p_sys->i_movi_lastchunk_pos = i_last_pos;
+
+    msg_Dbg( p_demux, "loaded the index %s", psz_path );
+    free( psz_path );
+    return VLC_SUCCESS;
+}
+
+static void AVI_IndexCreate( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    avi_indexer_t *p_ix = AVI_IndexerNew( p_demux, p_demux->s );
+    if( p_ix == NULL )
+        return;
+
+    if( AVI_IndexScan( p_ix ) == VLC_SUCCESS && p_ix->psz_cache != NULL )
+        AVI_IndexCacheSave( p_ix );
+
+    for( unsigned i = 0; i < p_sys->i_track; i++ )
+    {
+        avi_index_Clean( &p_sys->track[i]->idx );
+        p_sys->track[i]->idx = p_ix->idx[i];
+        avi_index_Init( &p_ix->idx[i] );
+    }
+    p_sys->i_movi_lastchunk_pos = __MAX( p_sys->i_movi_lastchunk_pos,
+                                         p_ix->i_last_pos );
+    AVI_IndexerDelete( p_ix );
+}
+
+static void *AVI_IndexThread( void *data )
+{
+    avi_indexer_t *p_ix = data;
+    mtime_t i_start = mdate();
+
+    vlc_interrupt_set( p_ix->p_interrupt );
+
+    bool b_complete = AVI_IndexScan( p_ix ) == VLC_SUCCESS;
+
+    vlc_mutex_lock( &p_ix->lock );
+    p_ix->b_done = true;
+    vlc_mutex_unlock( &p_ix->lock );
+
+    msg_Dbg( p_ix->p_demux, "index %s in %"PRId64" ms",
+             b_complete ? "built" : "interrupted", ( mdate() - i_start ) / 1000 );
+
+    /* Only the demux thread reads the entries now */
+    if( b_complete && p_ix->psz_cache != NULL )
+        AVI_IndexCacheSave( p_ix );
+    return NULL;
+}
+
+/* Rebuilds the index while playing, the entries found are taken by
+ * AVI_IndexMerge() */
+static int AVI_IndexStart( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    if( p_demux->s->psz_url == NULL )
+        return VLC_EGENERIC;
+
+    /* Use another stream, not to disturb the playback */
+    stream_t *s = vlc_stream_NewMRL( p_demux, p_demux->s->psz_url );
+    if( s == NULL )
+        return VLC_EGENERIC;
+
+    avi_indexer_t *p_ix = AVI_IndexerNew( p_demux, s );
+    if( p_ix == NULL )
+    {
+        vlc_stream_Delete( s );
+        return VLC_EGENERIC;
+    }
+
+    p_ix->p_interrupt = vlc_interrupt_create();
+    if( unlikely( p_ix->p_interrupt == NULL ) ||
+        vlc_clone( &p_ix->thread, AVI_IndexThread, p_ix,
+                   VLC_THREAD_PRIORITY_LOW ) )
+    {
+        AVI_IndexerDelete( p_ix );
+        return VLC_EGENERIC;
+    }
+
+    msg_Dbg( p_demux, "creating index in the background" );
+    p_sys->p_indexer = p_ix;
+    return VLC_SUCCESS;
+}
+
+static void AVI_IndexStop( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    avi_indexer_t *p_ix = p_sys->p_indexer;
+
+    if( p_ix == NULL )
+        return;
+
+    vlc_interrupt_kill( p_ix->p_interrupt );
+    vlc_join( p_ix->thread, NULL );
+    AVI_IndexerDelete( p_ix );
+    p_sys->p_indexer = NULL;
+}
+
+/* Appends the entries found by the background indexer to the tracks */
+static void AVI_IndexMerge( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    avi_indexer_t *p_ix = p_sys->p_indexer;
+
+    if( p_ix == NULL || p_ix->b_merged )
+        return;
+
+    vlc_mutex_lock( &p_ix->lock );
+    for( unsigned i = 0; i < p_sys->i_track; i++ )
+    {
+        avi_track_t *tk = p_sys->track[i];
+        const avi_index_t *p_index = &p_ix->idx[i];
+        unsigned i_from = tk->idx.i_size;
+
+        /* The playback may have indexed further already */
+        if( p_index->i_size <= i_from )
+            continue;
+
+        off_t i_pos = -1;
+        if( i_from > 0 && p_index->p_entry[i_from - 1].i_pos !=
+                          tk->idx.p_entry[i_from - 1].i_pos )
+        {
+            /* The loaded index disagrees, replace it and find the current
+             * chunk again */
+            i_pos = tk->i_idxposc < tk->idx.i_size
+                  ? tk->idx.p_entry[tk->i_idxposc].i_pos
+                  : tk->idx.p_entry[i_from - 1].i_pos + 1;
+            msg_Warn( p_demux, "stream[%u] index replaced", i );
+            tk->idx.i_size = i_from = 0;
+        }
+
+        for( unsigned j = i_from; j < p_index->i_size; j++ )
+        {
+            avi_entry_t index = p_index->p_entry[j];
+            avi_index_Append( &tk->idx, &p_sys->i_movi_lastchunk_pos, &index );
+        }
+
+        if( i_pos >= 0 )
+        {
+            tk->i_idxposc = 0;
+            tk->i_idxposb = 0;
+            while( tk->i_idxposc < tk->idx.i_size &&
+                   tk->idx.p_entry[tk->i_idxposc].i_pos < i_pos )
+                tk->i_idxposc++;
+        }
+    }
+    p_sys->i_movi_lastchunk_pos = __MAX( p_sys->i_movi_lastchunk_pos,
+                                         p_ix->i_last_pos );
+    const bool b_done = p_ix->b_done;
+    vlc_mutex_unlock( &p_ix->lock );
+
+    if( b_done )
+    {
+        p_ix->b_merged = true;
+        p_sys->i_length = AVI_MovieGetLength( p_demux );
+        msg_Dbg( p_demux, "background index merged, length %"PRId64" s",
+                 p_sys->i_length );
+    }
+}
+
+/* Tells if the audio rate of the track is to be guessed from its length */
+static bool AVI_MediaKitTrack( demux_t *p_demux, avi_chunk_list_t *p_hdrl,
+                               unsigned i )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    avi_track_t *tk = p_sys->track[i];
+
+    if( tk->i_cat != AUDIO_ES || tk->i_scale != 1 || tk->i_samplesize != 0 )
+        return false;
+
+    avi_chunk_list_t *p_strl = AVI_ChunkFind( p_hdrl, AVIFOURCC_strl, i );
+    avi_chunk_strf_auds_t *p_auds = AVI_ChunkFind( p_strl, AVIFOURCC_strf, 0 );
+
+    return p_auds->p_wf->wFormatTag != WAVE_FORMAT_PCM &&
+           tk->i_rate == p_auds->p_wf->nSamplesPerSec;
+}
+
+/* The rate of the MediaKit audio tracks needs the complete index before
+ * their ES are created, so those files are indexed up front */
+static bool AVI_IndexInBackground( demux_t *p_demux, avi_chunk_list_t *p_hdrl )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    if( !var_InheritBool( p_demux, "avi-background-index" ) )
+        return false;
+    for( unsigned i = 0; i < p_sys->i_track; i++ )
+        if( AVI_MediaKitTrack( p_demux, p_hdrl, i ) )
+            return false;
+    return true;
+}
+
+/* Guesses the rate of the audio tracks of some BeOS MediaKit generated files
+ * from their length */
+static void AVI_MediaKitFix( demux_t *p_demux, avi_chunk_list_t *p_hdrl,
+                             avi_chunk_avih_t *p_avih )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    for( unsigned i = 0 ; i < p_sys->i_track; i++ )
+    {
+        avi_track_t         *tk = p_sys->track[i];
+
+        if( tk->idx.i_size < 1 || !AVI_MediaKitTrack( p_demux, p_hdrl, i ) )
+        {
+            continue;
+        }
+
+        {
+            int64_t i_track_length =
+                tk->idx.p_entry[tk->idx.i_size-1].i_length +
+                tk->idx.p_entry[tk->idx.i_size-1].i_lengthtotal;
+            mtime_t i_length = (mtime_t)p_avih->i_totalframes *
+                               (mtime_t)p_avih->i_microsecperframe;
+
+            if( i_length == 0 )
+            {
+                msg_Warn( p_demux, "track[%d] cannot be fixed (BeOS MediaKit generated)", i );
+                continue;
+            }
+            tk->i_samplesize = 1;
+            tk->i_rate       = i_track_length  * CLOCK_FREQ / i_length;
+            msg_Warn( p_demux, "track[%d] fixed with rate=%d scale=%d (BeOS MediaKit generated)", i, tk->i_rate, tk->i_scale );
+        }
     }
 }
 
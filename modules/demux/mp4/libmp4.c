@@ -205,6 +205,34 @@ static int MP4_PeekBoxHeader( stream_t *p_stream, MP4_Box_t *p_box )
  * if p_box == NULL, box is invalid or failed, position undefined
  * on success, position is past read box or EOF
  *****************************************************************************/
+/* Sample tables are read on demand if the tree is lazy, see MP4_BoxLoad */
+static bool MP4_BoxIsOnDemand( const MP4_Box_t *p_box )
+{
+    const MP4_Box_t *p_root = p_box->p_father;
+
+    if( !p_root || p_root->i_type != ATOM_stbl )
+        return false;
+
+    switch( p_box->i_type )
+    {
+        case ATOM_stts:
+        case ATOM_ctts:
+        case ATOM_stsz:
+        case ATOM_stco:
+        case ATOM_co64:
+        case ATOM_stss:
+        case ATOM_stsh:
+        case ATOM_sdtp:
+            break;
+        default:
+            return false;
+    }
+
+    while( p_root->p_father )
+        p_root = p_root->p_father;
+    return p_root->i_type == ATOM_root && p_root->e_flags == BOX_FLAG_LAZY;
+}
+
 static MP4_Box_t *MP4_ReadBoxRestricted( stream_t *p_stream, MP4_Box_t *p_father,
                                          const uint32_t onlytypes[], const uint32_t nottypes[],
                                          bool *pb_restrictionhit )
@@ -260,6 +288,8 @@ static MP4_Box_t *MP4_ReadBoxRestricted( stream_t *p_stream, MP4_Box_t *p_father
 
     const uint64_t i_next = p_box->i_pos + p_box->i_size;
     p_box->p_father = p_father;
+    if( MP4_BoxIsOnDemand( p_box ) )
+        p_box->e_flags = BOX_FLAG_LAZY;
     if( MP4_Box_Read_Specific( p_stream, p_box, p_father ) != VLC_SUCCESS )
     {
         msg_Warn( p_stream, "Failed reading box %4.4s", (char*) &peekbox.i_type );
@@ -2538,14 +2568,23 @@ static void MP4_FreeBox_stsz( MP4_Box_t *p_box )
 
 static int MP4_ReadBox_stsz( stream_t *p_stream, MP4_Box_t *p_box )
 {
-    MP4_READBOX_ENTER( MP4_Box_data_stsz_t, MP4_FreeBox_stsz );
+    /* The sample count and size are always needed: only read the table of
+     * sizes on demand */
+    const uint64_t i_maxread = p_box->e_flags == BOX_FLAG_LAZY ?
+                               mp4_box_headersize( p_box ) + 12 : UINT64_MAX;
+    MP4_READBOX_ENTER_PARTIAL( MP4_Box_data_stsz_t, i_maxread, MP4_FreeBox_stsz );
 
     MP4_GETVERSIONFLAGS( p_box->data.p_stsz );
 
     MP4_GET4BYTES( p_box->data.p_stsz->i_sample_size );
     MP4_GET4BYTES( p_box->data.p_stsz->i_sample_count );
 
-    if( p_box->data.p_stsz->i_sample_size == 0 )
+    if( p_box->data.p_stsz->i_sample_size == 0 &&
+        p_box->e_flags == BOX_FLAG_LAZY )
+    {
+        p_box->data.p_stsz->i_entry_size = NULL;
+    }
+    else if( p_box->data.p_stsz->i_sample_size == 0 )
     {
         p_box->data.p_stsz->i_entry_size =
             calloc( p_box->data.p_stsz->i_sample_count, sizeof(uint32_t) );
@@ -2558,7 +2597,10 @@ static int MP4_ReadBox_stsz( stream_t *p_stream, MP4_Box_t *p_box )
         }
     }
     else
+    {
         p_box->data.p_stsz->i_entry_size = NULL;
+        p_box->e_flags = BOX_FLAG_NONE; /* nothing left to read */
+    }
 
 #ifdef MP4_VERBOSE
     msg_Dbg( p_stream, "read box: \"stsz\" sample-size %d sample-count %d",
@@ -4397,6 +4439,10 @@ static int MP4_Box_Read_Specific( stream_t *p_stream, MP4_Box_t *p_box, MP4_Box_
 {
     int i_index;
 
+    /* Only the extent of on demand boxes is recorded */
+    if( p_box->e_flags == BOX_FLAG_LAZY && p_box->i_type != ATOM_stsz )
+        return VLC_SUCCESS;
+
     for( i_index = 0; ; i_index++ )
     {
         if ( MP4_Box_Function[i_index].i_parent &&
@@ -4551,7 +4597,7 @@ MP4_Box_t *MP4_BoxGetNextChunk( stream_t *s )
  *  The first box is a virtual box "root" and is the father for all first
  *  level boxes for the file, a sort of virtual contener
  *****************************************************************************/
-MP4_Box_t *MP4_BoxGetRoot( stream_t *p_stream )
+static MP4_Box_t *MP4_BoxGetRootInternal( stream_t *p_stream, bool b_lazy )
 {
     int i_result;
 
@@ -4560,6 +4606,8 @@ MP4_Box_t *MP4_BoxGetRoot( stream_t *p_stream )
         return NULL;
 
     p_vroot->i_shortsize = 1;
+    if( b_lazy )
+        p_vroot->e_flags = BOX_FLAG_LAZY;
     int64_t i_size = stream_Size( p_stream );
     if( i_size > 0 )
         p_vroot->i_size = i_size;
@@ -4638,6 +4686,51 @@ error:
     return NULL;
 }
 
+MP4_Box_t *MP4_BoxGetRoot( stream_t *p_stream )
+{
+    return MP4_BoxGetRootInternal( p_stream, false );
+}
+
+MP4_Box_t *MP4_BoxGetRootLazy( stream_t *p_stream )
+{
+    return MP4_BoxGetRootInternal( p_stream, true );
+}
+
+/*****************************************************************************
+ * MP4_BoxLoad : read the on demand boxes of a lazy tree
+ *****************************************************************************/
+int MP4_BoxLoad( stream_t *p_stream, MP4_Box_t *p_box )
+{
+    int i_ret = VLC_SUCCESS;
+
+    for( MP4_Box_t *p_child = p_box->p_first; p_child; p_child = p_child->p_next )
+    {
+        if( MP4_BoxLoad( p_stream, p_child ) != VLC_SUCCESS )
+            i_ret = VLC_EGENERIC;
+    }
+
+    if( p_box->e_flags != BOX_FLAG_LAZY || !p_box->p_father )
+        return i_ret;
+
+    const uint64_t i_pos = vlc_stream_Tell( p_stream );
+
+    MP4_Box_Clean_Specific( p_box );
+    free( p_box->data.p_payload );
+    p_box->data.p_payload = NULL;
+    p_box->pf_free = NULL;
+    p_box->e_flags = BOX_FLAG_NONE;
+
+    if( MP4_Seek( p_stream, p_box->i_pos ) ||
+        MP4_Box_Read_Specific( p_stream, p_box, p_box->p_father ) != VLC_SUCCESS )
+    {
+        msg_Warn( p_stream, "Failed reading box %4.4s", (char*) &p_box->i_type );
+        i_ret = VLC_EGENERIC;
+    }
+
+    MP4_Seek( p_stream, i_pos );
+    return i_ret;
+}
+
 
 static void MP4_BoxDumpStructure_Internal( stream_t *s, const MP4_Box_t *p_box,
                                            unsigned int i_level )
@@ -1668,6 +1668,7 @@ struct MP4_Box_s
     {
         BOX_FLAG_NONE = 0,
         BOX_FLAG_INCOMPLETE,
+        BOX_FLAG_LAZY, /* not fully read yet, see MP4_BoxLoad */
     }            e_flags;
 
     UUID_t       i_uuid;  /* Set if i_type == "uuid" */
@@ -1817,6 +1818,19 @@ MP4_Box_t *MP4_BoxGetNextChunk( stream_t * );
  *****************************************************************************/
 MP4_Box_t *MP4_BoxGetRoot( stream_t * );
 
+/*****************************************************************************
+ * MP4_BoxGetRootLazy : Same as MP4_BoxGetRoot, but the sample tables are only
+ *                      read by MP4_BoxLoad (the stream has to be seekable)
+ *****************************************************************************/
+MP4_Box_t *MP4_BoxGetRootLazy( stream_t * );
+
+/*****************************************************************************
+ * MP4_BoxLoad : Read the boxes of a lazy tree that are not read yet
+ *****************************************************************************
+ *  p_box and its children are read, the stream position is kept
+ *****************************************************************************/
+int MP4_BoxLoad( stream_t *, MP4_Box_t *p_box );
+
 /*****************************************************************************
  * MP4_BoxNew : Allocates a new MP4 Box with its atom type
  *****************************************************************************
@@ -62,6 +62,10 @@ static int   DemuxAsLeaf( demux_t * );
 static int   Seek    ( demux_t *, mtime_t );
 static int   Control ( demux_t *, int, va_list );
 
+/* Largest read coalescing the samples of the selected tracks */
+#define MP4_READ_WINDOW (256 * 1024)
+#define MP4_READ_WINDOW_STEPS 4096
+
 struct demux_sys_t
 {
     MP4_Box_t    *p_root;      /* container for the whole file */
@@ -94,6 +98,22 @@ struct demux_sys_t
         uint32_t        i_lastseqnumber;
     } context;
 
+    /* Read window, holding the upcoming samples of the selected tracks */
+    struct
+    {
+        uint8_t  *p_buffer;
+        uint64_t  i_pos;
+        size_t    i_size;
+    } window;
+
+    struct
+    {
+        uint64_t  i_read_bytes;
+        uint64_t  i_sample_bytes;
+        unsigned  i_reads;
+        unsigned  i_seeks;
+    } readstats;
+
     /* */
     MP4_Box_t    *p_tref_chap;
 
@@ -111,8 +131,10 @@ struct demux_sys_t
  *****************************************************************************/
 static void MP4_TrackCreate ( demux_t *, mp4_track_t *, MP4_Box_t  *, bool, bool );
 static void MP4_TrackDestroy( demux_t *, mp4_track_t * );
+static int  MP4_TrackCreateIndex( demux_t *, mp4_track_t * );
 
 static block_t * MP4_Block_Read( demux_t *, const mp4_track_t *, int );
+static block_t * MP4_Block_ReadAt( demux_t *, mp4_track_t *, uint64_t, uint32_t );
 static void MP4_Block_Send( demux_t *, mp4_track_t *, block_t * );
 
 static int  MP4_TrackSelect ( demux_t *, mp4_track_t *, mtime_t );
@@ -212,6 +234,21 @@ static es_out_id_t * MP4_AddTrackES( es_out_t *out, mp4_track_t *p_track )
     return p_es;
 }
 
+/* Sample count of a chunk run, the first one being possibly shared */
+static inline uint32_t MP4_ChunkGetDTSRun( const mp4_chunk_t *p_chunk,
+                                           uint32_t i_index )
+{
+    return p_chunk->p_sample_count_dts[i_index] -
+           ( i_index ? 0 : p_chunk->i_skip_dts );
+}
+
+static inline uint32_t MP4_ChunkGetPTSRun( const mp4_chunk_t *p_chunk,
+                                           uint32_t i_index )
+{
+    return p_chunk->p_sample_count_pts[i_index] -
+           ( i_index ? 0 : p_chunk->i_skip_pts );
+}
+
 /* Return time in microsecond of a track */
 static inline int64_t MP4_TrackGetDTS( demux_t *p_demux, mp4_track_t *p_track )
 {
@@ -228,11 +265,11 @@ static inline int64_t MP4_TrackGetDTS( demux_t *p_demux, mp4_track_t *p_track )
 
     while( i_sample > 0 && i_index < p_chunk->i_entries_dts )
     {
-        if( i_sample > p_chunk->p_sample_count_dts[i_index] )
+        const uint32_t i_run = MP4_ChunkGetDTSRun( p_chunk, i_index );
+        if( i_sample > i_run )
         {
-            i_dts += p_chunk->p_sample_count_dts[i_index] *
-                p_chunk->p_sample_delta_dts[i_index];
-            i_sample -= p_chunk->p_sample_count_dts[i_index];
+            i_dts += i_run * p_chunk->p_sample_delta_dts[i_index];
+            i_sample -= i_run;
             i_index++;
         }
         else
@@ -284,14 +321,15 @@ static inline bool MP4_TrackGetPTSDelta( demux_t *p_demux, mp4_track_t *p_track,
 
     for( i_index = 0; i_index < ck->i_entries_pts ; i_index++ )
     {
-        if( i_sample < ck->p_sample_count_pts[i_index] )
+        const uint32_t i_run = MP4_ChunkGetPTSRun( ck, i_index );
+        if( i_sample < i_run )
         {
             *pi_delta = ck->p_sample_offset_pts[i_index] * CLOCK_FREQ /
                         (int64_t)p_track->i_timescale;
             return true;
         }
 
-        i_sample -= ck->p_sample_count_pts[i_index];
+        i_sample -= i_run;
     }
     return false;
 }
@@ -307,8 +345,14 @@ static int LoadInitFrag( demux_t *p_demux )
 {
     demux_sys_t *p_sys = p_demux->p_sys;
 
-    /* Load all boxes ( except raw data ) */
-    if( ( p_sys->p_root = MP4_BoxGetRoot( p_demux->s ) ) == NULL )
+    /* Load all boxes ( except raw data ), and if we can seek back to them,
+     * except the sample tables of the tracks until they are selected */
+    if( p_sys->b_seekable )
+        p_sys->p_root = MP4_BoxGetRootLazy( p_demux->s );
+    else
+        p_sys->p_root = MP4_BoxGetRoot( p_demux->s );
+
+    if( p_sys->p_root == NULL )
     {
         goto LoadInitFragError;
     }
@@ -401,12 +445,9 @@ static block_t * MP4_EIA608_Convert( block_t * p_block )
     return p_newblock;
 }
 
-static block_t * MP4_Block_Read( demux_t *p_demux, const mp4_track_t *p_track, int i_size )
+static block_t * MP4_Block_Convert( demux_t *p_demux, const mp4_track_t *p_track,
+                                    block_t *p_block )
 {
-    block_t *p_block = vlc_stream_Block( p_demux->s, i_size );
-    if ( !p_block )
-        return NULL;
-
     /* might have some encap */
     if( p_track->fmt.i_cat == SPU_ES )
     {
@@ -432,6 +473,176 @@ static block_t * MP4_Block_Read( demux_t *p_demux, const mp4_track_t *p_track, i
     return p_block;
 }
 
+static block_t * MP4_Block_Read( demux_t *p_demux, const mp4_track_t *p_track, int i_size )
+{
+    block_t *p_block = vlc_stream_Block( p_demux->s, i_size );
+    if ( !p_block )
+        return NULL;
+
+    return MP4_Block_Convert( p_demux, p_track, p_block );
+}
+
+/* Returns the end of the upcoming samples of the track that lie, in whole, in
+ * [i_start, i_max), or i_start if there is none */
+static uint64_t MP4_TrackGetWindowEnd( mp4_track_t *p_track,
+                                       uint64_t i_start, uint64_t i_max )
+{
+    uint32_t i_nb_samples;
+    uint64_t i_pos = MP4_TrackGetPos( p_track );
+    uint32_t i_size = MP4_TrackGetReadSize( p_track, &i_nb_samples );
+    unsigned i_steps = MP4_READ_WINDOW_STEPS;
+
+    if( i_pos < i_start || i_pos + i_size > i_max )
+        return i_start;
+    uint64_t i_end = i_pos + i_size;
+
+    for( uint32_t i_chunk = p_track->i_chunk;
+         i_chunk < p_track->i_chunk_count && i_steps > 0; i_chunk++ )
+    {
+        const mp4_chunk_t *p_chunk = &p_track->chunk[i_chunk];
+        uint32_t i_sample = p_track->i_sample;
+
+        if( i_chunk != p_track->i_chunk )
+        {
+            i_sample = p_chunk->i_sample_first;
+            i_pos = p_chunk->i_offset;
+            if( i_pos < i_start || i_pos >= i_max )
+                break;
+        }
+
+        /* Constant sizes have special meanings for some audio, only rely
+         * on the chunk offsets then */
+        if( p_track->i_sample_size != 0 )
+        {
+            i_end = __MAX( i_end, i_pos );
+            i_steps--;
+            continue;
+        }
+
+        for( ; i_sample < p_chunk->i_sample_first + p_chunk->i_sample_count &&
+               i_sample < p_track->i_sample_count && i_steps > 0;
+             i_sample++, i_steps-- )
+        {
+            if( i_pos + p_track->p_sample_size[i_sample] > i_max )
+                return i_end;
+            i_pos += p_track->p_sample_size[i_sample];
+            i_end = __MAX( i_end, i_pos );
+        }
+    }
+
+    return i_end;
+}
+
+/* Returns the end of the window to read for a sample at the given position,
+ * holding the upcoming samples of all the selected tracks. The window starts
+ * from the track lagging behind, so that it does not bounce between tracks
+ * read by dts, unless they are too far apart. */
+static uint64_t MP4_GetReadWindow( demux_sys_t *p_sys, uint64_t i_pos,
+                                   uint32_t i_size, uint64_t *pi_start )
+{
+    uint64_t i_start = i_pos;
+    uint64_t i_end = i_pos + i_size;
+
+    for( unsigned i = 0; i < p_sys->i_tracks; i++ )
+    {
+        mp4_track_t *tk = &p_sys->track[i];
+        if( tk->b_ok && !tk->b_chapters_source && tk->b_selected &&
+            tk->i_sample < tk->i_sample_count )
+            i_start = __MIN( i_start, MP4_TrackGetPos( tk ) );
+    }
+
+    if( i_end - i_start > MP4_READ_WINDOW )
+    {
+        *pi_start = i_pos;
+        return i_end;
+    }
+
+    for( unsigned i = 0; i < p_sys->i_tracks; i++ )
+    {
+        mp4_track_t *tk = &p_sys->track[i];
+        if( tk->b_ok && !tk->b_chapters_source && tk->b_selected &&
+            tk->i_sample < tk->i_sample_count )
+            i_end = __MAX( i_end, MP4_TrackGetWindowEnd( tk, i_start,
+                                                 i_start + MP4_READ_WINDOW ) );
+    }
+
+    *pi_start = i_start;
+    return i_end;
+}
+
+/* Reads a sample at the given position, from the read window if possible */
+static block_t * MP4_Block_ReadAt( demux_t *p_demux, mp4_track_t *p_track,
+                                   uint64_t i_pos, uint32_t i_size )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    block_t *p_block;
+
+    p_sys->readstats.i_sample_bytes += i_size;
+
+    if( p_sys->window.p_buffer == NULL || i_pos < p_sys->window.i_pos ||
+        i_pos + i_size > p_sys->window.i_pos + p_sys->window.i_size )
+    {
+        uint64_t i_start;
+        uint64_t i_end = MP4_GetReadWindow( p_sys, i_pos, i_size, &i_start );
+        bool b_window = i_end - i_start > i_size;
+
+        if( b_window && p_sys->window.p_buffer == NULL )
+        {
+            p_sys->window.p_buffer = malloc( MP4_READ_WINDOW );
+            b_window = p_sys->window.p_buffer != NULL;
+        }
+
+        /* Keep what the new window shares with the previous one */
+        uint64_t i_from = b_window ? i_start : i_pos;
+        size_t i_kept = 0;
+        if( b_window && i_start >= p_sys->window.i_pos &&
+            i_start < p_sys->window.i_pos + p_sys->window.i_size )
+        {
+            i_from = p_sys->window.i_pos + p_sys->window.i_size;
+            i_kept = i_from - i_start;
+            memmove( p_sys->window.p_buffer,
+                     &p_sys->window.p_buffer[i_start - p_sys->window.i_pos],
+                     i_kept );
+        }
+
+        if( vlc_stream_Tell( p_demux->s ) != i_from )
+        {
+            p_sys->readstats.i_seeks++;
+            if( vlc_stream_Seek( p_demux->s, i_from ) )
+                return NULL;
+        }
+
+        p_sys->readstats.i_reads++;
+        if( !b_window )
+        {
+            p_block = vlc_stream_Block( p_demux->s, i_size );
+            if( p_block == NULL )
+                return NULL;
+            p_sys->readstats.i_read_bytes += p_block->i_buffer;
+            return MP4_Block_Convert( p_demux, p_track, p_block );
+        }
+
+        ssize_t i_read = vlc_stream_Read( p_demux->s,
+                                          &p_sys->window.p_buffer[i_kept],
+                                          i_end - i_from );
+        if( i_read < 0 )
+            i_read = 0;
+        p_sys->window.i_pos = i_start;
+        p_sys->window.i_size = i_kept + i_read;
+        p_sys->readstats.i_read_bytes += i_read;
+        if( i_start + p_sys->window.i_size < i_pos + i_size )
+            return NULL;
+    }
+
+    p_block = block_Alloc( i_size );
+    if( p_block == NULL )
+        return NULL;
+    memcpy( p_block->p_buffer,
+            &p_sys->window.p_buffer[i_pos - p_sys->window.i_pos], i_size );
+
+    return MP4_Block_Convert( p_demux, p_track, p_block );
+}
+
 static void MP4_Block_Send( demux_t *p_demux, mp4_track_t *p_track, block_t *p_block )
 {
     if ( p_track->b_chans_reorder )
@@ -605,6 +816,10 @@ static int Open( vlc_object_t * p_this )
             p_sys->b_fragmented = true;
     }
 
+    /* Fragments handling expects the whole moov */
+    if( p_sys->b_fragmented )
+        MP4_BoxLoad( p_demux->s, p_sys->p_root );
+
     if ( !MP4_Fragment_Moov(&p_sys->fragments)->p_moox )
         AddFragment( p_demux, MP4_BoxGet( p_sys->p_root, "/moov" ) );
 
@@ -1116,16 +1331,6 @@ static int Demux( demux_t *p_demux )
         msg_Dbg( p_demux, "Could not select track by data position" );
         goto end;
     }
-    else if ( p_sys->b_seekmode )
-    {
-        if( vlc_stream_Seek( p_demux->s, i_candidate_pos ) )
-        {
-            msg_Warn( p_demux, "track[0x%x] will be disabled (eof?)",
-                      tk->i_track_ID );
-            MP4_TrackUnselect( p_demux, tk );
-            goto end;
-        }
-    }
 
 #if 0
     msg_Dbg( p_demux, "tk(%i)=%"PRId64" mv=%"PRId64" pos=%"PRIu64, tk->i_track_ID,
@@ -1138,30 +1343,13 @@ static int Demux( demux_t *p_demux )
     {
         block_t *p_block;
         int64_t i_delta;
-        uint64_t i_current_pos;
-
-        /* go,go go ! */
-        i_current_pos = vlc_stream_Tell( p_demux->s );
-
-        if( i_current_pos != i_candidate_pos )
-        {
-            if( vlc_stream_Seek( p_demux->s, i_candidate_pos ) )
-            {
-                msg_Warn( p_demux, "track[0x%x] will be disabled (eof?)"
-                          ": Failed to seek to %"PRIu64,
-                          tk->i_track_ID, i_candidate_pos );
-                MP4_TrackUnselect( p_demux, tk );
-                goto end;
-            }
-            i_current_pos = i_candidate_pos;
-        }
 
         /* now read pes */
-        if( !(p_block = MP4_Block_Read( p_demux, tk, i_samplessize )) )
+        if( !(p_block = MP4_Block_ReadAt( p_demux, tk, i_candidate_pos, i_samplessize )) )
         {
             msg_Warn( p_demux, "track[0x%x] will be disabled (eof?)"
                       ": Failed to read %d bytes sample at %"PRIu64,
-                      tk->i_track_ID, i_samplessize, i_current_pos );
+                      tk->i_track_ID, i_samplessize, i_candidate_pos );
             MP4_TrackUnselect( p_demux, tk );
             goto end;
         }
@@ -1241,11 +1429,13 @@ static int Seek( demux_t *p_demux, mtime_t i_date )
     p_sys->i_time = i_date * p_sys->i_timescale / CLOCK_FREQ;
     p_sys->i_pcr  = VLC_TS_INVALID;
 
-    /* Now for each stream try to go to this time */
+    /* Now for each stream try to go to this time, the others will be when
+     * selected */
     for( i_track = 0; i_track < p_sys->i_tracks; i_track++ )
     {
         mp4_track_t *tk = &p_sys->track[i_track];
-        MP4_TrackSeek( p_demux, tk, i_date );
+        if( tk->b_selected )
+            MP4_TrackSeek( p_demux, tk, i_date );
     }
     MP4_UpdateSeekpoint( p_demux );
 
@@ -1786,6 +1976,13 @@ static void Close ( vlc_object_t * p_this )
 
     MP4_Fragments_Clean( &p_sys->fragments );
 
+    if( p_sys->readstats.i_reads )
+        msg_Dbg( p_demux, "read %"PRIu64" bytes in %u reads and %u seeks for "
+                 "%"PRIu64" bytes of samples", p_sys->readstats.i_read_bytes,
+                 p_sys->readstats.i_reads, p_sys->readstats.i_seeks,
+                 p_sys->readstats.i_sample_bytes );
+    free( p_sys->window.p_buffer );
+
     free( p_sys );
 }
 
@@ -1844,6 +2041,9 @@ static void LoadChapterApple( demux_t  *p_demux, mp4_track_t *tk )
 {
     demux_sys_t *p_sys = p_demux->p_sys;
 
+    if( MP4_TrackCreateIndex( p_demux, tk ) )
+        return;
+
     for( tk->i_sample = 0; tk->i_sample < tk->i_sample_count; tk->i_sample++ )
     {
         const int64_t i_dts = MP4_TrackGetDTS( p_demux, tk );
@@ -2048,54 +2248,6 @@ static int TrackCreateChunksIndex( demux_t *p_demux,
     return VLC_SUCCESS;
 }
 
-static int xTTS_CountEntries( demux_t *p_demux, uint32_t *pi_entry /* out */,
-                              const uint32_t i_index,
-                              uint32_t i_index_samples_left,
-                              uint32_t i_sample_count,
-                              const uint32_t *pi_index_sample_count,
-                              const uint32_t i_table_count )
-{
-    uint32_t i_array_offset;
-    while( i_sample_count > 0 )
-    {
-        if ( likely((UINT32_MAX - i_index) >= *pi_entry) )
-            i_array_offset = i_index + *pi_entry;
-        else
-            return VLC_EGENERIC;
-
-        if ( i_array_offset >= i_table_count )
-        {
-            msg_Err( p_demux, "invalid index counting total samples %u %u", i_array_offset,  i_table_count );
-            return VLC_ENOVAR;
-        }
-
-        if ( i_index_samples_left )
-        {
-            if ( i_index_samples_left > i_sample_count )
-            {
-                i_index_samples_left -= i_sample_count;
-                i_sample_count = 0;
-                *pi_entry +=1; /* No samples left, go copy */
-                break;
-            }
-            else
-            {
-                i_sample_count -= i_index_samples_left;
-                i_index_samples_left = 0;
-                *pi_entry += 1;
-                continue;
-            }
-        }
-        else
-        {
-            i_sample_count -= __MIN( i_sample_count, pi_index_sample_count[i_array_offset] );
-            *pi_entry += 1;
-        }
-    }
-
-    return VLC_SUCCESS;
-}
-
 static int TrackCreateSamplesIndex( demux_t *p_demux,
                                     mp4_track_t *p_demux_track )
 {
@@ -2118,28 +2270,17 @@ static int TrackCreateSamplesIndex( demux_t *p_demux,
     }
     stsz = p_box->data.p_stsz;
 
-    /* Use stsz table to create a sample number -> sample size table */
-    p_demux_track->i_sample_count = stsz->i_sample_count;
+    /* Use stsz table to create a sample number -> sample size table, the
+     * sample count and size being already set by MP4_TrackCreate */
     if( stsz->i_sample_size )
     {
         /* 1: all sample have the same size, so no need to construct a table */
-        p_demux_track->i_sample_size = stsz->i_sample_size;
         p_demux_track->p_sample_size = NULL;
     }
     else
     {
         /* 2: each sample can have a different size */
-        p_demux_track->i_sample_size = 0;
-        p_demux_track->p_sample_size =
-            calloc( p_demux_track->i_sample_count, sizeof( uint32_t ) );
-        if( p_demux_track->p_sample_size == NULL )
-            return VLC_ENOMEM;
-
-        for( uint32_t i_sample = 0; i_sample < p_demux_track->i_sample_count; i_sample++ )
-        {
-            p_demux_track->p_sample_size[i_sample] =
-                    stsz->i_entry_size[i_sample];
-        }
+        p_demux_track->p_sample_size = stsz->i_entry_size;
     }
 
     if ( p_demux_track->i_chunk_count )
@@ -2147,9 +2288,9 @@ static int TrackCreateSamplesIndex( demux_t *p_demux,
         mp4_chunk_t *lastchunk = &p_demux_track->chunk[p_demux_track->i_chunk_count - 1];
         uint64_t i_total_size = lastchunk->i_offset;
 
-        if ( p_demux_track->i_sample_size != 0 ) /* all samples have same size */
+        if ( stsz->i_sample_size != 0 ) /* all samples have same size */
         {
-            i_total_size += (uint64_t)p_demux_track->i_sample_size * lastchunk->i_sample_count;
+            i_total_size += (uint64_t)stsz->i_sample_size * lastchunk->i_sample_count;
         }
         else
         {
@@ -2172,13 +2313,10 @@ static int TrackCreateSamplesIndex( demux_t *p_demux,
 
     /* Use stts table to create a sample number -> dts table.
      * XXX: if we don't want to waste too much memory, we can't expand
-     *  the box! so each chunk will contain an "extract" of this table
-     *  for fast research (problem with raw stream where a sample is sometime
+     *  the box! so each chunk only points to the runs of the table covering
+     *  its samples, like for raw streams where a sample is sometime
      *  just channels*bits_per_sample/8 */
 
-     /* FIXME: refactor STTS & CTTS, STTS having now only few extra lines and
-      *        differing in 2/2 fields and 1 signedness */
-
     mtime_t i_next_dts = 0;
     /* Find stts
      *  Gives mapping between sample and decoding time
@@ -2195,96 +2333,48 @@ static int TrackCreateSamplesIndex( demux_t *p_demux,
 
         msg_Warn( p_demux, "STTS table of %"PRIu32" entries", stts->i_entry_count );
 
-        /* Create sample -> dts table per chunk */
+        /* Point each chunk to its runs */
         uint32_t i_index = 0;
-        uint32_t i_current_index_samples_left = 0;
+        uint32_t i_skip = 0;
 
         for( uint32_t i_chunk = 0; i_chunk < p_demux_track->i_chunk_count; i_chunk++ )
         {
             mp4_chunk_t *ck = &p_demux_track->chunk[i_chunk];
-            uint32_t i_sample_count;
+            uint32_t i_sample_count = ck->i_sample_count;
 
             /* save first dts */
             ck->i_first_dts = i_next_dts;
             ck->i_last_dts  = i_next_dts;
 
-            /* count how many entries are needed for this chunk
-             * for p_sample_delta_dts and p_sample_count_dts */
-            ck->i_entries_dts = 0;
-
-            int i_ret = xTTS_CountEntries( p_demux, &ck->i_entries_dts, i_index,
-                                           i_current_index_samples_left,
-                                           ck->i_sample_count,
-                                           stts->pi_sample_count,
-                                           stts->i_entry_count );
-            if ( i_ret == VLC_EGENERIC )
-                return i_ret;
-
-            /* allocate them */
-            ck->p_sample_count_dts = calloc( ck->i_entries_dts, sizeof( uint32_t ) );
-            ck->p_sample_delta_dts = calloc( ck->i_entries_dts, sizeof( uint32_t ) );
-            if( !ck->p_sample_count_dts || !ck->p_sample_delta_dts )
+            if( i_sample_count && i_index >= stts->i_entry_count )
             {
-                free( ck->p_sample_count_dts );
-                free( ck->p_sample_delta_dts );
-                msg_Err( p_demux, "can't allocate memory for i_entry=%"PRIu32, ck->i_entries_dts );
-                ck->i_entries_dts = 0;
-                return VLC_ENOMEM;
+                msg_Err( p_demux, "invalid index counting total samples %u %u",
+                         i_index, stts->i_entry_count );
+                break;
             }
 
-            /* now copy */
-            i_sample_count = ck->i_sample_count;
+            ck->i_entries_dts = 0;
+            ck->i_skip_dts = i_skip;
+            ck->p_sample_count_dts = &stts->pi_sample_count[i_index];
+            ck->p_sample_delta_dts = (uint32_t *)&stts->pi_sample_delta[i_index];
 
-            for( uint32_t i = 0; i < ck->i_entries_dts; i++ )
+            while( i_sample_count && i_index < stts->i_entry_count )
             {
-                if ( i_current_index_samples_left )
+                uint32_t i_run = stts->pi_sample_count[i_index] - i_skip;
+                uint32_t i_used = __MIN( i_run, i_sample_count );
+
+                if( i_used ) ck->i_last_dts = i_next_dts;
+                i_next_dts += i_used * (uint32_t)stts->pi_sample_delta[i_index];
+                i_sample_count -= i_used;
+                ck->i_entries_dts++;
+
+                if( i_used == i_run )
                 {
-                    if ( i_current_index_samples_left > i_sample_count )
-                    {
-                        if ( i_sample_count ) ck->i_last_dts = i_next_dts;
-                        ck->p_sample_count_dts[i] = i_sample_count;
-                        ck->p_sample_delta_dts[i] = stts->pi_sample_delta[i_index];
-                        i_next_dts += ck->p_sample_count_dts[i] * stts->pi_sample_delta[i_index];
-                        i_current_index_samples_left -= i_sample_count;
-                        i_sample_count = 0;
-                        assert( i == ck->i_entries_dts - 1 );
-                        break;
-                    }
-                    else
-                    {
-                        if ( i_current_index_samples_left ) ck->i_last_dts = i_next_dts;
-                        ck->p_sample_count_dts[i] = i_current_index_samples_left;
-                        ck->p_sample_delta_dts[i] = stts->pi_sample_delta[i_index];
-                        i_next_dts += ck->p_sample_count_dts[i] * stts->pi_sample_delta[i_index];
-                        i_sample_count -= i_current_index_samples_left;
-                        i_current_index_samples_left = 0;
-                        i_index++;
-                    }
+                    i_index++;
+                    i_skip = 0;
                 }
                 else
-                {
-                    if ( stts->pi_sample_count[i_index] > i_sample_count )
-                    {
-                        if ( i_sample_count ) ck->i_last_dts = i_next_dts;
-                        ck->p_sample_count_dts[i] = i_sample_count;
-                        ck->p_sample_delta_dts[i] = stts->pi_sample_delta[i_index];
-                        i_next_dts += ck->p_sample_count_dts[i] * stts->pi_sample_delta[i_index];
-                        i_current_index_samples_left = stts->pi_sample_count[i_index] - i_sample_count;
-                        i_sample_count = 0;
-                        assert( i == ck->i_entries_dts - 1 );
-                        // keep building from same index
-                    }
-                    else
-                    {
-                        if ( stts->pi_sample_count[i_index] ) ck->i_last_dts = i_next_dts;
-                        ck->p_sample_count_dts[i] = stts->pi_sample_count[i_index];
-                        ck->p_sample_delta_dts[i] = stts->pi_sample_delta[i_index];
-                        i_next_dts += ck->p_sample_count_dts[i] * stts->pi_sample_delta[i_index];
-                        i_sample_count -= stts->pi_sample_count[i_index];
-                        i_index++;
-                    }
-                }
-
+                    i_skip += i_used; /* keep building from same index */
             }
         }
     }
@@ -2300,84 +2390,42 @@ static int TrackCreateSamplesIndex( demux_t *p_demux,
 
         msg_Warn( p_demux, "CTTS table of %"PRIu32" entries", ctts->i_entry_count );
 
-        /* Create pts-dts table per chunk */
+        /* Point each chunk to its runs */
         uint32_t i_index = 0;
-        uint32_t i_current_index_samples_left = 0;
+        uint32_t i_skip = 0;
 
         for( uint32_t i_chunk = 0; i_chunk < p_demux_track->i_chunk_count; i_chunk++ )
         {
             mp4_chunk_t *ck = &p_demux_track->chunk[i_chunk];
-            uint32_t i_sample_count;
+            uint32_t i_sample_count = ck->i_sample_count;
 
-            /* count how many entries are needed for this chunk
-             * for p_sample_offset_pts and p_sample_count_pts */
-            ck->i_entries_pts = 0;
-            int i_ret = xTTS_CountEntries( p_demux, &ck->i_entries_pts, i_index,
-                                           i_current_index_samples_left,
-                                           ck->i_sample_count,
-                                           ctts->pi_sample_count,
-                                           ctts->i_entry_count );
-            if ( i_ret == VLC_EGENERIC )
-                return i_ret;
-
-            /* allocate them */
-            ck->p_sample_count_pts = calloc( ck->i_entries_pts, sizeof( uint32_t ) );
-            ck->p_sample_offset_pts = calloc( ck->i_entries_pts, sizeof( int32_t ) );
-            if( !ck->p_sample_count_pts || !ck->p_sample_offset_pts )
+            if( i_sample_count && i_index >= ctts->i_entry_count )
             {
-                free( ck->p_sample_count_pts );
-                free( ck->p_sample_offset_pts );
-                msg_Err( p_demux, "can't allocate memory for i_entry=%"PRIu32, ck->i_entries_pts );
-                ck->i_entries_pts = 0;
-                return VLC_ENOMEM;
+                msg_Err( p_demux, "invalid index counting total samples %u %u",
+                         i_index, ctts->i_entry_count );
+                break;
             }
 
-            /* now copy */
-            i_sample_count = ck->i_sample_count;
+            ck->i_entries_pts = 0;
+            ck->i_skip_pts = i_skip;
+            ck->p_sample_count_pts = &ctts->pi_sample_count[i_index];
+            ck->p_sample_offset_pts = &ctts->pi_sample_offset[i_index];
 
-            for( uint32_t i = 0; i < ck->i_entries_pts; i++ )
+            while( i_sample_count && i_index < ctts->i_entry_count )
             {
-                if ( i_current_index_samples_left )
+                uint32_t i_run = ctts->pi_sample_count[i_index] - i_skip;
+                uint32_t i_used = __MIN( i_run, i_sample_count );
+
+                i_sample_count -= i_used;
+                ck->i_entries_pts++;
+
+                if( i_used == i_run )
                 {
-                    if ( i_current_index_samples_left > i_sample_count )
-                    {
-                        ck->p_sample_count_pts[i] = i_sample_count;
-                        ck->p_sample_offset_pts[i] = ctts->pi_sample_offset[i_index];
-                        i_current_index_samples_left -= i_sample_count;
-                        i_sample_count = 0;
-                        assert( i == ck->i_entries_pts - 1 );
-                        break;
-                    }
-                    else
-                    {
-                        ck->p_sample_count_pts[i] = i_current_index_samples_left;
-                        ck->p_sample_offset_pts[i] = ctts->pi_sample_offset[i_index];
-                        i_sample_count -= i_current_index_samples_left;
-                        i_current_index_samples_left = 0;
-                        i_index++;
-                    }
+                    i_index++;
+                    i_skip = 0;
                 }
                 else
-                {
-                    if ( ctts->pi_sample_count[i_index] > i_sample_count )
-                    {
-                        ck->p_sample_count_pts[i] = i_sample_count;
-                        ck->p_sample_offset_pts[i] = ctts->pi_sample_offset[i_index];
-                        i_current_index_samples_left = ctts->pi_sample_count[i_index] - i_sample_count;
-                        i_sample_count = 0;
-                        assert( i == ck->i_entries_pts - 1 );
-                        // keep building from same index
-                    }
-                    else
-                    {
-                        ck->p_sample_count_pts[i] = ctts->pi_sample_count[i_index];
-                        ck->p_sample_offset_pts[i] = ctts->pi_sample_offset[i_index];
-                        i_sample_count -= ctts->pi_sample_count[i_index];
-                        i_index++;
-                    }
-                }
-
-
+                    i_skip += i_used; /* keep building from same index */
             }
         }
     }
@@ -2455,8 +2503,18 @@ static int TrackCreateES( demux_t *p_demux, mp4_track_t *p_track,
     demux_sys_t *p_sys = p_demux->p_sys;
     unsigned int i_sample_description_index;
 
-    if( p_sys->b_fragmented || p_track->i_chunk_count == 0 )
+    if( p_sys->b_fragmented )
         i_sample_description_index = 1; /* XXX */
+    else if( p_track->i_chunk_count == 0 )
+    {
+        /* the index is not created yet: use the one of the first chunk */
+        const MP4_Box_t *p_stsc = MP4_BoxGet( p_track->p_stbl, "stsc" );
+        if( p_stsc && BOXDATA(p_stsc) && BOXDATA(p_stsc)->i_entry_count )
+            i_sample_description_index =
+                BOXDATA(p_stsc)->i_sample_description_index[0];
+        else
+            i_sample_description_index = 1; /* XXX */
+    }
     else
         i_sample_description_index =
                 p_track->chunk[i_chunk].i_sample_description_index;
@@ -2618,7 +2676,7 @@ static int TrackTimeToSampleChunk( demux_t *p_demux, mp4_track_t *p_track,
     uint64_t     i_dts;
     unsigned int i_sample;
     unsigned int i_chunk;
-    int          i_index;
+    uint32_t     i_index;
 
     /* FIXME see if it's needed to check p_track->i_chunk_count */
     if( p_track->i_chunk_count == 0 )
@@ -2662,49 +2720,40 @@ static int TrackTimeToSampleChunk( demux_t *p_demux, mp4_track_t *p_track,
         i_start = i_start * p_track->i_timescale / CLOCK_FREQ;
     }
 
-    /* we start from sample 0/chunk 0, hope it won't take too much time */
     /* *** find good chunk *** */
-    for( i_chunk = 0; ; i_chunk++ )
-    {
-        if( i_chunk + 1 >= p_track->i_chunk_count )
-        {
-            /* at the end and can't check if i_start in this chunk,
-               it will be check while searching i_sample */
-            i_chunk = p_track->i_chunk_count - 1;
-            break;
-        }
-
-        if( (uint64_t)i_start >= p_track->chunk[i_chunk].i_first_dts &&
-            (uint64_t)i_start <  p_track->chunk[i_chunk + 1].i_first_dts )
-        {
-            break;
-        }
+    /* chunks are sorted by dts: find the last one starting at or before
+       i_start, the last chunk being checked while searching i_sample */
+    uint32_t i_low = 0, i_high = p_track->i_chunk_count - 1;
+    while( i_low < i_high )
+    {
+        uint32_t i_mid = i_low + ( i_high - i_low + 1 ) / 2;
+        if( (uint64_t)i_start >= p_track->chunk[i_mid].i_first_dts )
+            i_low = i_mid;
+        else
+            i_high = i_mid - 1;
     }
+    i_chunk = i_low;
 
     /* *** find sample in the chunk *** */
-    i_sample = p_track->chunk[i_chunk].i_sample_first;
-    i_dts    = p_track->chunk[i_chunk].i_first_dts;
-    for( i_index = 0; i_sample < p_track->chunk[i_chunk].i_sample_count; )
+    const mp4_chunk_t *ck = &p_track->chunk[i_chunk];
+    uint32_t i_left = ck->i_sample_count;
+    i_sample = ck->i_sample_first;
+    i_dts    = ck->i_first_dts;
+    for( i_index = 0; i_left > 0 && i_index < ck->i_entries_dts; i_index++ )
     {
-        if( i_dts +
-            p_track->chunk[i_chunk].p_sample_count_dts[i_index] *
-            p_track->chunk[i_chunk].p_sample_delta_dts[i_index] < (uint64_t)i_start )
-        {
-            i_dts    +=
-                p_track->chunk[i_chunk].p_sample_count_dts[i_index] *
-                p_track->chunk[i_chunk].p_sample_delta_dts[i_index];
+        const uint32_t i_run = __MIN( MP4_ChunkGetDTSRun( ck, i_index ), i_left );
+        const uint32_t i_delta = ck->p_sample_delta_dts[i_index];
 
-            i_sample += p_track->chunk[i_chunk].p_sample_count_dts[i_index];
-            i_index++;
+        if( i_dts + (uint64_t)i_run * i_delta < (uint64_t)i_start )
+        {
+            i_dts    += (uint64_t)i_run * i_delta;
+            i_sample += i_run;
+            i_left   -= i_run;
         }
         else
         {
-            if( p_track->chunk[i_chunk].p_sample_delta_dts[i_index] <= 0 )
-            {
-                break;
-            }
-            i_sample += ( i_start - i_dts ) /
-                p_track->chunk[i_chunk].p_sample_delta_dts[i_index];
+            if( i_delta > 0 )
+                i_sample += ( i_start - i_dts ) / i_delta;
             break;
         }
     }
@@ -3043,13 +3092,19 @@ static void MP4_TrackCreate( demux_t *p_demux, mp4_track_t *p_track,
         }
     }
 
-    /* Create chunk index table and sample index table */
-    if( TrackCreateChunksIndex( p_demux,p_track  ) ||
-        TrackCreateSamplesIndex( p_demux, p_track ) )
+    /* The sample count and size are needed to setup the es, but the chunk
+     * and sample index are only created when the track is selected */
+    const MP4_Box_t *p_stsz = MP4_BoxGet( p_track->p_stbl, "stsz" );
+    if( !p_stsz || !BOXDATA(p_stsz) )
     {
-        msg_Err( p_demux, "cannot create chunks index" );
-        return; /* cannot create chunks index */
+        msg_Warn( p_demux, "cannot find STSZ box" );
+        return;
     }
+    p_track->i_sample_count = BOXDATA(p_stsz)->i_sample_count;
+    p_track->i_sample_size = BOXDATA(p_stsz)->i_sample_size;
+
+    if( p_sys->b_fragmented && MP4_TrackCreateIndex( p_demux, p_track ) )
+        return;
 
     p_track->i_chunk  = 0;
     p_track->i_sample = 0;
@@ -3134,6 +3189,29 @@ static void MP4_TrackCreate( demux_t *p_demux, mp4_track_t *p_track,
     p_track->b_ok = true;
 }
 
+/****************************************************************************
+ * MP4_TrackCreateIndex:
+ ****************************************************************************
+ * Read the sample tables of a track and create its chunk and sample index,
+ * unless already done.
+ ****************************************************************************/
+static int MP4_TrackCreateIndex( demux_t *p_demux, mp4_track_t *p_track )
+{
+    if( p_track->b_indexed )
+        return VLC_SUCCESS;
+
+    if( MP4_BoxLoad( p_demux->s, p_track->p_stbl ) ||
+        TrackCreateChunksIndex( p_demux, p_track ) ||
+        TrackCreateSamplesIndex( p_demux, p_track ) )
+    {
+        msg_Err( p_demux, "cannot create chunks index" );
+        return VLC_EGENERIC;
+    }
+
+    p_track->b_indexed = true;
+    return VLC_SUCCESS;
+}
+
 static void DestroyChunk( mp4_chunk_t *ck )
 {
     free( ck->p_sample_count_dts );
@@ -3162,11 +3240,7 @@ static void MP4_TrackDestroy( demux_t *p_demux, mp4_track_t *p_track )
     if( p_track->p_es )
         es_out_Del( p_demux->out, p_track->p_es );
 
-    if( p_track->chunk )
-    {
-        for( unsigned int i_chunk = 0; i_chunk < p_track->i_chunk_count; i_chunk++ )
-            DestroyChunk( &p_track->chunk[i_chunk] );
-    }
+    /* moov chunks only point to the sample tables */
     free( p_track->chunk );
 
     if( p_track->cchunk )
@@ -3176,9 +3250,6 @@ static void MP4_TrackDestroy( demux_t *p_demux, mp4_track_t *p_track )
         free( p_track->cchunk );
     }
 
-    if( !p_track->i_sample_size )
-        free( p_track->p_sample_size );
-
     if ( p_track->asfinfo.p_frame )
         block_ChainRelease( p_track->asfinfo.p_frame );
 }
@@ -3232,6 +3303,13 @@ static int MP4_TrackSeek( demux_t *p_demux, mp4_track_t *p_track,
     if( !p_track->b_ok || p_track->b_chapters_source )
         return VLC_EGENERIC;
 
+    if( MP4_TrackCreateIndex( p_demux, p_track ) )
+    {
+        p_track->b_ok = false;
+        p_track->b_selected = false;
+        return VLC_EGENERIC;
+    }
+
     p_track->b_selected = false;
 
     if( TrackTimeToSampleChunk( p_demux, p_track, i_start,
@@ -4595,13 +4673,13 @@ static inline mtime_t LeafGetMOOVTimeInChunk( const mp4_chunk_t *p_chunk, uint32
     mtime_t i_time = 0;
     uint32_t i_index = 0;
 
-    while( i_sample > 0 )
+    while( i_sample > 0 && i_index < p_chunk->i_entries_dts )
     {
-        if( i_sample > p_chunk->p_sample_count_dts[i_index] )
+        const uint32_t i_run = MP4_ChunkGetDTSRun( p_chunk, i_index );
+        if( i_sample > i_run )
         {
-            i_time += p_chunk->p_sample_count_dts[i_index] *
-                p_chunk->p_sample_delta_dts[i_index];
-            i_sample -= p_chunk->p_sample_count_dts[i_index];
+            i_time += i_run * p_chunk->p_sample_delta_dts[i_index];
+            i_sample -= i_run;
             i_index++;
         }
         else
@@ -46,16 +46,21 @@ typedef struct
     uint64_t     i_first_dts;   /* DTS of the first sample */
     uint64_t     i_last_dts;    /* DTS of the last sample */
 
+    /* runs covering the chunk samples: within the moov, these point into
+       the stts and ctts tables, the first run being possibly shared with
+       the previous chunks, of which i_skip samples are not in this chunk */
     uint32_t     i_entries_dts;
+    uint32_t     i_skip_dts;
     uint32_t     *p_sample_count_dts;
     uint32_t     *p_sample_delta_dts;   /* dts delta */
 
     uint32_t     i_entries_pts;
+    uint32_t     i_skip_pts;
     uint32_t     *p_sample_count_pts;
     int32_t      *p_sample_offset_pts;  /* pts-dts */
 
     uint8_t      **p_sample_data;     /* set when b_fragmented is true */
-    uint32_t     *p_sample_size;
+    uint32_t     *p_sample_size;      /* set when b_fragmented is true */
     /* TODO if needed add pts
         but quickly *add* support for edts and seeking */
 
@@ -107,14 +112,14 @@ typedef struct
     uint32_t         i_chunk_count;
     uint32_t         i_sample_count;
 
+    bool           b_indexed; /* chunk and sample index are created */
     mp4_chunk_t    *chunk; /* always defined  for each chunk */
     mp4_chunk_t    *cchunk; /* current chunk if b_fragmented is true */
 
     /* sample size, p_sample_size defined only if i_sample_size == 0
         else i_sample_size is size for all sample */
     uint32_t         i_sample_size;
-    uint32_t         *p_sample_size; /* XXX perhaps add file offset if take
-                                    too much time to do sumations each time*/
+    const uint32_t   *p_sample_size; /* points into the stsz table */
 
     uint32_t     i_sample_first; /* i_sample_first value
                                                    of the next chunk */
@@ -122,7 +127,7 @@ typedef struct
                                                    of the next chunk */
 
     const MP4_Box_t *p_track;
-    const MP4_Box_t *p_stbl;  /* will contain all timing information */
+    MP4_Box_t       *p_stbl;  /* will contain all timing information */
     const MP4_Box_t *p_stsd;  /* will contain all data to initialize decoder */
     const MP4_Box_t *p_sample;/* point on actual sdsd */
 
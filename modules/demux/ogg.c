@@ -52,6 +52,11 @@
 static int  Open ( vlc_object_t * );
 static void Close( vlc_object_t * );
 
+#define INDEX_CACHE_TEXT N_("Keep the seek indexes")
+#define INDEX_CACHE_LONGTEXT N_( \
+    "Save the positions of the pages met while playing, and reuse them to " \
+    "seek without searching when opening the same files again." )
+
 vlc_module_begin ()
     set_shortname ( "OGG" )
     set_description( N_("OGG demuxer" ) )
@@ -60,6 +65,8 @@ vlc_module_begin ()
     set_capability( "demux", 50 )
     set_callbacks( Open, Close )
     add_shortcut( "ogg" )
+    add_bool( "ogg-index-cache", false,
+              INDEX_CACHE_TEXT, INDEX_CACHE_LONGTEXT, true )
 vlc_module_end ()
 
 
@@ -250,6 +257,8 @@ static int Open( vlc_object_t * p_this )
     while ( !p_sys->b_preparsing_done && p_demux->pf_demux( p_demux ) > 0 )
     {}
 
+    OggSeek_IndexCacheLoad( p_demux );
+
     return VLC_SUCCESS;
 }
 
@@ -264,6 +273,7 @@ static void Close( vlc_object_t *p_this )
     /* Cleanup the bitstream parser */
     ogg_sync_clear( &p_sys->oy );
 
+    OggSeek_IndexCacheSave( p_demux );
     Ogg_EndOfStream( p_demux );
 
     if( p_sys->p_old_stream )
@@ -297,6 +307,7 @@ static int Demux( demux_t * p_demux )
         if ( p_sys->i_streams ) /* All finished */
         {
             msg_Dbg( p_demux, "end of a group of logical streams" );
+            OggSeek_IndexCacheSave( p_demux );
             /* We keep the ES to try reusing it in Ogg_BeginningOfStream
              * only 1 ES is supported (common case for ogg web radio) */
             if( p_sys->i_streams == 1 )
@@ -411,6 +422,12 @@ static int Demux( demux_t * p_demux )
             {
                 continue;
             }
+
+            /* Remember where the page is, to seek there again */
+            if( p_sys->i_total_length > 0 )
+                OggSeek_IndexAdd( p_stream,
+                                  ogg_page_granulepos( &p_sys->current_page ),
+                                  p_sys->i_page_pos );
         }
 
         /* clear the finished flag if pages after eos (ex: after a seek) */
@@ -694,6 +711,7 @@ static void Ogg_ResetStream( logical_stream_t *p_stream )
     p_stream->i_previous_granulepos = -1;
     p_stream->i_previous_pcr = VLC_TS_UNKNOWN;
     ogg_stream_reset( &p_stream->os );
+    OggSeek_IndexUnlink( p_stream );
     FREENULL( p_stream->prepcr.pp_blocks );
     p_stream->prepcr.i_size = 0;
     p_stream->prepcr.i_used = 0;
@@ -778,7 +796,7 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
                 return VLC_EGENERIC;
             }
             vlc_stream_Control( p_demux->s, STREAM_CAN_FASTSEEK, &b );
-            if ( Oggseek_BlindSeektoAbsoluteTime( p_demux, p_stream, i64, b ) )
+            if ( Oggseek_BlindSeektoAbsoluteTime( p_demux, p_stream, i64, b ) >= 0 )
             {
                 Ogg_ResetStreamsHelper( p_sys );
                 es_out_Control( p_demux->out, ES_OUT_SET_NEXT_DISPLAY_TIME,
@@ -918,7 +936,7 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
             }
 
             vlc_stream_Control( p_demux->s, STREAM_CAN_FASTSEEK, &b );
-            if ( Oggseek_BlindSeektoAbsoluteTime( p_demux, p_stream, i64, b ) )
+            if ( Oggseek_BlindSeektoAbsoluteTime( p_demux, p_stream, i64, b ) >= 0 )
             {
                 Ogg_ResetStreamsHelper( p_sys );
                 es_out_Control( p_demux->out, ES_OUT_SET_NEXT_DISPLAY_TIME,
@@ -960,6 +978,11 @@ static int Ogg_ReadPage( demux_t *p_demux, ogg_page *p_oggpage )
         ogg_sync_wrote( &p_ogg->oy, i_read );
     }
 
+    /* The page ends where the data left in the sync buffer starts */
+    p_ogg->i_page_pos = vlc_stream_Tell( p_demux->s )
+                      - ( p_ogg->oy.fill - p_ogg->oy.returned )
+                      - p_oggpage->header_len - p_oggpage->body_len;
+
     return VLC_SUCCESS;
 }
 
@@ -2160,8 +2183,8 @@ static int Ogg_BeginningOfStream( demux_t *p_demux )
 
         p_stream->p_es = NULL;
 
-        /* initialise kframe index */
-        p_stream->idx=NULL;
+        /* initialise page index */
+        p_stream->idx.i_last = -1;
 
         if ( p_stream->fmt.i_bitrate == 0  &&
              ( p_stream->fmt.i_cat == VIDEO_ES ||
@@ -2250,10 +2273,7 @@ static void Ogg_LogicalStreamDelete( demux_t *p_demux, logical_stream_t *p_strea
     es_format_Clean( &p_stream->fmt_old );
     es_format_Clean( &p_stream->fmt );
 
-    if ( p_stream->idx != NULL)
-    {
-        oggseek_index_entries_free( p_stream->idx );
-    }
+    OggSeek_IndexClean( p_stream );
 
     Ogg_FreeSkeleton( p_stream->p_skel );
     p_stream->p_skel = NULL;
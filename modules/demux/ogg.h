@@ -99,8 +99,17 @@ typedef struct logical_stream_s
     /* offset of first keyframe for theora; can be 0 or 1 depending on version number */
     int8_t i_keyframe_offset;
 
-    /* keyframe index for seeking, created as we discover keyframes */
-    demux_index_entry_t *idx;
+    /* page index for seeking, created as we demux */
+    struct
+    {
+        demux_index_entry_t *p_entries;
+        size_t i_count;
+        size_t i_size;
+        /* entry of the last page demuxed, or -1 after a seek */
+        ssize_t i_last;
+        /* entries added or linked since the index was loaded or saved */
+        bool b_dirty;
+    } idx;
 
     /* Skeleton data */
     ogg_skeleton_t *p_skel;
@@ -209,6 +218,8 @@ struct demux_sys_t
 
     /* current page being parsed */
     ogg_page current_page;
+    /* offset of the last page read by Ogg_ReadPage */
+    int64_t i_page_pos;
 
     /* */
     vlc_meta_t          *p_meta;
@@ -32,6 +32,8 @@
 
 #include <vlc_common.h>
 #include <vlc_demux.h>
+#include <vlc_fs.h>
+#include <vlc_md5.h>
 
 #include <ogg/ogg.h>
 #include <limits.h>
@@ -67,115 +69,123 @@ typedef struct packetStartCoordinates
 * index entries
 *************************************************************/
 
-/* free all entries in index list */
+/* free all entries of the index */
 
-void oggseek_index_entries_free ( demux_index_entry_t *idx )
+void OggSeek_IndexClean ( logical_stream_t *p_stream )
 {
-    demux_index_entry_t *idx_next;
-
-    while ( idx != NULL )
-    {
-        idx_next = idx->p_next;
-        free( idx );
-        idx = idx_next;
-    }
+    free( p_stream->idx.p_entries );
+    p_stream->idx.p_entries = NULL;
+    p_stream->idx.i_count = p_stream->idx.i_size = 0;
+    p_stream->idx.i_last = -1;
+    p_stream->idx.b_dirty = false;
 }
 
+/* the next page demuxed does not follow the last one */
 
-/* internal function to create a new list member */
-
-static demux_index_entry_t *index_entry_new( void )
+void OggSeek_IndexUnlink ( logical_stream_t *p_stream )
 {
-    demux_index_entry_t *idx = xmalloc( sizeof( demux_index_entry_t ) );
-    if ( !idx ) return NULL;
-    idx->p_next = idx->p_prev = NULL;
-    idx->i_pagepos_end = -1;
-    return idx;
+    p_stream->idx.i_last = -1;
 }
 
-/* We insert into index, sorting by pagepos (as a page can match multiple
-   time stamps) */
-const demux_index_entry_t *OggSeek_IndexAdd ( logical_stream_t *p_stream,
-                                             int64_t i_timestamp,
-                                             int64_t i_pagepos )
+/* index of the first entry at or after i_pagepos */
+
+static size_t OggSeekIndexLowerBound( const logical_stream_t *p_stream,
+                                      int64_t i_pagepos )
 {
-    demux_index_entry_t *idx;
-    demux_index_entry_t *last_idx = NULL;
+    size_t i_low = 0, i_high = p_stream->idx.i_count;
 
-    if ( p_stream == NULL ) return NULL;
+    while ( i_low < i_high )
+    {
+        size_t i_mid = ( i_low + i_high ) / 2;
+        if ( p_stream->idx.p_entries[i_mid].i_pagepos < i_pagepos )
+            i_low = i_mid + 1;
+        else
+            i_high = i_mid;
+    }
+    return i_low;
+}
 
-    idx = p_stream->idx;
+/* We insert into index, sorting by pagepos. Pages are mostly met in order
+   while demuxing, so that this is usually an append. */
+void OggSeek_IndexAdd ( logical_stream_t *p_stream,
+                        int64_t i_granule, int64_t i_pagepos )
+{
+    if ( i_granule < 1 || i_pagepos < 1 ) return;
 
-    if ( i_timestamp < 1 || i_pagepos < 1 ) return NULL;
+    size_t i = OggSeekIndexLowerBound( p_stream, i_pagepos );
+    demux_index_entry_t *p_entries = p_stream->idx.p_entries;
 
-    if ( idx == NULL )
+    if ( i == p_stream->idx.i_count || p_entries[i].i_pagepos != i_pagepos )
     {
-        demux_index_entry_t *ie = index_entry_new();
-        if ( !ie ) return NULL;
-        ie->i_value = i_timestamp;
-        ie->i_pagepos = i_pagepos;
-        p_stream->idx = ie;
-        return ie;
-    }
+        if ( p_stream->idx.i_count == p_stream->idx.i_size )
+        {
+            size_t i_size = __MAX( 2 * p_stream->idx.i_size, 256 );
+            p_entries = realloc( p_entries, i_size * sizeof( *p_entries ) );
+            if ( !p_entries ) return;
+            p_stream->idx.p_entries = p_entries;
+            p_stream->idx.i_size = i_size;
+        }
 
-    while ( idx != NULL )
-    {
-        if ( idx->i_pagepos > i_pagepos ) break;
-        last_idx = idx;
-        idx = idx->p_next;
-    }
+        memmove( &p_entries[i + 1], &p_entries[i],
+                 ( p_stream->idx.i_count - i ) * sizeof( *p_entries ) );
+        p_stream->idx.i_count++;
+        if ( p_stream->idx.i_last >= (ssize_t) i )
+            p_stream->idx.i_last++;
 
-    /* new entry; insert after last_idx */
-    idx = index_entry_new();
-    if ( !idx ) return NULL;
-    if ( last_idx != NULL )
-    {
-        idx->p_next = last_idx->p_next;
-        last_idx->p_next = idx;
-        idx->p_prev = last_idx;
-    }
-    else
-    {
-        idx->p_next = p_stream->idx;
-        p_stream->idx = idx;
+        p_entries[i].i_pagepos = i_pagepos;
+        p_entries[i].i_granule = i_granule;
+        p_entries[i].b_linked = false;
+
+        /* we no longer know what lies between the pages around */
+        if ( i + 1 < p_stream->idx.i_count )
+            p_entries[i + 1].b_linked = false;
+        p_stream->idx.b_dirty = true;
     }
 
-    if ( idx->p_next != NULL )
+    if ( i > 0 && p_stream->idx.i_last == (ssize_t) i - 1 &&
+         !p_entries[i].b_linked )
     {
-        idx->p_next->p_prev = idx;
+        p_entries[i].b_linked = true;
+        p_stream->idx.b_dirty = true;
     }
+    p_stream->idx.i_last = i;
+}
 
-    idx->i_value = i_timestamp;
-    idx->i_pagepos = i_pagepos;
+/* index of the last entry up to i_timestamp, or -1 */
 
-    return idx;
+static ssize_t OggSeekIndexFindTime ( logical_stream_t *p_stream,
+                                      int64_t i_timestamp )
+{
+    size_t i_low = 0, i_high = p_stream->idx.i_count;
+
+    while ( i_low < i_high )
+    {
+        size_t i_mid = ( i_low + i_high ) / 2;
+        if ( Oggseek_GranuleToAbsTimestamp( p_stream,
+                p_stream->idx.p_entries[i_mid].i_granule, false ) <= i_timestamp )
+            i_low = i_mid + 1;
+        else
+            i_high = i_mid;
+    }
+    return (ssize_t) i_low - 1;
 }
 
-static bool OggSeekIndexFind ( logical_stream_t *p_stream, int64_t i_timestamp,
-                               int64_t *pi_pos_lower, int64_t *pi_pos_upper )
+/* narrow the search bounds to the pages indexed around i_timestamp */
+
+static void OggSeekIndexBounds ( logical_stream_t *p_stream, int64_t i_timestamp,
+                                 int64_t *pi_pos_lower, int64_t *pi_pos_upper )
 {
-    demux_index_entry_t *idx = p_stream->idx;
+    ssize_t i = OggSeekIndexFindTime( p_stream, i_timestamp );
+
+    if ( i >= 0 )
+        *pi_pos_lower = __MAX( *pi_pos_lower, p_stream->idx.p_entries[i].i_pagepos );
 
-    while ( idx != NULL )
+    if ( (size_t) ( i + 1 ) < p_stream->idx.i_count )
     {
-        if ( idx->i_value <= i_timestamp )
-        {
-            if ( !idx->p_next ) /* found on last index */
-            {
-                *pi_pos_lower = idx->i_pagepos;
-                return true;
-            }
-            if ( idx->p_next->i_value > i_timestamp )
-            {
-                *pi_pos_lower = idx->i_pagepos;
-                *pi_pos_upper = idx->p_next->i_pagepos;
-                return true;
-            }
-        }
-        idx = idx->p_next;
+        int64_t i_pos = p_stream->idx.p_entries[i + 1].i_pagepos;
+        if ( *pi_pos_upper < 0 || i_pos < *pi_pos_upper )
+            *pi_pos_upper = i_pos;
     }
-
-    return false;
 }
 
 /*********************************************************************
@@ -673,6 +683,42 @@ restart:
     return i_result;
 }
 
+/* Looks the target up in the pages met while demuxing, and returns the
+ * position to demux from, or -1 if it lies in a region not indexed yet */
+static int64_t OggSeekIndexLookup( demux_t *p_demux, logical_stream_t *p_stream,
+                                   int64_t i_targettime )
+{
+    const demux_index_entry_t *p_entries = p_stream->idx.p_entries;
+    ssize_t i = OggSeekIndexFindTime( p_stream, i_targettime );
+
+    /* The target must fall between two linked pages */
+    if ( i < 0 || (size_t) i + 1 >= p_stream->idx.i_count ||
+         !p_entries[i + 1].b_linked || p_stream->b_oggds )
+        return -1;
+
+    /* Audio can be decoded from any page */
+    if ( p_stream->fmt.i_cat != VIDEO_ES )
+        return p_entries[i].i_pagepos;
+
+    /* Otherwise go back to the last page before the keyframe, where its
+     * packet can start, and look for it from there */
+    int64_t i_keyframegranule = Ogg_GetKeyframeGranule( p_stream,
+                                                        p_entries[i].i_granule );
+    while ( p_entries[i].i_granule >= i_keyframegranule )
+    {
+        if ( !p_entries[i].b_linked )
+            return -1;
+        i--;
+    }
+
+    int64_t i_pagepos = OggForwardSeekToFrame( p_demux, p_entries[i].i_pagepos,
+                                               p_demux->p_sys->i_total_length,
+                                               p_stream, i_keyframegranule, true );
+    OggDebug( msg_Dbg( p_demux, "Found keyframe at %"PRId64" using page index",
+                       i_pagepos ) );
+    return i_pagepos;
+}
+
 /* Dont use b_presentation with frames granules ! */
 int64_t Oggseek_GranuleToAbsTimestamp( logical_stream_t *p_stream,
                                        int64_t i_granule, bool b_presentation )
@@ -908,9 +954,10 @@ int Oggseek_BlindSeektoAbsoluteTime( demux_t *p_demux, logical_stream_t *p_strea
     if ( i_lowerpos != -1 ) b_found = true;
 
     /* And also search in our own index */
-    if ( !b_found && OggSeekIndexFind( p_stream, i_time, &i_lowerpos, &i_upperpos ) )
+    if ( !b_found )
     {
-        b_found = true;
+        i_lowerpos = OggSeekIndexLookup( p_demux, p_stream, i_time );
+        b_found = ( i_lowerpos != -1 );
     }
 
     /* Or try to be smart with audio fixed bitrate streams */
@@ -923,11 +970,20 @@ int Oggseek_BlindSeektoAbsoluteTime( demux_t *p_demux, logical_stream_t *p_strea
         b_found = true;
     }
 
-    /* or search */
+    /* or search, between the pages already met */
     if ( !b_found && b_fastseek )
     {
+        int64_t i_pos_lower = p_stream->i_data_start;
+        int64_t i_pos_upper = p_sys->i_total_length;
+        OggSeekIndexBounds( p_stream, i_time, &i_pos_lower, &i_pos_upper );
         i_lowerpos = OggBisectSearchByTime( p_demux, p_stream, i_time,
-                                            p_stream->i_data_start, p_sys->i_total_length );
+                                            i_pos_lower, i_pos_upper );
+        /* the target may precede the first page indexed */
+        if ( i_lowerpos == -1 && ( i_pos_lower != p_stream->i_data_start ||
+                                   i_pos_upper != p_sys->i_total_length ) )
+            i_lowerpos = OggBisectSearchByTime( p_demux, p_stream, i_time,
+                                                p_stream->i_data_start,
+                                                p_sys->i_total_length );
         b_found = ( i_lowerpos != -1 );
     }
 
@@ -1004,15 +1060,23 @@ int Oggseek_SeektoAbsolutetime( demux_t *p_demux, logical_stream_t *p_stream,
     }
     OggDebug( msg_Dbg( p_demux, "Search bounds set to %"PRId64" %"PRId64" using skeleton index", i_offset_lower, i_offset_upper ) );
 
-    OggNoDebug(
-        OggSeekIndexFind( p_stream, i_time, &i_offset_lower, &i_offset_upper )
-    );
-
-    i_offset_lower = __MAX( i_offset_lower, p_stream->i_data_start );
-    i_offset_upper = __MIN( i_offset_upper, p_sys->i_total_length );
-
-    int64_t i_pagepos = OggBisectSearchByTime( p_demux, p_stream, i_time,
-                                       i_offset_lower, i_offset_upper);
+    int64_t i_pagepos = OggSeekIndexLookup( p_demux, p_stream, i_time );
+    if ( i_pagepos < 0 )
+    {
+        OggSeekIndexBounds( p_stream, i_time, &i_offset_lower, &i_offset_upper );
+
+        i_offset_lower = __MAX( i_offset_lower, p_stream->i_data_start );
+        i_offset_upper = __MIN( i_offset_upper, p_sys->i_total_length );
+
+        i_pagepos = OggBisectSearchByTime( p_demux, p_stream, i_time,
+                                           i_offset_lower, i_offset_upper);
+        /* the target may precede the first page indexed */
+        if ( i_pagepos < 0 && ( i_offset_lower != p_stream->i_data_start ||
+                                i_offset_upper != p_sys->i_total_length ) )
+            i_pagepos = OggBisectSearchByTime( p_demux, p_stream, i_time,
+                                               p_stream->i_data_start,
+                                               p_sys->i_total_length );
+    }
     if ( i_pagepos >= 0 )
     {
         /* be sure to clear any state or read+pagein() will fail on same # */
@@ -1020,16 +1084,232 @@ int Oggseek_SeektoAbsolutetime( demux_t *p_demux, logical_stream_t *p_stream,
         p_sys->i_input_position = i_pagepos;
         seek_byte( p_demux, p_sys->i_input_position );
     }
-    /* Insert keyframe position into index */
-    OggNoDebug(
-    if ( i_pagepos >= p_stream->i_data_start )
-        OggSeek_IndexAdd( p_stream, i_time, i_pagepos )
-    );
 
     OggDebug( msg_Dbg( p_demux, "=================== Seeked To %"PRId64" time %"PRId64, i_pagepos, i_time ) );
     return i_pagepos;
 }
 
+/****************************************************************************
+ * Page index cache: the pages met while playing a file, reused the next time
+ * it is opened.
+ ****************************************************************************/
+
+static char *OggSeekIndexCachePath( demux_t *p_demux )
+{
+    const char *psz_url = p_demux->s->psz_url;
+    if ( psz_url == NULL || stream_Size( p_demux->s ) <= 0 ||
+         !var_InheritBool( p_demux, "ogg-index-cache" ) )
+        return NULL;
+
+    char *psz_dir = config_GetUserDir( VLC_CACHE_DIR );
+    if ( psz_dir == NULL )
+        return NULL;
+
+    struct md5_s md5;
+    InitMD5( &md5 );
+    AddMD5( &md5, psz_url, strlen( psz_url ) );
+    EndMD5( &md5 );
+
+    char *psz_hash = psz_md5_hash( &md5 );
+    char *psz_path;
+    if ( psz_hash == NULL ||
+         asprintf( &psz_path, "%s"DIR_SEP"ogg"DIR_SEP"%s-%"PRIx64".idx",
+                   psz_dir, psz_hash,
+                   (uint64_t)stream_Size( p_demux->s ) ) == -1 )
+        psz_path = NULL;
+
+    free( psz_hash );
+    free( psz_dir );
+    return psz_path;
+}
+
+/* The cache directory and its parents may not exist yet */
+static void OggSeekIndexCacheCreateDir( const char *psz_path )
+{
+    char psz_dir[strlen( psz_path ) + 1];
+    strcpy( psz_dir, psz_path );
+
+    for ( char *psz = strchr( psz_dir + 1, DIR_SEP_CHAR ); psz != NULL;
+          psz = strchr( psz + 1, DIR_SEP_CHAR ) )
+    {
+        *psz = '\0';
+        vlc_mkdir( psz_dir, 0700 );
+        *psz = DIR_SEP_CHAR;
+    }
+}
+
+/* The file may have been rewritten in place, check the page is still there */
+static bool OggSeekIndexCheck( demux_t *p_demux, const logical_stream_t *p_stream,
+                               const demux_index_entry_t *p_entry )
+{
+    uint8_t header[PAGE_HEADER_BYTES];
+
+    return !vlc_stream_Seek( p_demux->s, p_entry->i_pagepos ) &&
+           vlc_stream_Read( p_demux->s, header, PAGE_HEADER_BYTES ) == PAGE_HEADER_BYTES &&
+           !memcmp( header, "OggS", 4 ) &&
+           (int64_t)GetQWLE( &header[6] ) == p_entry->i_granule &&
+           (int)GetDWLE( &header[14] ) == p_stream->i_serial_no;
+}
+
+void OggSeek_IndexCacheLoad( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    if ( p_sys->i_streams == 0 )
+        return;
+
+    char *psz_path = OggSeekIndexCachePath( p_demux );
+    if ( psz_path == NULL )
+        return;
+
+    FILE *f = vlc_fopen( psz_path, "rt" );
+    if ( f == NULL )
+    {
+        free( psz_path );
+        return;
+    }
+
+    int64_t i_backup_pos = vlc_stream_Tell( p_demux->s );
+    uint64_t i_size = stream_Size( p_demux->s );
+    uint64_t i_file_size;
+    int i_version;
+    bool b_ok = fscanf( f, "vlc-ogg-index %d %"SCNu64,
+                        &i_version, &i_file_size ) == 2 &&
+                i_version == 1 && i_file_size == i_size;
+
+    demux_index_entry_t *pp_entries[p_sys->i_streams];
+    size_t pi_count[p_sys->i_streams];
+    for ( int i = 0; i < p_sys->i_streams; i++ )
+    {
+        pp_entries[i] = NULL;
+        pi_count[i] = 0;
+    }
+
+    int i_serial;
+    size_t i_count;
+    while ( b_ok && fscanf( f, " s %d %zu", &i_serial, &i_count ) == 2 )
+    {
+        int i = 0;
+        while ( i < p_sys->i_streams && p_sys->pp_stream[i]->i_serial_no != i_serial )
+            i++;
+
+        b_ok = i < p_sys->i_streams && pp_entries[i] == NULL &&
+               i_count > 0 && i_count <= i_size / PAGE_HEADER_BYTES;
+        if ( !b_ok )
+            break;
+
+        demux_index_entry_t *p_entries = malloc( i_count * sizeof( *p_entries ) );
+        pp_entries[i] = p_entries;
+        pi_count[i] = i_count;
+        b_ok = p_entries != NULL;
+
+        for ( size_t j = 0; b_ok && j < i_count; j++ )
+        {
+            int i_linked;
+            b_ok = fscanf( f, "%"SCNd64" %"SCNd64" %d", &p_entries[j].i_pagepos,
+                           &p_entries[j].i_granule, &i_linked ) == 3 &&
+                   p_entries[j].i_pagepos > ( j ? p_entries[j - 1].i_pagepos : 0 ) &&
+                   (uint64_t)p_entries[j].i_pagepos < i_size &&
+                   p_entries[j].i_granule > 0;
+            p_entries[j].b_linked = j > 0 && i_linked;
+        }
+
+        b_ok = b_ok && OggSeekIndexCheck( p_demux, p_sys->pp_stream[i],
+                                          &p_entries[i_count - 1] );
+    }
+    fclose( f );
+    if ( vlc_stream_Seek( p_demux->s, i_backup_pos ) != VLC_SUCCESS )
+        b_ok = false;
+
+    if ( !b_ok )
+        msg_Warn( p_demux, "invalid index %s", psz_path );
+
+    for ( int i = 0; i < p_sys->i_streams; i++ )
+    {
+        logical_stream_t *p_stream = p_sys->pp_stream[i];
+
+        if ( !b_ok || pp_entries[i] == NULL )
+        {
+            free( pp_entries[i] );
+            continue;
+        }
+
+        /* The pages met so far are already in there */
+        OggSeek_IndexClean( p_stream );
+        p_stream->idx.p_entries = pp_entries[i];
+        p_stream->idx.i_count = p_stream->idx.i_size = pi_count[i];
+        msg_Dbg( p_demux, "stream %d: loaded %zu index entries",
+                 p_stream->i_serial_no, pi_count[i] );
+    }
+    free( psz_path );
+}
+
+void OggSeek_IndexCacheSave( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    /* Only once per change, whether the streams end or the demuxer closes */
+    size_t i_entries = 0;
+    bool b_dirty = false;
+    for ( int i = 0; i < p_sys->i_streams; i++ )
+    {
+        i_entries += p_sys->pp_stream[i]->idx.i_count;
+        b_dirty |= p_sys->pp_stream[i]->idx.b_dirty;
+    }
+    if ( i_entries == 0 || !b_dirty )
+        return;
+
+    char *psz_path = OggSeekIndexCachePath( p_demux );
+    if ( psz_path == NULL )
+        return;
+
+    OggSeekIndexCacheCreateDir( psz_path );
+
+    char *psz_tmp;
+    if ( asprintf( &psz_tmp, "%s.tmp", psz_path ) == -1 )
+    {
+        free( psz_path );
+        return;
+    }
+
+    FILE *f = vlc_fopen( psz_tmp, "wt" );
+    bool b_ok = false;
+    if ( f != NULL )
+    {
+        fprintf( f, "vlc-ogg-index %d %"PRIu64"\n", 1,
+                 (uint64_t)stream_Size( p_demux->s ) );
+        for ( int i = 0; i < p_sys->i_streams; i++ )
+        {
+            const logical_stream_t *p_stream = p_sys->pp_stream[i];
+            if ( p_stream->idx.i_count == 0 )
+                continue;
+
+            fprintf( f, "s %d %zu\n", p_stream->i_serial_no, p_stream->idx.i_count );
+            for ( size_t j = 0; j < p_stream->idx.i_count; j++ )
+                fprintf( f, "%"PRId64" %"PRId64" %d\n",
+                         p_stream->idx.p_entries[j].i_pagepos,
+                         p_stream->idx.p_entries[j].i_granule,
+                         p_stream->idx.p_entries[j].b_linked );
+        }
+        b_ok = !ferror( f );
+        b_ok = fclose( f ) == 0 && b_ok;
+    }
+
+    if ( !b_ok || vlc_rename( psz_tmp, psz_path ) )
+    {
+        msg_Warn( p_demux, "cannot write the index %s", psz_path );
+        vlc_unlink( psz_tmp );
+    }
+    else
+    {
+        for ( int i = 0; i < p_sys->i_streams; i++ )
+            p_sys->pp_stream[i]->idx.b_dirty = false;
+        msg_Dbg( p_demux, "saved %zu index entries to %s", i_entries, psz_path );
+    }
+    free( psz_tmp );
+    free( psz_path );
+}
+
 /****************************************************************************
  * oggseek_read_page: Read a full Ogg page from the physical bitstream.
  ****************************************************************************
@@ -30,23 +30,17 @@
 
 #define OGGSEEK_BYTES_TO_READ 8500
 
-/* index entries are structured as follows:
- *   - for theora, highest granulepos -> pagepos (bytes) where keyframe begins
- *  - for dirac, kframe (sync point) -> pagepos of sequence start (?)
- */
+/* index entries are the pages of a logical stream met while demuxing, sorted
+ * by position. A seek falling between two linked entries needs no search. */
 
 /* this is typedefed to demux_index_entry_t in ogg.h */
 struct oggseek_index_entry
 {
-    demux_index_entry_t *p_next;
-    demux_index_entry_t *p_prev;
-
-    /* value is highest granulepos for theora, sync frame for dirac */
-    int64_t i_value;
     int64_t i_pagepos;
-
-    /* not used for theora because the granulepos tells us this */
-    int64_t i_pagepos_end;
+    /* granule of the last packet ending on that page */
+    int64_t i_granule;
+    /* the previous entry is the previous page of the stream with a granule */
+    bool    b_linked;
 };
 
 int64_t Ogg_GetKeyframeGranule ( logical_stream_t *p_stream, int64_t i_granule );
@@ -57,9 +51,11 @@ int64_t Oggseek_GranuleToAbsTimestamp ( logical_stream_t *p_stream, int64_t i_gr
 int     Oggseek_BlindSeektoAbsoluteTime ( demux_t *, logical_stream_t *, int64_t, bool );
 int     Oggseek_BlindSeektoPosition ( demux_t *, logical_stream_t *, double f, bool );
 int     Oggseek_SeektoAbsolutetime ( demux_t *, logical_stream_t *, int64_t i_granulepos );
-const demux_index_entry_t *OggSeek_IndexAdd ( logical_stream_t *, int64_t, int64_t );
+void    OggSeek_IndexAdd ( logical_stream_t *, int64_t i_granule, int64_t i_pagepos );
+void    OggSeek_IndexUnlink ( logical_stream_t * );
+void    OggSeek_IndexClean ( logical_stream_t * );
+void    OggSeek_IndexCacheLoad ( demux_t * );
+void    OggSeek_IndexCacheSave ( demux_t * );
 void    Oggseek_ProbeEnd( demux_t * );
 
-void oggseek_index_entries_free ( demux_index_entry_t * );
-
 int64_t oggseek_read_page ( demux_t * );
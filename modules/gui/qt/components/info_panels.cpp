@@ -603,6 +603,11 @@ InputStatsPanel::InputStatsPanel( QWidget *parent ): QWidget( parent )
     CREATE_AND_ADD_TO_CAT( aplayed_stat, qtr("Played"),
                            "0", audio, qtr("buffers") );
     CREATE_AND_ADD_TO_CAT( alost_stat, qtr("Lost"), "0", audio, qtr("buffers") );
+    CREATE_AND_ADD_TO_CAT( alatency_stat, qtr("Latency"), "0", audio, "ms" );
+    CREATE_AND_ADD_TO_CAT( aallocated_stat, qtr("Allocated"),
+                           "0", audio, qtr("buffers") );
+    CREATE_AND_ADD_TO_CAT( arecycled_stat, qtr("Recycled"),
+                           "0", audio, qtr("buffers") );
 
 #undef CREATE_AND_ADD_TO_CAT
 #undef CREATE_CATEGORY
@@ -674,6 +679,9 @@ void InputStatsPanel::update( input_item_t *p_item )
     UPDATE_INT( adecoded_stat, p_item->p_stats->i_decoded_audio );
     UPDATE_INT( aplayed_stat,  p_item->p_stats->i_played_abuffers );
     UPDATE_INT( alost_stat,    p_item->p_stats->i_lost_abuffers );
+    UPDATE_FLOAT( alatency_stat, "%.1f", (float)(p_item->p_stats->i_audio_latency / 1000.) );
+    UPDATE_INT( aallocated_stat, p_item->p_stats->i_allocated_abuffers );
+    UPDATE_INT( arecycled_stat, p_item->p_stats->i_recycled_abuffers );
 
 #undef UPDATE_INT
 #undef UPDATE_FLOAT
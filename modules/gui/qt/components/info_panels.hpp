@@ -142,6 +142,9 @@ private:
     QTreeWidgetItem *adecoded_stat;
     QTreeWidgetItem *aplayed_stat;
     QTreeWidgetItem *alost_stat;
+    QTreeWidgetItem *alatency_stat;
+    QTreeWidgetItem *aallocated_stat;
+    QTreeWidgetItem *arecycled_stat;
 
     VLCStatsView *statsView;
 public slots:
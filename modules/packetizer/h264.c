@@ -93,8 +93,8 @@ struct decoder_sys_t
 
     /* */
     bool    b_slice;
-    block_t *p_frame;
-    block_t **pp_frame_last;
+    hxxx_au_t au;
+    size_t  i_frame_aud; /* size of the leading access unit delimiter */
     bool    b_frame_sps;
     bool    b_frame_pps;
 
@@ -143,8 +143,6 @@ struct decoder_sys_t
     cc_storage_t *p_ccs;
 };
 
-#define BLOCK_FLAG_PRIVATE_AUD (1 << BLOCK_FLAG_PRIVATE_SHIFT)
-
 static block_t *Packetize( decoder_t *, block_t ** );
 static block_t *PacketizeAVC1( decoder_t *, block_t ** );
 static block_t *GetCc( decoder_t *p_dec, bool pb_present[4] );
@@ -153,10 +151,12 @@ static void PacketizeFlush( decoder_t * );
 static void PacketizeReset( void *p_private, bool b_broken );
 static block_t *PacketizeParse( void *p_private, bool *pb_ts_used, block_t * );
 static int PacketizeValidate( void *p_private, block_t * );
+static block_t *PacketizeAlloc( void *p_private, size_t );
 
 static block_t *ParseNALBlock( decoder_t *, bool *pb_ts_used, block_t * );
 
 static block_t *OutputPicture( decoder_t *p_dec );
+static void ResetOutputVariables( decoder_sys_t *p_sys );
 static void PutSPS( decoder_t *p_dec, block_t *p_frag );
 static void PutPPS( decoder_t *p_dec, block_t *p_frag );
 static bool ParseSlice( decoder_t *p_dec, bool *pb_new_picture, slice_t *p_slice,
@@ -201,10 +201,11 @@ static int Open( vlc_object_t *p_this )
                      p_h264_startcode, sizeof(p_h264_startcode), startcode_FindAnnexB,
                      p_h264_startcode, 1, 5,
                      PacketizeReset, PacketizeParse, PacketizeValidate, p_dec );
+    p_sys->packetizer.pf_alloc = PacketizeAlloc;
 
     p_sys->b_slice = false;
-    p_sys->p_frame = NULL;
-    p_sys->pp_frame_last = &p_sys->p_frame;
+    hxxx_au_init( &p_sys->au );
+    p_sys->i_frame_aud = 0;
     p_sys->b_frame_sps = false;
     p_sys->b_frame_pps = false;
 
@@ -326,8 +327,7 @@ static void Close( vlc_object_t *p_this )
     decoder_sys_t *p_sys = p_dec->p_sys;
     int i;
 
-    if( p_sys->p_frame )
-        block_ChainRelease( p_sys->p_frame );
+    hxxx_au_clean( &p_sys->au );
     for( i = 0; i < H264_SPS_MAX; i++ )
     {
         if( p_sys->pp_sps[i] )
@@ -373,7 +373,7 @@ static block_t *PacketizeAVC1( decoder_t *p_dec, block_t **pp_block )
 {
     decoder_sys_t *p_sys = p_dec->p_sys;
 
-    return PacketizeXXC1( p_dec, p_sys->i_avcC_length_size,
+    return PacketizeXXC1( p_dec, &p_sys->au, p_sys->i_avcC_length_size,
                           pp_block, ParseNALBlock );
 }
 
@@ -395,10 +395,8 @@ static void PacketizeReset( void *p_private, bool b_broken )
 
     if( b_broken )
     {
-        if( p_sys->p_frame )
-            block_ChainRelease( p_sys->p_frame );
-        p_sys->p_frame = NULL;
-        p_sys->pp_frame_last = &p_sys->p_frame;
+        hxxx_au_reset( &p_sys->au );
+        p_sys->i_frame_aud = 0;
         p_sys->b_frame_sps = false;
         p_sys->b_frame_pps = false;
         p_sys->slice.i_frame_type = 0;
@@ -426,6 +424,13 @@ static int PacketizeValidate( void *p_private, block_t *p_au )
     VLC_UNUSED(p_au);
     return VLC_SUCCESS;
 }
+static block_t *PacketizeAlloc( void *p_private, size_t i_size )
+{
+    decoder_t *p_dec = p_private;
+
+    /* Cut the NALs straight into the access unit */
+    return hxxx_au_alloc( &p_dec->p_sys->au, i_size );
+}
 
 /*****************************************************************************
  * ParseNALBlock: parses annexB type NALs
@@ -444,13 +449,12 @@ static block_t *ParseNALBlock( decoder_t *p_dec, bool *pb_ts_used, block_t *p_fr
 
     if( p_sys->b_slice && ( !p_sys->b_sps || !p_sys->b_pps ) )
     {
-        block_ChainRelease( p_sys->p_frame );
+        hxxx_au_reset( &p_sys->au );
         msg_Warn( p_dec, "waiting for SPS/PPS" );
 
         /* Reset context */
         p_sys->slice.i_frame_type = 0;
-        p_sys->p_frame = NULL;
-        p_sys->pp_frame_last = &p_sys->p_frame;
+        p_sys->i_frame_aud = 0;
         p_sys->b_frame_sps = false;
         p_sys->b_frame_pps = false;
         p_sys->b_slice = false;
@@ -487,6 +491,7 @@ static block_t *ParseNALBlock( decoder_t *p_dec, bool *pb_ts_used, block_t *p_fr
         PutSPS( p_dec, p_frag );
 
         /* Do not append the SPS because we will insert it on keyframes */
+        block_Release( p_frag );
         p_frag = NULL;
     }
     else if( i_nal_type == H264_NAL_PPS )
@@ -498,6 +503,7 @@ static block_t *ParseNALBlock( decoder_t *p_dec, bool *pb_ts_used, block_t *p_fr
         PutPPS( p_dec, p_frag );
 
         /* Do not append the PPS because we will insert it on keyframes */
+        block_Release( p_frag );
         p_frag = NULL;
     }
     else if( i_nal_type == H264_NAL_AU_DELIMITER ||
@@ -515,21 +521,21 @@ static block_t *ParseNALBlock( decoder_t *p_dec, bool *pb_ts_used, block_t *p_fr
         }
         else if( i_nal_type == H264_NAL_AU_DELIMITER )
         {
-            if( p_sys->p_frame && (p_sys->p_frame->i_flags & BLOCK_FLAG_PRIVATE_AUD) )
+            if( p_sys->i_frame_aud )
             {
                 block_Release( p_frag );
                 p_frag = NULL;
             }
-            else
+            else if( hxxx_au_empty( &p_sys->au ) )
             {
-                p_frag->i_flags |= BLOCK_FLAG_PRIVATE_AUD;
+                p_sys->i_frame_aud = p_frag->i_buffer;
             }
         }
     }
 
     /* Append the block */
     if( p_frag )
-        block_ChainLastAppend( &p_sys->pp_frame_last, p_frag );
+        hxxx_au_append( &p_sys->au, p_frag );
 
     *pb_ts_used = false;
     if( p_sys->i_frame_dts <= VLC_TS_INVALID &&
@@ -561,47 +567,66 @@ static block_t *OutputPicture( decoder_t *p_dec )
          p_sys->slice.i_frame_type != BLOCK_FLAG_TYPE_I)
         return NULL;
 
+    p_pic = hxxx_au_output( &p_sys->au );
+    if( !p_pic )
+    {
+        ResetOutputVariables( p_sys );
+        return NULL;
+    }
+
     const bool b_sps_pps_i = p_sys->slice.i_frame_type == BLOCK_FLAG_TYPE_I &&
                              p_sys->b_sps &&
                              p_sys->b_pps;
-    if( b_sps_pps_i || p_sys->b_frame_sps || p_sys->b_frame_pps )
+    const bool b_sps = b_sps_pps_i || p_sys->b_frame_sps;
+    const bool b_pps = b_sps_pps_i || p_sys->b_frame_pps;
+    size_t i_ps = 0;
+
+    for( int i = 0; i < H264_SPS_MAX && b_sps; i++ )
     {
-        block_t *p_head = NULL;
-        if( p_sys->p_frame->i_flags & BLOCK_FLAG_PRIVATE_AUD )
+        if( p_sys->pp_sps[i] )
+            i_ps += p_sys->pp_sps[i]->i_buffer;
+    }
+    for( int i = 0; i < H264_PPS_MAX && b_pps; i++ )
+    {
+        if( p_sys->pp_pps[i] )
+            i_ps += p_sys->pp_pps[i]->i_buffer;
+    }
+
+    if( i_ps > 0 )
+    {
+        /* Insert them after the AUD, and keep that much room in front of
+         * the next units so that it does not take a copy */
+        if( p_sys->au.i_headroom < i_ps )
+            p_sys->au.i_headroom = i_ps;
+        p_pic = block_Realloc( p_pic, i_ps, p_pic->i_buffer );
+        if( !p_pic )
         {
-            p_head = p_sys->p_frame;
-            p_sys->p_frame = p_sys->p_frame->p_next;
-            if( p_sys->p_frame == NULL )
-                p_sys->pp_frame_last = &p_sys->p_frame;
-            p_head->p_next = NULL;
+            ResetOutputVariables( p_sys );
+            return NULL;
         }
 
-        block_t *p_list = NULL;
-        block_t **pp_list_tail = &p_list;
-        for( int i = 0; i < H264_SPS_MAX && (b_sps_pps_i || p_sys->b_frame_sps); i++ )
+        uint8_t *p = p_pic->p_buffer;
+        memmove( p, &p[i_ps], p_sys->i_frame_aud );
+        p += p_sys->i_frame_aud;
+        for( int i = 0; i < H264_SPS_MAX && b_sps; i++ )
         {
             if( p_sys->pp_sps[i] )
-                block_ChainLastAppend( &pp_list_tail, block_Duplicate( p_sys->pp_sps[i] ) );
+            {
+                memcpy( p, p_sys->pp_sps[i]->p_buffer, p_sys->pp_sps[i]->i_buffer );
+                p += p_sys->pp_sps[i]->i_buffer;
+            }
         }
-        for( int i = 0; i < H264_PPS_MAX && (b_sps_pps_i || p_sys->b_frame_pps); i++ )
+        for( int i = 0; i < H264_PPS_MAX && b_pps; i++ )
         {
             if( p_sys->pp_pps[i] )
-                block_ChainLastAppend( &pp_list_tail, block_Duplicate( p_sys->pp_pps[i] ) );
+            {
+                memcpy( p, p_sys->pp_pps[i]->p_buffer, p_sys->pp_pps[i]->i_buffer );
+                p += p_sys->pp_pps[i]->i_buffer;
+            }
         }
-        if( b_sps_pps_i && p_list )
-            p_sys->b_header = true;
-
-        if( p_list )
-            block_ChainAppend( &p_head, p_list );
-
-        if( p_sys->p_frame )
-            block_ChainAppend( &p_head, p_sys->p_frame );
 
-        p_pic = block_ChainGather( p_head );
-    }
-    else
-    {
-        p_pic = block_ChainGather( p_sys->p_frame );
+        if( b_sps_pps_i )
+            p_sys->b_header = true;
     }
 
     unsigned i_num_clock_ts = 2;
@@ -683,24 +708,27 @@ static block_t *OutputPicture( decoder_t *p_dec )
     p_sys->i_prev_pts = p_pic->i_pts;
 
     p_pic->i_flags |= p_sys->slice.i_frame_type;
-    p_pic->i_flags &= ~BLOCK_FLAG_PRIVATE_AUD;
     if( !p_sys->b_header )
         p_pic->i_flags |= BLOCK_FLAG_PREROLL;
 
     /* reset after output */
+    ResetOutputVariables( p_sys );
+
+    /* CC */
+    cc_storage_commit( p_sys->p_ccs, p_pic );
+
+    return p_pic;
+}
+
+static void ResetOutputVariables( decoder_sys_t *p_sys )
+{
     p_sys->i_frame_dts = VLC_TS_INVALID;
     p_sys->i_frame_pts = VLC_TS_INVALID;
     p_sys->slice.i_frame_type = 0;
-    p_sys->p_frame = NULL;
-    p_sys->pp_frame_last = &p_sys->p_frame;
+    p_sys->i_frame_aud = 0;
     p_sys->b_frame_sps = false;
     p_sys->b_frame_pps = false;
     p_sys->b_slice = false;
-
-    /* CC */
-    cc_storage_commit( p_sys->p_ccs, p_pic );
-
-    return p_pic;
 }
 
 static void PutSPS( decoder_t *p_dec, block_t *p_frag )
@@ -717,7 +745,6 @@ static void PutSPS( decoder_t *p_dec, block_t *p_frag )
     if( !p_sps )
     {
         msg_Warn( p_dec, "invalid SPS" );
-        block_Release( p_frag );
         return;
     }
 
@@ -772,7 +799,7 @@ static void PutSPS( decoder_t *p_dec, block_t *p_frag )
 
     if( p_sys->pp_sps[p_sps->i_id] )
         block_Release( p_sys->pp_sps[p_sps->i_id] );
-    p_sys->pp_sps[p_sps->i_id] = p_frag;
+    p_sys->pp_sps[p_sps->i_id] = block_Duplicate( p_frag );
 
     h264_release_sps( p_sps );
 }
@@ -790,7 +817,6 @@ static void PutPPS( decoder_t *p_dec, block_t *p_frag )
     if( !p_pps )
     {
         msg_Warn( p_dec, "invalid PPS" );
-        block_Release( p_frag );
         return;
     }
     p_sys->i_pic_order_present_flag = p_pps->i_pic_order_present_flag;
@@ -802,7 +828,7 @@ static void PutPPS( decoder_t *p_dec, block_t *p_frag )
 
     if( p_sys->pp_pps[p_pps->i_id] )
         block_Release( p_sys->pp_pps[p_pps->i_id] );
-    p_sys->pp_pps[p_pps->i_id] = p_frag;
+    p_sys->pp_pps[p_pps->i_id] = block_Duplicate( p_frag );
 
     h264_release_pps( p_pps );
 }
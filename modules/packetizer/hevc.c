@@ -68,6 +68,7 @@ static void PacketizeReset(void *p_private, bool b_broken);
 static block_t *PacketizeParse(void *p_private, bool *pb_ts_used, block_t *);
 static block_t *ParseNALBlock(decoder_t *, bool *pb_ts_used, block_t *);
 static int PacketizeValidate(void *p_private, block_t *);
+static block_t *PacketizeAlloc(void *p_private, size_t);
 static bool ParseSEICallback( const hxxx_sei_data_t *, void * );
 static block_t *GetCc( decoder_t *, bool pb_present[4] );
 
@@ -76,11 +77,10 @@ struct decoder_sys_t
     /* */
     packetizer_t packetizer;
 
-    struct
-    {
-        block_t *p_chain;
-        block_t **pp_chain_last;
-    } frame, pre, post;
+    /* prefix, VCL and suffix NALs of the access unit, as they come */
+    hxxx_au_t au;
+    bool     b_pre, b_frame, b_post;
+    uint32_t i_frame_flags;
 
     uint8_t  i_nal_length_size;
     hevc_video_parameter_set_t    *rgi_p_decvps[HEVC_VPS_MAX];
@@ -96,52 +96,29 @@ static const uint8_t p_hevc_startcode[3] = {0x00, 0x00, 0x01};
 /****************************************************************************
  * Helpers
  ****************************************************************************/
-static inline void InitQueue( block_t **pp_head, block_t ***ppp_tail )
+static void QueueNAL(decoder_sys_t *p_sys, bool *pb_queued, block_t *p_nalb)
 {
-    *pp_head = NULL;
-    *ppp_tail = pp_head;
+    /* Because the access unit only keeps the flags of its first NAL */
+    if(!*pb_queued)
+        p_sys->i_frame_flags |= p_nalb->i_flags;
+    *pb_queued = true;
+    hxxx_au_append(&p_sys->au, p_nalb);
 }
-#define INITQ(name) InitQueue(&p_sys->name.p_chain, &p_sys->name.pp_chain_last)
 
-static block_t * OutputQueues(decoder_sys_t *p_sys, bool b_valid)
+static block_t * OutputAU(decoder_sys_t *p_sys, bool b_valid)
 {
-    block_t *p_output = NULL;
-    block_t **pp_output_last = &p_output;
-    uint32_t i_flags = 0; /* Because block_ChainGather does not merge flags or times */
-
-    if(p_sys->pre.p_chain)
-    {
-        i_flags |= p_sys->pre.p_chain->i_flags;
-        block_ChainLastAppend(&pp_output_last, p_sys->pre.p_chain);
-        INITQ(pre);
-    }
-
-    if(p_sys->frame.p_chain)
-    {
-        i_flags |= p_sys->frame.p_chain->i_flags;
-        if(p_output && p_output->i_dts == 0)
-        {
-            p_output->i_dts = p_sys->frame.p_chain->i_dts;
-            p_output->i_pts = p_sys->frame.p_chain->i_pts;
-        }
-        block_ChainLastAppend(&pp_output_last, p_sys->frame.p_chain);
-        INITQ(frame);
-    }
-
-    if(p_sys->post.p_chain)
-    {
-        i_flags |= p_sys->post.p_chain->i_flags;
-        block_ChainLastAppend(&pp_output_last, p_sys->post.p_chain);
-        INITQ(post);
-    }
+    block_t *p_output = hxxx_au_output(&p_sys->au);
 
     if(p_output)
     {
-        p_output->i_flags |= i_flags;
+        p_output->i_flags |= p_sys->i_frame_flags;
         if(!b_valid)
             p_output->i_flags |= BLOCK_FLAG_CORRUPTED;
     }
 
+    p_sys->b_pre = p_sys->b_frame = p_sys->b_post = false;
+    p_sys->i_frame_flags = 0;
+
     return p_output;
 }
 
@@ -168,14 +145,13 @@ static int Open(vlc_object_t *p_this)
         return VLC_ENOMEM;
     }
 
-    INITQ(pre);
-    INITQ(frame);
-    INITQ(post);
+    hxxx_au_init(&p_sys->au);
 
     packetizer_Init(&p_dec->p_sys->packetizer,
                     p_hevc_startcode, sizeof(p_hevc_startcode), startcode_FindAnnexB,
                     p_hevc_startcode, 1, 5,
                     PacketizeReset, PacketizeParse, PacketizeValidate, p_dec);
+    p_sys->packetizer.pf_alloc = PacketizeAlloc;
 
     /* Copy properties */
     es_format_Copy(&p_dec->fmt_out, &p_dec->fmt_in);
@@ -226,9 +202,7 @@ static void Close(vlc_object_t *p_this)
     decoder_sys_t *p_sys = p_dec->p_sys;
     packetizer_Clean(&p_sys->packetizer);
 
-    block_ChainRelease(p_sys->frame.p_chain);
-    block_ChainRelease(p_sys->pre.p_chain);
-    block_ChainRelease(p_sys->post.p_chain);
+    hxxx_au_clean(&p_sys->au);
 
     for(unsigned i=0;i<HEVC_PPS_MAX; i++)
     {
@@ -260,7 +234,7 @@ static block_t *PacketizeHVC1(decoder_t *p_dec, block_t **pp_block)
 {
     decoder_sys_t *p_sys = p_dec->p_sys;
 
-    return PacketizeXXC1( p_dec, p_sys->i_nal_length_size,
+    return PacketizeXXC1( p_dec, &p_sys->au, p_sys->i_nal_length_size,
                           pp_block, ParseNALBlock );
 }
 
@@ -296,9 +270,9 @@ static void PacketizeReset(void *p_private, bool b_broken)
     decoder_t *p_dec = p_private;
     decoder_sys_t *p_sys = p_dec->p_sys;
 
-    block_t *p_out = OutputQueues(p_sys, false);
+    block_t *p_out = OutputAU(p_sys, false);
     if(p_out)
-        block_ChainRelease(p_out);
+        block_Release(p_out);
 
     p_sys->b_init_sequence_complete = false;
 }
@@ -412,7 +386,7 @@ static block_t *ParseVCL(decoder_t *p_dec, uint8_t i_nal_type, block_t *p_frag)
 
     if(unlikely(!hxxx_strip_AnnexB_startcode(&p_buffer, &i_buffer) || i_buffer < 3))
     {
-        block_ChainAppend(&p_sys->frame.p_chain, p_frag); /* might be corrupted */
+        QueueNAL(p_sys, &p_sys->b_frame, p_frag); /* might be corrupted */
         return NULL;
     }
 
@@ -420,12 +394,6 @@ static block_t *ParseVCL(decoder_t *p_dec, uint8_t i_nal_type, block_t *p_frag)
     bool b_first_slice_in_pic = p_buffer[2] & 0x80;
     if (b_first_slice_in_pic)
     {
-        if(p_sys->frame.p_chain)
-        {
-            /* Starting new frame: return previous frame data for output */
-            p_outputchain = OutputQueues(p_sys, p_sys->b_init_sequence_complete);
-        }
-
         switch(i_nal_type)
         {
             case HEVC_NAL_BLA_W_LP:
@@ -457,6 +425,13 @@ static block_t *ParseVCL(decoder_t *p_dec, uint8_t i_nal_type, block_t *p_frag)
             }
             break;
         }
+
+        /* Not before, as the output moves the pending NAL */
+        if(p_sys->b_frame)
+        {
+            /* Starting new frame: return previous frame data for output */
+            p_outputchain = OutputAU(p_sys, p_sys->b_init_sequence_complete);
+        }
     }
 
     if(!p_sys->b_init_sequence_complete && i_layer == 0 &&
@@ -468,7 +443,7 @@ static block_t *ParseVCL(decoder_t *p_dec, uint8_t i_nal_type, block_t *p_frag)
     if( !p_sys->b_init_sequence_complete )
         cc_storage_reset( p_sys->p_ccs );
 
-    block_ChainLastAppend(&p_sys->frame.pp_chain_last, p_frag);
+    QueueNAL(p_sys, &p_sys->b_frame, p_frag);
 
     return p_outputchain;
 }
@@ -478,14 +453,14 @@ static block_t * ParseAUHead(decoder_t *p_dec, uint8_t i_nal_type, block_t *p_na
     decoder_sys_t *p_sys = p_dec->p_sys;
     block_t *p_ret = NULL;
 
-    if(p_sys->post.p_chain || p_sys->frame.p_chain)
-        p_ret = OutputQueues(p_sys, true);
+    if(p_sys->b_post || p_sys->b_frame)
+        p_ret = OutputAU(p_sys, true);
 
     switch(i_nal_type)
     {
         case HEVC_NAL_AUD:
-            if(!p_ret && p_sys->pre.p_chain)
-                p_ret = OutputQueues(p_sys, true);
+            if(!p_ret && p_sys->b_pre)
+                p_ret = OutputAU(p_sys, true);
             break;
 
         case HEVC_NAL_VPS:
@@ -551,7 +526,7 @@ static block_t * ParseAUHead(decoder_t *p_dec, uint8_t i_nal_type, block_t *p_na
             break;
     }
 
-    block_ChainLastAppend(&p_sys->pre.pp_chain_last, p_nalb);
+    QueueNAL(p_sys, &p_sys->b_pre, p_nalb);
 
     return p_ret;
 }
@@ -561,23 +536,22 @@ static block_t * ParseAUTail(decoder_t *p_dec, uint8_t i_nal_type, block_t *p_na
     decoder_sys_t *p_sys = p_dec->p_sys;
     block_t *p_ret = NULL;
 
-    block_ChainLastAppend(&p_sys->post.pp_chain_last, p_nalb);
+    if(i_nal_type == HEVC_NAL_SUFF_SEI)
+        HxxxParse_AnnexB_SEI( p_nalb->p_buffer, p_nalb->i_buffer,
+                              2 /* nal header */, ParseSEICallback, p_dec );
+
+    QueueNAL(p_sys, &p_sys->b_post, p_nalb);
 
     switch(i_nal_type)
     {
         case HEVC_NAL_EOS:
         case HEVC_NAL_EOB:
-            p_ret = OutputQueues(p_sys, true);
-            break;
-
-        case HEVC_NAL_SUFF_SEI:
-            HxxxParse_AnnexB_SEI( p_nalb->p_buffer, p_nalb->i_buffer,
-                                  2 /* nal header */, ParseSEICallback, p_dec );
+            p_ret = OutputAU(p_sys, true);
             break;
     }
 
-    if(!p_ret && p_sys->frame.p_chain == NULL)
-        p_ret = OutputQueues(p_sys, false);
+    if(!p_ret && !p_sys->b_frame)
+        p_ret = OutputAU(p_sys, false);
 
     return p_ret;
 }
@@ -601,21 +575,11 @@ static block_t * ParseNonVCL(decoder_t *p_dec, uint8_t i_nal_type, block_t *p_na
     return p_ret;
 }
 
-static block_t *GatherAndValidateChain(block_t *p_outputchain)
+static block_t *ValidateOutput(block_t *p_output)
 {
-    block_t *p_output = NULL;
-
-    if(p_outputchain)
-    {
-        if(p_outputchain->i_flags & BLOCK_FLAG_CORRUPTED)
-            p_output = p_outputchain; /* Avoid useless gather */
-        else
-            p_output = block_ChainGather(p_outputchain);
-    }
-
     if(p_output && (p_output->i_flags & BLOCK_FLAG_CORRUPTED))
     {
-        block_ChainRelease(p_output); /* Chain! see above */
+        block_Release(p_output);
         p_output = NULL;
     }
 
@@ -643,7 +607,7 @@ static block_t *ParseNALBlock(decoder_t *p_dec, bool *pb_ts_used, block_t *p_fra
         msg_Warn(p_dec,"Forbidden zero bit not null, corrupted NAL");
         block_Release(p_frag);
         *pb_ts_used = false;
-        return GatherAndValidateChain(OutputQueues(p_sys, false)); /* will drop */
+        return ValidateOutput(OutputAU(p_sys, false)); /* will drop */
     }
 
     /* Get NALU type */
@@ -661,7 +625,7 @@ static block_t *ParseNALBlock(decoder_t *p_dec, bool *pb_ts_used, block_t *p_fra
         p_output = ParseNonVCL(p_dec, i_nal_type, p_frag);
     }
 
-    p_output = GatherAndValidateChain(p_output);
+    p_output = ValidateOutput(p_output);
     *pb_ts_used = (p_output != NULL);
     return p_output;
 }
@@ -689,6 +653,14 @@ static int PacketizeValidate( void *p_private, block_t *p_au )
     return VLC_SUCCESS;
 }
 
+static block_t *PacketizeAlloc(void *p_private, size_t i_size)
+{
+    decoder_t *p_dec = p_private;
+
+    /* Cut the NALs straight into the access unit */
+    return hxxx_au_alloc(&p_dec->p_sys->au, i_size);
+}
+
 static bool ParseSEICallback( const hxxx_sei_data_t *p_sei_data, void *cbdata )
 {
     decoder_t *p_dec = (decoder_t *) cbdata;
@@ -21,6 +21,8 @@
 # include "config.h"
 #endif
 
+#include <assert.h>
+
 #include "hxxx_common.h"
 
 #include <vlc_block.h>
@@ -103,12 +105,203 @@ block_t * cc_storage_get_current( cc_storage_t *p_ccs, bool pb_present[4] )
     return p_block;
 }
 
+/****************************************************************************
+ * Access unit assembly
+ ****************************************************************************/
+static void hxxx_au_frag_release( block_t *p_frag )
+{
+    hxxx_au_t *p_au = (hxxx_au_t *)((uint8_t *)p_frag - offsetof(hxxx_au_t, frag));
+
+    assert( p_au->b_frag );
+    p_au->b_frag = false;
+}
+
+void hxxx_au_init( hxxx_au_t *p_au )
+{
+    p_au->p_block = NULL;
+    p_au->b_frag = false;
+    p_au->i_size_hint = 0;
+    p_au->i_headroom = 0;
+}
+
+void hxxx_au_clean( hxxx_au_t *p_au )
+{
+    assert( !p_au->b_frag );
+    if( p_au->p_block )
+        block_Release( p_au->p_block );
+}
+
+/* Makes room for i_extra bytes after the assembled NALs, overwriting the
+ * pending one */
+static bool hxxx_au_reserve( hxxx_au_t *p_au, size_t i_extra )
+{
+    block_t *p_block = p_au->p_block;
+    size_t i_used = 0;
+
+    if( p_block )
+    {
+        i_used = p_block->i_buffer;
+        if( (size_t)(&p_block->p_start[p_block->i_size] - p_block->p_buffer)
+             - i_used >= i_extra )
+            return true;
+    }
+
+    if( unlikely(i_extra > SIZE_MAX / 2 - i_used) )
+        return false;
+
+    /* Grow geometrically past the size of the previous units */
+    size_t i_size = __MAX( p_au->i_size_hint, (i_used + i_extra) * 3 / 2 );
+    block_t *p_new = block_Alloc( p_au->i_headroom + i_size );
+    if( unlikely(p_new == NULL) )
+        return false;
+
+    p_new->p_buffer += p_au->i_headroom;
+    p_new->i_buffer = i_used;
+    if( p_block )
+    {
+        memcpy( p_new->p_buffer, p_block->p_buffer, i_used );
+        block_CopyProperties( p_new, p_block );
+        block_Release( p_block );
+    }
+    p_au->p_block = p_new;
+    return true;
+}
+
+block_t *hxxx_au_alloc( hxxx_au_t *p_au, size_t i_size )
+{
+    assert( !p_au->b_frag );
+    if( unlikely(!hxxx_au_reserve( p_au, i_size )) )
+        return NULL;
+
+    block_t *p_block = p_au->p_block;
+    block_t *p_frag = &p_au->frag;
+
+    block_Init( p_frag, &p_block->p_buffer[p_block->i_buffer], i_size );
+    p_frag->pf_release = hxxx_au_frag_release;
+    p_au->b_frag = true;
+    return p_frag;
+}
+
+void hxxx_au_append( hxxx_au_t *p_au, block_t *p_frag )
+{
+    const bool b_own = p_frag == &p_au->frag;
+
+    if( b_own )
+    {
+        assert( p_au->b_frag );
+        p_au->b_frag = false;
+    }
+    else
+    {
+        assert( !p_au->b_frag );
+        if( unlikely(!hxxx_au_reserve( p_au, p_frag->i_buffer )) )
+        {
+            block_Release( p_frag );
+            return;
+        }
+    }
+
+    block_t *p_block = p_au->p_block;
+    uint8_t *p_end = &p_block->p_buffer[p_block->i_buffer];
+
+    if( !b_own )
+        memcpy( p_end, p_frag->p_buffer, p_frag->i_buffer );
+    else if( p_frag->p_buffer != p_end )
+        memmove( p_end, p_frag->p_buffer, p_frag->i_buffer );
+
+    /* The unit takes the properties of its first NAL, and the timestamps
+     * of the first one having some */
+    if( p_block->i_buffer == 0 )
+        block_CopyProperties( p_block, p_frag );
+    else if( p_block->i_dts <= VLC_TS_INVALID &&
+             p_block->i_pts <= VLC_TS_INVALID )
+    {
+        p_block->i_dts = p_frag->i_dts;
+        p_block->i_pts = p_frag->i_pts;
+    }
+    if( p_block->i_buffer > 0 )
+        p_block->i_length += p_frag->i_length;
+    p_block->i_buffer += p_frag->i_buffer;
+
+    if( !b_own )
+        block_Release( p_frag );
+}
+
+block_t *hxxx_au_output( hxxx_au_t *p_au )
+{
+    block_t *p_block = p_au->p_block;
+
+    if( hxxx_au_empty( p_au ) )
+        return NULL;
+
+    /* Leave some margin for the next units */
+    p_au->i_size_hint = p_block->i_buffer + p_block->i_buffer / 4;
+
+    if( !p_au->b_frag )
+    {
+        p_au->p_block = NULL;
+        return p_block;
+    }
+
+    /* The pending NAL starts the next unit: copy out whichever is smaller,
+     * the pending NAL into a new buffer, or the unit */
+    block_t *p_frag = &p_au->frag;
+    block_t *p_out;
+
+    if( p_frag->i_buffer < p_block->i_buffer )
+    {
+        p_au->p_block = NULL;
+        if( unlikely(!hxxx_au_reserve( p_au, p_frag->i_buffer )) )
+        {
+            p_au->p_block = p_block;
+            goto error;
+        }
+
+        uint8_t *p_dst = p_au->p_block->p_buffer;
+        memcpy( p_dst, p_frag->p_buffer, p_frag->i_buffer );
+        p_frag->p_start = p_frag->p_buffer = p_dst;
+        p_frag->i_size = p_frag->i_buffer;
+        p_out = p_block;
+    }
+    else
+    {
+        p_out = block_Alloc( p_au->i_headroom + p_block->i_buffer );
+        if( unlikely(p_out == NULL) )
+            goto error;
+
+        p_out->p_buffer += p_au->i_headroom;
+        p_out->i_buffer = p_block->i_buffer;
+        memcpy( p_out->p_buffer, p_block->p_buffer, p_block->i_buffer );
+        block_CopyProperties( p_out, p_block );
+
+        p_block->p_buffer = p_frag->p_buffer;
+        p_block->i_buffer = 0;
+    }
+    return p_out;
+
+error:
+    hxxx_au_reset( p_au );
+    return NULL;
+}
+
+void hxxx_au_reset( hxxx_au_t *p_au )
+{
+    block_t *p_block = p_au->p_block;
+
+    if( p_block == NULL )
+        return;
+
+    if( p_au->b_frag )
+        p_block->p_buffer = p_au->frag.p_buffer;
+    p_block->i_buffer = 0;
+}
+
 /****************************************************************************
  * PacketizeXXC1: Takes VCL blocks of data and creates annexe B type NAL stream
  * Will always use 4 byte 0 0 0 1 startcodes
  * Will prepend a SPS and PPS before each keyframe
  ****************************************************************************/
-block_t *PacketizeXXC1( decoder_t *p_dec, uint8_t i_nal_length_size,
+block_t *PacketizeXXC1( decoder_t *p_dec, hxxx_au_t *p_au, uint8_t i_nal_length_size,
                         block_t **pp_block, pf_annexb_nal_packetizer pf_nal_parser )
 {
     block_t       *p_block;
@@ -147,52 +340,37 @@ block_t *PacketizeXXC1( decoder_t *p_dec, uint8_t i_nal_length_size,
             break;
         }
 
-        /* Convert AVC to AnnexB */
-        block_t *p_nal;
-        /* If data exactly match remaining bytes (1 NAL only or trailing one) */
-        if( i_size == p_block->p_buffer + p_block->i_buffer - p )
-        {
-            p_block->i_buffer = i_size;
-            p_block->p_buffer = p;
-            p_nal = block_Realloc( p_block, 4, i_size );
-            if( p_nal )
-                p_block = NULL;
-        }
-        else
-        {
-            p_nal = block_Alloc( 4 + i_size );
-            if( p_nal )
-            {
-                p_nal->i_dts = p_block->i_dts;
-                p_nal->i_pts = p_block->i_pts;
-                /* Copy nalu */
-                memcpy( &p_nal->p_buffer[4], p, i_size );
-            }
-            p += i_size;
-        }
-
+        /* Convert AVC to AnnexB, straight into the access unit */
+        block_t *p_nal = hxxx_au_alloc( p_au, 4 + i_size );
         if( !p_nal )
             break;
 
+        p_nal->i_dts = p_block->i_dts;
+        p_nal->i_pts = p_block->i_pts;
+
         /* Add start code */
         p_nal->p_buffer[0] = 0x00;
         p_nal->p_buffer[1] = 0x00;
         p_nal->p_buffer[2] = 0x00;
         p_nal->p_buffer[3] = 0x01;
 
+        /* Copy nalu */
+        memcpy( &p_nal->p_buffer[4], p, i_size );
+        p += i_size;
+
+        /* The last one keeps the flags of the sample */
+        if( p == &p_block->p_buffer[p_block->i_buffer] )
+            p_nal->i_flags = p_block->i_flags;
+
         /* Parse the NAL */
         block_t *p_pic;
         if( ( p_pic = pf_nal_parser( p_dec, &b_dummy, p_nal ) ) )
         {
             block_ChainAppend( &p_ret, p_pic );
         }
-
-        if( !p_block )
-            break;
     }
 
-    if( p_block )
-        block_Release( p_block );
+    block_Release( p_block );
 
     return p_ret;
 }
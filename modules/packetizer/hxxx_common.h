@@ -21,6 +21,7 @@
 #define HXXX_COMMON_H
 
 #include <vlc_common.h>
+#include <vlc_block.h>
 
 /* */
 typedef struct cc_storage_t cc_storage_t;
@@ -35,10 +36,44 @@ void cc_storage_commit( cc_storage_t *p_ccs, block_t *p_pic );
 
 block_t * cc_storage_get_current( cc_storage_t *p_ccs, bool pb_present[4] );
 
+/* Access unit assembly
+ *
+ * NALs are cut straight into the tail of the access unit buffer, which is
+ * allocated from the size of the previous access units, so that the whole
+ * unit is output without gathering a chain of NALs.
+ * hxxx_au_alloc() returns the pending NAL, which the caller either appends
+ * with hxxx_au_append() or drops with block_Release(). Only one may be
+ * pending at a time, and it must be duplicated to be kept otherwise. */
+typedef struct
+{
+    block_t *p_block;       /* assembled NALs, followed by the pending one */
+    block_t  frag;          /* pending NAL */
+    bool     b_frag;
+    size_t   i_size_hint;   /* from the previous access units */
+    size_t   i_headroom;    /* reserved in front of the output units */
+} hxxx_au_t;
+
+void hxxx_au_init( hxxx_au_t *p_au );
+void hxxx_au_clean( hxxx_au_t *p_au );
+
+block_t *hxxx_au_alloc( hxxx_au_t *p_au, size_t i_size );
+void hxxx_au_append( hxxx_au_t *p_au, block_t *p_frag );
+/* Returns the assembled NALs, or NULL if there are none; the pending NAL
+ * is kept (but may have moved) */
+block_t *hxxx_au_output( hxxx_au_t *p_au );
+/* Drops the assembled NALs, but not the pending one */
+void hxxx_au_reset( hxxx_au_t *p_au );
+
+static inline bool hxxx_au_empty( const hxxx_au_t *p_au )
+{
+    return p_au->p_block == NULL || p_au->p_block->i_buffer == 0;
+}
+
 /* */
 
 typedef block_t * (*pf_annexb_nal_packetizer)(decoder_t *, bool *, block_t *);
-block_t *PacketizeXXC1( decoder_t *, uint8_t, block_t **, pf_annexb_nal_packetizer );
+block_t *PacketizeXXC1( decoder_t *, hxxx_au_t *, uint8_t, block_t **,
+                        pf_annexb_nal_packetizer );
 
 #endif // HXXX_COMMON_H
 
@@ -39,6 +39,7 @@ enum
 typedef void (*packetizer_reset_t)( void *p_private, bool b_broken );
 typedef block_t *(*packetizer_parse_t)( void *p_private, bool *pb_ts_used, block_t * );
 typedef int (*packetizer_validate_t)( void *p_private, block_t * );
+typedef block_t *(*packetizer_alloc_t)( void *p_private, size_t );
 
 typedef struct
 {
@@ -60,6 +61,8 @@ typedef struct
     packetizer_reset_t    pf_reset;
     packetizer_parse_t    pf_parse;
     packetizer_validate_t pf_validate;
+    /* Optional, lets the packetizer provide the storage of the next fragment */
+    packetizer_alloc_t    pf_alloc;
 
 } packetizer_t;
 
@@ -88,6 +91,7 @@ static inline void packetizer_Init( packetizer_t *p_pack,
     p_pack->pf_reset = pf_reset;
     p_pack->pf_parse = pf_parse;
     p_pack->pf_validate = pf_validate;
+    p_pack->pf_alloc = NULL;
     p_pack->p_private = p_private;
 }
 
@@ -175,7 +179,18 @@ static inline block_t *packetizer_Packetize( packetizer_t *p_pack, block_t **pp_
             /* Get the new fragment and set the pts/dts */
             block_t *p_block_bytestream = p_pack->bytestream.p_block;
 
-            p_pic = block_Alloc( p_pack->i_offset + p_pack->i_au_prepend );
+            if( p_pack->pf_alloc )
+                p_pic = p_pack->pf_alloc( p_pack->p_private,
+                                          p_pack->i_offset + p_pack->i_au_prepend );
+            else
+                p_pic = block_Alloc( p_pack->i_offset + p_pack->i_au_prepend );
+            if( unlikely(!p_pic) )
+            {
+                block_SkipBytes( &p_pack->bytestream, p_pack->i_offset );
+                p_pack->i_offset = 0;
+                p_pack->i_state = STATE_NOSYNC;
+                break;
+            }
             p_pic->i_pts = p_block_bytestream->i_pts;
             p_pic->i_dts = p_block_bytestream->i_dts;
 
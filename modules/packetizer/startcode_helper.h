@@ -26,6 +26,17 @@
    #include <emmintrin.h>
 #endif
 
+#if defined(HAVE_SSE2_INTRINSICS) && (defined(__i386__) || defined(__x86_64__)) \
+ && (defined(__AVX2__) || VLC_GCC_VERSION(4, 9) || defined(__clang__))
+   #include <immintrin.h>
+   #define STARTCODE_AVX2 1
+#endif
+
+#if defined(__ARM_NEON__) || defined(__aarch64__)
+   #include <arm_neon.h>
+   #define STARTCODE_NEON 1
+#endif
+
 /* Looks up efficiently for an AnnexB startcode 0x00 0x00 0x01
  * by using a 4 times faster trick than single byte lookup. */
 
@@ -109,16 +120,88 @@ static inline const uint8_t * startcode_FindAnnexB_SSE2( const uint8_t *p, const
 
 #endif
 
+/* The wide versions compare every position and the next two ones at once,
+ * using unaligned loads, instead of looking up the zero bytes first.
+ * As in the other versions, a startcode must be followed by at least
+ * one byte to be returned. */
+
+#ifdef STARTCODE_AVX2
+
+VLC_AVX2
+static inline const uint8_t * startcode_FindAnnexB_AVX2( const uint8_t *p, const uint8_t *end )
+{
+    if( end - p > 34 )
+    {
+        const __m256i zeros = _mm256_setzero_si256();
+        const __m256i ones = _mm256_set1_epi8( 0x01 );
+
+        for( ; p < end - 34; p += 32 )
+        {
+            __m256i v0 = _mm256_loadu_si256( (const __m256i *)(p + 0) );
+            __m256i v1 = _mm256_loadu_si256( (const __m256i *)(p + 1) );
+            __m256i v2 = _mm256_loadu_si256( (const __m256i *)(p + 2) );
+            __m256i res = _mm256_and_si256( _mm256_cmpeq_epi8( v0, zeros ),
+                                            _mm256_cmpeq_epi8( v1, zeros ) );
+            res = _mm256_and_si256( res, _mm256_cmpeq_epi8( v2, ones ) );
+
+            uint32_t match = _mm256_movemask_epi8( res );
+            if( match )
+                return p + ctz( match );
+        }
+    }
+
+    for (end -= 3; p < end; p++) {
+        if (p[0] == 0 && p[1] == 0 && p[2] == 1)
+            return p;
+    }
+
+    return NULL;
+}
+
+#endif
+
+#ifdef STARTCODE_NEON
+
+static inline const uint8_t * startcode_FindAnnexB_NEON( const uint8_t *p, const uint8_t *end )
+{
+    if( end - p > 18 )
+    {
+        const uint8x16_t zeros = vdupq_n_u8( 0x00 );
+        const uint8x16_t ones = vdupq_n_u8( 0x01 );
+
+        for( ; p < end - 18; p += 16 )
+        {
+            uint8x16_t res = vandq_u8( vceqq_u8( vld1q_u8( p + 0 ), zeros ),
+                                       vceqq_u8( vld1q_u8( p + 1 ), zeros ) );
+            res = vandq_u8( res, vceqq_u8( vld1q_u8( p + 2 ), ones ) );
+
+            uint64x2_t match = vreinterpretq_u64_u8( res );
+            if( vgetq_lane_u64( match, 0 ) | vgetq_lane_u64( match, 1 ) )
+            {
+                /* startcodes are sparse: look the position up bytewise */
+                while( p[0] != 0 || p[1] != 0 || p[2] != 1 )
+                    p++;
+                return p;
+            }
+        }
+    }
+
+    for (end -= 3; p < end; p++) {
+        if (p[0] == 0 && p[1] == 0 && p[2] == 1)
+            return p;
+    }
+
+    return NULL;
+}
+
+#endif
+
 /* That code is adapted from libav's ff_avc_find_startcode_internal
  * and i believe the trick originated from
  * https://graphics.stanford.edu/~seander/bithacks.html#ZeroInWord
  */
-static inline const uint8_t * startcode_FindAnnexB( const uint8_t *p, const uint8_t *end )
+static inline const uint8_t * startcode_FindAnnexB_C( const uint8_t *p, const uint8_t *end )
 {
-#if defined(CAN_COMPILE_SSE2) || defined(HAVE_SSE2_INTRINSICS)
-    if (vlc_CPU_SSE2())
-        return startcode_FindAnnexB_SSE2(p, end);
-#endif
     const uint8_t *a = p + 4 - ((intptr_t)p & 3);
 
     for (end -= 3; p < a && p < end; p++) {
@@ -143,6 +226,27 @@ static inline const uint8_t * startcode_FindAnnexB( const uint8_t *p, const uint
     return NULL;
 }
 
+static inline const uint8_t * startcode_FindAnnexB( const uint8_t *p, const uint8_t *end )
+{
+#ifdef STARTCODE_AVX2
+    if (vlc_CPU_AVX2())
+        return startcode_FindAnnexB_AVX2(p, end);
+#endif
+#if defined(CAN_COMPILE_SSE2) || defined(HAVE_SSE2_INTRINSICS)
+    if (vlc_CPU_SSE2())
+        return startcode_FindAnnexB_SSE2(p, end);
+#endif
+#ifdef STARTCODE_NEON
+# ifdef __aarch64__
+    if (vlc_CPU_ARM64_NEON())
+# else
+    if (vlc_CPU_ARM_NEON())
+# endif
+        return startcode_FindAnnexB_NEON(p, end);
+#endif
+    return startcode_FindAnnexB_C(p, end);
+}
+
 /* Special variation to return on prefix only and no data */
 static inline const uint8_t * startcode_FindAnyAnnexB( const uint8_t *p, const uint8_t *end )
 {
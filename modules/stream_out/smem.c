@@ -363,26 +363,36 @@ static int SendVideo( sout_stream_t *p_stream, sout_stream_id_sys_t *id,
                       block_t *p_buffer )
 {
     sout_stream_sys_t *p_sys = p_stream->p_sys;
-    size_t i_size = p_buffer->i_buffer;
-    uint8_t* p_pixels = NULL;
 
-    /* Calling the prerender callback to get user buffer */
-    p_sys->pf_video_prerender_callback( id->p_data, &p_pixels, i_size );
-
-    if (!p_pixels)
+    /* Threaded encoders may hand out several pictures at once */
+    while( p_buffer != NULL )
     {
-        msg_Err( p_stream, "No buffer given!" );
-        block_ChainRelease( p_buffer );
-        return VLC_EGENERIC;
+        block_t *p_next = p_buffer->p_next;
+        size_t i_size = p_buffer->i_buffer;
+        uint8_t* p_pixels = NULL;
+
+        p_buffer->p_next = NULL;
+
+        /* Calling the prerender callback to get user buffer */
+        p_sys->pf_video_prerender_callback( id->p_data, &p_pixels, i_size );
+
+        if (!p_pixels)
+        {
+            msg_Err( p_stream, "No buffer given!" );
+            block_Release( p_buffer );
+            block_ChainRelease( p_next );
+            return VLC_EGENERIC;
+        }
+
+        /* Copying data into user buffer */
+        memcpy( p_pixels, p_buffer->p_buffer, i_size );
+        /* Calling the postrender callback to tell the user his buffer is ready */
+        p_sys->pf_video_postrender_callback( id->p_data, p_pixels,
+                                             id->format->video.i_width, id->format->video.i_height,
+                                             id->format->video.i_bits_per_pixel, i_size, p_buffer->i_pts );
+        block_Release( p_buffer );
+        p_buffer = p_next;
     }
-
-    /* Copying data into user buffer */
-    memcpy( p_pixels, p_buffer->p_buffer, i_size );
-    /* Calling the postrender callback to tell the user his buffer is ready */
-    p_sys->pf_video_postrender_callback( id->p_data, p_pixels,
-                                         id->format->video.i_width, id->format->video.i_height,
-                                         id->format->video.i_bits_per_pixel, i_size, p_buffer->i_pts );
-    block_ChainRelease( p_buffer );
     return VLC_SUCCESS;
 }
 
@@ -390,11 +400,7 @@ static int SendAudio( sout_stream_t *p_stream, sout_stream_id_sys_t *id,
                       block_t *p_buffer )
 {
     sout_stream_sys_t *p_sys = p_stream->p_sys;
-    int i_size;
-    uint8_t* p_pcm_buffer = NULL;
-    int i_samples = 0;
 
-    i_size = p_buffer->i_buffer;
     if (id->format->audio.i_channels <= 0)
     {
         msg_Warn( p_stream, "No buffer given!" );
@@ -402,23 +408,35 @@ static int SendAudio( sout_stream_t *p_stream, sout_stream_id_sys_t *id,
         return VLC_EGENERIC;
     }
 
-    i_samples = i_size / ( ( id->format->audio.i_bitspersample / 8 ) * id->format->audio.i_channels );
-    /* Calling the prerender callback to get user buffer */
-    p_sys->pf_audio_prerender_callback( id->p_data, &p_pcm_buffer, i_size );
-    if (!p_pcm_buffer)
+    while( p_buffer != NULL )
     {
-        msg_Err( p_stream, "No buffer given!" );
-        block_ChainRelease( p_buffer );
-        return VLC_EGENERIC;
+        block_t *p_next = p_buffer->p_next;
+        int i_size = p_buffer->i_buffer;
+        uint8_t* p_pcm_buffer = NULL;
+        int i_samples;
+
+        p_buffer->p_next = NULL;
+
+        i_samples = i_size / ( ( id->format->audio.i_bitspersample / 8 ) * id->format->audio.i_channels );
+        /* Calling the prerender callback to get user buffer */
+        p_sys->pf_audio_prerender_callback( id->p_data, &p_pcm_buffer, i_size );
+        if (!p_pcm_buffer)
+        {
+            msg_Err( p_stream, "No buffer given!" );
+            block_Release( p_buffer );
+            block_ChainRelease( p_next );
+            return VLC_EGENERIC;
+        }
+
+        /* Copying data into user buffer */
+        memcpy( p_pcm_buffer, p_buffer->p_buffer, i_size );
+        /* Calling the postrender callback to tell the user his buffer is ready */
+        p_sys->pf_audio_postrender_callback( id->p_data, p_pcm_buffer,
+                                             id->format->audio.i_channels, id->format->audio.i_rate, i_samples,
+                                             id->format->audio.i_bitspersample, i_size, p_buffer->i_pts );
+        block_Release( p_buffer );
+        p_buffer = p_next;
     }
-
-    /* Copying data into user buffer */
-    memcpy( p_pcm_buffer, p_buffer->p_buffer, i_size );
-    /* Calling the postrender callback to tell the user his buffer is ready */
-    p_sys->pf_audio_postrender_callback( id->p_data, p_pcm_buffer,
-                                         id->format->audio.i_channels, id->format->audio.i_rate, i_samples,
-                                         id->format->audio.i_bitspersample, i_size, p_buffer->i_pts );
-    block_ChainRelease( p_buffer );
     return VLC_SUCCESS;
 }
 
@@ -201,6 +201,89 @@ void transcode_audio_close( sout_stream_id_sys_t *id )
         aout_FiltersDelete( (vlc_object_t *)NULL, id->p_af_chain );
 }
 
+/*
+ * Renditions share the decoder and the filters, so their encoders must accept
+ * the same input as the main encoder.
+ */
+static int transcode_audio_rendition_open( sout_stream_t *p_stream,
+                                           sout_stream_id_sys_t *id,
+                                           transcode_rendition_t *r )
+{
+    const transcode_rendition_cfg_t *p_cfg = r->p_cfg;
+    encoder_t *p_enc = r->p_encoder;
+
+    es_format_Clean( &p_enc->fmt_in );
+    es_format_Init( &p_enc->fmt_in, AUDIO_ES, id->p_encoder->fmt_in.i_codec );
+    p_enc->fmt_in.audio = id->p_encoder->fmt_in.audio;
+
+    p_enc->p_cfg = p_cfg->p_audio_cfg;
+    p_enc->p_module = module_need( p_enc, "encoder", p_cfg->psz_aenc, true );
+    if( !p_enc->p_module )
+    {
+        msg_Err( p_stream, "cannot find rendition audio encoder (module:%s fourcc:%4.4s)",
+                 p_cfg->psz_aenc ? p_cfg->psz_aenc : "any",
+                 (char *)&p_cfg->i_acodec );
+        return VLC_EGENERIC;
+    }
+
+    if( p_enc->fmt_in.i_codec != id->p_encoder->fmt_in.i_codec ||
+        p_enc->fmt_in.audio.i_rate != id->p_encoder->fmt_in.audio.i_rate ||
+        p_enc->fmt_in.audio.i_physical_channels !=
+            id->p_encoder->fmt_in.audio.i_physical_channels )
+    {
+        msg_Err( p_stream, "rendition audio encoder needs a different input "
+                 "format (%4.4s), dropping it", (char *)&p_enc->fmt_in.i_codec );
+        return VLC_EGENERIC;
+    }
+
+    p_enc->fmt_out.i_codec = vlc_fourcc_GetCodec( AUDIO_ES, p_enc->fmt_out.i_codec );
+
+    r->id = sout_StreamIdAdd( p_stream->p_next, &p_enc->fmt_out );
+    if( !r->id )
+    {
+        msg_Err( p_stream, "cannot add this stream" );
+        return VLC_EGENERIC;
+    }
+    return VLC_SUCCESS;
+}
+
+static void transcode_audio_renditions_open( sout_stream_t *p_stream,
+                                             sout_stream_id_sys_t *id )
+{
+    for( int i = 0; i < id->i_renditions; )
+    {
+        transcode_rendition_t *r = id->pp_renditions[i];
+
+        if( r->p_encoder->p_module ||
+            transcode_audio_rendition_open( p_stream, id, r ) == VLC_SUCCESS )
+        {
+            i++;
+            continue;
+        }
+        TAB_ERASE( id->i_renditions, id->pp_renditions, i );
+        transcode_rendition_Delete( p_stream, r );
+    }
+}
+
+static void transcode_audio_renditions_encode( sout_stream_t *p_stream,
+                                               sout_stream_id_sys_t *id,
+                                               block_t *p_audio_buf )
+{
+    for( int i = 0; i < id->i_renditions; i++ )
+    {
+        transcode_rendition_t *r = id->pp_renditions[i];
+        block_t *p_block;
+
+        if( !r->p_encoder->p_module )
+            continue;
+        do {
+            p_block = r->p_encoder->pf_encode_audio( r->p_encoder, p_audio_buf );
+            if( p_block )
+                sout_StreamIdSend( p_stream->p_next, r->id, p_block );
+        } while( p_block && p_audio_buf == NULL );
+    }
+}
+
 int transcode_audio_process( sout_stream_t *p_stream,
                                     sout_stream_id_sys_t *id,
                                     block_t *in, block_t **out )
@@ -212,6 +295,7 @@ int transcode_audio_process( sout_stream_t *p_stream,
     if( unlikely( in == NULL ) )
     {
         block_t *p_block;
+        transcode_audio_renditions_encode( p_stream, id, NULL );
         do {
            p_block = id->p_encoder->pf_encode_audio(id->p_encoder, NULL );
            block_ChainAppend( out, p_block );
@@ -261,6 +345,8 @@ int transcode_audio_process( sout_stream_t *p_stream,
             }
             date_Init( &id->next_input_pts, id->p_decoder->fmt_out.audio.i_rate, 1 );
             date_Set( &id->next_input_pts, p_audio_buf->i_pts );
+
+            transcode_audio_renditions_open( p_stream, id );
         }
 
         /* Check if audio format has changed, and filters need reinit */
@@ -317,6 +403,8 @@ int transcode_audio_process( sout_stream_t *p_stream,
 
         p_audio_buf->i_dts = p_audio_buf->i_pts;
 
+        transcode_audio_renditions_encode( p_stream, id, p_audio_buf );
+
         p_block = id->p_encoder->pf_encode_audio( id->p_encoder, p_audio_buf );
 
         block_ChainAppend( out, p_block );
@@ -386,5 +474,23 @@ bool transcode_audio_add( sout_stream_t *p_stream, const es_format_t *p_fmt,
             aout_FiltersDelete( (vlc_object_t *)NULL, id->p_af_chain );
         id->p_af_chain = NULL;
     }
+
+    /* Renditions encoders are opened along with the main one */
+    for( int i = 0; i < p_sys->i_renditions; i++ )
+    {
+        const transcode_rendition_cfg_t *p_cfg = p_sys->pp_renditions[i];
+        transcode_rendition_t *r;
+
+        if( !p_cfg->i_acodec )
+            continue;
+        r = transcode_rendition_New( p_stream, id, p_cfg );
+        if( !r )
+            continue;
+
+        r->p_encoder->fmt_out.i_codec = p_cfg->i_acodec;
+        r->p_encoder->fmt_out.i_bitrate = p_cfg->i_abitrate;
+        r->p_encoder->fmt_out.audio = id->p_encoder->fmt_out.audio;
+        TAB_APPEND( id->i_renditions, id->pp_renditions, r );
+    }
     return true;
 }
@@ -0,0 +1,231 @@
+/*****************************************************************************
+ * rendition.c: transcoding stream output module (additional renditions)
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ * $Id$
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*****************************************************************************
+ * Preamble
+ *****************************************************************************/
+
+#include "transcode.h"
+
+#include <vlc_charset.h>
+#include <vlc_modules.h>
+
+/*
+ * A rendition is an additional encoding of a transcoded elementary stream.
+ * It shares the decoder and the filters of the stream it belongs to, and
+ * only owns an encoder (and for video a scaler) and its own output ES:
+ *
+ *   transcode{vcodec=h264,vb=4000,deinterlace,
+ *             rendition{vb=2000,width=1280},
+ *             rendition{vb=800,width=640,acodec=mp4a,ab=64}}
+ *
+ * Unset codec and encoder parameters are inherited from the main settings.
+ */
+
+static vlc_fourcc_t ParseCodec( int i_cat, const char *psz_value )
+{
+    char fcc[5] = "    \0";
+
+    memcpy( fcc, psz_value, __MIN( strlen( psz_value ), 4 ) );
+    return vlc_fourcc_GetCodecFromString( i_cat, fcc );
+}
+
+static void ParseEncoder( char **ppsz_enc, config_chain_t **pp_cfg,
+                          const char *psz_value )
+{
+    char *psz_next;
+
+    free( *ppsz_enc );
+    config_ChainDestroy( *pp_cfg );
+    *ppsz_enc = NULL;
+    *pp_cfg = NULL;
+
+    psz_next = config_ChainCreate( ppsz_enc, pp_cfg, psz_value );
+    free( psz_next );
+}
+
+transcode_rendition_cfg_t *transcode_rendition_cfg_New( sout_stream_t *p_stream,
+                                                        const sout_stream_sys_t *p_sys,
+                                                        const char *psz_value )
+{
+    transcode_rendition_cfg_t *p_cfg;
+    config_chain_t *p_chain = NULL;
+    char *psz_name = NULL, *psz_chain, *psz_next;
+    bool b_video = false, b_audio = false;
+
+    /* Accept both rendition{...} and rendition="..." */
+    if( asprintf( &psz_chain, "rendition{%s}",
+                  *psz_value == '{' ? psz_value + 1 : psz_value ) < 0 )
+        return NULL;
+    if( *psz_value == '{' )
+        psz_chain[strlen( psz_chain ) - 1] = '\0';
+
+    psz_next = config_ChainCreate( &psz_name, &p_chain, psz_chain );
+    free( psz_next );
+    free( psz_name );
+    free( psz_chain );
+
+    p_cfg = calloc( 1, sizeof( *p_cfg ) );
+    if( !p_cfg )
+    {
+        config_ChainDestroy( p_chain );
+        return NULL;
+    }
+
+    for( const config_chain_t *p = p_chain; p != NULL; p = p->p_next )
+    {
+        const char *psz = p->psz_value ? p->psz_value : "";
+
+        if( !strcmp( p->psz_name, "vcodec" ) )
+            p_cfg->i_vcodec = ParseCodec( VIDEO_ES, psz );
+        else if( !strcmp( p->psz_name, "venc" ) )
+            ParseEncoder( &p_cfg->psz_venc, &p_cfg->p_video_cfg, psz );
+        else if( !strcmp( p->psz_name, "vb" ) )
+        {
+            p_cfg->i_vbitrate = atoi( psz );
+            if( p_cfg->i_vbitrate < 16000 ) p_cfg->i_vbitrate *= 1000;
+        }
+        else if( !strcmp( p->psz_name, "scale" ) )
+            p_cfg->f_scale = us_atof( psz );
+        else if( !strcmp( p->psz_name, "width" ) )
+            p_cfg->i_width = atoi( psz );
+        else if( !strcmp( p->psz_name, "height" ) )
+            p_cfg->i_height = atoi( psz );
+        else if( !strcmp( p->psz_name, "maxwidth" ) )
+            p_cfg->i_maxwidth = atoi( psz );
+        else if( !strcmp( p->psz_name, "maxheight" ) )
+            p_cfg->i_maxheight = atoi( psz );
+        else if( !strcmp( p->psz_name, "acodec" ) )
+            p_cfg->i_acodec = ParseCodec( AUDIO_ES, psz );
+        else if( !strcmp( p->psz_name, "aenc" ) )
+            ParseEncoder( &p_cfg->psz_aenc, &p_cfg->p_audio_cfg, psz );
+        else if( !strcmp( p->psz_name, "ab" ) )
+        {
+            p_cfg->i_abitrate = atoi( psz );
+            if( p_cfg->i_abitrate < 4000 ) p_cfg->i_abitrate *= 1000;
+        }
+        else
+        {
+            msg_Warn( p_stream, "unknown rendition option `%s'", p->psz_name );
+            continue;
+        }
+
+        if( p->psz_name[0] == 'a' )
+            b_audio = true;
+        else
+            b_video = true;
+    }
+    config_ChainDestroy( p_chain );
+
+    /* Inherit the main settings */
+    if( b_video )
+    {
+        if( !p_cfg->i_vcodec )
+            p_cfg->i_vcodec = p_sys->i_vcodec;
+        if( !p_cfg->psz_venc && p_sys->psz_venc )
+        {
+            p_cfg->psz_venc = strdup( p_sys->psz_venc );
+            p_cfg->p_video_cfg = config_ChainDuplicate( p_sys->p_video_cfg );
+        }
+        if( !p_cfg->i_vbitrate )
+            p_cfg->i_vbitrate = p_sys->i_vbitrate;
+    }
+    else
+        p_cfg->i_vcodec = 0;
+
+    if( b_audio )
+    {
+        if( !p_cfg->i_acodec )
+            p_cfg->i_acodec = p_sys->i_acodec;
+        if( !p_cfg->psz_aenc && p_sys->psz_aenc )
+        {
+            p_cfg->psz_aenc = strdup( p_sys->psz_aenc );
+            p_cfg->p_audio_cfg = config_ChainDuplicate( p_sys->p_audio_cfg );
+        }
+        if( !p_cfg->i_abitrate )
+            p_cfg->i_abitrate = p_sys->i_abitrate;
+    }
+    else
+        p_cfg->i_acodec = 0;
+
+    if( p_cfg->i_vcodec )
+        msg_Dbg( p_stream, "rendition video=%4.4s %dx%d scaling: %f %dkb/s",
+                 (char *)&p_cfg->i_vcodec, p_cfg->i_width, p_cfg->i_height,
+                 p_cfg->f_scale, p_cfg->i_vbitrate / 1000 );
+    if( p_cfg->i_acodec )
+        msg_Dbg( p_stream, "rendition audio=%4.4s %dKb/s",
+                 (char *)&p_cfg->i_acodec, p_cfg->i_abitrate / 1000 );
+
+    return p_cfg;
+}
+
+void transcode_rendition_cfg_Delete( transcode_rendition_cfg_t *p_cfg )
+{
+    config_ChainDestroy( p_cfg->p_video_cfg );
+    free( p_cfg->psz_venc );
+    config_ChainDestroy( p_cfg->p_audio_cfg );
+    free( p_cfg->psz_aenc );
+    free( p_cfg );
+}
+
+transcode_rendition_t *transcode_rendition_New( sout_stream_t *p_stream,
+                                                sout_stream_id_sys_t *id,
+                                                const transcode_rendition_cfg_t *p_cfg )
+{
+    transcode_rendition_t *r = calloc( 1, sizeof( *r ) );
+    if( !r )
+        return NULL;
+
+    r->p_cfg = p_cfg;
+    transcode_stage_stats_Init( &r->stats );
+    r->p_stats = &p_stream->p_sys->stats[TRANSCODE_STAGE_ENCODE];
+    r->p_encoder = sout_EncoderCreate( p_stream );
+    if( !r->p_encoder )
+    {
+        free( r );
+        return NULL;
+    }
+    r->p_encoder->p_module = NULL;
+
+    /* The renditions get their own ES id from the muxer */
+    es_format_Init( &r->p_encoder->fmt_out, id->p_decoder->fmt_in.i_cat, 0 );
+    r->p_encoder->fmt_out.i_group = id->p_encoder->fmt_out.i_group;
+    if( id->p_encoder->fmt_out.psz_language )
+        r->p_encoder->fmt_out.psz_language =
+            strdup( id->p_encoder->fmt_out.psz_language );
+
+    return r;
+}
+
+void transcode_rendition_Delete( sout_stream_t *p_stream,
+                                 transcode_rendition_t *r )
+{
+    if( r->id )
+        sout_StreamIdDel( p_stream->p_next, r->id );
+    if( r->p_encoder->p_module )
+        module_unneed( r->p_encoder, r->p_encoder->p_module );
+    if( r->p_conv_chain )
+        filter_chain_Delete( r->p_conv_chain );
+    es_format_Clean( &r->p_encoder->fmt_in );
+    es_format_Clean( &r->p_encoder->fmt_out );
+    vlc_object_release( r->p_encoder );
+    free( r );
+}
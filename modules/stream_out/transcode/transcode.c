@@ -131,6 +131,15 @@
 #define HP_LONGTEXT N_( \
     "Runs the optional encoder thread at the OUTPUT priority instead of " \
     "VIDEO." )
+#define PIPELINE_TEXT N_("Pipelined video filters")
+#define PIPELINE_LONGTEXT N_( \
+    "Runs the video filters in their own thread, between the decoder and " \
+    "the encoder. Up to pool-size pictures are queued between the stages." )
+#define RENDITION_TEXT N_("Additional rendition")
+#define RENDITION_LONGTEXT N_( \
+    "Encodes the transcoded streams once more with these settings, sharing " \
+    "the decoders and filters. Accepts vcodec, venc, vb, scale, width, " \
+    "height, maxwidth, maxheight, acodec, aenc and ab, and can be repeated." )
 #define POOL_TEXT N_("Picture pool size")
 #define POOL_LONGTEXT N_( "Defines how many pictures we allow to be in pool "\
     "between decoder/encoder threads when threads > 0" )
@@ -223,6 +232,10 @@ vlc_module_begin ()
         change_integer_range( 1, 1000 )
     add_bool( SOUT_CFG_PREFIX "high-priority", false, HP_TEXT, HP_LONGTEXT,
               true )
+    add_bool( SOUT_CFG_PREFIX "pipeline", false, PIPELINE_TEXT,
+              PIPELINE_LONGTEXT, true )
+    add_string( SOUT_CFG_PREFIX "rendition", NULL, RENDITION_TEXT,
+                RENDITION_LONGTEXT, true )
 
 vlc_module_end ()
 
@@ -232,7 +245,7 @@ static const char *const ppsz_sout_options[] = {
     "deinterlace-module", "threads", "aenc", "acodec", "ab", "alang",
     "afilter", "samplerate", "channels", "senc", "scodec", "soverlay",
     "sfilter", "osd", "high-priority", "maxwidth", "maxheight", "pool-size",
-    NULL
+    "pipeline", "rendition", NULL
 };
 
 /*****************************************************************************
@@ -241,6 +254,7 @@ static const char *const ppsz_sout_options[] = {
 static sout_stream_id_sys_t *Add( sout_stream_t *, const es_format_t * );
 static void              Del ( sout_stream_t *, sout_stream_id_sys_t * );
 static int               Send( sout_stream_t *, sout_stream_id_sys_t *, block_t* );
+static int               Control( sout_stream_t *, int, va_list );
 
 /*****************************************************************************
  * Open:
@@ -258,6 +272,8 @@ static int Open( vlc_object_t *p_this )
     }
     p_sys = calloc( 1, sizeof( *p_sys ) );
     p_sys->i_master_drift = 0;
+    for( int i = 0; i < TRANSCODE_STAGE_MAX; i++ )
+        transcode_stage_stats_Init( &p_sys->stats[i] );
 
     config_ChainParse( p_stream, SOUT_CFG_PREFIX, ppsz_sout_options,
                    p_stream->p_cfg );
@@ -381,6 +397,21 @@ static int Open( vlc_object_t *p_this )
     p_sys->i_threads = var_GetInteger( p_stream, SOUT_CFG_PREFIX "threads" );
     p_sys->pool_size = var_GetInteger( p_stream, SOUT_CFG_PREFIX "pool-size" );
     p_sys->b_high_priority = var_GetBool( p_stream, SOUT_CFG_PREFIX "high-priority" );
+    p_sys->b_pipeline = var_GetBool( p_stream, SOUT_CFG_PREFIX "pipeline" );
+
+    /* Additional renditions, inheriting the settings above */
+    TAB_INIT( p_sys->i_renditions, p_sys->pp_renditions );
+    for( config_chain_t *p_cfg = p_stream->p_cfg; p_cfg != NULL;
+         p_cfg = p_cfg->p_next )
+    {
+        if( strcmp( p_cfg->psz_name, "rendition" ) || !p_cfg->psz_value )
+            continue;
+
+        transcode_rendition_cfg_t *p_rcfg =
+            transcode_rendition_cfg_New( p_stream, p_sys, p_cfg->psz_value );
+        if( p_rcfg )
+            TAB_APPEND( p_sys->i_renditions, p_sys->pp_renditions, p_rcfg );
+    }
 
     if( p_sys->i_vcodec )
     {
@@ -471,6 +502,7 @@ static int Open( vlc_object_t *p_this )
     p_stream->pf_add    = Add;
     p_stream->pf_del    = Del;
     p_stream->pf_send   = Send;
+    p_stream->pf_control = Control;
     p_stream->p_sys     = p_sys;
 
     return VLC_SUCCESS;
@@ -492,6 +524,10 @@ static void Close( vlc_object_t * p_this )
 
     free( p_sys->psz_vf2 );
 
+    for( int i = 0; i < p_sys->i_renditions; i++ )
+        transcode_rendition_cfg_Delete( p_sys->pp_renditions[i] );
+    TAB_CLEAN( p_sys->i_renditions, p_sys->pp_renditions );
+
     config_ChainDestroy( p_sys->p_video_cfg );
     free( p_sys->psz_venc );
 
@@ -620,6 +656,10 @@ static void Del( sout_stream_t *p_stream, sout_stream_id_sys_t *id )
         }
     }
 
+    for( int i = 0; i < id->i_renditions; i++ )
+        transcode_rendition_Delete( p_stream, id->pp_renditions[i] );
+    TAB_CLEAN( id->i_renditions, id->pp_renditions );
+
     if( id->id ) sout_StreamIdDel( p_stream->p_next, id->id );
 
     if( id->p_decoder )
@@ -697,3 +737,30 @@ static int Send( sout_stream_t *p_stream, sout_stream_id_sys_t *id,
         return sout_StreamIdSend( p_stream->p_next, id->id, p_out );
     return VLC_SUCCESS;
 }
+
+static int Control( sout_stream_t *p_stream, int i_query, va_list args )
+{
+    sout_stream_sys_t *p_sys = p_stream->p_sys;
+
+    switch( i_query )
+    {
+        case SOUT_STREAM_GET_STATS:
+        {
+            input_stage_stats_t *p_decode = va_arg( args, input_stage_stats_t * );
+            input_stage_stats_t *p_filter = va_arg( args, input_stage_stats_t * );
+            input_stage_stats_t *p_encode = va_arg( args, input_stage_stats_t * );
+
+            transcode_stage_stats_Get( &p_sys->stats[TRANSCODE_STAGE_DECODE],
+                                       p_decode );
+            transcode_stage_stats_Get( &p_sys->stats[TRANSCODE_STAGE_FILTER],
+                                       p_filter );
+            transcode_stage_stats_Get( &p_sys->stats[TRANSCODE_STAGE_ENCODE],
+                                       p_encode );
+            /* Chained transcoders add up */
+            sout_StreamControl( p_stream->p_next, SOUT_STREAM_GET_STATS,
+                                p_decode, p_filter, p_encode );
+            return VLC_SUCCESS;
+        }
+    }
+    return VLC_EGENERIC;
+}
@@ -8,12 +8,96 @@
 #include <vlc_filter.h>
 #include <vlc_es.h>
 #include <vlc_codec.h>
+#include <vlc_atomic.h>
+#include <vlc_input_item.h>
 
 #include <vlc_picture_fifo.h>
 
 /*100ms is around the limit where people are noticing lipsync issues*/
 #define MASTER_SYNC_MAX_DRIFT 100000
 
+/** Video pipeline stages */
+enum
+{
+    TRANSCODE_STAGE_DECODE,
+    TRANSCODE_STAGE_FILTER,
+    TRANSCODE_STAGE_ENCODE,
+    TRANSCODE_STAGE_MAX
+};
+
+/** Stage counters, updated by the stage thread and read from any thread */
+typedef struct
+{
+    atomic_ullong   i_pictures;
+    atomic_llong    i_busy;     /**< time spent processing */
+    atomic_llong    i_stalled;  /**< time spent waiting for the next stage */
+} transcode_stage_stats_t;
+
+static inline void transcode_stage_stats_Init( transcode_stage_stats_t *p_stats )
+{
+    atomic_init( &p_stats->i_pictures, 0 );
+    atomic_init( &p_stats->i_busy, 0 );
+    atomic_init( &p_stats->i_stalled, 0 );
+}
+
+/* Adds the counters to the input statistics */
+static inline void transcode_stage_stats_Get( transcode_stage_stats_t *p_stats,
+                                              input_stage_stats_t *p_out )
+{
+    p_out->i_pictures += atomic_load( &p_stats->i_pictures );
+    p_out->i_busy += atomic_load( &p_stats->i_busy );
+    p_out->i_stalled += atomic_load( &p_stats->i_stalled );
+}
+
+/** Settings of one additional rendition, see rendition.c */
+typedef struct
+{
+    /* Video */
+    vlc_fourcc_t    i_vcodec;   /* codec video (0 if no video rendition) */
+    char            *psz_venc;
+    config_chain_t  *p_video_cfg;
+    int             i_vbitrate;
+    double          f_scale;
+    unsigned int    i_width, i_maxwidth;
+    unsigned int    i_height, i_maxheight;
+
+    /* Audio */
+    vlc_fourcc_t    i_acodec;   /* codec audio (0 if no audio rendition) */
+    char            *psz_aenc;
+    config_chain_t  *p_audio_cfg;
+    int             i_abitrate;
+} transcode_rendition_cfg_t;
+
+/** Per ES state of one additional rendition */
+typedef struct
+{
+    const transcode_rendition_cfg_t *p_cfg;
+
+    /* id of the out stream */
+    void            *id;
+
+    encoder_t       *p_encoder;
+    filter_chain_t  *p_conv_chain; /**< Scaling and chroma conversion */
+
+    transcode_stage_stats_t stats;      /**< scaler and encoder */
+    transcode_stage_stats_t *p_stats;   /**< encoders of the whole stream */
+
+    /* Video encoder thread */
+    vlc_thread_t    thread;
+    vlc_mutex_t     lock;
+    vlc_cond_t      cond;       /**< pictures were queued or abort */
+    vlc_cond_t      wait;       /**< the queue was drained */
+    vlc_sem_t       has_room;
+    picture_t       **pp_pics;  /**< ring of shared pictures */
+    unsigned int    i_pics_size;
+    unsigned int    i_pics_first;
+    unsigned int    i_pics_count;
+    block_t         *p_buffers;
+    bool            b_busy;
+    bool            b_abort;
+    bool            b_thread;
+} transcode_rendition_t;
+
 struct sout_stream_sys_t
 {
     sout_stream_id_sys_t *id_video;
@@ -26,6 +110,21 @@ struct sout_stream_sys_t
     uint32_t        pool_size;
     vlc_thread_t    thread;
 
+    /* Video filters thread, between the decoder and the encoder thread */
+    bool            b_pipeline;
+    bool            b_filter_thread;
+    bool            b_filter_busy;
+    bool            b_filter_abort;
+    vlc_thread_t    filter_thread;
+    vlc_mutex_t     lock_filter;
+    vlc_cond_t      cond_filter;        /**< pictures were queued or abort */
+    vlc_cond_t      cond_filter_idle;   /**< the queue was drained */
+    vlc_sem_t       filter_has_room;
+    picture_fifo_t  *p_filter_pics;
+    block_t         *p_filter_buffers;
+
+    transcode_stage_stats_t stats[TRANSCODE_STAGE_MAX];
+
     /* Audio */
     vlc_fourcc_t    i_acodec;   /* codec audio (0 if not transcode) */
     char            *psz_aenc;
@@ -55,6 +154,10 @@ struct sout_stream_sys_t
 
     char            *psz_vf2;
 
+    /* Additional renditions sharing the decoders and filters */
+    int                         i_renditions;
+    transcode_rendition_cfg_t   **pp_renditions;
+
     /* SPU */
     vlc_fourcc_t    i_scodec;   /* codec spu (0 if not transcode) */
     char            *psz_senc;
@@ -93,6 +196,10 @@ struct sout_stream_id_sys_t
          {
              filter_chain_t  *p_f_chain; /**< Video filters */
              filter_chain_t  *p_uf_chain; /**< User-specified video filters */
+             filter_chain_t  *p_conv_chain; /**< Scaling and chroma conversion */
+
+    transcode_stage_stats_t stats;      /**< scaler and encoder */
+    transcode_stage_stats_t *p_stats;   /**< encoders of the whole stream */
              video_format_t  fmt_input_video;
          };
          struct
@@ -106,12 +213,27 @@ struct sout_stream_id_sys_t
     /* Encoder */
     encoder_t       *p_encoder;
 
+    /* Additional renditions */
+    int                     i_renditions;
+    transcode_rendition_t   **pp_renditions;
+
     /* Sync */
     date_t          next_input_pts; /**< Incoming calculated PTS */
     date_t          next_output_pts; /**< output calculated PTS */
 
 };
 
+/* RENDITIONS */
+
+transcode_rendition_cfg_t *transcode_rendition_cfg_New( sout_stream_t *,
+                                                        const sout_stream_sys_t *,
+                                                        const char * );
+void transcode_rendition_cfg_Delete( transcode_rendition_cfg_t * );
+transcode_rendition_t *transcode_rendition_New( sout_stream_t *,
+                                                sout_stream_id_sys_t *,
+                                                const transcode_rendition_cfg_t * );
+void transcode_rendition_Delete( sout_stream_t *, transcode_rendition_t * );
+
 /* OSD */
 
 int transcode_osd_new( sout_stream_t *p_stream, sout_stream_id_sys_t *id );
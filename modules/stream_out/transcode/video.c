@@ -66,6 +66,36 @@ static picture_t *transcode_video_filter_buffer_new( filter_t *p_filter )
     return picture_NewFromFormat( &p_filter->fmt_out.video );
 }
 
+static block_t *transcode_video_encode( sout_stream_sys_t *p_sys,
+                                        sout_stream_id_sys_t *id,
+                                        picture_t *p_pic )
+{
+    transcode_stage_stats_t *p_stats = &p_sys->stats[TRANSCODE_STAGE_ENCODE];
+    mtime_t i_start = mdate();
+
+    block_t *p_block = id->p_encoder->pf_encode_video( id->p_encoder, p_pic );
+
+    atomic_fetch_add( &p_stats->i_busy, mdate() - i_start );
+    atomic_fetch_add( &p_stats->i_pictures, 1 );
+    return p_block;
+}
+
+static picture_t *transcode_video_filter( sout_stream_sys_t *p_sys,
+                                          filter_chain_t *p_chain,
+                                          picture_t *p_pic )
+{
+    mtime_t i_start = mdate();
+
+    p_pic = filter_chain_VideoFilter( p_chain, p_pic );
+
+    atomic_fetch_add( &p_sys->stats[TRANSCODE_STAGE_FILTER].i_busy,
+                      mdate() - i_start );
+    return p_pic;
+}
+
+static int transcode_video_filter_thread_start( sout_stream_t * );
+static void transcode_video_filter_thread_stop( sout_stream_sys_t * );
+
 static void* EncoderThread( void *obj )
 {
     sout_stream_sys_t *p_sys = (sout_stream_sys_t*)obj;
@@ -87,7 +117,7 @@ static void* EncoderThread( void *obj )
         {
             /* release lock while encoding */
             vlc_mutex_unlock( &p_sys->lock_out );
-            p_block = id->p_encoder->pf_encode_video( id->p_encoder, p_pic );
+            p_block = transcode_video_encode( p_sys, id, p_pic );
             picture_Release( p_pic );
             vlc_mutex_lock( &p_sys->lock_out );
 
@@ -102,7 +132,7 @@ static void* EncoderThread( void *obj )
     while( (p_pic = picture_fifo_Pop( p_sys->pp_pics )) != NULL )
     {
         vlc_sem_post( &p_sys->picture_pool_has_room );
-        p_block = id->p_encoder->pf_encode_video( id->p_encoder, p_pic );
+        p_block = transcode_video_encode( p_sys, id, p_pic );
         picture_Release( p_pic );
         block_ChainAppend( &p_sys->p_buffers, p_block );
     }
@@ -214,16 +244,26 @@ int transcode_video_new( sout_stream_t *p_stream, sout_stream_id_sys_t *id )
     }
     id->p_encoder->p_module = NULL;
 
+    p_sys->id_video = id;
+    if( p_sys->b_pipeline && transcode_video_filter_thread_start( p_stream ) )
+    {
+        msg_Err( p_stream, "cannot spawn filter thread" );
+        module_unneed( id->p_decoder, id->p_decoder->p_module );
+        id->p_decoder->p_module = NULL;
+        free( id->p_decoder->p_owner );
+        return VLC_EGENERIC;
+    }
+
     if( p_sys->i_threads <= 0 )
         return VLC_SUCCESS;
 
     int i_priority = p_sys->b_high_priority ? VLC_THREAD_PRIORITY_OUTPUT :
                        VLC_THREAD_PRIORITY_VIDEO;
-    p_sys->id_video = id;
     p_sys->pp_pics = picture_fifo_New();
     if( p_sys->pp_pics == NULL )
     {
         msg_Err( p_stream, "cannot create picture fifo" );
+        transcode_video_filter_thread_stop( p_sys );
         module_unneed( id->p_decoder, id->p_decoder->p_module );
         id->p_decoder->p_module = NULL;
         free( id->p_decoder->p_owner );
@@ -241,6 +281,7 @@ int transcode_video_new( sout_stream_t *p_stream, sout_stream_id_sys_t *id )
         vlc_mutex_destroy( &p_sys->lock_out );
         vlc_cond_destroy( &p_sys->cond );
         picture_fifo_Delete( p_sys->pp_pics );
+        transcode_video_filter_thread_stop( p_sys );
         module_unneed( id->p_decoder, id->p_decoder->p_module );
         id->p_decoder->p_module = NULL;
         free( id->p_decoder->p_owner );
@@ -325,7 +366,34 @@ static void transcode_video_filter_init( sout_stream_t *p_stream,
 }
 
 /* Take care of the scaling and chroma conversions. */
-static void conversion_video_filter_append( sout_stream_id_sys_t *id )
+static filter_chain_t *transcode_video_conv_chain_new( sout_stream_t *p_stream,
+                                                       const es_format_t *p_fmt_out,
+                                                       encoder_t *p_enc )
+{
+    filter_owner_t owner = {
+        .sys = p_stream->p_sys,
+        .video = {
+            .buffer_new = transcode_video_filter_buffer_new,
+        },
+    };
+
+    filter_chain_t *p_chain = filter_chain_NewVideo( p_stream, false, &owner );
+    if( !p_chain )
+        return NULL;
+    filter_chain_Reset( p_chain, p_fmt_out, &p_enc->fmt_in );
+
+    if( ( p_fmt_out->video.i_chroma != p_enc->fmt_in.video.i_chroma ) ||
+        ( p_fmt_out->video.i_width != p_enc->fmt_in.video.i_width ) ||
+        ( p_fmt_out->video.i_height != p_enc->fmt_in.video.i_height ) )
+    {
+        filter_chain_AppendFilter( p_chain, NULL, NULL,
+                                   p_fmt_out, &p_enc->fmt_in );
+    }
+    return p_chain;
+}
+
+/* Output format of the filters shared by all the renditions */
+static const es_format_t *transcode_video_filters_fmt_out( sout_stream_id_sys_t *id )
 {
     const es_format_t *p_fmt_out = &id->p_decoder->fmt_out;
     if( id->p_f_chain )
@@ -333,66 +401,68 @@ static void conversion_video_filter_append( sout_stream_id_sys_t *id )
 
     if( id->p_uf_chain )
         p_fmt_out = filter_chain_GetFmtOut( id->p_uf_chain );
+    return p_fmt_out;
+}
 
-    if( ( p_fmt_out->video.i_chroma != id->p_encoder->fmt_in.video.i_chroma ) ||
-        ( p_fmt_out->video.i_width != id->p_encoder->fmt_in.video.i_width ) ||
-        ( p_fmt_out->video.i_height != id->p_encoder->fmt_in.video.i_height ) )
-    {
-        filter_chain_AppendFilter( id->p_uf_chain ? id->p_uf_chain : id->p_f_chain,
-                                   NULL, NULL,
-                                   p_fmt_out,
-                                   &id->p_encoder->fmt_in );
-    }
+static void conversion_video_filter_append( sout_stream_t *p_stream,
+                                            sout_stream_id_sys_t *id )
+{
+    id->p_conv_chain =
+        transcode_video_conv_chain_new( p_stream,
+                                        transcode_video_filters_fmt_out( id ),
+                                        id->p_encoder );
 }
 
 static void transcode_video_framerate_init( sout_stream_t *p_stream,
                                             sout_stream_id_sys_t *id,
+                                            encoder_t *p_enc,
                                             const es_format_t *p_fmt_out )
 {
     /* Handle frame rate conversion */
-    if( !id->p_encoder->fmt_out.video.i_frame_rate ||
-        !id->p_encoder->fmt_out.video.i_frame_rate_base )
+    if( !p_enc->fmt_out.video.i_frame_rate ||
+        !p_enc->fmt_out.video.i_frame_rate_base )
     {
         if( p_fmt_out->video.i_frame_rate &&
             p_fmt_out->video.i_frame_rate_base )
         {
-            id->p_encoder->fmt_out.video.i_frame_rate =
+            p_enc->fmt_out.video.i_frame_rate =
                 p_fmt_out->video.i_frame_rate;
-            id->p_encoder->fmt_out.video.i_frame_rate_base =
+            p_enc->fmt_out.video.i_frame_rate_base =
                 p_fmt_out->video.i_frame_rate_base;
         }
         else
         {
             /* Pick a sensible default value */
-            id->p_encoder->fmt_out.video.i_frame_rate = ENC_FRAMERATE;
-            id->p_encoder->fmt_out.video.i_frame_rate_base = ENC_FRAMERATE_BASE;
+            p_enc->fmt_out.video.i_frame_rate = ENC_FRAMERATE;
+            p_enc->fmt_out.video.i_frame_rate_base = ENC_FRAMERATE_BASE;
         }
     }
 
-    id->p_encoder->fmt_in.video.i_frame_rate =
-        id->p_encoder->fmt_out.video.i_frame_rate;
-    id->p_encoder->fmt_in.video.i_frame_rate_base =
-        id->p_encoder->fmt_out.video.i_frame_rate_base;
+    p_enc->fmt_in.video.i_frame_rate =
+        p_enc->fmt_out.video.i_frame_rate;
+    p_enc->fmt_in.video.i_frame_rate_base =
+        p_enc->fmt_out.video.i_frame_rate_base;
 
-    vlc_ureduce( &id->p_encoder->fmt_in.video.i_frame_rate,
-        &id->p_encoder->fmt_in.video.i_frame_rate_base,
-        id->p_encoder->fmt_in.video.i_frame_rate,
-        id->p_encoder->fmt_in.video.i_frame_rate_base,
+    vlc_ureduce( &p_enc->fmt_in.video.i_frame_rate,
+        &p_enc->fmt_in.video.i_frame_rate_base,
+        p_enc->fmt_in.video.i_frame_rate,
+        p_enc->fmt_in.video.i_frame_rate_base,
         0 );
      msg_Dbg( p_stream, "source fps %u/%u, destination %u/%u",
         id->p_decoder->fmt_out.video.i_frame_rate,
         id->p_decoder->fmt_out.video.i_frame_rate_base,
-        id->p_encoder->fmt_in.video.i_frame_rate,
-        id->p_encoder->fmt_in.video.i_frame_rate_base );
+        p_enc->fmt_in.video.i_frame_rate,
+        p_enc->fmt_in.video.i_frame_rate_base );
 
 }
 
 static void transcode_video_size_init( sout_stream_t *p_stream,
-                                     sout_stream_id_sys_t *id,
-                                     const es_format_t *p_fmt_out )
+                                     encoder_t *p_enc,
+                                     const es_format_t *p_fmt_out,
+                                     double f_scale,
+                                     unsigned int i_maxwidth,
+                                     unsigned int i_maxheight )
 {
-    sout_stream_sys_t *p_sys = p_stream->p_sys;
-
     /* Calculate scaling
      * width/height of source */
     int i_src_visible_width = p_fmt_out->video.i_visible_width;
@@ -421,13 +491,13 @@ static void transcode_video_size_init( sout_stream_t *p_stream,
     msg_Dbg( p_stream, "source pixel aspect is %f:1", (double) f_aspect );
 
     /* Calculate scaling factor for specified parameters */
-    if( id->p_encoder->fmt_out.video.i_visible_width <= 0 &&
-        id->p_encoder->fmt_out.video.i_visible_height <= 0 && p_sys->f_scale )
+    if( p_enc->fmt_out.video.i_visible_width <= 0 &&
+        p_enc->fmt_out.video.i_visible_height <= 0 && f_scale )
     {
         /* Global scaling. Make sure width will remain a factor of 16 */
         float f_real_scale;
         int  i_new_height;
-        int i_new_width = i_src_visible_width * p_sys->f_scale;
+        int i_new_width = i_src_visible_width * f_scale;
 
         if( i_new_width % 16 <= 7 && i_new_width >= 16 )
             i_new_width -= i_new_width % 16;
@@ -441,39 +511,39 @@ static void transcode_video_size_init( sout_stream_t *p_stream,
         f_scale_width = f_real_scale;
         f_scale_height = (float) i_new_height / (float) i_src_visible_height;
     }
-    else if( id->p_encoder->fmt_out.video.i_visible_width > 0 &&
-             id->p_encoder->fmt_out.video.i_visible_height <= 0 )
+    else if( p_enc->fmt_out.video.i_visible_width > 0 &&
+             p_enc->fmt_out.video.i_visible_height <= 0 )
     {
         /* Only width specified */
-        f_scale_width = (float)id->p_encoder->fmt_out.video.i_visible_width/i_src_visible_width;
+        f_scale_width = (float)p_enc->fmt_out.video.i_visible_width/i_src_visible_width;
         f_scale_height = f_scale_width;
     }
-    else if( id->p_encoder->fmt_out.video.i_visible_width <= 0 &&
-             id->p_encoder->fmt_out.video.i_visible_height > 0 )
+    else if( p_enc->fmt_out.video.i_visible_width <= 0 &&
+             p_enc->fmt_out.video.i_visible_height > 0 )
     {
          /* Only height specified */
-         f_scale_height = (float)id->p_encoder->fmt_out.video.i_visible_height/i_src_visible_height;
+         f_scale_height = (float)p_enc->fmt_out.video.i_visible_height/i_src_visible_height;
          f_scale_width = f_scale_height;
      }
-     else if( id->p_encoder->fmt_out.video.i_visible_width > 0 &&
-              id->p_encoder->fmt_out.video.i_visible_height > 0 )
+     else if( p_enc->fmt_out.video.i_visible_width > 0 &&
+              p_enc->fmt_out.video.i_visible_height > 0 )
      {
          /* Width and height specified */
-         f_scale_width = (float)id->p_encoder->fmt_out.video.i_visible_width/i_src_visible_width;
-         f_scale_height = (float)id->p_encoder->fmt_out.video.i_visible_height/i_src_visible_height;
+         f_scale_width = (float)p_enc->fmt_out.video.i_visible_width/i_src_visible_width;
+         f_scale_height = (float)p_enc->fmt_out.video.i_visible_height/i_src_visible_height;
      }
 
      /* check maxwidth and maxheight */
-     if( p_sys->i_maxwidth && f_scale_width > (float)p_sys->i_maxwidth /
+     if( i_maxwidth && f_scale_width > (float)i_maxwidth /
                                                      i_src_visible_width )
      {
-         f_scale_width = (float)p_sys->i_maxwidth / i_src_visible_width;
+         f_scale_width = (float)i_maxwidth / i_src_visible_width;
      }
 
-     if( p_sys->i_maxheight && f_scale_height > (float)p_sys->i_maxheight /
+     if( i_maxheight && f_scale_height > (float)i_maxheight /
                                                        i_src_visible_height )
      {
-         f_scale_height = (float)p_sys->i_maxheight / i_src_visible_height;
+         f_scale_height = (float)i_maxheight / i_src_visible_height;
      }
 
 
@@ -495,15 +565,15 @@ static void transcode_video_size_init( sout_stream_t *p_stream,
      f_aspect = f_aspect * i_dst_visible_width / i_dst_visible_height;
 
      /* Store calculated values */
-     id->p_encoder->fmt_out.video.i_width = i_dst_width;
-     id->p_encoder->fmt_out.video.i_visible_width = i_dst_visible_width;
-     id->p_encoder->fmt_out.video.i_height = i_dst_height;
-     id->p_encoder->fmt_out.video.i_visible_height = i_dst_visible_height;
+     p_enc->fmt_out.video.i_width = i_dst_width;
+     p_enc->fmt_out.video.i_visible_width = i_dst_visible_width;
+     p_enc->fmt_out.video.i_height = i_dst_height;
+     p_enc->fmt_out.video.i_visible_height = i_dst_visible_height;
 
-     id->p_encoder->fmt_in.video.i_width = i_dst_width;
-     id->p_encoder->fmt_in.video.i_visible_width = i_dst_visible_width;
-     id->p_encoder->fmt_in.video.i_height = i_dst_height;
-     id->p_encoder->fmt_in.video.i_visible_height = i_dst_visible_height;
+     p_enc->fmt_in.video.i_width = i_dst_width;
+     p_enc->fmt_in.video.i_visible_width = i_dst_visible_width;
+     p_enc->fmt_in.video.i_height = i_dst_height;
+     p_enc->fmt_in.video.i_visible_height = i_dst_visible_height;
 
      msg_Dbg( p_stream, "source %ix%i, destination %ix%i",
          i_src_visible_width, i_src_visible_height,
@@ -512,7 +582,7 @@ static void transcode_video_size_init( sout_stream_t *p_stream,
 };
 
 static void transcode_video_sar_init( sout_stream_t *p_stream,
-                                     sout_stream_id_sys_t *id,
+                                     encoder_t *p_enc,
                                      const es_format_t *p_fmt_out )
 {
     int i_src_visible_width = p_fmt_out->video.i_visible_width;
@@ -524,54 +594,51 @@ static void transcode_video_sar_init( sout_stream_t *p_stream,
         i_src_visible_height = p_fmt_out->video.i_height;
 
     /* Check whether a particular aspect ratio was requested */
-    if( id->p_encoder->fmt_out.video.i_sar_num <= 0 ||
-        id->p_encoder->fmt_out.video.i_sar_den <= 0 )
+    if( p_enc->fmt_out.video.i_sar_num <= 0 ||
+        p_enc->fmt_out.video.i_sar_den <= 0 )
     {
-        vlc_ureduce( &id->p_encoder->fmt_out.video.i_sar_num,
-                     &id->p_encoder->fmt_out.video.i_sar_den,
-                     (uint64_t)p_fmt_out->video.i_sar_num * id->p_encoder->fmt_out.video.i_width * p_fmt_out->video.i_height,
-                     (uint64_t)p_fmt_out->video.i_sar_den * id->p_encoder->fmt_out.video.i_height * p_fmt_out->video.i_width,
+        vlc_ureduce( &p_enc->fmt_out.video.i_sar_num,
+                     &p_enc->fmt_out.video.i_sar_den,
+                     (uint64_t)p_fmt_out->video.i_sar_num * p_enc->fmt_out.video.i_width * p_fmt_out->video.i_height,
+                     (uint64_t)p_fmt_out->video.i_sar_den * p_enc->fmt_out.video.i_height * p_fmt_out->video.i_width,
                      0 );
     }
     else
     {
-        vlc_ureduce( &id->p_encoder->fmt_out.video.i_sar_num,
-                     &id->p_encoder->fmt_out.video.i_sar_den,
-                     id->p_encoder->fmt_out.video.i_sar_num,
-                     id->p_encoder->fmt_out.video.i_sar_den,
+        vlc_ureduce( &p_enc->fmt_out.video.i_sar_num,
+                     &p_enc->fmt_out.video.i_sar_den,
+                     p_enc->fmt_out.video.i_sar_num,
+                     p_enc->fmt_out.video.i_sar_den,
                      0 );
     }
 
-    id->p_encoder->fmt_in.video.i_sar_num =
-        id->p_encoder->fmt_out.video.i_sar_num;
-    id->p_encoder->fmt_in.video.i_sar_den =
-        id->p_encoder->fmt_out.video.i_sar_den;
+    p_enc->fmt_in.video.i_sar_num =
+        p_enc->fmt_out.video.i_sar_num;
+    p_enc->fmt_in.video.i_sar_den =
+        p_enc->fmt_out.video.i_sar_den;
 
     msg_Dbg( p_stream, "encoder aspect is %i:%i",
-             id->p_encoder->fmt_out.video.i_sar_num * id->p_encoder->fmt_out.video.i_width,
-             id->p_encoder->fmt_out.video.i_sar_den * id->p_encoder->fmt_out.video.i_height );
+             p_enc->fmt_out.video.i_sar_num * p_enc->fmt_out.video.i_width,
+             p_enc->fmt_out.video.i_sar_den * p_enc->fmt_out.video.i_height );
 
 }
 
 static void transcode_video_encoder_init( sout_stream_t *p_stream,
                                           sout_stream_id_sys_t *id )
 {
-    const es_format_t *p_fmt_out = &id->p_decoder->fmt_out;
-    if( id->p_f_chain ) {
-        p_fmt_out = filter_chain_GetFmtOut( id->p_f_chain );
-    }
-    if( id->p_uf_chain ) {
-        p_fmt_out = filter_chain_GetFmtOut( id->p_uf_chain );
-    }
+    sout_stream_sys_t *p_sys = p_stream->p_sys;
+    const es_format_t *p_fmt_out = transcode_video_filters_fmt_out( id );
 
     id->p_encoder->fmt_in.video.orientation =
         id->p_encoder->fmt_out.video.orientation =
         id->p_decoder->fmt_in.video.orientation;
 
-    transcode_video_framerate_init( p_stream, id, p_fmt_out );
+    transcode_video_framerate_init( p_stream, id, id->p_encoder, p_fmt_out );
 
-    transcode_video_size_init( p_stream, id, p_fmt_out );
-    transcode_video_sar_init( p_stream, id, p_fmt_out );
+    transcode_video_size_init( p_stream, id->p_encoder, p_fmt_out,
+                               p_sys->f_scale, p_sys->i_maxwidth,
+                               p_sys->i_maxheight );
+    transcode_video_sar_init( p_stream, id->p_encoder, p_fmt_out );
 
 }
 
@@ -611,9 +678,303 @@ static int transcode_video_encoder_open( sout_stream_t *p_stream,
     return VLC_SUCCESS;
 }
 
+/*
+ * Renditions
+ *
+ * Each rendition runs its scaler and encoder in its own thread, fed with
+ * references to the pictures coming out of the shared filters. The encoded
+ * blocks are picked up and sent downstream from the stream output thread.
+ */
+static void* RenditionThread( void *obj )
+{
+    transcode_rendition_t *r = obj;
+    picture_t *p_pic;
+    block_t *p_block;
+    int canc = vlc_savecancel ();
+
+    vlc_mutex_lock( &r->lock );
+    for( ;; )
+    {
+        if( r->i_pics_count == 0 )
+        {
+            r->b_busy = false;
+            vlc_cond_signal( &r->wait );
+            if( r->b_abort )
+                break;
+            vlc_cond_wait( &r->cond, &r->lock );
+            continue;
+        }
+        p_pic = r->pp_pics[r->i_pics_first];
+        r->i_pics_first = ( r->i_pics_first + 1 ) % r->i_pics_size;
+        r->i_pics_count--;
+        vlc_sem_post( &r->has_room );
+
+        /* release lock while scaling and encoding */
+        vlc_mutex_unlock( &r->lock );
+        mtime_t i_start = mdate();
+        p_pic = filter_chain_VideoFilter( r->p_conv_chain, p_pic );
+        p_block = NULL;
+        if( p_pic )
+        {
+            p_block = r->p_encoder->pf_encode_video( r->p_encoder, p_pic );
+            picture_Release( p_pic );
+
+            mtime_t i_busy = mdate() - i_start;
+            atomic_fetch_add( &r->stats.i_busy, i_busy );
+            atomic_fetch_add( &r->stats.i_pictures, 1 );
+            atomic_fetch_add( &r->p_stats->i_busy, i_busy );
+            atomic_fetch_add( &r->p_stats->i_pictures, 1 );
+        }
+        vlc_mutex_lock( &r->lock );
+
+        block_ChainAppend( &r->p_buffers, p_block );
+    }
+
+    /*Now flush encoder*/
+    do {
+        p_block = r->p_encoder->pf_encode_video( r->p_encoder, NULL );
+        block_ChainAppend( &r->p_buffers, p_block );
+    } while( p_block );
+
+    vlc_mutex_unlock( &r->lock );
+
+    vlc_restorecancel (canc);
+
+    return NULL;
+}
+
+static int transcode_video_rendition_start( sout_stream_t *p_stream,
+                                            transcode_rendition_t *r )
+{
+    sout_stream_sys_t *p_sys = p_stream->p_sys;
+    int i_priority = p_sys->b_high_priority ? VLC_THREAD_PRIORITY_OUTPUT :
+                       VLC_THREAD_PRIORITY_VIDEO;
+
+    /* The pictures are shared with the other renditions, so they cannot
+     * be linked in a picture_fifo_t */
+    r->pp_pics = malloc( p_sys->pool_size * sizeof( *r->pp_pics ) );
+    if( r->pp_pics == NULL )
+        return VLC_ENOMEM;
+    r->i_pics_size = p_sys->pool_size;
+    r->i_pics_first = r->i_pics_count = 0;
+
+    vlc_sem_init( &r->has_room, p_sys->pool_size );
+    vlc_mutex_init( &r->lock );
+    vlc_cond_init( &r->cond );
+    vlc_cond_init( &r->wait );
+    r->p_buffers = NULL;
+    r->b_busy = false;
+    r->b_abort = false;
+    if( vlc_clone( &r->thread, RenditionThread, r, i_priority ) )
+    {
+        vlc_cond_destroy( &r->wait );
+        vlc_cond_destroy( &r->cond );
+        vlc_mutex_destroy( &r->lock );
+        vlc_sem_destroy( &r->has_room );
+        free( r->pp_pics );
+        r->pp_pics = NULL;
+        return VLC_EGENERIC;
+    }
+    r->b_thread = true;
+    return VLC_SUCCESS;
+}
+
+/* Encodes the pending pictures, flushes the encoder and joins the thread.
+ * The remaining blocks are left in r->p_buffers. */
+static void transcode_video_rendition_stop( transcode_rendition_t *r )
+{
+    if( !r->b_thread )
+        return;
+
+    vlc_mutex_lock( &r->lock );
+    r->b_abort = true;
+    vlc_cond_signal( &r->cond );
+    vlc_mutex_unlock( &r->lock );
+
+    vlc_join( r->thread, NULL );
+    r->b_thread = false;
+
+    vlc_cond_destroy( &r->wait );
+    vlc_cond_destroy( &r->cond );
+    vlc_mutex_destroy( &r->lock );
+    vlc_sem_destroy( &r->has_room );
+    free( r->pp_pics );
+    r->pp_pics = NULL;
+}
+
+/* Waits until the thread has processed all the queued pictures */
+static void transcode_video_rendition_drain( transcode_rendition_t *r )
+{
+    if( !r->b_thread )
+        return;
+
+    vlc_mutex_lock( &r->lock );
+    while( r->b_busy )
+        vlc_cond_wait( &r->wait, &r->lock );
+    vlc_mutex_unlock( &r->lock );
+}
+
+static void transcode_video_rendition_push( transcode_rendition_t *r,
+                                            picture_t *p_pic )
+{
+    vlc_sem_wait( &r->has_room );
+    vlc_mutex_lock( &r->lock );
+    r->pp_pics[( r->i_pics_first + r->i_pics_count++ ) % r->i_pics_size] =
+        picture_Hold( p_pic );
+    r->b_busy = true;
+    vlc_cond_signal( &r->cond );
+    vlc_mutex_unlock( &r->lock );
+}
+
+/* Sends blocks left over by a thread, if the ES was added downstream */
+static void transcode_video_send( sout_stream_t *p_stream, void *id_out,
+                                  block_t *p_out )
+{
+    if( p_out == NULL )
+        return;
+    if( id_out != NULL )
+        sout_StreamIdSend( p_stream->p_next, id_out, p_out );
+    else
+        block_ChainRelease( p_out );
+}
+
+static void transcode_video_rendition_output( sout_stream_t *p_stream,
+                                              transcode_rendition_t *r )
+{
+    block_t *p_out;
+
+    if( r->b_thread )
+    {
+        vlc_mutex_lock( &r->lock );
+        p_out = r->p_buffers;
+        r->p_buffers = NULL;
+        vlc_mutex_unlock( &r->lock );
+    }
+    else
+    {
+        p_out = r->p_buffers;
+        r->p_buffers = NULL;
+    }
+
+    transcode_video_send( p_stream, r->id, p_out );
+}
+
+static int transcode_video_rendition_open( sout_stream_t *p_stream,
+                                           sout_stream_id_sys_t *id,
+                                           transcode_rendition_t *r )
+{
+    sout_stream_sys_t *p_sys = p_stream->p_sys;
+    const transcode_rendition_cfg_t *p_cfg = r->p_cfg;
+    const es_format_t *p_fmt_out = transcode_video_filters_fmt_out( id );
+    encoder_t *p_enc = r->p_encoder;
+
+    /* Start from the shared filters output, the scaler does the rest */
+    es_format_Clean( &p_enc->fmt_in );
+    es_format_Init( &p_enc->fmt_in, VIDEO_ES, p_fmt_out->video.i_chroma );
+    p_enc->fmt_in.video = p_fmt_out->video;
+    p_enc->fmt_in.video.p_palette = NULL;
+    p_enc->fmt_in.video.i_x_offset = p_enc->fmt_in.video.i_y_offset = 0;
+    p_enc->fmt_in.video.orientation =
+        p_enc->fmt_out.video.orientation =
+        id->p_decoder->fmt_in.video.orientation;
+
+    transcode_video_framerate_init( p_stream, id, p_enc, p_fmt_out );
+    transcode_video_size_init( p_stream, p_enc, p_fmt_out, p_cfg->f_scale,
+                               p_cfg->i_maxwidth, p_cfg->i_maxheight );
+    transcode_video_sar_init( p_stream, p_enc, p_fmt_out );
+
+    p_enc->i_threads = p_sys->i_threads;
+    p_enc->p_cfg = p_cfg->p_video_cfg;
+    p_enc->p_module = module_need( p_enc, "encoder", p_cfg->psz_venc, true );
+    if( !p_enc->p_module )
+    {
+        msg_Err( p_stream, "cannot find rendition video encoder (module:%s fourcc:%4.4s)",
+                 p_cfg->psz_venc ? p_cfg->psz_venc : "any",
+                 (char *)&p_cfg->i_vcodec );
+        return VLC_EGENERIC;
+    }
+    p_enc->fmt_in.video.i_chroma = p_enc->fmt_in.i_codec;
+    p_enc->fmt_out.i_codec = vlc_fourcc_GetCodec( VIDEO_ES, p_enc->fmt_out.i_codec );
+
+    r->p_conv_chain = transcode_video_conv_chain_new( p_stream, p_fmt_out, p_enc );
+    if( !r->p_conv_chain )
+        return VLC_ENOMEM;
+
+    r->id = sout_StreamIdAdd( p_stream->p_next, &p_enc->fmt_out );
+    if( !r->id )
+    {
+        msg_Err( p_stream, "cannot add this stream" );
+        return VLC_EGENERIC;
+    }
+
+    if( transcode_video_rendition_start( p_stream, r ) )
+    {
+        msg_Err( p_stream, "cannot spawn rendition encoder thread" );
+        return VLC_EGENERIC;
+    }
+
+    msg_Dbg( p_stream, "rendition %4.4s %ix%i opened",
+             (char *)&p_enc->fmt_out.i_codec,
+             p_enc->fmt_in.video.i_visible_width,
+             p_enc->fmt_in.video.i_visible_height );
+    return VLC_SUCCESS;
+}
+
+static void transcode_video_renditions_open( sout_stream_t *p_stream,
+                                             sout_stream_id_sys_t *id )
+{
+    for( int i = 0; i < id->i_renditions; )
+    {
+        transcode_rendition_t *r = id->pp_renditions[i];
+
+        if( transcode_video_rendition_open( p_stream, id, r ) == VLC_SUCCESS )
+        {
+            i++;
+            continue;
+        }
+        /* Do not give up on the other renditions */
+        TAB_ERASE( id->i_renditions, id->pp_renditions, i );
+        transcode_rendition_Delete( p_stream, r );
+    }
+}
+
+/* Rebuilds the scalers after the shared filters output changed */
+static void transcode_video_renditions_reinit( sout_stream_t *p_stream,
+                                               sout_stream_id_sys_t *id )
+{
+    const es_format_t *p_fmt_out = transcode_video_filters_fmt_out( id );
+
+    for( int i = 0; i < id->i_renditions; i++ )
+    {
+        transcode_rendition_t *r = id->pp_renditions[i];
+
+        if( !r->b_thread )
+            continue;
+        transcode_video_rendition_drain( r );
+        filter_chain_Delete( r->p_conv_chain );
+        r->p_conv_chain = transcode_video_conv_chain_new( p_stream, p_fmt_out,
+                                                          r->p_encoder );
+        if( !r->p_conv_chain )
+        {
+            transcode_video_rendition_stop( r );
+            transcode_video_rendition_output( p_stream, r );
+        }
+    }
+}
+
 void transcode_video_close( sout_stream_t *p_stream,
                                    sout_stream_id_sys_t *id )
 {
+    static const char *const ppsz_stages[TRANSCODE_STAGE_MAX] = {
+        "decoder", "filters", "encoder"
+    };
+
+    /* Whatever the threads still encode goes out before the stream is
+     * deleted: this is the end of stream if the flush did not happen */
+    transcode_video_filter_thread_stop( p_stream->p_sys );
+    transcode_video_send( p_stream, id->id, p_stream->p_sys->p_filter_buffers );
+    p_stream->p_sys->p_filter_buffers = NULL;
+
     if( p_stream->p_sys->i_threads >= 1 && !p_stream->p_sys->b_abort )
     {
         vlc_mutex_lock( &p_stream->p_sys->lock_out );
@@ -624,7 +985,8 @@ void transcode_video_close( sout_stream_t *p_stream,
         vlc_join( p_stream->p_sys->thread, NULL );
 
         picture_fifo_Delete( p_stream->p_sys->pp_pics );
-        block_ChainRelease( p_stream->p_sys->p_buffers );
+        transcode_video_send( p_stream, id->id, p_stream->p_sys->p_buffers );
+        p_stream->p_sys->p_buffers = NULL;
     }
 
     if( p_stream->p_sys->i_threads >= 1 )
@@ -633,6 +995,30 @@ void transcode_video_close( sout_stream_t *p_stream,
         vlc_cond_destroy( &p_stream->p_sys->cond );
     }
 
+    for( int i = 0; i < TRANSCODE_STAGE_MAX; i++ )
+    {
+        transcode_stage_stats_t *p_stats = &p_stream->p_sys->stats[i];
+
+        msg_Dbg( p_stream, "%s: %llu pictures, %lld ms busy, %lld ms stalled",
+                 ppsz_stages[i], atomic_load( &p_stats->i_pictures ),
+                 atomic_load( &p_stats->i_busy ) / 1000,
+                 atomic_load( &p_stats->i_stalled ) / 1000 );
+    }
+
+    /* Stop renditions, they are deleted with the stream */
+    for( int i = 0; i < id->i_renditions; i++ )
+    {
+        transcode_rendition_t *r = id->pp_renditions[i];
+
+        transcode_video_rendition_stop( r );
+        transcode_video_rendition_output( p_stream, r );
+
+        msg_Dbg( p_stream, "rendition %4.4s: %llu pictures, %lld ms busy",
+                 (char *)&r->p_encoder->fmt_out.i_codec,
+                 atomic_load( &r->stats.i_pictures ),
+                 atomic_load( &r->stats.i_busy ) / 1000 );
+    }
+
     /* Close decoder */
     if( id->p_decoder->p_module )
         module_unneed( id->p_decoder, id->p_decoder->p_module );
@@ -650,6 +1036,8 @@ void transcode_video_close( sout_stream_t *p_stream,
         filter_chain_Delete( id->p_f_chain );
     if( id->p_uf_chain )
         filter_chain_Delete( id->p_uf_chain );
+    if( id->p_conv_chain )
+        filter_chain_Delete( id->p_conv_chain );
 }
 
 static void OutputFrame( sout_stream_t *p_stream, picture_t *p_pic, sout_stream_id_sys_t *id, block_t **out )
@@ -679,7 +1067,8 @@ static void OutputFrame( sout_stream_t *p_stream, picture_t *p_pic, sout_stream_
         /* Overlay subpicture */
         if( p_subpic )
         {
-            if( picture_IsReferenced( p_pic ) && !filter_chain_GetLength( id->p_f_chain ) )
+            if( picture_IsReferenced( p_pic ) &&
+                ( !filter_chain_GetLength( id->p_f_chain ) || id->i_renditions > 0 ) )
             {
                 /* We can't modify the picture, we need to duplicate it,
                  * in this point the picture is already p_encoder->fmt.in format*/
@@ -703,13 +1092,16 @@ static void OutputFrame( sout_stream_t *p_stream, picture_t *p_pic, sout_stream_
     {
         block_t *p_block;
 
-        p_block = id->p_encoder->pf_encode_video( id->p_encoder, p_pic );
+        p_block = transcode_video_encode( p_sys, id, p_pic );
         block_ChainAppend( out, p_block );
     }
 
     if( p_sys->i_threads )
     {
+        mtime_t i_start = mdate();
         vlc_sem_wait( &p_sys->picture_pool_has_room );
+        atomic_fetch_add( &p_sys->stats[TRANSCODE_STAGE_FILTER].i_stalled,
+                          mdate() - i_start );
         vlc_mutex_lock( &p_sys->lock_out );
         picture_fifo_Push( p_sys->pp_pics, p_pic );
         vlc_cond_signal( &p_sys->cond );
@@ -722,6 +1114,166 @@ static void OutputFrame( sout_stream_t *p_stream, picture_t *p_pic, sout_stream_
         picture_Release( p_pic );
 }
 
+static void transcode_video_filter_picture( sout_stream_t *p_stream,
+                                            sout_stream_id_sys_t *id,
+                                            picture_t *p_pic, block_t **out )
+{
+    sout_stream_sys_t *p_sys = p_stream->p_sys;
+
+    atomic_fetch_add( &p_sys->stats[TRANSCODE_STAGE_FILTER].i_pictures, 1 );
+
+    /* Run the filter and output chains; first with the picture,
+     * and then with NULL as many times as we need until they
+     * stop outputting frames.
+     */
+    for ( ;; ) {
+        picture_t *p_filtered_pic = p_pic;
+
+        /* Run filter chain */
+        if( id->p_f_chain )
+            p_filtered_pic = transcode_video_filter( p_sys, id->p_f_chain, p_filtered_pic );
+        if( !p_filtered_pic )
+            break;
+
+        for ( ;; ) {
+            picture_t *p_user_filtered_pic = p_filtered_pic;
+
+            /* Run user specified filter chain */
+            if( id->p_uf_chain )
+                p_user_filtered_pic = transcode_video_filter( p_sys, id->p_uf_chain, p_user_filtered_pic );
+            if( !p_user_filtered_pic )
+                break;
+
+            /* Hand a reference to each rendition */
+            for( int i = 0; i < id->i_renditions; i++ )
+            {
+                if( !id->pp_renditions[i]->b_thread )
+                    continue;
+
+                mtime_t i_start = mdate();
+                transcode_video_rendition_push( id->pp_renditions[i],
+                                                p_user_filtered_pic );
+                atomic_fetch_add( &p_sys->stats[TRANSCODE_STAGE_FILTER].i_stalled,
+                                  mdate() - i_start );
+            }
+
+            /* Scale for the main encoder */
+            if( id->p_conv_chain )
+                p_user_filtered_pic = transcode_video_filter( p_sys, id->p_conv_chain,
+                                                              p_user_filtered_pic );
+            if( p_user_filtered_pic )
+                OutputFrame( p_stream, p_user_filtered_pic, id, out );
+
+            p_filtered_pic = NULL;
+        }
+
+        p_pic = NULL;
+    }
+}
+
+static void* FilterThread( void *obj )
+{
+    sout_stream_t *p_stream = (sout_stream_t *)obj;
+    sout_stream_sys_t *p_sys = p_stream->p_sys;
+    sout_stream_id_sys_t *id = p_sys->id_video;
+    picture_t *p_pic;
+    block_t *p_out;
+    int canc = vlc_savecancel ();
+
+    vlc_mutex_lock( &p_sys->lock_filter );
+    for( ;; )
+    {
+        p_pic = picture_fifo_Pop( p_sys->p_filter_pics );
+        if( p_pic == NULL )
+        {
+            p_sys->b_filter_busy = false;
+            vlc_cond_signal( &p_sys->cond_filter_idle );
+            if( p_sys->b_filter_abort )
+                break;
+            vlc_cond_wait( &p_sys->cond_filter, &p_sys->lock_filter );
+            continue;
+        }
+        vlc_sem_post( &p_sys->filter_has_room );
+
+        /* release lock while filtering */
+        vlc_mutex_unlock( &p_sys->lock_filter );
+        p_out = NULL;
+        transcode_video_filter_picture( p_stream, id, p_pic, &p_out );
+        vlc_mutex_lock( &p_sys->lock_filter );
+
+        block_ChainAppend( &p_sys->p_filter_buffers, p_out );
+    }
+    vlc_mutex_unlock( &p_sys->lock_filter );
+
+    vlc_restorecancel (canc);
+
+    return NULL;
+}
+
+static int transcode_video_filter_thread_start( sout_stream_t *p_stream )
+{
+    sout_stream_sys_t *p_sys = p_stream->p_sys;
+    int i_priority = p_sys->b_high_priority ? VLC_THREAD_PRIORITY_OUTPUT :
+                       VLC_THREAD_PRIORITY_VIDEO;
+
+    p_sys->p_filter_pics = picture_fifo_New();
+    if( p_sys->p_filter_pics == NULL )
+        return VLC_ENOMEM;
+
+    vlc_sem_init( &p_sys->filter_has_room, p_sys->pool_size );
+    vlc_mutex_init( &p_sys->lock_filter );
+    vlc_cond_init( &p_sys->cond_filter );
+    vlc_cond_init( &p_sys->cond_filter_idle );
+    p_sys->p_filter_buffers = NULL;
+    p_sys->b_filter_busy = false;
+    p_sys->b_filter_abort = false;
+    if( vlc_clone( &p_sys->filter_thread, FilterThread, p_stream, i_priority ) )
+    {
+        vlc_cond_destroy( &p_sys->cond_filter_idle );
+        vlc_cond_destroy( &p_sys->cond_filter );
+        vlc_mutex_destroy( &p_sys->lock_filter );
+        vlc_sem_destroy( &p_sys->filter_has_room );
+        picture_fifo_Delete( p_sys->p_filter_pics );
+        return VLC_EGENERIC;
+    }
+    p_sys->b_filter_thread = true;
+    return VLC_SUCCESS;
+}
+
+/* Filters the pending pictures and joins the thread.
+ * The remaining blocks are left in p_sys->p_filter_buffers. */
+static void transcode_video_filter_thread_stop( sout_stream_sys_t *p_sys )
+{
+    if( !p_sys->b_filter_thread )
+        return;
+
+    vlc_mutex_lock( &p_sys->lock_filter );
+    p_sys->b_filter_abort = true;
+    vlc_cond_signal( &p_sys->cond_filter );
+    vlc_mutex_unlock( &p_sys->lock_filter );
+
+    vlc_join( p_sys->filter_thread, NULL );
+    p_sys->b_filter_thread = false;
+
+    vlc_cond_destroy( &p_sys->cond_filter_idle );
+    vlc_cond_destroy( &p_sys->cond_filter );
+    vlc_mutex_destroy( &p_sys->lock_filter );
+    vlc_sem_destroy( &p_sys->filter_has_room );
+    picture_fifo_Delete( p_sys->p_filter_pics );
+}
+
+/* Waits until the filters are idle, before they get reconfigured */
+static void transcode_video_filter_thread_drain( sout_stream_sys_t *p_sys )
+{
+    if( !p_sys->b_filter_thread )
+        return;
+
+    vlc_mutex_lock( &p_sys->lock_filter );
+    while( p_sys->b_filter_busy )
+        vlc_cond_wait( &p_sys->cond_filter_idle, &p_sys->lock_filter );
+    vlc_mutex_unlock( &p_sys->lock_filter );
+}
+
 int transcode_video_process( sout_stream_t *p_stream, sout_stream_id_sys_t *id,
                                     block_t *in, block_t **out )
 {
@@ -731,6 +1283,19 @@ int transcode_video_process( sout_stream_t *p_stream, sout_stream_id_sys_t *id,
 
     if( unlikely( in == NULL ) )
     {
+        /* The filters feed both the renditions and the encoder */
+        transcode_video_filter_thread_stop( p_sys );
+        block_ChainAppend( out, p_sys->p_filter_buffers );
+        p_sys->p_filter_buffers = NULL;
+
+        for( int i = 0; i < id->i_renditions; i++ )
+        {
+            transcode_rendition_t *r = id->pp_renditions[i];
+
+            transcode_video_rendition_stop( r );
+            transcode_video_rendition_output( p_stream, r );
+        }
+
         if( p_sys->i_threads == 0 )
         {
             block_t *p_block;
@@ -749,7 +1314,7 @@ int transcode_video_process( sout_stream_t *p_stream, sout_stream_id_sys_t *id,
 
             vlc_join( p_stream->p_sys->thread, NULL );
             vlc_mutex_lock( &p_sys->lock_out );
-            *out = p_sys->p_buffers;
+            block_ChainAppend( out, p_sys->p_buffers );
             p_sys->p_buffers = NULL;
             vlc_mutex_unlock( &p_sys->lock_out );
 
@@ -759,8 +1324,12 @@ int transcode_video_process( sout_stream_t *p_stream, sout_stream_id_sys_t *id,
     }
 
 
+    mtime_t i_start = mdate();
     while( (p_pic = id->p_decoder->pf_decode_video( id->p_decoder, &in )) )
     {
+        atomic_fetch_add( &p_sys->stats[TRANSCODE_STAGE_DECODE].i_busy,
+                          mdate() - i_start );
+        atomic_fetch_add( &p_sys->stats[TRANSCODE_STAGE_DECODE].i_pictures, 1 );
 
         if( unlikely (
              id->p_encoder->p_module &&
@@ -772,6 +1341,8 @@ int transcode_video_process( sout_stream_t *p_stream, sout_stream_id_sys_t *id,
                         id->fmt_input_video.i_sar_num, id->p_decoder->fmt_out.video.i_sar_num,
                         id->fmt_input_video.i_sar_den, id->p_decoder->fmt_out.video.i_sar_den
                     );
+            transcode_video_filter_thread_drain( p_sys );
+
             /* Close filters */
             if( id->p_f_chain )
                 filter_chain_Delete( id->p_f_chain );
@@ -779,6 +1350,9 @@ int transcode_video_process( sout_stream_t *p_stream, sout_stream_id_sys_t *id,
             if( id->p_uf_chain )
                 filter_chain_Delete( id->p_uf_chain );
             id->p_uf_chain = NULL;
+            if( id->p_conv_chain )
+                filter_chain_Delete( id->p_conv_chain );
+            id->p_conv_chain = NULL;
 
             /* Reinitialize filters */
             id->p_encoder->fmt_out.video.i_visible_width  = p_sys->i_width & ~1;
@@ -787,22 +1361,27 @@ int transcode_video_process( sout_stream_t *p_stream, sout_stream_id_sys_t *id,
 
             transcode_video_filter_init( p_stream, id );
             transcode_video_encoder_init( p_stream, id );
-            conversion_video_filter_append( id );
+            conversion_video_filter_append( p_stream, id );
+            transcode_video_renditions_reinit( p_stream, id );
             memcpy( &id->fmt_input_video, &id->p_decoder->fmt_out.video, sizeof(video_format_t));
         }
 
 
         if( unlikely( !id->p_encoder->p_module ) )
         {
+            transcode_video_filter_thread_drain( p_sys );
+
             if( id->p_f_chain )
                 filter_chain_Delete( id->p_f_chain );
             if( id->p_uf_chain )
                 filter_chain_Delete( id->p_uf_chain );
-            id->p_f_chain = id->p_uf_chain = NULL;
+            if( id->p_conv_chain )
+                filter_chain_Delete( id->p_conv_chain );
+            id->p_f_chain = id->p_uf_chain = id->p_conv_chain = NULL;
 
             transcode_video_filter_init( p_stream, id );
             transcode_video_encoder_init( p_stream, id );
-            conversion_video_filter_append( id );
+            conversion_video_filter_append( p_stream, id );
             memcpy( &id->fmt_input_video, &id->p_decoder->fmt_out.video, sizeof(video_format_t));
 
             if( transcode_video_encoder_open( p_stream, id ) != VLC_SUCCESS )
@@ -813,48 +1392,51 @@ int transcode_video_process( sout_stream_t *p_stream, sout_stream_id_sys_t *id,
                 id->b_transcode = false;
                 return VLC_EGENERIC;
             }
+            transcode_video_renditions_open( p_stream, id );
         }
 
-        /* Run the filter and output chains; first with the picture,
-         * and then with NULL as many times as we need until they
-         * stop outputting frames.
-         */
-        for ( ;; ) {
-            picture_t *p_filtered_pic = p_pic;
-
-            /* Run filter chain */
-            if( id->p_f_chain )
-                p_filtered_pic = filter_chain_VideoFilter( id->p_f_chain, p_filtered_pic );
-            if( !p_filtered_pic )
-                break;
-
-            for ( ;; ) {
-                picture_t *p_user_filtered_pic = p_filtered_pic;
-
-                /* Run user specified filter chain */
-                if( id->p_uf_chain )
-                    p_user_filtered_pic = filter_chain_VideoFilter( id->p_uf_chain, p_user_filtered_pic );
-                if( !p_user_filtered_pic )
-                    break;
-
-                OutputFrame( p_stream, p_user_filtered_pic, id, out );
+        if( p_sys->b_filter_thread )
+        {
+            mtime_t i_start = mdate();
+            vlc_sem_wait( &p_sys->filter_has_room );
+            atomic_fetch_add( &p_sys->stats[TRANSCODE_STAGE_DECODE].i_stalled,
+                              mdate() - i_start );
+
+            vlc_mutex_lock( &p_sys->lock_filter );
+            picture_fifo_Push( p_sys->p_filter_pics, p_pic );
+            p_sys->b_filter_busy = true;
+            vlc_cond_signal( &p_sys->cond_filter );
+            vlc_mutex_unlock( &p_sys->lock_filter );
+        }
+        else
+            transcode_video_filter_picture( p_stream, id, p_pic, out );
 
-                p_filtered_pic = NULL;
-            }
+        i_start = mdate();
+    }
+    atomic_fetch_add( &p_sys->stats[TRANSCODE_STAGE_DECODE].i_busy,
+                      mdate() - i_start );
 
-            p_pic = NULL;
-        }
+    if( p_sys->b_filter_thread )
+    {
+        /* Pick up what the filters thread encoded itself */
+        vlc_mutex_lock( &p_sys->lock_filter );
+        block_ChainAppend( out, p_sys->p_filter_buffers );
+        p_sys->p_filter_buffers = NULL;
+        vlc_mutex_unlock( &p_sys->lock_filter );
     }
 
     if( p_sys->i_threads >= 1 )
     {
         /* Pick up any return data the encoder thread wants to output. */
         vlc_mutex_lock( &p_sys->lock_out );
-        *out = p_sys->p_buffers;
+        block_ChainAppend( out, p_sys->p_buffers );
         p_sys->p_buffers = NULL;
         vlc_mutex_unlock( &p_sys->lock_out );
     }
 
+    for( int i = 0; i < id->i_renditions; i++ )
+        transcode_video_rendition_output( p_stream, id->pp_renditions[i] );
+
     return VLC_SUCCESS;
 }
 
@@ -890,6 +1472,29 @@ bool transcode_video_add( sout_stream_t *p_stream, const es_format_t *p_fmt,
         id->p_encoder->fmt_in.video.i_frame_rate_base = id->p_encoder->fmt_out.video.i_frame_rate_base = (p_sys->fps_den ? p_sys->fps_den : 1);
     }
 
+    /* Renditions encoders are opened along with the main one */
+    for( int i = 0; i < p_sys->i_renditions; i++ )
+    {
+        const transcode_rendition_cfg_t *p_cfg = p_sys->pp_renditions[i];
+        transcode_rendition_t *r;
+
+        if( !p_cfg->i_vcodec )
+            continue;
+        r = transcode_rendition_New( p_stream, id, p_cfg );
+        if( !r )
+            continue;
+
+        r->p_encoder->fmt_out.i_codec = p_cfg->i_vcodec;
+        r->p_encoder->fmt_out.video.i_visible_width  = p_cfg->i_width & ~1;
+        r->p_encoder->fmt_out.video.i_visible_height = p_cfg->i_height & ~1;
+        r->p_encoder->fmt_out.i_bitrate = p_cfg->i_vbitrate;
+        r->p_encoder->fmt_out.video.i_frame_rate =
+            id->p_encoder->fmt_out.video.i_frame_rate;
+        r->p_encoder->fmt_out.video.i_frame_rate_base =
+            id->p_encoder->fmt_out.video.i_frame_rate_base;
+        TAB_APPEND( id->i_renditions, id->pp_renditions, r );
+    }
+
     return true;
 }
 
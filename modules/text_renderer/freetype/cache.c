@@ -0,0 +1,437 @@
+/*****************************************************************************
+ * cache.c : Glyph and layout caches for the freetype text renderer
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ * $Id$
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/** \ingroup freetype
+ * @{
+ * \file
+ * Glyph and layout caches
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+#include <vlc_filter.h>
+#include <vlc_text_style.h>
+
+#include "freetype.h"
+#include "text_layout.h"
+#include "cache.h"
+
+/*****************************************************************************
+ * Glyph cache
+ *****************************************************************************/
+typedef struct glyph_entry_t glyph_entry_t;
+struct glyph_entry_t
+{
+    glyph_cache_key_t key;
+    FT_Glyph          p_glyph;
+    FT_Glyph          p_outline;
+    FT_Vector         advance;
+
+    glyph_entry_t    *p_hash_next;
+    glyph_entry_t    *p_lru_prev;  /* more recently used */
+    glyph_entry_t    *p_lru_next;  /* less recently used */
+};
+
+struct glyph_cache_t
+{
+    glyph_entry_t **pp_buckets;
+    unsigned        i_buckets;     /* power of 2 */
+    unsigned        i_count;
+    unsigned        i_max;
+    glyph_entry_t  *p_lru_first;
+    glyph_entry_t  *p_lru_last;
+    cache_stats_t   stats;
+};
+
+static unsigned GlyphKeyHash( const glyph_cache_key_t *p_key )
+{
+    uint64_t h = (uintptr_t)p_key->p_face;
+    h ^= (uint64_t)p_key->i_index * UINT64_C(0x9E3779B97F4A7C15);
+    h ^= (uint64_t)p_key->i_radius << 7;
+    h ^= p_key->i_flags;
+    return h ^ (h >> 29);
+}
+
+static bool GlyphKeyEquals( const glyph_cache_key_t *a,
+                            const glyph_cache_key_t *b )
+{
+    return a->p_face == b->p_face && a->i_index == b->i_index
+        && a->i_flags == b->i_flags && a->i_radius == b->i_radius;
+}
+
+static void GlyphLruUnlink( glyph_cache_t *p_cache, glyph_entry_t *p_entry )
+{
+    if( p_entry->p_lru_prev )
+        p_entry->p_lru_prev->p_lru_next = p_entry->p_lru_next;
+    else
+        p_cache->p_lru_first = p_entry->p_lru_next;
+    if( p_entry->p_lru_next )
+        p_entry->p_lru_next->p_lru_prev = p_entry->p_lru_prev;
+    else
+        p_cache->p_lru_last = p_entry->p_lru_prev;
+}
+
+static void GlyphLruPushFront( glyph_cache_t *p_cache, glyph_entry_t *p_entry )
+{
+    p_entry->p_lru_prev = NULL;
+    p_entry->p_lru_next = p_cache->p_lru_first;
+    if( p_cache->p_lru_first )
+        p_cache->p_lru_first->p_lru_prev = p_entry;
+    else
+        p_cache->p_lru_last = p_entry;
+    p_cache->p_lru_first = p_entry;
+}
+
+static void GlyphEntryDelete( glyph_entry_t *p_entry )
+{
+    FT_Done_Glyph( p_entry->p_glyph );
+    if( p_entry->p_outline )
+        FT_Done_Glyph( p_entry->p_outline );
+    free( p_entry );
+}
+
+static void GlyphCacheEvict( glyph_cache_t *p_cache )
+{
+    glyph_entry_t *p_entry = p_cache->p_lru_last;
+    glyph_entry_t **pp = &p_cache->pp_buckets[ GlyphKeyHash( &p_entry->key )
+                                               & (p_cache->i_buckets - 1) ];
+    while( *pp != p_entry )
+        pp = &(*pp)->p_hash_next;
+    *pp = p_entry->p_hash_next;
+
+    GlyphLruUnlink( p_cache, p_entry );
+    GlyphEntryDelete( p_entry );
+    p_cache->i_count--;
+    p_cache->stats.i_evictions++;
+}
+
+glyph_cache_t *GlyphCache_New( unsigned i_max )
+{
+    if( i_max == 0 )
+        return NULL;
+
+    glyph_cache_t *p_cache = calloc( 1, sizeof( *p_cache ) );
+    if( !p_cache )
+        return NULL;
+
+    /* Keep the load factor below 1 */
+    p_cache->i_buckets = 16;
+    while( p_cache->i_buckets < i_max )
+        p_cache->i_buckets <<= 1;
+
+    p_cache->pp_buckets = calloc( p_cache->i_buckets,
+                                  sizeof( *p_cache->pp_buckets ) );
+    if( !p_cache->pp_buckets )
+    {
+        free( p_cache );
+        return NULL;
+    }
+    p_cache->i_max = i_max;
+    return p_cache;
+}
+
+void GlyphCache_Delete( glyph_cache_t *p_cache )
+{
+    for( glyph_entry_t *p_entry = p_cache->p_lru_first; p_entry; )
+    {
+        glyph_entry_t *p_next = p_entry->p_lru_next;
+        GlyphEntryDelete( p_entry );
+        p_entry = p_next;
+    }
+    free( p_cache->pp_buckets );
+    free( p_cache );
+}
+
+int GlyphCache_Get( glyph_cache_t *p_cache, const glyph_cache_key_t *p_key,
+                    FT_Glyph *pp_glyph, FT_Glyph *pp_outline,
+                    FT_Vector *p_advance )
+{
+    glyph_entry_t *p_entry =
+        p_cache->pp_buckets[ GlyphKeyHash( p_key ) & (p_cache->i_buckets - 1) ];
+    while( p_entry && !GlyphKeyEquals( &p_entry->key, p_key ) )
+        p_entry = p_entry->p_hash_next;
+
+    if( !p_entry )
+    {
+        p_cache->stats.i_misses++;
+        return VLC_EGENERIC;
+    }
+
+    if( FT_Glyph_Copy( p_entry->p_glyph, pp_glyph ) )
+        return VLC_EGENERIC;
+    *pp_outline = NULL;
+    if( p_entry->p_outline && FT_Glyph_Copy( p_entry->p_outline, pp_outline ) )
+    {
+        FT_Done_Glyph( *pp_glyph );
+        return VLC_EGENERIC;
+    }
+    *p_advance = p_entry->advance;
+
+    if( p_cache->p_lru_first != p_entry )
+    {
+        GlyphLruUnlink( p_cache, p_entry );
+        GlyphLruPushFront( p_cache, p_entry );
+    }
+    p_cache->stats.i_hits++;
+    return VLC_SUCCESS;
+}
+
+void GlyphCache_Put( glyph_cache_t *p_cache, const glyph_cache_key_t *p_key,
+                     FT_Glyph p_glyph, FT_Glyph p_outline,
+                     const FT_Vector *p_advance )
+{
+    glyph_entry_t *p_entry = malloc( sizeof( *p_entry ) );
+    if( unlikely( !p_entry ) )
+        return;
+
+    if( FT_Glyph_Copy( p_glyph, &p_entry->p_glyph ) )
+    {
+        free( p_entry );
+        return;
+    }
+    p_entry->p_outline = NULL;
+    if( p_outline && FT_Glyph_Copy( p_outline, &p_entry->p_outline ) )
+    {
+        FT_Done_Glyph( p_entry->p_glyph );
+        free( p_entry );
+        return;
+    }
+    p_entry->key = *p_key;
+    p_entry->advance = *p_advance;
+
+    if( p_cache->i_count >= p_cache->i_max )
+        GlyphCacheEvict( p_cache );
+
+    glyph_entry_t **pp_bucket =
+        &p_cache->pp_buckets[ GlyphKeyHash( p_key ) & (p_cache->i_buckets - 1) ];
+    p_entry->p_hash_next = *pp_bucket;
+    *pp_bucket = p_entry;
+    GlyphLruPushFront( p_cache, p_entry );
+    p_cache->i_count++;
+}
+
+const cache_stats_t *GlyphCache_Stats( const glyph_cache_t *p_cache )
+{
+    return &p_cache->stats;
+}
+
+/*****************************************************************************
+ * Line cache
+ *****************************************************************************/
+typedef struct
+{
+    layout_params_t params;
+    uint32_t        i_hash;
+    uni_char_t     *psz_text;
+    text_style_t  **pp_styles;
+    size_t          i_length;
+    size_t          i_styles;
+    uint64_t        i_last_use;
+
+    line_desc_t    *p_lines;
+    FT_BBox         bbox;
+    int             i_max_face_height;
+} line_entry_t;
+
+struct line_cache_t
+{
+    line_entry_t   *p_entries;
+    unsigned        i_count;
+    unsigned        i_max;
+    uint64_t        i_clock;
+    cache_stats_t   stats;
+};
+
+static uint32_t TextHash( const uni_char_t *psz_text, size_t i_length )
+{
+    /* FNV-1a */
+    uint32_t h = 2166136261u;
+    for( size_t i = 0; i < i_length; i++ )
+    {
+        h ^= psz_text[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static bool StringEquals( const char *a, const char *b )
+{
+    if( a == NULL || b == NULL )
+        return a == b;
+    return !strcmp( a, b );
+}
+
+static bool StyleEquals( const text_style_t *a, const text_style_t *b )
+{
+    if( a == b )
+        return true;
+
+    return a->i_features == b->i_features
+        && a->i_style_flags == b->i_style_flags
+        && a->f_font_relsize == b->f_font_relsize
+        && a->i_font_size == b->i_font_size
+        && a->i_font_color == b->i_font_color
+        && a->i_font_alpha == b->i_font_alpha
+        && a->i_spacing == b->i_spacing
+        && a->i_outline_color == b->i_outline_color
+        && a->i_outline_alpha == b->i_outline_alpha
+        && a->i_outline_width == b->i_outline_width
+        && a->i_shadow_color == b->i_shadow_color
+        && a->i_shadow_alpha == b->i_shadow_alpha
+        && a->i_shadow_width == b->i_shadow_width
+        && a->i_background_color == b->i_background_color
+        && a->i_background_alpha == b->i_background_alpha
+        && a->i_karaoke_background_color == b->i_karaoke_background_color
+        && a->i_karaoke_background_alpha == b->i_karaoke_background_alpha
+        && StringEquals( a->psz_fontname, b->psz_fontname )
+        && StringEquals( a->psz_monofontname, b->psz_monofontname );
+}
+
+static bool ParamsEquals( const layout_params_t *a, const layout_params_t *b )
+{
+    return a->i_visible_width == b->i_visible_width
+        && a->i_video_height == b->i_video_height
+        && a->i_scale == b->i_scale
+        && a->i_outline_thickness == b->i_outline_thickness
+        && a->b_grid == b->b_grid;
+}
+
+static bool LineEntryMatches( const line_entry_t *p_entry, uint32_t i_hash,
+                              const layout_params_t *p_params,
+                              const uni_char_t *psz_text,
+                              text_style_t *const *pp_styles, size_t i_length )
+{
+    if( p_entry->i_hash != i_hash || p_entry->i_length != i_length
+     || !ParamsEquals( &p_entry->params, p_params )
+     || memcmp( p_entry->psz_text, psz_text, i_length * sizeof( *psz_text ) ) )
+        return false;
+
+    for( size_t i = 0; i < i_length; i++ )
+    {
+        /* Styles are shared by all the characters of a segment */
+        if( i > 0 && pp_styles[i] == pp_styles[i - 1]
+         && p_entry->pp_styles[i] == p_entry->pp_styles[i - 1] )
+            continue;
+        if( !StyleEquals( p_entry->pp_styles[i], pp_styles[i] ) )
+            return false;
+    }
+    return true;
+}
+
+static void LineEntryClean( line_entry_t *p_entry )
+{
+    FreeLines( p_entry->p_lines );
+    free( p_entry->psz_text );
+    FreeStylesArray( p_entry->pp_styles, p_entry->i_styles );
+}
+
+line_cache_t *LineCache_New( unsigned i_max )
+{
+    if( i_max == 0 )
+        return NULL;
+
+    line_cache_t *p_cache = calloc( 1, sizeof( *p_cache ) );
+    if( !p_cache )
+        return NULL;
+
+    p_cache->p_entries = calloc( i_max, sizeof( *p_cache->p_entries ) );
+    if( !p_cache->p_entries )
+    {
+        free( p_cache );
+        return NULL;
+    }
+    p_cache->i_max = i_max;
+    return p_cache;
+}
+
+void LineCache_Delete( line_cache_t *p_cache )
+{
+    for( unsigned i = 0; i < p_cache->i_count; i++ )
+        LineEntryClean( &p_cache->p_entries[i] );
+    free( p_cache->p_entries );
+    free( p_cache );
+}
+
+line_desc_t *LineCache_Get( line_cache_t *p_cache,
+                            const layout_params_t *p_params,
+                            const uni_char_t *psz_text,
+                            text_style_t *const *pp_styles, size_t i_length,
+                            FT_BBox *p_bbox, int *pi_max_face_height )
+{
+    const uint32_t i_hash = TextHash( psz_text, i_length );
+
+    for( unsigned i = 0; i < p_cache->i_count; i++ )
+    {
+        line_entry_t *p_entry = &p_cache->p_entries[i];
+        if( LineEntryMatches( p_entry, i_hash, p_params,
+                              psz_text, pp_styles, i_length ) )
+        {
+            p_entry->i_last_use = ++p_cache->i_clock;
+            p_cache->stats.i_hits++;
+            *p_bbox = p_entry->bbox;
+            *pi_max_face_height = p_entry->i_max_face_height;
+            return p_entry->p_lines;
+        }
+    }
+
+    p_cache->stats.i_misses++;
+    return NULL;
+}
+
+void LineCache_Put( line_cache_t *p_cache, const layout_params_t *p_params,
+                    uni_char_t *psz_text, text_style_t **pp_styles,
+                    size_t i_length, size_t i_styles,
+                    line_desc_t *p_lines, const FT_BBox *p_bbox,
+                    int i_max_face_height )
+{
+    line_entry_t *p_entry;
+
+    if( p_cache->i_count < p_cache->i_max )
+        p_entry = &p_cache->p_entries[p_cache->i_count++];
+    else
+    {
+        p_entry = &p_cache->p_entries[0];
+        for( unsigned i = 1; i < p_cache->i_count; i++ )
+            if( p_cache->p_entries[i].i_last_use < p_entry->i_last_use )
+                p_entry = &p_cache->p_entries[i];
+        LineEntryClean( p_entry );
+        p_cache->stats.i_evictions++;
+    }
+
+    p_entry->params = *p_params;
+    p_entry->i_hash = TextHash( psz_text, i_length );
+    p_entry->psz_text = psz_text;
+    p_entry->pp_styles = pp_styles;
+    p_entry->i_length = i_length;
+    p_entry->i_styles = i_styles;
+    p_entry->i_last_use = ++p_cache->i_clock;
+    p_entry->p_lines = p_lines;
+    p_entry->bbox = *p_bbox;
+    p_entry->i_max_face_height = i_max_face_height;
+}
+
+const cache_stats_t *LineCache_Stats( const line_cache_t *p_cache )
+{
+    return &p_cache->stats;
+}
@@ -0,0 +1,131 @@
+/*****************************************************************************
+ * cache.h : Glyph and layout caches for the freetype text renderer
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ * $Id$
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_FREETYPE_CACHE_H
+#define VLC_FREETYPE_CACHE_H
+
+/** \ingroup freetype
+ * @{
+ * \file
+ * Glyph and layout caches
+ *
+ * Both caches are only ever accessed from the Render() callback, which the
+ * subpicture unit never calls concurrently, so they do not lock.
+ */
+
+#include "freetype.h"
+#include "text_layout.h"
+
+typedef struct
+{
+    uint64_t i_hits;
+    uint64_t i_misses;
+    uint64_t i_evictions;
+} cache_stats_t;
+
+/**
+ * Identifies one loaded glyph. The face already embeds the pixel size,
+ * since faces are cached per font file and size.
+ */
+typedef struct
+{
+    FT_Face  p_face;
+    FT_UInt  i_index;     /**< glyph index within p_face */
+    uint16_t i_flags;     /**< STYLE_BOLD / STYLE_ITALIC emboldening flags */
+    FT_Fixed i_radius;    /**< outline stroker radius, 0 without outline */
+} glyph_cache_key_t;
+
+typedef struct glyph_cache_t glyph_cache_t;
+
+/**
+ * Creates a LRU cache of at most \p i_max loaded glyphs.
+ * Returns NULL if \p i_max is 0 or on allocation failure.
+ */
+glyph_cache_t *GlyphCache_New( unsigned i_max );
+void GlyphCache_Delete( glyph_cache_t *p_cache );
+
+/**
+ * Looks up a glyph. On hit, \p pp_glyph and \p pp_outline receive copies
+ * owned by the caller (the outline may be NULL).
+ *
+ * \return VLC_SUCCESS on hit, VLC_EGENERIC otherwise
+ */
+int GlyphCache_Get( glyph_cache_t *p_cache, const glyph_cache_key_t *p_key,
+                    FT_Glyph *pp_glyph, FT_Glyph *pp_outline,
+                    FT_Vector *p_advance );
+
+/**
+ * Stores copies of a freshly loaded glyph and its outline (which may be NULL).
+ */
+void GlyphCache_Put( glyph_cache_t *p_cache, const glyph_cache_key_t *p_key,
+                     FT_Glyph p_glyph, FT_Glyph p_outline,
+                     const FT_Vector *p_advance );
+
+const cache_stats_t *GlyphCache_Stats( const glyph_cache_t *p_cache );
+
+/**
+ * Everything besides the text and its styles which changes the result of
+ * LayoutText()
+ */
+typedef struct
+{
+    unsigned i_visible_width;
+    unsigned i_video_height;
+    int      i_scale;
+    int      i_outline_thickness;
+    bool     b_grid;
+} layout_params_t;
+
+typedef struct line_cache_t line_cache_t;
+
+/**
+ * Creates a LRU cache of at most \p i_max laid out texts.
+ * Returns NULL if \p i_max is 0 or on allocation failure.
+ */
+line_cache_t *LineCache_New( unsigned i_max );
+void LineCache_Delete( line_cache_t *p_cache );
+
+/**
+ * Looks up the lines previously laid out for the same text, styles and
+ * parameters. The returned lines remain owned by the cache and are valid
+ * until the next LineCache_Put() or LineCache_Delete().
+ *
+ * \return the lines, or NULL on miss
+ */
+line_desc_t *LineCache_Get( line_cache_t *p_cache,
+                            const layout_params_t *p_params,
+                            const uni_char_t *psz_text,
+                            text_style_t *const *pp_styles, size_t i_length,
+                            FT_BBox *p_bbox, int *pi_max_face_height );
+
+/**
+ * Transfers ownership of the text, styles (as released by FreeStylesArray())
+ * and lines to the cache, evicting the least recently used entry if full.
+ */
+void LineCache_Put( line_cache_t *p_cache, const layout_params_t *p_params,
+                    uni_char_t *psz_text, text_style_t **pp_styles,
+                    size_t i_length, size_t i_styles,
+                    line_desc_t *p_lines, const FT_BBox *p_bbox,
+                    int i_max_face_height );
+
+const cache_stats_t *LineCache_Stats( const line_cache_t *p_cache );
+
+#endif
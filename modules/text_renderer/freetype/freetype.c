@@ -71,6 +71,7 @@
 #include "platform_fonts.h"
 #include "freetype.h"
 #include "text_layout.h"
+#include "cache.h"
 
 /*****************************************************************************
  * Module descriptor
@@ -116,6 +117,14 @@ static void Destroy( vlc_object_t * );
 #define SHADOW_ANGLE_TEXT N_("Shadow angle")
 #define SHADOW_DISTANCE_TEXT N_("Shadow distance")
 
+#define GLYPH_CACHE_TEXT N_("Glyph cache size")
+#define GLYPH_CACHE_LONGTEXT N_("Number of loaded and outlined glyphs kept " \
+    "for reuse. 0 disables the cache." )
+#define LINE_CACHE_TEXT N_("Layout cache size")
+#define LINE_CACHE_LONGTEXT N_("Number of rendered texts kept for reuse " \
+    "when the same text is displayed again, like with tickers or karaoke. " \
+    "0 disables the cache." )
+
 #define TEXT_DIRECTION_TEXT N_("Text direction")
 #define TEXT_DIRECTION_LONGTEXT N_("Paragraph base direction for the Unicode bi-directional algorithm.")
 
@@ -232,6 +241,11 @@ vlc_module_begin ()
     add_bool( "freetype-yuvp", false, YUVP_TEXT,
               YUVP_LONGTEXT, true )
 
+    add_integer_with_range( "freetype-glyph-cache", 1024, 0, 65536,
+                            GLYPH_CACHE_TEXT, GLYPH_CACHE_LONGTEXT, true )
+    add_integer_with_range( "freetype-layout-cache", 16, 0, 1024,
+                            LINE_CACHE_TEXT, LINE_CACHE_LONGTEXT, true )
+
 #ifdef HAVE_FRIBIDI
     add_integer_with_range( "freetype-text-direction", 0, 0, 2, TEXT_DIRECTION_TEXT,
                             TEXT_DIRECTION_LONGTEXT, false )
@@ -966,7 +980,7 @@ static void FillDefaultStyles( filter_t *p_filter )
     text_style_Merge( p_sys->p_default_style, p_sys->p_forced_style, true );
 }
 
-static void FreeStylesArray( text_style_t **pp_styles, size_t i_styles )
+void FreeStylesArray( text_style_t **pp_styles, size_t i_styles )
 {
     text_style_t *p_style = NULL;
     for( size_t i = 0; i< i_styles; i++ )
@@ -1096,9 +1110,25 @@ static int Render( filter_t *p_filter, subpicture_region_t *p_region_out,
 
     uint32_t *pi_k_durations   = NULL;
 
-    rv = LayoutText( p_filter,
-                     &p_lines, &bbox, &i_max_face_height,
-                     psz_text, pp_styles, pi_k_durations, i_text_length, p_region_in->b_gridmode );
+    const layout_params_t params = {
+        .i_visible_width     = p_filter->fmt_out.video.i_visible_width,
+        .i_video_height      = p_filter->fmt_out.video.i_height,
+        .i_scale             = p_sys->i_scale,
+        .i_outline_thickness = var_InheritInteger( p_filter, "freetype-outline-thickness" ),
+        .b_grid              = b_grid,
+    };
+    bool b_cached = false;
+
+    if( p_sys->p_line_cache && !pi_k_durations )
+        p_lines = LineCache_Get( p_sys->p_line_cache, &params,
+                                 psz_text, pp_styles, i_text_length,
+                                 &bbox, &i_max_face_height );
+    if( p_lines )
+        b_cached = true;
+    else
+        rv = LayoutText( p_filter,
+                         &p_lines, &bbox, &i_max_face_height,
+                         psz_text, pp_styles, pi_k_durations, i_text_length, p_region_in->b_gridmode );
 
     p_region_out->i_x = p_region_in->i_x;
     p_region_out->i_y = p_region_in->i_y;
@@ -1153,10 +1183,20 @@ static int Render( filter_t *p_filter, subpicture_region_t *p_region_out,
             var_SetBool( p_filter, "text-rerender", true );
     }
 
-    FreeLines( p_lines );
-
-    free( psz_text );
-    FreeStylesArray( pp_styles, i_styles );
+    if( !b_cached && !rv && p_lines && p_sys->p_line_cache && !pi_k_durations )
+    {
+        /* The cache now owns the text and styles the lines refer to */
+        LineCache_Put( p_sys->p_line_cache, &params, psz_text, pp_styles,
+                       i_text_length, i_styles, p_lines, &bbox,
+                       i_max_face_height );
+    }
+    else
+    {
+        if( !b_cached )
+            FreeLines( p_lines );
+        free( psz_text );
+        FreeStylesArray( pp_styles, i_styles );
+    }
     free( pi_k_durations );
 
     return rv;
@@ -1292,6 +1332,12 @@ static int Create( vlc_object_t *p_this )
         goto error;
     }
 
+    /* Caches are optional: rendering works without them */
+    p_sys->p_glyph_cache =
+        GlyphCache_New( var_InheritInteger( p_filter, "freetype-glyph-cache" ) );
+    p_sys->p_line_cache =
+        LineCache_New( var_InheritInteger( p_filter, "freetype-layout-cache" ) );
+
     p_filter->pf_render = Render;
 
     return VLC_SUCCESS;
@@ -1326,6 +1372,24 @@ static void Destroy( vlc_object_t *p_this )
     DumpDictionary( p_filter, &p_sys->fallback_map, true, -1 );
 #endif
 
+    /* Caches reference the faces and the default style: release them first */
+    if( p_sys->p_line_cache )
+    {
+        const cache_stats_t *p_stats = LineCache_Stats( p_sys->p_line_cache );
+        msg_Dbg( p_filter, "layout cache: %"PRIu64" hits, %"PRIu64" misses, "
+                 "%"PRIu64" evictions", p_stats->i_hits, p_stats->i_misses,
+                 p_stats->i_evictions );
+        LineCache_Delete( p_sys->p_line_cache );
+    }
+    if( p_sys->p_glyph_cache )
+    {
+        const cache_stats_t *p_stats = GlyphCache_Stats( p_sys->p_glyph_cache );
+        msg_Dbg( p_filter, "glyph cache: %"PRIu64" hits, %"PRIu64" misses, "
+                 "%"PRIu64" evictions", p_stats->i_hits, p_stats->i_misses,
+                 p_stats->i_evictions );
+        GlyphCache_Delete( p_sys->p_glyph_cache );
+    }
+
     /* Attachments */
     if( p_sys->pp_font_attachments )
     {
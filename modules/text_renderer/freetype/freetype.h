@@ -111,6 +111,12 @@ struct filter_sys_t
     /** Font face cache */
     vlc_dictionary_t  face_map;
 
+    /** Loaded glyphs cache, NULL if disabled */
+    struct glyph_cache_t *p_glyph_cache;
+
+    /** Laid out texts cache, NULL if disabled */
+    struct line_cache_t  *p_line_cache;
+
     int               i_fallback_counter;
 
     /* Current scaling of the text, default is 100 (%) */
@@ -149,4 +155,13 @@ struct filter_sys_t
 FT_Face SelectAndLoadFace( filter_t *p_filter, const text_style_t *p_style,
                            uni_char_t codepoint );
 
+/**
+ * Releases an array of per-character styles, where consecutive characters
+ * share the same style
+ *
+ * \param pp_styles the styles array [IN]
+ * \param i_styles number of entries in \p pp_styles [IN]
+ */
+void FreeStylesArray( text_style_t **pp_styles, size_t i_styles );
+
 #endif
@@ -65,6 +65,7 @@
 #include "freetype.h"
 #include "text_layout.h"
 #include "platform_fonts.h"
+#include "cache.h"
 
 /* Win32 */
 #ifdef _WIN32
@@ -957,18 +958,25 @@ static int LoadGlyphs( filter_t *p_filter, paragraph_t *p_paragraph,
         else
             p_face = p_run->p_face;
 
+        int i_radius = 0;
         if( p_sys->p_stroker && (p_style->i_style_flags & STYLE_OUTLINE) )
         {
             double f_outline_thickness =
                 var_InheritInteger( p_filter, "freetype-outline-thickness" ) / 100.0;
             f_outline_thickness = VLC_CLIP( f_outline_thickness, 0.0, 0.5 );
-            int i_radius = ( i_live_size << 6 ) * f_outline_thickness;
+            i_radius = ( i_live_size << 6 ) * f_outline_thickness;
             FT_Stroker_Set( p_sys->p_stroker,
                             i_radius,
                             FT_STROKER_LINECAP_ROUND,
                             FT_STROKER_LINEJOIN_ROUND, 0 );
         }
 
+        glyph_cache_key_t key = {
+            .p_face   = p_face,
+            .i_flags  = p_style->i_style_flags & (STYLE_BOLD | STYLE_ITALIC),
+            .i_radius = i_radius,
+        };
+
         for( int j = p_run->i_start_offset; j < p_run->i_end_offset; ++j )
         {
             int i_glyph_index;
@@ -1019,6 +1027,25 @@ static int LoadGlyphs( filter_t *p_filter, paragraph_t *p_paragraph,
                     SKIP_GLYPH( p_bitmaps )
             }
 
+            key.i_index = i_glyph_index;
+            FT_Vector advance;
+            if( p_sys->p_glyph_cache
+             && !GlyphCache_Get( p_sys->p_glyph_cache, &key,
+                                 &p_bitmaps->p_glyph, &p_bitmaps->p_outline,
+                                 &advance ) )
+            {
+                p_bitmaps->p_shadow = NULL;
+                if( p_style->i_shadow_alpha != STYLE_ALPHA_TRANSPARENT )
+                    p_bitmaps->p_shadow = p_bitmaps->p_outline ?
+                                          p_bitmaps->p_outline : p_bitmaps->p_glyph;
+                if( b_overwrite_advance )
+                {
+                    p_bitmaps->i_x_advance = advance.x;
+                    p_bitmaps->i_y_advance = advance.y;
+                }
+                continue;
+            }
+
             if( FT_Load_Glyph( p_face, i_glyph_index,
                                FT_LOAD_NO_BITMAP | FT_LOAD_DEFAULT )
              && FT_Load_Glyph( p_face, i_glyph_index, FT_LOAD_DEFAULT ) )
@@ -1048,6 +1075,11 @@ static int LoadGlyphs( filter_t *p_filter, paragraph_t *p_paragraph,
                 p_bitmaps->p_shadow = p_bitmaps->p_outline ?
                                       p_bitmaps->p_outline : p_bitmaps->p_glyph;
 
+            if( p_sys->p_glyph_cache )
+                GlyphCache_Put( p_sys->p_glyph_cache, &key,
+                                p_bitmaps->p_glyph, p_bitmaps->p_outline,
+                                &p_face->glyph->advance );
+
             if( b_overwrite_advance )
             {
                 p_bitmaps->i_x_advance = p_face->glyph->advance.x;
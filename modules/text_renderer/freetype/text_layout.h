@@ -25,6 +25,9 @@
  * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
  *****************************************************************************/
 
+#ifndef VLC_FREETYPE_TEXT_LAYOUT_H
+#define VLC_FREETYPE_TEXT_LAYOUT_H
+
 /** \ingroup freetype
  * @{
  * \file
@@ -79,3 +82,5 @@ int LayoutText(filter_t *p_filter, line_desc_t **pp_lines,
                 FT_BBox *p_bbox, int *pi_max_face_height,
                 const uni_char_t *psz_text, text_style_t **pp_styles,
                 uint32_t *pi_k_dates, int i_len, bool b_grid );
+
+#endif
@@ -56,6 +56,11 @@ static void CloseScaler( vlc_object_t * );
 
 #define SCALEMODE_TEXT N_("Scaling mode")
 #define SCALEMODE_LONGTEXT N_("Scaling mode to use.")
+#define THREADS_TEXT N_("Threads")
+#define THREADS_LONGTEXT N_("Number of threads scaling horizontal bands " \
+    "of large pictures in parallel (0 = automatic, 1 = disabled). " \
+    "Scaling filters that reach across band edges may differ slightly " \
+    "from a single pass.")
 
 static const int pi_mode_values[] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 };
 const char *const ppsz_mode_descriptions[] =
@@ -73,6 +78,8 @@ vlc_module_begin ()
     set_callbacks( OpenScaler, CloseScaler )
     add_integer( "swscale-mode", 2, SCALEMODE_TEXT, SCALEMODE_LONGTEXT, true )
         change_integer_list( pi_mode_values, ppsz_mode_descriptions )
+    add_integer_with_range( "swscale-threads", 1, 0, 16,
+                            THREADS_TEXT, THREADS_LONGTEXT, true )
 vlc_module_end ()
 
 /* Version checking */
@@ -82,13 +89,28 @@ vlc_module_end ()
  ****************************************************************************/
 
 /**
- * Internal swscale filter structure.
+ * Horizontal band of the picture scaled by its own context.
+ *
+ * Bands are extended by a margin of neighbouring lines so that the scaler
+ * taps see the same input as when scaling the whole picture; the margin
+ * lines of the output are scaled into p_tmp and dropped.
  */
-struct filter_sys_t
+typedef struct
 {
-    SwsFilter *p_filter;
-    int i_cpu_mask, i_sws_flags;
+    struct SwsContext *ctx;
+    unsigned i_src_y;       /* first source line, margin included */
+    unsigned i_src_h;       /* source lines, margins included */
+    unsigned i_dst_y;       /* first destination line */
+    unsigned i_dst_h;       /* destination lines, margins excluded */
+    unsigned i_dst_skip;    /* leading margin lines in p_tmp */
+    picture_t *p_tmp;       /* destination lines, margins included */
+} scaler_band_t;
 
+/**
+ * Scaler configuration for one input/output format pair.
+ */
+typedef struct
+{
     video_format_t fmt_in;
     video_format_t fmt_out;
     const vlc_chroma_description_t *desc_in;
@@ -105,11 +127,63 @@ struct filter_sys_t
     bool b_copy;
     bool b_swap_uvi;
     bool b_swap_uvo;
+
+    /* Bands scaled in parallel, none if the picture is scaled by ctx */
+    scaler_band_t *p_bands;
+    unsigned i_bands;
+
+    uint64_t i_last_use;
+} scaler_state_t;
+
+typedef struct scaler_worker_t scaler_worker_t;
+
+/* Number of previously used configurations kept around, so that switching
+ * back and forth between formats does not rebuild the scaling contexts */
+#define SCALER_CACHE_SIZE (4)
+/* Maximum number of bands scaled in parallel */
+#define SCALER_MAX_BANDS (16)
+/* Do not split pictures into bands smaller than this (output lines) */
+#define SCALER_MIN_BAND_LINES (64)
+
+/**
+ * Internal swscale filter structure.
+ */
+struct filter_sys_t
+{
+    SwsFilter *p_filter;
+    int i_cpu_mask, i_sws_flags;
+
+    scaler_state_t cur;
+    scaler_state_t cache[SCALER_CACHE_SIZE];
+    unsigned i_cache;
+    uint64_t i_clock;
+
+    /* Band workers, spawned on first use */
+    unsigned i_threads;
+    scaler_worker_t *p_workers;
+    unsigned i_workers;
+};
+
+struct scaler_worker_t
+{
+    filter_t *p_filter;
+    vlc_thread_t thread;
+    vlc_sem_t start;
+    vlc_sem_t done;
+    bool b_quit;
+
+    /* Current job */
+    const scaler_band_t *p_band;
+    picture_t *p_src;
+    picture_t *p_dst;
+    int i_plane_count;
 };
 
 static picture_t *Filter( filter_t *, picture_t * );
 static int  Init( filter_t * );
 static void Clean( filter_t * );
+static void CleanState( scaler_state_t * );
+static void StopWorkers( filter_t * );
 
 typedef struct
 {
@@ -179,12 +253,19 @@ static int OpenScaler( vlc_object_t *p_this )
     default: p_sys->i_sws_flags = SWS_BICUBIC; i_sws_mode = 2; break;
     }
 
+    p_sys->i_threads = var_InheritInteger( p_filter, "swscale-threads" );
+    if( p_sys->i_threads == 0 )
+        p_sys->i_threads = vlc_GetCPUCount();
+    p_sys->i_threads = VLC_CLIP( p_sys->i_threads, 1, SCALER_MAX_BANDS );
+
     /* Misc init */
-    memset( &p_sys->fmt_in,  0, sizeof(p_sys->fmt_in) );
-    memset( &p_sys->fmt_out, 0, sizeof(p_sys->fmt_out) );
+    memset( &p_sys->cur.fmt_in,  0, sizeof(p_sys->cur.fmt_in) );
+    memset( &p_sys->cur.fmt_out, 0, sizeof(p_sys->cur.fmt_out) );
 
     if( Init( p_filter ) )
     {
+        Clean( p_filter );
+        StopWorkers( p_filter );
         if( p_sys->p_filter )
             sws_freeFilter( p_sys->p_filter );
         free( p_sys );
@@ -215,6 +296,7 @@ static void CloseScaler( vlc_object_t *p_this )
     filter_sys_t *p_sys = p_filter->p_sys;
 
     Clean( p_filter );
+    StopWorkers( p_filter );
     if( p_sys->p_filter )
         sws_freeFilter( p_sys->p_filter );
     free( p_sys );
@@ -349,6 +431,226 @@ static int GetParameters( ScalerConfiguration *p_cfg,
     return VLC_SUCCESS;
 }
 
+static bool FormatsMatch( const scaler_state_t *p_state,
+                          const video_format_t *p_fmti,
+                          const video_format_t *p_fmto )
+{
+    /* The output aspect ratio may have been adjusted by Init() and does
+     * not change the scaling itself */
+    video_format_t fmto = *p_fmto;
+    fmto.i_sar_num = p_state->fmt_out.i_sar_num;
+    fmto.i_sar_den = p_state->fmt_out.i_sar_den;
+
+    return p_state->ctx &&
+           video_format_IsSimilar( p_fmti, &p_state->fmt_in ) &&
+           video_format_IsSimilar( &fmto, &p_state->fmt_out );
+}
+
+/**
+ * Moves the current configuration to the cache, evicting the least
+ * recently used one if needed.
+ */
+static void StashState( filter_sys_t *p_sys )
+{
+    if( !p_sys->cur.ctx )
+    {
+        CleanState( &p_sys->cur );
+        return;
+    }
+
+    scaler_state_t *p_slot;
+    if( p_sys->i_cache < SCALER_CACHE_SIZE )
+        p_slot = &p_sys->cache[p_sys->i_cache++];
+    else
+    {
+        p_slot = &p_sys->cache[0];
+        for( unsigned i = 1; i < p_sys->i_cache; i++ )
+            if( p_sys->cache[i].i_last_use < p_slot->i_last_use )
+                p_slot = &p_sys->cache[i];
+        CleanState( p_slot );
+    }
+    *p_slot = p_sys->cur;
+    memset( &p_sys->cur, 0, sizeof(p_sys->cur) );
+}
+
+static unsigned MaxVerticalSubsampling( const vlc_chroma_description_t *desc )
+{
+    unsigned i_max = 1;
+    for( unsigned i = 0; i < desc->plane_count; i++ )
+        i_max = __MAX( i_max, desc->p[i].h.den / desc->p[i].h.num );
+    return i_max;
+}
+
+/**
+ * Number of taps of the scaler filter at unity scale, as libswscale sizes
+ * its filters (initFilter()); they are stretched by the ratio when
+ * downscaling.
+ */
+static unsigned FilterTaps( int i_sws_flags )
+{
+    if( i_sws_flags & SWS_POINT )
+        return 1;
+    if( i_sws_flags & (SWS_BICUBIC | SWS_BICUBLIN) )
+        return 4;
+    if( i_sws_flags & (SWS_X | SWS_GAUSS) )
+        return 8;
+    if( i_sws_flags & SWS_AREA )
+        return 1;
+    if( i_sws_flags & SWS_LANCZOS )
+        return 6;
+    if( i_sws_flags & (SWS_SINC | SWS_SPLINE) )
+        return 20;
+    return 2; /* bilinear */
+}
+
+/**
+ * Source lines (luma) the filter reaches on either side of a line of a
+ * plane scaled from i_in_h to i_out_h lines, with i_sub source luma lines
+ * per plane line.
+ */
+static unsigned FilterMargin( unsigned i_taps, unsigned i_in_h,
+                              unsigned i_out_h, unsigned i_sub )
+{
+    const unsigned i_ratio = (i_in_h + i_out_h - 1) / i_out_h;
+
+    /* Plus a line of rounding on the filter position */
+    return (i_taps * __MAX( i_ratio, 1 ) / 2 + 2) * i_sub;
+}
+
+/**
+ * Splits the picture into horizontal bands scaled by separate contexts.
+ *
+ * Band boundaries are placed where source and destination lines match
+ * exactly and are aligned on the chroma subsampling, so that each band
+ * sees the same filter phases as the whole picture would.
+ */
+static void InitBands( filter_t *p_filter, const ScalerConfiguration *p_cfg )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    scaler_state_t *p_st = &p_sys->cur;
+    const video_format_t *p_fmti = &p_filter->fmt_in.video;
+    const video_format_t *p_fmto = &p_filter->fmt_out.video;
+
+    if( p_sys->i_threads < 2 || p_st->b_copy || p_st->ctxA ||
+        p_st->i_extend_factor != 1 ||
+        p_fmti->i_chroma == VLC_CODEC_RGBP )
+        return;
+
+    const unsigned i_in_h  = p_fmti->i_visible_height;
+    const unsigned i_out_h = p_fmto->i_visible_height;
+    const unsigned i_gcd   = GCD( i_in_h, i_out_h );
+    const unsigned i_sub_in  = MaxVerticalSubsampling( p_st->desc_in );
+    const unsigned i_sub_out = MaxVerticalSubsampling( p_st->desc_out );
+
+    /* Smallest group of lines mapping exactly between input and output */
+    unsigned i_group = 1;
+    while( ( i_group * (i_in_h / i_gcd) ) % i_sub_in ||
+           ( i_group * (i_out_h / i_gcd) ) % i_sub_out )
+    {
+        if( ++i_group > 4 )
+            return;
+    }
+    if( i_gcd % i_group )
+        return;
+
+    const unsigned i_units    = i_gcd / i_group;
+    const unsigned i_unit_in  = i_group * (i_in_h / i_gcd);
+    const unsigned i_unit_out = i_group * (i_out_h / i_gcd);
+
+    unsigned i_bands = __MIN( p_sys->i_threads, i_out_h / SCALER_MIN_BAND_LINES );
+    i_bands = __MIN( i_bands, i_units );
+    if( i_bands < 2 )
+        return;
+
+    /* Margin covering the vertical filter support on the source side, for
+     * the luma and the most subsampled chroma planes */
+    const unsigned i_taps = FilterTaps( p_cfg->i_sws_flags );
+    const unsigned i_margin_in =
+        __MAX( FilterMargin( i_taps, i_in_h, i_out_h, 1 ),
+               FilterMargin( i_taps, i_in_h / i_sub_in, i_out_h / i_sub_out,
+                             i_sub_in ) );
+    const unsigned i_margin = (i_margin_in + i_unit_in - 1) / i_unit_in;
+
+    scaler_band_t *p_bands = calloc( i_bands, sizeof(*p_bands) );
+    if( !p_bands )
+        return;
+
+    const unsigned i_in_w  = p_fmti->i_visible_width;
+    const unsigned i_out_w = p_fmto->i_visible_width;
+    for( unsigned k = 0; k < i_bands; k++ )
+    {
+        scaler_band_t *p_band = &p_bands[k];
+        const unsigned u0 = i_units * k / i_bands;
+        const unsigned u1 = i_units * (k + 1) / i_bands;
+        const unsigned i_top = __MIN( i_margin, u0 );
+        const unsigned i_bottom = __MIN( i_margin, i_units - u1 );
+        const unsigned i_ext = u1 - u0 + i_top + i_bottom;
+
+        p_band->i_src_y    = (u0 - i_top) * i_unit_in;
+        p_band->i_src_h    = i_ext * i_unit_in;
+        p_band->i_dst_y    = u0 * i_unit_out;
+        p_band->i_dst_h    = (u1 - u0) * i_unit_out;
+        p_band->i_dst_skip = i_top * i_unit_out;
+
+        p_band->ctx = sws_getContext( i_in_w, p_band->i_src_h, p_cfg->i_fmti,
+                                      i_out_w, i_ext * i_unit_out, p_cfg->i_fmto,
+                                      p_cfg->i_sws_flags | p_sys->i_cpu_mask,
+                                      p_sys->p_filter, NULL, 0 );
+        p_band->p_tmp = picture_New( p_fmto->i_chroma, i_out_w,
+                                     i_ext * i_unit_out, 1, 1 );
+        if( !p_band->ctx || !p_band->p_tmp )
+        {
+            p_st->p_bands = p_bands;
+            p_st->i_bands = k + 1;
+            goto error;
+        }
+    }
+    p_st->p_bands = p_bands;
+    p_st->i_bands = i_bands;
+
+    msg_Dbg( p_filter, "scaling in %u bands", i_bands );
+    return;
+
+error:
+    msg_Warn( p_filter, "could not split scaling into bands" );
+    for( unsigned k = 0; k < p_st->i_bands; k++ )
+    {
+        if( p_st->p_bands[k].ctx )
+            sws_freeContext( p_st->p_bands[k].ctx );
+        if( p_st->p_bands[k].p_tmp )
+            picture_Release( p_st->p_bands[k].p_tmp );
+    }
+    free( p_st->p_bands );
+    p_st->p_bands = NULL;
+    p_st->i_bands = 0;
+}
+
+static void FixAspectRatio( filter_t *p_filter )
+{
+    const video_format_t *p_fmti = &p_filter->fmt_in.video;
+    video_format_t       *p_fmto = &p_filter->fmt_out.video;
+
+    if (p_filter->b_allow_fmt_out_change)
+    {
+        /*
+         * If the transformation is not homothetic we must modify the
+         * aspect ratio of the output format in order to have the
+         * output picture displayed correctly and not stretched
+         * horizontally or vertically.
+         * WARNING: this is a hack, ideally this should not be needed
+         * and the vout should update its video format instead.
+         */
+        unsigned i_sar_num = p_fmti->i_sar_num * p_fmti->i_visible_width;
+        unsigned i_sar_den = p_fmti->i_sar_den * p_fmto->i_visible_width;
+        vlc_ureduce(&i_sar_num, &i_sar_den, i_sar_num, i_sar_den, 65536);
+        i_sar_num *= p_fmto->i_visible_height;
+        i_sar_den *= p_fmti->i_visible_height;
+        vlc_ureduce(&i_sar_num, &i_sar_den, i_sar_num, i_sar_den, 65536);
+        p_fmto->i_sar_num = i_sar_num;
+        p_fmto->i_sar_den = i_sar_den;
+    }
+}
+
 static int Init( filter_t *p_filter )
 {
     filter_sys_t *p_sys = p_filter->p_sys;
@@ -358,14 +660,24 @@ static int Init( filter_t *p_filter )
     if( p_fmti->orientation != p_fmto->orientation )
         return VLC_EGENERIC;
 
-    if( video_format_IsSimilar( p_fmti, &p_sys->fmt_in ) &&
-        video_format_IsSimilar( p_fmto, &p_sys->fmt_out ) &&
-        p_sys->ctx )
-    {
+    if( FormatsMatch( &p_sys->cur, p_fmti, p_fmto ) )
         return VLC_SUCCESS;
-    }
 
-    Clean( p_filter );
+    StashState( p_sys );
+
+    /* Reuse a previous configuration for these formats if any */
+    for( unsigned i = 0; i < p_sys->i_cache; i++ )
+    {
+        if( FormatsMatch( &p_sys->cache[i], p_fmti, p_fmto ) )
+        {
+            p_sys->cur = p_sys->cache[i];
+            p_sys->cache[i] = p_sys->cache[--p_sys->i_cache];
+            FixAspectRatio( p_filter );
+            p_sys->cur.fmt_out = *p_fmto;
+            p_sys->cur.i_last_use = ++p_sys->i_clock;
+            return VLC_SUCCESS;
+        }
+    }
 
     /* Init with new parameters */
     ScalerConfiguration cfg;
@@ -383,18 +695,18 @@ static int Init( filter_t *p_filter )
         return VLC_EGENERIC;
     }
 
-    p_sys->desc_in = vlc_fourcc_GetChromaDescription( p_fmti->i_chroma );
-    p_sys->desc_out = vlc_fourcc_GetChromaDescription( p_fmto->i_chroma );
-    if( p_sys->desc_in == NULL || p_sys->desc_out == NULL )
+    p_sys->cur.desc_in = vlc_fourcc_GetChromaDescription( p_fmti->i_chroma );
+    p_sys->cur.desc_out = vlc_fourcc_GetChromaDescription( p_fmto->i_chroma );
+    if( p_sys->cur.desc_in == NULL || p_sys->cur.desc_out == NULL )
         return VLC_EGENERIC;
 
     /* swscale does not like too small width */
-    p_sys->i_extend_factor = 1;
-    while( __MIN( p_fmti->i_visible_width, p_fmto->i_visible_width ) * p_sys->i_extend_factor < MINIMUM_WIDTH)
-        p_sys->i_extend_factor++;
+    p_sys->cur.i_extend_factor = 1;
+    while( __MIN( p_fmti->i_visible_width, p_fmto->i_visible_width ) * p_sys->cur.i_extend_factor < MINIMUM_WIDTH)
+        p_sys->cur.i_extend_factor++;
 
-    const unsigned i_fmti_visible_width = p_fmti->i_visible_width * p_sys->i_extend_factor;
-    const unsigned i_fmto_visible_width = p_fmto->i_visible_width * p_sys->i_extend_factor;
+    const unsigned i_fmti_visible_width = p_fmti->i_visible_width * p_sys->cur.i_extend_factor;
+    const unsigned i_fmto_visible_width = p_fmto->i_visible_width * p_sys->cur.i_extend_factor;
     for( int n = 0; n < (cfg.b_has_a ? 2 : 1); n++ )
     {
         const int i_fmti = n == 0 ? cfg.i_fmti : AV_PIX_FMT_GRAY8;
@@ -406,92 +718,87 @@ static int Init( filter_t *p_filter )
                               cfg.i_sws_flags | p_sys->i_cpu_mask,
                               p_sys->p_filter, NULL, 0 );
         if( n == 0 )
-            p_sys->ctx = ctx;
+            p_sys->cur.ctx = ctx;
         else
-            p_sys->ctxA = ctx;
+            p_sys->cur.ctxA = ctx;
     }
-    if( p_sys->ctxA )
+    if( p_sys->cur.ctxA )
     {
-        p_sys->p_src_a = picture_New( VLC_CODEC_GREY, i_fmti_visible_width, p_fmti->i_visible_height, 0, 1 );
-        p_sys->p_dst_a = picture_New( VLC_CODEC_GREY, i_fmto_visible_width, p_fmto->i_visible_height, 0, 1 );
+        p_sys->cur.p_src_a = picture_New( VLC_CODEC_GREY, i_fmti_visible_width, p_fmti->i_visible_height, 0, 1 );
+        p_sys->cur.p_dst_a = picture_New( VLC_CODEC_GREY, i_fmto_visible_width, p_fmto->i_visible_height, 0, 1 );
     }
-    if( p_sys->i_extend_factor != 1 )
+    if( p_sys->cur.i_extend_factor != 1 )
     {
-        p_sys->p_src_e = picture_New( p_fmti->i_chroma, i_fmti_visible_width, p_fmti->i_visible_height, 0, 1 );
-        p_sys->p_dst_e = picture_New( p_fmto->i_chroma, i_fmto_visible_width, p_fmto->i_visible_height, 0, 1 );
+        p_sys->cur.p_src_e = picture_New( p_fmti->i_chroma, i_fmti_visible_width, p_fmti->i_visible_height, 0, 1 );
+        p_sys->cur.p_dst_e = picture_New( p_fmto->i_chroma, i_fmto_visible_width, p_fmto->i_visible_height, 0, 1 );
 
-        if( p_sys->p_src_e )
-            memset( p_sys->p_src_e->p[0].p_pixels, 0, p_sys->p_src_e->p[0].i_pitch * p_sys->p_src_e->p[0].i_lines );
-        if( p_sys->p_dst_e )
-            memset( p_sys->p_dst_e->p[0].p_pixels, 0, p_sys->p_dst_e->p[0].i_pitch * p_sys->p_dst_e->p[0].i_lines );
+        if( p_sys->cur.p_src_e )
+            memset( p_sys->cur.p_src_e->p[0].p_pixels, 0, p_sys->cur.p_src_e->p[0].i_pitch * p_sys->cur.p_src_e->p[0].i_lines );
+        if( p_sys->cur.p_dst_e )
+            memset( p_sys->cur.p_dst_e->p[0].p_pixels, 0, p_sys->cur.p_dst_e->p[0].i_pitch * p_sys->cur.p_dst_e->p[0].i_lines );
     }
 
-    if( !p_sys->ctx ||
-        ( cfg.b_has_a && ( !p_sys->ctxA || !p_sys->p_src_a || !p_sys->p_dst_a ) ) ||
-        ( p_sys->i_extend_factor != 1 && ( !p_sys->p_src_e || !p_sys->p_dst_e ) ) )
+    if( !p_sys->cur.ctx ||
+        ( cfg.b_has_a && ( !p_sys->cur.ctxA || !p_sys->cur.p_src_a || !p_sys->cur.p_dst_a ) ) ||
+        ( p_sys->cur.i_extend_factor != 1 && ( !p_sys->cur.p_src_e || !p_sys->cur.p_dst_e ) ) )
     {
         msg_Err( p_filter, "could not init SwScaler and/or allocate memory" );
-        Clean( p_filter );
+        CleanState( &p_sys->cur );
         return VLC_EGENERIC;
     }
 
-    if (p_filter->b_allow_fmt_out_change)
-    {
-        /*
-         * If the transformation is not homothetic we must modify the
-         * aspect ratio of the output format in order to have the
-         * output picture displayed correctly and not stretched
-         * horizontally or vertically.
-         * WARNING: this is a hack, ideally this should not be needed
-         * and the vout should update its video format instead.
-         */
-        unsigned i_sar_num = p_fmti->i_sar_num * p_fmti->i_visible_width;
-        unsigned i_sar_den = p_fmti->i_sar_den * p_fmto->i_visible_width;
-        vlc_ureduce(&i_sar_num, &i_sar_den, i_sar_num, i_sar_den, 65536);
-        i_sar_num *= p_fmto->i_visible_height;
-        i_sar_den *= p_fmti->i_visible_height;
-        vlc_ureduce(&i_sar_num, &i_sar_den, i_sar_num, i_sar_den, 65536);
-        p_fmto->i_sar_num = i_sar_num;
-        p_fmto->i_sar_den = i_sar_den;
-    }
+    FixAspectRatio( p_filter );
 
-    p_sys->b_add_a = cfg.b_add_a;
-    p_sys->b_copy = cfg.b_copy;
-    p_sys->fmt_in  = *p_fmti;
-    p_sys->fmt_out = *p_fmto;
-    p_sys->b_swap_uvi = cfg.b_swap_uvi;
-    p_sys->b_swap_uvo = cfg.b_swap_uvo;
+    p_sys->cur.b_add_a = cfg.b_add_a;
+    p_sys->cur.b_copy = cfg.b_copy;
+    p_sys->cur.fmt_in  = *p_fmti;
+    p_sys->cur.fmt_out = *p_fmto;
+    p_sys->cur.b_swap_uvi = cfg.b_swap_uvi;
+    p_sys->cur.b_swap_uvo = cfg.b_swap_uvo;
+    p_sys->cur.i_last_use = ++p_sys->i_clock;
+
+    InitBands( p_filter, &cfg );
 
     return VLC_SUCCESS;
 }
 
-static void Clean( filter_t *p_filter )
+static void CleanState( scaler_state_t *p_st )
 {
-    filter_sys_t *p_sys = p_filter->p_sys;
+    for( unsigned k = 0; k < p_st->i_bands; k++ )
+    {
+        sws_freeContext( p_st->p_bands[k].ctx );
+        picture_Release( p_st->p_bands[k].p_tmp );
+    }
+    free( p_st->p_bands );
 
-    if( p_sys->p_src_e )
-        picture_Release( p_sys->p_src_e );
-    if( p_sys->p_dst_e )
-        picture_Release( p_sys->p_dst_e );
+    if( p_st->p_src_e )
+        picture_Release( p_st->p_src_e );
+    if( p_st->p_dst_e )
+        picture_Release( p_st->p_dst_e );
 
-    if( p_sys->p_src_a )
-        picture_Release( p_sys->p_src_a );
-    if( p_sys->p_dst_a )
-        picture_Release( p_sys->p_dst_a );
+    if( p_st->p_src_a )
+        picture_Release( p_st->p_src_a );
+    if( p_st->p_dst_a )
+        picture_Release( p_st->p_dst_a );
 
-    if( p_sys->ctxA )
-        sws_freeContext( p_sys->ctxA );
+    if( p_st->ctxA )
+        sws_freeContext( p_st->ctxA );
 
-    if( p_sys->ctx )
-        sws_freeContext( p_sys->ctx );
+    if( p_st->ctx )
+        sws_freeContext( p_st->ctx );
 
     /* We have to set it to null has we call be called again :( */
-    p_sys->ctx = NULL;
-    p_sys->ctxA = NULL;
-    p_sys->p_src_a = NULL;
-    p_sys->p_dst_a = NULL;
-    p_sys->p_src_e = NULL;
-    p_sys->p_dst_e = NULL;
+    memset( p_st, 0, sizeof(*p_st) );
+}
+
+static void Clean( filter_t *p_filter )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    CleanState( &p_sys->cur );
+    for( unsigned i = 0; i < p_sys->i_cache; i++ )
+        CleanState( &p_sys->cache[i] );
+    p_sys->i_cache = 0;
 }
 
 static void GetPixels( uint8_t *pp_pixel[4], int pi_pitch[4],
@@ -590,7 +897,7 @@ static void Convert( filter_t *p_filter, struct SwsContext *ctx,
     uint8_t *src[4]; int src_stride[4];
     uint8_t *dst[4]; int dst_stride[4];
 
-    GetPixels( src, src_stride, p_sys->desc_in, &p_filter->fmt_in.video,
+    GetPixels( src, src_stride, p_sys->cur.desc_in, &p_filter->fmt_in.video,
                p_src, i_plane_count, b_swap_uvi );
     if( p_filter->fmt_in.video.i_chroma == VLC_CODEC_RGBP )
     {
@@ -602,7 +909,7 @@ static void Convert( filter_t *p_filter, struct SwsContext *ctx,
         src_stride[1] = 4;
     }
 
-    GetPixels( dst, dst_stride, p_sys->desc_out, &p_filter->fmt_out.video,
+    GetPixels( dst, dst_stride, p_sys->cur.desc_out, &p_filter->fmt_out.video,
                p_dst, i_plane_count, b_swap_uvo );
 
 #if LIBSWSCALE_VERSION_INT  >= ((0<<16)+(5<<8)+0)
@@ -614,6 +921,151 @@ static void Convert( filter_t *p_filter, struct SwsContext *ctx,
 #endif
 }
 
+/**
+ * Scales one band of the picture into its margin-extended temporary
+ * picture, then copies the lines belonging to the band to the destination.
+ */
+static void ConvertBand( filter_t *p_filter, const scaler_band_t *p_band,
+                         picture_t *p_dst, picture_t *p_src,
+                         int i_plane_count )
+{
+    const scaler_state_t *p_st = &p_filter->p_sys->cur;
+    uint8_t *src[4]; int src_stride[4];
+    uint8_t *tmp[4]; int tmp_stride[4];
+    uint8_t *dst[4]; int dst_stride[4];
+
+    GetPixels( src, src_stride, p_st->desc_in, &p_filter->fmt_in.video,
+               p_src, i_plane_count, p_st->b_swap_uvi );
+    for( unsigned i = 0; i < 4 && i < p_st->desc_in->plane_count; i++ )
+        if( src[i] )
+            src[i] += p_band->i_src_y * p_st->desc_in->p[i].h.num
+                    / p_st->desc_in->p[i].h.den * src_stride[i];
+
+    GetPixels( tmp, tmp_stride, p_st->desc_out, &p_band->p_tmp->format,
+               p_band->p_tmp, i_plane_count, p_st->b_swap_uvo );
+
+    sws_scale( p_band->ctx, src, src_stride,
+               0, p_band->i_src_h, tmp, tmp_stride );
+
+    GetPixels( dst, dst_stride, p_st->desc_out, &p_filter->fmt_out.video,
+               p_dst, i_plane_count, p_st->b_swap_uvo );
+    for( unsigned i = 0; i < 4 && i < p_st->desc_out->plane_count; i++ )
+    {
+        if( !dst[i] || !tmp[i] )
+            continue;
+
+        const unsigned num = p_st->desc_out->p[i].h.num;
+        const unsigned den = p_st->desc_out->p[i].h.den;
+        const plane_t *p_plane = &p_band->p_tmp->p[i];
+        const uint8_t *p_in = tmp[i] + p_band->i_dst_skip * num / den * tmp_stride[i];
+        uint8_t *p_out = dst[i] + p_band->i_dst_y * num / den * dst_stride[i];
+
+        for( unsigned y = 0; y < p_band->i_dst_h * num / den; y++ )
+        {
+            memcpy( p_out, p_in, p_plane->i_visible_pitch );
+            p_in += tmp_stride[i];
+            p_out += dst_stride[i];
+        }
+    }
+}
+
+static void *WorkerThread( void *data )
+{
+    scaler_worker_t *p_worker = data;
+
+    for( ;; )
+    {
+        vlc_sem_wait( &p_worker->start );
+        if( p_worker->b_quit )
+            break;
+
+        ConvertBand( p_worker->p_filter, p_worker->p_band,
+                     p_worker->p_dst, p_worker->p_src,
+                     p_worker->i_plane_count );
+        vlc_sem_post( &p_worker->done );
+    }
+    return NULL;
+}
+
+static void StartWorkers( filter_t *p_filter )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    if( p_sys->p_workers )
+        return;
+
+    p_sys->p_workers = calloc( p_sys->i_threads - 1, sizeof(*p_sys->p_workers) );
+    if( !p_sys->p_workers )
+        return;
+
+    for( unsigned i = 0; i < p_sys->i_threads - 1; i++ )
+    {
+        scaler_worker_t *p_worker = &p_sys->p_workers[i];
+
+        p_worker->p_filter = p_filter;
+        vlc_sem_init( &p_worker->start, 0 );
+        vlc_sem_init( &p_worker->done, 0 );
+        if( vlc_clone( &p_worker->thread, WorkerThread, p_worker,
+                       VLC_THREAD_PRIORITY_VIDEO ) )
+        {
+            vlc_sem_destroy( &p_worker->start );
+            vlc_sem_destroy( &p_worker->done );
+            break;
+        }
+        p_sys->i_workers++;
+    }
+}
+
+static void StopWorkers( filter_t *p_filter )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    for( unsigned i = 0; i < p_sys->i_workers; i++ )
+    {
+        scaler_worker_t *p_worker = &p_sys->p_workers[i];
+
+        p_worker->b_quit = true;
+        vlc_sem_post( &p_worker->start );
+        vlc_join( p_worker->thread, NULL );
+        vlc_sem_destroy( &p_worker->start );
+        vlc_sem_destroy( &p_worker->done );
+    }
+    free( p_sys->p_workers );
+    p_sys->p_workers = NULL;
+    p_sys->i_workers = 0;
+}
+
+/**
+ * Scales all the bands, in parallel as far as there are workers.
+ */
+static void ConvertBands( filter_t *p_filter, picture_t *p_dst,
+                          picture_t *p_src, int i_plane_count )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    const scaler_state_t *p_st = &p_sys->cur;
+
+    StartWorkers( p_filter );
+
+    const unsigned i_jobs = __MIN( p_st->i_bands - 1, p_sys->i_workers );
+    for( unsigned i = 0; i < i_jobs; i++ )
+    {
+        scaler_worker_t *p_worker = &p_sys->p_workers[i];
+
+        p_worker->p_band = &p_st->p_bands[i + 1];
+        p_worker->p_src = p_src;
+        p_worker->p_dst = p_dst;
+        p_worker->i_plane_count = i_plane_count;
+        vlc_sem_post( &p_worker->start );
+    }
+
+    ConvertBand( p_filter, &p_st->p_bands[0], p_dst, p_src, i_plane_count );
+    for( unsigned k = i_jobs + 1; k < p_st->i_bands; k++ )
+        ConvertBand( p_filter, &p_st->p_bands[k], p_dst, p_src, i_plane_count );
+
+    for( unsigned i = 0; i < i_jobs; i++ )
+        vlc_sem_wait( &p_sys->p_workers[i].done );
+}
+
 /****************************************************************************
  * Filter: the whole thing
  ****************************************************************************
@@ -644,46 +1096,49 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
     /* */
     picture_t *p_src = p_pic;
     picture_t *p_dst = p_pic_dst;
-    if( p_sys->i_extend_factor != 1 )
+    if( p_sys->cur.i_extend_factor != 1 )
     {
-        p_src = p_sys->p_src_e;
-        p_dst = p_sys->p_dst_e;
+        p_src = p_sys->cur.p_src_e;
+        p_dst = p_sys->cur.p_dst_e;
 
         CopyPad( p_src, p_pic );
     }
 
-    if( p_sys->b_copy && p_sys->b_swap_uvi == p_sys->b_swap_uvo )
+    if( p_sys->cur.b_copy && p_sys->cur.b_swap_uvi == p_sys->cur.b_swap_uvo )
         picture_CopyPixels( p_dst, p_src );
-    else if( p_sys->b_copy )
+    else if( p_sys->cur.b_copy )
         SwapUV( p_dst, p_src );
     else
     {
         /* Even if alpha is unused, swscale expects the pointer to be set */
-        const int n_planes = !p_sys->ctxA && (p_src->i_planes == 4 ||
+        const int n_planes = !p_sys->cur.ctxA && (p_src->i_planes == 4 ||
                              p_dst->i_planes == 4) ? 4 : 3;
-        Convert( p_filter, p_sys->ctx, p_dst, p_src, p_fmti->i_visible_height,
-                 n_planes, p_sys->b_swap_uvi, p_sys->b_swap_uvo );
+        if( p_sys->cur.i_bands > 0 )
+            ConvertBands( p_filter, p_dst, p_src, n_planes );
+        else
+            Convert( p_filter, p_sys->cur.ctx, p_dst, p_src, p_fmti->i_visible_height,
+                     n_planes, p_sys->cur.b_swap_uvi, p_sys->cur.b_swap_uvo );
     }
-    if( p_sys->ctxA )
+    if( p_sys->cur.ctxA )
     {
         /* We extract the A plane to rescale it, and then we reinject it. */
         if( p_fmti->i_chroma == VLC_CODEC_RGBA || p_fmti->i_chroma == VLC_CODEC_BGRA )
-            ExtractA( p_sys->p_src_a, p_src, OFFSET_A );
+            ExtractA( p_sys->cur.p_src_a, p_src, OFFSET_A );
         else if( p_fmti->i_chroma == VLC_CODEC_ARGB )
-            ExtractA( p_sys->p_src_a, p_src, 0 );
+            ExtractA( p_sys->cur.p_src_a, p_src, 0 );
         else
-            plane_CopyPixels( p_sys->p_src_a->p, p_src->p+A_PLANE );
+            plane_CopyPixels( p_sys->cur.p_src_a->p, p_src->p+A_PLANE );
 
-        Convert( p_filter, p_sys->ctxA, p_sys->p_dst_a, p_sys->p_src_a,
+        Convert( p_filter, p_sys->cur.ctxA, p_sys->cur.p_dst_a, p_sys->cur.p_src_a,
                  p_fmti->i_visible_height, 1, false, false );
         if( p_fmto->i_chroma == VLC_CODEC_RGBA || p_fmto->i_chroma == VLC_CODEC_BGRA )
-            InjectA( p_dst, p_sys->p_dst_a, OFFSET_A );
+            InjectA( p_dst, p_sys->cur.p_dst_a, OFFSET_A );
         else if( p_fmto->i_chroma == VLC_CODEC_ARGB )
-            InjectA( p_dst, p_sys->p_dst_a, 0 );
+            InjectA( p_dst, p_sys->cur.p_dst_a, 0 );
         else
-            plane_CopyPixels( p_dst->p+A_PLANE, p_sys->p_dst_a->p );
+            plane_CopyPixels( p_dst->p+A_PLANE, p_sys->cur.p_dst_a->p );
     }
-    else if( p_sys->b_add_a )
+    else if( p_sys->cur.b_add_a )
     {
         /* We inject a complete opaque alpha plane */
         if( p_fmto->i_chroma == VLC_CODEC_RGBA || p_fmto->i_chroma == VLC_CODEC_BGRA )
@@ -694,7 +1149,7 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
             FillA( &p_dst->p[A_PLANE], 0 );
     }
 
-    if( p_sys->i_extend_factor != 1 )
+    if( p_sys->cur.i_extend_factor != 1 )
     {
         picture_CopyPixels( p_pic_dst, p_dst );
     }
@@ -94,6 +94,7 @@ struct filter_sys_t
 
     /* FFT window parameters */
     window_param wind_param;
+    vlc_fft_t *fft;
 };
 
 
@@ -134,6 +135,13 @@ static int Open(vlc_object_t * p_this)
     /* Fetch the FFT window parameters */
     window_get_param( VLC_OBJECT( p_filter ), &p_sys->wind_param );
 
+    p_sys->fft = vlc_fft_New(FFT_BUFFER_SIZE);
+    if (p_sys->fft == NULL)
+    {
+        free(p_sys);
+        return VLC_ENOMEM;
+    }
+
     /* Create the FIFO for the audio data. */
     p_sys->fifo = block_FifoNew();
     if (p_sys->fifo == NULL)
@@ -164,6 +172,7 @@ static int Open(vlc_object_t * p_this)
     return VLC_SUCCESS;
 
 error:
+    vlc_fft_Delete(p_sys->fft);
     free(p_sys);
     return VLC_EGENERIC;
 }
@@ -186,6 +195,7 @@ static void Close(vlc_object_t *p_this)
     vlc_gl_surface_Destroy(p_sys->gl);
     block_FifoRelease(p_sys->fifo);
     free(p_sys->p_prev_s16_buff);
+    vlc_fft_Delete(p_sys->fft);
     free(p_sys);
 }
 
@@ -370,7 +380,6 @@ static void *Thread( void *p_data )
         const unsigned xscale[] = {0,1,2,3,4,5,6,7,8,11,15,20,27,
                                    36,47,62,82,107,141,184,255};
 
-        fft_state *p_state = NULL; /* internal FFT data */
         DEFINE_WIND_CONTEXT(wind_ctx); /* internal window data */
 
         unsigned i, j;
@@ -417,12 +426,6 @@ static void *Thread( void *p_data )
 
             p_buffl++; p_buffs++;
         }
-        p_state = visual_fft_init();
-        if (!p_state)
-        {
-            msg_Err(p_filter,"unable to initialize FFT transform");
-            goto release;
-        }
         if (!window_init(FFT_BUFFER_SIZE, &p_sys->wind_param, &wind_ctx))
         {
             msg_Err(p_filter,"unable to initialize FFT window");
@@ -439,7 +442,7 @@ static void *Thread( void *p_data )
                 p_buffs = p_s16_buff;
         }
         window_scale_in_place (p_buffer1, &wind_ctx);
-        fft_perform (p_buffer1, p_output, p_state);
+        fft_perform (p_buffer1, p_output, p_sys->fft);
 
         for (i = 0; i< FFT_BUFFER_SIZE; ++i)
             p_dest[i] = p_output[i] *  (2 ^ 16)
@@ -491,7 +494,6 @@ static void *Thread( void *p_data )
 
 release:
         window_close(&wind_ctx);
-        fft_close(p_state);
         vlc_gl_ReleaseCurrent(gl);
         block_Release(block);
         vlc_restorecancel(canc);
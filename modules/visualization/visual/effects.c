@@ -74,6 +74,7 @@ typedef struct spectrum_data
     unsigned i_prev_nb_samples;
     int16_t *p_prev_s16_buff;
 
+    vlc_fft_t *p_fft;
     window_param wind_param;
 } spectrum_data;
 
@@ -104,7 +105,6 @@ static int spectrum_Run(visual_effect_t * p_effect, vlc_object_t *p_aout,
      110,115,121,130,141,152,163,174,185,200,255};
     const int *xscale;
 
-    fft_state *p_state;                 /* internal FFT data */
     DEFINE_WIND_CONTEXT( wind_ctx );    /* internal window data */
 
     int i , j , y , k;
@@ -137,8 +137,14 @@ static int spectrum_Run(visual_effect_t * p_effect, vlc_object_t *p_aout,
         p_data->i_prev_nb_samples = 0;
         p_data->p_prev_s16_buff = NULL;
 
+        p_data->p_fft = vlc_fft_New( FFT_BUFFER_SIZE );
+        if( !p_data->p_fft )
+            msg_Err(p_aout,"unable to initialize FFT transform");
+
         window_get_param( p_aout, &p_data->wind_param );
     }
+    if( !p_data->p_fft )
+        return -1;
     peaks = (int *)p_data->peaks;
     prev_heights = (int *)p_data->prev_heights;
 
@@ -186,16 +192,8 @@ static int spectrum_Run(visual_effect_t * p_effect, vlc_object_t *p_aout,
 
         p_buffl++ ; p_buffs++ ;
     }
-    p_state  = visual_fft_init();
-    if( !p_state)
-    {
-        free( height );
-        msg_Err(p_aout,"unable to initialize FFT transform");
-        return -1;
-    }
     if( !window_init( FFT_BUFFER_SIZE, &p_data->wind_param, &wind_ctx ) )
     {
-        fft_close( p_state );
         free( height );
         msg_Err(p_aout,"unable to initialize FFT window");
         return -1;
@@ -212,7 +210,7 @@ static int spectrum_Run(visual_effect_t * p_effect, vlc_object_t *p_aout,
 
     }
     window_scale_in_place( p_buffer1, &wind_ctx );
-    fft_perform( p_buffer1, p_output, p_state);
+    fft_perform( p_buffer1, p_output, p_data->p_fft );
     for( i = 0; i< FFT_BUFFER_SIZE ; i++ )
         p_dest[i] = p_output[i] *  ( 2 ^ 16 ) / ( ( FFT_BUFFER_SIZE / 2 * 32768 ) ^ 2 );
 
@@ -361,8 +359,6 @@ static int spectrum_Run(visual_effect_t * p_effect, vlc_object_t *p_aout,
 
     window_close( &wind_ctx );
 
-    fft_close( p_state );
-
     free( height );
 
     return 0;
@@ -377,6 +373,8 @@ static void spectrum_Free( void *data )
         free( p_data->peaks );
         free( p_data->prev_heights );
         free( p_data->p_prev_s16_buff );
+        if( p_data->p_fft != NULL )
+            vlc_fft_Delete( p_data->p_fft );
         free( p_data );
     }
 }
@@ -392,6 +390,7 @@ typedef struct
     unsigned i_prev_nb_samples;
     int16_t *p_prev_s16_buff;
 
+    vlc_fft_t *p_fft;
     window_param wind_param;
 } spectrometer_data;
 
@@ -442,7 +441,6 @@ static int spectrometer_Run(visual_effect_t * p_effect, vlc_object_t *p_aout,
     const int *xscale;
     const double y_scale =  3.60673760222;  /* (log 256) */
 
-    fft_state *p_state;                 /* internal FFT data */
     DEFINE_WIND_CONTEXT( wind_ctx );    /* internal window data */
 
     int i , j , k;
@@ -476,6 +474,14 @@ static int spectrometer_Run(visual_effect_t * p_effect, vlc_object_t *p_aout,
         }
         p_data->i_prev_nb_samples = 0;
         p_data->p_prev_s16_buff = NULL;
+        p_data->p_fft = vlc_fft_New( FFT_BUFFER_SIZE );
+        if( !p_data->p_fft )
+        {
+            msg_Err(p_aout,"unable to initialize FFT transform");
+            free( p_data->peaks );
+            free( p_data );
+            return -1;
+        }
         window_get_param( p_aout, &p_data->wind_param );
         p_effect->p_data = (void*)p_data;
     }
@@ -534,16 +540,8 @@ static int spectrometer_Run(visual_effect_t * p_effect, vlc_object_t *p_aout,
 
         p_buffl++ ; p_buffs++ ;
     }
-    p_state  = visual_fft_init();
-    if( !p_state)
-    {
-        msg_Err(p_aout,"unable to initialize FFT transform");
-        free( height );
-        return -1;
-    }
     if( !window_init( FFT_BUFFER_SIZE, &p_data->wind_param, &wind_ctx ) )
     {
-        fft_close( p_state );
         free( height );
         msg_Err(p_aout,"unable to initialize FFT window");
         return -1;
@@ -559,7 +557,7 @@ static int spectrometer_Run(visual_effect_t * p_effect, vlc_object_t *p_aout,
             p_buffs = p_s16_buff;
     }
     window_scale_in_place( p_buffer1, &wind_ctx );
-    fft_perform( p_buffer1, p_output, p_state);
+    fft_perform( p_buffer1, p_output, p_data->p_fft );
     for(i = 0; i < FFT_BUFFER_SIZE; i++)
     {
         int sqrti = sqrt(p_output[i]);
@@ -858,8 +856,6 @@ static int spectrometer_Run(visual_effect_t * p_effect, vlc_object_t *p_aout,
 
     window_close( &wind_ctx );
 
-    fft_close( p_state );
-
     free( height );
 
     return 0;
@@ -873,6 +869,7 @@ static void spectrometer_Free( void *data )
     {
         free( p_data->peaks );
         free( p_data->p_prev_s16_buff );
+        vlc_fft_Delete( p_data->p_fft );
         free( p_data );
     }
 }
@@ -1,11 +1,7 @@
 /*****************************************************************************
- * fft.h: Headers for iterative implementation of a FFT
+ * fft.h: spectrum of the visualization frames
  *****************************************************************************
- * $Id$
- *
- * Mainly taken from XMMS's code
- *
- * Authors: Richard Boulton <richard@tartarus.org>
+ * Copyright (C) 2026 VLC authors and VideoLAN
  *
  * This program is free software; you can redistribute it and/or modify
  * it under the terms of the GNU General Public License as published by
@@ -25,6 +21,8 @@
 #ifndef VLC_VISUAL_FFT_H_
 #define VLC_VISUAL_FFT_H_
 
+#include <vlc_fft.h>
+
 #define FFT_BUFFER_SIZE_LOG 9
 
 #define FFT_BUFFER_SIZE (1 << FFT_BUFFER_SIZE_LOG)
@@ -32,25 +30,26 @@
 /* sound sample - should be an signed 16 bit value */
 typedef short int sound_sample;
 
-struct _struct_fft_state {
-     /* Temporary data stores to perform FFT in. */
-     float real[FFT_BUFFER_SIZE];
-     float imag[FFT_BUFFER_SIZE];
-
-     /* */
-     unsigned int bitReverse[FFT_BUFFER_SIZE];
-
-     /* The next two tables could be made to use less space in memory, since they
-      * overlap hugely, but hey. */
-     float sintable[FFT_BUFFER_SIZE / 2];
-     float costable[FFT_BUFFER_SIZE / 2];
-};
-
-/* FFT prototypes */
-typedef struct _struct_fft_state fft_state;
-fft_state *visual_fft_init (void);
-void fft_perform (const sound_sample *input, float *output, fft_state *state);
-void fft_close (fft_state *state);
-
+/*
+ * Returns the intensities of each frequency of FFT_BUFFER_SIZE samples, as
+ * floats in the range 0 to ((FFT_BUFFER_SIZE / 2) * 32768) ^ 2.
+ *
+ * The output array is assumed to have (FFT_BUFFER_SIZE / 2 + 1) elements.
+ * fft is a transform of FFT_BUFFER_SIZE samples.
+ */
+static inline void fft_perform(const sound_sample *input, float *output,
+                               vlc_fft_t *fft)
+{
+    float in[FFT_BUFFER_SIZE];
+
+    for (unsigned i = 0; i < FFT_BUFFER_SIZE; i++)
+        in[i] = input[i];
+    vlc_fft_Power(fft, in, output);
+
+    /* Do divisions to keep the constant and highest frequency terms in scale
+     * with the other terms. */
+    output[0] /= 4;
+    output[FFT_BUFFER_SIZE / 2] /= 4;
+}
 
 #endif /* include-guard */
@@ -73,15 +73,19 @@ typedef struct
         unsigned resamp_start_drift; /**< Resampler drift absolute value */
         int resamp_type; /**< Resampler mode (FIXME: redundant / resampling) */
         bool discontinuity;
+        mtime_t max_advance; /**< Drift above which to down-sample */
+        mtime_t max_delay; /**< Drift above which to up-sample */
     } sync;
 
     audio_sample_format_t input_format;
     audio_sample_format_t mixer_format;
+    audio_replay_gain_t replay_gain; /**< Stream replay gain, for filters */
 
     aout_request_vout_t request_vout;
 
     atomic_uint buffers_lost;
     atomic_uint buffers_played;
+    atomic_llong latency; /**< Last measured playback latency, or -1 */
     atomic_uchar restart;
 } aout_owner_t;
 
@@ -142,7 +146,8 @@ int aout_DecNew(audio_output_t *, const audio_sample_format_t *,
                 const audio_replay_gain_t *, const aout_request_vout_t *);
 void aout_DecDelete(audio_output_t *);
 int aout_DecPlay(audio_output_t *, block_t *, int i_input_rate);
-void aout_DecGetResetStats(audio_output_t *, unsigned *, unsigned *);
+void aout_DecGetResetStats(audio_output_t *, unsigned *, unsigned *,
+                           mtime_t *);
 void aout_DecChangePause(audio_output_t *, bool b_paused, mtime_t i_date);
 void aout_DecFlush(audio_output_t *, bool wait);
 void aout_RequestRestart (audio_output_t *, unsigned);
@@ -84,6 +84,13 @@ int aout_DecNew( audio_output_t *p_aout,
     owner->input_format = *p_format;
     owner->mixer_format = owner->input_format;
     owner->request_vout = *p_request_vout;
+    if (p_replay_gain != NULL)
+        owner->replay_gain = *p_replay_gain;
+    else
+        memset (&owner->replay_gain, 0, sizeof (owner->replay_gain));
+    /* Let the audio filters know the stream replay gain */
+    var_Create (p_aout, "audio-replay-gain", VLC_VAR_ADDRESS);
+    var_SetAddress (p_aout, "audio-replay-gain", &owner->replay_gain);
 
     if (aout_OutputNew (p_aout, &owner->mixer_format))
         goto error;
@@ -99,6 +106,7 @@ error:
         aout_volume_Delete (owner->volume);
         owner->volume = NULL;
         aout_OutputUnlock (p_aout);
+        var_Destroy (p_aout, "audio-replay-gain");
         var_Destroy (p_aout, "stereo-mode");
         return -1;
     }
@@ -106,10 +114,22 @@ error:
     owner->sync.end = VLC_TS_INVALID;
     owner->sync.resamp_type = AOUT_RESAMPLING_NONE;
     owner->sync.discontinuity = true;
+    if (var_InheritBool (p_aout, "audio-low-latency"))
+    {
+        owner->sync.max_advance = AOUT_LOW_LATENCY_PTS_DRIFT;
+        owner->sync.max_delay = AOUT_LOW_LATENCY_PTS_DRIFT;
+        msg_Dbg (p_aout, "low latency mode");
+    }
+    else
+    {
+        owner->sync.max_advance = AOUT_MAX_PTS_ADVANCE;
+        owner->sync.max_delay = AOUT_MAX_PTS_DELAY;
+    }
     aout_OutputUnlock (p_aout);
 
     atomic_init (&owner->buffers_lost, 0);
     atomic_init (&owner->buffers_played, 0);
+    atomic_init (&owner->latency, -1);
     return 0;
 }
 
@@ -129,6 +149,7 @@ void aout_DecDelete (audio_output_t *aout)
     aout_volume_Delete (owner->volume);
     owner->volume = NULL;
     aout_OutputUnlock (aout);
+    var_Destroy (aout, "audio-replay-gain");
     var_Destroy (aout, "stereo-mode");
 }
 
@@ -222,7 +243,7 @@ static void aout_DecSilence (audio_output_t *aout, mtime_t length, mtime_t pts)
 }
 
 static void aout_DecSynchronize (audio_output_t *aout, mtime_t dec_pts,
-                                 int input_rate)
+                                 int input_rate, mtime_t *restrict delay)
 {
     aout_owner_t *owner = aout_owner (aout);
     mtime_t drift;
@@ -243,9 +264,12 @@ static void aout_DecSynchronize (audio_output_t *aout, mtime_t dec_pts,
      * all samples in the buffer will have been played. Then:
      *    pts = mdate() + delay
      */
-    if (aout_OutputTimeGet (aout, &drift) != 0)
+    if (aout_OutputTimeGet (aout, delay) != 0)
+    {
+        *delay = -1;
         return; /* nothing can be done if timing is unknown */
-    drift += mdate () - dec_pts;
+    }
+    drift = *delay + mdate () - dec_pts;
 
     /* Late audio output.
      * This can happen due to insufficient caching, scheduling jitter
@@ -254,7 +278,7 @@ static void aout_DecSynchronize (audio_output_t *aout, mtime_t dec_pts,
      * where supported. The other alternative is to flush the buffers
      * completely. */
     if (drift > (owner->sync.discontinuity ? 0
-                  : +3 * input_rate * AOUT_MAX_PTS_DELAY / INPUT_RATE_DEFAULT))
+                  : +3 * input_rate * owner->sync.max_delay / INPUT_RATE_DEFAULT))
     {
         if (!owner->sync.discontinuity)
             msg_Warn (aout, "playback way too late (%"PRId64"): "
@@ -269,20 +293,24 @@ static void aout_DecSynchronize (audio_output_t *aout, mtime_t dec_pts,
         owner->sync.discontinuity = true;
 
         /* Now the output might be too early... Recheck. */
-        if (aout_OutputTimeGet (aout, &drift) != 0)
+        if (aout_OutputTimeGet (aout, delay) != 0)
+        {
+            *delay = -1;
             return; /* nothing can be done if timing is unknown */
-        drift += mdate () - dec_pts;
+        }
+        drift = *delay + mdate () - dec_pts;
     }
 
     /* Early audio output.
      * This is rare except at startup when the buffers are still empty. */
     if (drift < (owner->sync.discontinuity ? 0
-                : -3 * input_rate * AOUT_MAX_PTS_ADVANCE / INPUT_RATE_DEFAULT))
+                : -3 * input_rate * owner->sync.max_advance / INPUT_RATE_DEFAULT))
     {
         if (!owner->sync.discontinuity)
             msg_Warn (aout, "playback way too early (%"PRId64"): "
                       "playing silence", drift);
         aout_DecSilence (aout, -drift, dec_pts);
+        *delay -= drift;
 
         aout_StopResampling (aout);
         owner->sync.discontinuity = true;
@@ -290,7 +318,7 @@ static void aout_DecSynchronize (audio_output_t *aout, mtime_t dec_pts,
     }
 
     /* Resampling */
-    if (drift > +AOUT_MAX_PTS_DELAY
+    if (drift > +owner->sync.max_delay
      && owner->sync.resamp_type != AOUT_RESAMPLING_UP)
     {
         msg_Warn (aout, "playback too late (%"PRId64"): up-sampling",
@@ -298,7 +326,7 @@ static void aout_DecSynchronize (audio_output_t *aout, mtime_t dec_pts,
         owner->sync.resamp_type = AOUT_RESAMPLING_UP;
         owner->sync.resamp_start_drift = +drift;
     }
-    if (drift < -AOUT_MAX_PTS_ADVANCE
+    if (drift < -owner->sync.max_advance
      && owner->sync.resamp_type != AOUT_RESAMPLING_DOWN)
     {
         msg_Warn (aout, "playback too early (%"PRId64"): down-sampling",
@@ -380,7 +408,12 @@ int aout_DecPlay (audio_output_t *aout, block_t *block, int input_rate)
     aout_volume_Amplify (owner->volume, block);
 
     /* Drift correction */
-    aout_DecSynchronize (aout, block->i_pts, input_rate);
+    mtime_t delay;
+    aout_DecSynchronize (aout, block->i_pts, input_rate, &delay);
+
+    /* Latency: from the decoder to the speakers, if the output can tell */
+    if (delay >= 0)
+        atomic_store (&owner->latency, mdate () - now + delay);
 
     /* Output */
     owner->sync.end = block->i_pts + block->i_length + 1;
@@ -399,12 +432,14 @@ lost:
 }
 
 void aout_DecGetResetStats(audio_output_t *aout, unsigned *restrict lost,
-                           unsigned *restrict played)
+                           unsigned *restrict played,
+                           mtime_t *restrict latency)
 {
     aout_owner_t *owner = aout_owner (aout);
 
     *lost = atomic_exchange(&owner->buffers_lost, 0);
     *played = atomic_exchange(&owner->buffers_played, 0);
+    *latency = atomic_load(&owner->latency);
 }
 
 void aout_DecChangePause (audio_output_t *aout, bool paused, mtime_t date)
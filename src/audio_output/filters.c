@@ -251,6 +251,32 @@ error:
     return -1;
 }
 
+/* Chunk of the in-place filters, to stay within the L1 data cache */
+#define AOUT_INPLACE_CHUNK_BYTES 8192
+
+/**
+ * Runs consecutive in-place filters chunk by chunk, in a single pass over
+ * the block.
+ */
+static void aout_FiltersPipelineInplace(filter_t *const *filters,
+                                        unsigned count, block_t *block)
+{
+    const unsigned channels =
+        aout_FormatNbChannels(&filters[0]->fmt_in.audio);
+    const unsigned chunk =
+        __MAX(AOUT_INPLACE_CHUNK_BYTES / (channels * sizeof (float)), 1);
+    float *buf = (float *)block->p_buffer;
+
+    for (unsigned done = 0; done < block->i_nb_samples; done += chunk)
+    {
+        unsigned frames = __MIN(chunk, block->i_nb_samples - done);
+
+        for (unsigned i = 0; i < count; i++)
+            filters[i]->pf_audio_inplace(filters[i], buf + done * channels,
+                                         frames);
+    }
+}
+
 /**
  * Filters an audio buffer through a chain of filters.
  */
@@ -261,6 +287,17 @@ static block_t *aout_FiltersPipelinePlay(filter_t *const *filters,
     for (unsigned i = 0; (i < count) && (block != NULL); i++)
     {
         filter_t *filter = filters[i];
+        unsigned inplace = 0;
+
+        while (i + inplace < count
+            && filters[i + inplace]->pf_audio_inplace != NULL)
+            inplace++;
+        if (inplace >= 2)
+        {
+            aout_FiltersPipelineInplace(filters + i, inplace, block);
+            i += inplace - 1;
+            continue;
+        }
 
         /* Please note that p_block->i_nb_samples & i_buffer
          * shall be set by the filter plug-in. */
@@ -39,6 +39,7 @@ struct aout_volume
     audio_replay_gain_t replay_gain;
     vlc_atomic_float gain_factor;
     float output_factor;
+    float applied_factor; /**< Last factor applied, negative if none */
     module_t *module;
 };
 
@@ -58,6 +59,7 @@ aout_volume_t *aout_volume_New(vlc_object_t *parent,
         return NULL;
     vol->module = NULL;
     vol->output_factor = 1.f;
+    vol->applied_factor = -1.f;
 
     //audio_volume_t *obj = &vol->object;
 
@@ -95,6 +97,7 @@ int aout_volume_SetFormat(aout_volume_t *vol, vlc_fourcc_t format)
     }
 
     obj->format = format;
+    obj->amplify_ramp = NULL;
     vol->module = module_need(obj, "audio volume", NULL, false);
     if (vol->module == NULL)
         return -1;
@@ -137,7 +140,14 @@ int aout_volume_Amplify(aout_volume_t *vol, block_t *block)
     float amp = vol->output_factor
               * vlc_atomic_load_float (&vol->gain_factor);
 
-    vol->object.amplify(&vol->object, block, amp);
+    /* Ramp volume changes over the block, rather than stepping abruptly */
+    if (amp != vol->applied_factor && vol->applied_factor >= 0.f
+     && vol->object.amplify_ramp != NULL)
+        vol->object.amplify_ramp(&vol->object, block, vol->applied_factor,
+                                 amp);
+    else
+        vol->object.amplify(&vol->object, block, amp);
+    vol->applied_factor = amp;
     return 0;
 }
 
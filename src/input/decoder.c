@@ -104,6 +104,7 @@ struct decoder_owner_sys_t
 
     /* -- These variables need locking on write(only) -- */
     audio_output_t *p_aout;
+    block_pool_t   *p_audio_pool; /* Recycled audio buffers */
 
     vout_thread_t   *p_vout;
 
@@ -281,6 +282,13 @@ static vout_thread_t *aout_request_vout( void *p_private,
     return p_vout;
 }
 
+static block_t *aout_new_buffer( decoder_t *p_dec, size_t i_size )
+{
+    decoder_owner_sys_t *p_owner = p_dec->p_owner;
+
+    return block_pool_Alloc( p_owner->p_audio_pool, i_size );
+}
+
 static int aout_update_format( decoder_t *p_dec )
 {
     decoder_owner_sys_t *p_owner = p_dec->p_owner;
@@ -600,7 +608,9 @@ block_t *decoder_NewAudioBuffer( decoder_t *dec, int samples )
 
     size_t length = samples * dec->fmt_out.audio.i_bytes_per_frame
                             / dec->fmt_out.audio.i_frame_length;
-    block_t *block = block_Alloc( length );
+    block_t *block = dec->pf_aout_buffer_new != NULL
+                   ? dec->pf_aout_buffer_new( dec, length )
+                   : block_Alloc( length );
     if( likely(block != NULL) )
     {
         block->i_nb_samples = samples;
@@ -1199,23 +1209,34 @@ static void DecoderUpdateStatAudio( decoder_t *p_dec, unsigned decoded,
     decoder_owner_sys_t *p_owner = p_dec->p_owner;
     input_thread_t *p_input = p_owner->p_input;
     unsigned played = 0;
+    mtime_t latency = -1;
+    unsigned allocated = 0, recycled = 0;
 
     /* Update ugly stat */
     if( p_input == NULL )
         return;
 
+    if( p_owner->p_audio_pool != NULL )
+        block_pool_GetResetStats( p_owner->p_audio_pool, &allocated,
+                                  &recycled );
+
     if( p_owner->p_aout != NULL )
     {
         unsigned aout_lost;
 
-        aout_DecGetResetStats( p_owner->p_aout, &aout_lost, &played );
+        aout_DecGetResetStats( p_owner->p_aout, &aout_lost, &played,
+                               &latency );
         lost += aout_lost;
     }
 
     vlc_mutex_lock( &p_input->p->counters.counters_lock);
     stats_Update( p_input->p->counters.p_lost_abuffers, lost, NULL );
     stats_Update( p_input->p->counters.p_played_abuffers, played, NULL );
+    if( latency >= 0 )
+        stats_Update( p_input->p->counters.p_audio_latency, latency, NULL );
     stats_Update( p_input->p->counters.p_decoded_audio, decoded, NULL );
+    stats_Update( p_input->p->counters.p_allocated_abuffers, allocated, NULL );
+    stats_Update( p_input->p->counters.p_recycled_abuffers, recycled, NULL );
     vlc_mutex_unlock( &p_input->p->counters.counters_lock);
 }
 
@@ -1644,6 +1665,7 @@ static decoder_t * CreateDecoder( vlc_object_t *p_parent,
     p_owner->p_input = p_input;
     p_owner->p_resource = p_resource;
     p_owner->p_aout = NULL;
+    p_owner->p_audio_pool = NULL;
     p_owner->p_vout = NULL;
     p_owner->p_spu_vout = NULL;
     p_owner->i_spu_channel = 0;
@@ -1688,6 +1710,11 @@ static decoder_t * CreateDecoder( vlc_object_t *p_parent,
 
     /* Set buffers allocation callbacks for the decoders */
     p_dec->pf_aout_format_update = aout_update_format;
+    /* Audio buffers return to the pool once played by the audio output */
+    if( fmt->i_cat == AUDIO_ES && p_sout == NULL )
+        p_owner->p_audio_pool = block_pool_New();
+    if( p_owner->p_audio_pool != NULL )
+        p_dec->pf_aout_buffer_new = aout_new_buffer;
     p_dec->pf_vout_format_update = vout_update_format;
     p_dec->pf_vout_buffer_new = vout_new_buffer;
     p_dec->pf_spu_buffer_new  = spu_new_buffer;
@@ -1790,6 +1817,8 @@ static void DeleteDecoder( decoder_t * p_dec )
         if( p_owner->p_input != NULL )
             input_SendEventAout( p_owner->p_input );
     }
+    if( p_owner->p_audio_pool )
+        block_pool_Release( p_owner->p_audio_pool );
     if( p_owner->p_vout )
     {
         /* Hack to make sure all the the pictures are freed by the decoder
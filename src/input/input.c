@@ -806,6 +806,9 @@ static void InitStatistics( input_thread_t * p_input )
         INIT_COUNTER( demux_discontinuity, COUNTER );
         INIT_COUNTER( played_abuffers, COUNTER );
         INIT_COUNTER( lost_abuffers, COUNTER );
+        INIT_COUNTER( audio_latency, LAST );
+        INIT_COUNTER( allocated_abuffers, COUNTER );
+        INIT_COUNTER( recycled_abuffers, COUNTER );
         INIT_COUNTER( displayed_pictures, COUNTER );
         INIT_COUNTER( lost_pictures, COUNTER );
         INIT_COUNTER( decoded_audio, COUNTER );
@@ -1387,6 +1390,9 @@ error:
         EXIT_COUNTER( demux_discontinuity );
         EXIT_COUNTER( played_abuffers );
         EXIT_COUNTER( lost_abuffers );
+        EXIT_COUNTER( audio_latency );
+        EXIT_COUNTER( allocated_abuffers );
+        EXIT_COUNTER( recycled_abuffers );
         EXIT_COUNTER( displayed_pictures );
         EXIT_COUNTER( lost_pictures );
         EXIT_COUNTER( decoded_audio );
@@ -1452,6 +1458,9 @@ static void End( input_thread_t * p_input )
             CL_CO( demux_discontinuity );
             CL_CO( played_abuffers );
             CL_CO( lost_abuffers );
+            CL_CO( audio_latency );
+            CL_CO( allocated_abuffers );
+            CL_CO( recycled_abuffers );
             CL_CO( displayed_pictures );
             CL_CO( lost_pictures );
             CL_CO( decoded_audio) ;
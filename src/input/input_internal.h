@@ -154,6 +154,9 @@ struct input_thread_private_t
         counter_t *p_sout_send_bitrate;
         counter_t *p_played_abuffers;
         counter_t *p_lost_abuffers;
+        counter_t *p_audio_latency;
+        counter_t *p_allocated_abuffers;
+        counter_t *p_recycled_abuffers;
         counter_t *p_displayed_pictures;
         counter_t *p_lost_pictures;
         vlc_mutex_t counters_lock;
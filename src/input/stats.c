@@ -27,13 +27,13 @@
 
 #include <vlc_common.h>
 #include "input/input_internal.h"
+#include "stream_output/stream_output.h"
 
 /**
  * Create a statistics counter
  * \param i_compute_type the aggregation type. One of STATS_LAST (always
  * keep the last value), STATS_COUNTER (increment by the passed value),
- * STATS_MAX (keep the maximum passed value), STATS_MIN, or STATS_DERIVATIVE
- * (keep a time derivative of the value)
+ * or STATS_DERIVATIVE (keep a time derivative of the value)
  */
 counter_t * stats_CounterCreate( int i_compute_type )
 {
@@ -83,6 +83,12 @@ void stats_ComputeInputStats(input_thread_t *input, input_stats_t *st)
     if (!libvlc_stats(input))
         return;
 
+    /* Query the stream output first, it may be busy encoding */
+    input_stage_stats_t decode = { 0 }, filter = { 0 }, encode = { 0 };
+    bool transcode = input->p->p_sout != NULL
+        && sout_GetStats(input->p->p_sout, &decode, &filter,
+                         &encode) == VLC_SUCCESS;
+
     vlc_mutex_lock(&input->p->counters.counters_lock);
     vlc_mutex_lock(&st->lock);
 
@@ -106,10 +112,21 @@ void stats_ComputeInputStats(input_thread_t *input, input_stats_t *st)
         st->i_sent_bytes = stats_GetTotal(input->p->counters.p_sout_sent_bytes);
         st->f_send_bitrate = stats_GetRate(input->p->counters.p_sout_send_bitrate);
     }
+    if (transcode)
+    {
+        st->transcode_decode = decode;
+        st->transcode_filter = filter;
+        st->transcode_encode = encode;
+    }
 
     /* Aout */
     st->i_played_abuffers = stats_GetTotal(input->p->counters.p_played_abuffers);
     st->i_lost_abuffers = stats_GetTotal(input->p->counters.p_lost_abuffers);
+    st->i_audio_latency = stats_GetTotal(input->p->counters.p_audio_latency);
+    st->i_allocated_abuffers =
+        stats_GetTotal(input->p->counters.p_allocated_abuffers);
+    st->i_recycled_abuffers =
+        stats_GetTotal(input->p->counters.p_recycled_abuffers);
 
     /* Vouts */
     st->i_displayed_pictures = stats_GetTotal(input->p->counters.p_displayed_pictures);
@@ -129,9 +146,14 @@ void stats_ReinitInputStats( input_stats_t *p_stats )
     p_stats->i_demux_corrupted = p_stats->i_demux_discontinuity =
     p_stats->i_displayed_pictures = p_stats->i_lost_pictures =
     p_stats->i_played_abuffers = p_stats->i_lost_abuffers =
+    p_stats->i_audio_latency =
+    p_stats->i_allocated_abuffers = p_stats->i_recycled_abuffers =
     p_stats->i_decoded_video = p_stats->i_decoded_audio =
     p_stats->i_sent_bytes = p_stats->i_sent_packets = p_stats->f_send_bitrate
      = 0;
+    memset( &p_stats->transcode_decode, 0, sizeof(p_stats->transcode_decode) );
+    memset( &p_stats->transcode_filter, 0, sizeof(p_stats->transcode_filter) );
+    memset( &p_stats->transcode_encode, 0, sizeof(p_stats->transcode_encode) );
     vlc_mutex_unlock( &p_stats->lock );
 }
 
@@ -190,6 +212,7 @@ void stats_Update( counter_t *p_counter, uint64_t val, uint64_t *new_val )
         }
         break;
     }
+    case STATS_LAST:
     case STATS_COUNTER:
         if( p_counter->i_samples == 0 )
         {
@@ -205,7 +228,10 @@ void stats_Update( counter_t *p_counter, uint64_t val, uint64_t *new_val )
         }
         if( p_counter->i_samples == 1 )
         {
-            p_counter->pp_samples[0]->value += val;
+            if( p_counter->i_compute_type == STATS_LAST )
+                p_counter->pp_samples[0]->value = val;
+            else
+                p_counter->pp_samples[0]->value += val;
             if( new_val )
                 *new_val = p_counter->pp_samples[0]->value;
         }
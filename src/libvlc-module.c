@@ -124,6 +124,12 @@ static const char *const ppsz_snap_formats[] =
     "The default behavior is to automatically select the best method " \
     "available.")
 
+#define AOUT_LOW_LATENCY_TEXT N_("Low latency audio output")
+#define AOUT_LOW_LATENCY_LONGTEXT N_( \
+    "Use short buffers in the audio output device, and correct clock drift " \
+    "more tightly. This reduces the audio latency, for live monitoring, at " \
+    "the expense of a higher CPU usage and a higher risk of drop-outs.")
+
 #define ROLE_TEXT N_("Media role")
 #define ROLE_LONGTEXT N_("Media (player) role for operating system policy.")
 
@@ -1486,6 +1492,8 @@ vlc_module_begin ()
     add_module( "aout", "audio output", NULL, AOUT_TEXT, AOUT_LONGTEXT,
                 true )
         change_short('A')
+    add_bool( "audio-low-latency", false, AOUT_LOW_LATENCY_TEXT,
+              AOUT_LOW_LATENCY_LONGTEXT, true )
     add_string( "role", "video", ROLE_TEXT, ROLE_LONGTEXT, true )
         change_string_list( ppsz_roles, ppsz_roles_text )
 
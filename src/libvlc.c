@@ -71,6 +71,7 @@
 #include "libvlc.h"
 #include "playlist/playlist_internal.h"
 #include "misc/variables.h"
+#include "misc/picture.h"
 
 #include <vlc_vlm.h>
 
@@ -547,6 +548,8 @@ void libvlc_InternalCleanup( libvlc_int_t *p_libvlc )
     /* Free module bank. It is refcounted, so we call this each time  */
     vlc_LogDeinit (p_libvlc);
     module_EndBank (true);
+    /* Do not keep pixel buffers around after the pictures are gone */
+    picture_buffer_Flush ();
 #if defined(_WIN32) || defined(__OS2__)
     system_End( );
 #endif
@@ -177,6 +177,7 @@ void var_OptionParse (vlc_object_t *, const char *, bool trusted);
  */
 enum
 {
+    STATS_LAST,
     STATS_COUNTER,
     STATS_DERIVATIVE,
 };
@@ -226,4 +227,31 @@ void stats_CounterClean (counter_t * );
 void stats_ComputeInputStats(input_thread_t*, input_stats_t*);
 void stats_ReinitInputStats(input_stats_t *);
 
+/*
+ * Block pools
+ */
+typedef struct block_pool block_pool_t;
+
+/**
+ * Creates a pool of recycled blocks.
+ * Blocks allocated from the pool return to it when released, from any thread.
+ */
+block_pool_t *block_pool_New (void);
+
+/**
+ * Releases the pool. It is destroyed once all its blocks are released.
+ */
+void block_pool_Release (block_pool_t *);
+
+/**
+ * Allocates a block, recycling a released one if large enough.
+ */
+block_t *block_pool_Alloc (block_pool_t *, size_t);
+
+/**
+ * Gets and resets the number of blocks allocated from the heap and recycled.
+ */
+void block_pool_GetResetStats (block_pool_t *, unsigned *restrict allocated,
+                               unsigned *restrict recycled);
+
 #endif
@@ -37,6 +37,7 @@
 #include <vlc_common.h>
 #include <vlc_block.h>
 #include <vlc_fs.h>
+#include "../libvlc.h"
 
 /**
  * @section Block handling functions.
@@ -278,6 +279,185 @@ block_t *block_heap_Alloc (void *addr, size_t length)
     return block;
 }
 
+/**
+ * @section Recycled blocks.
+ *
+ * The blocks of a pool return to it when released, so that their memory can
+ * be reused. The pool lives as long as its owner or any of its blocks.
+ */
+
+/** Largest number of released blocks kept for reuse */
+#define BLOCK_POOL_MAX   16
+
+/** Rounding of the blocks size, so that slightly smaller or larger blocks
+ * can be reused for one another */
+#define BLOCK_POOL_ROUND 4096
+
+struct block_pool
+{
+    vlc_mutex_t lock;
+    block_t *cache; /**< Released blocks, most recent first */
+    unsigned cached;
+    unsigned refs; /**< Owner reference plus one per block */
+    bool owned;
+    unsigned allocated;
+    unsigned recycled;
+};
+
+typedef struct
+{
+    block_t self;
+    block_pool_t *pool;
+    size_t capacity;
+} block_pooled_t;
+
+block_pool_t *block_pool_New (void)
+{
+    block_pool_t *pool = malloc (sizeof (*pool));
+    if (unlikely(pool == NULL))
+        return NULL;
+
+    vlc_mutex_init (&pool->lock);
+    pool->cache = NULL;
+    pool->cached = 0;
+    pool->refs = 1;
+    pool->owned = true;
+    pool->allocated = 0;
+    pool->recycled = 0;
+    return pool;
+}
+
+/** Drops a reference, destroying the pool with the last one */
+static void block_pool_Unref (block_pool_t *pool, unsigned refs)
+{
+    vlc_mutex_lock (&pool->lock);
+    assert (pool->refs >= refs);
+    pool->refs -= refs;
+    refs = pool->refs;
+    vlc_mutex_unlock (&pool->lock);
+
+    if (refs == 0)
+    {
+        vlc_mutex_destroy (&pool->lock);
+        free (pool);
+    }
+}
+
+void block_pool_Release (block_pool_t *pool)
+{
+    vlc_mutex_lock (&pool->lock);
+    block_t *cache = pool->cache;
+    unsigned cached = pool->cached;
+
+    pool->cache = NULL;
+    pool->cached = 0;
+    pool->owned = false;
+    vlc_mutex_unlock (&pool->lock);
+
+    while (cache != NULL)
+    {
+        block_t *next = cache->p_next;
+
+        free (cache);
+        cache = next;
+    }
+    block_pool_Unref (pool, 1 + cached);
+}
+
+static void block_pool_ReleaseBlock (block_t *block)
+{
+    block_pool_t *pool = ((block_pooled_t *)block)->pool;
+
+    block_Invalidate (block);
+
+    vlc_mutex_lock (&pool->lock);
+    if (pool->owned && pool->cached < BLOCK_POOL_MAX)
+    {
+        block->p_next = pool->cache;
+        pool->cache = block;
+        pool->cached++;
+        vlc_mutex_unlock (&pool->lock);
+        return;
+    }
+    vlc_mutex_unlock (&pool->lock);
+
+    free (block);
+    block_pool_Unref (pool, 1);
+}
+
+block_t *block_pool_Alloc (block_pool_t *pool, size_t size)
+{
+    block_t *block = NULL, *small = NULL;
+
+    vlc_mutex_lock (&pool->lock);
+    for (block_t **pp = &pool->cache; *pp != NULL; pp = &(*pp)->p_next)
+        if (((block_pooled_t *)*pp)->capacity >= size)
+        {
+            block = *pp;
+            *pp = block->p_next;
+            pool->cached--;
+            pool->recycled++;
+            break;
+        }
+
+    if (block == NULL && pool->cache != NULL)
+    {   /* Make room for a larger block */
+        small = pool->cache;
+        pool->cache = small->p_next;
+        pool->cached--;
+    }
+    vlc_mutex_unlock (&pool->lock);
+
+    if (small != NULL)
+    {
+        free (small);
+        block_pool_Unref (pool, 1);
+    }
+
+    if (block == NULL)
+    {
+        size_t capacity = (size + BLOCK_POOL_ROUND - 1)
+                        & ~(size_t)(BLOCK_POOL_ROUND - 1);
+        const size_t alloc = sizeof (block_pooled_t) + BLOCK_ALIGN
+                           + (2 * BLOCK_PADDING) + capacity;
+        if (unlikely(capacity < size || alloc <= capacity))
+            return NULL;
+
+        block_pooled_t *pb = malloc (alloc);
+        if (unlikely(pb == NULL))
+            return NULL;
+
+        pb->pool = pool;
+        pb->capacity = capacity;
+        block = &pb->self;
+
+        vlc_mutex_lock (&pool->lock);
+        pool->refs++;
+        pool->allocated++;
+        vlc_mutex_unlock (&pool->lock);
+    }
+
+    block_pooled_t *pb = (block_pooled_t *)block;
+
+    block_Init (block, pb + 1, BLOCK_ALIGN + (2 * BLOCK_PADDING)
+                               + pb->capacity);
+    block->p_buffer += BLOCK_PADDING + BLOCK_ALIGN - 1;
+    block->p_buffer = (void *)(((uintptr_t)block->p_buffer) & ~(BLOCK_ALIGN - 1));
+    block->i_buffer = size;
+    block->pf_release = block_pool_ReleaseBlock;
+    return block;
+}
+
+void block_pool_GetResetStats (block_pool_t *pool, unsigned *restrict allocated,
+                               unsigned *restrict recycled)
+{
+    vlc_mutex_lock (&pool->lock);
+    *allocated = pool->allocated;
+    *recycled = pool->recycled;
+    pool->allocated = pool->recycled = 0;
+    vlc_mutex_unlock (&pool->lock);
+}
+
 #ifdef HAVE_MMAP
 # include <sys/mman.h>
 
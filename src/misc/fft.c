@@ -0,0 +1,747 @@
+/*****************************************************************************
+ * fft.c: real-input fast Fourier transform
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+
+#include <vlc_common.h>
+#include <vlc_cpu.h>
+#include <vlc_fft.h>
+
+#if defined(HAVE_SSE_INTRINSICS) && (defined(__i386__) || defined(__x86_64__))
+# include <xmmintrin.h>
+# define FFT_SSE 1
+#endif
+#if defined(__ARM_NEON__) || defined(__aarch64__)
+# include <arm_neon.h>
+# define FFT_NEON 1
+#endif
+
+/*
+ * The size real samples are transformed as size / 2 complex samples, then
+ * the spectrum of the real signal is untangled from the complex one.
+ *
+ * The complex transform is a mixed radix (4, 2, 3, 5) Stockham auto-sort FFT,
+ * with decimation in frequency, on split real and imaginary arrays. Each
+ * stage reads one pair of arrays and writes the other one, in natural order,
+ * so that no bit reversal pass is needed. After the first stage, the inner
+ * loop runs over contiguous samples, and is vectorized.
+ */
+
+#define FFT_MAX_STAGES 32
+
+struct fft_stage;
+typedef void (*fft_butterfly_t)(const struct fft_stage *,
+                                const float *, const float *,
+                                float *, float *);
+
+struct fft_stage
+{
+    fft_butterfly_t butterfly;
+    unsigned radix;
+    unsigned count; /**< Length of the stage sub-transforms divided by radix */
+    unsigned stride;
+    const float *tw_re; /**< (radix - 1) * count twiddle factors */
+    const float *tw_im;
+};
+
+struct fft_plan
+{
+    struct fft_plan *next;
+    unsigned refs;
+    unsigned size; /**< Number of real samples */
+    unsigned stages;
+    struct fft_stage stage[FFT_MAX_STAGES];
+    float *post_re; /**< exp(-2i.pi.k/size), for k <= size / 4 */
+    float *post_im;
+    float tables[];
+};
+
+struct vlc_fft
+{
+    struct fft_plan *plan;
+    float *work; /**< Two pairs of split complex arrays */
+    unsigned pitch; /**< Distance between the work arrays */
+};
+
+static struct
+{
+    vlc_mutex_t lock;
+    struct fft_plan *list;
+} plans = { .lock = VLC_STATIC_MUTEX };
+
+/*****************************************************************************
+ * Butterflies
+ *****************************************************************************/
+/* Each stage splits sub-transforms of length radix * count, found every
+ * stride samples, into radix sub-transforms of length count, found every
+ * radix * stride samples. */
+
+static void fft_radix2_c(const struct fft_stage *st,
+                         const float *xr, const float *xi,
+                         float *yr, float *yi)
+{
+    const unsigned m = st->count, s = st->stride;
+
+    for (unsigned p = 0; p < m; p++)
+    {
+        const float wr = st->tw_re[p], wi = st->tw_im[p];
+        const float *ar = xr + s * p, *ai = xi + s * p;
+        const float *br = ar + s * m, *bi = ai + s * m;
+        float *y0r = yr + 2 * s * p, *y0i = yi + 2 * s * p;
+        float *y1r = y0r + s, *y1i = y0i + s;
+
+        for (unsigned q = 0; q < s; q++)
+        {
+            const float dr = ar[q] - br[q], di = ai[q] - bi[q];
+
+            y0r[q] = ar[q] + br[q];
+            y0i[q] = ai[q] + bi[q];
+            y1r[q] = dr * wr - di * wi;
+            y1i[q] = dr * wi + di * wr;
+        }
+    }
+}
+
+static void fft_radix3_c(const struct fft_stage *st,
+                         const float *xr, const float *xi,
+                         float *yr, float *yi)
+{
+    const unsigned m = st->count, s = st->stride;
+    const float c = 0.86602540378443864676f; /* sin(2.pi/3) */
+
+    for (unsigned p = 0; p < m; p++)
+    {
+        const float w1r = st->tw_re[p], w1i = st->tw_im[p];
+        const float w2r = st->tw_re[m + p], w2i = st->tw_im[m + p];
+        const float *x0r = xr + s * p, *x0i = xi + s * p;
+        float *y0r = yr + 3 * s * p, *y0i = yi + 3 * s * p;
+
+        for (unsigned q = 0; q < s; q++)
+        {
+            const float ar = x0r[q], ai = x0i[q];
+            const float br = x0r[q + s * m], bi = x0i[q + s * m];
+            const float cr = x0r[q + 2 * s * m], ci = x0i[q + 2 * s * m];
+            const float sr = br + cr, si = bi + ci;
+            const float dr = c * (br - cr), di = c * (bi - ci);
+            const float hr = ar - .5f * sr, hi = ai - .5f * si;
+            const float t1r = hr + di, t1i = hi - dr;
+            const float t2r = hr - di, t2i = hi + dr;
+
+            y0r[q] = ar + sr;
+            y0i[q] = ai + si;
+            y0r[q + s] = t1r * w1r - t1i * w1i;
+            y0i[q + s] = t1r * w1i + t1i * w1r;
+            y0r[q + 2 * s] = t2r * w2r - t2i * w2i;
+            y0i[q + 2 * s] = t2r * w2i + t2i * w2r;
+        }
+    }
+}
+
+static void fft_radix4_c(const struct fft_stage *st,
+                         const float *xr, const float *xi,
+                         float *yr, float *yi)
+{
+    const unsigned m = st->count, s = st->stride;
+
+    for (unsigned p = 0; p < m; p++)
+    {
+        const float w1r = st->tw_re[p], w1i = st->tw_im[p];
+        const float w2r = st->tw_re[m + p], w2i = st->tw_im[m + p];
+        const float w3r = st->tw_re[2 * m + p], w3i = st->tw_im[2 * m + p];
+        const float *x0r = xr + s * p, *x0i = xi + s * p;
+        float *y0r = yr + 4 * s * p, *y0i = yi + 4 * s * p;
+
+        for (unsigned q = 0; q < s; q++)
+        {
+            const float ar = x0r[q], ai = x0i[q];
+            const float br = x0r[q + s * m], bi = x0i[q + s * m];
+            const float cr = x0r[q + 2 * s * m], ci = x0i[q + 2 * s * m];
+            const float dr = x0r[q + 3 * s * m], di = x0i[q + 3 * s * m];
+            const float t0r = ar + cr, t0i = ai + ci;
+            const float t1r = ar - cr, t1i = ai - ci;
+            const float t2r = br + dr, t2i = bi + di;
+            const float t3r = br - dr, t3i = bi - di;
+            /* (t1 - i.t3), (t0 - t2) and (t1 + i.t3) */
+            const float u1r = t1r + t3i, u1i = t1i - t3r;
+            const float u2r = t0r - t2r, u2i = t0i - t2i;
+            const float u3r = t1r - t3i, u3i = t1i + t3r;
+
+            y0r[q] = t0r + t2r;
+            y0i[q] = t0i + t2i;
+            y0r[q + s] = u1r * w1r - u1i * w1i;
+            y0i[q + s] = u1r * w1i + u1i * w1r;
+            y0r[q + 2 * s] = u2r * w2r - u2i * w2i;
+            y0i[q + 2 * s] = u2r * w2i + u2i * w2r;
+            y0r[q + 3 * s] = u3r * w3r - u3i * w3i;
+            y0i[q + 3 * s] = u3r * w3i + u3i * w3r;
+        }
+    }
+}
+
+static void fft_radix5_c(const struct fft_stage *st,
+                         const float *xr, const float *xi,
+                         float *yr, float *yi)
+{
+    const unsigned m = st->count, s = st->stride;
+    const float c1 = 0.30901699437494742410f;  /* cos(2.pi/5) */
+    const float c2 = -0.80901699437494742410f; /* cos(4.pi/5) */
+    const float s1 = 0.95105651629515357212f;  /* sin(2.pi/5) */
+    const float s2 = 0.58778525229247312917f;  /* sin(4.pi/5) */
+
+    for (unsigned p = 0; p < m; p++)
+    {
+        const float *x0r = xr + s * p, *x0i = xi + s * p;
+        float *y0r = yr + 5 * s * p, *y0i = yi + 5 * s * p;
+        float wr[4], wi[4];
+
+        for (unsigned u = 0; u < 4; u++)
+        {
+            wr[u] = st->tw_re[u * m + p];
+            wi[u] = st->tw_im[u * m + p];
+        }
+
+        for (unsigned q = 0; q < s; q++)
+        {
+            const float ar = x0r[q], ai = x0i[q];
+            const float b1r = x0r[q + s * m] + x0r[q + 4 * s * m];
+            const float b1i = x0i[q + s * m] + x0i[q + 4 * s * m];
+            const float b2r = x0r[q + 2 * s * m] + x0r[q + 3 * s * m];
+            const float b2i = x0i[q + 2 * s * m] + x0i[q + 3 * s * m];
+            const float d1r = x0r[q + s * m] - x0r[q + 4 * s * m];
+            const float d1i = x0i[q + s * m] - x0i[q + 4 * s * m];
+            const float d2r = x0r[q + 2 * s * m] - x0r[q + 3 * s * m];
+            const float d2i = x0i[q + 2 * s * m] - x0i[q + 3 * s * m];
+            const float t1r = ar + c1 * b1r + c2 * b2r;
+            const float t1i = ai + c1 * b1i + c2 * b2i;
+            const float t2r = ar + c2 * b1r + c1 * b2r;
+            const float t2i = ai + c2 * b1i + c1 * b2i;
+            const float t3r = s1 * d1r + s2 * d2r, t3i = s1 * d1i + s2 * d2i;
+            const float t4r = s2 * d1r - s1 * d2r, t4i = s2 * d1i - s1 * d2i;
+            /* t1 - i.t3, t2 - i.t4, t2 + i.t4 and t1 + i.t3 */
+            const float ur[4] = { t1r + t3i, t2r + t4i, t2r - t4i, t1r - t3i };
+            const float ui[4] = { t1i - t3r, t2i - t4r, t2i + t4r, t1i + t3r };
+
+            y0r[q] = ar + b1r + b2r;
+            y0i[q] = ai + b1i + b2i;
+            for (unsigned u = 0; u < 4; u++)
+            {
+                y0r[q + (u + 1) * s] = ur[u] * wr[u] - ui[u] * wi[u];
+                y0i[q + (u + 1) * s] = ur[u] * wi[u] + ui[u] * wr[u];
+            }
+        }
+    }
+}
+
+#ifdef FFT_SSE
+/* Complex multiplication of split vectors */
+# define CMUL_SSE(r, i, wr, wi) do { \
+    __m128 r_ = _mm_sub_ps(_mm_mul_ps(r, wr), _mm_mul_ps(i, wi)); \
+    i = _mm_add_ps(_mm_mul_ps(r, wi), _mm_mul_ps(i, wr)); \
+    r = r_; \
+} while (0)
+
+/* Radix-4 butterflies of 4 vectors, twiddles not applied */
+# define RADIX4_SSE(ar, ai, br, bi, cr, ci, dr, di) do { \
+    __m128 t0r = _mm_add_ps(ar, cr), t0i = _mm_add_ps(ai, ci); \
+    __m128 t1r = _mm_sub_ps(ar, cr), t1i = _mm_sub_ps(ai, ci); \
+    __m128 t2r = _mm_add_ps(br, dr), t2i = _mm_add_ps(bi, di); \
+    __m128 t3r = _mm_sub_ps(br, dr), t3i = _mm_sub_ps(bi, di); \
+    ar = _mm_add_ps(t0r, t2r); ai = _mm_add_ps(t0i, t2i); \
+    br = _mm_add_ps(t1r, t3i); bi = _mm_sub_ps(t1i, t3r); \
+    cr = _mm_sub_ps(t0r, t2r); ci = _mm_sub_ps(t0i, t2i); \
+    dr = _mm_sub_ps(t1r, t3i); di = _mm_add_ps(t1i, t3r); \
+} while (0)
+
+/* Stride multiple of 4: vectorized over contiguous samples */
+VLC_SSE
+static void fft_radix4_sse(const struct fft_stage *st,
+                           const float *xr, const float *xi,
+                           float *yr, float *yi)
+{
+    const unsigned m = st->count, s = st->stride;
+
+    for (unsigned p = 0; p < m; p++)
+    {
+        const __m128 w1r = _mm_set1_ps(st->tw_re[p]);
+        const __m128 w1i = _mm_set1_ps(st->tw_im[p]);
+        const __m128 w2r = _mm_set1_ps(st->tw_re[m + p]);
+        const __m128 w2i = _mm_set1_ps(st->tw_im[m + p]);
+        const __m128 w3r = _mm_set1_ps(st->tw_re[2 * m + p]);
+        const __m128 w3i = _mm_set1_ps(st->tw_im[2 * m + p]);
+        const float *x0r = xr + s * p, *x0i = xi + s * p;
+        float *y0r = yr + 4 * s * p, *y0i = yi + 4 * s * p;
+
+        for (unsigned q = 0; q < s; q += 4)
+        {
+            __m128 ar = _mm_load_ps(x0r + q), ai = _mm_load_ps(x0i + q);
+            __m128 br = _mm_load_ps(x0r + q + s * m);
+            __m128 bi = _mm_load_ps(x0i + q + s * m);
+            __m128 cr = _mm_load_ps(x0r + q + 2 * s * m);
+            __m128 ci = _mm_load_ps(x0i + q + 2 * s * m);
+            __m128 dr = _mm_load_ps(x0r + q + 3 * s * m);
+            __m128 di = _mm_load_ps(x0i + q + 3 * s * m);
+
+            RADIX4_SSE(ar, ai, br, bi, cr, ci, dr, di);
+            CMUL_SSE(br, bi, w1r, w1i);
+            CMUL_SSE(cr, ci, w2r, w2i);
+            CMUL_SSE(dr, di, w3r, w3i);
+
+            _mm_store_ps(y0r + q, ar);
+            _mm_store_ps(y0i + q, ai);
+            _mm_store_ps(y0r + q + s, br);
+            _mm_store_ps(y0i + q + s, bi);
+            _mm_store_ps(y0r + q + 2 * s, cr);
+            _mm_store_ps(y0i + q + 2 * s, ci);
+            _mm_store_ps(y0r + q + 3 * s, dr);
+            _mm_store_ps(y0i + q + 3 * s, di);
+        }
+    }
+}
+
+/* First stage (unit stride): vectorized over 4 sub-transforms, the outputs
+ * of which are transposed to be stored contiguously */
+VLC_SSE
+static void fft_radix4_first_sse(const struct fft_stage *st,
+                                 const float *xr, const float *xi,
+                                 float *yr, float *yi)
+{
+    const unsigned m = st->count;
+
+    assert(st->stride == 1);
+    for (unsigned p = 0; p < m; p += 4)
+    {
+        __m128 ar = _mm_load_ps(xr + p), ai = _mm_load_ps(xi + p);
+        __m128 br = _mm_load_ps(xr + m + p), bi = _mm_load_ps(xi + m + p);
+        __m128 cr = _mm_load_ps(xr + 2 * m + p);
+        __m128 ci = _mm_load_ps(xi + 2 * m + p);
+        __m128 dr = _mm_load_ps(xr + 3 * m + p);
+        __m128 di = _mm_load_ps(xi + 3 * m + p);
+
+        RADIX4_SSE(ar, ai, br, bi, cr, ci, dr, di);
+        CMUL_SSE(br, bi, _mm_loadu_ps(st->tw_re + p),
+                 _mm_loadu_ps(st->tw_im + p));
+        CMUL_SSE(cr, ci, _mm_loadu_ps(st->tw_re + m + p),
+                 _mm_loadu_ps(st->tw_im + m + p));
+        CMUL_SSE(dr, di, _mm_loadu_ps(st->tw_re + 2 * m + p),
+                 _mm_loadu_ps(st->tw_im + 2 * m + p));
+
+        _MM_TRANSPOSE4_PS(ar, br, cr, dr);
+        _MM_TRANSPOSE4_PS(ai, bi, ci, di);
+        _mm_store_ps(yr + 4 * p, ar);
+        _mm_store_ps(yr + 4 * p + 4, br);
+        _mm_store_ps(yr + 4 * p + 8, cr);
+        _mm_store_ps(yr + 4 * p + 12, dr);
+        _mm_store_ps(yi + 4 * p, ai);
+        _mm_store_ps(yi + 4 * p + 4, bi);
+        _mm_store_ps(yi + 4 * p + 8, ci);
+        _mm_store_ps(yi + 4 * p + 12, di);
+    }
+}
+
+VLC_SSE
+static void fft_radix2_sse(const struct fft_stage *st,
+                           const float *xr, const float *xi,
+                           float *yr, float *yi)
+{
+    const unsigned m = st->count, s = st->stride;
+
+    for (unsigned p = 0; p < m; p++)
+    {
+        const __m128 wr = _mm_set1_ps(st->tw_re[p]);
+        const __m128 wi = _mm_set1_ps(st->tw_im[p]);
+        const float *ar = xr + s * p, *ai = xi + s * p;
+        const float *br = ar + s * m, *bi = ai + s * m;
+        float *y0r = yr + 2 * s * p, *y0i = yi + 2 * s * p;
+        float *y1r = y0r + s, *y1i = y0i + s;
+
+        for (unsigned q = 0; q < s; q += 4)
+        {
+            __m128 a_r = _mm_load_ps(ar + q), a_i = _mm_load_ps(ai + q);
+            __m128 b_r = _mm_load_ps(br + q), b_i = _mm_load_ps(bi + q);
+            __m128 dr = _mm_sub_ps(a_r, b_r), di = _mm_sub_ps(a_i, b_i);
+
+            CMUL_SSE(dr, di, wr, wi);
+            _mm_store_ps(y0r + q, _mm_add_ps(a_r, b_r));
+            _mm_store_ps(y0i + q, _mm_add_ps(a_i, b_i));
+            _mm_store_ps(y1r + q, dr);
+            _mm_store_ps(y1i + q, di);
+        }
+    }
+}
+#endif
+
+#ifdef FFT_NEON
+/* Stride multiple of 4: vectorized over contiguous samples */
+static void fft_radix4_neon(const struct fft_stage *st,
+                            const float *xr, const float *xi,
+                            float *yr, float *yi)
+{
+    const unsigned m = st->count, s = st->stride;
+
+    for (unsigned p = 0; p < m; p++)
+    {
+        float32x4_t wr[3], wi[3];
+        const float *x0r = xr + s * p, *x0i = xi + s * p;
+        float *y0r = yr + 4 * s * p, *y0i = yi + 4 * s * p;
+
+        for (unsigned u = 0; u < 3; u++)
+        {
+            wr[u] = vdupq_n_f32(st->tw_re[u * m + p]);
+            wi[u] = vdupq_n_f32(st->tw_im[u * m + p]);
+        }
+
+        for (unsigned q = 0; q < s; q += 4)
+        {
+            float32x4_t ar = vld1q_f32(x0r + q), ai = vld1q_f32(x0i + q);
+            float32x4_t br = vld1q_f32(x0r + q + s * m);
+            float32x4_t bi = vld1q_f32(x0i + q + s * m);
+            float32x4_t cr = vld1q_f32(x0r + q + 2 * s * m);
+            float32x4_t ci = vld1q_f32(x0i + q + 2 * s * m);
+            float32x4_t dr = vld1q_f32(x0r + q + 3 * s * m);
+            float32x4_t di = vld1q_f32(x0i + q + 3 * s * m);
+            float32x4_t t0r = vaddq_f32(ar, cr), t0i = vaddq_f32(ai, ci);
+            float32x4_t t1r = vsubq_f32(ar, cr), t1i = vsubq_f32(ai, ci);
+            float32x4_t t2r = vaddq_f32(br, dr), t2i = vaddq_f32(bi, di);
+            float32x4_t t3r = vsubq_f32(br, dr), t3i = vsubq_f32(bi, di);
+            float32x4_t ur[3], ui[3];
+
+            ur[0] = vaddq_f32(t1r, t3i); ui[0] = vsubq_f32(t1i, t3r);
+            ur[1] = vsubq_f32(t0r, t2r); ui[1] = vsubq_f32(t0i, t2i);
+            ur[2] = vsubq_f32(t1r, t3i); ui[2] = vaddq_f32(t1i, t3r);
+
+            vst1q_f32(y0r + q, vaddq_f32(t0r, t2r));
+            vst1q_f32(y0i + q, vaddq_f32(t0i, t2i));
+            for (unsigned u = 0; u < 3; u++)
+            {
+                vst1q_f32(y0r + q + (u + 1) * s,
+                          vmlsq_f32(vmulq_f32(ur[u], wr[u]), ui[u], wi[u]));
+                vst1q_f32(y0i + q + (u + 1) * s,
+                          vmlaq_f32(vmulq_f32(ur[u], wi[u]), ui[u], wr[u]));
+            }
+        }
+    }
+}
+#endif
+
+static fft_butterfly_t fft_butterfly(unsigned radix, unsigned count,
+                                     unsigned stride)
+{
+#ifdef FFT_SSE
+    if (vlc_CPU_SSE())
+    {
+        if (radix == 4 && (stride % 4) == 0)
+            return fft_radix4_sse;
+        if (radix == 4 && stride == 1 && (count % 4) == 0)
+            return fft_radix4_first_sse;
+        if (radix == 2 && (stride % 4) == 0)
+            return fft_radix2_sse;
+    }
+#endif
+#ifdef FFT_NEON
+# ifdef __aarch64__
+    if (vlc_CPU_ARM64_NEON())
+# else
+    if (vlc_CPU_ARM_NEON())
+# endif
+    {
+        if (radix == 4 && (stride % 4) == 0)
+            return fft_radix4_neon;
+    }
+#endif
+    (void) count;
+
+    switch (radix)
+    {
+        case 2: return fft_radix2_c;
+        case 3: return fft_radix3_c;
+        case 4: return fft_radix4_c;
+        case 5: return fft_radix5_c;
+    }
+    vlc_assert_unreachable();
+}
+
+/*****************************************************************************
+ * Plans
+ *****************************************************************************/
+static struct fft_plan *fft_plan_Create(unsigned size)
+{
+    const unsigned n = size / 2;
+    unsigned radix[FFT_MAX_STAGES], stages = 0, rest = n;
+
+    /* Radix 4 first, so that most stages can be vectorized */
+    while ((rest % 4) == 0)
+        radix[stages++] = 4, rest /= 4;
+    if ((rest % 2) == 0)
+        radix[stages++] = 2, rest /= 2;
+    while ((rest % 3) == 0)
+        radix[stages++] = 3, rest /= 3;
+    while ((rest % 5) == 0)
+        radix[stages++] = 5, rest /= 5;
+    if (rest != 1)
+        return NULL; /* unsupported prime factor */
+
+    /* Twiddle factors: fewer than n per stage, and n / 2 + 1 to untangle */
+    size_t tables = 2 * ((size_t)stages * n + n / 2 + 1);
+    struct fft_plan *plan = malloc(sizeof (*plan) + tables * sizeof (float));
+    if (unlikely(plan == NULL))
+        return NULL;
+
+    plan->next = NULL;
+    plan->refs = 1;
+    plan->size = size;
+    plan->stages = stages;
+
+    float *table = plan->tables;
+    unsigned length = n, stride = 1;
+
+    for (unsigned i = 0; i < stages; i++)
+    {
+        struct fft_stage *st = &plan->stage[i];
+        const unsigned count = length / radix[i];
+        const unsigned twiddles = (radix[i] - 1) * count;
+
+        st->radix = radix[i];
+        st->count = count;
+        st->stride = stride;
+        st->butterfly = fft_butterfly(radix[i], count, stride);
+        st->tw_re = table;
+        st->tw_im = table + twiddles;
+
+        for (unsigned u = 1; u < radix[i]; u++)
+            for (unsigned p = 0; p < count; p++)
+            {
+                double phi = -2. * M_PI * p * u / length;
+
+                table[(u - 1) * count + p] = cos(phi);
+                table[twiddles + (u - 1) * count + p] = sin(phi);
+            }
+        table += 2 * twiddles;
+        length = count;
+        stride *= radix[i];
+    }
+
+    plan->post_re = table;
+    plan->post_im = table + n / 2 + 1;
+    for (unsigned k = 0; k <= n / 2; k++)
+    {
+        double phi = -2. * M_PI * k / size;
+
+        plan->post_re[k] = cos(phi);
+        plan->post_im[k] = sin(phi);
+    }
+    return plan;
+}
+
+static struct fft_plan *fft_plan_Get(unsigned size)
+{
+    struct fft_plan *plan;
+
+    vlc_mutex_lock(&plans.lock);
+    for (plan = plans.list; plan != NULL; plan = plan->next)
+        if (plan->size == size)
+        {
+            plan->refs++;
+            break;
+        }
+
+    if (plan == NULL)
+    {
+        plan = fft_plan_Create(size);
+        if (plan != NULL)
+        {
+            plan->next = plans.list;
+            plans.list = plan;
+        }
+    }
+    vlc_mutex_unlock(&plans.lock);
+    return plan;
+}
+
+static void fft_plan_Release(struct fft_plan *plan)
+{
+    vlc_mutex_lock(&plans.lock);
+    if (--plan->refs == 0)
+    {
+        struct fft_plan **pp = &plans.list;
+
+        while (*pp != plan)
+            pp = &(*pp)->next;
+        *pp = plan->next;
+        free(plan);
+    }
+    vlc_mutex_unlock(&plans.lock);
+}
+
+/*****************************************************************************
+ * Transforms
+ *****************************************************************************/
+vlc_fft_t *vlc_fft_New(unsigned size)
+{
+    if (size < 2 || (size % 2) != 0)
+        return NULL;
+
+    vlc_fft_t *fft = malloc(sizeof (*fft));
+    if (unlikely(fft == NULL))
+        return NULL;
+
+    fft->plan = fft_plan_Get(size);
+    if (fft->plan == NULL)
+    {
+        free(fft);
+        return NULL;
+    }
+
+    /* Keep each array aligned for the vector units */
+    fft->pitch = ((size / 2) + 3) & ~3;
+    fft->work = vlc_memalign(16, 4 * fft->pitch * sizeof (float));
+    if (unlikely(fft->work == NULL))
+    {
+        fft_plan_Release(fft->plan);
+        free(fft);
+        return NULL;
+    }
+    return fft;
+}
+
+void vlc_fft_Delete(vlc_fft_t *fft)
+{
+    vlc_free(fft->work);
+    fft_plan_Release(fft->plan);
+    free(fft);
+}
+
+/* Complex transform of the first pair of work arrays: returns the real
+ * parts, followed by the imaginary parts pitch samples later. */
+static const float *fft_Stages(vlc_fft_t *fft)
+{
+    const struct fft_plan *plan = fft->plan;
+    float *xr = fft->work, *xi = xr + fft->pitch;
+    float *yr = xi + fft->pitch, *yi = yr + fft->pitch;
+
+    for (unsigned i = 0; i < plan->stages; i++)
+    {
+        const struct fft_stage *st = &plan->stage[i];
+        float *tr = xr, *ti = xi;
+
+        st->butterfly(st, xr, xi, yr, yi);
+        xr = yr; xi = yi;
+        yr = tr; yi = ti;
+    }
+    return xr;
+}
+
+/* Complex transform of the even and odd samples */
+static const float *fft_Complex(vlc_fft_t *fft, const float *in)
+{
+    const unsigned n = fft->plan->size / 2;
+    float *xr = fft->work, *xi = xr + fft->pitch;
+
+    for (unsigned k = 0; k < n; k++)
+    {
+        xr[k] = in[2 * k];
+        xi[k] = in[2 * k + 1];
+    }
+    return fft_Stages(fft);
+}
+
+/* Untangles bins k and n - k of the real signal from the complex transform
+ * z of its even (real part) and odd (imaginary part) samples */
+#define FFT_UNTANGLE(plan, zr, zi, n, k, \
+                     xkr, xki, xmr, xmi) do { \
+    const float er = .5f * ((zr)[k] + (zr)[(n) - (k)]); \
+    const float ei = .5f * ((zi)[k] - (zi)[(n) - (k)]); \
+    const float or_ = .5f * ((zi)[k] + (zi)[(n) - (k)]); \
+    const float oi = -.5f * ((zr)[k] - (zr)[(n) - (k)]); \
+    const float wr = (plan)->post_re[k], wi = (plan)->post_im[k]; \
+    const float tr = wr * or_ - wi * oi, ti = wr * oi + wi * or_; \
+    xkr = er + tr; xki = ei + ti; \
+    xmr = er - tr; xmi = ti - ei; \
+} while (0)
+
+void vlc_fft_Forward(vlc_fft_t *fft, const float *in, float *re, float *im)
+{
+    const struct fft_plan *plan = fft->plan;
+    const unsigned n = plan->size / 2;
+    const float *zr = fft_Complex(fft, in), *zi = zr + fft->pitch;
+
+    re[0] = zr[0] + zi[0];
+    im[0] = 0.f;
+    re[n] = zr[0] - zi[0];
+    im[n] = 0.f;
+    for (unsigned k = 1; k <= n / 2; k++)
+        FFT_UNTANGLE(plan, zr, zi, n, k, re[k], im[k], re[n - k], im[n - k]);
+}
+
+void vlc_fft_Power(vlc_fft_t *fft, const float *in, float *power)
+{
+    const struct fft_plan *plan = fft->plan;
+    const unsigned n = plan->size / 2;
+    const float *zr = fft_Complex(fft, in), *zi = zr + fft->pitch;
+
+    power[0] = (zr[0] + zi[0]) * (zr[0] + zi[0]);
+    power[n] = (zr[0] - zi[0]) * (zr[0] - zi[0]);
+    for (unsigned k = 1; k <= n / 2; k++)
+    {
+        float xkr, xki, xmr, xmi;
+
+        FFT_UNTANGLE(plan, zr, zi, n, k, xkr, xki, xmr, xmi);
+        power[k] = xkr * xkr + xki * xki;
+        power[n - k] = xmr * xmr + xmi * xmi;
+    }
+}
+
+void vlc_fft_Inverse(vlc_fft_t *fft, const float *re, const float *im,
+                     float *out)
+{
+    const struct fft_plan *plan = fft->plan;
+    const unsigned n = plan->size / 2;
+    float *xr = fft->work, *xi = xr + fft->pitch;
+
+    /* Entangle the even (e) and odd (o) samples spectra back into z = e + i.o,
+     * conjugated so that the forward stages compute the inverse transform */
+    xr[0] = re[0] + re[n];
+    xi[0] = re[n] - re[0];
+    for (unsigned k = 1; k <= n / 2; k++)
+    {
+        const float er = re[k] + re[n - k], ei = im[k] - im[n - k];
+        const float dr = re[k] - re[n - k], di = im[k] + im[n - k];
+        const float wr = plan->post_re[k], wi = plan->post_im[k];
+        const float or_ = dr * wr + di * wi, oi = di * wr - dr * wi;
+
+        xr[k] = er - oi;
+        xi[k] = -(ei + or_);
+        xr[n - k] = er + oi;
+        xi[n - k] = ei - or_;
+    }
+
+    const float *zr = fft_Stages(fft), *zi = zr + fft->pitch;
+
+    for (unsigned k = 0; k < n; k++)
+    {
+        out[2 * k] = zr[k];
+        out[2 * k + 1] = -zi[k];
+    }
+}
@@ -62,8 +62,8 @@ static int AllocatePicture( picture_t *p_pic )
         i_bytes += p->i_pitch * p->i_lines;
     }
 
-    uint8_t *p_data = vlc_memalign( 16, i_bytes );
-    if( i_bytes > 0 && p_data == NULL )
+    uint8_t *p_data = picture_buffer_New( i_bytes );
+    if( p_data == NULL )
     {
         p_pic->i_planes = 0;
         return VLC_EGENERIC;
@@ -111,7 +111,9 @@ static void picture_DestroyFromResource( picture_t *p_picture )
  */
 static void picture_Destroy( picture_t *p_picture )
 {
-    vlc_free( p_picture->p[0].p_pixels );
+    picture_priv_t *priv = (picture_priv_t *)p_picture;
+
+    picture_buffer_Delete( priv->gc.opaque );
     free( p_picture );
 }
 
@@ -259,6 +261,8 @@ picture_t *picture_NewFromResource( const video_format_t *p_fmt, const picture_r
             return NULL;
         }
         priv->gc.destroy = picture_Destroy;
+        /* Planes may be altered later on, so remember the buffer */
+        priv->gc.opaque = p_picture->p[0].p_pixels;
     }
 
     return p_picture;
@@ -31,3 +31,20 @@ typedef struct
         void *opaque;
     } gc;
 } picture_priv_t;
+
+/**
+ * Allocates a pixel buffer of (at least) the given size, aligned on 64 bytes,
+ * reusing a recently freed one if possible.
+ */
+void *picture_buffer_New(size_t);
+
+/**
+ * Frees a buffer allocated by picture_buffer_New(), keeping it around for
+ * a while so that it can be reused.
+ */
+void picture_buffer_Delete(void *);
+
+/**
+ * Frees all the buffers kept by the recycler.
+ */
+void picture_buffer_Flush(void);
@@ -34,6 +34,206 @@
 #include <vlc_atomic.h>
 #include "picture.h"
 
+/*
+ * Picture buffers recycler
+ *
+ * Pictures allocated from the heap draw their pixel buffer from here, and
+ * return it when they are destroyed. Recently freed buffers are kept in lists
+ * per size class (four classes per power of two), so that re-creating pools
+ * (e.g. on a vout or filter chain reconfiguration, or when an adaptive stream
+ * switches back and forth between resolutions) does not hit the heap again.
+ *
+ * Cached buffers are evicted, oldest first, beyond RECYCLER_MAX_BYTES or after
+ * RECYCLER_MAX_AGE without being reused. As eviction only happens when the
+ * recycler is used, everything is freed when the last picture pool is
+ * destroyed, and when a LibVLC instance is cleaned up.
+ */
+#define RECYCLER_MIN_SIZE  (64 << 10) /* smaller buffers are not worth it */
+#define RECYCLER_MAX_BYTES (128 << 20)
+#define RECYCLER_MAX_AGE   (10 * CLOCK_FREQ)
+#define RECYCLER_CLASSES   (4 * CHAR_BIT * sizeof (size_t))
+#define RECYCLER_HEADER    64 /* also the alignment of the pixels */
+
+struct picture_buffer {
+    size_t size; /* usable bytes after the header */
+    mtime_t date;
+    struct picture_buffer *prev, *next; /* within the size class */
+    struct picture_buffer *older, *newer; /* within all cached buffers */
+};
+
+static_assert(sizeof (struct picture_buffer) <= RECYCLER_HEADER,
+              "Picture buffer header too large");
+
+static struct {
+    vlc_mutex_t lock;
+    struct picture_buffer *classes[RECYCLER_CLASSES];
+    struct picture_buffer *newest, *oldest;
+    picture_buffer_stats_t stats;
+    unsigned pools; /* live picture pools */
+} recycler = { .lock = VLC_STATIC_MUTEX };
+
+static unsigned picture_buffer_Class(size_t size)
+{
+    unsigned msb = 0;
+
+    assert(size >= RECYCLER_MIN_SIZE);
+    while (size >> (msb + 1))
+        msb++;
+    return 4 * msb + ((size >> (msb - 2)) & 3);
+}
+
+static void picture_buffer_Unlink(struct picture_buffer *buf)
+{
+    if (buf->prev != NULL)
+        buf->prev->next = buf->next;
+    else
+        recycler.classes[picture_buffer_Class(buf->size)] = buf->next;
+    if (buf->next != NULL)
+        buf->next->prev = buf->prev;
+
+    if (buf->older != NULL)
+        buf->older->newer = buf->newer;
+    else
+        recycler.oldest = buf->newer;
+    if (buf->newer != NULL)
+        buf->newer->older = buf->older;
+    else
+        recycler.newest = buf->older;
+
+    recycler.stats.cached_bytes -= buf->size;
+    recycler.stats.cached_count--;
+}
+
+static void picture_buffer_Evict(mtime_t now, size_t room)
+{
+    struct picture_buffer *buf;
+
+    while ((buf = recycler.oldest) != NULL
+        && (now - buf->date > RECYCLER_MAX_AGE
+         || recycler.stats.cached_bytes + room > RECYCLER_MAX_BYTES))
+    {
+        picture_buffer_Unlink(buf);
+        recycler.stats.evicted++;
+        vlc_free(buf);
+    }
+}
+
+void *picture_buffer_New(size_t size)
+{
+    struct picture_buffer *buf = NULL;
+
+    if (unlikely(size > SIZE_MAX - RECYCLER_HEADER))
+        return NULL;
+
+    if (size >= RECYCLER_MIN_SIZE) {
+        unsigned c = picture_buffer_Class(size);
+
+        vlc_mutex_lock(&recycler.lock);
+        picture_buffer_Evict(mdate(), 0);
+
+        for (buf = recycler.classes[c]; buf != NULL; buf = buf->next)
+            if (buf->size >= size)
+                break;
+        /* Any buffer from the next class is large enough */
+        if (buf == NULL && c + 1 < RECYCLER_CLASSES)
+            buf = recycler.classes[c + 1];
+
+        if (buf != NULL) {
+            picture_buffer_Unlink(buf);
+            recycler.stats.reused++;
+        } else
+            recycler.stats.allocated++;
+        vlc_mutex_unlock(&recycler.lock);
+    }
+
+    if (buf == NULL) {
+        buf = vlc_memalign(RECYCLER_HEADER, RECYCLER_HEADER + size);
+        if (unlikely(buf == NULL))
+            return NULL;
+        buf->size = size;
+    }
+    return ((unsigned char *)buf) + RECYCLER_HEADER;
+}
+
+void picture_buffer_Delete(void *data)
+{
+    struct picture_buffer *buf =
+        (void *)(((unsigned char *)data) - RECYCLER_HEADER);
+
+    if (buf->size < RECYCLER_MIN_SIZE || buf->size > RECYCLER_MAX_BYTES) {
+        vlc_free(buf);
+        return;
+    }
+
+    unsigned c = picture_buffer_Class(buf->size);
+
+    vlc_mutex_lock(&recycler.lock);
+    buf->date = mdate();
+    picture_buffer_Evict(buf->date, buf->size);
+
+    buf->prev = NULL;
+    buf->next = recycler.classes[c];
+    if (buf->next != NULL)
+        buf->next->prev = buf;
+    recycler.classes[c] = buf;
+
+    buf->older = recycler.newest;
+    buf->newer = NULL;
+    if (buf->older != NULL)
+        buf->older->newer = buf;
+    else
+        recycler.oldest = buf;
+    recycler.newest = buf;
+
+    recycler.stats.recycled++;
+    recycler.stats.cached_bytes += buf->size;
+    recycler.stats.cached_count++;
+    vlc_mutex_unlock(&recycler.lock);
+}
+
+static void picture_buffer_FlushLocked(void)
+{
+    struct picture_buffer *buf;
+
+    while ((buf = recycler.oldest) != NULL) {
+        picture_buffer_Unlink(buf);
+        recycler.stats.evicted++;
+        vlc_free(buf);
+    }
+}
+
+void picture_buffer_Flush(void)
+{
+    vlc_mutex_lock(&recycler.lock);
+    picture_buffer_FlushLocked();
+    vlc_mutex_unlock(&recycler.lock);
+}
+
+/** Accounts for a picture pool, flushing the recycler after the last one */
+static void picture_buffer_PoolRef(bool add)
+{
+    vlc_mutex_lock(&recycler.lock);
+    if (add)
+        recycler.pools++;
+    else if (--recycler.pools == 0)
+        picture_buffer_FlushLocked();
+    vlc_mutex_unlock(&recycler.lock);
+}
+
+void picture_buffer_GetStats(picture_buffer_stats_t *stats)
+{
+    vlc_mutex_lock(&recycler.lock);
+    *stats = recycler.stats;
+    vlc_mutex_unlock(&recycler.lock);
+}
+
+/*
+ * Picture pools
+ *
+ * Free pictures are tracked by an atomic bitmap, so that picture_pool_Get()
+ * and returning a picture to the pool do not lock. The mutex only serializes
+ * picture_pool_Wait() with the wake ups, and only if a thread is waiting.
+ */
 static const uintptr_t pool_max = CHAR_BIT * sizeof (unsigned long long);
 
 struct picture_pool_t {
@@ -42,8 +242,9 @@ struct picture_pool_t {
     vlc_mutex_t lock;
     vlc_cond_t  wait;
 
-    bool               canceled;
-    unsigned long long available;
+    atomic_bool        canceled;
+    atomic_ullong      available;
+    atomic_uint        waiters;
     atomic_ushort      refs;
     unsigned short     picture_count;
     picture_t  *picture[];
@@ -57,6 +258,7 @@ static void picture_pool_Destroy(picture_pool_t *pool)
     vlc_cond_destroy(&pool->wait);
     vlc_mutex_destroy(&pool->lock);
     vlc_free(pool);
+    picture_buffer_PoolRef(false);
 }
 
 void picture_pool_Release(picture_pool_t *pool)
@@ -66,6 +268,38 @@ void picture_pool_Release(picture_pool_t *pool)
     picture_pool_Destroy(pool);
 }
 
+/** Marks a picture as free, and wakes up a waiting thread if any */
+static void picture_pool_Put(picture_pool_t *pool, unsigned offset)
+{
+    unsigned long long bit = 1ULL << offset;
+    unsigned long long prev = atomic_fetch_or(&pool->available, bit);
+
+    assert(!(prev & bit));
+    (void) prev;
+
+    if (atomic_load(&pool->waiters) > 0) {
+        vlc_mutex_lock(&pool->lock);
+        vlc_cond_signal(&pool->wait);
+        vlc_mutex_unlock(&pool->lock);
+    }
+}
+
+/** Marks the first free picture among mask as used */
+static int picture_pool_Take(picture_pool_t *pool, unsigned long long mask)
+{
+    unsigned long long avail = atomic_load(&pool->available);
+
+    while (avail & mask) {
+        unsigned i = ffsll(avail & mask) - 1;
+        unsigned long long bit = 1ULL << i;
+
+        avail = atomic_fetch_and(&pool->available, ~bit);
+        if (avail & bit)
+            return i;
+    }
+    return -1;
+}
+
 static void picture_pool_ReleasePicture(picture_t *clone)
 {
     picture_priv_t *priv = (picture_priv_t *)clone;
@@ -80,12 +314,7 @@ static void picture_pool_ReleasePicture(picture_t *clone)
         pool->pic_unlock(picture);
     picture_Release(picture);
 
-    vlc_mutex_lock(&pool->lock);
-    assert(!(pool->available & (1ULL << offset)));
-    pool->available |= 1ULL << offset;
-    vlc_cond_signal(&pool->wait);
-    vlc_mutex_unlock(&pool->lock);
-
+    picture_pool_Put(pool, offset);
     picture_pool_Destroy(pool);
 }
 
@@ -127,12 +356,14 @@ picture_pool_t *picture_pool_NewExtended(const picture_pool_configuration_t *cfg
     pool->pic_unlock = cfg->unlock;
     vlc_mutex_init(&pool->lock);
     vlc_cond_init(&pool->wait);
-    pool->available = (1ULL << cfg->picture_count) - 1;
+    atomic_init(&pool->available, (1ULL << cfg->picture_count) - 1);
+    atomic_init(&pool->waiters, 0);
     atomic_init(&pool->refs,  1);
     pool->picture_count = cfg->picture_count;
     memcpy(pool->picture, cfg->picture,
            cfg->picture_count * sizeof (picture_t *));
-    pool->canceled = false;
+    atomic_init(&pool->canceled, false);
+    picture_buffer_PoolRef(true);
     return pool;
 }
 
@@ -193,113 +424,94 @@ error:
     return NULL;
 }
 
-/** Find next (bit) set */
-static int fnsll(unsigned long long x, unsigned i)
+static picture_t *picture_pool_Clone(picture_pool_t *pool, unsigned offset)
 {
-    if (i >= CHAR_BIT * sizeof (x))
-        return 0;
-    return ffsll(x & ~((1ULL << i) - 1));
+    picture_t *clone = picture_pool_ClonePicture(pool, offset);
+    if (clone != NULL) {
+        assert(clone->p_next == NULL);
+        atomic_fetch_add(&pool->refs, 1);
+    }
+    return clone;
 }
 
 picture_t *picture_pool_Get(picture_pool_t *pool)
 {
-    vlc_mutex_lock(&pool->lock);
-    assert(pool->refs > 0);
+    unsigned long long mask = ~0ULL;
+    int i;
 
-    if (pool->canceled)
-    {
-        vlc_mutex_unlock(&pool->lock);
+    assert(atomic_load(&pool->refs) > 0);
+
+    if (atomic_load(&pool->canceled))
         return NULL;
-    }
 
-    for (unsigned i = ffsll(pool->available); i; i = fnsll(pool->available, i))
+    while ((i = picture_pool_Take(pool, mask)) >= 0)
     {
-        pool->available &= ~(1ULL << (i - 1));
-        vlc_mutex_unlock(&pool->lock);
-
-        picture_t *picture = pool->picture[i - 1];
+        picture_t *picture = pool->picture[i];
 
         if (pool->pic_lock != NULL && pool->pic_lock(picture) != VLC_SUCCESS) {
-            vlc_mutex_lock(&pool->lock);
-            pool->available |= 1ULL << (i - 1);
+            picture_pool_Put(pool, i);
+            mask &= ~(1ULL << i);
             continue;
         }
-
-        picture_t *clone = picture_pool_ClonePicture(pool, i - 1);
-        if (clone != NULL) {
-            assert(clone->p_next == NULL);
-            atomic_fetch_add(&pool->refs, 1);
-        }
-        return clone;
+        return picture_pool_Clone(pool, i);
     }
-
-    vlc_mutex_unlock(&pool->lock);
     return NULL;
 }
 
 picture_t *picture_pool_Wait(picture_pool_t *pool)
 {
-    unsigned i;
+    int i;
 
-    vlc_mutex_lock(&pool->lock);
-    assert(pool->refs > 0);
+    assert(atomic_load(&pool->refs) > 0);
 
-    while (pool->available == 0)
+    i = picture_pool_Take(pool, ~0ULL);
+    if (i < 0)
     {
-        if (pool->canceled)
-        {
-            vlc_mutex_unlock(&pool->lock);
+        vlc_mutex_lock(&pool->lock);
+        atomic_fetch_add(&pool->waiters, 1);
+        /* Rechecks once registered, so that a concurrent picture_pool_Put()
+         * either is seen here or signals the condition. */
+        while (!atomic_load(&pool->canceled)
+            && (i = picture_pool_Take(pool, ~0ULL)) < 0)
+            vlc_cond_wait(&pool->wait, &pool->lock);
+        atomic_fetch_sub(&pool->waiters, 1);
+        vlc_mutex_unlock(&pool->lock);
+
+        if (i < 0)
             return NULL;
-        }
-        vlc_cond_wait(&pool->wait, &pool->lock);
     }
 
-    i = ffsll(pool->available);
-    assert(i > 0);
-    pool->available &= ~(1ULL << (i - 1));
-    vlc_mutex_unlock(&pool->lock);
-
-    picture_t *picture = pool->picture[i - 1];
+    picture_t *picture = pool->picture[i];
 
     if (pool->pic_lock != NULL && pool->pic_lock(picture) != VLC_SUCCESS) {
-        vlc_mutex_lock(&pool->lock);
-        pool->available |= 1ULL << (i - 1);
-        vlc_cond_signal(&pool->wait);
-        vlc_mutex_unlock(&pool->lock);
+        picture_pool_Put(pool, i);
         return NULL;
     }
-
-    picture_t *clone = picture_pool_ClonePicture(pool, i - 1);
-    if (clone != NULL) {
-        assert(clone->p_next == NULL);
-        atomic_fetch_add(&pool->refs, 1);
-    }
-    return clone;
+    return picture_pool_Clone(pool, i);
 }
 
 void picture_pool_Cancel(picture_pool_t *pool, bool canceled)
 {
-    vlc_mutex_lock(&pool->lock);
-    assert(pool->refs > 0);
+    assert(atomic_load(&pool->refs) > 0);
 
-    pool->canceled = canceled;
-    if (canceled)
+    atomic_store(&pool->canceled, canceled);
+    if (canceled) {
+        vlc_mutex_lock(&pool->lock);
         vlc_cond_broadcast(&pool->wait);
-    vlc_mutex_unlock(&pool->lock);
+        vlc_mutex_unlock(&pool->lock);
+    }
 }
 
 unsigned picture_pool_Reset(picture_pool_t *pool)
 {
-    unsigned ret;
+    unsigned long long avail;
 
-    vlc_mutex_lock(&pool->lock);
-    assert(pool->refs > 0);
-    ret = pool->picture_count - popcountll(pool->available);
-    pool->available = (1ULL << pool->picture_count) - 1;
-    pool->canceled = false;
-    vlc_mutex_unlock(&pool->lock);
+    assert(atomic_load(&pool->refs) > 0);
+    avail = atomic_exchange(&pool->available,
+                            (1ULL << pool->picture_count) - 1);
+    atomic_store(&pool->canceled, false);
 
-    return ret;
+    return pool->picture_count - popcountll(avail);
 }
 
 unsigned picture_pool_GetSize(const picture_pool_t *pool)
@@ -232,6 +232,22 @@ void sout_InputFlush( sout_packetizer_input_t *p_input )
     vlc_mutex_unlock( &p_sout->lock );
 }
 
+/**
+ * Gets the transcoding counters of the stream output chain
+ * \return VLC_SUCCESS if a stream transcodes, else the counters are unchanged
+ */
+int sout_GetStats( sout_instance_t *p_sout, input_stage_stats_t *p_decode,
+                   input_stage_stats_t *p_filter, input_stage_stats_t *p_encode )
+{
+    int i_ret;
+
+    vlc_mutex_lock( &p_sout->lock );
+    i_ret = sout_StreamControl( p_sout->p_stream, SOUT_STREAM_GET_STATS,
+                                p_decode, p_filter, p_encode );
+    vlc_mutex_unlock( &p_sout->lock );
+    return i_ret;
+}
+
 /*****************************************************************************
  *
  *****************************************************************************/
@@ -29,6 +29,7 @@
 
 # include <vlc_sout.h>
 # include <vlc_network.h>
+# include <vlc_input_item.h>
 
 /****************************************************************************
  * sout_packetizer_input_t: p_sout <-> p_packetizer
@@ -51,5 +52,7 @@ int sout_InputDelete( sout_packetizer_input_t * );
 int sout_InputSendBuffer( sout_packetizer_input_t *, block_t* );
 bool sout_InputIsEmpty(sout_packetizer_input_t *);
 void sout_InputFlush( sout_packetizer_input_t * );
+int sout_GetStats( sout_instance_t *, input_stage_stats_t *,
+                   input_stage_stats_t *, input_stage_stats_t * );
 
 #endif
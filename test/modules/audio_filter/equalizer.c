@@ -0,0 +1,212 @@
+/*****************************************************************************
+ * equalizer.c: equalizer filter bank test
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+#include <stdio.h>
+
+#include "fixture.h"
+
+#include "../modules/audio_filter/equalizer_bank.h"
+
+#define RATE     48000
+#define CHANNELS 8
+#define SAMPLES  (RATE / 10)
+
+static void bank_init( eqz_bank_t *p_bank, eqz_state_t *p_state,
+                       eqz_state_t *p_state2 )
+{
+    /* Mix of boosted and cut bands, as in the presets */
+    static const float f_gains[EQZ_BANDS_MAX] =
+        { 12.f, 8.f, 4.f, -2.f, -6.f, 0.f, 3.f, 9.f, -12.f, 6.f };
+    eqz_config_t cfg;
+
+    EqzCoeffs( RATE, 1.0f, true, &cfg );
+    memset( p_bank, 0, sizeof(*p_bank) );
+    p_bank->i_band = cfg.i_band;
+    for( int i = 0; i < cfg.i_band; i++ )
+    {
+        p_bank->f_alpha[i] = cfg.band[i].f_alpha;
+        p_bank->f_beta[i]  = cfg.band[i].f_beta;
+        p_bank->f_gamma[i] = cfg.band[i].f_gamma;
+        p_bank->f_amp[i]   = EQZ_IN_FACTOR *
+                             ( powf( 10.f, f_gains[i] / 20.f ) - 1.f );
+    }
+    memset( p_state, 0, CHANNELS * sizeof(*p_state) );
+    memset( p_state2, 0, CHANNELS * sizeof(*p_state2) );
+}
+
+/* Output/input power ratio of a sine at the given frequency, in dB */
+static float response( eqz_filter_t pf_filter, float f_freq, bool b_2eqz )
+{
+    eqz_bank_t bank;
+    eqz_state_t state[CHANNELS], state2[CHANNELS];
+    float *p_buf = malloc( SAMPLES * sizeof(float) );
+    double in = 0., out = 0.;
+
+    assert( p_buf != NULL );
+    bank_init( &bank, state, state2 );
+
+    for( int i = 0; i < SAMPLES; i++ )
+    {
+        p_buf[i] = 0.5f * sinf( 2.f * (float)M_PI * f_freq * i / RATE );
+        if( i >= SAMPLES / 2 )
+            in += p_buf[i] * p_buf[i];
+    }
+    pf_filter( &bank, state, state2, p_buf, p_buf, SAMPLES, 1, 1.f, b_2eqz );
+    /* Ignore the transient */
+    for( int i = SAMPLES / 2; i < SAMPLES; i++ )
+        out += p_buf[i] * p_buf[i];
+
+    free( p_buf );
+    return 10.f * log10f( out / in );
+}
+
+/* Output of the equalizer before it was vectorized, for the noise above
+ * and a preamp of 0.8. The narrow low frequency bands amplify rounding
+ * differences over time, hence the tolerance of -80 dB. */
+static const struct
+{
+    int i_sample;
+    int i_channel;
+    float f_value[2]; /* one pass, two passes */
+} ref_outputs[] = {
+    {    0, 0, {  1.644582003e-01f,  5.904628709e-02f } },
+    {    1, 1, { -1.752977371e-01f, -6.233475730e-02f } },
+    {    2, 2, { -1.696413755e-01f, -7.012487948e-02f } },
+    {    3, 3, { -2.273563445e-01f, -1.047812551e-01f } },
+    {    7, 4, { -1.177075729e-01f, -2.126986161e-02f } },
+    {   31, 5, {  6.891798973e-02f,  1.823233254e-02f } },
+    {  127, 6, {  1.226580143e-01f,  4.312529042e-02f } },
+    {  511, 7, {  1.104144827e-01f,  3.128624335e-02f } },
+    { 1023, 0, { -1.284565181e-01f, -5.771050230e-02f } },
+    { 2047, 1, { -2.186471783e-02f,  2.344330959e-02f } },
+    { 3001, 2, { -8.083829656e-03f, -1.974255778e-02f } },
+    { 4799, 3, { -1.015607119e-01f, -4.426878318e-02f } },
+};
+
+static void test_reference( eqz_filter_t pf_filter, bool b_2eqz )
+{
+    eqz_bank_t bank;
+    eqz_state_t state[CHANNELS], state2[CHANNELS];
+    float *p_buf = fixture_noise_new( SAMPLES * CHANNELS, .5f );
+
+    bank_init( &bank, state, state2 );
+    pf_filter( &bank, state, state2, p_buf, p_buf,
+               SAMPLES, CHANNELS, 0.8f, b_2eqz );
+
+    for( size_t i = 0; i < ARRAY_SIZE(ref_outputs); i++ )
+    {
+        float f_ref = ref_outputs[i].f_value[b_2eqz];
+        float f_out = p_buf[ref_outputs[i].i_sample * CHANNELS
+                            + ref_outputs[i].i_channel];
+
+        assert( fabsf( f_out - f_ref ) < 1e-4f );
+    }
+    free( p_buf );
+}
+
+static void test_equivalence( eqz_filter_t pf_filter, bool b_2eqz )
+{
+    eqz_bank_t bank;
+    eqz_state_t state[CHANNELS], state2[CHANNELS];
+    eqz_state_t ref_state[CHANNELS], ref_state2[CHANNELS];
+    float *p_ref = fixture_noise_new( SAMPLES * CHANNELS, .5f );
+    float *p_buf = fixture_noise_new( SAMPLES * CHANNELS, .5f );
+    float f_max = 0.f;
+
+    bank_init( &bank, ref_state, ref_state2 );
+    EqzFilterC( &bank, ref_state, ref_state2, p_ref, p_ref,
+                SAMPLES, CHANNELS, 0.8f, b_2eqz );
+    bank_init( &bank, state, state2 );
+    pf_filter( &bank, state, state2, p_buf, p_buf,
+               SAMPLES, CHANNELS, 0.8f, b_2eqz );
+
+    /* Only the summing order of the bands differs */
+    for( int i = 0; i < SAMPLES * CHANNELS; i++ )
+        f_max = __MAX( f_max, fabsf( p_buf[i] - p_ref[i] ) );
+    printf( "%s pass: max difference %g\n", b_2eqz ? "two" : "one", f_max );
+    assert( f_max < 1e-5f );
+
+    free( p_ref );
+    free( p_buf );
+
+    const float *f_freqs = f_vlc_frequency_table_10b;
+    for( int i = 0; i < EQZ_BANDS_MAX; i++ )
+    {
+        float f_ref = response( EqzFilterC, f_freqs[i], b_2eqz );
+        float f_db = response( pf_filter, f_freqs[i], b_2eqz );
+
+        printf( "  %5.0f Hz: %+7.3f dB (reference %+7.3f dB)\n",
+                f_freqs[i], f_db, f_ref );
+        assert( fabsf( f_db - f_ref ) < 0.001f );
+    }
+}
+
+#ifdef BENCHMARK
+static double benchmark( eqz_filter_t pf_filter, bool b_2eqz )
+{
+    eqz_bank_t bank;
+    eqz_state_t state[CHANNELS], state2[CHANNELS];
+    float *p_buf = fixture_noise_new( SAMPLES * CHANNELS, .5f );
+    const int i_loops = 50;
+
+    bank_init( &bank, state, state2 );
+
+    mtime_t i_start = mdate();
+    for( int i = 0; i < i_loops; i++ )
+        pf_filter( &bank, state, state2, p_buf, p_buf,
+                   SAMPLES, CHANNELS, 0.1f, b_2eqz );
+    mtime_t i_time = mdate() - i_start;
+
+    free( p_buf );
+    return fixture_realtime( i_loops * SAMPLES, RATE, i_time );
+}
+#endif
+
+int main( void )
+{
+    eqz_filter_t pf_filter = EqzFilterSelect();
+
+    if( pf_filter == EqzFilterC )
+        printf( "no SIMD version for this CPU, checking C only\n" );
+
+    test_reference( EqzFilterC, false );
+    test_reference( EqzFilterC, true );
+    test_reference( pf_filter, false );
+    test_reference( pf_filter, true );
+
+    test_equivalence( pf_filter, false );
+    test_equivalence( pf_filter, true );
+
+#ifdef BENCHMARK
+    for( int i = 0; i < 2; i++ )
+    {
+        double f_c = benchmark( EqzFilterC, i );
+        double f_simd = benchmark( pf_filter, i );
+
+        printf( "%d channels, %s pass: C %.0fx real-time, selected %.0fx "
+                "real-time (%.2fx)\n", CHANNELS, i ? "two" : "one",
+                f_c, f_simd, f_simd / f_c );
+    }
+#endif
+    return 0;
+}
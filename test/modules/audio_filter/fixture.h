@@ -0,0 +1,146 @@
+/*****************************************************************************
+ * fixture.h: audio filter tests helpers
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_TEST_AUDIO_FILTER_FIXTURE_H
+#define VLC_TEST_AUDIO_FILTER_FIXTURE_H
+
+/* The tests are built with -DBENCHMARK into programs which also time the
+ * code, and which make check does not run. */
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <vlc/vlc.h>
+
+#include "../../../lib/libvlc_internal.h"
+
+#include <vlc_common.h>
+#include <vlc_modules.h>
+#include <vlc_aout.h>
+#include <vlc_filter.h>
+#include <vlc_block.h>
+
+#undef NDEBUG
+#include <assert.h>
+
+/**
+ * Starts libvlc with the plugins of the build tree, and aborts the test
+ * after the given number of seconds.
+ */
+static inline libvlc_instance_t *fixture_libvlc_new( int i_argc,
+                                                     const char *const *argv,
+                                                     unsigned i_timeout )
+{
+    setenv( "VLC_PLUGIN_PATH", "../modules", 1 );
+    alarm( i_timeout );
+
+    libvlc_instance_t *p_libvlc = libvlc_new( i_argc, argv );
+    assert( p_libvlc != NULL );
+    return p_libvlc;
+}
+
+/** Next value of the pseudo-random generator of all the test signals */
+static inline uint32_t fixture_rand( uint32_t *p_seed )
+{
+    *p_seed = *p_seed * 1664525 + 1013904223;
+    return *p_seed;
+}
+
+/** White noise in [-f_amplitude, f_amplitude), the same on every run */
+static inline float *fixture_noise_new( size_t i_count, float f_amplitude )
+{
+    float *p_buf = malloc( i_count * sizeof(float) );
+    uint32_t seed = 0x12345678;
+
+    assert( p_buf != NULL );
+    for( size_t i = 0; i < i_count; i++ )
+        p_buf[i] = (float)(int32_t)fixture_rand( &seed ) / 2147483648.f
+                 * f_amplitude;
+    return p_buf;
+}
+
+static inline void fixture_fmt_init( audio_sample_format_t *p_fmt,
+                                     unsigned i_rate, uint32_t i_channels )
+{
+    memset( p_fmt, 0, sizeof(*p_fmt) );
+    p_fmt->i_format = VLC_CODEC_FL32;
+    p_fmt->i_rate = i_rate;
+    p_fmt->i_physical_channels =
+    p_fmt->i_original_channels = i_channels;
+    aout_FormatPrepare( p_fmt );
+}
+
+/**
+ * Creates a filter object, which fixture_filter_load() loads once the
+ * variables of the module are set.
+ */
+static inline filter_t *fixture_filter_new( vlc_object_t *p_parent,
+                                            const audio_sample_format_t *p_in,
+                                            const audio_sample_format_t *p_out )
+{
+    filter_t *p_filter = vlc_object_create( p_parent, sizeof(*p_filter) );
+    assert( p_filter != NULL );
+
+    es_format_Init( &p_filter->fmt_in, AUDIO_ES, p_in->i_format );
+    p_filter->fmt_in.audio = *p_in;
+    es_format_Init( &p_filter->fmt_out, AUDIO_ES, p_out->i_format );
+    p_filter->fmt_out.audio = *p_out;
+    return p_filter;
+}
+
+/** \return false if the module is not available */
+static inline bool fixture_filter_load( filter_t *p_filter,
+                                        const char *psz_capability,
+                                        const char *psz_module )
+{
+    p_filter->p_module = module_need( p_filter, psz_capability,
+                                      psz_module, true );
+    return p_filter->p_module != NULL;
+}
+
+static inline void fixture_filter_delete( filter_t *p_filter )
+{
+    if( p_filter->p_module != NULL )
+        module_unneed( p_filter, p_filter->p_module );
+    vlc_object_release( p_filter );
+}
+
+/**
+ * Filters one block, adding the time spent to *pi_time unless it is NULL.
+ */
+static inline block_t *fixture_filter_play( filter_t *p_filter,
+                                            block_t *p_block,
+                                            mtime_t *pi_time )
+{
+    mtime_t i_start = mdate();
+
+    p_block = p_filter->pf_audio_filter( p_filter, p_block );
+    if( pi_time != NULL )
+        *pi_time += mdate() - i_start;
+    return p_block;
+}
+
+/** How many times faster than real time the given frames were processed */
+static inline double fixture_realtime( uint64_t i_frames, unsigned i_rate,
+                                       mtime_t i_time )
+{
+    return (double)i_frames * CLOCK_FREQ / i_rate / __MAX( i_time, 1 );
+}
+
+#endif
@@ -0,0 +1,279 @@
+/*****************************************************************************
+ * headphone.c: headphone virtualization test
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+#include <math.h>
+
+#include "fixture.h"
+
+#include <vlc_fs.h>
+
+#define RATE    48000
+#define BLOCK   1000    /* not a multiple of the partition size */
+#define LATENCY 256     /* frames */
+#define POSITIONS 9
+
+/* File order of the speakers, and input order of the channels */
+static const uint32_t positions[POSITIONS] = {
+    AOUT_CHAN_LEFT, AOUT_CHAN_RIGHT, AOUT_CHAN_MIDDLELEFT,
+    AOUT_CHAN_MIDDLERIGHT, AOUT_CHAN_REARLEFT, AOUT_CHAN_REARRIGHT,
+    AOUT_CHAN_REARCENTER, AOUT_CHAN_CENTER, AOUT_CHAN_LFE,
+};
+/* Weights of the physical model, applied to the measured responses */
+static const float weights[POSITIONS] =
+    { 2.0, 2.0, 1.5, 1.5, 1.5, 1.5, 1.5, 1.5, 5.0 };
+
+static filter_t *headphone_new( vlc_object_t *obj, uint32_t i_channels,
+                                bool b_convolution, const char *psz_hrir )
+{
+    audio_sample_format_t in, out;
+
+    fixture_fmt_init( &in, RATE, i_channels );
+    fixture_fmt_init( &out, RATE, AOUT_CHANS_STEREO );
+
+    filter_t *p_filter = fixture_filter_new( obj, &in, &out );
+    var_Create( p_filter, "headphone-convolution", VLC_VAR_BOOL );
+    var_SetBool( p_filter, "headphone-convolution", b_convolution );
+    var_Create( p_filter, "headphone-hrir", VLC_VAR_STRING );
+    var_SetString( p_filter, "headphone-hrir", psz_hrir ? psz_hrir : "" );
+
+    bool b_loaded = fixture_filter_load( p_filter, "audio filter",
+                                         "headphone" );
+    assert( b_loaded );
+    return p_filter;
+}
+
+/* Filters interleaved input, block by block, into a stereo output */
+static float *headphone_run( filter_t *p_filter, const float *p_in,
+                             size_t i_frames, mtime_t *pi_time )
+{
+    const unsigned i_in_nb = aout_FormatNbChannels( &p_filter->fmt_in.audio );
+    float *p_out = malloc( i_frames * 2 * sizeof(float) );
+
+    assert( p_out != NULL );
+    if( pi_time != NULL )
+        *pi_time = 0;
+    for( size_t i_done = 0; i_done < i_frames; i_done += BLOCK )
+    {
+        size_t i_count = __MIN( BLOCK, i_frames - i_done );
+        block_t *p_block = block_Alloc( i_count * i_in_nb * sizeof(float) );
+        assert( p_block != NULL );
+
+        memcpy( p_block->p_buffer, &p_in[i_done * i_in_nb],
+                p_block->i_buffer );
+        p_block->i_nb_samples = i_count;
+        p_block->i_pts = VLC_TS_0 + i_done * CLOCK_FREQ / RATE;
+
+        p_block = fixture_filter_play( p_filter, p_block, pi_time );
+
+        assert( p_block != NULL && p_block->i_nb_samples == i_count );
+        memcpy( &p_out[i_done * 2], p_block->p_buffer, p_block->i_buffer );
+        block_Release( p_block );
+    }
+    return p_out;
+}
+
+/* The convolution with the responses of the physical model gives the same
+ * output as the delay lines, one partition later */
+static void test_model( vlc_object_t *obj, uint32_t i_channels )
+{
+    const size_t i_frames = RATE / 2;
+    const unsigned i_nb = popcount( i_channels );
+    float *p_in = fixture_noise_new( i_frames * i_nb, .5f );
+
+    filter_t *p_filter = headphone_new( obj, i_channels, false, NULL );
+    float *p_ref = headphone_run( p_filter, p_in, i_frames, NULL );
+    fixture_filter_delete( p_filter );
+
+    p_filter = headphone_new( obj, i_channels, true, NULL );
+    float *p_out = headphone_run( p_filter, p_in, i_frames, NULL );
+    fixture_filter_delete( p_filter );
+
+    float f_max = 0.f;
+    for( size_t i = 0; i < LATENCY * 2; i++ )
+        f_max = __MAX( f_max, fabsf( p_out[i] ) );
+    for( size_t i = LATENCY * 2; i < i_frames * 2; i++ )
+        f_max = __MAX( f_max, fabsf( p_out[i] - p_ref[i - LATENCY * 2] ) );
+
+    printf( "%u channels model: max difference %g\n", i_nb, f_max );
+    assert( f_max < 1e-5f );
+
+    free( p_ref );
+    free( p_out );
+    free( p_in );
+}
+
+/* Writes the responses of all the positions as a 32-bits float WAV */
+static void hrir_write( int fd, const float *p_ir, size_t i_length )
+{
+    const unsigned i_channels = 2 * POSITIONS;
+    const uint32_t i_data = i_length * i_channels * sizeof(float);
+    uint8_t hdr[44];
+
+    memcpy( hdr, "RIFF", 4 );
+    SetDWLE( hdr + 4, 36 + i_data );
+    memcpy( hdr + 8, "WAVEfmt ", 8 );
+    SetDWLE( hdr + 16, 16 );
+    SetWLE( hdr + 20, 3 );
+    SetWLE( hdr + 22, i_channels );
+    SetDWLE( hdr + 24, RATE );
+    SetDWLE( hdr + 28, RATE * i_channels * sizeof(float) );
+    SetWLE( hdr + 32, i_channels * sizeof(float) );
+    SetWLE( hdr + 34, 32 );
+    memcpy( hdr + 36, "data", 4 );
+    SetDWLE( hdr + 40, i_data );
+    assert( write( fd, hdr, sizeof(hdr) ) == sizeof(hdr) );
+
+    for( size_t i = 0; i < i_length; i++ )
+        for( unsigned c = 0; c < i_channels; c++ )
+            assert( write( fd, &p_ir[c * i_length + i], sizeof(float) )
+                    == sizeof(float) );
+}
+
+/* Decaying noise, planar, one pair of ears per position */
+static float *hrir_new( size_t i_length )
+{
+    float *p_ir = fixture_noise_new( 2 * POSITIONS * i_length, .5f );
+
+    for( unsigned c = 0; c < 2 * POSITIONS; c++ )
+        for( size_t i = 0; i < i_length; i++ )
+            p_ir[c * i_length + i] *= expf( -5.f * i / i_length );
+    return p_ir;
+}
+
+/* Checks some output frames against the direct convolution */
+static void test_file( vlc_object_t *obj, uint32_t i_channels,
+                       const char *psz_path, const float *p_ir,
+                       size_t i_length )
+{
+    const size_t i_frames = RATE / 4;
+    const unsigned i_nb = popcount( i_channels );
+    float *p_in = fixture_noise_new( i_frames * i_nb, .5f );
+
+    filter_t *p_filter = headphone_new( obj, i_channels, false, psz_path );
+    float *p_out = headphone_run( p_filter, p_in, i_frames, NULL );
+    fixture_filter_delete( p_filter );
+
+    float f_max = 0.f;
+    for( size_t t = LATENCY; t < i_frames; t += 997 )
+        for( unsigned i_ear = 0; i_ear < 2; i_ear++ )
+        {
+            double d_ref = 0.;
+            for( unsigned i = 0, c = 0; i < POSITIONS; i++ )
+            {
+                if( !( i_channels & positions[i] ) )
+                    continue;
+
+                const float *h = &p_ir[( 2 * i + i_ear ) * i_length];
+                for( size_t j = 0; j < i_length && j <= t - LATENCY; j++ )
+                    d_ref += (double)h[j] * weights[i] / 2 / i_nb
+                           * p_in[( t - LATENCY - j ) * i_nb + c];
+                c++;
+            }
+            f_max = __MAX( f_max, fabs( p_out[t * 2 + i_ear] - d_ref ) );
+        }
+
+    printf( "%u channels, %zu frames responses: max difference %g\n",
+            i_nb, i_length, f_max );
+    assert( f_max < 1e-4f );
+
+    free( p_out );
+    free( p_in );
+}
+
+#ifdef BENCHMARK
+static void benchmark( vlc_object_t *obj, uint32_t i_channels,
+                       bool b_convolution, const char *psz_path,
+                       size_t i_length )
+{
+    const size_t i_frames = RATE;
+    const unsigned i_nb = popcount( i_channels );
+    float *p_in = fixture_noise_new( i_frames * i_nb, .5f );
+    mtime_t i_time;
+
+    filter_t *p_filter = headphone_new( obj, i_channels, b_convolution,
+                                        psz_path );
+    free( headphone_run( p_filter, p_in, i_frames, &i_time ) );
+    fixture_filter_delete( p_filter );
+
+    printf( "%u channels, %s %5zu frames: %4.0fx real-time, "
+            "%.1f ms latency\n", i_nb,
+            b_convolution ? "convolution" : "delay lines", i_length,
+            (double)i_frames * CLOCK_FREQ / RATE / __MAX( i_time, 1 ),
+            b_convolution ? LATENCY * 1000. / RATE : 0. );
+    free( p_in );
+}
+
+#endif
+
+/* Writes decaying noise responses of the given length to a WAV file */
+static float *hrir_file_new( char *psz_path, size_t i_length )
+{
+    int fd = vlc_mkstemp( psz_path );
+    assert( fd != -1 );
+
+    float *p_ir = hrir_new( i_length );
+    hrir_write( fd, p_ir, i_length );
+    close( fd );
+    return p_ir;
+}
+
+int main( void )
+{
+    libvlc_instance_t *p_libvlc = fixture_libvlc_new( 0, NULL, 30 );
+    vlc_object_t *obj = VLC_OBJECT( p_libvlc->p_libvlc_int );
+    static const uint32_t layouts[] = { AOUT_CHANS_5_1, AOUT_CHANS_7_1 };
+
+    for( size_t i = 0; i < ARRAY_SIZE(layouts); i++ )
+        test_model( obj, layouts[i] );
+
+    char psz_path[] = "/tmp/libvlc_XXXXXX";
+    float *p_ir = hrir_file_new( psz_path, 512 );
+    for( size_t i = 0; i < ARRAY_SIZE(layouts); i++ )
+        test_file( obj, layouts[i], psz_path, p_ir, 512 );
+    free( p_ir );
+    unlink( psz_path );
+
+#ifdef BENCHMARK
+    static const size_t lengths[] = { 512, 4096, 32768 };
+
+    for( size_t l = 0; l < ARRAY_SIZE(lengths); l++ )
+    {
+        char psz_bench_path[] = "/tmp/libvlc_XXXXXX";
+        free( hrir_file_new( psz_bench_path, lengths[l] ) );
+
+        for( size_t i = 0; i < ARRAY_SIZE(layouts); i++ )
+            benchmark( obj, layouts[i], true, psz_bench_path, lengths[l] );
+        unlink( psz_bench_path );
+    }
+
+    /* The physical model responses are about 1500 frames long */
+    for( size_t i = 0; i < ARRAY_SIZE(layouts); i++ )
+    {
+        benchmark( obj, layouts[i], false, NULL, 1500 );
+        benchmark( obj, layouts[i], true, NULL, 1500 );
+    }
+#endif
+
+    libvlc_release( p_libvlc );
+    return 0;
+}
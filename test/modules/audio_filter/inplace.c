@@ -0,0 +1,157 @@
+/*****************************************************************************
+ * inplace.c: fused in-place audio filters test
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+#include <math.h>
+
+#include "fixture.h"
+
+#include <vlc_input.h>
+
+#define RATE     48000
+#define CHANNELS 2
+#define BLOCK    4096
+#define BLOCKS   500
+
+static const char *const modules[] = {
+    "gain", "equalizer", "compressor", "stereo_widen",
+};
+
+static filter_t *filter_new( vlc_object_t *obj, const char *psz_module )
+{
+    audio_sample_format_t fmt;
+
+    fixture_fmt_init( &fmt, RATE, AOUT_CHANS_STEREO );
+
+    filter_t *p_filter = fixture_filter_new( obj, &fmt, &fmt );
+    bool b_loaded = fixture_filter_load( p_filter, "audio filter",
+                                         psz_module );
+    assert( b_loaded );
+    assert( p_filter->pf_audio_inplace != NULL );
+    return p_filter;
+}
+
+/* A loud two tone signal, so that the compressor kicks in */
+static block_t *block_new( size_t i_done )
+{
+    block_t *p_block = block_Alloc( BLOCK * CHANNELS * sizeof(float) );
+    assert( p_block != NULL );
+
+    float *p = (float *)p_block->p_buffer;
+    for( size_t i = 0; i < BLOCK; i++ )
+    {
+        double t = (double)( i_done + i ) / RATE;
+        p[i * CHANNELS] = 0.8 * sin( 2. * M_PI * 220. * t );
+        p[i * CHANNELS + 1] = 0.5 * sin( 2. * M_PI * 3520. * t )
+                            + 0.3 * sin( 2. * M_PI * 55. * t );
+    }
+    p_block->i_nb_samples = BLOCK;
+    p_block->i_pts = VLC_TS_0 + i_done * CLOCK_FREQ / RATE;
+    return p_block;
+}
+
+int main( void )
+{
+    static const char *const argv[] = {
+        "--equalizer-bands=8 4.8 -5.6 -8 -3.2 4 8.8 11.2 11.2 11.2",
+        "--gain-value=0.8",
+        /* No resampling after the user filters */
+        "--audio-resampler=none",
+    };
+
+    libvlc_instance_t *p_libvlc = fixture_libvlc_new( ARRAY_SIZE(argv), argv,
+                                                      30 );
+
+    vlc_object_t *root = VLC_OBJECT( p_libvlc->p_libvlc_int );
+    vlc_object_t *p_ref_obj = vlc_object_create( root, sizeof(*p_ref_obj) );
+    vlc_object_t *p_chain_obj = vlc_object_create( root, sizeof(*p_chain_obj) );
+    assert( p_ref_obj != NULL && p_chain_obj != NULL );
+
+    /* Reference: each filter on the whole block, one after the other */
+    filter_t *p_ref[ARRAY_SIZE(modules)];
+    for( size_t m = 0; m < ARRAY_SIZE(modules); m++ )
+        p_ref[m] = filter_new( p_ref_obj, modules[m] );
+
+    /* Output filter chain, fusing the in-place filters */
+    audio_sample_format_t fmt;
+    fixture_fmt_init( &fmt, RATE, AOUT_CHANS_STEREO );
+    var_Create( p_chain_obj, "audio-filter", VLC_VAR_STRING );
+    var_SetString( p_chain_obj, "audio-filter",
+                   "gain:equalizer:compressor:stereo_widen" );
+    aout_filters_t *p_chain = aout_FiltersNew( p_chain_obj, &fmt, &fmt,
+                                               NULL );
+    assert( p_chain != NULL );
+
+#ifdef BENCHMARK
+    mtime_t i_time_ref = 0, i_time_chain = 0;
+#endif
+    size_t i_differ = 0;
+
+    for( size_t b = 0; b < BLOCKS; b++ )
+    {
+        block_t *p_a = block_new( b * BLOCK );
+        block_t *p_b = block_new( b * BLOCK );
+
+#ifdef BENCHMARK
+        mtime_t t0 = mdate();
+#endif
+        for( size_t m = 0; m < ARRAY_SIZE(modules); m++ )
+            p_a = p_ref[m]->pf_audio_filter( p_ref[m], p_a );
+#ifdef BENCHMARK
+        mtime_t t1 = mdate();
+#endif
+        p_b = aout_FiltersPlay( p_chain, p_b, INPUT_RATE_DEFAULT );
+#ifdef BENCHMARK
+        mtime_t t2 = mdate();
+
+        i_time_ref += t1 - t0;
+        i_time_chain += t2 - t1;
+#endif
+
+        /* Every filter only depends on past frames: chunking the block does
+         * not change the output at all */
+        assert( p_a != NULL && p_b != NULL );
+        assert( p_a->i_nb_samples == p_b->i_nb_samples );
+        if( memcmp( p_a->p_buffer, p_b->p_buffer, p_a->i_buffer ) )
+            i_differ++;
+
+        block_Release( p_a );
+        block_Release( p_b );
+    }
+
+    printf( "%zu/%u blocks differ\n", i_differ, BLOCKS );
+    assert( i_differ == 0 );
+#ifdef BENCHMARK
+    printf( "separate passes %.0fx real-time, fused chunks %.0fx real-time\n",
+            fixture_realtime( BLOCKS * BLOCK, RATE, i_time_ref ),
+            fixture_realtime( BLOCKS * BLOCK, RATE, i_time_chain ) );
+#endif
+
+    aout_FiltersDelete( (vlc_object_t *)NULL, p_chain );
+    for( size_t m = 0; m < ARRAY_SIZE(modules); m++ )
+        fixture_filter_delete( p_ref[m] );
+    vlc_object_release( p_chain_obj );
+    vlc_object_release( p_ref_obj );
+
+    libvlc_release( p_libvlc );
+    return 0;
+}
@@ -0,0 +1,262 @@
+/*****************************************************************************
+ * loudness.c: EBU R128 loudness normalization test
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+#include <math.h>
+
+#include "fixture.h"
+
+#include <vlc_es.h>
+
+#define RATE     48000
+#define BLOCK    1024
+
+/* A 1 kHz stereo sine of amplitude A measures 20 log10(A) LUFS */
+#define QUIET_LUFS (-33.)
+
+static vlc_object_t *root;
+
+typedef float (*signal_t)( size_t frame, unsigned channel );
+
+static float Quiet( size_t i, unsigned c )
+{
+    (void) c;
+    return pow( 10., QUIET_LUFS / 20. ) * sin( 2. * M_PI * 1000. * i / RATE );
+}
+
+/* Short bursts of a sine at a quarter of the sample rate, sampled 45 degrees
+ * off its peaks: the true peak is 3 dB above the sample peak. */
+#define BURST_PERIOD (RATE * 2 / 5)
+#define BURST_LENGTH (RATE / 100)
+
+static float Bursts( size_t i, unsigned c )
+{
+    size_t n = i % BURST_PERIOD;
+
+    if( n >= BURST_LENGTH )
+        return 0.f;
+
+    double env = .5 * ( 1. - cos( 2. * M_PI * n / BURST_LENGTH ) );
+    return .25 * env * sin( M_PI / 2. * i + M_PI / 4. + M_PI * c );
+}
+
+static vlc_object_t *parent_new( float f_target, audio_replay_gain_t *p_rg )
+{
+    vlc_object_t *obj = vlc_object_create( root, sizeof(*obj) );
+    assert( obj != NULL );
+
+    var_Create( obj, "loudness-target", VLC_VAR_FLOAT );
+    var_SetFloat( obj, "loudness-target", f_target );
+    var_Create( obj, "loudness-max-gain", VLC_VAR_FLOAT );
+    var_SetFloat( obj, "loudness-max-gain", 40.f );
+    if( p_rg != NULL )
+    {
+        var_Create( obj, "audio-replay-gain", VLC_VAR_ADDRESS );
+        var_SetAddress( obj, "audio-replay-gain", p_rg );
+    }
+    return obj;
+}
+
+static filter_t *filter_new( vlc_object_t *obj, uint32_t i_channels )
+{
+    audio_sample_format_t fmt;
+
+    fixture_fmt_init( &fmt, RATE, i_channels );
+
+    filter_t *p_filter = fixture_filter_new( obj, &fmt, &fmt );
+    bool b_loaded = fixture_filter_load( p_filter, "audio filter",
+                                         "loudness" );
+    assert( b_loaded );
+    assert( p_filter->pf_audio_inplace != NULL );
+    return p_filter;
+}
+
+static void filter_delete( filter_t *p_filter )
+{
+    vlc_object_t *obj = p_filter->obj.parent;
+
+    fixture_filter_delete( p_filter );
+    vlc_object_release( obj );
+}
+
+/* Filters the given number of frames of a signal, keeping the output */
+static float *run( filter_t *p_filter, signal_t signal, size_t i_frames,
+                   mtime_t *pi_time )
+{
+    const unsigned i_channels = p_filter->fmt_in.audio.i_channels;
+    float *p_out = malloc( i_frames * i_channels * sizeof(float) );
+    assert( p_out != NULL );
+
+    if( pi_time != NULL )
+        *pi_time = 0;
+    for( size_t i_done = 0; i_done < i_frames; i_done += BLOCK )
+    {
+        block_t *p_block = block_Alloc( BLOCK * i_channels * sizeof(float) );
+        assert( p_block != NULL );
+        p_block->i_nb_samples = BLOCK;
+
+        float *p = (float *)p_block->p_buffer;
+        for( size_t i = 0; i < BLOCK; i++ )
+            for( unsigned c = 0; c < i_channels; c++ )
+                p[i * i_channels + c] = signal( i_done + i, c );
+
+        p_block = fixture_filter_play( p_filter, p_block, pi_time );
+
+        size_t i_copy = __MIN( BLOCK, i_frames - i_done );
+        memcpy( p_out + i_done * i_channels, p_block->p_buffer,
+                i_copy * i_channels * sizeof(float) );
+        block_Release( p_block );
+    }
+    return p_out;
+}
+
+/* Level in dB of the first channel over the given frames */
+static double peak_db( const float *p, unsigned i_channels,
+                       size_t i_from, size_t i_to )
+{
+    float f_max = 0.f;
+
+    for( size_t i = i_from; i < i_to; i++ )
+        f_max = fmaxf( f_max, fabsf( p[i * i_channels] ) );
+    return 20. * log10( f_max );
+}
+
+/* True peak in dBTP of stereo frames, oversampled 16 times with a long
+ * windowed sinc, much finer than the filter estimate */
+static double true_peak_db( const float *p, size_t i_from, size_t i_to )
+{
+    const int i_half = 32;
+    double f_max = 0.;
+
+    for( size_t i = i_from; i < i_to; i++ )
+        for( unsigned c = 0; c < 2; c++ )
+            for( int k = 0; k < 16; k++ )
+            {
+                double f_acc = 0.;
+
+                for( int t = -i_half + 1; t <= i_half; t++ )
+                {
+                    double d = t - k / 16.;
+                    double sinc = d != 0. ? sin( M_PI * d ) / ( M_PI * d ) : 1.;
+                    double win = .5 * ( 1. + cos( M_PI * d / i_half ) );
+
+                    f_acc += p[( i + t ) * 2 + c] * sinc * win;
+                }
+                f_max = fmax( f_max, fabs( f_acc ) );
+            }
+    return 20. * log10( f_max );
+}
+
+static void test_normalize( void )
+{
+    filter_t *p_filter = filter_new( parent_new( -23.f, NULL ),
+                                     AOUT_CHANS_STEREO );
+    float *p_out = run( p_filter, Quiet, 30 * RATE, NULL );
+
+    /* Unity gain at first, then +10 dB once the gain has settled */
+    double f_start = peak_db( p_out, 2, RATE / 10, RATE / 5 ) - QUIET_LUFS;
+    double f_end = peak_db( p_out, 2, 29 * RATE, 30 * RATE ) - QUIET_LUFS;
+    printf( "normalization: %+.2f dB at first, %+.2f dB at last\n",
+            f_start, f_end );
+    assert( fabs( f_start ) < .5 );
+    assert( fabs( f_end - 10. ) < .3 );
+
+    free( p_out );
+    filter_delete( p_filter );
+}
+
+static void test_replay_gain( void )
+{
+    audio_replay_gain_t rg;
+
+    memset( &rg, 0, sizeof(rg) );
+    rg.pb_gain[AUDIO_REPLAY_GAIN_TRACK] = true;
+    rg.pf_gain[AUDIO_REPLAY_GAIN_TRACK] = -18.f - QUIET_LUFS;
+
+    filter_t *p_filter = filter_new( parent_new( -23.f, &rg ),
+                                     AOUT_CHANS_STEREO );
+    float *p_out = run( p_filter, Quiet, 5 * RATE, NULL );
+
+    /* The gain is right from the start */
+    double f_start = peak_db( p_out, 2, RATE / 10, RATE / 5 ) - QUIET_LUFS;
+    double f_end = peak_db( p_out, 2, 4 * RATE, 5 * RATE ) - QUIET_LUFS;
+    printf( "replay gain: %+.2f dB at first, %+.2f dB at last\n",
+            f_start, f_end );
+    assert( fabs( f_start - 10. ) < .3 );
+    assert( fabs( f_end - 10. ) < .3 );
+
+    free( p_out );
+    filter_delete( p_filter );
+}
+
+static void test_true_peak( void )
+{
+    /* The bursts are loud for their loudness: they would peak about 12 dB
+     * above the default -1 dBTP ceiling without the limiter. */
+    filter_t *p_filter = filter_new( parent_new( -5.f, NULL ),
+                                     AOUT_CHANS_STEREO );
+    float *p_out = run( p_filter, Bursts, 20 * RATE, NULL );
+
+    double f_sample = peak_db( p_out, 2, 10 * RATE, 20 * RATE - 64 );
+    double f_true = true_peak_db( p_out, 10 * RATE, 20 * RATE - 64 );
+    printf( "limiter: sample peak %.2f dBFS, true peak %.2f dBTP\n",
+            f_sample, f_true );
+    assert( f_true < -1. + .2 );
+    /* Limited, not just attenuated */
+    assert( f_true > -1. - 1. );
+    assert( f_sample < f_true - 2. );
+
+    free( p_out );
+    filter_delete( p_filter );
+}
+
+#ifdef BENCHMARK
+static void bench( uint32_t i_channels, const char *psz_name )
+{
+    filter_t *p_filter = filter_new( parent_new( -23.f, NULL ), i_channels );
+    mtime_t i_time;
+    float *p_out = run( p_filter, Quiet, 20 * RATE, &i_time );
+
+    printf( "%s: %.0fx real time\n", psz_name,
+            fixture_realtime( 20 * RATE, RATE, i_time ) );
+
+    free( p_out );
+    filter_delete( p_filter );
+}
+#endif
+
+int main( void )
+{
+    libvlc_instance_t *p_libvlc = fixture_libvlc_new( 0, NULL, 60 );
+    root = VLC_OBJECT( p_libvlc->p_libvlc_int );
+
+    test_normalize();
+    test_replay_gain();
+    test_true_peak();
+#ifdef BENCHMARK
+    bench( AOUT_CHANS_STEREO, "stereo" );
+    bench( AOUT_CHANS_5_1, "5.1" );
+#endif
+
+    libvlc_release( p_libvlc );
+    return 0;
+}
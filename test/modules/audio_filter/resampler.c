@@ -0,0 +1,274 @@
+/*****************************************************************************
+ * resampler.c: audio resamplers quality test
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+#include <math.h>
+
+#include "fixture.h"
+
+#define CHANNELS 2
+#define BLOCK    1024
+#define SECONDS  4
+
+/* Resamplers compared with each other, only tested if built */
+static const char *const modules[] = {
+    "polyphase", "bandlimited", "ugly",
+};
+
+static filter_t *resampler_new( vlc_object_t *obj, const char *psz_module,
+                                unsigned i_in_rate, unsigned i_out_rate )
+{
+    audio_sample_format_t in, out;
+
+    fixture_fmt_init( &in, i_in_rate, AOUT_CHANS_STEREO );
+    out = in;
+    out.i_rate = i_out_rate;
+
+    filter_t *p_filter = fixture_filter_new( obj, &in, &out );
+    if( !fixture_filter_load( p_filter, "audio resampler", psz_module ) )
+    {
+        fixture_filter_delete( p_filter );
+        return NULL;
+    }
+    return p_filter;
+}
+
+/* Feeds i_frames frames of a sine, optionally changing the input rate by up
+ * to i_drift Hz between blocks, and gathers the output */
+static float *resample( filter_t *p_filter, float f_freq, size_t i_frames,
+                        unsigned i_drift, size_t *pi_out, mtime_t *pi_time )
+{
+    const unsigned i_rate = p_filter->fmt_in.audio.i_rate;
+    block_t *p_chain = NULL;
+
+    if( pi_time != NULL )
+        *pi_time = 0;
+
+    for( size_t i_done = 0, b = 0; i_done < i_frames; i_done += BLOCK, b++ )
+    {
+        block_t *p_block = block_Alloc( BLOCK * CHANNELS * sizeof(float) );
+        assert( p_block != NULL );
+
+        float *p = (float *)p_block->p_buffer;
+        for( size_t i = 0; i < BLOCK; i++ )
+            for( unsigned ch = 0; ch < CHANNELS; ch++ )
+                p[i * CHANNELS + ch] =
+                    0.5 * sin( 2. * M_PI * f_freq * (i_done + i) / i_rate );
+        p_block->i_nb_samples = BLOCK;
+        p_block->i_pts = VLC_TS_0 + i_done * CLOCK_FREQ / i_rate;
+
+        if( i_drift > 0 )
+            p_filter->fmt_in.audio.i_rate = i_rate + (b % 3) * i_drift
+                                                   - i_drift;
+
+        p_block = fixture_filter_play( p_filter, p_block, pi_time );
+
+        p_filter->fmt_in.audio.i_rate = i_rate;
+        if( p_block != NULL )
+            block_ChainAppend( &p_chain, p_block );
+    }
+
+    block_t *p_out = block_ChainGather( p_chain );
+    assert( p_out != NULL );
+
+    float *p_samples = malloc( p_out->i_buffer );
+    assert( p_samples != NULL );
+    memcpy( p_samples, p_out->p_buffer, p_out->i_buffer );
+    *pi_out = p_out->i_buffer / ( CHANNELS * sizeof(float) );
+    block_Release( p_out );
+    return p_samples;
+}
+
+/* Signal to noise ratio of the first channel, against the best fitting sine
+ * at the expected frequency, ignoring the edges */
+static double sine_snr( const float *p_samples, size_t i_frames,
+                        double f_freq, unsigned i_rate )
+{
+    const size_t i_start = i_frames / 8, i_end = i_frames - i_frames / 8;
+    double ss = 0., sc = 0., cc = 0., xs = 0., xc = 0.;
+
+    for( size_t i = i_start; i < i_end; i++ )
+    {
+        double w = 2. * M_PI * f_freq * i / i_rate;
+        double s = sin( w ), c = cos( w ), x = p_samples[i * CHANNELS];
+
+        ss += s * s; sc += s * c; cc += c * c;
+        xs += x * s; xc += x * c;
+    }
+
+    double det = ss * cc - sc * sc;
+    double a = ( xs * cc - xc * sc ) / det;
+    double b = ( xc * ss - xs * sc ) / det;
+    double signal = 0., noise = 0.;
+
+    for( size_t i = i_start; i < i_end; i++ )
+    {
+        double w = 2. * M_PI * f_freq * i / i_rate;
+        double fit = a * sin( w ) + b * cos( w );
+        double err = p_samples[i * CHANNELS] - fit;
+
+        signal += fit * fit;
+        noise += err * err;
+    }
+    return 10. * log10( signal / __MAX( noise, 1e-20 ) );
+}
+
+static void test_quality( vlc_object_t *obj, unsigned i_in, unsigned i_out )
+{
+    /* Whole blocks only */
+    const size_t i_frames = SECONDS * i_in / BLOCK * BLOCK;
+    const float f_freq = 997.f;
+
+    for( size_t m = 0; m < ARRAY_SIZE(modules); m++ )
+    {
+        filter_t *p_filter = resampler_new( obj, modules[m], i_in, i_out );
+        if( p_filter == NULL )
+        {
+            printf( "%s: not available\n", modules[m] );
+            continue;
+        }
+
+        size_t i_out_frames;
+        float *p_samples = resample( p_filter, f_freq, i_frames, 0,
+                                     &i_out_frames, NULL );
+        double snr = sine_snr( p_samples, i_out_frames, f_freq, i_out );
+
+        printf( "%s: %u -> %u Hz: %zu -> %zu frames, SNR %.1f dB\n",
+                modules[m], i_in, i_out, i_frames, i_out_frames, snr );
+
+        /* The output length matches the ratio, minus the filter delay */
+        if( !strcmp( modules[m], "polyphase" ) )
+        {
+            assert( i_out_frames <= (uint64_t)i_frames * i_out / i_in + 1 );
+            assert( i_out_frames + 64 >= (uint64_t)i_frames * i_out / i_in );
+            assert( snr > 80. );
+        }
+
+        free( p_samples );
+        fixture_filter_delete( p_filter );
+    }
+}
+
+/* The audio output changes the input rate slightly, from block to block, to
+ * compensate for clock drift */
+static void test_drift( vlc_object_t *obj )
+{
+    const unsigned i_rate = 48000;
+    const float f_freq = 997.f;
+    filter_t *p_filter = resampler_new( obj, "polyphase", i_rate, i_rate );
+    assert( p_filter != NULL );
+
+    size_t i_out_frames;
+    const size_t i_frames = SECONDS * i_rate / BLOCK * BLOCK;
+    float *p_samples = resample( p_filter, f_freq, i_frames, 20,
+                                 &i_out_frames, NULL );
+
+    /* No discontinuity: past the onset ringing, the slope of the sine never
+     * exceeds its maximum */
+    const float f_max = 0.5f * 2.f * (float)M_PI * f_freq / ( i_rate - 20 );
+    for( size_t i = 64; i < i_out_frames; i++ )
+        assert( fabsf( p_samples[i * CHANNELS] - p_samples[(i - 1) * CHANNELS] )
+                <= f_max * 1.01f );
+
+    printf( "polyphase: %u Hz +/- 20 Hz: %zu -> %zu frames\n", i_rate,
+            i_frames, i_out_frames );
+    assert( i_out_frames + 64 >= i_frames && i_out_frames <= i_frames + 64 );
+
+    free( p_samples );
+    fixture_filter_delete( p_filter );
+}
+
+/* Whether the rates are equal or not, the response must be the same, lest
+ * drift compensation switch between filtered and unfiltered output */
+static void test_unity( vlc_object_t *obj )
+{
+    const unsigned i_rate = 48000;
+    const float f_freq = 23500.f; /* in the transition band */
+    const size_t i_frames = i_rate / BLOCK * BLOCK;
+    double f_power[2];
+
+    for( unsigned i_drift = 0; i_drift < 2; i_drift++ )
+    {
+        filter_t *p_filter = resampler_new( obj, "polyphase", i_rate, i_rate );
+        assert( p_filter != NULL );
+
+        size_t i_out_frames;
+        float *p_samples = resample( p_filter, f_freq, i_frames, i_drift,
+                                     &i_out_frames, NULL );
+        double f_sum = 0.;
+
+        for( size_t i = i_out_frames / 8; i < i_out_frames; i++ )
+            f_sum += p_samples[i * CHANNELS] * p_samples[i * CHANNELS];
+        /* Relative to the power of the input sine */
+        f_power[i_drift] = 10. * log10( f_sum / ( i_out_frames * 7 / 8 )
+                                        / 0.125 );
+        free( p_samples );
+        fixture_filter_delete( p_filter );
+    }
+
+    printf( "polyphase: %.0f Hz at %u Hz: %.1f dB, %.1f dB with drift\n",
+            f_freq, i_rate, f_power[0], f_power[1] );
+    assert( f_power[0] < -10. );
+    assert( fabs( f_power[1] - f_power[0] ) < 0.5 );
+}
+
+#ifdef BENCHMARK
+static void bench( vlc_object_t *obj, unsigned i_in, unsigned i_out )
+{
+    const size_t i_frames = SECONDS * i_in / BLOCK * BLOCK;
+
+    for( size_t m = 0; m < ARRAY_SIZE(modules); m++ )
+    {
+        filter_t *p_filter = resampler_new( obj, modules[m], i_in, i_out );
+        if( p_filter == NULL )
+            continue;
+
+        size_t i_out_frames;
+        mtime_t i_time;
+        free( resample( p_filter, 997.f, i_frames, 0, &i_out_frames,
+                        &i_time ) );
+        printf( "%s: %u -> %u Hz: %.0fx real-time\n", modules[m], i_in,
+                i_out, fixture_realtime( i_frames, i_in, i_time ) );
+        fixture_filter_delete( p_filter );
+    }
+}
+#endif
+
+int main( void )
+{
+    libvlc_instance_t *p_libvlc = fixture_libvlc_new( 0, NULL, 30 );
+    vlc_object_t *obj = VLC_OBJECT( p_libvlc->p_libvlc_int );
+
+    test_quality( obj, 44100, 48000 );
+    test_quality( obj, 48000, 44100 );
+    test_quality( obj, 48000, 96000 );
+    test_drift( obj );
+    test_unity( obj );
+#ifdef BENCHMARK
+    bench( obj, 44100, 48000 );
+    bench( obj, 48000, 44100 );
+    bench( obj, 48000, 96000 );
+#endif
+
+    libvlc_release( p_libvlc );
+    return 0;
+}
@@ -0,0 +1,232 @@
+/*****************************************************************************
+ * scaletempo.c: tempo scaler overlap search test
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+#include <math.h>
+#include <stdio.h>
+
+#include "fixture.h"
+
+#include "../modules/audio_filter/scaletempo_search.h"
+
+/* Default parameters of the filter at 48 kHz: 30 ms stride, 20 % overlap
+ * and 14 ms search */
+#define RATE           48000
+#define FRAMES_STRIDE  1440
+#define FRAMES_OVERLAP 288
+#define FRAMES_SEARCH  672
+#define STRIDES        200
+#define SCALE          1.5
+
+typedef struct
+{
+    unsigned channels;
+    float *p_signal;
+    float *p_pre_corr;
+    float *p_coarse;
+    unsigned samples;
+} context_t;
+
+/* Harmonic tones with vibrato, and some noise, different on each channel */
+static float *signal_new( unsigned channels, size_t frames )
+{
+    float *p_buf = malloc( frames * channels * sizeof(float) );
+    uint32_t seed = 0x12345678;
+
+    assert( p_buf != NULL );
+    for( size_t i = 0; i < frames; i++ )
+        for( unsigned c = 0; c < channels; c++ )
+        {
+            double t = (double)i / RATE;
+            double f0 = 220. * ( 1. + 0.01 * sin( 2. * M_PI * 5. * t ) );
+            double v = 0.;
+
+            for( unsigned h = 1; h <= 6; h++ )
+                v += sin( 2. * M_PI * f0 * h * t + c ) / ( h + c );
+            v += 0.3 * sin( 2. * M_PI * 331. * ( c + 1 ) * t );
+
+            p_buf[i * channels + c] = 0.2 * v
+                + (float)(int32_t)fixture_rand( &seed ) / 2147483648.f * 0.05f;
+        }
+    return p_buf;
+}
+
+/* Same windowing as the filter, on the overlap at the given frame */
+static void pre_corr_init( context_t *ctx, size_t frame )
+{
+    const float *po = &ctx->p_signal[( frame + 1 ) * ctx->channels];
+    float *ppc = ctx->p_pre_corr;
+
+    for( unsigned i = 1; i < FRAMES_OVERLAP; i++ )
+        for( unsigned c = 0; c < ctx->channels; c++ )
+            *ppc++ = (float)( i * ( FRAMES_OVERLAP - i ) ) * *po++;
+}
+
+static const float *search_start( const context_t *ctx, unsigned stride )
+{
+    size_t frame = FRAMES_STRIDE * stride * SCALE + FRAMES_STRIDE / 3;
+    return &ctx->p_signal[( frame + 1 ) * ctx->channels];
+}
+
+static double correlation( const context_t *ctx, const float *search,
+                           unsigned off )
+{
+    double corr = 0.;
+    for( unsigned i = 0; i < ctx->samples; i++ )
+        corr += ctx->p_pre_corr[i] * search[off * ctx->channels + i];
+    return corr;
+}
+
+static void context_init( context_t *ctx, unsigned channels )
+{
+    const size_t frames = FRAMES_STRIDE * ( STRIDES * SCALE + 2 )
+                        + FRAMES_SEARCH + FRAMES_OVERLAP;
+
+    ctx->channels = channels;
+    ctx->samples = ( FRAMES_OVERLAP - 1 ) * channels;
+    ctx->p_signal = signal_new( channels, frames );
+    ctx->p_pre_corr = malloc( ctx->samples * sizeof(float) );
+    ctx->p_coarse = malloc( ScaletempoCoarseSize( FRAMES_OVERLAP,
+                                                  FRAMES_SEARCH, channels )
+                            * sizeof(float) );
+    assert( ctx->p_pre_corr != NULL && ctx->p_coarse != NULL );
+}
+
+static void context_clean( context_t *ctx )
+{
+    free( ctx->p_coarse );
+    free( ctx->p_pre_corr );
+    free( ctx->p_signal );
+}
+
+static void test_channels( unsigned channels )
+{
+    scaletempo_corr4_t pf_corr4 = ScaletempoCorr4Select();
+    context_t ctx;
+
+    context_init( &ctx, channels );
+
+    unsigned exact = 0, coarse_exact = 0;
+    double loss = 0., worst = 0.;
+
+    for( unsigned s = 0; s < STRIDES; s++ )
+    {
+        const float *search = search_start( &ctx, s );
+        pre_corr_init( &ctx, FRAMES_STRIDE * s );
+
+        unsigned ref = ScaletempoSearch( ScaletempoCorr4C, ctx.p_pre_corr,
+                                         search, ctx.samples, channels,
+                                         FRAMES_SEARCH );
+        unsigned simd = ScaletempoSearch( pf_corr4, ctx.p_pre_corr, search,
+                                          ctx.samples, channels,
+                                          FRAMES_SEARCH );
+        unsigned coarse = ScaletempoSearchCoarse( pf_corr4, ctx.p_pre_corr,
+                                                  search, ctx.samples,
+                                                  channels, FRAMES_SEARCH,
+                                                  ctx.p_coarse );
+
+        /* Only the summing order differs: a different offset can only be
+         * a tie within rounding errors */
+        double best = correlation( &ctx, search, ref );
+        if( simd == ref )
+            exact++;
+        else
+            assert( correlation( &ctx, search, simd )
+                    >= best - 1e-5 * fabs( best ) );
+
+        if( coarse == ref )
+            coarse_exact++;
+        double l = ( best - correlation( &ctx, search, coarse ) )
+                 / fabs( best );
+        loss += l;
+        worst = __MAX( worst, l );
+    }
+
+    printf( "%u channels: SIMD %u/%u identical offsets\n",
+            channels, exact, STRIDES );
+    printf( "%u channels: coarse %u/%u identical offsets, "
+            "correlation loss mean %.4f%% worst %.3f%%\n",
+            channels, coarse_exact, STRIDES, 100. * loss / STRIDES,
+            100. * worst );
+
+    assert( exact >= STRIDES * 99 / 100 );
+    assert( loss / STRIDES < 0.01 );
+
+    context_clean( &ctx );
+}
+
+#ifdef BENCHMARK
+static void bench_channels( unsigned channels )
+{
+    scaletempo_corr4_t pf_corr4 = ScaletempoCorr4Select();
+    mtime_t time_c = 0, time_simd = 0, time_coarse = 0;
+    volatile unsigned sink = 0;
+    context_t ctx;
+
+    context_init( &ctx, channels );
+
+    for( unsigned s = 0; s < STRIDES; s++ )
+    {
+        const float *search = search_start( &ctx, s );
+        pre_corr_init( &ctx, FRAMES_STRIDE * s );
+
+        mtime_t t0 = mdate();
+        sink += ScaletempoSearch( ScaletempoCorr4C, ctx.p_pre_corr, search,
+                                  ctx.samples, channels, FRAMES_SEARCH );
+        mtime_t t1 = mdate();
+        sink += ScaletempoSearch( pf_corr4, ctx.p_pre_corr, search,
+                                  ctx.samples, channels, FRAMES_SEARCH );
+        mtime_t t2 = mdate();
+        sink += ScaletempoSearchCoarse( pf_corr4, ctx.p_pre_corr, search,
+                                        ctx.samples, channels, FRAMES_SEARCH,
+                                        ctx.p_coarse );
+        mtime_t t3 = mdate();
+
+        time_c += t1 - t0;
+        time_simd += t2 - t1;
+        time_coarse += t3 - t2;
+    }
+
+    printf( "%u channels: SIMD %.2fx faster, coarse %.2fx faster\n",
+            channels, (double)time_c / __MAX( time_simd, 1 ),
+            (double)time_c / __MAX( time_coarse, 1 ) );
+
+    context_clean( &ctx );
+    (void) sink;
+}
+#endif
+
+int main( void )
+{
+    if( ScaletempoCorr4Select() == ScaletempoCorr4C )
+        printf( "no SIMD version for this CPU, checking C only\n" );
+
+    test_channels( 1 );
+    test_channels( 2 );
+    test_channels( 6 );
+#ifdef BENCHMARK
+    bench_channels( 1 );
+    bench_channels( 2 );
+    bench_channels( 6 );
+#endif
+    return 0;
+}
@@ -0,0 +1,268 @@
+/*****************************************************************************
+ * volume.c: software volume kernels test
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+#include <math.h>
+
+#include "../audio_filter/fixture.h"
+
+#include <vlc_aout_volume.h>
+
+#define FRAMES 1023 /* not a multiple of the vector sizes */
+#define RUNS   2000
+
+static const unsigned channels[] = { 1, 2, 6, 8 };
+
+static const struct
+{
+    vlc_fourcc_t format;
+    unsigned size;
+    int64_t tolerance; /* of the plain amplification */
+} formats[] = {
+    { VLC_CODEC_FL32, 4, 0 },
+    { VLC_CODEC_FL64, 8, 0 },
+    { VLC_CODEC_S16N, 2, 0 },
+    /* Rounded to nearest in double precision, instead of down */
+    { VLC_CODEC_S32N, 4, 1 },
+    { VLC_CODEC_U8,   1, 0 },
+};
+
+static block_t *block_new( vlc_fourcc_t format, unsigned size,
+                           unsigned chans )
+{
+    block_t *p_block = block_Alloc( FRAMES * chans * size );
+    uint32_t seed = 0x12345678;
+
+    assert( p_block != NULL );
+    for( size_t i = 0; i < FRAMES * chans; i++ )
+    {
+        fixture_rand( &seed );
+        /* Full scale noise, so that amplification saturates */
+        double v = (int32_t)seed / 2147483648.;
+
+        switch( format )
+        {
+            case VLC_CODEC_FL32:
+                ((float *)p_block->p_buffer)[i] = v;
+                break;
+            case VLC_CODEC_FL64:
+                ((double *)p_block->p_buffer)[i] = v;
+                break;
+            case VLC_CODEC_S16N:
+                ((int16_t *)p_block->p_buffer)[i] = seed >> 16;
+                break;
+            case VLC_CODEC_S32N:
+                ((int32_t *)p_block->p_buffer)[i] = seed;
+                break;
+            case VLC_CODEC_U8:
+                p_block->p_buffer[i] = seed >> 24;
+                break;
+        }
+    }
+    p_block->i_nb_samples = FRAMES;
+    return p_block;
+}
+
+static double sample_get( const block_t *p_block, vlc_fourcc_t format,
+                          size_t i )
+{
+    switch( format )
+    {
+        case VLC_CODEC_FL32: return ((const float *)p_block->p_buffer)[i];
+        case VLC_CODEC_FL64: return ((const double *)p_block->p_buffer)[i];
+        case VLC_CODEC_S16N: return ((const int16_t *)p_block->p_buffer)[i];
+        case VLC_CODEC_S32N: return ((const int32_t *)p_block->p_buffer)[i];
+        case VLC_CODEC_U8:   return p_block->p_buffer[i] - 128;
+    }
+    vlc_assert_unreachable();
+}
+
+/* Scalar reference, as the C versions compute it */
+static double reference( vlc_fourcc_t format, double s, float gain,
+                         bool ramp )
+{
+    double r;
+
+    switch( format )
+    {
+        case VLC_CODEC_FL32:
+            return (float)( (float)s * gain );
+        case VLC_CODEC_FL64:
+            return s * (double)gain;
+        case VLC_CODEC_S16N:
+            if( ramp )
+                r = rintf( __MIN( __MAX( (float)s * gain, -32768.f ),
+                                  32767.f ) );
+            else
+                r = ( (int64_t)s * lroundf( gain * 0x1.p8f ) ) >> 8;
+            return __MIN( __MAX( r, INT16_MIN ), INT16_MAX );
+        case VLC_CODEC_S32N:
+            if( ramp )
+                r = rint( __MIN( __MAX( s * (double)gain, INT32_MIN ),
+                                 INT32_MAX ) );
+            else
+                r = ( (int64_t)s * lroundf( gain * 0x1.p24f ) ) >> 24;
+            return __MIN( __MAX( r, INT32_MIN ), INT32_MAX );
+        case VLC_CODEC_U8:
+            if( ramp )
+                r = rintf( __MIN( __MAX( (float)s * gain, -128.f ), 127.f ) );
+            else
+                r = ( (int64_t)s * lroundf( gain * 0x1.p8f ) ) >> 8;
+            return __MIN( __MAX( r, INT8_MIN ), INT8_MAX );
+    }
+    vlc_assert_unreachable();
+}
+
+#ifdef BENCHMARK
+/* Plain C loops, as the volume modules used to run */
+static void scalar_amplify( block_t *p_block, vlc_fourcc_t format,
+                            float gain )
+{
+    switch( format )
+    {
+        case VLC_CODEC_FL32:
+        {
+            float *p = (float *)p_block->p_buffer;
+            for( size_t n = p_block->i_buffer / sizeof(*p); n > 0; n-- )
+                *(p++) *= gain;
+            break;
+        }
+        case VLC_CODEC_FL64:
+        {
+            double *p = (double *)p_block->p_buffer;
+            for( size_t n = p_block->i_buffer / sizeof(*p); n > 0; n-- )
+                *(p++) *= gain;
+            break;
+        }
+        case VLC_CODEC_S16N:
+        {
+            int16_t *p = (int16_t *)p_block->p_buffer;
+            int_fast32_t mult = lroundf( gain * 0x1.p8f );
+            for( size_t n = p_block->i_buffer / sizeof(*p); n > 0; n-- )
+            {
+                int_fast32_t s = ( *p * mult ) >> 8;
+                *(p++) = __MIN( __MAX( s, INT16_MIN ), INT16_MAX );
+            }
+            break;
+        }
+        case VLC_CODEC_S32N:
+        {
+            int32_t *p = (int32_t *)p_block->p_buffer;
+            int_fast64_t mult = lroundf( gain * 0x1.p24f );
+            for( size_t n = p_block->i_buffer / sizeof(*p); n > 0; n-- )
+            {
+                int_fast64_t s = ( *p * mult ) >> 24;
+                *(p++) = __MIN( __MAX( s, INT32_MIN ), INT32_MAX );
+            }
+            break;
+        }
+        case VLC_CODEC_U8:
+        {
+            uint8_t *p = p_block->p_buffer;
+            int_fast32_t mult = lroundf( gain * 0x1.p8f );
+            for( size_t n = p_block->i_buffer; n > 0; n-- )
+            {
+                int_fast32_t s = ( ( *p - 128 ) * mult ) >> 8;
+                *(p++) = __MIN( __MAX( s, INT8_MIN ), INT8_MAX ) + 128;
+            }
+            break;
+        }
+    }
+}
+
+#endif
+
+static void test_format( vlc_object_t *root, unsigned f, unsigned chans )
+{
+    const vlc_fourcc_t format = formats[f].format;
+    const float from = 0.25f, to = 1.75f;
+
+    audio_volume_t *p_volume = vlc_object_create( root, sizeof(*p_volume) );
+    assert( p_volume != NULL );
+    p_volume->format = format;
+    module_t *p_module = module_need( p_volume, "audio volume", NULL, false );
+    assert( p_module != NULL );
+    assert( p_volume->amplify_ramp != NULL );
+
+    block_t *p_in = block_new( format, formats[f].size, chans );
+    block_t *p_step = block_Duplicate( p_in );
+    block_t *p_ramp = block_Duplicate( p_in );
+    assert( p_step != NULL && p_ramp != NULL );
+
+    p_volume->amplify( p_volume, p_step, to );
+    p_volume->amplify_ramp( p_volume, p_ramp, from, to );
+
+    /* The n-th frame of the ramp is amplified by from + step * (n + 1) */
+    const float step = ( to - from ) / FRAMES;
+    for( size_t i = 0; i < FRAMES * chans; i++ )
+    {
+        double s = sample_get( p_in, format, i );
+        float gain = from + step * (float)( i / chans + 1 );
+
+        assert( fabs( sample_get( p_step, format, i )
+                      - reference( format, s, to, false ) )
+                <= formats[f].tolerance );
+        assert( sample_get( p_ramp, format, i )
+                == reference( format, s, gain, true ) );
+    }
+    /* The last frame reaches the new volume */
+    assert( fabsf( from + step * FRAMES - to ) < 1e-6f );
+
+#ifdef BENCHMARK
+    /* Benchmark against the scalar reference */
+    mtime_t t0 = mdate();
+    for( unsigned r = 0; r < RUNS; r++ )
+        p_volume->amplify( p_volume, p_step, r & 1 ? 0.5f : 2.f );
+    mtime_t t1 = mdate();
+    for( unsigned r = 0; r < RUNS; r++ )
+        p_volume->amplify_ramp( p_volume, p_ramp, r & 1 ? 0.5f : 2.f,
+                                r & 1 ? 2.f : 0.5f );
+    mtime_t t2 = mdate();
+    for( unsigned r = 0; r < RUNS; r++ )
+        scalar_amplify( p_in, format, r & 1 ? 0.5f : 2.f );
+    mtime_t t3 = mdate();
+
+    const double samples = (double)RUNS * FRAMES * chans;
+    printf( "%4.4s %u channels: step %.2f ns, ramp %.2f ns, "
+            "scalar %.2f ns per sample\n", (const char *)&format, chans,
+            1000. * ( t1 - t0 ) / samples, 1000. * ( t2 - t1 ) / samples,
+            1000. * ( t3 - t2 ) / samples );
+#endif
+
+    block_Release( p_ramp );
+    block_Release( p_step );
+    block_Release( p_in );
+    module_unneed( p_volume, p_module );
+    vlc_object_release( p_volume );
+}
+
+int main( void )
+{
+    libvlc_instance_t *p_libvlc = fixture_libvlc_new( 0, NULL, 60 );
+    vlc_object_t *root = VLC_OBJECT( p_libvlc->p_libvlc_int );
+    for( unsigned f = 0; f < ARRAY_SIZE(formats); f++ )
+        for( unsigned c = 0; c < ARRAY_SIZE(channels); c++ )
+            test_format( root, f, channels[c] );
+
+    libvlc_release( p_libvlc );
+    return 0;
+}
@@ -0,0 +1,436 @@
+/*****************************************************************************
+ * avi.c: AVI demuxer index reconstruction test and benchmark
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+#include <vlc/vlc.h>
+
+#include "../../../lib/libvlc_internal.h"
+
+#include <vlc_common.h>
+#include <vlc_demux.h>
+#include <vlc_es_out.h>
+#include <vlc_stream.h>
+#include <vlc_fs.h>
+#include <vlc_url.h>
+
+#include <dirent.h>
+#include <unistd.h>
+
+#undef NDEBUG
+#include <assert.h>
+
+/* A broken capture: half an hour of 25 fps DIV3 video and 8 kHz audio,
+ * interleaved frame by frame, without index and with no frame count in
+ * the header */
+#define MINUTES        30
+#define FPS            25
+#define FRAMES         (MINUTES * 60 * FPS)
+#define GOP            25
+#define AUDIO_RATE     8000
+#define AUDIO_CHUNK    (AUDIO_RATE / FPS)
+#define DURATION       ((mtime_t)FRAMES * CLOCK_FREQ / FPS)
+
+static uint32_t frame_size( unsigned i )
+{
+    return 200 + ( i % 5 ) * 16;
+}
+
+/*****************************************************************************
+ * Chunk writer
+ *****************************************************************************/
+typedef struct
+{
+    FILE *f;
+    long i_pos[4];
+    unsigned i_level;
+} writer_t;
+
+static void put( writer_t *w, const void *p, size_t i )
+{
+    assert( fwrite( p, 1, i, w->f ) == i );
+}
+
+static void put16( writer_t *w, uint16_t v )
+{
+    uint8_t a[2]; SetWLE( a, v ); put( w, a, 2 );
+}
+static void put32( writer_t *w, uint32_t v )
+{
+    uint8_t a[4]; SetDWLE( a, v ); put( w, a, 4 );
+}
+
+static void list_open( writer_t *w, const char *psz_list, const char *psz_type )
+{
+    assert( w->i_level < ARRAY_SIZE(w->i_pos) );
+    w->i_pos[w->i_level++] = ftell( w->f );
+    put( w, psz_list, 4 );
+    put32( w, 0 );
+    put( w, psz_type, 4 );
+}
+
+static void list_close( writer_t *w )
+{
+    long i_start = w->i_pos[--w->i_level];
+    long i_end = ftell( w->f );
+
+    assert( fseek( w->f, i_start + 4, SEEK_SET ) == 0 );
+    put32( w, i_end - i_start - 8 );
+    assert( fseek( w->f, i_end, SEEK_SET ) == 0 );
+}
+
+static void chunk_put( writer_t *w, const char *psz_fourcc, const void *p,
+                       uint32_t i_size )
+{
+    put( w, psz_fourcc, 4 );
+    put32( w, i_size );
+    put( w, p, i_size );
+    if( i_size & 1 )
+        put( w, "", 1 );
+}
+
+static void file_write( const char *psz_path )
+{
+    writer_t w = { .f = vlc_fopen( psz_path, "wb" ) };
+    uint8_t p[512];
+    assert( w.f != NULL );
+
+    list_open( &w, "RIFF", "AVI " );
+    list_open( &w, "LIST", "hdrl" );
+
+    put( &w, "avih", 4 );
+    put32( &w, 56 );
+    put32( &w, CLOCK_FREQ / FPS );
+    put32( &w, 0 );
+    put32( &w, 0 );
+    put32( &w, 0x100 );                 /* interleaved, no index */
+    put32( &w, 0 );                     /* unknown frame count */
+    put32( &w, 0 );
+    put32( &w, 2 );
+    put32( &w, 0 );
+    put32( &w, 320 );
+    put32( &w, 240 );
+    for( unsigned i = 0; i < 4; i++ )
+        put32( &w, 0 );
+
+    list_open( &w, "LIST", "strl" );
+    put( &w, "strh", 4 );
+    put32( &w, 56 );
+    put( &w, "vidsDIV3", 8 );
+    for( unsigned i = 0; i < 3; i++ )
+        put32( &w, 0 );
+    put32( &w, 1 );                     /* scale */
+    put32( &w, FPS );                   /* rate */
+    for( unsigned i = 0; i < 4; i++ )
+        put32( &w, 0 );
+    put32( &w, 0 );                     /* sample size */
+    for( unsigned i = 0; i < 2; i++ )
+        put32( &w, 0 );
+    put( &w, "strf", 4 );
+    put32( &w, 40 );
+    put32( &w, 40 );
+    put32( &w, 320 );
+    put32( &w, 240 );
+    put16( &w, 1 );
+    put16( &w, 24 );
+    put( &w, "DIV3", 4 );
+    for( unsigned i = 0; i < 5; i++ )
+        put32( &w, 0 );
+    list_close( &w );
+
+    list_open( &w, "LIST", "strl" );
+    put( &w, "strh", 4 );
+    put32( &w, 56 );
+    put( &w, "auds", 4 );
+    for( unsigned i = 0; i < 4; i++ )
+        put32( &w, 0 );
+    put32( &w, 1 );                     /* scale */
+    put32( &w, AUDIO_RATE );            /* rate */
+    for( unsigned i = 0; i < 4; i++ )
+        put32( &w, 0 );
+    put32( &w, 1 );                     /* sample size */
+    for( unsigned i = 0; i < 2; i++ )
+        put32( &w, 0 );
+    put( &w, "strf", 4 );
+    put32( &w, 18 );
+    put16( &w, 1 );                     /* PCM */
+    put16( &w, 1 );
+    put32( &w, AUDIO_RATE );
+    put32( &w, AUDIO_RATE );
+    put16( &w, 1 );
+    put16( &w, 8 );
+    put16( &w, 0 );
+    list_close( &w );
+
+    list_close( &w );
+
+    /* Video frames start with their picture type and number */
+    list_open( &w, "LIST", "movi" );
+    for( unsigned i = 0; i < FRAMES; i++ )
+    {
+        memset( p, 0, sizeof(p) );
+        p[0] = i % GOP ? 0x40 : 0x00;
+        SetDWLE( &p[4], i );
+        chunk_put( &w, "00dc", p, frame_size( i ) );
+
+        memset( p, 0x80, AUDIO_CHUNK );
+        chunk_put( &w, "01wb", p, AUDIO_CHUNK );
+    }
+    list_close( &w );
+
+    list_close( &w );
+    assert( fclose( w.f ) == 0 );
+}
+
+/*****************************************************************************
+ * Elementary streams output
+ *****************************************************************************/
+struct es_out_id_t
+{
+    int i_cat;
+};
+
+struct es_out_sys_t
+{
+    es_out_id_t es[2];
+    unsigned i_es;
+    unsigned i_video;
+    unsigned i_first_frame;
+};
+
+static es_out_id_t *EsOutAdd( es_out_t *out, const es_format_t *fmt )
+{
+    es_out_sys_t *p_sys = out->p_sys;
+
+    assert( p_sys->i_es < 2 );
+    p_sys->es[p_sys->i_es].i_cat = fmt->i_cat;
+    return &p_sys->es[p_sys->i_es++];
+}
+
+static int EsOutSend( es_out_t *out, es_out_id_t *id, block_t *p_block )
+{
+    es_out_sys_t *p_sys = out->p_sys;
+
+    if( id->i_cat == VIDEO_ES )
+    {
+        unsigned i = GetDWLE( &p_block->p_buffer[4] );
+
+        assert( p_block->i_buffer == frame_size( i ) );
+        assert( p_block->i_dts - VLC_TS_0 ==
+                (mtime_t)i * CLOCK_FREQ / FPS );
+        if( p_sys->i_video++ == 0 )
+            p_sys->i_first_frame = i;
+    }
+
+    block_Release( p_block );
+    return VLC_SUCCESS;
+}
+
+static void EsOutDel( es_out_t *out, es_out_id_t *id )
+{
+    (void) out; (void) id;
+}
+
+static int EsOutControl( es_out_t *out, int i_query, va_list args )
+{
+    (void) out;
+
+    if( i_query == ES_OUT_GET_ES_STATE )
+    {
+        (void) va_arg( args, es_out_id_t * );
+        *va_arg( args, bool * ) = true;
+    }
+    return VLC_SUCCESS;
+}
+
+/*****************************************************************************
+ * Test
+ *****************************************************************************/
+typedef struct
+{
+    demux_t *p_demux;
+    es_out_t out;
+    es_out_sys_t out_sys;
+} player_t;
+
+static mtime_t player_open( player_t *p, vlc_object_t *root,
+                            const char *psz_url )
+{
+    memset( &p->out_sys, 0, sizeof(p->out_sys) );
+    p->out = (es_out_t) {
+        .pf_add = EsOutAdd, .pf_send = EsOutSend, .pf_del = EsOutDel,
+        .pf_control = EsOutControl, .p_sys = &p->out_sys,
+    };
+
+    mtime_t t0 = mdate();
+    stream_t *s = vlc_stream_NewMRL( root, psz_url );
+    assert( s != NULL );
+    p->p_demux = demux_New( root, "avi", "", s, &p->out );
+    assert( p->p_demux != NULL );
+    return mdate() - t0;
+}
+
+static mtime_t length( player_t *p )
+{
+    int64_t i_length;
+    assert( demux_Control( p->p_demux, DEMUX_GET_LENGTH, &i_length ) == 0 );
+    return i_length;
+}
+
+/* Plays a few frames from the given time or position, and returns the
+ * first video frame */
+static unsigned play_from( player_t *p, mtime_t i_time, double f_pos )
+{
+    if( i_time >= 0 )
+        assert( demux_Control( p->p_demux, DEMUX_SET_TIME, i_time,
+                               true ) == 0 );
+    else
+        assert( demux_Control( p->p_demux, DEMUX_SET_POSITION, f_pos,
+                               true ) == 0 );
+
+    p->out_sys.i_video = 0;
+    while( p->out_sys.i_video < 10 )
+        assert( demux_Demux( p->p_demux ) == VLC_DEMUXER_SUCCESS );
+    return p->out_sys.i_first_frame;
+}
+
+/* The frames from the key frame before the target */
+static void check_seek( player_t *p, mtime_t i_time )
+{
+    unsigned i_target = i_time * FPS / CLOCK_FREQ;
+    unsigned i_frame = play_from( p, i_time, 0. );
+
+    assert( i_frame % GOP == 0 );
+    assert( i_frame <= i_target && i_target < i_frame + GOP );
+}
+
+static void set_options( vlc_object_t *root, bool b_background,
+                         bool b_cache )
+{
+    var_SetBool( root, "avi-background-index", b_background );
+    var_SetBool( root, "avi-index-cache", b_cache );
+}
+
+static void remove_cache( const char *psz_cache )
+{
+    char *psz_dir;
+    assert( asprintf( &psz_dir, "%s/vlc/avi", psz_cache ) != -1 );
+
+    DIR *dir = opendir( psz_dir );
+    if( dir != NULL )
+    {
+        struct dirent *ent;
+        while( ( ent = readdir( dir ) ) != NULL )
+        {
+            char *psz_file;
+            if( ent->d_name[0] == '.' )
+                continue;
+            assert( asprintf( &psz_file, "%s/%s", psz_dir,
+                              ent->d_name ) != -1 );
+            unlink( psz_file );
+            free( psz_file );
+        }
+        closedir( dir );
+    }
+    rmdir( psz_dir );
+    free( psz_dir );
+
+    assert( asprintf( &psz_dir, "%s/vlc", psz_cache ) != -1 );
+    rmdir( psz_dir );
+    free( psz_dir );
+    rmdir( psz_cache );
+}
+
+int main( void )
+{
+    const char *psz_tmp = getenv( "TMPDIR" );
+    char *psz_path, *psz_cache;
+    assert( asprintf( &psz_path, "%s/vlc-test-avi-XXXXXX",
+                      psz_tmp ? psz_tmp : "/tmp" ) != -1 );
+    assert( asprintf( &psz_cache, "%s/vlc-test-avi-cache-XXXXXX",
+                      psz_tmp ? psz_tmp : "/tmp" ) != -1 );
+    int fd = mkstemp( psz_path );
+    assert( fd >= 0 );
+    close( fd );
+    assert( mkdtemp( psz_cache ) != NULL );
+
+    setenv( "VLC_PLUGIN_PATH", "../modules", 1 );
+    setenv( "XDG_CACHE_HOME", psz_cache, 1 );
+    alarm( 60 );
+
+    file_write( psz_path );
+    char *psz_url = vlc_path2uri( psz_path, "file" );
+    assert( psz_url != NULL );
+
+    /* Always fix the index */
+    static const char *const argv[] = { "--avi-index=1" };
+    libvlc_instance_t *p_libvlc = libvlc_new( 1, argv );
+    assert( p_libvlc != NULL );
+    vlc_object_t *root = VLC_OBJECT( p_libvlc->p_libvlc_int );
+    var_Create( root, "avi-background-index", VLC_VAR_BOOL );
+    var_Create( root, "avi-index-cache", VLC_VAR_BOOL );
+
+    player_t p;
+
+    /* Scanning the whole file before playing */
+    set_options( root, false, false );
+    mtime_t i_sync = player_open( &p, root, psz_url );
+    assert( length( &p ) == DURATION );
+    check_seek( &p, DURATION * 4 / 5 );
+    check_seek( &p, DURATION / 3 );
+    demux_Delete( p.p_demux );
+
+    /* Playing right away, seeking by position until the index is complete */
+    set_options( root, true, true );
+    mtime_t i_background = player_open( &p, root, psz_url );
+    unsigned i_frame = play_from( &p, -1, .8 );
+    assert( abs( (int)i_frame - FRAMES * 4 / 5 ) < FRAMES / 50 );
+
+    unsigned i_demux = 0;
+    while( length( &p ) != DURATION )
+    {
+        if( demux_Demux( p.p_demux ) != VLC_DEMUXER_SUCCESS )
+            play_from( &p, -1, .5 );
+        i_demux++;
+    }
+    check_seek( &p, DURATION * 9 / 10 );
+    check_seek( &p, DURATION / 4 );
+    demux_Delete( p.p_demux );
+
+    /* Reusing the index built in the background */
+    mtime_t i_cached = player_open( &p, root, psz_url );
+    assert( length( &p ) == DURATION );
+    check_seek( &p, DURATION / 2 );
+    demux_Delete( p.p_demux );
+
+    printf( "open: %"PRId64" ms indexing, %"PRId64" ms in the background "
+            "(complete after %u demux calls), %"PRId64" ms from the cache\n",
+            i_sync / 1000, i_background / 1000, i_demux, i_cached / 1000 );
+
+    libvlc_release( p_libvlc );
+
+    remove_cache( psz_cache );
+    unlink( psz_path );
+    free( psz_url );
+    free( psz_cache );
+    free( psz_path );
+    return 0;
+}
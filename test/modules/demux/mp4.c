@@ -0,0 +1,700 @@
+/*****************************************************************************
+ * mp4.c: MP4 demuxer sample tables and reads test and benchmark
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+#include <vlc/vlc.h>
+
+#include "../../../lib/libvlc_internal.h"
+
+#include <vlc_common.h>
+#include <vlc_demux.h>
+#include <vlc_es_out.h>
+#include <vlc_stream.h>
+
+#undef NDEBUG
+#include <assert.h>
+
+/* A long recording: 30 fps video with B-frames, one frame per chunk, and
+ * AAC-like audio in several languages, five frames per chunk */
+#define HOURS          3
+#define VIDEO_SCALE    30000
+#define VIDEO_DELTA    1000
+#define VIDEO_SAMPLES  (HOURS * 3600 * VIDEO_SCALE / VIDEO_DELTA)
+#define VIDEO_GOP      30
+#define AUDIO_SCALE    48000
+#define AUDIO_DELTA    1024
+#define AUDIO_SAMPLES  (HOURS * 3600 * AUDIO_SCALE / AUDIO_DELTA)
+#define AUDIO_PER_CHUNK 5
+#define AUDIO_TRACKS   4
+#define TRACKS         (1 + AUDIO_TRACKS)
+#define MDAT_SIZE      256
+
+/* A short but real file: half a second chunks of all the tracks, stored by
+ * time, and every sample starting with its track and number */
+#define INTERLEAVED_SECONDS 64
+
+typedef struct
+{
+    unsigned i_seconds;
+    unsigned i_per_chunk[2];            /* video, audio */
+    bool     b_interleaved;             /* else one small shared mdat */
+    uint32_t *pi_offset[TRACKS];        /* chunk offsets when interleaved */
+} layout_t;
+
+static const layout_t long_layout = {
+    HOURS * 3600, { 1, AUDIO_PER_CHUNK }, false, { NULL },
+};
+
+static unsigned track_samples( const layout_t *l, unsigned i_track )
+{
+    return i_track == 0 ? l->i_seconds * VIDEO_SCALE / VIDEO_DELTA
+                        : l->i_seconds * AUDIO_SCALE / AUDIO_DELTA;
+}
+
+static unsigned track_chunks( const layout_t *l, unsigned i_track )
+{
+    const unsigned i_per_chunk = l->i_per_chunk[i_track ? 1 : 0];
+    return ( track_samples( l, i_track ) + i_per_chunk - 1 ) / i_per_chunk;
+}
+
+static uint32_t sample_size( const layout_t *l, unsigned i_track, unsigned i )
+{
+    if( !l->b_interleaved )
+        return 16 + ( i * 7 ) % 48;
+    return i_track == 0 ? 2048 + ( i * 797 ) % 12288
+                        : 256 + ( i * 61 ) % 384;
+}
+
+static uint32_t sample_tag( unsigned i_track, unsigned i )
+{
+    return ( i_track << 24 ) | i;
+}
+
+/* Composition offset of the i-th video frame */
+static uint32_t video_cts( unsigned i )
+{
+    return ( i % 3 ) * VIDEO_DELTA;
+}
+
+/*****************************************************************************
+ * Box writer
+ *****************************************************************************/
+typedef struct
+{
+    uint8_t *p;
+    size_t i_size;
+    size_t i_alloc;
+} buffer_t;
+
+static void put( buffer_t *b, const void *p, size_t i )
+{
+    if( b->i_size + i > b->i_alloc )
+    {
+        b->i_alloc = __MAX( 2 * b->i_alloc, b->i_size + i );
+        b->p = realloc( b->p, b->i_alloc );
+        assert( b->p != NULL );
+    }
+    memcpy( b->p + b->i_size, p, i );
+    b->i_size += i;
+}
+
+static void put8( buffer_t *b, uint8_t v ) { put( b, &v, 1 ); }
+static void put16( buffer_t *b, uint16_t v )
+{
+    uint8_t a[2]; SetWBE( a, v ); put( b, a, 2 );
+}
+static void put32( buffer_t *b, uint32_t v )
+{
+    uint8_t a[4]; SetDWBE( a, v ); put( b, a, 4 );
+}
+static void putz( buffer_t *b, size_t i )
+{
+    while( i-- ) put8( b, 0 );
+}
+
+static size_t box_open( buffer_t *b, const char *psz_type )
+{
+    size_t i_start = b->i_size;
+    put32( b, 0 );
+    put( b, psz_type, 4 );
+    return i_start;
+}
+
+static size_t fullbox_open( buffer_t *b, const char *psz_type, uint32_t flags )
+{
+    size_t i_start = box_open( b, psz_type );
+    put32( b, flags );
+    return i_start;
+}
+
+static void box_close( buffer_t *b, size_t i_start )
+{
+    SetDWBE( b->p + i_start, b->i_size - i_start );
+}
+
+static void put_matrix( buffer_t *b )
+{
+    static const uint32_t matrix[9] = {
+        0x10000, 0, 0, 0, 0x10000, 0, 0, 0, 0x40000000 };
+    for( unsigned i = 0; i < 9; i++ )
+        put32( b, matrix[i] );
+}
+
+static void put_stbl( buffer_t *b, const layout_t *l, unsigned i_track,
+                      uint32_t i_mdat )
+{
+    const bool b_video = i_track == 0;
+    const unsigned i_samples = track_samples( l, i_track );
+    const unsigned i_per_chunk = l->i_per_chunk[b_video ? 0 : 1];
+    const unsigned i_chunks = track_chunks( l, i_track );
+    size_t stbl = box_open( b, "stbl" );
+
+    size_t stsd = fullbox_open( b, "stsd", 0 );
+    put32( b, 1 );
+    if( b_video )
+    {
+        size_t entry = box_open( b, "jpeg" );
+        putz( b, 6 ); put16( b, 1 );
+        putz( b, 16 );
+        put16( b, 640 ); put16( b, 360 );
+        put32( b, 0x480000 ); put32( b, 0x480000 );
+        put32( b, 0 ); put16( b, 1 );
+        putz( b, 32 );
+        put16( b, 24 ); put16( b, 0xffff );
+        box_close( b, entry );
+    }
+    else
+    {
+        size_t entry = box_open( b, "mp4a" );
+        putz( b, 6 ); put16( b, 1 );
+        putz( b, 8 );
+        put16( b, 2 ); put16( b, 16 );
+        put16( b, 0 ); put16( b, 0 );
+        put32( b, AUDIO_SCALE << 16 );
+        box_close( b, entry );
+    }
+    box_close( b, stsd );
+
+    size_t stts = fullbox_open( b, "stts", 0 );
+    put32( b, 1 );
+    put32( b, i_samples );
+    put32( b, b_video ? VIDEO_DELTA : AUDIO_DELTA );
+    box_close( b, stts );
+
+    if( b_video )
+    {
+        size_t ctts = fullbox_open( b, "ctts", 0 );
+        put32( b, i_samples );
+        for( unsigned i = 0; i < i_samples; i++ )
+        {
+            put32( b, 1 );
+            put32( b, video_cts( i ) );
+        }
+        box_close( b, ctts );
+
+        size_t stss = fullbox_open( b, "stss", 0 );
+        put32( b, ( i_samples + VIDEO_GOP - 1 ) / VIDEO_GOP );
+        for( unsigned i = 0; i < i_samples; i += VIDEO_GOP )
+            put32( b, i + 1 );
+        box_close( b, stss );
+    }
+
+    size_t stsc = fullbox_open( b, "stsc", 0 );
+    put32( b, 1 );
+    put32( b, 1 ); put32( b, i_per_chunk ); put32( b, 1 );
+    box_close( b, stsc );
+
+    size_t stsz = fullbox_open( b, "stsz", 0 );
+    put32( b, 0 );
+    put32( b, i_samples );
+    for( unsigned i = 0; i < i_samples; i++ )
+        put32( b, sample_size( l, i_track, i ) );
+    box_close( b, stsz );
+
+    size_t stco = fullbox_open( b, "stco", 0 );
+    put32( b, i_chunks );
+    for( unsigned i = 0; i < i_chunks; i++ )
+        put32( b, l->b_interleaved ? l->pi_offset[i_track][i] : i_mdat );
+    box_close( b, stco );
+
+    box_close( b, stbl );
+}
+
+static void put_trak( buffer_t *b, const layout_t *l, unsigned i_track,
+                      uint32_t i_mdat )
+{
+    const bool b_video = i_track == 0;
+    const uint32_t i_scale = b_video ? VIDEO_SCALE : AUDIO_SCALE;
+    const uint32_t i_duration = track_samples( l, i_track )
+                              * ( b_video ? VIDEO_DELTA : AUDIO_DELTA );
+    size_t trak = box_open( b, "trak" );
+
+    size_t tkhd = fullbox_open( b, "tkhd", 3 );
+    put32( b, 0 ); put32( b, 0 );
+    put32( b, 1 + i_track );
+    put32( b, 0 );
+    put32( b, l->i_seconds * 1000 );
+    putz( b, 8 );
+    put16( b, 0 ); put16( b, 0 );
+    put16( b, b_video ? 0 : 0x100 ); put16( b, 0 );
+    put_matrix( b );
+    put32( b, b_video ? 640 << 16 : 0 );
+    put32( b, b_video ? 360 << 16 : 0 );
+    box_close( b, tkhd );
+
+    size_t mdia = box_open( b, "mdia" );
+    size_t mdhd = fullbox_open( b, "mdhd", 0 );
+    put32( b, 0 ); put32( b, 0 );
+    put32( b, i_scale );
+    put32( b, i_duration );
+    put16( b, 0x55c4 ); put16( b, 0 );
+    box_close( b, mdhd );
+
+    size_t hdlr = fullbox_open( b, "hdlr", 0 );
+    put32( b, 0 );
+    put( b, b_video ? "vide" : "soun", 4 );
+    putz( b, 12 );
+    put8( b, 0 );
+    box_close( b, hdlr );
+
+    size_t minf = box_open( b, "minf" );
+    if( b_video )
+    {
+        size_t vmhd = fullbox_open( b, "vmhd", 1 );
+        putz( b, 8 );
+        box_close( b, vmhd );
+    }
+    else
+    {
+        size_t smhd = fullbox_open( b, "smhd", 0 );
+        putz( b, 4 );
+        box_close( b, smhd );
+    }
+    put_stbl( b, l, i_track, i_mdat );
+    box_close( b, minf );
+    box_close( b, mdia );
+    box_close( b, trak );
+}
+
+/* Stores the chunks of all the tracks by start time */
+static void put_interleaved( buffer_t *b, layout_t *l )
+{
+    unsigned i_chunk[TRACKS] = { 0 };
+
+    for( unsigned t = 0; t < TRACKS; t++ )
+    {
+        l->pi_offset[t] = malloc( track_chunks( l, t ) * sizeof(uint32_t) );
+        assert( l->pi_offset[t] != NULL );
+    }
+
+    for( ;; )
+    {
+        unsigned i_track = TRACKS;
+        mtime_t i_start = INT64_MAX;
+
+        for( unsigned t = 0; t < TRACKS; t++ )
+        {
+            if( i_chunk[t] >= track_chunks( l, t ) )
+                continue;
+            mtime_t i_time = t == 0
+                ? (mtime_t)i_chunk[t] * l->i_per_chunk[0] * VIDEO_DELTA
+                  * CLOCK_FREQ / VIDEO_SCALE
+                : (mtime_t)i_chunk[t] * l->i_per_chunk[1] * AUDIO_DELTA
+                  * CLOCK_FREQ / AUDIO_SCALE;
+            if( i_time < i_start )
+            {
+                i_start = i_time;
+                i_track = t;
+            }
+        }
+        if( i_track == TRACKS )
+            break;
+
+        const unsigned i_per_chunk = l->i_per_chunk[i_track ? 1 : 0];
+        const unsigned i_first = i_chunk[i_track] * i_per_chunk;
+        const unsigned i_last = __MIN( i_first + i_per_chunk,
+                                       track_samples( l, i_track ) );
+
+        l->pi_offset[i_track][i_chunk[i_track]++] = b->i_size;
+        for( unsigned i = i_first; i < i_last; i++ )
+        {
+            uint32_t i_size = sample_size( l, i_track, i );
+            put32( b, sample_tag( i_track, i ) );
+            for( uint32_t j = 4; j < i_size; j++ )
+                put8( b, j );
+        }
+    }
+}
+
+static void file_build( buffer_t *b, layout_t *l )
+{
+    size_t ftyp = box_open( b, "ftyp" );
+    put( b, "isom", 4 ); put32( b, 0 ); put( b, "isom", 4 );
+    box_close( b, ftyp );
+
+    size_t mdat = box_open( b, "mdat" );
+    const uint32_t i_mdat = b->i_size;
+    if( l->b_interleaved )
+        put_interleaved( b, l );
+    else
+        for( unsigned i = 0; i < MDAT_SIZE; i++ )
+            put8( b, i );
+    box_close( b, mdat );
+
+    size_t moov = box_open( b, "moov" );
+    size_t mvhd = fullbox_open( b, "mvhd", 0 );
+    put32( b, 0 ); put32( b, 0 );
+    put32( b, 1000 );
+    put32( b, l->i_seconds * 1000 );
+    put32( b, 0x10000 ); put16( b, 0x100 );
+    putz( b, 10 );
+    put_matrix( b );
+    putz( b, 24 );
+    put32( b, 2 + AUDIO_TRACKS );
+    box_close( b, mvhd );
+    for( unsigned i = 0; i < TRACKS; i++ )
+        put_trak( b, l, i, i_mdat );
+    box_close( b, moov );
+}
+
+/*****************************************************************************
+ * Elementary streams output
+ *****************************************************************************/
+struct es_out_id_t
+{
+    int i_cat;
+};
+
+struct es_out_sys_t
+{
+    const layout_t *p_layout;
+    es_out_id_t es[TRACKS];
+    unsigned i_es;
+    unsigned i_video;
+    unsigned i_audio;
+    mtime_t i_first_video_dts;
+};
+
+static es_out_id_t *EsOutAdd( es_out_t *out, const es_format_t *fmt )
+{
+    es_out_sys_t *p_sys = out->p_sys;
+
+    assert( p_sys->i_es < TRACKS );
+    p_sys->es[p_sys->i_es].i_cat = fmt->i_cat;
+    return &p_sys->es[p_sys->i_es++];
+}
+
+static int EsOutSend( es_out_t *out, es_out_id_t *id, block_t *p_block )
+{
+    es_out_sys_t *p_sys = out->p_sys;
+
+    if( id->i_cat == VIDEO_ES )
+    {
+        /* Check the timestamps of the video frames */
+        mtime_t i_dts = p_block->i_dts - VLC_TS_0;
+        unsigned i = ( i_dts * VIDEO_SCALE + CLOCK_FREQ / 2 )
+                   / CLOCK_FREQ / VIDEO_DELTA;
+        mtime_t i_cts = (mtime_t)video_cts( i ) * CLOCK_FREQ / VIDEO_SCALE;
+
+        assert( p_block->i_buffer == sample_size( p_sys->p_layout, 0, i ) );
+        assert( llabs( p_block->i_pts - p_block->i_dts - i_cts ) <= 1 );
+        if( p_sys->p_layout->b_interleaved )
+            assert( GetDWBE( p_block->p_buffer ) == sample_tag( 0, i ) );
+        if( p_sys->i_video++ == 0 )
+            p_sys->i_first_video_dts = i_dts;
+    }
+    else
+    {
+        /* Only the first audio track is selected */
+        assert( id == &p_sys->es[1] );
+        if( p_sys->p_layout->b_interleaved )
+        {
+            mtime_t i_dts = p_block->i_dts - VLC_TS_0;
+            unsigned i = ( i_dts * AUDIO_SCALE + CLOCK_FREQ / 2 )
+                       / CLOCK_FREQ / AUDIO_DELTA;
+
+            assert( p_block->i_buffer == sample_size( p_sys->p_layout, 1, i ) );
+            assert( GetDWBE( p_block->p_buffer ) == sample_tag( 1, i ) );
+        }
+        p_sys->i_audio++;
+    }
+
+    block_Release( p_block );
+    return VLC_SUCCESS;
+}
+
+static void EsOutDel( es_out_t *out, es_out_id_t *id )
+{
+    (void) out; (void) id;
+}
+
+static int EsOutControl( es_out_t *out, int i_query, va_list args )
+{
+    es_out_sys_t *p_sys = out->p_sys;
+
+    if( i_query == ES_OUT_GET_ES_STATE )
+    {
+        es_out_id_t *id = va_arg( args, es_out_id_t * );
+        *va_arg( args, bool * ) = id <= &p_sys->es[1];
+    }
+    return VLC_SUCCESS;
+}
+
+/*****************************************************************************
+ * Counting stream
+ *****************************************************************************/
+struct stream_sys_t
+{
+    const buffer_t *p_file;
+    uint64_t i_pos;
+    bool b_fastseek;
+
+    uint64_t i_bytes;
+    unsigned i_reads;
+    unsigned i_seeks;
+};
+
+static ssize_t CountingRead( stream_t *s, void *p_read, size_t i_read )
+{
+    stream_sys_t *p_sys = s->p_sys;
+
+    i_read = __MIN( i_read, p_sys->p_file->i_size - p_sys->i_pos );
+    if( p_read != NULL )
+        memcpy( p_read, p_sys->p_file->p + p_sys->i_pos, i_read );
+    p_sys->i_pos += i_read;
+    p_sys->i_bytes += i_read;
+    p_sys->i_reads++;
+    return i_read;
+}
+
+static int CountingSeek( stream_t *s, uint64_t i_pos )
+{
+    stream_sys_t *p_sys = s->p_sys;
+
+    p_sys->i_pos = __MIN( i_pos, p_sys->p_file->i_size );
+    p_sys->i_seeks++;
+    return VLC_SUCCESS;
+}
+
+static int CountingControl( stream_t *s, int i_query, va_list args )
+{
+    stream_sys_t *p_sys = s->p_sys;
+
+    switch( i_query )
+    {
+        case STREAM_GET_SIZE:
+            *va_arg( args, uint64_t * ) = p_sys->p_file->i_size;
+            return VLC_SUCCESS;
+        case STREAM_CAN_SEEK:
+        case STREAM_CAN_PAUSE:
+        case STREAM_CAN_CONTROL_PACE:
+            *va_arg( args, bool * ) = true;
+            return VLC_SUCCESS;
+        case STREAM_CAN_FASTSEEK:
+            *va_arg( args, bool * ) = p_sys->b_fastseek;
+            return VLC_SUCCESS;
+        case STREAM_GET_PTS_DELAY:
+            *va_arg( args, int64_t * ) = 0;
+            return VLC_SUCCESS;
+        default:
+            return VLC_EGENERIC;
+    }
+}
+
+static void CountingDelete( stream_t *s )
+{
+    (void) s;
+}
+
+/*****************************************************************************
+ * Benchmark
+ *****************************************************************************/
+/* Resident memory, in kB */
+static long rss( void )
+{
+    long i_pages = -1;
+#ifdef __linux__
+    FILE *f = fopen( "/proc/self/statm", "r" );
+    if( f != NULL )
+    {
+        if( fscanf( f, "%*ld %ld", &i_pages ) != 1 )
+            i_pages = -1;
+        fclose( f );
+    }
+#endif
+    return i_pages >= 0 ? i_pages * ( sysconf( _SC_PAGESIZE ) / 1024 ) : -1;
+}
+
+static void test_tables( vlc_object_t *root )
+{
+    layout_t layout = long_layout;
+    buffer_t file = { NULL, 0, 0 };
+    file_build( &file, &layout );
+    printf( "file: %zu kB of moov, %u video and %u x %u audio samples\n",
+            file.i_size / 1024, VIDEO_SAMPLES, AUDIO_TRACKS, AUDIO_SAMPLES );
+
+    es_out_sys_t out_sys;
+    memset( &out_sys, 0, sizeof(out_sys) );
+    out_sys.p_layout = &layout;
+    es_out_t out = {
+        .pf_add = EsOutAdd, .pf_send = EsOutSend, .pf_del = EsOutDel,
+        .pf_control = EsOutControl, .p_sys = &out_sys,
+    };
+
+    stream_t *s = vlc_stream_MemoryNew( root, file.p, file.i_size, true );
+    assert( s != NULL );
+
+    long i_rss = rss();
+    mtime_t t0 = mdate();
+    demux_t *p_demux = demux_New( root, "mp4", "", s, &out );
+    mtime_t t1 = mdate();
+    assert( p_demux != NULL );
+    long i_rss_open = rss();
+
+    printf( "open: %"PRId64" ms", ( t1 - t0 ) / 1000 );
+    if( i_rss >= 0 )
+        printf( ", %ld kB", i_rss_open - i_rss );
+    printf( "\n" );
+    assert( out_sys.i_es == TRACKS );
+
+    /* The selected tracks are only loaded when starting */
+    t0 = mdate();
+    assert( demux_Demux( p_demux ) == VLC_DEMUXER_SUCCESS );
+    printf( "start: %"PRId64" ms", ( mdate() - t0 ) / 1000 );
+    if( i_rss >= 0 )
+        printf( ", %ld kB", rss() - i_rss );
+    printf( "\n" );
+
+    int64_t i_length;
+    assert( demux_Control( p_demux, DEMUX_GET_LENGTH, &i_length ) == 0 );
+    assert( llabs( i_length - (int64_t)HOURS * 3600 * CLOCK_FREQ )
+            < CLOCK_FREQ );
+
+    /* Seek all over the file, and check the frames from there */
+    static const double positions[] = { .5, .1, .9, .25, .75, .0, .999 };
+    mtime_t i_seek = 0;
+
+    for( unsigned i = 0; i < ARRAY_SIZE(positions); i++ )
+    {
+        mtime_t i_target = positions[i] * i_length;
+
+        t0 = mdate();
+        assert( demux_Control( p_demux, DEMUX_SET_TIME, i_target,
+                               true ) == 0 );
+        i_seek += mdate() - t0;
+
+        out_sys.i_video = out_sys.i_audio = 0;
+        while( out_sys.i_video < 100 && out_sys.i_audio < 100 )
+            assert( demux_Demux( p_demux ) == VLC_DEMUXER_SUCCESS );
+
+        /* From the key frame before the target */
+        mtime_t i_gop = (mtime_t)VIDEO_GOP * VIDEO_DELTA * CLOCK_FREQ
+                      / VIDEO_SCALE;
+        assert( out_sys.i_first_video_dts <= i_target );
+        assert( out_sys.i_first_video_dts + i_gop > i_target );
+    }
+    printf( "seek: %"PRId64" us on average\n",
+            i_seek / (mtime_t)ARRAY_SIZE(positions) );
+
+    t0 = mdate();
+    demux_Delete( p_demux );
+    printf( "close: %"PRId64" ms\n", ( mdate() - t0 ) / 1000 );
+
+    free( file.p );
+}
+
+/* Plays a whole interleaved file, checking the samples and counting the
+ * reads and seeks it takes */
+static void test_reads( vlc_object_t *root, bool b_fastseek )
+{
+    layout_t layout = {
+        INTERLEAVED_SECONDS, { 15, 24 }, true, { NULL },
+    };
+    buffer_t file = { NULL, 0, 0 };
+    file_build( &file, &layout );
+
+    es_out_sys_t out_sys;
+    memset( &out_sys, 0, sizeof(out_sys) );
+    out_sys.p_layout = &layout;
+    es_out_t out = {
+        .pf_add = EsOutAdd, .pf_send = EsOutSend, .pf_del = EsOutDel,
+        .pf_control = EsOutControl, .p_sys = &out_sys,
+    };
+
+    stream_sys_t stream_sys = { .p_file = &file, .b_fastseek = b_fastseek };
+    stream_t *s = vlc_stream_CommonNew( root, CountingDelete );
+    assert( s != NULL );
+    s->p_sys = &stream_sys;
+    s->pf_read = CountingRead;
+    s->pf_seek = CountingSeek;
+    s->pf_control = CountingControl;
+
+    demux_t *p_demux = demux_New( root, "mp4", "", s, &out );
+    assert( p_demux != NULL );
+
+    /* Only count the samples reads */
+    stream_sys.i_bytes = stream_sys.i_reads = stream_sys.i_seeks = 0;
+    uint64_t i_sample_bytes = 0;
+    for( unsigned i = 0; i < track_samples( &layout, 0 ); i++ )
+        i_sample_bytes += sample_size( &layout, 0, i );
+    for( unsigned i = 0; i < track_samples( &layout, 1 ); i++ )
+        i_sample_bytes += sample_size( &layout, 1, i );
+
+    mtime_t t0 = mdate();
+    int i_ret;
+    while( ( i_ret = demux_Demux( p_demux ) ) == VLC_DEMUXER_SUCCESS );
+    mtime_t i_time = mdate() - t0;
+    assert( i_ret == VLC_DEMUXER_EOF );
+    assert( out_sys.i_video == track_samples( &layout, 0 ) );
+    assert( out_sys.i_audio == track_samples( &layout, 1 ) );
+
+    printf( "reads (%s seek): %u samples in %u reads and %u seeks, "
+            "%"PRIu64" kB read of %zu kB for %"PRIu64" kB of samples, "
+            "%"PRId64" ms\n",
+            b_fastseek ? "fast" : "slow", out_sys.i_video + out_sys.i_audio,
+            stream_sys.i_reads, stream_sys.i_seeks, stream_sys.i_bytes / 1024,
+            file.i_size / 1024, i_sample_bytes / 1024, i_time / 1000 );
+    assert( stream_sys.i_reads * 10 < out_sys.i_video + out_sys.i_audio );
+    assert( stream_sys.i_bytes < file.i_size );
+
+    demux_Delete( p_demux );
+    for( unsigned t = 0; t < TRACKS; t++ )
+        free( layout.pi_offset[t] );
+    free( file.p );
+}
+
+int main( void )
+{
+    setenv( "VLC_PLUGIN_PATH", "../modules", 1 );
+    alarm( 60 );
+
+    libvlc_instance_t *p_libvlc = libvlc_new( 0, NULL );
+    assert( p_libvlc != NULL );
+    vlc_object_t *root = VLC_OBJECT( p_libvlc->p_libvlc_int );
+
+    test_tables( root );
+    test_reads( root, false );
+    test_reads( root, true );
+
+    libvlc_release( p_libvlc );
+    return 0;
+}
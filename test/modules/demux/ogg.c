@@ -0,0 +1,480 @@
+/*****************************************************************************
+ * ogg.c: Ogg demuxer seek index test and benchmark
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+#include <vlc/vlc.h>
+
+#include "../../../lib/libvlc_internal.h"
+
+#include <vlc_common.h>
+#include <vlc_demux.h>
+#include <vlc_es_out.h>
+#include <vlc_stream.h>
+
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#undef NDEBUG
+#include <assert.h>
+
+/* An hour of mono Opus, one 20 ms packet per segment and one second per
+ * page */
+#define MINUTES         60
+#define PACKET_SAMPLES  960
+#define PACKET_SIZE     60
+#define PAGE_PACKETS    50
+#define PRE_SKIP        312
+#define PACKETS         (MINUTES * 60 * 48000 / PACKET_SAMPLES)
+#define DURATION        ((mtime_t)MINUTES * 60 * CLOCK_FREQ)
+#define SERIAL          0x1234
+
+static mtime_t packet_time( unsigned i )
+{
+    return (mtime_t)i * PACKET_SAMPLES * CLOCK_FREQ / 48000;
+}
+
+/*****************************************************************************
+ * Ogg writer
+ *****************************************************************************/
+typedef struct
+{
+    uint8_t *p;
+    size_t i_size;
+    size_t i_alloc;
+    uint32_t i_pageno;
+} buffer_t;
+
+static uint32_t crc_table[256];
+
+static void crc_init( void )
+{
+    for( uint32_t i = 0; i < 256; i++ )
+    {
+        uint32_t r = i << 24;
+        for( unsigned j = 0; j < 8; j++ )
+            r = ( r & 0x80000000 ) ? ( r << 1 ) ^ 0x04c11db7 : r << 1;
+        crc_table[i] = r;
+    }
+}
+
+static void page_put( buffer_t *b, uint8_t i_flags, int64_t i_granule,
+                      const uint8_t *p_data, const uint8_t *pi_lacing,
+                      unsigned i_segments )
+{
+    size_t i_body = 0;
+    for( unsigned i = 0; i < i_segments; i++ )
+        i_body += pi_lacing[i];
+
+    size_t i_page = 27 + i_segments + i_body;
+    if( b->i_size + i_page > b->i_alloc )
+    {
+        b->i_alloc = __MAX( 2 * b->i_alloc, b->i_size + i_page );
+        b->p = realloc( b->p, b->i_alloc );
+        assert( b->p != NULL );
+    }
+
+    uint8_t *p = &b->p[b->i_size];
+    memcpy( p, "OggS", 4 );
+    p[4] = 0;
+    p[5] = i_flags;
+    SetQWLE( &p[6], i_granule );
+    SetDWLE( &p[14], SERIAL );
+    SetDWLE( &p[18], b->i_pageno++ );
+    SetDWLE( &p[22], 0 );
+    p[26] = i_segments;
+    memcpy( &p[27], pi_lacing, i_segments );
+    memcpy( &p[27 + i_segments], p_data, i_body );
+
+    uint32_t i_crc = 0;
+    for( size_t i = 0; i < i_page; i++ )
+        i_crc = ( i_crc << 8 ) ^ crc_table[( i_crc >> 24 ) ^ p[i]];
+    SetDWLE( &p[22], i_crc );
+
+    b->i_size += i_page;
+}
+
+static void file_build( buffer_t *b )
+{
+    static const uint8_t head[19] = {
+        'O', 'p', 'u', 's', 'H', 'e', 'a', 'd', 1, 1,
+        PRE_SKIP & 0xff, PRE_SKIP >> 8, 0x80, 0xbb, 0, 0, 0, 0, 0,
+    };
+    static const uint8_t tags[16] = {
+        'O', 'p', 'u', 's', 'T', 'a', 'g', 's', 4, 0, 0, 0,
+        't', 'e', 's', 't',
+    };
+    uint8_t lacing[PAGE_PACKETS], i_lacing = sizeof(head);
+    uint8_t data[PAGE_PACKETS * PACKET_SIZE];
+
+    memset( b, 0, sizeof(*b) );
+    crc_init();
+
+    page_put( b, 0x02, 0, head, &i_lacing, 1 );
+    i_lacing = sizeof(tags) + 4;
+    uint8_t tags_data[sizeof(tags) + 4] = { 0 };
+    memcpy( tags_data, tags, sizeof(tags) );
+    page_put( b, 0x00, 0, tags_data, &i_lacing, 1 );
+
+    /* CELT fullband 20 ms frames, numbered */
+    memset( lacing, PACKET_SIZE, sizeof(lacing) );
+    for( unsigned i = 0; i < PACKETS; i += PAGE_PACKETS )
+    {
+        memset( data, 0, sizeof(data) );
+        for( unsigned j = 0; j < PAGE_PACKETS; j++ )
+        {
+            data[j * PACKET_SIZE] = 0xf8;
+            SetDWLE( &data[j * PACKET_SIZE + 1], i + j );
+        }
+        page_put( b, i + PAGE_PACKETS >= PACKETS ? 0x04 : 0x00,
+                  PRE_SKIP + (int64_t)( i + PAGE_PACKETS ) * PACKET_SAMPLES,
+                  data, lacing, PAGE_PACKETS );
+    }
+}
+
+/*****************************************************************************
+ * Counting stream
+ *****************************************************************************/
+struct stream_sys_t
+{
+    const buffer_t *p_file;
+    uint64_t i_pos;
+
+    uint64_t i_bytes;
+    unsigned i_seeks;
+};
+
+static ssize_t CountingRead( stream_t *s, void *p_read, size_t i_read )
+{
+    stream_sys_t *p_sys = s->p_sys;
+
+    i_read = __MIN( i_read, p_sys->p_file->i_size - p_sys->i_pos );
+    if( p_read != NULL )
+        memcpy( p_read, p_sys->p_file->p + p_sys->i_pos, i_read );
+    p_sys->i_pos += i_read;
+    p_sys->i_bytes += i_read;
+    return i_read;
+}
+
+static int CountingSeek( stream_t *s, uint64_t i_pos )
+{
+    stream_sys_t *p_sys = s->p_sys;
+
+    p_sys->i_pos = __MIN( i_pos, p_sys->p_file->i_size );
+    p_sys->i_seeks++;
+    return VLC_SUCCESS;
+}
+
+static int CountingControl( stream_t *s, int i_query, va_list args )
+{
+    stream_sys_t *p_sys = s->p_sys;
+
+    switch( i_query )
+    {
+        case STREAM_GET_SIZE:
+            *va_arg( args, uint64_t * ) = p_sys->p_file->i_size;
+            return VLC_SUCCESS;
+        case STREAM_CAN_SEEK:
+        case STREAM_CAN_FASTSEEK:
+        case STREAM_CAN_PAUSE:
+        case STREAM_CAN_CONTROL_PACE:
+            *va_arg( args, bool * ) = true;
+            return VLC_SUCCESS;
+        case STREAM_GET_PTS_DELAY:
+            *va_arg( args, int64_t * ) = 0;
+            return VLC_SUCCESS;
+        default:
+            return VLC_EGENERIC;
+    }
+}
+
+static void CountingDelete( stream_t *s )
+{
+    (void) s;
+}
+
+/*****************************************************************************
+ * Elementary streams output
+ *****************************************************************************/
+struct es_out_id_t
+{
+    int i_cat;
+};
+
+struct es_out_sys_t
+{
+    es_out_id_t es;
+    unsigned i_es;
+    unsigned i_packets;
+    unsigned i_first_packet;
+};
+
+static es_out_id_t *EsOutAdd( es_out_t *out, const es_format_t *fmt )
+{
+    es_out_sys_t *p_sys = out->p_sys;
+
+    assert( p_sys->i_es++ == 0 );
+    p_sys->es.i_cat = fmt->i_cat;
+    return &p_sys->es;
+}
+
+static int EsOutSend( es_out_t *out, es_out_id_t *id, block_t *p_block )
+{
+    es_out_sys_t *p_sys = out->p_sys;
+
+    assert( id->i_cat == AUDIO_ES );
+    if( p_block->i_buffer == PACKET_SIZE && p_block->p_buffer[0] == 0xf8 &&
+        p_sys->i_packets++ == 0 )
+        p_sys->i_first_packet = GetDWLE( &p_block->p_buffer[1] );
+
+    block_Release( p_block );
+    return VLC_SUCCESS;
+}
+
+static void EsOutDel( es_out_t *out, es_out_id_t *id )
+{
+    (void) out; (void) id;
+}
+
+static int EsOutControl( es_out_t *out, int i_query, va_list args )
+{
+    (void) out;
+
+    if( i_query == ES_OUT_GET_ES_STATE )
+    {
+        (void) va_arg( args, es_out_id_t * );
+        *va_arg( args, bool * ) = true;
+    }
+    return VLC_SUCCESS;
+}
+
+/*****************************************************************************
+ * Test
+ *****************************************************************************/
+typedef struct
+{
+    demux_t *p_demux;
+    es_out_t out;
+    es_out_sys_t out_sys;
+    stream_sys_t stream_sys;
+} player_t;
+
+/* Plays a few packets */
+static void play( player_t *p, unsigned i_packets )
+{
+    p->out_sys.i_packets = 0;
+    while( p->out_sys.i_packets < i_packets )
+        assert( demux_Demux( p->p_demux ) == VLC_DEMUXER_SUCCESS );
+}
+
+static bool player_open( player_t *p, vlc_object_t *root, const buffer_t *file )
+{
+    memset( &p->out_sys, 0, sizeof(p->out_sys) );
+    p->out = (es_out_t) {
+        .pf_add = EsOutAdd, .pf_send = EsOutSend, .pf_del = EsOutDel,
+        .pf_control = EsOutControl, .p_sys = &p->out_sys,
+    };
+    p->stream_sys = (stream_sys_t) { .p_file = file };
+
+    stream_t *s = vlc_stream_CommonNew( root, CountingDelete );
+    assert( s != NULL );
+    s->p_sys = &p->stream_sys;
+    s->pf_read = CountingRead;
+    s->pf_seek = CountingSeek;
+    s->pf_control = CountingControl;
+    /* Only names the cached index */
+    s->psz_url = strdup( "file:///vlc-test-ogg-seek.opus" );
+    assert( s->psz_url != NULL );
+
+    p->p_demux = demux_New( root, "ogg", "", s, &p->out );
+    if( p->p_demux == NULL )
+    {
+        vlc_stream_Delete( s );
+        return false;
+    }
+
+    int64_t i_length;
+    assert( demux_Control( p->p_demux, DEMUX_GET_LENGTH, &i_length ) == 0 );
+    assert( llabs( i_length - DURATION ) <= CLOCK_FREQ );
+
+    /* The elementary stream is only created, and seeking only allowed,
+     * once the headers are demuxed */
+    play( p, 1 );
+    return true;
+}
+
+static const double targets[] = { .5, .1, .9, .25, .75, .33, .66, .95 };
+
+/* Seeks all over the file, checks the packets from there, and returns the
+ * number of seeks and bytes read to find the targets */
+static void seeks( player_t *p, const char *psz_name, unsigned *pi_seeks )
+{
+    uint64_t i_bytes = 0;
+    mtime_t i_time = 0;
+
+    *pi_seeks = 0;
+    for( unsigned i = 0; i < ARRAY_SIZE(targets); i++ )
+    {
+        mtime_t i_target = targets[i] * DURATION;
+
+        p->stream_sys.i_seeks = p->stream_sys.i_bytes = 0;
+        mtime_t t0 = mdate();
+        assert( demux_Control( p->p_demux, DEMUX_SET_TIME, i_target,
+                               true ) == 0 );
+        i_time += mdate() - t0;
+        *pi_seeks += p->stream_sys.i_seeks;
+        i_bytes += p->stream_sys.i_bytes;
+
+        /* From the page before the target */
+        play( p, 10 );
+        mtime_t i_first = packet_time( p->out_sys.i_first_packet );
+        assert( i_first <= i_target );
+        assert( i_first + 3 * PAGE_PACKETS * packet_time( 1 ) > i_target );
+    }
+
+    printf( "seek (%s): %.1f seeks and %"PRIu64" kB read, %"PRId64" us "
+            "on average\n", psz_name,
+            (double)*pi_seeks / ARRAY_SIZE(targets),
+            i_bytes / 1024 / ARRAY_SIZE(targets),
+            i_time / (mtime_t)ARRAY_SIZE(targets) );
+}
+
+/* Saving replaces the index file, hence its inode */
+static ino_t cache_inode( const char *psz_cache )
+{
+    char *psz_dir;
+    ino_t i_ino = 0;
+    assert( asprintf( &psz_dir, "%s/vlc/ogg", psz_cache ) != -1 );
+
+    DIR *dir = opendir( psz_dir );
+    assert( dir != NULL );
+    struct dirent *ent;
+    while( ( ent = readdir( dir ) ) != NULL )
+    {
+        char *psz_file;
+        struct stat st;
+        if( ent->d_name[0] == '.' )
+            continue;
+        assert( i_ino == 0 );
+        assert( asprintf( &psz_file, "%s/%s", psz_dir, ent->d_name ) != -1 );
+        assert( stat( psz_file, &st ) == 0 );
+        i_ino = st.st_ino;
+        free( psz_file );
+    }
+    closedir( dir );
+    free( psz_dir );
+    assert( i_ino != 0 );
+    return i_ino;
+}
+
+static void remove_cache( const char *psz_cache )
+{
+    char *psz_dir;
+    assert( asprintf( &psz_dir, "%s/vlc/ogg", psz_cache ) != -1 );
+
+    DIR *dir = opendir( psz_dir );
+    if( dir != NULL )
+    {
+        struct dirent *ent;
+        while( ( ent = readdir( dir ) ) != NULL )
+        {
+            char *psz_file;
+            if( ent->d_name[0] == '.' )
+                continue;
+            assert( asprintf( &psz_file, "%s/%s", psz_dir,
+                              ent->d_name ) != -1 );
+            unlink( psz_file );
+            free( psz_file );
+        }
+        closedir( dir );
+    }
+    rmdir( psz_dir );
+    free( psz_dir );
+
+    assert( asprintf( &psz_dir, "%s/vlc", psz_cache ) != -1 );
+    rmdir( psz_dir );
+    free( psz_dir );
+    rmdir( psz_cache );
+}
+
+int main( void )
+{
+    const char *psz_tmp = getenv( "TMPDIR" );
+    char *psz_cache;
+    assert( asprintf( &psz_cache, "%s/vlc-test-ogg-cache-XXXXXX",
+                      psz_tmp ? psz_tmp : "/tmp" ) != -1 );
+    assert( mkdtemp( psz_cache ) != NULL );
+
+    setenv( "VLC_PLUGIN_PATH", "../modules", 1 );
+    setenv( "XDG_CACHE_HOME", psz_cache, 1 );
+    alarm( 60 );
+
+    buffer_t file;
+    file_build( &file );
+
+    libvlc_instance_t *p_libvlc = libvlc_new( 0, NULL );
+    assert( p_libvlc != NULL );
+    vlc_object_t *root = VLC_OBJECT( p_libvlc->p_libvlc_int );
+    var_Create( root, "ogg-index-cache", VLC_VAR_BOOL );
+    var_SetBool( root, "ogg-index-cache", true );
+
+    player_t p;
+    unsigned i_bisect, i_indexed, i_cached;
+
+    /* Searching in a file never played */
+    if( !player_open( &p, root, &file ) )
+    {
+        /* Built without the Ogg demuxer */
+        libvlc_release( p_libvlc );
+        remove_cache( psz_cache );
+        free( psz_cache );
+        free( file.p );
+        return 77;
+    }
+    seeks( &p, "bisection", &i_bisect );
+
+    /* Playing it through indexes all its pages */
+    assert( demux_Control( p.p_demux, DEMUX_SET_TIME, (int64_t)0,
+                           true ) == 0 );
+    play( &p, PACKETS - 2 * PAGE_PACKETS );
+
+    seeks( &p, "indexed", &i_indexed );
+    demux_Delete( p.p_demux );
+
+    /* Reusing the index saved on close, which is not saved again as long
+     * as no pages are added */
+    ino_t i_ino = cache_inode( psz_cache );
+    assert( player_open( &p, root, &file ) );
+    seeks( &p, "cached", &i_cached );
+    demux_Delete( p.p_demux );
+    assert( cache_inode( psz_cache ) == i_ino );
+
+    assert( i_indexed <= ARRAY_SIZE(targets) && i_indexed < i_bisect );
+    assert( i_cached <= ARRAY_SIZE(targets) );
+
+    libvlc_release( p_libvlc );
+
+    remove_cache( psz_cache );
+    free( psz_cache );
+    free( file.p );
+    return 0;
+}
@@ -0,0 +1,583 @@
+/*****************************************************************************
+ * annexb.c: H.264/HEVC packetizers access unit assembly test and benchmark
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+#include <vlc/vlc.h>
+
+#include "../../../lib/libvlc_internal.h"
+
+#include <vlc_common.h>
+#include <vlc_modules.h>
+#include <vlc_codec.h>
+#include <vlc_block.h>
+#include <vlc_bits.h>
+
+#include <stdio.h>
+#include <unistd.h>
+
+#undef NDEBUG
+#include <assert.h>
+
+/* Five seconds of 2160p50 at about 50 Mbit/s, one keyframe per second */
+#define WIDTH       3840
+#define HEIGHT      2160
+#define FRAMES      250
+#define GOP         50
+#define I_SIZE      (512 * 1024)
+#define P_SIZE      (112 * 1024)
+#define SLICES      4
+#define CHUNK       65536   /* as read by the ES demuxer */
+#define SMALL_CHUNK 1316    /* as carried by TS packets over UDP */
+#define RUNS        5
+
+/*****************************************************************************
+ * Elementary stream writer
+ *****************************************************************************/
+typedef struct
+{
+    uint8_t *p;
+    size_t i_size;
+    size_t i_alloc;
+    size_t pi_au[FRAMES + 1];   /* offset of each access unit */
+} buffer_t;
+
+static uint32_t i_seed = 0x12345678;
+
+static uint8_t random_byte( void )
+{
+    i_seed = i_seed * 1664525 + 1013904223;
+    return i_seed >> 24;
+}
+
+static void buffer_reserve( buffer_t *b, size_t i_extra )
+{
+    if( b->i_size + i_extra <= b->i_alloc )
+        return;
+    b->i_alloc = ( b->i_size + i_extra ) * 2;
+    b->p = realloc( b->p, b->i_alloc );
+    assert( b->p != NULL );
+}
+
+/* Writes a NAL unit with emulation prevention, returns its size */
+static size_t nal_write( uint8_t *p_buf, const uint8_t *p_hdr, size_t i_hdr,
+                         const uint8_t *p_rbsp, size_t i_rbsp )
+{
+    uint8_t *p = p_buf;
+    unsigned i_zeros = 0;
+
+    memcpy( p, p_hdr, i_hdr );
+    p += i_hdr;
+    for( size_t i = 0; i < i_rbsp; i++ )
+    {
+        if( i_zeros >= 2 && p_rbsp[i] <= 3 )
+        {
+            *p++ = 3;
+            i_zeros = 0;
+        }
+        *p++ = p_rbsp[i];
+        i_zeros = p_rbsp[i] ? 0 : i_zeros + 1;
+    }
+    return p - p_buf;
+}
+
+/* Appends a NAL unit after a 4 bytes start code, or length prefix */
+static void nal_put( buffer_t *b, bool b_annexb,
+                     const uint8_t *p_hdr, size_t i_hdr,
+                     const uint8_t *p_rbsp, size_t i_rbsp )
+{
+    buffer_reserve( b, 4 + i_hdr + i_rbsp * 3 / 2 + 1 );
+
+    uint8_t *p = &b->p[b->i_size];
+    size_t i_nal = nal_write( p + 4, p_hdr, i_hdr, p_rbsp, i_rbsp );
+
+    SetDWBE( p, b_annexb ? 1 : i_nal );
+    b->i_size += 4 + i_nal;
+}
+
+static void write_ue( bs_t *s, uint32_t i_val )
+{
+    unsigned i_bits = 0;
+
+    for( uint32_t i = i_val + 1; i > 1; i >>= 1 )
+        i_bits++;
+    bs_write( s, i_bits, 0 );
+    bs_write( s, i_bits + 1, i_val + 1 );
+}
+
+static size_t write_trailing( bs_t *s )
+{
+    bs_write( s, 1, 1 );
+    bs_align_0( s );
+    return s->p - s->p_start;
+}
+
+/* Fills a slice up to its size once its header is written */
+static size_t write_slice_data( bs_t *s, size_t i_size )
+{
+    bs_write( s, 1, 1 );
+    bs_align_0( s );
+    while( (size_t)(s->p - s->p_start) < i_size - 1 )
+        *s->p++ = random_byte();
+    *s->p++ = 0x80;
+    return s->p - s->p_start;
+}
+
+static size_t frame_size( unsigned i_frame )
+{
+    return ( i_frame % GOP ) ? P_SIZE : I_SIZE;
+}
+
+/*****************************************************************************
+ * H.264: Main profile, level 5.1, POC type 2, AUD on every picture
+ *****************************************************************************/
+static size_t h264_sps( uint8_t *p_buf, size_t i_buf )
+{
+    bs_t s;
+    bs_write_init( &s, p_buf, i_buf );
+    bs_write( &s, 8, 77 );      /* profile_idc */
+    bs_write( &s, 8, 0 );       /* constraint flags */
+    bs_write( &s, 8, 51 );      /* level_idc */
+    write_ue( &s, 0 );          /* seq_parameter_set_id */
+    write_ue( &s, 0 );          /* log2_max_frame_num_minus4 */
+    write_ue( &s, 2 );          /* pic_order_cnt_type */
+    write_ue( &s, 1 );          /* max_num_ref_frames */
+    bs_write( &s, 1, 0 );       /* gaps_in_frame_num_value_allowed_flag */
+    write_ue( &s, WIDTH / 16 - 1 );
+    write_ue( &s, HEIGHT / 16 - 1 );
+    bs_write( &s, 1, 1 );       /* frame_mbs_only_flag */
+    bs_write( &s, 1, 1 );       /* direct_8x8_inference_flag */
+    bs_write( &s, 1, 0 );       /* frame_cropping_flag */
+    bs_write( &s, 1, 0 );       /* vui_parameters_present_flag */
+    return write_trailing( &s );
+}
+
+static size_t h264_pps( uint8_t *p_buf, size_t i_buf )
+{
+    bs_t s;
+    bs_write_init( &s, p_buf, i_buf );
+    write_ue( &s, 0 );          /* pic_parameter_set_id */
+    write_ue( &s, 0 );          /* seq_parameter_set_id */
+    bs_write( &s, 1, 0 );       /* entropy_coding_mode_flag */
+    bs_write( &s, 1, 0 );       /* bottom_field_pic_order_in_frame_present */
+    write_ue( &s, 0 );          /* num_slice_groups_minus1 */
+    write_ue( &s, 0 );          /* num_ref_idx_l0_default_active_minus1 */
+    write_ue( &s, 0 );          /* num_ref_idx_l1_default_active_minus1 */
+    bs_write( &s, 3, 0 );       /* weighted_pred_flag, weighted_bipred_idc */
+    write_ue( &s, 0 );          /* pic_init_qp_minus26 */
+    write_ue( &s, 0 );          /* pic_init_qs_minus26 */
+    write_ue( &s, 0 );          /* chroma_qp_index_offset */
+    bs_write( &s, 3, 4 );       /* deblocking_filter_control_present_flag */
+    return write_trailing( &s );
+}
+
+/* Writes the stream as Annex B, and as avcC samples and extradata */
+static void h264_build( buffer_t *p_annexb, buffer_t *p_avc,
+                        uint8_t **pp_extra, size_t *pi_extra )
+{
+    static const uint8_t aud[1] = { 0xF0 };
+    const unsigned i_mbs = ( WIDTH / 16 ) * ( HEIGHT / 16 );
+    uint8_t sps[32], pps[32];
+    size_t i_sps = h264_sps( sps, sizeof(sps) );
+    size_t i_pps = h264_pps( pps, sizeof(pps) );
+    uint8_t *p_slice = malloc( I_SIZE );
+    assert( p_slice != NULL );
+
+    /* avcC with the parameter sets, also repeated in band */
+    uint8_t *p_extra = malloc( 11 + 2 * ( i_sps + i_pps ) );
+    assert( p_extra != NULL );
+    memcpy( p_extra, (const uint8_t[]){ 1, 77, 0, 51, 0xFF, 0xE1 }, 6 );
+    size_t i_extra = 6;
+    size_t i_nal = nal_write( &p_extra[i_extra + 2],
+                              (const uint8_t[]){ 0x67 }, 1, sps, i_sps );
+    SetWBE( &p_extra[i_extra], i_nal );
+    i_extra += 2 + i_nal;
+    p_extra[i_extra++] = 1;
+    i_nal = nal_write( &p_extra[i_extra + 2],
+                       (const uint8_t[]){ 0x68 }, 1, pps, i_pps );
+    SetWBE( &p_extra[i_extra], i_nal );
+    i_extra += 2 + i_nal;
+    *pp_extra = p_extra;
+    *pi_extra = i_extra;
+
+    unsigned i_frame_num = 0;
+    for( unsigned i = 0; i < FRAMES; i++ )
+    {
+        const bool b_idr = ( i % GOP ) == 0;
+
+        p_annexb->pi_au[i] = p_annexb->i_size;
+        p_avc->pi_au[i] = p_avc->i_size;
+        for( unsigned j = 0; j < 2; j++ )
+        {
+            buffer_t *b = j ? p_avc : p_annexb;
+
+            nal_put( b, !j, (const uint8_t[]){ 0x09 }, 1, aud, sizeof(aud) );
+            if( b_idr )
+            {
+                nal_put( b, !j, (const uint8_t[]){ 0x67 }, 1, sps, i_sps );
+                nal_put( b, !j, (const uint8_t[]){ 0x68 }, 1, pps, i_pps );
+            }
+        }
+        if( b_idr )
+            i_frame_num = 0;
+
+        for( unsigned j = 0; j < SLICES; j++ )
+        {
+            bs_t s;
+            bs_write_init( &s, p_slice, I_SIZE );
+            write_ue( &s, j * i_mbs / SLICES ); /* first_mb_in_slice */
+            write_ue( &s, b_idr ? 7 : 5 );      /* slice_type: I or P */
+            write_ue( &s, 0 );                  /* pic_parameter_set_id */
+            bs_write( &s, 4, i_frame_num );     /* frame_num */
+            if( b_idr )
+                write_ue( &s, ( i / GOP ) & 1 ); /* idr_pic_id */
+            size_t i_slice = write_slice_data( &s, frame_size( i ) / SLICES );
+
+            const uint8_t hdr = b_idr ? 0x65 : 0x41;
+            nal_put( p_annexb, true, &hdr, 1, p_slice, i_slice );
+            nal_put( p_avc, false, &hdr, 1, p_slice, i_slice );
+        }
+        i_frame_num = ( i_frame_num + 1 ) % 16;
+    }
+    p_annexb->pi_au[FRAMES] = p_annexb->i_size;
+    p_avc->pi_au[FRAMES] = p_avc->i_size;
+    free( p_slice );
+}
+
+/*****************************************************************************
+ * HEVC: Main profile, level 5.1, 64x64 CTB, AUD and suffix SEI on every
+ * picture
+ *****************************************************************************/
+static void hevc_ptl( bs_t *s )
+{
+    bs_write( s, 2, 0 );            /* general_profile_space */
+    bs_write( s, 1, 0 );            /* general_tier_flag */
+    bs_write( s, 5, 1 );            /* general_profile_idc */
+    bs_write( s, 32, 0x60000000 );  /* general_profile_compatibility_flags */
+    bs_write( s, 4, 9 );            /* progressive, frame only */
+    bs_write( s, 32, 0 );           /* general_reserved_zero_43bits */
+    bs_write( s, 11, 0 );
+    bs_write( s, 1, 0 );            /* general_inbld_flag */
+    bs_write( s, 8, 153 );          /* general_level_idc */
+}
+
+static size_t hevc_vps( uint8_t *p_buf, size_t i_buf )
+{
+    bs_t s;
+    bs_write_init( &s, p_buf, i_buf );
+    bs_write( &s, 4, 0 );       /* vps_video_parameter_set_id */
+    bs_write( &s, 2, 3 );       /* vps_base_layer_internal/available_flag */
+    bs_write( &s, 6, 0 );       /* vps_max_layers_minus1 */
+    bs_write( &s, 3, 0 );       /* vps_max_sub_layers_minus1 */
+    bs_write( &s, 1, 1 );       /* vps_temporal_id_nesting_flag */
+    bs_write( &s, 16, 0xFFFF ); /* vps_reserved_0xffff_16bits */
+    hevc_ptl( &s );
+    bs_write( &s, 1, 1 );       /* vps_sub_layer_ordering_info_present_flag */
+    write_ue( &s, 1 );          /* vps_max_dec_pic_buffering_minus1 */
+    write_ue( &s, 0 );          /* vps_max_num_reorder_pics */
+    write_ue( &s, 0 );          /* vps_max_latency_increase_plus1 */
+    bs_write( &s, 6, 0 );       /* vps_max_layer_id */
+    write_ue( &s, 0 );          /* vps_num_layer_sets_minus1 */
+    bs_write( &s, 1, 0 );       /* vps_timing_info_present_flag */
+    bs_write( &s, 1, 0 );       /* vps_extension_flag */
+    return write_trailing( &s );
+}
+
+static size_t hevc_sps( uint8_t *p_buf, size_t i_buf )
+{
+    bs_t s;
+    bs_write_init( &s, p_buf, i_buf );
+    bs_write( &s, 4, 0 );       /* sps_video_parameter_set_id */
+    bs_write( &s, 3, 0 );       /* sps_max_sub_layers_minus1 */
+    bs_write( &s, 1, 1 );       /* sps_temporal_id_nesting_flag */
+    hevc_ptl( &s );
+    write_ue( &s, 0 );          /* sps_seq_parameter_set_id */
+    write_ue( &s, 1 );          /* chroma_format_idc */
+    write_ue( &s, WIDTH );
+    write_ue( &s, HEIGHT );
+    bs_write( &s, 1, 0 );       /* conformance_window_flag */
+    write_ue( &s, 0 );          /* bit_depth_luma_minus8 */
+    write_ue( &s, 0 );          /* bit_depth_chroma_minus8 */
+    write_ue( &s, 4 );          /* log2_max_pic_order_cnt_lsb_minus4 */
+    bs_write( &s, 1, 1 );       /* sps_sub_layer_ordering_info_present_flag */
+    write_ue( &s, 1 );          /* sps_max_dec_pic_buffering_minus1 */
+    write_ue( &s, 0 );          /* sps_max_num_reorder_pics */
+    write_ue( &s, 0 );          /* sps_max_latency_increase_plus1 */
+    write_ue( &s, 0 );          /* log2_min_luma_coding_block_size_minus3 */
+    write_ue( &s, 3 );          /* log2_diff_max_min_luma_coding_block_size */
+    write_ue( &s, 0 );          /* log2_min_luma_transform_block_size_minus2 */
+    write_ue( &s, 3 );          /* log2_diff_max_min_luma_transform_block_size */
+    write_ue( &s, 0 );          /* max_transform_hierarchy_depth_inter */
+    write_ue( &s, 0 );          /* max_transform_hierarchy_depth_intra */
+    bs_write( &s, 1, 0 );       /* scaling_list_enabled_flag */
+    bs_write( &s, 2, 3 );       /* amp, sample_adaptive_offset */
+    bs_write( &s, 1, 0 );       /* pcm_enabled_flag */
+    write_ue( &s, 0 );          /* num_short_term_ref_pic_sets */
+    bs_write( &s, 1, 0 );       /* long_term_ref_pics_present_flag */
+    bs_write( &s, 2, 3 );       /* temporal_mvp, strong_intra_smoothing */
+    bs_write( &s, 1, 0 );       /* vui_parameters_present_flag */
+    bs_write( &s, 1, 0 );       /* sps_extension_present_flag */
+    return write_trailing( &s );
+}
+
+static size_t hevc_pps( uint8_t *p_buf, size_t i_buf )
+{
+    bs_t s;
+    bs_write_init( &s, p_buf, i_buf );
+    write_ue( &s, 0 );          /* pps_pic_parameter_set_id */
+    write_ue( &s, 0 );          /* pps_seq_parameter_set_id */
+    bs_write( &s, 2, 0 );       /* dependent_slice_segments, output_flag */
+    bs_write( &s, 3, 0 );       /* num_extra_slice_header_bits */
+    bs_write( &s, 2, 0 );       /* sign_data_hiding, cabac_init_present */
+    write_ue( &s, 0 );          /* num_ref_idx_l0_default_active_minus1 */
+    write_ue( &s, 0 );          /* num_ref_idx_l1_default_active_minus1 */
+    write_ue( &s, 0 );          /* init_qp_minus26 */
+    bs_write( &s, 3, 0 );       /* constrained_intra_pred, transform_skip,
+                                 * cu_qp_delta_enabled */
+    write_ue( &s, 0 );          /* pps_cb_qp_offset */
+    write_ue( &s, 0 );          /* pps_cr_qp_offset */
+    bs_write( &s, 6, 0 );       /* ..., tiles, entropy_coding_sync */
+    bs_write( &s, 1, 1 );       /* pps_loop_filter_across_slices_enabled */
+    bs_write( &s, 1, 0 );       /* deblocking_filter_control_present_flag */
+    bs_write( &s, 2, 0 );       /* scaling_list_data, lists_modification */
+    write_ue( &s, 0 );          /* log2_parallel_merge_level_minus2 */
+    bs_write( &s, 1, 0 );       /* slice_segment_header_extension_present */
+    bs_write( &s, 1, 0 );       /* pps_extension_present_flag */
+    return write_trailing( &s );
+}
+
+static void hevc_build( buffer_t *p_annexb )
+{
+    static const uint8_t aud[1] = { 0x50 };
+    const unsigned i_ctbs = ( ( WIDTH + 63 ) / 64 ) * ( ( HEIGHT + 63 ) / 64 );
+    unsigned i_address_bits = 0;
+    while( ( 1U << i_address_bits ) < i_ctbs )
+        i_address_bits++;
+
+    uint8_t vps[32], sps[64], pps[32];
+    size_t i_vps = hevc_vps( vps, sizeof(vps) );
+    size_t i_sps = hevc_sps( sps, sizeof(sps) );
+    size_t i_pps = hevc_pps( pps, sizeof(pps) );
+    uint8_t *p_slice = malloc( I_SIZE );
+    assert( p_slice != NULL );
+
+    for( unsigned i = 0; i < FRAMES; i++ )
+    {
+        const bool b_idr = ( i % GOP ) == 0;
+
+        p_annexb->pi_au[i] = p_annexb->i_size;
+        nal_put( p_annexb, true, (const uint8_t[]){ 0x46, 0x01 }, 2,
+                 aud, sizeof(aud) );
+        if( b_idr )
+        {
+            nal_put( p_annexb, true, (const uint8_t[]){ 0x40, 0x01 }, 2,
+                     vps, i_vps );
+            nal_put( p_annexb, true, (const uint8_t[]){ 0x42, 0x01 }, 2,
+                     sps, i_sps );
+            nal_put( p_annexb, true, (const uint8_t[]){ 0x44, 0x01 }, 2,
+                     pps, i_pps );
+        }
+
+        for( unsigned j = 0; j < SLICES; j++ )
+        {
+            bs_t s;
+            bs_write_init( &s, p_slice, I_SIZE );
+            bs_write( &s, 1, j == 0 );  /* first_slice_segment_in_pic_flag */
+            if( b_idr )
+                bs_write( &s, 1, 0 );   /* no_output_of_prior_pics_flag */
+            write_ue( &s, 0 );          /* slice_pic_parameter_set_id */
+            if( j > 0 )
+                bs_write( &s, i_address_bits, j * i_ctbs / SLICES );
+            write_ue( &s, b_idr ? 2 : 1 ); /* slice_type: I or P */
+            size_t i_slice = write_slice_data( &s, frame_size( i ) / SLICES );
+
+            /* IDR_W_RADL or TRAIL_R */
+            nal_put( p_annexb, true, b_idr ? (const uint8_t[]){ 0x26, 0x01 }
+                                           : (const uint8_t[]){ 0x02, 0x01 },
+                     2, p_slice, i_slice );
+        }
+
+        /* Decoded picture hash */
+        uint8_t sei[19] = { 132, 16 };
+        for( unsigned j = 2; j < 18; j++ )
+            sei[j] = random_byte();
+        sei[18] = 0x80;
+        nal_put( p_annexb, true, (const uint8_t[]){ 0x50, 0x01 }, 2,
+                 sei, sizeof(sei) );
+    }
+    p_annexb->pi_au[FRAMES] = p_annexb->i_size;
+    free( p_slice );
+}
+
+/*****************************************************************************
+ * Packetizer
+ *****************************************************************************/
+static decoder_t *packetizer_new( vlc_object_t *obj, const char *psz_name,
+                                  vlc_fourcc_t i_codec, vlc_fourcc_t i_original,
+                                  const uint8_t *p_extra, size_t i_extra )
+{
+    decoder_t *p_dec = vlc_object_create( obj, sizeof(*p_dec) );
+    assert( p_dec != NULL );
+
+    es_format_Init( &p_dec->fmt_in, VIDEO_ES, i_codec );
+    p_dec->fmt_in.i_original_fourcc = i_original;
+    if( i_extra > 0 )
+    {
+        p_dec->fmt_in.p_extra = malloc( i_extra );
+        assert( p_dec->fmt_in.p_extra != NULL );
+        memcpy( p_dec->fmt_in.p_extra, p_extra, i_extra );
+        p_dec->fmt_in.i_extra = i_extra;
+    }
+    es_format_Init( &p_dec->fmt_out, UNKNOWN_ES, 0 );
+
+    p_dec->p_module = module_need( p_dec, "packetizer", psz_name, true );
+    assert( p_dec->p_module != NULL );
+    return p_dec;
+}
+
+static void packetizer_delete( decoder_t *p_dec )
+{
+    module_unneed( p_dec, p_dec->p_module );
+    es_format_Clean( &p_dec->fmt_in );
+    es_format_Clean( &p_dec->fmt_out );
+    vlc_object_release( p_dec );
+}
+
+/* Packetizes a whole stream, cut in chunks or in samples, and checks that the
+ * access units match the reference Annex B stream, picture type included.
+ * The last one stays in the packetizer, waiting for the next. */
+static mtime_t packetize( decoder_t *p_dec, const buffer_t *p_in, size_t i_chunk,
+                          const buffer_t *p_ref )
+{
+    mtime_t i_time = 0;
+    size_t i_out = 0;
+    unsigned i_aus = 0;
+    unsigned i_sample = 0;
+
+    for( size_t i_pos = 0; i_pos < p_in->i_size; )
+    {
+        size_t i_size = i_chunk ? __MIN( i_chunk, p_in->i_size - i_pos )
+                                : p_in->pi_au[i_sample + 1] - i_pos;
+        block_t *p_block = block_Alloc( i_size );
+        assert( p_block != NULL );
+        memcpy( p_block->p_buffer, &p_in->p[i_pos], i_size );
+        i_pos += i_size;
+        i_sample++;
+
+        /* Called again on the same block until it is used up */
+        for( ;; )
+        {
+            mtime_t i_start = mdate();
+            block_t *p_out = p_dec->pf_packetize( p_dec, &p_block );
+            i_time += mdate() - i_start;
+
+            if( p_out == NULL )
+                break;
+
+            do
+            {
+                block_t *p_next = p_out->p_next;
+
+                assert( i_aus < FRAMES );
+                assert( i_out == p_ref->pi_au[i_aus] );
+                assert( p_out->i_buffer == p_ref->pi_au[i_aus + 1] - i_out );
+                assert( !memcmp( p_out->p_buffer, &p_ref->p[i_out],
+                                 p_out->i_buffer ) );
+                assert( ( p_out->i_flags & BLOCK_FLAG_TYPE_MASK ) ==
+                        ( ( i_aus % GOP ) ? BLOCK_FLAG_TYPE_P
+                                          : BLOCK_FLAG_TYPE_I ) );
+                assert( !( p_out->i_flags & BLOCK_FLAG_CORRUPTED ) );
+
+                i_out += p_out->i_buffer;
+                i_aus++;
+                block_Release( p_out );
+                p_out = p_next;
+            }
+            while( p_out != NULL );
+        }
+    }
+    assert( i_aus == FRAMES - 1 );
+    return i_time;
+}
+
+static void benchmark( vlc_object_t *obj, const char *psz_name,
+                       const char *psz_format, vlc_fourcc_t i_codec,
+                       vlc_fourcc_t i_original, const uint8_t *p_extra,
+                       size_t i_extra, const buffer_t *p_in, size_t i_chunk,
+                       const buffer_t *p_ref )
+{
+    mtime_t i_best = INT64_MAX;
+
+    for( unsigned i = 0; i < RUNS; i++ )
+    {
+        decoder_t *p_dec = packetizer_new( obj, psz_name, i_codec, i_original,
+                                           p_extra, i_extra );
+        mtime_t i_time = packetize( p_dec, p_in, i_chunk, p_ref );
+        packetizer_delete( p_dec );
+        i_best = __MIN( i_best, i_time );
+    }
+
+    printf( "%s %s: %.0f MB/s, %.0f access units/s\n", psz_name, psz_format,
+            p_in->i_size / (double)__MAX( i_best, 1 ),
+            (double)FRAMES * CLOCK_FREQ / __MAX( i_best, 1 ) );
+
+    /* Cut at random places */
+    if( i_chunk )
+    {
+        decoder_t *p_dec = packetizer_new( obj, psz_name, i_codec, i_original,
+                                           p_extra, i_extra );
+        packetize( p_dec, p_in, SMALL_CHUNK, p_ref );
+        packetizer_delete( p_dec );
+    }
+}
+
+int main( void )
+{
+    setenv( "VLC_PLUGIN_PATH", "../modules", 1 );
+    alarm( 60 );
+
+    libvlc_instance_t *p_libvlc = libvlc_new( 0, NULL );
+    assert( p_libvlc != NULL );
+    vlc_object_t *obj = VLC_OBJECT( p_libvlc->p_libvlc_int );
+
+    buffer_t annexb = { 0 }, avc = { 0 };
+    uint8_t *p_extra;
+    size_t i_extra;
+
+    h264_build( &annexb, &avc, &p_extra, &i_extra );
+    benchmark( obj, "h264", "Annex B", VLC_CODEC_H264, 0, NULL, 0,
+               &annexb, CHUNK, &annexb );
+    benchmark( obj, "h264", "avcC", VLC_CODEC_H264,
+               VLC_FOURCC( 'a', 'v', 'c', '1' ), p_extra, i_extra,
+               &avc, 0, &annexb );
+    free( annexb.p );
+    free( avc.p );
+    free( p_extra );
+
+    memset( &annexb, 0, sizeof(annexb) );
+    hevc_build( &annexb );
+    benchmark( obj, "hevc", "Annex B", VLC_CODEC_HEVC, 0, NULL, 0,
+               &annexb, CHUNK, &annexb );
+    free( annexb.p );
+
+    libvlc_release( p_libvlc );
+    return 0;
+}
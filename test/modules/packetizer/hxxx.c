@@ -18,10 +18,16 @@
  * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
  *****************************************************************************/
 
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
 #ifdef NDEBUG
  #undef NDEBUG
 #endif
 #include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include <vlc_common.h>
 #include <vlc_block.h>
 #include "../modules/packetizer/hxxx_nal.h"
@@ -208,9 +214,229 @@ static void test_annexb()
     test_iterators( NULL, 0, p_res, rgi_res );
 }
 
-int main( void )
+typedef const uint8_t * (*startcode_finder_t)( const uint8_t *, const uint8_t * );
+
+static const struct
+{
+    const char *psz_name;
+    startcode_finder_t pf_find;
+} startcode_finders[] = {
+#ifdef STARTCODE_AVX2
+    { "AVX2", startcode_FindAnnexB_AVX2 },
+#endif
+#if defined(CAN_COMPILE_SSE2) || defined(HAVE_SSE2_INTRINSICS)
+    { "SSE2", startcode_FindAnnexB_SSE2 },
+#endif
+#ifdef STARTCODE_NEON
+    { "NEON", startcode_FindAnnexB_NEON },
+#endif
+    { "C", startcode_FindAnnexB_C },
+    { "default", startcode_FindAnnexB },
+};
+
+static bool startcode_finder_usable( const char *psz_name )
+{
+#ifdef STARTCODE_AVX2
+    if( !strcmp( psz_name, "AVX2" ) )
+        return vlc_CPU_AVX2();
+#endif
+#if defined(CAN_COMPILE_SSE2) || defined(HAVE_SSE2_INTRINSICS)
+    if( !strcmp( psz_name, "SSE2" ) )
+        return vlc_CPU_SSE2();
+#endif
+    return true;
+}
+
+static const uint8_t * startcode_FindAnnexB_ref( const uint8_t *p, const uint8_t *end )
+{
+    /* startcodes must be followed by some data */
+    for( ; end - p > 3; p++ )
+        if( p[0] == 0 && p[1] == 0 && p[2] == 1 )
+            return p;
+    return NULL;
+}
+
+static uint32_t test_rand( uint32_t *pi_state )
+{
+    /* xorshift32: the same sequence on every run and platform */
+    uint32_t x = *pi_state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *pi_state = x;
+}
+
+static void test_startcode()
+{
+    /* Dense zeros, so that partial and overlapping startcodes are everywhere */
+    uint8_t buf[512 + 64];
+    uint32_t i_seed = 0x5eed;
+    static const uint8_t values[8] = { 0, 0, 0, 0, 1, 1, 2, 0x80 };
+
+    printf("\nTEST startcode lookup\n");
+
+    for( unsigned i_round = 0; i_round < 16; i_round++ )
+    {
+        for( size_t i = 0; i < sizeof(buf); i++ )
+            buf[i] = values[test_rand( &i_seed ) & 7];
+        /* and some runs without any startcode */
+        if( i_round & 1 )
+            memset( &buf[i_round * 4], 0x42, 256 );
+
+        for( size_t i_offset = 0; i_offset < 32; i_offset++ )
+        for( size_t i_size = 0; i_size <= 512; i_size += 1 + (i_size >> 6) )
+        {
+            const uint8_t *p = &buf[i_offset], *end = p + i_size;
+
+            for( size_t i = 0; i < ARRAY_SIZE(startcode_finders); i++ )
+            {
+                if( !startcode_finder_usable( startcode_finders[i].psz_name ) )
+                    continue;
+
+                /* walk the whole buffer, as the packetizers do */
+                const uint8_t *ref = p, *res = p;
+                do
+                {
+                    ref = startcode_FindAnnexB_ref( ref, end );
+                    res = startcode_finders[i].pf_find( res, end );
+                    if( ref != res )
+                        printf("%s: offset %zu size %zu: %td != %td\n",
+                               startcode_finders[i].psz_name, i_offset, i_size,
+                               res ? res - p : -1, ref ? ref - p : -1);
+                    assert( ref == res );
+                    if( ref )
+                        ref = res = ref + 3;
+                } while( ref );
+            }
+        }
+    }
+}
+
+/* Builds an AnnexB elementary stream resembling a high bitrate one:
+ * large slices of incompressible data, with emulation prevention,
+ * between a few small parameter sets */
+static uint8_t * bench_bitstream( size_t i_size, uint32_t *pi_seed )
+{
+    uint8_t *p_buf = malloc( i_size );
+    if( !p_buf )
+        return NULL;
+
+    size_t i = 0;
+    while( i < i_size )
+    {
+        /* 1 frame out of 8 carries parameter sets, then 1 to 4 slices */
+        size_t i_nal = (test_rand( pi_seed ) & 7) ? 1 + (test_rand( pi_seed ) & 3) : 4;
+        size_t i_frame = 64 * 1024 + (test_rand( pi_seed ) % (384 * 1024));
+
+        for( size_t n = 0; n < i_nal && i < i_size; n++ )
+        {
+            static const uint8_t startcode[4] = { 0, 0, 0, 1 };
+            size_t i_len = (i_nal == 4 && n < 3) ? 8 + (test_rand( pi_seed ) & 31)
+                                                 : i_frame / i_nal;
+            size_t i_zeros = 0;
+
+            for( size_t j = 0; j < 4 && i < i_size; j++ )
+                p_buf[i++] = startcode[j];
+
+            for( size_t j = 0; j < i_len && i < i_size; j++ )
+            {
+                uint8_t b = test_rand( pi_seed ) >> 24;
+                if( i_zeros >= 2 && b <= 3 )
+                {
+                    p_buf[i++] = 3;
+                    i_zeros = 0;
+                    if( i == i_size )
+                        break;
+                }
+                p_buf[i++] = b;
+                i_zeros = b ? 0 : i_zeros + 1;
+            }
+            /* RBSP trailing bits */
+            if( i < i_size )
+                p_buf[i++] = 0x80;
+        }
+    }
+    return p_buf;
+}
+
+static void bench_startcode( const char *psz_file )
+{
+    uint8_t *p_buf = NULL;
+    size_t i_buf = 0;
+
+    if( psz_file )
+    {
+        FILE *f = fopen( psz_file, "rb" );
+        if( f )
+        {
+            if( !fseek( f, 0, SEEK_END ) && (i_buf = ftell( f )) > 0 &&
+                !fseek( f, 0, SEEK_SET ) && (p_buf = malloc( i_buf )) &&
+                fread( p_buf, 1, i_buf, f ) != i_buf )
+            {
+                free( p_buf );
+                p_buf = NULL;
+            }
+            fclose( f );
+        }
+        if( !p_buf )
+        {
+            fprintf( stderr, "cannot read %s\n", psz_file );
+            exit( 1 );
+        }
+    }
+    else
+    {
+        uint32_t i_seed = 0xb17;
+        i_buf = 32 * 1024 * 1024;
+        p_buf = bench_bitstream( i_buf, &i_seed );
+        assert( p_buf );
+    }
+
+    printf("\nBENCH startcode lookup over %zu bytes\n", i_buf);
+
+    size_t i_count_ref = 0;
+    for( size_t i = 0; i < ARRAY_SIZE(startcode_finders); i++ )
+    {
+        if( !startcode_finder_usable( startcode_finders[i].psz_name ) )
+        {
+            printf("%-8s: not supported by this CPU\n",
+                   startcode_finders[i].psz_name);
+            continue;
+        }
+
+        const unsigned i_passes = 8;
+        size_t i_count = 0;
+        mtime_t i_time = mdate();
+
+        for( unsigned j = 0; j < i_passes; j++ )
+        {
+            const uint8_t *p = p_buf, *end = p_buf + i_buf;
+            while( (p = startcode_finders[i].pf_find( p, end )) )
+            {
+                i_count++;
+                p += 3;
+            }
+        }
+        i_time = mdate() - i_time;
+        i_count /= i_passes;
+
+        if( i_count_ref == 0 )
+            i_count_ref = i_count;
+        assert( i_count == i_count_ref );
+
+        printf("%-8s: %zu startcodes, %.0f MB/s\n",
+               startcode_finders[i].psz_name, i_count,
+               (double)i_buf * i_passes / (i_time > 0 ? i_time : 1));
+    }
+    free( p_buf );
+}
+
+int main( int argc, char **argv )
 {
     test_annexb();
+    test_startcode();
+    /* an AnnexB H.264/HEVC elementary stream can be given to benchmark */
+    bench_startcode( argc > 1 ? argv[1] : NULL );
 
     return 0;
 }
@@ -0,0 +1,238 @@
+/*****************************************************************************
+ * transcode.c: transcode stream output threading test
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+#include <vlc/vlc.h>
+
+#include "../../../lib/libvlc_internal.h"
+#include "../../../lib/media_internal.h"
+
+#include <vlc_common.h>
+#include <vlc_fs.h>
+#include <vlc_input_item.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#undef NDEBUG
+#include <assert.h>
+
+#define WIDTH       64
+#define HEIGHT      48
+#define FPS         25
+#define FRAMES      200
+#define MAX_STREAMS 3
+
+/*
+ * The input is a raw I420 YUV4MPEG2 file, whose pictures are filled with
+ * their number. The transcoded streams are encoded to raw R420, which
+ * starts with the first luma sample, so every output block tells which
+ * picture it comes from.
+ */
+static void y4m_write( FILE *f )
+{
+    const size_t i_luma = WIDTH * HEIGHT;
+    uint8_t *p_frame = malloc( i_luma * 3 / 2 );
+
+    assert( p_frame != NULL );
+    fprintf( f, "YUV4MPEG2 W%u H%u F%u:1 Ip A1:1 C420jpeg\n",
+             WIDTH, HEIGHT, FPS );
+    for( unsigned i = 0; i < FRAMES; i++ )
+    {
+        memset( p_frame, i, i_luma );
+        memset( p_frame + i_luma, 0x80, i_luma / 2 );
+        fputs( "FRAME\n", f );
+        assert( fwrite( p_frame, 1, i_luma * 3 / 2, f ) == i_luma * 3 / 2 );
+    }
+    free( p_frame );
+}
+
+typedef struct
+{
+    uint8_t *p_buffer;
+    unsigned i_blocks;
+    /* Next picture expected on each output stream */
+    unsigned pi_next[MAX_STREAMS];
+    unsigned i_streams;
+    mtime_t i_first_pts;
+    /* Posted on the first block to stop while the threads are busy */
+    vlc_sem_t *p_started;
+} output_t;
+
+static void Prerender( void *opaque, uint8_t **pp_buffer, size_t i_size )
+{
+    output_t *p_out = opaque;
+
+    p_out->p_buffer = realloc( p_out->p_buffer, i_size );
+    assert( p_out->p_buffer != NULL );
+    *pp_buffer = p_out->p_buffer;
+}
+
+static void Postrender( void *opaque, uint8_t *p_buffer, int i_width,
+                        int i_height, int i_pixel_pitch, size_t i_size,
+                        mtime_t i_pts )
+{
+    output_t *p_out = opaque;
+    const unsigned i_pic = p_buffer[0];
+
+    (void) i_pixel_pitch;
+    assert( i_width == WIDTH && i_height == HEIGHT );
+    assert( i_size == WIDTH * HEIGHT * 3 / 2 );
+
+    if( p_out->i_blocks++ == 0 )
+    {
+        p_out->i_first_pts = i_pts;
+        if( p_out->p_started != NULL )
+            vlc_sem_post( p_out->p_started );
+    }
+    assert( i_pts - p_out->i_first_pts ==
+            (mtime_t)i_pic * CLOCK_FREQ / FPS );
+
+    /* The streams are not told apart: the picture must be the next one of
+     * some stream, i.e. every stream outputs all of them in order */
+    unsigned i;
+    for( i = 0; i < p_out->i_streams; i++ )
+        if( p_out->pi_next[i] == i_pic )
+            break;
+    assert( i < p_out->i_streams );
+    p_out->pi_next[i]++;
+}
+
+static void EndReached( const libvlc_event_t *p_ev, void *opaque )
+{
+    (void) p_ev;
+    vlc_sem_post( opaque );
+}
+
+static void test_transcode( libvlc_instance_t *p_libvlc, const char *psz_path,
+                            const char *psz_options, unsigned i_streams,
+                            bool b_interrupt )
+{
+    output_t out = { .i_streams = i_streams };
+    char *psz_sout;
+
+    assert( asprintf( &psz_sout, ":sout=#transcode{vcodec=R420,venc=rtpvideo"
+                      "%s}:smem{no-time-sync,video-data=%"PRIdPTR","
+                      "video-prerender-callback=%"PRIdPTR","
+                      "video-postrender-callback=%"PRIdPTR"}", psz_options,
+                      (intptr_t)&out, (intptr_t)Prerender,
+                      (intptr_t)Postrender ) >= 0 );
+    printf( "%s\n", psz_sout );
+
+    libvlc_media_t *p_md = libvlc_media_new_path( p_libvlc, psz_path );
+    assert( p_md != NULL );
+    libvlc_media_add_option( p_md, psz_sout );
+    free( psz_sout );
+    /* The raw video demuxer does not keep the YUV4MPEG2 rate otherwise */
+    libvlc_media_add_option( p_md, ":rawvid-fps=25" );
+
+    libvlc_media_player_t *p_mp = libvlc_media_player_new_from_media( p_md );
+    assert( p_mp != NULL );
+
+    vlc_sem_t sem;
+    vlc_sem_init( &sem, 0 );
+    libvlc_event_manager_t *p_em = libvlc_media_player_event_manager( p_mp );
+    assert( libvlc_event_attach( p_em, libvlc_MediaPlayerEndReached,
+                                 EndReached, &sem ) == 0 );
+    if( b_interrupt )
+        out.p_started = &sem;
+
+    assert( libvlc_media_player_play( p_mp ) == 0 );
+    vlc_sem_wait( &sem );
+    libvlc_media_player_stop( p_mp );
+    libvlc_event_detach( p_em, libvlc_MediaPlayerEndReached, EndReached, &sem );
+    vlc_sem_destroy( &sem );
+
+    /* The statistics are updated when the input ends */
+    input_stats_t *p_stats = p_md->p_input_item->p_stats;
+    assert( p_stats != NULL );
+    vlc_mutex_lock( &p_stats->lock );
+    input_stage_stats_t decode = p_stats->transcode_decode;
+    input_stage_stats_t filter = p_stats->transcode_filter;
+    input_stage_stats_t encode = p_stats->transcode_encode;
+    vlc_mutex_unlock( &p_stats->lock );
+
+    printf( "%u blocks, decoder %"PRId64" pictures %"PRId64" us, "
+            "filters %"PRId64" pictures %"PRId64" us, "
+            "encoders %"PRId64" pictures %"PRId64" us\n", out.i_blocks,
+            decode.i_pictures, decode.i_busy, filter.i_pictures, filter.i_busy,
+            encode.i_pictures, encode.i_busy );
+
+    /* Every decoded picture went through every stream, even when the
+     * stream was deleted while the threads still had pictures queued */
+    const unsigned i_frames = b_interrupt ? out.pi_next[0] : FRAMES;
+    assert( i_frames > 0 );
+    assert( out.i_blocks == i_frames * i_streams );
+    for( unsigned i = 0; i < i_streams; i++ )
+        assert( out.pi_next[i] == i_frames );
+
+    assert( decode.i_pictures == i_frames && decode.i_busy > 0 );
+    assert( filter.i_pictures == i_frames );
+    assert( encode.i_pictures == i_frames * i_streams && encode.i_busy > 0 );
+
+    libvlc_media_player_release( p_mp );
+    libvlc_media_release( p_md );
+    free( out.p_buffer );
+}
+
+int main( void )
+{
+    setenv( "VLC_PLUGIN_PATH", "../modules", 1 );
+    alarm( 60 );
+
+    const char *psz_tmp = getenv( "TMPDIR" );
+    char *psz_path;
+    assert( asprintf( &psz_path, "%s/vlc-test-transcode-XXXXXX",
+                      psz_tmp ? psz_tmp : "/tmp" ) >= 0 );
+    int fd = vlc_mkstemp( psz_path );
+    assert( fd != -1 );
+    FILE *f = fdopen( fd, "wb" );
+    assert( f != NULL );
+    y4m_write( f );
+    fclose( f );
+
+    const char *argv[] = { "--no-audio", "--no-spu", "--no-osd" };
+    libvlc_instance_t *p_libvlc = libvlc_new( ARRAY_SIZE(argv), argv );
+    assert( p_libvlc != NULL );
+
+    /* Synchronous encoding, as a reference */
+    test_transcode( p_libvlc, psz_path, "", 1, false );
+    /* Encoder thread */
+    test_transcode( p_libvlc, psz_path, ",threads=2", 1, false );
+    /* Filters thread feeding the encoder thread */
+    test_transcode( p_libvlc, psz_path, ",threads=2,pipeline", 1, false );
+    /* Renditions in their own threads, behind a small queue */
+    test_transcode( p_libvlc, psz_path, ",rendition{vb=100}", 2, false );
+    test_transcode( p_libvlc, psz_path,
+                    ",threads=2,pipeline,pool-size=2,"
+                    "rendition{vb=100},rendition{vb=50}", 3, false );
+    /* Stopped before the end, so the stream is closed during the flush */
+    test_transcode( p_libvlc, psz_path,
+                    ",threads=2,pipeline,pool-size=2,"
+                    "rendition{vb=100},rendition{vb=50}", 3, true );
+
+    libvlc_release( p_libvlc );
+    unlink( psz_path );
+    free( psz_path );
+    return 0;
+}
@@ -0,0 +1,316 @@
+/*****************************************************************************
+ * freetype_cache.c: freetype glyph and layout caches test
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+#include <vlc_text_style.h>
+
+#include "../../../modules/text_renderer/freetype/cache.h"
+
+#undef NDEBUG
+#include <assert.h>
+
+/* The renderer helpers the line cache releases its entries with */
+static unsigned i_freed_lines;
+static unsigned i_freed_styles;
+
+void FreeLines( line_desc_t *p_lines )
+{
+    free( p_lines );
+    i_freed_lines++;
+}
+
+void FreeStylesArray( text_style_t **pp_styles, size_t i_styles )
+{
+    text_style_t *p_style = NULL;
+    for( size_t i = 0; i < i_styles; i++ )
+    {
+        if( p_style != pp_styles[i] )
+        {
+            p_style = pp_styles[i];
+            text_style_Delete( p_style );
+        }
+    }
+    free( pp_styles );
+    i_freed_styles++;
+}
+
+/*****************************************************************************
+ * Glyph cache
+ *****************************************************************************/
+static FT_Glyph glyph_new( FT_Library p_library, int i_mark )
+{
+    FT_Glyph p_glyph;
+    FT_Error i_err = FT_New_Glyph( p_library, FT_GLYPH_FORMAT_BITMAP,
+                                   &p_glyph );
+
+    assert( i_err == 0 );
+    ((FT_BitmapGlyph)p_glyph)->left = i_mark;
+    return p_glyph;
+}
+
+static glyph_cache_key_t glyph_key( FT_UInt i_index )
+{
+    glyph_cache_key_t key = {
+        .p_face = NULL, .i_index = i_index, .i_flags = 0, .i_radius = 0,
+    };
+    return key;
+}
+
+/* Returns the mark of the cached glyph, or -1 on miss */
+static int glyph_get( glyph_cache_t *p_cache, const glyph_cache_key_t *p_key,
+                      bool b_outline )
+{
+    FT_Glyph p_glyph, p_outline;
+    FT_Vector advance;
+
+    if( GlyphCache_Get( p_cache, p_key, &p_glyph, &p_outline, &advance ) )
+        return -1;
+
+    int i_mark = ((FT_BitmapGlyph)p_glyph)->left;
+    assert( advance.x == i_mark && advance.y == 0 );
+    assert( (p_outline != NULL) == b_outline );
+    if( p_outline )
+    {
+        assert( ((FT_BitmapGlyph)p_outline)->left == -i_mark );
+        FT_Done_Glyph( p_outline );
+    }
+    FT_Done_Glyph( p_glyph );
+    return i_mark;
+}
+
+static void glyph_put( FT_Library p_library, glyph_cache_t *p_cache,
+                       const glyph_cache_key_t *p_key, int i_mark,
+                       bool b_outline )
+{
+    FT_Glyph p_glyph = glyph_new( p_library, i_mark );
+    FT_Glyph p_outline = b_outline ? glyph_new( p_library, -i_mark ) : NULL;
+    FT_Vector advance = { .x = i_mark, .y = 0 };
+
+    /* The cache keeps copies */
+    GlyphCache_Put( p_cache, p_key, p_glyph, p_outline, &advance );
+    FT_Done_Glyph( p_glyph );
+    if( p_outline )
+        FT_Done_Glyph( p_outline );
+}
+
+static void test_glyph_cache( FT_Library p_library )
+{
+    assert( GlyphCache_New( 0 ) == NULL );
+
+    glyph_cache_t *p_cache = GlyphCache_New( 4 );
+    assert( p_cache != NULL );
+
+    for( unsigned i = 0; i < 4; i++ )
+    {
+        glyph_cache_key_t key = glyph_key( i );
+        assert( glyph_get( p_cache, &key, false ) == -1 );
+        glyph_put( p_library, p_cache, &key, 100 + i, i & 1 );
+    }
+    for( unsigned i = 0; i < 4; i++ )
+    {
+        glyph_cache_key_t key = glyph_key( i );
+        assert( glyph_get( p_cache, &key, i & 1 ) == (int)(100 + i) );
+    }
+
+    /* Emboldened and outlined glyphs are distinct entries */
+    glyph_cache_key_t key = glyph_key( 0 );
+    key.i_flags = STYLE_BOLD;
+    assert( glyph_get( p_cache, &key, false ) == -1 );
+    key = glyph_key( 0 );
+    key.i_radius = 64;
+    assert( glyph_get( p_cache, &key, false ) == -1 );
+
+    const cache_stats_t *p_stats = GlyphCache_Stats( p_cache );
+    assert( p_stats->i_hits == 4 );
+    assert( p_stats->i_misses == 6 );
+    assert( p_stats->i_evictions == 0 );
+
+    /* Glyph 1 is now the least recently used one, and gets evicted */
+    key = glyph_key( 0 );
+    assert( glyph_get( p_cache, &key, false ) == 100 );
+    key = glyph_key( 4 );
+    glyph_put( p_library, p_cache, &key, 104, false );
+    assert( p_stats->i_evictions == 1 );
+
+    key = glyph_key( 1 );
+    assert( glyph_get( p_cache, &key, false ) == -1 );
+    for( unsigned i = 0; i < 5; i++ )
+    {
+        if( i == 1 )
+            continue;
+        key = glyph_key( i );
+        assert( glyph_get( p_cache, &key, i & 1 ) == (int)(100 + i) );
+    }
+    assert( p_stats->i_hits == 9 );
+    assert( p_stats->i_misses == 7 );
+
+    /* Filling it up again evicts in least recently used order */
+    for( unsigned i = 5; i < 9; i++ )
+    {
+        key = glyph_key( i );
+        glyph_put( p_library, p_cache, &key, 100 + i, false );
+    }
+    assert( p_stats->i_evictions == 5 );
+    for( unsigned i = 0; i < 9; i++ )
+    {
+        key = glyph_key( i );
+        assert( glyph_get( p_cache, &key, false )
+                == (i < 5 ? -1 : (int)(100 + i)) );
+    }
+
+    GlyphCache_Delete( p_cache );
+}
+
+/*****************************************************************************
+ * Line cache
+ *****************************************************************************/
+static const layout_params_t params = {
+    .i_visible_width = 1280, .i_video_height = 720, .i_scale = 1000,
+    .i_outline_thickness = 4, .b_grid = false,
+};
+
+static uni_char_t *text_new( const char *psz, size_t *pi_length )
+{
+    size_t i_length = strlen( psz );
+    uni_char_t *psz_text = malloc( i_length * sizeof( *psz_text ) );
+
+    assert( psz_text != NULL );
+    for( size_t i = 0; i < i_length; i++ )
+        psz_text[i] = psz[i];
+    *pi_length = i_length;
+    return psz_text;
+}
+
+/* One style shared by the whole text, as the renderer does for a segment */
+static text_style_t **styles_new( size_t i_length, int i_font_size )
+{
+    text_style_t **pp_styles = malloc( i_length * sizeof( *pp_styles ) );
+    text_style_t *p_style = text_style_Create( STYLE_NO_DEFAULTS );
+
+    assert( pp_styles != NULL && p_style != NULL );
+    p_style->i_font_size = i_font_size;
+    p_style->psz_fontname = strdup( "Serif" );
+    for( size_t i = 0; i < i_length; i++ )
+        pp_styles[i] = p_style;
+    return pp_styles;
+}
+
+static line_desc_t *line_put( line_cache_t *p_cache, const char *psz )
+{
+    size_t i_length;
+    uni_char_t *psz_text = text_new( psz, &i_length );
+    text_style_t **pp_styles = styles_new( i_length, 24 );
+    line_desc_t *p_lines = calloc( 1, sizeof( *p_lines ) );
+    FT_BBox bbox = { .xMin = 0, .yMin = 0, .xMax = i_length, .yMax = 24 };
+
+    assert( p_lines != NULL );
+    LineCache_Put( p_cache, &params, psz_text, pp_styles, i_length, i_length,
+                   p_lines, &bbox, 24 );
+    return p_lines;
+}
+
+static line_desc_t *line_get( line_cache_t *p_cache,
+                              const layout_params_t *p_params,
+                              const char *psz, int i_font_size )
+{
+    size_t i_length;
+    uni_char_t *psz_text = text_new( psz, &i_length );
+    /* Equal styles, but not the cached ones */
+    text_style_t **pp_styles = styles_new( i_length, i_font_size );
+    FT_BBox bbox;
+    int i_max_face_height;
+
+    line_desc_t *p_lines = LineCache_Get( p_cache, p_params, psz_text,
+                                          pp_styles, i_length,
+                                          &bbox, &i_max_face_height );
+    if( p_lines )
+    {
+        assert( bbox.xMax == (FT_Pos)i_length && bbox.yMax == 24 );
+        assert( i_max_face_height == 24 );
+    }
+    text_style_Delete( pp_styles[0] );
+    free( pp_styles );
+    free( psz_text );
+    return p_lines;
+}
+
+static void test_line_cache( void )
+{
+    assert( LineCache_New( 0 ) == NULL );
+
+    line_cache_t *p_cache = LineCache_New( 2 );
+    assert( p_cache != NULL );
+
+    assert( line_get( p_cache, &params, "first", 24 ) == NULL );
+    line_desc_t *p_first = line_put( p_cache, "first" );
+    line_desc_t *p_second = line_put( p_cache, "second" );
+
+    assert( line_get( p_cache, &params, "first", 24 ) == p_first );
+    assert( line_get( p_cache, &params, "second", 24 ) == p_second );
+
+    /* Any difference in the text, styles or parameters misses */
+    layout_params_t other = params;
+    other.i_video_height = 1080;
+    assert( line_get( p_cache, &other, "first", 24 ) == NULL );
+    other = params;
+    other.b_grid = true;
+    assert( line_get( p_cache, &other, "first", 24 ) == NULL );
+    assert( line_get( p_cache, &params, "first", 32 ) == NULL );
+    assert( line_get( p_cache, &params, "First", 24 ) == NULL );
+    assert( line_get( p_cache, &params, "firs", 24 ) == NULL );
+
+    const cache_stats_t *p_stats = LineCache_Stats( p_cache );
+    assert( p_stats->i_hits == 2 );
+    assert( p_stats->i_misses == 6 );
+    assert( p_stats->i_evictions == 0 );
+    assert( i_freed_lines == 0 && i_freed_styles == 0 );
+
+    /* The second text is now the least recently used one */
+    assert( line_get( p_cache, &params, "first", 24 ) == p_first );
+    line_desc_t *p_third = line_put( p_cache, "third" );
+    assert( p_stats->i_evictions == 1 );
+    assert( i_freed_lines == 1 && i_freed_styles == 1 );
+
+    assert( line_get( p_cache, &params, "second", 24 ) == NULL );
+    assert( line_get( p_cache, &params, "first", 24 ) == p_first );
+    assert( line_get( p_cache, &params, "third", 24 ) == p_third );
+    assert( p_stats->i_hits == 5 );
+    assert( p_stats->i_misses == 7 );
+
+    LineCache_Delete( p_cache );
+    assert( i_freed_lines == 3 && i_freed_styles == 3 );
+}
+
+int main( void )
+{
+    FT_Library p_library;
+    FT_Error i_err = FT_Init_FreeType( &p_library );
+
+    assert( i_err == 0 );
+    test_glyph_cache( p_library );
+    FT_Done_FreeType( p_library );
+
+    test_line_cache();
+    return 0;
+}
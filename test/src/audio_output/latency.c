@@ -0,0 +1,253 @@
+/*****************************************************************************
+ * latency.c: audio output latency statistics test
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+#include <math.h>
+#include <vlc/vlc.h>
+
+#include "../../../lib/libvlc_internal.h"
+#include "../../../lib/media_internal.h"
+
+#define MODULE_NAME test_latency_aout
+#undef MODULE_STRING
+#define MODULE_STRING "test_latency_aout"
+#include <vlc_common.h>
+#include <vlc_plugin.h>
+#include <vlc_aout.h>
+#include <vlc_fs.h>
+#include <vlc_input_item.h>
+
+#undef NDEBUG
+#include <assert.h>
+
+#define RATE     48000
+#define CHANNELS 2
+#define SECONDS  1
+
+/* One second of a stereo 16-bits sine */
+static void wav_write( int fd )
+{
+    const uint32_t i_data = SECONDS * RATE * CHANNELS * 2;
+    uint8_t hdr[44];
+
+    memcpy( hdr, "RIFF", 4 );
+    SetDWLE( hdr + 4, 36 + i_data );
+    memcpy( hdr + 8, "WAVEfmt ", 8 );
+    SetDWLE( hdr + 16, 16 );
+    SetWLE( hdr + 20, 1 );
+    SetWLE( hdr + 22, CHANNELS );
+    SetDWLE( hdr + 24, RATE );
+    SetDWLE( hdr + 28, RATE * CHANNELS * 2 );
+    SetWLE( hdr + 32, CHANNELS * 2 );
+    SetWLE( hdr + 34, 16 );
+    memcpy( hdr + 36, "data", 4 );
+    SetDWLE( hdr + 40, i_data );
+    assert( write( fd, hdr, sizeof(hdr) ) == sizeof(hdr) );
+
+    for( unsigned i = 0; i < SECONDS * RATE; i++ )
+    {
+        uint8_t frame[CHANNELS * 2];
+
+        for( unsigned c = 0; c < CHANNELS; c++ )
+            SetWLE( frame + 2 * c,
+                    (int16_t)( 16000. * sin( 2. * M_PI * 440. * i / RATE ) ) );
+        assert( write( fd, frame, sizeof(frame) ) == sizeof(frame) );
+    }
+}
+
+/*****************************************************************************
+ * Sound card
+ *****************************************************************************/
+/* Plays in real time, with the device buffer of the ALSA output: writing
+ * blocks while the buffer is full, and the delay is what is left in there */
+struct aout_sys_t
+{
+    mtime_t i_buffer;
+    mtime_t i_end;
+};
+
+static unsigned i_frames;
+
+static int TimeGet( audio_output_t *p_aout, mtime_t *pi_delay )
+{
+    *pi_delay = __MAX( p_aout->sys->i_end - mdate(), 0 );
+    return 0;
+}
+
+static void Play( audio_output_t *p_aout, block_t *p_block )
+{
+    aout_sys_t *p_sys = p_aout->sys;
+
+    p_sys->i_end = __MAX( p_sys->i_end, mdate() ) + p_block->i_length;
+    i_frames += p_block->i_nb_samples;
+    block_Release( p_block );
+
+    mwait( p_sys->i_end - p_sys->i_buffer );
+}
+
+static void Flush( audio_output_t *p_aout, bool b_wait )
+{
+    aout_sys_t *p_sys = p_aout->sys;
+
+    if( b_wait )
+        mwait( p_sys->i_end );
+    p_sys->i_end = VLC_TS_INVALID;
+}
+
+static int Start( audio_output_t *p_aout, audio_sample_format_t *restrict fmt )
+{
+    aout_sys_t *p_sys = p_aout->sys;
+
+    fmt->i_format = VLC_CODEC_S16N;
+    p_sys->i_buffer = var_InheritBool( p_aout, "audio-low-latency" )
+                    ? AOUT_LOW_LATENCY_BUFFER : AOUT_MAX_ADVANCE_TIME;
+    p_sys->i_end = VLC_TS_INVALID;
+    return VLC_SUCCESS;
+}
+
+static int OpenAout( vlc_object_t *p_this )
+{
+    audio_output_t *p_aout = (audio_output_t *)p_this;
+
+    p_aout->sys = malloc( sizeof(*p_aout->sys) );
+    if( p_aout->sys == NULL )
+        return VLC_ENOMEM;
+    p_aout->start = Start;
+    p_aout->time_get = TimeGet;
+    p_aout->play = Play;
+    p_aout->pause = NULL;
+    p_aout->flush = Flush;
+    p_aout->stop = NULL;
+    p_aout->volume_set = NULL;
+    p_aout->mute_set = NULL;
+    return VLC_SUCCESS;
+}
+
+static void CloseAout( vlc_object_t *p_this )
+{
+    audio_output_t *p_aout = (audio_output_t *)p_this;
+
+    free( p_aout->sys );
+}
+
+vlc_module_begin()
+    set_capability( "audio output", 0 )
+    set_callbacks( OpenAout, CloseAout )
+vlc_module_end()
+
+VLC_EXPORT int (*vlc_static_modules[])( vlc_set_cb, void * ) = {
+    vlc_entry__test_latency_aout, NULL
+};
+
+/*****************************************************************************
+ * Test
+ *****************************************************************************/
+static void EndReached( const libvlc_event_t *p_ev, void *opaque )
+{
+    (void) p_ev;
+    vlc_sem_post( opaque );
+}
+
+static int64_t test_latency( const char *psz_path, bool b_low_latency )
+{
+    const char *argv[] = {
+        "--no-video", "--no-audio-time-stretch", "--aout=test_latency_aout",
+        b_low_latency ? "--audio-low-latency" : "--no-audio-low-latency",
+    };
+
+    libvlc_instance_t *p_libvlc = libvlc_new( ARRAY_SIZE(argv), argv );
+    assert( p_libvlc != NULL );
+
+    libvlc_media_t *p_md = libvlc_media_new_path( p_libvlc, psz_path );
+    assert( p_md != NULL );
+    libvlc_media_player_t *p_mp = libvlc_media_player_new_from_media( p_md );
+    assert( p_mp != NULL );
+
+    i_frames = 0;
+
+    vlc_sem_t sem;
+    vlc_sem_init( &sem, 0 );
+    libvlc_event_manager_t *p_em = libvlc_media_player_event_manager( p_mp );
+    assert( libvlc_event_attach( p_em, libvlc_MediaPlayerEndReached,
+                                 EndReached, &sem ) == 0 );
+    assert( libvlc_event_attach( p_em, libvlc_MediaPlayerEncounteredError,
+                                 EndReached, &sem ) == 0 );
+
+    assert( libvlc_media_player_play( p_mp ) == 0 );
+    vlc_sem_wait( &sem );
+    assert( libvlc_media_player_get_state( p_mp ) == libvlc_Ended );
+    libvlc_media_player_stop( p_mp );
+    libvlc_event_detach( p_em, libvlc_MediaPlayerEncounteredError,
+                         EndReached, &sem );
+    libvlc_event_detach( p_em, libvlc_MediaPlayerEndReached,
+                         EndReached, &sem );
+    vlc_sem_destroy( &sem );
+
+    /* The statistics are updated when the input ends */
+    input_stats_t *p_stats = p_md->p_input_item->p_stats;
+    assert( p_stats != NULL );
+    vlc_mutex_lock( &p_stats->lock );
+    int64_t i_latency = p_stats->i_audio_latency;
+    int64_t i_played = p_stats->i_played_abuffers;
+    int64_t i_lost = p_stats->i_lost_abuffers;
+    vlc_mutex_unlock( &p_stats->lock );
+
+    printf( "%s: %u frames, %"PRId64" buffers played, %"PRId64" lost, "
+            "latency %"PRId64" us\n", b_low_latency ? "low latency" : "default",
+            i_frames, i_played, i_lost, i_latency );
+
+    assert( i_frames >= SECONDS * RATE );
+    assert( i_played > 0 && i_lost == 0 );
+    assert( i_latency > 0 );
+
+    libvlc_media_player_release( p_mp );
+    libvlc_media_release( p_md );
+    libvlc_release( p_libvlc );
+    return i_latency;
+}
+
+int main( void )
+{
+    setenv( "VLC_PLUGIN_PATH", "../modules", 1 );
+    alarm( 30 );
+
+    const char *psz_tmp = getenv( "TMPDIR" );
+    char *psz_path;
+    assert( asprintf( &psz_path, "%s/vlc-test-latency-XXXXXX",
+                      psz_tmp ? psz_tmp : "/tmp" ) >= 0 );
+    int fd = vlc_mkstemp( psz_path );
+    assert( fd != -1 );
+    wav_write( fd );
+    close( fd );
+
+    int64_t i_default = test_latency( psz_path, false );
+    int64_t i_low = test_latency( psz_path, true );
+
+    /* Within the device buffer and one period of scheduling, and below the
+     * default latency */
+    assert( i_low <= AOUT_LOW_LATENCY_BUFFER + AOUT_LOW_LATENCY_PERIOD );
+    assert( i_low < i_default );
+
+    unlink( psz_path );
+    free( psz_path );
+    return 0;
+}
@@ -0,0 +1,176 @@
+/*****************************************************************************
+ * audio_pool.c: decoder audio buffers recycling test
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+#include <math.h>
+#include <vlc/vlc.h>
+
+#include "../../../lib/libvlc_internal.h"
+#include "../../../lib/media_internal.h"
+
+#include <vlc_common.h>
+#include <vlc_fs.h>
+#include <vlc_input_item.h>
+
+#undef NDEBUG
+#include <assert.h>
+
+#define RATE     48000
+#define CHANNELS 2
+#define SECONDS  5
+#define STREAMS  4
+
+/* A stereo 24-bits sine, which the raw audio decoder converts to 32-bits
+ * samples in new buffers */
+static void wav_write( int fd )
+{
+    const uint32_t i_data = SECONDS * RATE * CHANNELS * 3;
+    uint8_t hdr[44];
+
+    memcpy( hdr, "RIFF", 4 );
+    SetDWLE( hdr + 4, 36 + i_data );
+    memcpy( hdr + 8, "WAVEfmt ", 8 );
+    SetDWLE( hdr + 16, 16 );
+    SetWLE( hdr + 20, 1 );
+    SetWLE( hdr + 22, CHANNELS );
+    SetDWLE( hdr + 24, RATE );
+    SetDWLE( hdr + 28, RATE * CHANNELS * 3 );
+    SetWLE( hdr + 32, CHANNELS * 3 );
+    SetWLE( hdr + 34, 24 );
+    memcpy( hdr + 36, "data", 4 );
+    SetDWLE( hdr + 40, i_data );
+    assert( write( fd, hdr, sizeof(hdr) ) == sizeof(hdr) );
+
+    for( unsigned i = 0; i < SECONDS * RATE; i++ )
+    {
+        uint8_t frame[CHANNELS * 3];
+        int32_t v = 4000000. * sin( 2. * M_PI * 440. * i / RATE );
+
+        for( unsigned c = 0; c < CHANNELS; c++ )
+        {
+            frame[3 * c] = v;
+            frame[3 * c + 1] = v >> 8;
+            frame[3 * c + 2] = v >> 16;
+        }
+        assert( write( fd, frame, sizeof(frame) ) == sizeof(frame) );
+    }
+}
+
+/* The memory audio output stands in for the sound card */
+static void Play( void *opaque, const void *samples, unsigned count,
+                  int64_t pts )
+{
+    (void) opaque; (void) samples; (void) count; (void) pts;
+}
+
+static void EndReached( const libvlc_event_t *p_ev, void *opaque )
+{
+    (void) p_ev;
+    vlc_sem_post( opaque );
+}
+
+int main( void )
+{
+    const char *argv[] = { "--no-video", "--no-audio-time-stretch" };
+
+    setenv( "VLC_PLUGIN_PATH", "../modules", 1 );
+    alarm( 30 );
+
+    const char *psz_tmp = getenv( "TMPDIR" );
+    char *psz_path;
+    assert( asprintf( &psz_path, "%s/vlc-test-audio-pool-XXXXXX",
+                      psz_tmp ? psz_tmp : "/tmp" ) >= 0 );
+    int fd = vlc_mkstemp( psz_path );
+    assert( fd != -1 );
+    wav_write( fd );
+    close( fd );
+
+    libvlc_instance_t *p_libvlc = libvlc_new( ARRAY_SIZE(argv), argv );
+    assert( p_libvlc != NULL );
+
+    /* Several streams at once, as when restreaming radios */
+    libvlc_media_t *pp_md[STREAMS];
+    libvlc_media_player_t *pp_mp[STREAMS];
+    vlc_sem_t p_sem[STREAMS];
+
+    for( unsigned i = 0; i < STREAMS; i++ )
+    {
+        pp_md[i] = libvlc_media_new_path( p_libvlc, psz_path );
+        assert( pp_md[i] != NULL );
+        libvlc_media_add_option( pp_md[i], ":rate=4" );
+        pp_mp[i] = libvlc_media_player_new_from_media( pp_md[i] );
+        assert( pp_mp[i] != NULL );
+        libvlc_audio_set_callbacks( pp_mp[i], Play, NULL, NULL, NULL, NULL,
+                                    NULL );
+        libvlc_audio_set_format( pp_mp[i], "S32N", RATE, CHANNELS );
+
+        libvlc_event_manager_t *p_em =
+            libvlc_media_player_event_manager( pp_mp[i] );
+        vlc_sem_init( &p_sem[i], 0 );
+        assert( libvlc_event_attach( p_em, libvlc_MediaPlayerEndReached,
+                                     EndReached, &p_sem[i] ) == 0 );
+        assert( libvlc_event_attach( p_em, libvlc_MediaPlayerEncounteredError,
+                                     EndReached, &p_sem[i] ) == 0 );
+        assert( libvlc_media_player_play( pp_mp[i] ) == 0 );
+    }
+
+    for( unsigned i = 0; i < STREAMS; i++ )
+    {
+        libvlc_event_manager_t *p_em =
+            libvlc_media_player_event_manager( pp_mp[i] );
+
+        vlc_sem_wait( &p_sem[i] );
+        assert( libvlc_media_player_get_state( pp_mp[i] ) == libvlc_Ended );
+        libvlc_media_player_stop( pp_mp[i] );
+        libvlc_event_detach( p_em, libvlc_MediaPlayerEncounteredError,
+                             EndReached, &p_sem[i] );
+        libvlc_event_detach( p_em, libvlc_MediaPlayerEndReached,
+                             EndReached, &p_sem[i] );
+        vlc_sem_destroy( &p_sem[i] );
+
+        input_stats_t *p_stats = pp_md[i]->p_input_item->p_stats;
+        assert( p_stats != NULL );
+        vlc_mutex_lock( &p_stats->lock );
+        int64_t i_decoded = p_stats->i_decoded_audio;
+        int64_t i_allocated = p_stats->i_allocated_abuffers;
+        int64_t i_recycled = p_stats->i_recycled_abuffers;
+        int64_t i_played = p_stats->i_played_abuffers;
+        vlc_mutex_unlock( &p_stats->lock );
+
+        printf( "stream %u: %"PRId64" buffers decoded, %"PRId64" played, "
+                "%"PRId64" allocated, %"PRId64" recycled\n", i, i_decoded,
+                i_played, i_allocated, i_recycled );
+
+        /* Only a few buffers are in flight at any time */
+        assert( i_decoded > 0 && i_played > 0 );
+        assert( i_allocated + i_recycled == i_decoded );
+        assert( i_allocated <= 16 );
+
+        libvlc_media_player_release( pp_mp[i] );
+        libvlc_media_release( pp_md[i] );
+    }
+
+    libvlc_release( p_libvlc );
+    unlink( psz_path );
+    free( psz_path );
+    return 0;
+}
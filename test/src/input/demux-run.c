@@ -0,0 +1,217 @@
+/*****************************************************************************
+ * demux-run.c: demux helpers for benchmarks and fuzzers
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vlc/vlc.h>
+#include "../../../lib/libvlc_internal.h"
+
+#include <vlc_common.h>
+#include <vlc_demux.h>
+#include <vlc_es_out.h>
+#include <vlc_stream.h>
+#include <vlc_url.h>
+
+#include "demux-run.h"
+
+static libvlc_instance_t *vlc;
+
+/*****************************************************************************
+ * Null elementary streams output
+ *****************************************************************************/
+struct es_out_id_t
+{
+    struct es_out_id_t *next;
+    int cat;
+};
+
+struct es_out_sys_t
+{
+    struct es_out_id_t *ids;
+    struct vlc_demux_stats *stats;
+};
+
+static es_out_id_t *EsOutAdd(es_out_t *out, const es_format_t *fmt)
+{
+    es_out_sys_t *sys = out->p_sys;
+    es_out_id_t *id = malloc(sizeof (*id));
+
+    if (unlikely(id == NULL))
+        return NULL;
+
+    id->next = sys->ids;
+    id->cat = fmt->i_cat;
+    sys->ids = id;
+    sys->stats->i_es++;
+    return id;
+}
+
+static int EsOutSend(es_out_t *out, es_out_id_t *id, block_t *block)
+{
+    es_out_sys_t *sys = out->p_sys;
+
+    sys->stats->i_packets++;
+    sys->stats->i_bytes += block->i_buffer;
+    block_Release(block);
+    (void) id;
+    return VLC_SUCCESS;
+}
+
+static void EsOutDel(es_out_t *out, es_out_id_t *id)
+{
+    es_out_sys_t *sys = out->p_sys;
+    es_out_id_t **pp = &sys->ids;
+
+    while (*pp != id)
+    {
+        assert(*pp != NULL);
+        pp = &(*pp)->next;
+    }
+    *pp = id->next;
+    free(id);
+}
+
+static int EsOutControl(es_out_t *out, int query, va_list args)
+{
+    (void) out;
+
+    switch (query)
+    {
+        case ES_OUT_GET_ES_STATE:
+            (void) va_arg(args, es_out_id_t *);
+            *va_arg(args, bool *) = true;
+            return VLC_SUCCESS;
+        case ES_OUT_GET_EMPTY:
+            *va_arg(args, bool *) = true;
+            return VLC_SUCCESS;
+        case ES_OUT_GET_PCR_SYSTEM:
+        case ES_OUT_MODIFY_PCR_SYSTEM:
+            return VLC_EGENERIC;
+        default:
+            /* Nothing is decoded, so there is nothing to pace either */
+            return VLC_SUCCESS;
+    }
+}
+
+/*****************************************************************************
+ * Demux
+ *****************************************************************************/
+static int demux_process_stream(const char *name, stream_t *s,
+                                struct vlc_demux_stats *stats)
+{
+    struct vlc_demux_stats dummy;
+    es_out_sys_t sys = { NULL, stats != NULL ? stats : &dummy };
+    es_out_t out = {
+        .pf_add = EsOutAdd, .pf_send = EsOutSend, .pf_del = EsOutDel,
+        .pf_control = EsOutControl, .p_sys = &sys,
+    };
+
+    memset(sys.stats, 0, sizeof (*sys.stats));
+
+    if (s == NULL)
+    {
+        fprintf(stderr, "Error: cannot create input stream\n");
+        return -1;
+    }
+
+    mtime_t start = mdate();
+    demux_t *demux = demux_New(VLC_OBJECT(vlc->p_libvlc_int), name, "", s,
+                               &out);
+    if (demux == NULL)
+    {
+        vlc_stream_Delete(s);
+        fprintf(stderr, "Error: cannot create demultiplexer\n");
+        return -1;
+    }
+
+    int val;
+    while ((val = demux_Demux(demux)) == VLC_DEMUXER_SUCCESS);
+
+    sys.stats->i_input = vlc_stream_Tell(s);
+    demux_Delete(demux);
+    sys.stats->i_time = mdate() - start;
+
+    /* Some demuxers leave their elementary streams to the output */
+    while (sys.ids != NULL)
+        EsOutDel(&out, sys.ids);
+
+    return val == VLC_DEMUXER_EOF ? 0 : -1;
+}
+
+int vlc_demux_process_url(const char *demux, const char *url,
+                          struct vlc_demux_stats *stats)
+{
+    stream_t *s = vlc_stream_NewMRL(VLC_OBJECT(vlc->p_libvlc_int), url);
+    return demux_process_stream(demux, s, stats);
+}
+
+int vlc_demux_process_path(const char *demux, const char *path,
+                           struct vlc_demux_stats *stats)
+{
+    char *url = vlc_path2uri(path, NULL);
+    if (url == NULL)
+    {
+        fprintf(stderr, "Error: cannot convert path to URL: %s\n", path);
+        return -1;
+    }
+
+    int ret = vlc_demux_process_url(demux, url, stats);
+    free(url);
+    return ret;
+}
+
+int vlc_demux_process_memory(const char *demux, const unsigned char *buf,
+                             size_t length, struct vlc_demux_stats *stats)
+{
+    stream_t *s = vlc_stream_MemoryNew(VLC_OBJECT(vlc->p_libvlc_int),
+                                       (uint8_t *)buf, length, true);
+    return demux_process_stream(demux, s, stats);
+}
+
+/*****************************************************************************
+ * LibVLC
+ *****************************************************************************/
+int vlc_demux_run_init(int argc, const char *const *argv)
+{
+#ifdef TOP_BUILDDIR
+    setenv("VLC_PLUGIN_PATH", TOP_BUILDDIR"/modules", 0);
+#endif
+
+    vlc = libvlc_new(argc, argv);
+    if (vlc == NULL)
+    {
+        fprintf(stderr, "Error: cannot initialize LibVLC\n");
+        return -1;
+    }
+    return 0;
+}
+
+void vlc_demux_run_deinit(void)
+{
+    libvlc_release(vlc);
+    vlc = NULL;
+}
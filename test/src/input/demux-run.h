@@ -0,0 +1,66 @@
+/*****************************************************************************
+ * demux-run.h: demux helpers for benchmarks and fuzzers
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_TEST_DEMUX_RUN_H
+#define VLC_TEST_DEMUX_RUN_H 1
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * What a demuxer produced from one input.
+ */
+struct vlc_demux_stats
+{
+    unsigned i_es;          /**< elementary streams added */
+    uint64_t i_packets;     /**< blocks sent to the elementary streams */
+    uint64_t i_bytes;       /**< payload of those blocks */
+    uint64_t i_input;       /**< bytes of input read */
+    int64_t  i_time;        /**< time spent demuxing, in microseconds */
+};
+
+/**
+ * Creates the LibVLC instance the demuxers run in.
+ *
+ * The plugins are loaded from the build tree unless VLC_PLUGIN_PATH is set.
+ * @return 0 on success, -1 on error
+ */
+int vlc_demux_run_init(int argc, const char *const *argv);
+
+/**
+ * Releases the LibVLC instance.
+ */
+void vlc_demux_run_deinit(void);
+
+/**
+ * Demuxes a whole input, discarding the elementary streams.
+ *
+ * @param demux name of the demuxer module, or "any" to probe them all
+ * @param stats statistics to fill, or NULL
+ * @return 0 if the input was demuxed up to its end, -1 otherwise
+ */
+int vlc_demux_process_url(const char *demux, const char *url,
+                          struct vlc_demux_stats *stats);
+int vlc_demux_process_path(const char *demux, const char *path,
+                           struct vlc_demux_stats *stats);
+int vlc_demux_process_memory(const char *demux, const unsigned char *buf,
+                             size_t length, struct vlc_demux_stats *stats);
+
+#endif
@@ -0,0 +1,251 @@
+/*****************************************************************************
+ * fft.c: real-input FFT test
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+#ifdef NDEBUG
+ #undef NDEBUG
+#endif
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <vlc_common.h>
+#include <vlc_fft.h>
+
+/* Frame size of the visualization plugins */
+#define VISUAL_SIZE 512
+#define RUNS        20000
+
+static float *signal_new( unsigned size )
+{
+    float *p_buf = malloc( size * sizeof(float) );
+    uint32_t seed = 0x12345678;
+
+    assert( p_buf != NULL );
+    for( unsigned i = 0; i < size; i++ )
+    {
+        seed = seed * 1664525 + 1013904223;
+        p_buf[i] = 16000. * sin( 2. * M_PI * 7. * i / size )
+                 + 8000. * cos( 2. * M_PI * 0.3 * i )
+                 + (float)(int32_t)seed / 2147483648.f * 4000.f;
+    }
+    return p_buf;
+}
+
+/* Direct evaluation of the bins in double precision */
+static void dft( const float *in, unsigned size, double *re, double *im )
+{
+    for( unsigned k = 0; k <= size / 2; k++ )
+    {
+        double r = 0., i = 0.;
+
+        for( unsigned n = 0; n < size; n++ )
+        {
+            double phi = -2. * M_PI * (double)( ( (uint64_t)k * n ) % size )
+                       / size;
+            r += in[n] * cos( phi );
+            i += in[n] * sin( phi );
+        }
+        re[k] = r;
+        im[k] = i;
+    }
+}
+
+static void test_size( unsigned size )
+{
+    vlc_fft_t *fft = vlc_fft_New( size );
+    assert( fft != NULL );
+
+    float *in = signal_new( size );
+    float *re = malloc( ( size / 2 + 1 ) * sizeof(float) );
+    float *im = malloc( ( size / 2 + 1 ) * sizeof(float) );
+    float *power = malloc( ( size / 2 + 1 ) * sizeof(float) );
+    double *ref_re = malloc( ( size / 2 + 1 ) * sizeof(double) );
+    double *ref_im = malloc( ( size / 2 + 1 ) * sizeof(double) );
+    assert( re != NULL && im != NULL && power != NULL );
+    assert( ref_re != NULL && ref_im != NULL );
+
+    dft( in, size, ref_re, ref_im );
+    vlc_fft_Forward( fft, in, re, im );
+    vlc_fft_Power( fft, in, power );
+
+    double energy = 0., error = 0., power_error = 0.;
+    for( unsigned k = 0; k <= size / 2; k++ )
+    {
+        double m = ref_re[k] * ref_re[k] + ref_im[k] * ref_im[k];
+
+        energy += m;
+        error += ( re[k] - ref_re[k] ) * ( re[k] - ref_re[k] )
+               + ( im[k] - ref_im[k] ) * ( im[k] - ref_im[k] );
+        power_error = __MAX( power_error, fabs( power[k] - m ) );
+    }
+    assert( im[0] == 0.f && im[size / 2] == 0.f );
+
+    /* Relative error of the spectrum, within single precision rounding */
+    error = sqrt( error / energy );
+    power_error /= energy;
+    printf( "size %u: relative error %.2e, power error %.2e\n",
+            size, error, power_error );
+    assert( error < 1e-5 );
+    assert( power_error < 1e-5 );
+
+    /* Back to the signal, scaled by size */
+    float *out = malloc( size * sizeof(float) );
+    assert( out != NULL );
+    vlc_fft_Inverse( fft, re, im, out );
+
+    double signal = 0., inverse_error = 0.;
+    for( unsigned n = 0; n < size; n++ )
+    {
+        double d = out[n] / size - in[n];
+
+        signal += in[n] * in[n];
+        inverse_error += d * d;
+    }
+    inverse_error = sqrt( inverse_error / signal );
+    printf( "size %u: inverse relative error %.2e\n", size, inverse_error );
+    assert( inverse_error < 1e-5 );
+    free( out );
+
+    free( ref_im );
+    free( ref_re );
+    free( power );
+    free( im );
+    free( re );
+    free( in );
+    vlc_fft_Delete( fft );
+}
+
+#ifdef BENCHMARK
+/* Textbook in-place radix-2 complex transform with trigonometric tables,
+ * as the visualizations used to do it */
+static void fft_radix2( float *re, float *im, unsigned size,
+                        const float *cos_tab, const float *sin_tab )
+{
+    for( unsigned i = 1, j = 0; i < size; i++ )
+    {
+        unsigned bit = size >> 1;
+
+        for( ; j & bit; bit >>= 1 )
+            j ^= bit;
+        j |= bit;
+        if( i < j )
+        {
+            float t = re[i]; re[i] = re[j]; re[j] = t;
+            t = im[i]; im[i] = im[j]; im[j] = t;
+        }
+    }
+
+    for( unsigned len = 2; len <= size; len <<= 1 )
+        for( unsigned k = 0; k < len / 2; k++ )
+        {
+            float wr = cos_tab[k * ( size / len )];
+            float wi = -sin_tab[k * ( size / len )];
+
+            for( unsigned i = k; i < size; i += len )
+            {
+                unsigned j = i + len / 2;
+                float tr = re[j] * wr - im[j] * wi;
+                float ti = re[j] * wi + im[j] * wr;
+
+                re[j] = re[i] - tr;
+                im[j] = im[i] - ti;
+                re[i] += tr;
+                im[i] += ti;
+            }
+        }
+}
+
+static void bench_visual( void )
+{
+    float *in = signal_new( VISUAL_SIZE );
+    float re[VISUAL_SIZE], im[VISUAL_SIZE];
+    float power[VISUAL_SIZE / 2 + 1];
+    float cos_tab[VISUAL_SIZE / 2], sin_tab[VISUAL_SIZE / 2];
+    volatile float sink = 0.f;
+
+    for( unsigned k = 0; k < VISUAL_SIZE / 2; k++ )
+    {
+        cos_tab[k] = cos( 2. * M_PI * k / VISUAL_SIZE );
+        sin_tab[k] = sin( 2. * M_PI * k / VISUAL_SIZE );
+    }
+
+    vlc_fft_t *fft = vlc_fft_New( VISUAL_SIZE );
+    assert( fft != NULL );
+
+    mtime_t t0 = mdate();
+    for( unsigned r = 0; r < RUNS; r++ )
+    {
+        for( unsigned i = 0; i < VISUAL_SIZE; i++ )
+        {
+            re[i] = in[i];
+            im[i] = 0.f;
+        }
+        fft_radix2( re, im, VISUAL_SIZE, cos_tab, sin_tab );
+        for( unsigned k = 0; k <= VISUAL_SIZE / 2; k++ )
+            power[k] = re[k] * re[k] + im[k] * im[k];
+        sink += power[r % ( VISUAL_SIZE / 2 )];
+    }
+    mtime_t t1 = mdate();
+    for( unsigned r = 0; r < RUNS; r++ )
+    {
+        vlc_fft_Power( fft, in, power );
+        sink += power[r % ( VISUAL_SIZE / 2 )];
+    }
+    mtime_t t2 = mdate();
+
+    printf( "size %u power spectrum: complex radix-2 %.0f ns, "
+            "real FFT %.0f ns, %.2fx faster\n", VISUAL_SIZE,
+            1000. * ( t1 - t0 ) / RUNS, 1000. * ( t2 - t1 ) / RUNS,
+            (double)( t1 - t0 ) / __MAX( t2 - t1, 1 ) );
+
+    vlc_fft_Delete( fft );
+    free( in );
+    (void) sink;
+}
+#endif
+
+int main( void )
+{
+    static const unsigned sizes[] = {
+        2, 4, 6, 8, 10, 30, 64, 480, 512, 1000, 1024, 1920, 4096,
+    };
+
+    for( size_t i = 0; i < ARRAY_SIZE(sizes); i++ )
+        test_size( sizes[i] );
+
+    /* The plans are shared */
+    vlc_fft_t *a = vlc_fft_New( 480 ), *b = vlc_fft_New( 480 );
+    assert( a != NULL && b != NULL );
+    vlc_fft_Delete( a );
+    vlc_fft_Delete( b );
+
+    /* Odd sizes and prime factors above 5 are not supported */
+    assert( vlc_fft_New( 0 ) == NULL );
+    assert( vlc_fft_New( 15 ) == NULL );
+    assert( vlc_fft_New( 14 ) == NULL );
+    assert( vlc_fft_New( 2 * 11 * 16 ) == NULL );
+
+#ifdef BENCHMARK
+    bench_visual();
+#endif
+    return 0;
+}
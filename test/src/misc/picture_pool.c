@@ -0,0 +1,208 @@
+/*****************************************************************************
+ * picture_pool.c: test for picture pools and the picture buffers recycler
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "../../libvlc/test.h"
+#ifdef NDEBUG
+ #undef NDEBUG
+#endif
+#include <vlc_common.h>
+#include <vlc_picture_pool.h>
+#include <vlc_atomic.h>
+#include <assert.h>
+#include <sched.h>
+
+#define PICTURES 10
+#define THREADS  4
+#define ROUNDS   2000
+
+static void test_pool( const video_format_t *fmt )
+{
+    picture_pool_t *pool = picture_pool_NewFromFormat( fmt, PICTURES );
+    picture_t *pics[PICTURES];
+
+    assert( pool != NULL );
+    assert( picture_pool_GetSize( pool ) == PICTURES );
+
+    for( unsigned i = 0; i < PICTURES; i++ )
+    {
+        pics[i] = picture_pool_Get( pool );
+        assert( pics[i] != NULL );
+        for( unsigned j = 0; j < i; j++ )
+            assert( pics[i]->p[0].p_pixels != pics[j]->p[0].p_pixels );
+    }
+    assert( picture_pool_Get( pool ) == NULL );
+
+    picture_Release( pics[3] );
+    pics[3] = picture_pool_Wait( pool );
+    assert( pics[3] != NULL );
+    assert( picture_pool_Get( pool ) == NULL );
+
+    /* Late pictures outlive the pool */
+    for( unsigned i = 1; i < PICTURES; i++ )
+        picture_Release( pics[i] );
+    picture_pool_Release( pool );
+    picture_Release( pics[0] );
+}
+
+static void test_reserve( const video_format_t *fmt )
+{
+    picture_pool_t *pool = picture_pool_NewFromFormat( fmt, PICTURES );
+    assert( pool != NULL );
+
+    picture_pool_t *reserve = picture_pool_Reserve( pool, PICTURES / 2 );
+    assert( reserve != NULL );
+
+    for( unsigned i = 0; i < PICTURES / 2; i++ )
+    {
+        picture_t *pic = picture_pool_Get( pool );
+        assert( pic != NULL );
+        picture_Release( pic );
+    }
+
+    picture_t *pic = picture_pool_Get( reserve );
+    assert( pic != NULL );
+    picture_pool_Release( reserve );
+    picture_Release( pic );
+    picture_pool_Release( pool );
+}
+
+struct concurrent
+{
+    picture_pool_t *pool;
+    const video_format_t *fmt;
+    atomic_uint held;
+};
+
+struct concurrent_thread
+{
+    struct concurrent *c;
+    vlc_thread_t thread;
+    uint8_t id;
+};
+
+static void *test_concurrent_thread( void *data )
+{
+    struct concurrent_thread *t = data;
+    struct concurrent *c = t->c;
+
+    for( unsigned i = 0; i < ROUNDS; i++ )
+    {
+        picture_t *pic = (i & 1) ? picture_pool_Wait( c->pool )
+                                 : picture_pool_Get( c->pool );
+        if( pic != NULL )
+        {
+            /* No other thread may get the same picture meanwhile */
+            assert( atomic_fetch_add( &c->held, 1 ) < PICTURES );
+            pic->p[0].p_pixels[0] = t->id;
+            sched_yield();
+            assert( pic->p[0].p_pixels[0] == t->id );
+            atomic_fetch_sub( &c->held, 1 );
+            picture_Release( pic );
+        }
+
+        /* Heap pictures go through the recycler at the same time */
+        picture_t *heap = picture_NewFromFormat( c->fmt );
+        assert( heap != NULL );
+        picture_Release( heap );
+    }
+    return NULL;
+}
+
+static void test_concurrent( const video_format_t *fmt )
+{
+    struct concurrent c = {
+        .pool = picture_pool_NewFromFormat( fmt, PICTURES ),
+        .fmt = fmt,
+    };
+    struct concurrent_thread threads[THREADS];
+    picture_t *pics[PICTURES];
+
+    assert( c.pool != NULL );
+    atomic_init( &c.held, 0 );
+
+    for( unsigned i = 0; i < THREADS; i++ )
+    {
+        threads[i].c = &c;
+        threads[i].id = i + 1;
+        assert( vlc_clone( &threads[i].thread, test_concurrent_thread,
+                           &threads[i], VLC_THREAD_PRIORITY_LOW ) == 0 );
+    }
+    for( unsigned i = 0; i < THREADS; i++ )
+        vlc_join( threads[i].thread, NULL );
+
+    /* Every picture went back to the pool */
+    for( unsigned i = 0; i < PICTURES; i++ )
+    {
+        pics[i] = picture_pool_Get( c.pool );
+        assert( pics[i] != NULL );
+    }
+    assert( picture_pool_Get( c.pool ) == NULL );
+    for( unsigned i = 0; i < PICTURES; i++ )
+        picture_Release( pics[i] );
+    picture_pool_Release( c.pool );
+}
+
+int main( void )
+{
+    video_format_t fmt;
+    picture_buffer_stats_t before, after;
+
+    test_init();
+
+    video_format_Init( &fmt, VLC_CODEC_I420 );
+    video_format_Setup( &fmt, VLC_CODEC_I420, 640, 480, 640, 480, 1, 1 );
+
+    /* The recycler is flushed when no pools are left: keep one meanwhile */
+    picture_pool_t *keep = picture_pool_NewFromFormat( &fmt, 1 );
+    assert( keep != NULL );
+
+    test_pool( &fmt );
+    test_reserve( &fmt );
+
+    /* Re-creating a pool of the same format reuses the buffers */
+    picture_buffer_GetStats( &before );
+    assert( before.cached_count >= PICTURES );
+    picture_pool_Release( picture_pool_NewFromFormat( &fmt, PICTURES ) );
+    picture_buffer_GetStats( &after );
+    assert( after.reused - before.reused == PICTURES );
+    assert( after.allocated == before.allocated );
+    assert( after.cached_count == before.cached_count );
+
+    /* Smaller pictures may use larger buffers, not the other way around */
+    video_format_Setup( &fmt, VLC_CODEC_I420, 720, 576, 720, 576, 1, 1 );
+    picture_buffer_GetStats( &before );
+    picture_pool_Release( picture_pool_NewFromFormat( &fmt, PICTURES ) );
+    picture_buffer_GetStats( &after );
+    assert( after.allocated - before.allocated == PICTURES );
+
+    video_format_Setup( &fmt, VLC_CODEC_I420, 704, 576, 704, 576, 1, 1 );
+    picture_buffer_GetStats( &before );
+    picture_pool_Release( picture_pool_NewFromFormat( &fmt, PICTURES ) );
+    picture_buffer_GetStats( &after );
+    assert( after.reused - before.reused == PICTURES );
+
+    test_concurrent( &fmt );
+
+    picture_pool_Release( keep );
+    picture_buffer_GetStats( &after );
+    assert( after.cached_count == 0 && after.cached_bytes == 0 );
+
+    return 0;
+}
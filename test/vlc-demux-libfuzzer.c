@@ -0,0 +1,60 @@
+/**
+ * @file vlc-demux-libfuzzer.c
+ * @brief libFuzzer target for the demultiplexers
+ */
+/*****************************************************************************
+ * Copyright © 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "src/input/demux-run.h"
+
+/* The demultiplexer to fuzz is set with the VLC_TARGET environment variable,
+ * e.g. VLC_TARGET=mkv; all demultiplexers are probed by default. */
+static const char *demux = "any";
+
+int LLVMFuzzerInitialize(int *argc, char ***argv);
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+int LLVMFuzzerInitialize(int *argc, char ***argv)
+{
+    static const char *const args[] = {
+        "--no-media-library", "--no-plugins-cache", "--vout=dummy",
+        "--aout=dummy", "--quiet",
+    };
+    const char *target = getenv("VLC_TARGET");
+
+    if (target != NULL)
+        demux = target;
+
+    (void) argc; (void) argv;
+    if (vlc_demux_run_init(sizeof (args) / sizeof (args[0]), args))
+        abort();
+    return 0;
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    vlc_demux_process_memory(demux, data, size, NULL);
+    return 0;
+}
@@ -0,0 +1,280 @@
+/**
+ * @file vlc-demux-run.c
+ * @brief Demux throughput benchmark
+ */
+/*****************************************************************************
+ * Copyright © 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <errno.h>
+#include <inttypes.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/resource.h>
+
+#include <vlc_common.h>
+
+#include "src/input/demux-run.h"
+
+/*
+ * Allocations are counted by interposing the C library allocator, which the
+ * executable must export for LibVLC and the plugins to pick it up. This is
+ * left out when a sanitizer already owns the allocator.
+ */
+#if defined(__GLIBC__) && !defined(__SANITIZE_ADDRESS__)
+# if defined(__has_feature)
+#  if !__has_feature(address_sanitizer) && !__has_feature(memory_sanitizer)
+#   define COUNT_ALLOCATIONS 1
+#  endif
+# else
+#  define COUNT_ALLOCATIONS 1
+# endif
+#endif
+
+#ifdef COUNT_ALLOCATIONS
+# include <malloc.h>
+
+static atomic_ullong allocations = ATOMIC_VAR_INIT(0);
+
+extern void *__libc_malloc(size_t);
+extern void *__libc_calloc(size_t, size_t);
+extern void *__libc_realloc(void *, size_t);
+extern void *__libc_memalign(size_t, size_t);
+
+VLC_EXPORT void *malloc(size_t size)
+{
+    atomic_fetch_add_explicit(&allocations, 1, memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+VLC_EXPORT void *calloc(size_t n, size_t size)
+{
+    atomic_fetch_add_explicit(&allocations, 1, memory_order_relaxed);
+    return __libc_calloc(n, size);
+}
+
+VLC_EXPORT void *realloc(void *ptr, size_t size)
+{
+    atomic_fetch_add_explicit(&allocations, 1, memory_order_relaxed);
+    return __libc_realloc(ptr, size);
+}
+
+VLC_EXPORT void *memalign(size_t align, size_t size)
+{
+    atomic_fetch_add_explicit(&allocations, 1, memory_order_relaxed);
+    return __libc_memalign(align, size);
+}
+
+VLC_EXPORT void *aligned_alloc(size_t align, size_t size)
+{
+    return memalign(align, size);
+}
+
+VLC_EXPORT int posix_memalign(void **pp, size_t align, size_t size)
+{
+    if (align < sizeof (void *) || (align & (align - 1)))
+        return EINVAL;
+
+    void *p = memalign(align, size);
+    if (p == NULL)
+        return ENOMEM;
+    *pp = p;
+    return 0;
+}
+
+static unsigned long long count_allocations(void)
+{
+    return atomic_load_explicit(&allocations, memory_order_relaxed);
+}
+#else
+static unsigned long long count_allocations(void)
+{
+    return 0;
+}
+#endif
+
+static long peak_rss(void)
+{
+    struct rusage ru;
+
+    if (getrusage(RUSAGE_SELF, &ru))
+        return -1;
+    return ru.ru_maxrss; /* kB */
+}
+
+static void *load_file(const char *path, size_t *restrict length)
+{
+    FILE *stream = fopen(path, "rb");
+    if (stream == NULL)
+    {
+        perror(path);
+        return NULL;
+    }
+
+    unsigned char *buf = NULL;
+    size_t size = 0, len = 0;
+
+    for (;;)
+    {
+        if (len == size)
+        {
+            size = size ? 2 * size : 1 << 20;
+            unsigned char *p = realloc(buf, size);
+            if (p == NULL)
+            {
+                perror(path);
+                free(buf);
+                buf = NULL;
+                break;
+            }
+            buf = p;
+        }
+
+        size_t val = fread(buf + len, 1, size - len, stream);
+        len += val;
+        if (val == 0)
+            break;
+    }
+
+    if (buf != NULL && ferror(stream))
+    {
+        perror(path);
+        free(buf);
+        buf = NULL;
+    }
+    fclose(stream);
+    *length = len;
+    return buf;
+}
+
+static void usage(const char *name)
+{
+    fprintf(stderr,
+            "Usage: %s [-d DEMUX] [-m] [-r RUNS] FILE...\n"
+            "Demuxes each FILE into a null output and prints:\n"
+            "packets/s, MB/s, allocations and peak resident set size.\n\n"
+            " -d DEMUX  demultiplexer module, e.g. ts, mp4, mkv, avi, ogg,\n"
+            "           es or ps (default: any)\n"
+            " -m        read each FILE into memory before demuxing it\n"
+            " -r RUNS   demux each FILE RUNS times (default: 1)\n",
+            name);
+}
+
+int main(int argc, char *argv[])
+{
+    const char *demux = "any";
+    bool in_memory = false;
+    unsigned runs = 1;
+    int c;
+
+    while ((c = getopt(argc, argv, "d:mr:h")) != -1)
+        switch (c)
+        {
+            case 'd':
+                demux = optarg;
+                break;
+            case 'm':
+                in_memory = true;
+                break;
+            case 'r':
+                runs = strtoul(optarg, NULL, 0);
+                if (runs == 0)
+                    runs = 1;
+                break;
+            default:
+                usage(argv[0]);
+                return c == 'h' ? 0 : 1;
+        }
+
+    if (optind >= argc)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    static const char *const args[] = {
+        "--no-media-library", "--no-plugins-cache", "--vout=dummy",
+        "--aout=dummy", "--quiet",
+    };
+
+    if (vlc_demux_run_init(sizeof (args) / sizeof (args[0]), args))
+        return 1;
+
+    int ret = 0;
+
+    for (int i = optind; i < argc; i++)
+    {
+        const char *path = argv[i];
+        unsigned char *buf = NULL;
+        size_t length = 0;
+
+        if (in_memory)
+        {
+            buf = load_file(path, &length);
+            if (buf == NULL)
+            {
+                ret = 1;
+                continue;
+            }
+        }
+
+        for (unsigned run = 0; run < runs; run++)
+        {
+            struct vlc_demux_stats stats;
+            unsigned long long allocs = count_allocations();
+            int val;
+
+            if (in_memory)
+                val = vlc_demux_process_memory(demux, buf, length, &stats);
+            else
+                val = vlc_demux_process_path(demux, path, &stats);
+
+            allocs = count_allocations() - allocs;
+
+            double secs = (stats.i_time > 0 ? stats.i_time : 1) / 1e6;
+
+            printf("%s: %u ES, %"PRIu64" packets, %"PRIu64" bytes out of "
+                   "%"PRIu64" in %.3f s%s\n", path, stats.i_es,
+                   stats.i_packets, stats.i_bytes, stats.i_input, secs,
+                   val ? " (incomplete)" : "");
+            printf("  %.0f packets/s, %.2f MB/s, ", stats.i_packets / secs,
+                   stats.i_input / secs / 1e6);
+#ifdef COUNT_ALLOCATIONS
+            printf("%llu allocations (%.1f per packet), ", allocs,
+                   stats.i_packets ? (double)allocs / stats.i_packets : 0.);
+#else
+            (void) allocs;
+            printf("allocations not counted, ");
+#endif
+            printf("peak RSS %ld kB\n", peak_rss());
+
+            if (val)
+                ret = 1;
+        }
+        free(buf);
+    }
+
+    vlc_demux_run_deinit();
+    return ret;
+}